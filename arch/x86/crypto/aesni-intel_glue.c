@@ -652,6 +652,21 @@ static int generic_gcmaes_set_authsize(struct crypto_aead *tfm,
 	return 0;
 }
 
+/* Must be called with the FPU held */
+static void gcmaes_finalize(void *aes_ctx, struct gcm_context_data *data,
+			    u8 *auth_tag, unsigned long auth_tag_len,
+			    bool do_avx, bool do_avx2)
+{
+	if (static_branch_likely(&gcm_use_avx2) && do_avx2)
+		aesni_gcm_finalize_avx_gen4(aes_ctx, data, auth_tag,
+					    auth_tag_len);
+	else if (static_branch_likely(&gcm_use_avx) && do_avx)
+		aesni_gcm_finalize_avx_gen2(aes_ctx, data, auth_tag,
+					    auth_tag_len);
+	else
+		aesni_gcm_finalize(aes_ctx, data, auth_tag, auth_tag_len);
+}
+
 static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 			      unsigned int assoclen, u8 *hash_subkey,
 			      u8 *iv, void *aes_ctx, u8 *auth_tag,
@@ -663,6 +678,7 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 	struct scatter_walk assoc_sg_walk;
 	struct skcipher_walk walk;
 	bool do_avx, do_avx2;
+	bool finalized = false;
 	u8 *assocmem = NULL;
 	u8 *assoc;
 	int err;
@@ -740,6 +756,16 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 			aesni_gcm_dec_update(aes_ctx, data, walk.dst.virt.addr,
 					     walk.src.virt.addr, walk.nbytes);
 		}
+		/*
+		 * The tag only depends on the GHASH state, so compute it while
+		 * the FPU is still held for the last chunk.  Small records,
+		 * which are a single chunk, save an FPU section this way.
+		 */
+		if (walk.nbytes == walk.total) {
+			gcmaes_finalize(aes_ctx, data, auth_tag, auth_tag_len,
+					do_avx, do_avx2);
+			finalized = true;
+		}
 		kernel_fpu_end();
 
 		err = skcipher_walk_done(&walk, 0);
@@ -748,16 +774,12 @@ static int gcmaes_crypt_by_sg(bool enc, struct aead_request *req,
 	if (err)
 		return err;
 
-	kernel_fpu_begin();
-	if (static_branch_likely(&gcm_use_avx2) && do_avx2)
-		aesni_gcm_finalize_avx_gen4(aes_ctx, data, auth_tag,
-					    auth_tag_len);
-	else if (static_branch_likely(&gcm_use_avx) && do_avx)
-		aesni_gcm_finalize_avx_gen2(aes_ctx, data, auth_tag,
-					    auth_tag_len);
-	else
-		aesni_gcm_finalize(aes_ctx, data, auth_tag, auth_tag_len);
-	kernel_fpu_end();
+	if (!finalized) {
+		kernel_fpu_begin();
+		gcmaes_finalize(aes_ctx, data, auth_tag, auth_tag_len,
+				do_avx, do_avx2);
+		kernel_fpu_end();
+	}
 
 	return 0;
 }
@@ -496,7 +496,16 @@ static struct xor_block_template xor_block_sse_pf64 = {
 # include <asm/xor_64.h>
 #endif
 
+#ifdef CONFIG_X86_64
+/*
+ * AVX-512 is not always faster than AVX, e.g. when it lowers the clock, so
+ * benchmark it against the other routines instead of forcing AVX.
+ */
+#define XOR_SELECT_TEMPLATE(FASTEST) \
+	(boot_cpu_has(X86_FEATURE_AVX512F) ? (FASTEST) : AVX_SELECT(FASTEST))
+#else
 #define XOR_SELECT_TEMPLATE(FASTEST) \
 	AVX_SELECT(FASTEST)
+#endif
 
 #endif /* _ASM_X86_XOR_H */
@@ -11,8 +11,9 @@ static struct xor_block_template xor_block_sse = {
 };
 
 
-/* Also try the AVX routines */
+/* Also try the AVX and AVX-512 routines */
 #include <asm/xor_avx.h>
+#include <asm/xor_avx512.h>
 
 /* We force the use of the SSE xor block because it can write around L2.
    We may also be able to load into the L1 only depending on how the cpu
@@ -20,6 +21,7 @@ static struct xor_block_template xor_block_sse = {
 #undef XOR_TRY_TEMPLATES
 #define XOR_TRY_TEMPLATES			\
 do {						\
+	AVX512_XOR_SPEED;			\
 	AVX_XOR_SPEED;				\
 	xor_speed(&xor_block_sse_pf64);		\
 	xor_speed(&xor_block_sse);		\
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef _ASM_X86_XOR_AVX512_H
+#define _ASM_X86_XOR_AVX512_H
+
+/*
+ * Optimized RAID-5 checksumming functions for AVX-512
+ *
+ * Based on the AVX routines in xor_avx.h. Each line of 512 bytes is
+ * processed in eight 64 byte zmm registers.
+ */
+
+#include <linux/compiler.h>
+#include <asm/fpu/api.h>
+
+#define BLOCK8() \
+		BLOCK(64 * 0, 0) \
+		BLOCK(64 * 1, 1) \
+		BLOCK(64 * 2, 2) \
+		BLOCK(64 * 3, 3) \
+		BLOCK(64 * 4, 4) \
+		BLOCK(64 * 5, 5) \
+		BLOCK(64 * 6, 6) \
+		BLOCK(64 * 7, 7)
+
+static void xor_avx512_2(unsigned long bytes, unsigned long * __restrict p0,
+			 const unsigned long * __restrict p1)
+{
+	unsigned long lines = bytes >> 9;
+
+	kernel_fpu_begin();
+
+	while (lines--) {
+#undef BLOCK
+#define BLOCK(i, reg) \
+do { \
+	asm volatile("vmovdqu64 %0, %%zmm" #reg : : "m" (p1[i / sizeof(*p1)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p0[i / sizeof(*p0)])); \
+	asm volatile("vmovdqu64 %%zmm" #reg ", %0" : \
+		"=m" (p0[i / sizeof(*p0)])); \
+} while (0);
+
+		BLOCK8()
+
+		p0 = (unsigned long *)((uintptr_t)p0 + 512);
+		p1 = (unsigned long *)((uintptr_t)p1 + 512);
+	}
+
+	kernel_fpu_end();
+}
+
+static void xor_avx512_3(unsigned long bytes, unsigned long * __restrict p0,
+			 const unsigned long * __restrict p1,
+			 const unsigned long * __restrict p2)
+{
+	unsigned long lines = bytes >> 9;
+
+	kernel_fpu_begin();
+
+	while (lines--) {
+#undef BLOCK
+#define BLOCK(i, reg) \
+do { \
+	asm volatile("vmovdqu64 %0, %%zmm" #reg : : "m" (p2[i / sizeof(*p2)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p1[i / sizeof(*p1)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p0[i / sizeof(*p0)])); \
+	asm volatile("vmovdqu64 %%zmm" #reg ", %0" : \
+		"=m" (p0[i / sizeof(*p0)])); \
+} while (0);
+
+		BLOCK8()
+
+		p0 = (unsigned long *)((uintptr_t)p0 + 512);
+		p1 = (unsigned long *)((uintptr_t)p1 + 512);
+		p2 = (unsigned long *)((uintptr_t)p2 + 512);
+	}
+
+	kernel_fpu_end();
+}
+
+static void xor_avx512_4(unsigned long bytes, unsigned long * __restrict p0,
+			 const unsigned long * __restrict p1,
+			 const unsigned long * __restrict p2,
+			 const unsigned long * __restrict p3)
+{
+	unsigned long lines = bytes >> 9;
+
+	kernel_fpu_begin();
+
+	while (lines--) {
+#undef BLOCK
+#define BLOCK(i, reg) \
+do { \
+	asm volatile("vmovdqu64 %0, %%zmm" #reg : : "m" (p3[i / sizeof(*p3)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p2[i / sizeof(*p2)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p1[i / sizeof(*p1)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p0[i / sizeof(*p0)])); \
+	asm volatile("vmovdqu64 %%zmm" #reg ", %0" : \
+		"=m" (p0[i / sizeof(*p0)])); \
+} while (0);
+
+		BLOCK8()
+
+		p0 = (unsigned long *)((uintptr_t)p0 + 512);
+		p1 = (unsigned long *)((uintptr_t)p1 + 512);
+		p2 = (unsigned long *)((uintptr_t)p2 + 512);
+		p3 = (unsigned long *)((uintptr_t)p3 + 512);
+	}
+
+	kernel_fpu_end();
+}
+
+static void xor_avx512_5(unsigned long bytes, unsigned long * __restrict p0,
+			 const unsigned long * __restrict p1,
+			 const unsigned long * __restrict p2,
+			 const unsigned long * __restrict p3,
+			 const unsigned long * __restrict p4)
+{
+	unsigned long lines = bytes >> 9;
+
+	kernel_fpu_begin();
+
+	while (lines--) {
+#undef BLOCK
+#define BLOCK(i, reg) \
+do { \
+	asm volatile("vmovdqu64 %0, %%zmm" #reg : : "m" (p4[i / sizeof(*p4)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p3[i / sizeof(*p3)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p2[i / sizeof(*p2)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p1[i / sizeof(*p1)])); \
+	asm volatile("vpxorq %0, %%zmm" #reg ", %%zmm" #reg : : \
+		"m" (p0[i / sizeof(*p0)])); \
+	asm volatile("vmovdqu64 %%zmm" #reg ", %0" : \
+		"=m" (p0[i / sizeof(*p0)])); \
+} while (0);
+
+		BLOCK8()
+
+		p0 = (unsigned long *)((uintptr_t)p0 + 512);
+		p1 = (unsigned long *)((uintptr_t)p1 + 512);
+		p2 = (unsigned long *)((uintptr_t)p2 + 512);
+		p3 = (unsigned long *)((uintptr_t)p3 + 512);
+		p4 = (unsigned long *)((uintptr_t)p4 + 512);
+	}
+
+	kernel_fpu_end();
+}
+
+static struct xor_block_template xor_block_avx512 = {
+	.name = "avx512",
+	.do_2 = xor_avx512_2,
+	.do_3 = xor_avx512_3,
+	.do_4 = xor_avx512_4,
+	.do_5 = xor_avx512_5,
+};
+
+#define AVX512_XOR_SPEED \
+do { \
+	if (boot_cpu_has(X86_FEATURE_AVX512F) && \
+	    cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM | \
+			      XFEATURE_MASK_AVX512, NULL)) \
+		xor_speed(&xor_block_avx512); \
+} while (0)
+
+#endif
@@ -1669,6 +1669,14 @@ void __init alternative_instructions(void)
 	 * patching.
 	 */
 
+#ifdef CONFIG_PARAVIRT_SPINLOCKS
+	/*
+	 * Pick the spinlock slow path before the paravirt calls to it get
+	 * patched, once the hypervisor had its chance to install its own.
+	 */
+	cna_configure_spin_lock_slowpath();
+#endif
+
 	/*
 	 * Make sure to set (artificial) features depending on used paravirt
 	 * functions which can later influence alternative patching.
@@ -900,6 +900,24 @@ static bool tlb_is_not_lazy(int cpu, void *data)
 	return !per_cpu(cpu_tlbstate_shared.is_lazy, cpu);
 }
 
+static void trace_flush_tlb_multi(const struct cpumask *cpumask,
+				  const struct flush_tlb_info *info)
+{
+	unsigned int nr_cpus = 0, nr_lazy = 0;
+	int cpu, this_cpu = smp_processor_id();
+
+	for_each_cpu(cpu, cpumask) {
+		if (cpu == this_cpu)
+			continue;
+		nr_cpus++;
+		if (!tlb_is_not_lazy(cpu, NULL))
+			nr_lazy++;
+	}
+	trace_tlb_flush_ipi(info->mm, nr_cpus, nr_lazy,
+			    info->freed_tables ? nr_cpus : nr_cpus - nr_lazy,
+			    info->freed_tables);
+}
+
 DEFINE_PER_CPU_SHARED_ALIGNED(struct tlb_state_shared, cpu_tlbstate_shared);
 EXPORT_PER_CPU_SYMBOL(cpu_tlbstate_shared);
 
@@ -917,6 +935,8 @@ STATIC_NOPV void native_flush_tlb_multi(const struct cpumask *cpumask,
 	else
 		trace_tlb_flush(TLB_REMOTE_SEND_IPI,
 				(info->end - info->start) >> PAGE_SHIFT);
+	if (trace_tlb_flush_ipi_enabled())
+		trace_flush_tlb_multi(cpumask, info);
 
 	/*
 	 * If no page tables were freed, we can skip sending IPIs to
@@ -26,12 +26,17 @@
 
 #define ALLOC_CACHE_THRESHOLD	16
 #define ALLOC_CACHE_MAX		256
+#define ALLOC_CACHE_VECS	16
+#define ALLOC_CACHE_VECS_MAX	64
 
 struct bio_alloc_cache {
 	struct bio		*free_list;
 	struct bio		*free_list_irq;
 	unsigned int		nr;
 	unsigned int		nr_irq;
+	/* biovec-16 tables, linked through their first entry */
+	void			*free_vecs;
+	unsigned int		nr_vecs;
 };
 
 static struct biovec_slab {
@@ -251,6 +256,7 @@ void bio_init(struct bio *bio, struct block_device *bdev, struct bio_vec *table,
 	bio->bi_flags = 0;
 	bio->bi_ioprio = 0;
 	bio->bi_write_hint = 0;
+	bio->bi_write_stream = 0;
 	bio->bi_status = 0;
 	bio->bi_iter.bi_sector = 0;
 	bio->bi_iter.bi_size = 0;
@@ -445,6 +451,7 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 		struct bio_set *bs)
 {
 	struct bio_alloc_cache *cache;
+	struct bio_vec *bvl = NULL;
 	struct bio *bio;
 
 	cache = per_cpu_ptr(bs->cache, get_cpu());
@@ -459,9 +466,32 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 	bio = cache->free_list;
 	cache->free_list = bio->bi_next;
 	cache->nr--;
+	if (nr_vecs > BIO_INLINE_VECS && cache->free_vecs) {
+		bvl = cache->free_vecs;
+		cache->free_vecs = *(void **)bvl;
+		cache->nr_vecs--;
+	}
 	put_cpu();
 
-	bio_init(bio, bdev, nr_vecs ? bio->bi_inline_vecs : NULL, nr_vecs, opf);
+	if (nr_vecs > BIO_INLINE_VECS) {
+		/*
+		 * Don't dip into the bvec mempool here, the regular allocation
+		 * path knows how to do that without deadlocking.
+		 */
+		nr_vecs = ALLOC_CACHE_VECS;
+		if (!bvl)
+			bvl = bvec_alloc(&bs->bvec_pool, &nr_vecs,
+					 gfp & ~__GFP_DIRECT_RECLAIM);
+		if (unlikely(!bvl)) {
+			bio->bi_pool = bs;
+			bio_free(bio);
+			return NULL;
+		}
+		bio_init(bio, bdev, bvl, nr_vecs, opf);
+	} else {
+		bio_init(bio, bdev, nr_vecs ? bio->bi_inline_vecs : NULL,
+			 nr_vecs, opf);
+	}
 	bio->bi_pool = bs;
 	return bio;
 }
@@ -512,8 +542,10 @@ struct bio *bio_alloc_bioset(struct block_device *bdev, unsigned short nr_vecs,
 	if (WARN_ON_ONCE(!mempool_initialized(&bs->bvec_pool) && nr_vecs > 0))
 		return NULL;
 
+	if (bs->cache_all && in_task())
+		opf |= REQ_ALLOC_CACHE;
 	if (opf & REQ_ALLOC_CACHE) {
-		if (bs->cache && nr_vecs <= BIO_INLINE_VECS) {
+		if (bs->cache && nr_vecs <= ALLOC_CACHE_VECS) {
 			bio = bio_alloc_percpu_cache(bdev, nr_vecs, opf,
 						     gfp_mask, bs);
 			if (bio)
@@ -737,6 +769,17 @@ static void bio_alloc_cache_prune(struct bio_alloc_cache *cache,
 	}
 }
 
+static void bio_alloc_cache_prune_vecs(struct bio_alloc_cache *cache)
+{
+	void *bvl;
+
+	while ((bvl = cache->free_vecs) != NULL) {
+		cache->free_vecs = *(void **)bvl;
+		cache->nr_vecs--;
+		kmem_cache_free(biovec_slab(ALLOC_CACHE_VECS)->slab, bvl);
+	}
+}
+
 static int bio_cpu_dead(unsigned int cpu, struct hlist_node *node)
 {
 	struct bio_set *bs;
@@ -746,6 +789,7 @@ static int bio_cpu_dead(unsigned int cpu, struct hlist_node *node)
 		struct bio_alloc_cache *cache = per_cpu_ptr(bs->cache, cpu);
 
 		bio_alloc_cache_prune(cache, -1U);
+		bio_alloc_cache_prune_vecs(cache);
 	}
 	return 0;
 }
@@ -763,6 +807,7 @@ static void bio_alloc_cache_destroy(struct bio_set *bs)
 
 		cache = per_cpu_ptr(bs->cache, cpu);
 		bio_alloc_cache_prune(cache, -1U);
+		bio_alloc_cache_prune_vecs(cache);
 	}
 	free_percpu(bs->cache);
 	bs->cache = NULL;
@@ -770,14 +815,39 @@ static void bio_alloc_cache_destroy(struct bio_set *bs)
 
 static inline void bio_put_percpu_cache(struct bio *bio)
 {
+	struct bio_set *bs = bio->bi_pool;
 	struct bio_alloc_cache *cache;
 
-	cache = per_cpu_ptr(bio->bi_pool->cache, get_cpu());
+	/*
+	 * Refill the mempool reserve before caching anything, otherwise a
+	 * bio_set using the cache for all allocations could keep its reserve
+	 * drained while bios pile up in per-cpu lists.
+	 */
+	if (!mempool_is_saturated(&bs->bio_pool)) {
+		bio_free(bio);
+		return;
+	}
+
+	cache = per_cpu_ptr(bs->cache, get_cpu());
 	if (READ_ONCE(cache->nr_irq) + cache->nr > ALLOC_CACHE_MAX)
 		goto out_free;
 
 	if (in_task()) {
 		bio_uninit(bio);
+		if (bio->bi_max_vecs > BIO_INLINE_VECS) {
+			if (bio->bi_max_vecs == ALLOC_CACHE_VECS &&
+			    cache->nr_vecs < ALLOC_CACHE_VECS_MAX &&
+			    mempool_is_saturated(&bs->bvec_pool)) {
+				*(void **)bio->bi_io_vec = cache->free_vecs;
+				cache->free_vecs = bio->bi_io_vec;
+				cache->nr_vecs++;
+			} else {
+				bvec_free(&bs->bvec_pool, bio->bi_io_vec,
+					  bio->bi_max_vecs);
+			}
+			bio->bi_io_vec = NULL;
+			bio->bi_max_vecs = 0;
+		}
 		bio->bi_next = cache->free_list;
 		/* Not necessary but helps not to iopoll already freed bios */
 		bio->bi_bdev = NULL;
@@ -787,6 +857,9 @@ static inline void bio_put_percpu_cache(struct bio *bio)
 		lockdep_assert_irqs_disabled();
 
 		bio_uninit(bio);
+		bvec_free(&bs->bvec_pool, bio->bi_io_vec, bio->bi_max_vecs);
+		bio->bi_io_vec = NULL;
+		bio->bi_max_vecs = 0;
 		bio->bi_next = cache->free_list_irq;
 		cache->free_list_irq = bio;
 		cache->nr_irq++;
@@ -827,6 +900,7 @@ static int __bio_clone(struct bio *bio, struct bio *bio_src, gfp_t gfp)
 	bio_set_flag(bio, BIO_CLONED);
 	bio->bi_ioprio = bio_src->bi_ioprio;
 	bio->bi_write_hint = bio_src->bi_write_hint;
+	bio->bi_write_stream = bio_src->bi_write_stream;
 	bio->bi_iter = bio_src->bi_iter;
 
 	if (bio->bi_bdev) {
@@ -1747,8 +1821,9 @@ EXPORT_SYMBOL(bioset_exit);
  * @bs:		pool to initialize
  * @pool_size:	Number of bio and bio_vecs to cache in the mempool
  * @front_pad:	Number of bytes to allocate in front of the returned bio
- * @flags:	Flags to modify behavior, currently %BIOSET_NEED_BVECS
- *              and %BIOSET_NEED_RESCUER
+ * @flags:	Flags to modify behavior, currently %BIOSET_NEED_BVECS,
+ *              %BIOSET_NEED_RESCUER, %BIOSET_PERCPU_CACHE and
+ *              %BIOSET_CACHE_ALL
  *
  * Description:
  *    Set up a bio_set to be used with @bio_alloc_bioset. Allows the caller
@@ -1761,6 +1836,10 @@ EXPORT_SYMBOL(bioset_exit);
  *    for allocating iovecs.  This pool is not needed e.g. for bio_init_clone().
  *    If %BIOSET_NEED_RESCUER is set, a workqueue is created which can be used
  *    to dispatch queued requests when the mempool runs out of space.
+ *    If %BIOSET_PERCPU_CACHE is set, bios allocated with %REQ_ALLOC_CACHE
+ *    are recycled through per-cpu caches, together with small bvec tables.
+ *    %BIOSET_CACHE_ALL additionally uses these caches for every allocation
+ *    from task context.
  *
  */
 int bioset_init(struct bio_set *bs,
@@ -1800,6 +1879,7 @@ int bioset_init(struct bio_set *bs,
 		if (!bs->cache)
 			goto bad;
 		cpuhp_state_add_instance_nocalls(CPUHP_BIO_DEAD, &bs->cpuhp_dead);
+		bs->cache_all = flags & BIOSET_CACHE_ALL;
 	}
 
 	return 0;
@@ -1829,7 +1909,8 @@ static int __init init_bio(void)
 					bio_cpu_dead);
 
 	if (bioset_init(&fs_bio_set, BIO_POOL_SIZE, 0,
-			BIOSET_NEED_BVECS | BIOSET_PERCPU_CACHE))
+			BIOSET_NEED_BVECS | BIOSET_PERCPU_CACHE |
+			BIOSET_CACHE_ALL))
 		panic("bio: can't allocate bios\n");
 
 	if (bioset_integrity_create(&fs_bio_set, BIO_POOL_SIZE))
@@ -1093,6 +1093,7 @@ EXPORT_SYMBOL(kblockd_mod_delayed_work_on);
 void blk_start_plug_nr_ios(struct blk_plug *plug, unsigned short nr_ios)
 {
 	struct task_struct *tsk = current;
+	int i;
 
 	/*
 	 * If this is a nested plug, don't actually assign it.
@@ -1102,6 +1103,8 @@ void blk_start_plug_nr_ios(struct blk_plug *plug, unsigned short nr_ios)
 
 	plug->cur_ktime = 0;
 	plug->mq_list = NULL;
+	for (i = 0; i < ARRAY_SIZE(plug->merge_hash); i++)
+		INIT_HLIST_HEAD(&plug->merge_hash[i]);
 	plug->cached_rq = NULL;
 	plug->nr_ios = min_t(unsigned short, nr_ios, BLK_MAX_REQUEST_COUNT);
 	plug->rq_count = 0;
@@ -301,6 +301,13 @@ enum {
 	/* don't let cmds which take a very long time pin lagging for too long */
 	MAX_LAGGING_PERIODS	= 10,
 
+	/*
+	 * When issuing within budget, charge vtime for up to this many IOs of
+	 * the same cost at once and let the CPU issue the following ones from
+	 * its local budget, see iocg_commit_bio_local().
+	 */
+	IOCG_PCPU_BUDGET_IOS	= 16,
+
 	/*
 	 * Count IO size in 4k pages.  The 12bit shift helps keeping
 	 * size-proportional components of cost calculation in closer
@@ -449,6 +456,10 @@ struct ioc {
 
 struct iocg_pcpu_stat {
 	local64_t			abs_vusage;
+
+	/* vtime charged to iocg->vtime ahead of use and the period it's for */
+	atomic64_t			budget;
+	u64				budget_period;
 };
 
 struct iocg_stat {
@@ -727,6 +738,83 @@ static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
 	put_cpu_ptr(gcs);
 }
 
+/*
+ * Issue @bio from the local CPU's pre-charged vtime budget, which lets most IOs
+ * of a busy iocg go without touching the shared @iocg->vtime. The budget is
+ * only good for the period it was charged in.
+ */
+static bool iocg_commit_bio_local(struct ioc_gq *iocg, struct bio *bio,
+				  u64 abs_cost, u64 cost)
+{
+	struct iocg_pcpu_stat *gcs;
+	bool committed = false;
+	s64 budget;
+
+	gcs = get_cpu_ptr(iocg->pcpu_stat);
+	if (gcs->budget_period != atomic64_read(&iocg->ioc->cur_period))
+		goto out;
+
+	budget = atomic64_read(&gcs->budget);
+	do {
+		if (budget < (s64)cost)
+			goto out;
+	} while (!atomic64_try_cmpxchg(&gcs->budget, &budget, budget - cost));
+
+	bio->bi_iocost_cost = cost;
+	local64_add(abs_cost, &gcs->abs_vusage);
+	committed = true;
+out:
+	put_cpu_ptr(gcs);
+	return committed;
+}
+
+/*
+ * Like iocg_commit_bio() but also charge up to @room of extra vtime for the
+ * local CPU's budget.
+ */
+static void iocg_commit_bio_batch(struct ioc_gq *iocg, struct bio *bio,
+				  u64 abs_cost, u64 cost, u64 room)
+{
+	u64 extra = min(cost * (IOCG_PCPU_BUDGET_IOS - 1), room - cost);
+	u64 period = atomic64_read(&iocg->ioc->cur_period);
+	struct iocg_pcpu_stat *gcs;
+	s64 stale = 0;
+
+	bio->bi_iocost_cost = cost;
+
+	gcs = get_cpu_ptr(iocg->pcpu_stat);
+	if (extra && gcs->budget_period != period) {
+		/* give back what's left from a past period */
+		stale = atomic64_xchg(&gcs->budget, 0);
+		gcs->budget_period = period;
+	}
+	atomic64_add(cost + extra - stale, &iocg->vtime);
+	if (extra)
+		atomic64_add(extra, &gcs->budget);
+	local64_add(abs_cost, &gcs->abs_vusage);
+	put_cpu_ptr(gcs);
+}
+
+/*
+ * Give the unused local budgets of all CPUs back to @iocg so that the vtime
+ * accounting and waiters see it.
+ */
+static void iocg_return_budgets(struct ioc_gq *iocg)
+{
+	u64 surplus = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct iocg_pcpu_stat *gcs = per_cpu_ptr(iocg->pcpu_stat, cpu);
+
+		if (atomic64_read(&gcs->budget))
+			surplus += atomic64_xchg(&gcs->budget, 0);
+	}
+
+	if (surplus)
+		atomic64_sub(surplus, &iocg->vtime);
+}
+
 static void iocg_lock(struct ioc_gq *iocg, bool lock_ioc, unsigned long *flags)
 {
 	if (lock_ioc) {
@@ -2276,8 +2364,10 @@ static void ioc_timer_fn(struct timer_list *timer)
 
 		/*
 		 * Collect unused and wind vtime closer to vnow to prevent
-		 * iocgs from accumulating a large amount of budget.
+		 * iocgs from accumulating a large amount of budget. The local
+		 * budgets are settled every period for the same reason.
 		 */
+		iocg_return_budgets(iocg);
 		vdone = atomic64_read(&iocg->done_vtime);
 		vtime = atomic64_read(&iocg->vtime);
 		current_hweight(iocg, &hw_active, &hw_inuse);
@@ -2624,14 +2714,18 @@ static void ioc_rqos_throttle(struct rq_qos *rqos, struct bio *bio)
 	cost = adjust_inuse_and_calc_cost(iocg, vtime, abs_cost, &now);
 
 	/*
-	 * If no one's waiting and within budget, issue right away.  The
-	 * tests are racy but the races aren't systemic - we only miss once
-	 * in a while which is fine.
+	 * If no one's waiting and within budget, issue right away, from the
+	 * local budget if there's enough left. The tests are racy but the
+	 * races aren't systemic - we only miss once in a while which is fine.
 	 */
-	if (!waitqueue_active(&iocg->waitq) && !iocg->abs_vdebt &&
-	    time_before_eq64(vtime + cost, now.vnow)) {
-		iocg_commit_bio(iocg, bio, abs_cost, cost);
-		return;
+	if (!waitqueue_active(&iocg->waitq) && !iocg->abs_vdebt) {
+		if (iocg_commit_bio_local(iocg, bio, abs_cost, cost))
+			return;
+		if (time_before_eq64(vtime + cost, now.vnow)) {
+			iocg_commit_bio_batch(iocg, bio, abs_cost, cost,
+					      now.vnow - vtime);
+			return;
+		}
 	}
 
 	/*
@@ -2715,6 +2809,8 @@ static void ioc_rqos_throttle(struct rq_qos *rqos, struct bio *bio)
 	wait.abs_cost = abs_cost;
 	wait.committed = false;	/* will be set true by waker */
 
+	/* the budgets held by other CPUs are better spent on waiters */
+	iocg_return_budgets(iocg);
 	__add_wait_queue_entry_tail(&iocg->waitq, &wait.wait);
 	iocg_kick_waitq(iocg, ioc_locked, &now);
 
@@ -3333,9 +3429,9 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 	spin_unlock_irq(&ioc->lock);
 
 	if (enable)
-		wbt_disable_default(disk);
+		wbt_qos_disable(disk, WBT_QOS_IOCOST);
 	else
-		wbt_enable_default(disk);
+		wbt_qos_enable(disk, WBT_QOS_IOCOST);
 
 	blk_mq_unquiesce_queue(disk->queue);
 	blk_mq_unfreeze_queue(disk->queue);
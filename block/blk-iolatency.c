@@ -62,6 +62,12 @@
  * root cg issued io's, wethere that's some metadata intensive operation or the
  * group is using so much memory that it is pushing us into swap.
  *
+ * While any group on a device has a latency target, wbt running with its
+ * default settings is switched off for that device.  Both controllers would
+ * otherwise react to the same completions with conflicting depth changes.
+ * Completion latencies keep being sorted into the per-queue histogram in
+ * blk-stat, which is visible as latency_hist in the queue's debugfs directory.
+ *
  * Copyright (C) 2018 Josef Bacik
  */
 #include <linux/kernel.h>
@@ -77,6 +83,7 @@
 #include "blk-rq-qos.h"
 #include "blk-stat.h"
 #include "blk-cgroup.h"
+#include "blk-wbt.h"
 #include "blk.h"
 
 #define DEFAULT_SCALE_COOKIE 1000000U
@@ -646,6 +653,15 @@ static void blkcg_iolatency_exit(struct rq_qos *rqos)
 
 	timer_shutdown_sync(&blkiolat->timer);
 	flush_work(&blkiolat->enable_work);
+	/*
+	 * Hand the device back to wbt if we took it over.  This runs from
+	 * rq_qos_exit() once the queue is unregistered, so wbt is never set
+	 * up from here, only switched back on if it's still around.
+	 */
+	if (blkiolat->enabled) {
+		blk_stat_disable_accounting(rqos->disk->queue);
+		wbt_qos_enable(rqos->disk, WBT_QOS_IOLATENCY);
+	}
 	blkcg_deactivate_policy(rqos->disk, &blkcg_policy_iolatency);
 	kfree(blkiolat);
 }
@@ -749,9 +765,20 @@ static void blkiolatency_enable_work_fn(struct work_struct *work)
 	 */
 	enabled = atomic_read(&blkiolat->enable_cnt);
 	if (enabled != blkiolat->enabled) {
-		blk_mq_freeze_queue(blkiolat->rqos.disk->queue);
+		struct gendisk *disk = blkiolat->rqos.disk;
+
+		blk_mq_freeze_queue(disk->queue);
 		blkiolat->enabled = enabled;
-		blk_mq_unfreeze_queue(blkiolat->rqos.disk->queue);
+		blk_mq_unfreeze_queue(disk->queue);
+
+		/* Only one latency controller gets to throttle the device */
+		if (enabled) {
+			wbt_qos_disable(disk, WBT_QOS_IOLATENCY);
+			blk_stat_enable_accounting(disk->queue);
+		} else {
+			blk_stat_disable_accounting(disk->queue);
+			wbt_qos_enable(disk, WBT_QOS_IOLATENCY);
+		}
 	}
 }
 
@@ -813,8 +813,9 @@ static struct request *attempt_merge(struct request_queue *q,
 	if (rq_data_dir(req) != rq_data_dir(next))
 		return NULL;
 
-	/* Don't merge requests with different write hints. */
-	if (req->write_hint != next->write_hint)
+	/* Don't merge requests with different write hints or streams. */
+	if (req->write_hint != next->write_hint ||
+	    req->write_stream != next->write_stream)
 		return NULL;
 
 	if (req->ioprio != next->ioprio)
@@ -944,8 +945,9 @@ bool blk_rq_merge_ok(struct request *rq, struct bio *bio)
 	if (!bio_crypt_rq_ctx_compatible(rq, bio))
 		return false;
 
-	/* Don't merge requests with different write hints. */
-	if (rq->write_hint != bio->bi_write_hint)
+	/* Don't merge requests with different write hints or streams. */
+	if (rq->write_hint != bio->bi_write_hint ||
+	    rq->write_stream != bio->bi_write_stream)
 		return false;
 
 	if (rq->ioprio != bio_prio(bio))
@@ -1100,7 +1102,8 @@ static enum bio_merge_status blk_attempt_bio_merge(struct request_queue *q,
  * from the passed in @q already in the plug list
  *
  * Determine whether @bio being queued on @q can be merged with the previous
- * request on %current's plugged list.  Returns %true if merge was successful,
+ * request on %current's plugged list, or be appended to any plugged request of
+ * @q which ends where @bio starts.  Returns %true if merge was successful,
  * otherwise %false.
  *
  * Plugging coalesces IOs from the same issuer for the same purpose without
@@ -1116,16 +1119,34 @@ bool blk_attempt_plug_merge(struct request_queue *q, struct bio *bio,
 		unsigned int nr_segs)
 {
 	struct blk_plug *plug = current->plug;
+	sector_t sector = bio->bi_iter.bi_sector;
 	struct request *rq;
 
 	if (!plug || rq_list_empty(plug->mq_list))
 		return false;
 
+	/*
+	 * Interleaved sequential streams would miss back merges by only looking
+	 * at the last request, find the request to append to by its end sector.
+	 */
+	hlist_for_each_entry(rq, blk_plug_hash_bucket(plug, sector), hash) {
+		if (rq->q != q || blk_rq_pos(rq) + blk_rq_sectors(rq) != sector)
+			continue;
+		if (blk_attempt_bio_merge(q, rq, bio, nr_segs, false) ==
+		    BIO_MERGE_OK) {
+			blk_plug_hash_reposition(plug, rq);
+			return true;
+		}
+		break;
+	}
+
 	rq_list_for_each(&plug->mq_list, rq) {
 		if (rq->q == q) {
 			if (blk_attempt_bio_merge(q, rq, bio, nr_segs, false) ==
-			    BIO_MERGE_OK)
+			    BIO_MERGE_OK) {
+				blk_plug_hash_reposition(plug, rq);
 				return true;
+			}
 			break;
 		}
 
@@ -12,12 +12,38 @@
 #include "blk-mq-debugfs.h"
 #include "blk-mq-sched.h"
 #include "blk-rq-qos.h"
+#include "blk-stat.h"
 
 static int queue_poll_stat_show(void *data, struct seq_file *m)
 {
 	return 0;
 }
 
+static int queue_latency_hist_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	u64 buckets[BLK_STAT_HIST_BUCKETS];
+	int dir, i;
+
+	for (dir = READ; dir <= WRITE; dir++) {
+		blk_stat_hist_sum(q, dir, buckets);
+		seq_puts(m, dir == READ ? "read:" : "write:");
+		for (i = 0; i < BLK_STAT_HIST_BUCKETS; i++)
+			seq_printf(m, " %llu", buckets[i]);
+		seq_putc(m, '\n');
+	}
+	return 0;
+}
+
+static ssize_t queue_latency_hist_write(void *data, const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct request_queue *q = data;
+
+	blk_stat_hist_reset(q);
+	return count;
+}
+
 static void *queue_requeue_list_start(struct seq_file *m, loff_t *pos)
 	__acquires(&q->requeue_lock)
 {
@@ -157,6 +183,7 @@ static ssize_t queue_state_write(void *data, const char __user *buf,
 
 static const struct blk_mq_debugfs_attr blk_mq_debugfs_queue_attrs[] = {
 	{ "poll_stat", 0400, queue_poll_stat_show },
+	{ "latency_hist", 0600, queue_latency_hist_show, queue_latency_hist_write },
 	{ "requeue_list", 0400, .seq_ops = &queue_requeue_list_seq_ops },
 	{ "pm_only", 0600, queue_pm_only_show, NULL },
 	{ "state", 0600, queue_state_show, queue_state_write },
@@ -102,17 +102,148 @@ void __blk_mq_tag_idle(struct blk_mq_hw_ctx *hctx)
 	blk_mq_tag_wakeup_all(tags, false);
 }
 
+/*
+ * Each CPU caches up to this many free tags of the bitmap_tags of a tag map.
+ */
+#define BLK_MQ_TAG_CACHE_MAX	16
+
+struct blk_mq_tag_cache {
+	spinlock_t	lock;
+	unsigned int	nr;
+	unsigned int	tags[BLK_MQ_TAG_CACHE_MAX];
+} ____cacheline_aligned_in_smp;
+
+/*
+ * Only let the caches hold a quarter of the tags at most, so that they rarely
+ * have to be drained for an allocation to succeed.
+ */
+static unsigned int blk_mq_tag_cache_batch(struct blk_mq_tags *tags,
+					   unsigned int depth)
+{
+	unsigned int batch = depth / (4 * num_possible_cpus());
+
+	if (!tags->cache || tags->bitmap_tags.sb.round_robin || batch < 2)
+		return 0;
+	return min(batch, BLK_MQ_TAG_CACHE_MAX);
+}
+
+/*
+ * Give the cached tags back to the sbitmap. Only the CPUs that refilled their
+ * cache since they were last drained can hold any.
+ */
+static void blk_mq_tag_cache_drain(struct blk_mq_tags *tags)
+{
+	int cpu;
+
+	if (!tags->cache)
+		return;
+
+	for_each_cpu(cpu, tags->cache_cpus) {
+		struct blk_mq_tag_cache *cache = per_cpu_ptr(tags->cache, cpu);
+		unsigned long flags;
+
+		spin_lock_irqsave(&cache->lock, flags);
+		cpumask_clear_cpu(cpu, tags->cache_cpus);
+		while (cache->nr)
+			sbitmap_queue_clear(&tags->bitmap_tags,
+					    cache->tags[--cache->nr], cpu);
+		spin_unlock_irqrestore(&cache->lock, flags);
+	}
+}
+
+/*
+ * Allocate a tag from the local CPU's cache of @tags->bitmap_tags, which is
+ * refilled with a batch of tags taken with a single atomic operation on one
+ * sbitmap word. This keeps submitters on different CPUs from bouncing the
+ * sbitmap cachelines, which hurts most with tag maps shared by many hctxs.
+ * Tags are freed straight to the sbitmap, which keeps waking up waiters as
+ * before. If the sbitmap runs dry, the caches of all CPUs are drained so that
+ * no tag is held back by an idle CPU.
+ */
+static int blk_mq_tag_cache_get(struct blk_mq_tags *tags, unsigned int batch)
+{
+	struct sbitmap_queue *bt = &tags->bitmap_tags;
+	struct blk_mq_tag_cache *cache;
+	unsigned int offset;
+	unsigned long flags, mask;
+	int tag = BLK_MQ_NO_TAG;
+	int cpu = raw_smp_processor_id();
+
+	cache = per_cpu_ptr(tags->cache, cpu);
+	spin_lock_irqsave(&cache->lock, flags);
+	if (!cache->nr) {
+		mask = __sbitmap_queue_get_batch(bt, batch, &offset);
+		for (; mask; mask &= mask - 1)
+			cache->tags[cache->nr++] = offset + __ffs(mask);
+		if (cache->nr && !cpumask_test_cpu(cpu, tags->cache_cpus))
+			cpumask_set_cpu(cpu, tags->cache_cpus);
+	}
+	if (cache->nr)
+		tag = cache->tags[--cache->nr];
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	if (tag != BLK_MQ_NO_TAG)
+		return tag;
+
+	tag = __sbitmap_queue_get(bt);
+	if (tag != BLK_MQ_NO_TAG)
+		return tag;
+
+	blk_mq_tag_cache_drain(tags);
+	return __sbitmap_queue_get(bt);
+}
+
+/*
+ * Resize bitmap_tags, draining the caches first as they may hold tags beyond
+ * the new depth.
+ */
+static void blk_mq_resize_bitmap_tags(struct blk_mq_tags *tags,
+				      unsigned int depth)
+{
+	WRITE_ONCE(tags->cache_batch, 0);
+	blk_mq_tag_cache_drain(tags);
+	sbitmap_queue_resize(&tags->bitmap_tags, depth);
+	WRITE_ONCE(tags->cache_batch, blk_mq_tag_cache_batch(tags, depth));
+}
+
+static void blk_mq_tag_cache_init(struct blk_mq_tags *tags)
+{
+	int cpu;
+
+	/* Without the caches, tags are simply allocated from the sbitmap */
+	if (!zalloc_cpumask_var(&tags->cache_cpus, GFP_KERNEL))
+		return;
+	tags->cache = alloc_percpu_gfp(struct blk_mq_tag_cache, GFP_KERNEL);
+	if (!tags->cache) {
+		free_cpumask_var(tags->cache_cpus);
+		return;
+	}
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(tags->cache, cpu)->lock);
+
+	tags->cache_batch = blk_mq_tag_cache_batch(tags,
+			tags->nr_tags - tags->nr_reserved_tags);
+}
+
 static int __blk_mq_get_tag(struct blk_mq_alloc_data *data,
 			    struct sbitmap_queue *bt)
 {
+	struct blk_mq_tags *tags = blk_mq_tags_from_data(data);
+	unsigned int batch;
+
 	if (!data->q->elevator && !(data->flags & BLK_MQ_REQ_RESERVED) &&
 			!hctx_may_queue(data->hctx, bt))
 		return BLK_MQ_NO_TAG;
 
 	if (data->shallow_depth)
 		return sbitmap_queue_get_shallow(bt, data->shallow_depth);
-	else
-		return __sbitmap_queue_get(bt);
+
+	batch = READ_ONCE(tags->cache_batch);
+	if (batch && bt == &tags->bitmap_tags)
+		return blk_mq_tag_cache_get(tags, batch);
+
+	return __sbitmap_queue_get(bt);
 }
 
 unsigned long blk_mq_get_tags(struct blk_mq_alloc_data *data, int nr_tags,
@@ -588,11 +719,16 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 		kfree(tags);
 		return NULL;
 	}
+	blk_mq_tag_cache_init(tags);
 	return tags;
 }
 
 void blk_mq_free_tags(struct blk_mq_tags *tags)
 {
+	if (tags->cache) {
+		free_percpu(tags->cache);
+		free_cpumask_var(tags->cache_cpus);
+	}
 	sbitmap_queue_free(&tags->bitmap_tags);
 	sbitmap_queue_free(&tags->breserved_tags);
 	kfree(tags);
@@ -643,8 +779,7 @@ int blk_mq_tag_update_depth(struct blk_mq_hw_ctx *hctx,
 		 * Don't need (or can't) update reserved tags here, they
 		 * remain static and should never need resizing.
 		 */
-		sbitmap_queue_resize(&tags->bitmap_tags,
-				tdepth - tags->nr_reserved_tags);
+		blk_mq_resize_bitmap_tags(tags, tdepth - tags->nr_reserved_tags);
 	}
 
 	return 0;
@@ -654,13 +789,13 @@ void blk_mq_tag_resize_shared_tags(struct blk_mq_tag_set *set, unsigned int size
 {
 	struct blk_mq_tags *tags = set->shared_tags;
 
-	sbitmap_queue_resize(&tags->bitmap_tags, size - set->reserved_tags);
+	blk_mq_resize_bitmap_tags(tags, size - set->reserved_tags);
 }
 
 void blk_mq_tag_update_sched_shared_tags(struct request_queue *q)
 {
-	sbitmap_queue_resize(&q->sched_shared_tags->bitmap_tags,
-			     q->nr_requests - q->tag_set->reserved_tags);
+	blk_mq_resize_bitmap_tags(q->sched_shared_tags,
+				  q->nr_requests - q->tag_set->reserved_tags);
 }
 
 /**
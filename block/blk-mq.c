@@ -1106,6 +1106,15 @@ void blk_mq_end_request_batch(struct io_comp_batch *iob)
 		if (!req_ref_put_and_test(rq))
 			continue;
 
+		/*
+		 * Requests allocated from sched tags also hold a driver tag
+		 * and need the scheduler restarted, free them one by one.
+		 */
+		if (rq->rq_flags & RQF_SCHED_TAGS) {
+			__blk_mq_free_request(rq);
+			continue;
+		}
+
 		blk_crypto_free_request(rq);
 		blk_pm_mark_last_busy(rq);
 
@@ -1309,9 +1318,26 @@ static void blk_add_rq_to_plug(struct blk_plug *plug, struct request *rq)
 		plug->has_elevator = true;
 	rq->rq_next = NULL;
 	rq_list_add(&plug->mq_list, rq);
+	if (rq_mergeable(rq))
+		blk_plug_hash_add(plug, rq);
 	plug->rq_count++;
 }
 
+/*
+ * The elevator takes over rq->hash once the requests are inserted, so empty
+ * the plug's merge hash before dispatching.
+ */
+static void blk_plug_hash_reset(struct blk_plug *plug)
+{
+	struct request *rq;
+	int i;
+
+	rq_list_for_each(&plug->mq_list, rq)
+		INIT_HLIST_NODE(&rq->hash);
+	for (i = 0; i < ARRAY_SIZE(plug->merge_hash); i++)
+		INIT_HLIST_HEAD(&plug->merge_hash[i]);
+}
+
 /**
  * blk_execute_rq_nowait - insert a request to I/O scheduler for execution
  * @rq:		request to insert
@@ -2550,6 +2576,7 @@ static void blk_mq_bio_to_request(struct request *rq, struct bio *bio,
 
 	rq->__sector = bio->bi_iter.bi_sector;
 	rq->write_hint = bio->bi_write_hint;
+	rq->write_stream = bio->bi_write_stream;
 	blk_rq_bio_prep(rq, bio, nr_segs);
 
 	/* This can't fail, since GFP_NOIO includes __GFP_DIRECT_RECLAIM. */
@@ -2769,6 +2796,7 @@ void blk_mq_flush_plug_list(struct blk_plug *plug, bool from_schedule)
 	if (plug->rq_count == 0)
 		return;
 	plug->rq_count = 0;
+	blk_plug_hash_reset(plug);
 
 	if (!plug->multiple_queues && !plug->has_elevator && !from_schedule) {
 		struct request_queue *q;
@@ -3171,6 +3199,7 @@ int blk_rq_prep_clone(struct request *rq, struct request *rq_src,
 	rq->nr_phys_segments = rq_src->nr_phys_segments;
 	rq->ioprio = rq_src->ioprio;
 	rq->write_hint = rq_src->write_hint;
+	rq->write_stream = rq_src->write_stream;
 
 	if (rq->bio && blk_crypto_rq_bio_prep(rq, rq->bio, gfp_mask) < 0)
 		goto free_and_out;
@@ -11,10 +11,19 @@
 #include "blk-mq.h"
 #include "blk.h"
 
+/*
+ * Completion latency histogram shared by all latency controllers of a queue,
+ * indexed by data direction and log2 of the latency in microseconds.
+ */
+struct blk_stat_hist {
+	u64 buckets[2][BLK_STAT_HIST_BUCKETS];
+};
+
 struct blk_queue_stats {
 	struct list_head callbacks;
 	spinlock_t lock;
 	int accounting;
+	struct blk_stat_hist __percpu *hist;
 };
 
 void blk_rq_stat_init(struct blk_rq_stat *stat)
@@ -59,6 +68,13 @@ void blk_stat_add(struct request *rq, u64 now)
 
 	rcu_read_lock();
 	cpu = get_cpu();
+	if (req_op(rq) == REQ_OP_READ || op_is_write(req_op(rq))) {
+		struct blk_stat_hist *hist = per_cpu_ptr(q->stats->hist, cpu);
+		unsigned int slot = min_t(unsigned int, fls64(value >> 10),
+					  BLK_STAT_HIST_BUCKETS - 1);
+
+		hist->buckets[op_is_write(req_op(rq))][slot]++;
+	}
 	list_for_each_entry_rcu(cb, &q->stats->callbacks, list) {
 		if (!blk_stat_is_active(cb))
 			continue;
@@ -211,6 +227,12 @@ struct blk_queue_stats *blk_alloc_queue_stats(void)
 	if (!stats)
 		return NULL;
 
+	stats->hist = alloc_percpu(struct blk_stat_hist);
+	if (!stats->hist) {
+		kfree(stats);
+		return NULL;
+	}
+
 	INIT_LIST_HEAD(&stats->callbacks);
 	spin_lock_init(&stats->lock);
 	stats->accounting = 0;
@@ -225,5 +247,37 @@ void blk_free_queue_stats(struct blk_queue_stats *stats)
 
 	WARN_ON(!list_empty(&stats->callbacks));
 
+	free_percpu(stats->hist);
 	kfree(stats);
 }
+
+/**
+ * blk_stat_hist_sum() - Sum the latency histogram of a queue over all CPUs.
+ * @q: The request queue.
+ * @dir: READ or WRITE.
+ * @buckets: Array of %BLK_STAT_HIST_BUCKETS counters to fill in.
+ *
+ * Bucket 0 counts completions under 1us, bucket n > 0 those between 2^(n-1)
+ * and 2^n us.  The last bucket also counts everything slower than that.
+ */
+void blk_stat_hist_sum(struct request_queue *q, int dir, u64 *buckets)
+{
+	int cpu, i;
+
+	memset(buckets, 0, BLK_STAT_HIST_BUCKETS * sizeof(*buckets));
+	for_each_possible_cpu(cpu) {
+		struct blk_stat_hist *hist = per_cpu_ptr(q->stats->hist, cpu);
+
+		for (i = 0; i < BLK_STAT_HIST_BUCKETS; i++)
+			buckets[i] += READ_ONCE(hist->buckets[dir][i]);
+	}
+}
+
+void blk_stat_hist_reset(struct request_queue *q)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(q->stats->hist, cpu), 0,
+		       sizeof(struct blk_stat_hist));
+}
@@ -62,9 +62,15 @@ struct blk_stat_callback {
 	struct rcu_head rcu;
 };
 
+/* log2 usec buckets, the last one covers everything from ~4s up */
+#define BLK_STAT_HIST_BUCKETS	24
+
 struct blk_queue_stats *blk_alloc_queue_stats(void);
 void blk_free_queue_stats(struct blk_queue_stats *);
 
+void blk_stat_hist_sum(struct request_queue *q, int dir, u64 *buckets);
+void blk_stat_hist_reset(struct request_queue *q);
+
 void blk_stat_add(struct request *rq, u64 now);
 
 /* record time/size info in request but not add a callback */
@@ -710,6 +710,9 @@ void wbt_enable_default(struct gendisk *disk)
 	if (q->elevator &&
 	    test_bit(ELEVATOR_FLAG_DISABLE_WBT, &q->elevator->flags))
 		enable = false;
+	/* A QoS policy still throttles the device, see wbt_qos_disable() */
+	if (READ_ONCE(q->wbt_qos_off))
+		enable = false;
 
 	/* Throttling already enabled? */
 	rqos = wbt_rq_qos(q);
@@ -785,6 +788,23 @@ void wbt_disable_default(struct gendisk *disk)
 }
 EXPORT_SYMBOL_GPL(wbt_disable_default);
 
+/*
+ * blk-iocost and blk-iolatency each turn the default wbt off while they are
+ * enabled.  Keep track of who did, so that one of them going away doesn't
+ * switch wbt back on under the other.  Both are idempotent per @owner.
+ */
+void wbt_qos_disable(struct gendisk *disk, enum wbt_qos_owner owner)
+{
+	set_bit(owner, &disk->queue->wbt_qos_off);
+	wbt_disable_default(disk);
+}
+
+void wbt_qos_enable(struct gendisk *disk, enum wbt_qos_owner owner)
+{
+	clear_bit(owner, &disk->queue->wbt_qos_off);
+	wbt_enable_default(disk);
+}
+
 #ifdef CONFIG_BLK_DEBUG_FS
 static int wbt_curr_win_nsec_show(void *data, struct seq_file *m)
 {
@@ -2,11 +2,19 @@
 #ifndef WB_THROTTLE_H
 #define WB_THROTTLE_H
 
+/* QoS policies that turn the default wbt off while they are active */
+enum wbt_qos_owner {
+	WBT_QOS_IOCOST,
+	WBT_QOS_IOLATENCY,
+};
+
 #ifdef CONFIG_BLK_WBT
 
 int wbt_init(struct gendisk *disk);
 void wbt_disable_default(struct gendisk *disk);
 void wbt_enable_default(struct gendisk *disk);
+void wbt_qos_disable(struct gendisk *disk, enum wbt_qos_owner owner);
+void wbt_qos_enable(struct gendisk *disk, enum wbt_qos_owner owner);
 
 u64 wbt_get_min_lat(struct request_queue *q);
 void wbt_set_min_lat(struct request_queue *q, u64 val);
@@ -22,6 +30,14 @@ static inline void wbt_disable_default(struct gendisk *disk)
 static inline void wbt_enable_default(struct gendisk *disk)
 {
 }
+static inline void wbt_qos_disable(struct gendisk *disk,
+				   enum wbt_qos_owner owner)
+{
+}
+static inline void wbt_qos_enable(struct gendisk *disk,
+				  enum wbt_qos_owner owner)
+{
+}
 
 #endif /* CONFIG_BLK_WBT */
 
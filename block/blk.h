@@ -3,6 +3,7 @@
 #define BLK_INTERNAL_H
 
 #include <linux/blk-crypto.h>
+#include <linux/hash.h>
 #include <linux/memblock.h>	/* for max_pfn/max_low_pfn */
 #include <linux/sched/sysctl.h>
 #include <linux/timekeeping.h>
@@ -289,6 +290,32 @@ bool blk_bio_list_merge(struct request_queue *q, struct list_head *list,
 #define BLK_MAX_REQUEST_COUNT	32
 #define BLK_PLUG_FLUSH_SIZE	(128 * 1024)
 
+/*
+ * Plugged requests are hashed by their end sector in plug->merge_hash, through
+ * rq->hash which only the elevator uses once the plug is flushed.
+ */
+static inline struct hlist_head *blk_plug_hash_bucket(struct blk_plug *plug,
+						     sector_t end)
+{
+	return &plug->merge_hash[hash_64(end, BLK_PLUG_HASH_BITS)];
+}
+
+static inline void blk_plug_hash_add(struct blk_plug *plug, struct request *rq)
+{
+	hlist_add_head(&rq->hash, blk_plug_hash_bucket(plug,
+				blk_rq_pos(rq) + blk_rq_sectors(rq)));
+}
+
+/* Rehash @rq after a merge moved its end sector */
+static inline void blk_plug_hash_reposition(struct blk_plug *plug,
+					    struct request *rq)
+{
+	if (hlist_unhashed(&rq->hash))
+		return;
+	hlist_del(&rq->hash);
+	blk_plug_hash_add(plug, rq);
+}
+
 /*
  * Internal elevator interface
  */
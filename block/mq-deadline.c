@@ -79,6 +79,16 @@ struct dd_per_prio {
 	struct io_stats_per_prio stats;
 };
 
+/*
+ * Requests are inserted on a per-CPU staging list, without taking dd->lock,
+ * and moved to the sort and fifo lists in batches by the next dispatch.
+ */
+struct dd_staging {
+	spinlock_t lock;
+	struct list_head at_head;
+	struct list_head at_tail;
+} ____cacheline_aligned_in_smp;
+
 struct deadline_data {
 	/*
 	 * run time data
@@ -86,6 +96,10 @@ struct deadline_data {
 
 	struct dd_per_prio per_prio[DD_PRIO_COUNT];
 
+	struct dd_staging __percpu *staging;
+	/* CPUs which may have staged requests */
+	cpumask_var_t staged_cpus;
+
 	/* Data direction of latest dispatched request. */
 	enum dd_data_dir last_dir;
 	unsigned int batching;		/* number of sequential requests made */
@@ -465,8 +479,10 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 	const unsigned long now = jiffies;
 	struct request *rq;
 	enum dd_prio prio;
+	LIST_HEAD(free);
 
 	spin_lock(&dd->lock);
+	dd_insert_staged(hctx, dd, &free);
 	rq = dd_dispatch_prio_aged_requests(dd, now);
 	if (rq)
 		goto unlock;
@@ -484,6 +500,8 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 unlock:
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&free);
+
 	return rq;
 }
 
@@ -529,6 +547,16 @@ static void dd_exit_sched(struct elevator_queue *e)
 {
 	struct deadline_data *dd = e->elevator_data;
 	enum dd_prio prio;
+	int cpu;
+
+	/* Bits can be left over from racing insertions, the lists can't */
+	for_each_cpu(cpu, dd->staged_cpus) {
+		struct dd_staging *ds = per_cpu_ptr(dd->staging, cpu);
+
+		WARN_ON_ONCE(!list_empty(&ds->at_head));
+		WARN_ON_ONCE(!list_empty(&ds->at_tail));
+	}
+	cpumask_clear(dd->staged_cpus);
 
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
 		struct dd_per_prio *per_prio = &dd->per_prio[prio];
@@ -548,6 +576,8 @@ static void dd_exit_sched(struct elevator_queue *e)
 			  stats->dispatched, atomic_read(&stats->completed));
 	}
 
+	free_percpu(dd->staging);
+	free_cpumask_var(dd->staged_cpus);
 	kfree(dd);
 }
 
@@ -560,6 +590,7 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	struct elevator_queue *eq;
 	enum dd_prio prio;
 	int ret = -ENOMEM;
+	int cpu;
 
 	eq = elevator_alloc(q, e);
 	if (!eq)
@@ -571,6 +602,20 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 
 	eq->elevator_data = dd;
 
+	dd->staging = alloc_percpu(struct dd_staging);
+	if (!dd->staging)
+		goto free_dd;
+	if (!zalloc_cpumask_var(&dd->staged_cpus, GFP_KERNEL))
+		goto free_staging;
+
+	for_each_possible_cpu(cpu) {
+		struct dd_staging *ds = per_cpu_ptr(dd->staging, cpu);
+
+		spin_lock_init(&ds->lock);
+		INIT_LIST_HEAD(&ds->at_head);
+		INIT_LIST_HEAD(&ds->at_tail);
+	}
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
 		struct dd_per_prio *per_prio = &dd->per_prio[prio];
 
@@ -595,6 +640,10 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	q->elevator = eq;
 	return 0;
 
+free_staging:
+	free_percpu(dd->staging);
+free_dd:
+	kfree(dd);
 put_eq:
 	kobject_put(&eq->kobj);
 	return ret;
@@ -681,9 +730,9 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 
 	trace_block_rq_insert(rq);
 
+	/* rq->fifo_time is when the request got staged by dd_insert_requests() */
 	if (flags & BLK_MQ_INSERT_AT_HEAD) {
 		list_add(&rq->queuelist, &per_prio->dispatch);
-		rq->fifo_time = jiffies;
 	} else {
 		struct list_head *insert_before;
 
@@ -698,14 +747,65 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 		/*
 		 * set expire time and add to fifo list
 		 */
-		rq->fifo_time = jiffies + dd->fifo_expire[data_dir];
+		rq->fifo_time += dd->fifo_expire[data_dir];
 		insert_before = &per_prio->fifo_list[data_dir];
 		list_add_tail(&rq->queuelist, insert_before);
 	}
 }
 
+static void dd_insert_list(struct blk_mq_hw_ctx *hctx, struct list_head *list,
+			   blk_insert_t flags, struct list_head *free)
+{
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		dd_insert_request(hctx, rq, flags, free);
+	}
+}
+
+/*
+ * Move the staged requests of all CPUs to the sort and fifo lists. Requests
+ * only wait on a staging list until the next dispatch, which the insertion
+ * triggers, so the deadlines which count from staging are still met.
+ */
+static void dd_insert_staged(struct blk_mq_hw_ctx *hctx,
+			     struct deadline_data *dd, struct list_head *free)
+{
+	int cpu;
+
+	lockdep_assert_held(&dd->lock);
+
+	for_each_cpu(cpu, dd->staged_cpus) {
+		struct dd_staging *ds = per_cpu_ptr(dd->staging, cpu);
+		LIST_HEAD(at_head);
+		LIST_HEAD(at_tail);
+
+		/*
+		 * Clear the bit before taking ds->lock. dd_insert_requests()
+		 * tests it only after dropping ds->lock, so it either finds the
+		 * bit clear and sets it again, or its requests are spliced
+		 * below. A bit may thus stay set with empty staging lists.
+		 */
+		cpumask_clear_cpu(cpu, dd->staged_cpus);
+		smp_mb__after_atomic();
+
+		spin_lock(&ds->lock);
+		list_splice_init(&ds->at_head, &at_head);
+		list_splice_init(&ds->at_tail, &at_tail);
+		spin_unlock(&ds->lock);
+
+		dd_insert_list(hctx, &at_head, BLK_MQ_INSERT_AT_HEAD, free);
+		dd_insert_list(hctx, &at_tail, 0, free);
+	}
+}
+
 /*
  * Called from blk_mq_insert_request() or blk_mq_dispatch_plug_list().
+ *
+ * Only the local CPU's staging lock is taken here, so that submitters on
+ * different CPUs don't contend on dd->lock.
  */
 static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 			       struct list_head *list,
@@ -713,19 +813,21 @@ static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
-	LIST_HEAD(free);
+	int cpu = raw_smp_processor_id();
+	struct dd_staging *ds = per_cpu_ptr(dd->staging, cpu);
+	const unsigned long now = jiffies;
+	struct request *rq;
 
-	spin_lock(&dd->lock);
-	while (!list_empty(list)) {
-		struct request *rq;
+	list_for_each_entry(rq, list, queuelist)
+		rq->fifo_time = now;
 
-		rq = list_first_entry(list, struct request, queuelist);
-		list_del_init(&rq->queuelist);
-		dd_insert_request(hctx, rq, flags, &free);
-	}
-	spin_unlock(&dd->lock);
+	spin_lock(&ds->lock);
+	list_splice_tail_init(list, flags & BLK_MQ_INSERT_AT_HEAD ?
+			      &ds->at_head : &ds->at_tail);
+	spin_unlock(&ds->lock);
 
-	blk_mq_free_requests(&free);
+	if (!cpumask_test_cpu(cpu, dd->staged_cpus))
+		cpumask_set_cpu(cpu, dd->staged_cpus);
 }
 
 /* Callback from inside blk_mq_rq_ctx_init(). */
@@ -766,6 +868,9 @@ static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	enum dd_prio prio;
 
+	if (!cpumask_empty(dd->staged_cpus))
+		return true;
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++)
 		if (dd_has_work_for_prio(&dd->per_prio[prio]))
 			return true;
@@ -116,7 +116,8 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 	void **tfm_ctx = acomp_tfm_ctx(tfm);
 	struct crypto_scomp *scomp = *tfm_ctx;
 	void **ctx = acomp_request_ctx(req);
-	struct scomp_scratch *scratch;
+	struct scomp_scratch *scratch = NULL;
+	bool src_linear, dst_linear;
 	void *src, *dst;
 	unsigned int dlen;
 	int ret;
@@ -132,10 +133,22 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 
 	dlen = req->dlen;
 
-	scratch = raw_cpu_ptr(&scomp_scratch);
-	spin_lock(&scratch->lock);
+	src_linear = sg_nents(req->src) == 1 && !PageHighMem(sg_page(req->src));
+	dst_linear = req->dst && sg_nents(req->dst) == 1 &&
+		     !PageHighMem(sg_page(req->dst));
+
+	/*
+	 * The per-cpu scratch buffers are only needed to linearize the
+	 * source or the destination.  Callers like zswap pass a single
+	 * lowmem page each way, don't serialize them on the scratch lock
+	 * nor keep preemption disabled while they compress.
+	 */
+	if (!src_linear || !dst_linear) {
+		scratch = raw_cpu_ptr(&scomp_scratch);
+		spin_lock(&scratch->lock);
+	}
 
-	if (sg_nents(req->src) == 1 && !PageHighMem(sg_page(req->src))) {
+	if (src_linear) {
 		src = page_to_virt(sg_page(req->src)) + req->src->offset;
 	} else {
 		scatterwalk_map_and_copy(scratch->src, req->src, 0,
@@ -143,7 +156,7 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 		src = scratch->src;
 	}
 
-	if (req->dst && sg_nents(req->dst) == 1 && !PageHighMem(sg_page(req->dst)))
+	if (dst_linear)
 		dst = page_to_virt(sg_page(req->dst)) + req->dst->offset;
 	else
 		dst = scratch->dst;
@@ -165,7 +178,7 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 			ret = -ENOSPC;
 			goto out;
 		}
-		if (dst == scratch->dst) {
+		if (!dst_linear) {
 			scatterwalk_map_and_copy(scratch->dst, req->dst, 0,
 						 req->dlen, 1);
 		} else {
@@ -178,7 +191,8 @@ static int scomp_acomp_comp_decomp(struct acomp_req *req, int dir)
 		}
 	}
 out:
-	spin_unlock(&scratch->lock);
+	if (scratch)
+		spin_unlock(&scratch->lock);
 	return ret;
 }
 
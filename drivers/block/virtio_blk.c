@@ -332,10 +332,9 @@ static inline u8 virtblk_vbr_status(struct virtblk_req *vbr)
 	return *((u8 *)&vbr->in_hdr + vbr->in_hdr_len - 1);
 }
 
-static inline void virtblk_request_done(struct request *req)
+static inline void virtblk_finish_cmd(struct request *req)
 {
 	struct virtblk_req *vbr = blk_mq_rq_to_pdu(req);
-	blk_status_t status = virtblk_result(virtblk_vbr_status(vbr));
 	struct virtio_blk *vblk = req->mq_hctx->queue->queuedata;
 
 	virtblk_unmap_data(req, vbr);
@@ -344,13 +343,22 @@ static inline void virtblk_request_done(struct request *req)
 	if (req_op(req) == REQ_OP_ZONE_APPEND)
 		req->__sector = virtio64_to_cpu(vblk->vdev,
 						vbr->in_hdr.zone_append.sector);
+}
+
+static inline void virtblk_request_done(struct request *req)
+{
+	struct virtblk_req *vbr = blk_mq_rq_to_pdu(req);
 
-	blk_mq_end_request(req, status);
+	virtblk_finish_cmd(req);
+	blk_mq_end_request(req, virtblk_result(virtblk_vbr_status(vbr)));
 }
 
+static void virtblk_complete_batch(struct io_comp_batch *iob);
+
 static void virtblk_done(struct virtqueue *vq)
 {
 	struct virtio_blk *vblk = vq->vdev->priv;
+	DEFINE_IO_COMP_BATCH(iob);
 	bool req_done = false;
 	int qid = vq->index;
 	struct virtblk_req *vbr;
@@ -363,9 +371,14 @@ static void virtblk_done(struct virtqueue *vq)
 		while ((vbr = virtqueue_get_buf(vblk->vqs[qid].vq, &len)) != NULL) {
 			struct request *req = blk_mq_rq_from_pdu(vbr);
 
-			if (likely(!blk_should_fake_timeout(req->q)))
-				blk_mq_complete_request(req);
 			req_done = true;
+			if (unlikely(blk_should_fake_timeout(req->q)) ||
+			    blk_mq_complete_request_remote(req))
+				continue;
+			if (!blk_mq_add_to_batch(req, &iob,
+						 virtblk_vbr_status(vbr),
+						 virtblk_complete_batch))
+				virtblk_request_done(req);
 		}
 	} while (!virtqueue_enable_cb(vq));
 
@@ -373,6 +386,10 @@ static void virtblk_done(struct virtqueue *vq)
 	if (req_done)
 		blk_mq_start_stopped_hw_queues(vblk->disk->queue, true);
 	spin_unlock_irqrestore(&vblk->vqs[qid].lock, flags);
+
+	/* end the whole batch at once, like it's done for polled queues */
+	if (!rq_list_empty(iob.req_list))
+		iob.complete(&iob);
 }
 
 static void virtio_commit_rqs(struct blk_mq_hw_ctx *hctx)
@@ -1195,10 +1212,8 @@ static void virtblk_complete_batch(struct io_comp_batch *iob)
 {
 	struct request *req;
 
-	rq_list_for_each(&iob->req_list, req) {
-		virtblk_unmap_data(req, blk_mq_rq_to_pdu(req));
-		virtblk_cleanup_cmd(req);
-	}
+	rq_list_for_each(&iob->req_list, req)
+		virtblk_finish_cmd(req);
 	blk_mq_end_request_batch(iob);
 }
 
@@ -80,6 +80,8 @@ struct mapped_device {
 
 	wait_queue_head_t wait;
 	unsigned long __percpu *pending_io;
+	/* bios mapped by dm_submit_bio_fast() */
+	unsigned long __percpu *fast_remap_ios;
 
 	/* forced geometry settings */
 	struct hd_geometry geometry;
@@ -206,6 +208,7 @@ struct dm_table {
 
 	bool integrity_supported:1;
 	bool singleton:1;
+	bool simple_remap:1;
 	unsigned integrity_added:1;
 
 	/*
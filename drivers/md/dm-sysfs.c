@@ -99,11 +99,19 @@ static ssize_t dm_attr_use_blk_mq_show(struct mapped_device *md, char *buf)
 	return strlen(buf);
 }
 
+static ssize_t dm_attr_fast_remap_ios_show(struct mapped_device *md, char *buf)
+{
+	sprintf(buf, "%lu\n", dm_fast_remap_ios(md));
+
+	return strlen(buf);
+}
+
 static DM_ATTR_RO(name);
 static DM_ATTR_RO(uuid);
 static DM_ATTR_RO(suspended);
 static DM_ATTR_RO(use_blk_mq);
 static DM_ATTR_RW(rq_based_seq_io_merge_deadline);
+static DM_ATTR_RO(fast_remap_ios);
 
 static struct attribute *dm_attrs[] = {
 	&dm_attr_name.attr,
@@ -111,6 +119,7 @@ static struct attribute *dm_attrs[] = {
 	&dm_attr_suspended.attr,
 	&dm_attr_use_blk_mq.attr,
 	&dm_attr_rq_based_seq_io_merge_deadline.attr,
+	&dm_attr_fast_remap_ios.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(dm);
@@ -1014,13 +1014,12 @@ bool dm_table_request_based(struct dm_table *t)
 	return __table_type_request_based(dm_table_get_type(t));
 }
 
-static bool dm_table_supports_poll(struct dm_table *t);
-
 static int dm_table_alloc_md_mempools(struct dm_table *t, struct mapped_device *md)
 {
 	enum dm_queue_mode type = dm_table_get_type(t);
 	unsigned int per_io_data_size = 0, front_pad, io_front_pad;
 	unsigned int min_pool_size = 0, pool_size;
+	int bs_flags = 0;
 	struct dm_md_mempools *pools;
 
 	if (unlikely(type == DM_TYPE_NONE)) {
@@ -1051,13 +1050,14 @@ static int dm_table_alloc_md_mempools(struct dm_table *t, struct mapped_device *
 	io_front_pad = roundup(per_io_data_size,
 		__alignof__(struct dm_io)) + DM_IO_BIO_OFFSET;
 	if (bioset_init(&pools->io_bs, pool_size, io_front_pad,
-			dm_table_supports_poll(t) ? BIOSET_PERCPU_CACHE : 0))
+			BIOSET_PERCPU_CACHE | BIOSET_CACHE_ALL))
 		goto out_free_pools;
 	if (t->integrity_supported &&
 	    bioset_integrity_create(&pools->io_bs, pool_size))
 		goto out_free_pools;
+	bs_flags = BIOSET_PERCPU_CACHE | BIOSET_CACHE_ALL;
 init_bs:
-	if (bioset_init(&pools->bs, pool_size, front_pad, 0))
+	if (bioset_init(&pools->bs, pool_size, front_pad, bs_flags))
 		goto out_free_pools;
 	if (t->integrity_supported &&
 	    bioset_integrity_create(&pools->bs, pool_size))
@@ -1423,6 +1423,14 @@ int dm_table_complete(struct dm_table *t)
 		return r;
 	}
 
+	t->simple_remap = __table_type_bio_based(t->type);
+	for (unsigned int i = 0; i < t->num_targets; i++) {
+		struct dm_target *ti = dm_table_get_target(t, i);
+
+		if (!ti->simple_remap || ti->per_io_data_size)
+			t->simple_remap = false;
+	}
+
 	r = dm_table_register_integrity(t);
 	if (r) {
 		DMERR("could not register integrity profile.");
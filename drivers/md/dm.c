@@ -1873,6 +1873,69 @@ static void dm_split_and_process_bio(struct mapped_device *md,
 		dm_queue_poll_io(bio, io);
 }
 
+/*
+ * Fast path for tables made of simple remapping targets only, such as
+ * dm-linear and dm-stripe: a normal bio that does not need to be split is
+ * mapped through the clone embedded in its dm_io right away. This skips the
+ * clone_info setup and split handling, and the dm_io only holds the
+ * reference of its clone.
+ */
+static bool dm_submit_bio_fast(struct mapped_device *md, struct dm_table *map,
+			       struct bio *bio)
+{
+	struct dm_target_io *tio;
+	struct dm_target *ti;
+	struct dm_io *io;
+	struct bio *clone;
+
+	if (bio->bi_opf & (REQ_PREFLUSH | REQ_POLLED | REQ_NOWAIT) ||
+	    !bio_sectors(bio) || is_abnormal_io(bio))
+		return false;
+	if (static_branch_unlikely(&zoned_enabled) &&
+	    bdev_is_zoned(bio->bi_bdev))
+		return false;
+	if (static_branch_unlikely(&swap_bios_enabled) &&
+	    unlikely(bio->bi_opf & REQ_SWAP))
+		return false;
+
+	ti = dm_table_find_target(map, bio->bi_iter.bi_sector);
+	if (unlikely(!ti) ||
+	    max_io_len(ti, bio->bi_iter.bi_sector) < bio_sectors(bio))
+		return false;
+
+	io = alloc_io(md, bio, GFP_NOIO);
+	/* no split and a single clone: no submission reference needed */
+	atomic_set(&io->io_count, 1);
+
+	tio = &io->tio;
+	tio->magic = DM_TIO_MAGIC;
+	tio->io = io;
+	tio->ti = ti;
+	tio->target_bio_nr = 0;
+	tio->len_ptr = NULL;
+	tio->old_sector = 0;
+
+	clone = &tio->clone;
+	clone->bi_bdev = md->disk->part0;
+	if (unlikely(ti->needs_bio_set_dev))
+		bio_set_dev(clone, md->disk->part0);
+
+	this_cpu_inc(*md->fast_remap_ios);
+	__map_bio(clone);
+	return true;
+}
+
+unsigned long dm_fast_remap_ios(struct mapped_device *md)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += *per_cpu_ptr(md->fast_remap_ios, cpu);
+
+	return sum;
+}
+
 static void dm_submit_bio(struct bio *bio)
 {
 	struct mapped_device *md = bio->bi_bdev->bd_disk->private_data;
@@ -1893,6 +1956,9 @@ static void dm_submit_bio(struct bio *bio)
 		goto out;
 	}
 
+	if (map->simple_remap && dm_submit_bio_fast(md, map, bio))
+		goto out;
+
 	dm_split_and_process_bio(md, map, bio);
 out:
 	dm_put_live_table(md, srcu_idx);
@@ -2072,6 +2138,8 @@ static void cleanup_mapped_device(struct mapped_device *md)
 		free_percpu(md->pending_io);
 		md->pending_io = NULL;
 	}
+	free_percpu(md->fast_remap_ios);
+	md->fast_remap_ios = NULL;
 
 	cleanup_srcu_struct(&md->io_barrier);
 
@@ -2180,6 +2248,10 @@ static struct mapped_device *alloc_dev(int minor)
 	if (!md->pending_io)
 		goto bad;
 
+	md->fast_remap_ios = alloc_percpu(unsigned long);
+	if (!md->fast_remap_ios)
+		goto bad;
+
 	r = dm_stats_init(&md->stats);
 	if (r < 0)
 		goto bad;
@@ -144,6 +144,7 @@ int dm_deleting_md(struct mapped_device *md);
  * Is this mapped_device suspended?
  */
 int dm_suspended_md(struct mapped_device *md);
+unsigned long dm_fast_remap_ios(struct mapped_device *md);
 
 /*
  * Internal suspend and resume methods.
@@ -3381,6 +3381,17 @@ schedule_reconstruction(struct stripe_head *sh, struct stripe_head_state *s,
 		if (s->locked + conf->max_degraded == disks)
 			if (!test_and_set_bit(STRIPE_FULL_WRITE, &sh->state))
 				atomic_inc(&conf->pending_full_writes);
+
+		if (!expand) {
+			unsigned long nr = 1;
+
+			if (sh->batch_head == sh)
+				nr += list_count_nodes(&sh->batch_list);
+			if (test_bit(STRIPE_FULL_WRITE, &sh->state))
+				this_cpu_add(conf->percpu->full_stripe_writes, nr);
+			else
+				this_cpu_add(conf->percpu->rcw_writes, nr);
+		}
 	} else {
 		BUG_ON(!(test_bit(R5_UPTODATE, &sh->dev[pd_idx].flags) ||
 			test_bit(R5_Wantcompute, &sh->dev[pd_idx].flags)));
@@ -3409,6 +3420,7 @@ schedule_reconstruction(struct stripe_head *sh, struct stripe_head_state *s,
 			/* False alarm - nothing to do */
 			return;
 		sh->reconstruct_state = reconstruct_state_prexor_drain_run;
+		this_cpu_inc(conf->percpu->rmw_writes);
 		set_bit(STRIPE_OP_PREXOR, &s->ops_request);
 		set_bit(STRIPE_OP_BIODRAIN, &s->ops_request);
 		set_bit(STRIPE_OP_RECONSTRUCT, &s->ops_request);
@@ -7111,6 +7123,36 @@ stripe_cache_active_show(struct mddev *mddev, char *page)
 static struct md_sysfs_entry
 raid5_stripecache_active = __ATTR_RO(stripe_cache_active);
 
+/*
+ * Number of stripes written as full stripes, with reconstruct-write after
+ * reading the missing data blocks, and with read-modify-write.
+ */
+static ssize_t
+stripe_writes_show(struct mddev *mddev, char *page)
+{
+	unsigned long full = 0, rcw = 0, rmw = 0;
+	struct r5conf *conf;
+	int cpu, ret = 0;
+
+	spin_lock(&mddev->lock);
+	conf = mddev->private;
+	if (conf && conf->percpu) {
+		for_each_possible_cpu(cpu) {
+			struct raid5_percpu *percpu = per_cpu_ptr(conf->percpu, cpu);
+
+			full += percpu->full_stripe_writes;
+			rcw += percpu->rcw_writes;
+			rmw += percpu->rmw_writes;
+		}
+		ret = sprintf(page, "%lu %lu %lu\n", full, rcw, rmw);
+	}
+	spin_unlock(&mddev->lock);
+	return ret;
+}
+
+static struct md_sysfs_entry
+raid5_stripe_writes = __ATTR_RO(stripe_writes);
+
 static ssize_t
 raid5_show_group_thread_cnt(struct mddev *mddev, char *page)
 {
@@ -7181,6 +7223,7 @@ raid5_group_thread_cnt = __ATTR(group_thread_cnt, S_IRUGO | S_IWUSR,
 static struct attribute *raid5_attrs[] =  {
 	&raid5_stripecache_size.attr,
 	&raid5_stripecache_active.attr,
+	&raid5_stripe_writes.attr,
 	&raid5_preread_bypass_threshold.attr,
 	&raid5_group_thread_cnt.attr,
 	&raid5_skip_copy.attr,
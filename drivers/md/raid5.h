@@ -569,6 +569,10 @@ struct raid5_percpu {
 				     */
 	int             scribble_obj_size;
 	local_lock_t    lock;
+	/* stripe writes by parity update method, see stripe_writes_show() */
+	unsigned long	full_stripe_writes;
+	unsigned long	rcw_writes;
+	unsigned long	rmw_writes;
 };
 
 struct r5conf {
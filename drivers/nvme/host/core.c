@@ -652,6 +652,7 @@ static void nvme_free_ns_head(struct kref *ref)
 		container_of(ref, struct nvme_ns_head, ref);
 
 	nvme_mpath_remove_disk(head);
+	kfree(head->plids);
 	ida_free(&head->subsys->ns_ida, head->instance);
 	cleanup_srcu_struct(&head->srcu);
 	nvme_put_subsystem(head->subsys);
@@ -927,6 +928,27 @@ static inline blk_status_t nvme_setup_write_zeroes(struct nvme_ns *ns,
 	return BLK_STS_OK;
 }
 
+/*
+ * Writes carrying an explicit stream use the matching placement handle.
+ * Otherwise the lifetime hint set through fcntl(F_SET_RW_HINT) picks one, so
+ * unmodified applications still get their data separated on FDP drives.
+ */
+static inline void nvme_assign_placement(struct nvme_ns_head *head,
+		unsigned int nr_plids, struct request *req, u16 *control,
+		u32 *dsmgmt)
+{
+	unsigned int stream = req->write_stream;
+
+	if (!stream && req->write_hint > WRITE_LIFE_NONE)
+		stream = min_t(unsigned int, req->write_hint - WRITE_LIFE_NONE,
+			       nr_plids);
+	if (!stream || stream > nr_plids)
+		return;
+
+	*control |= NVME_RW_DTYPE_DPLCMT;
+	*dsmgmt |= (u32)head->plids[stream - 1] << 16;
+}
+
 static inline blk_status_t nvme_setup_rw(struct nvme_ns *ns,
 		struct request *req, struct nvme_command *cmnd,
 		enum nvme_opcode op)
@@ -984,6 +1006,15 @@ static inline blk_status_t nvme_setup_rw(struct nvme_ns *ns,
 		}
 	}
 
+	if (op == nvme_cmd_write) {
+		/* pairs with the release in nvme_query_fdp_info() */
+		unsigned int nr_plids = smp_load_acquire(&ns->head->nr_plids);
+
+		if (nr_plids)
+			nvme_assign_placement(ns->head, nr_plids, req, &control,
+					&dsmgmt);
+	}
+
 	cmnd->rw.control = cpu_to_le16(control);
 	cmnd->rw.dsmgmt = cpu_to_le32(dsmgmt);
 	return 0;
@@ -2055,6 +2086,139 @@ static int nvme_update_ns_info_generic(struct nvme_ns *ns,
 	return ret;
 }
 
+static int nvme_query_fdp_runs(struct nvme_ctrl *ctrl, u16 endgid,
+		u8 fdpcidx, u32 *runs)
+{
+	struct nvme_fdp_config_log hdr, *log;
+	struct nvme_fdp_config_desc *desc;
+	size_t size, off, chunk;
+	u64 max_xfer;
+	void *end;
+	int ret, i;
+
+	ret = nvme_get_log_lsi(ctrl, 0, NVME_LOG_FDP_CONFIGS, 0, NVME_CSI_NVM,
+			&hdr, sizeof(hdr), 0, endgid);
+	if (ret)
+		return ret;
+
+	size = le32_to_cpu(hdr.size);
+	if (size < sizeof(hdr))
+		return -EINVAL;
+
+	log = kvzalloc(size, GFP_KERNEL | __GFP_NOWARN);
+	if (!log)
+		return -ENOMEM;
+
+	/* the log can be larger than a single transfer, read all of it */
+	max_xfer = (u64)ctrl->max_hw_sectors << SECTOR_SHIFT;
+	for (off = 0; off < size; off += chunk) {
+		chunk = size - off;
+		if (max_xfer)
+			chunk = min_t(u64, chunk, max_xfer);
+		ret = nvme_get_log_lsi(ctrl, 0, NVME_LOG_FDP_CONFIGS, 0,
+				NVME_CSI_NVM, (void *)log + off, chunk, off,
+				endgid);
+		if (ret)
+			goto out;
+	}
+
+	ret = -EINVAL;
+	if (fdpcidx > le16_to_cpu(log->n))
+		goto out;
+
+	/* every descriptor up to the one in use must lie within the log */
+	end = (void *)log + size;
+	desc = log->configs;
+	for (i = 0; ; i++) {
+		if ((void *)(desc + 1) > end ||
+		    le16_to_cpu(desc->dsze) < sizeof(*desc) ||
+		    (void *)desc + le16_to_cpu(desc->dsze) > end)
+			goto out;
+		if (i == fdpcidx)
+			break;
+		desc = (void *)desc + le16_to_cpu(desc->dsze);
+	}
+	if (!(desc->fdpa & NVME_FDP_FDPA_VALID))
+		goto out;
+
+	*runs = min_t(u64, le64_to_cpu(desc->runs), UINT_MAX);
+	ret = 0;
+out:
+	kvfree(log);
+	return ret;
+}
+
+/*
+ * Discover the reclaim unit handles of an FDP enabled endurance group and
+ * record the placement identifiers the namespace can use.  Failures are not
+ * fatal, the namespace just does not advertise any write streams.
+ */
+static void nvme_query_fdp_info(struct nvme_ns *ns, struct nvme_id_ns *id)
+{
+	struct nvme_ns_head *head = ns->head;
+	struct nvme_fdp_ruh_status *ruhs;
+	struct nvme_command c = { };
+	u16 endgid = le16_to_cpu(id->endgid);
+	u32 result, runs, nr;
+	size_t size;
+	u16 *plids;
+	int ret, i;
+
+	if (!(ns->ctrl->ctratt & NVME_CTRL_ATTR_FDPS) || head->plids)
+		return;
+
+	ret = nvme_get_features(ns->ctrl, NVME_FEAT_FDP, endgid, NULL, 0,
+			&result);
+	if (ret || !(result & NVME_FDP_FDPE))
+		return;
+
+	ret = nvme_query_fdp_runs(ns->ctrl, endgid, (result >> 8) & 0xff,
+			&runs);
+	if (ret)
+		return;
+
+	size = struct_size(ruhs, ruhsd, U8_MAX);
+	ruhs = kzalloc(size, GFP_KERNEL);
+	if (!ruhs)
+		return;
+
+	c.imr.opcode = nvme_cmd_io_mgmt_recv;
+	c.imr.nsid = cpu_to_le32(head->ns_id);
+	c.imr.mo = NVME_IO_MGMT_RECV_MO_RUHS;
+	c.imr.numd = cpu_to_le32(nvme_bytes_to_numd(size));
+	ret = nvme_submit_sync_cmd(ns->queue, &c, ruhs, size);
+	if (ret)
+		goto out;
+
+	nr = min_t(u32, le16_to_cpu(ruhs->nruhsd), U8_MAX);
+	if (!nr)
+		goto out;
+
+	plids = kcalloc(nr, sizeof(*plids), GFP_KERNEL);
+	if (!plids)
+		goto out;
+	for (i = 0; i < nr; i++)
+		plids[i] = le16_to_cpu(ruhs->ruhsd[i].pid);
+
+	/*
+	 * All paths of a shared namespace may get here concurrently; only
+	 * the first one publishes.  The identifiers are never changed or
+	 * freed before the head goes away, so I/O only needs to observe
+	 * ->nr_plids after them.
+	 */
+	mutex_lock(&head->subsys->lock);
+	if (!head->plids) {
+		head->runs = runs;
+		head->plids = plids;
+		smp_store_release(&head->nr_plids, nr);
+		plids = NULL;
+	}
+	mutex_unlock(&head->subsys->lock);
+	kfree(plids);
+out:
+	kfree(ruhs);
+}
+
 static int nvme_update_ns_info_block(struct nvme_ns *ns,
 		struct nvme_ns_info *info)
 {
@@ -2092,6 +2256,8 @@ static int nvme_update_ns_info_block(struct nvme_ns *ns,
 			goto out;
 	}
 
+	nvme_query_fdp_info(ns, id);
+
 	blk_mq_freeze_queue(ns->disk->queue);
 	ns->head->lba_shift = id->lbaf[lbaf].ds;
 	ns->head->nuse = le64_to_cpu(id->nuse);
@@ -2107,6 +2273,8 @@ static int nvme_update_ns_info_block(struct nvme_ns *ns,
 	if (IS_ENABLED(CONFIG_BLK_DEV_ZONED) &&
 	    ns->head->ids.csi == NVME_CSI_ZNS)
 		nvme_update_zone_info(ns, &lim, &zi);
+	lim.max_write_streams = ns->head->nr_plids;
+	lim.write_stream_granularity = ns->head->nr_plids ? ns->head->runs : 0;
 	ret = queue_limits_commit_update(ns->disk->queue, &lim);
 	if (ret) {
 		blk_mq_unfreeze_queue(ns->disk->queue);
@@ -2221,6 +2389,8 @@ static int nvme_update_ns_info(struct nvme_ns *ns, struct nvme_ns_info *info)
 		lim.physical_block_size = ns_lim->physical_block_size;
 		lim.io_min = ns_lim->io_min;
 		lim.io_opt = ns_lim->io_opt;
+		lim.max_write_streams = ns_lim->max_write_streams;
+		lim.write_stream_granularity = ns_lim->write_stream_granularity;
 		queue_limits_stack_bdev(&lim, ns->disk->part0, 0,
 					ns->head->disk->disk_name);
 		ret = queue_limits_commit_update(ns->head->disk->queue, &lim);
@@ -2952,8 +3122,8 @@ static int nvme_init_subsystem(struct nvme_ctrl *ctrl, struct nvme_id_ctrl *id)
 	return ret;
 }
 
-int nvme_get_log(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp, u8 csi,
-		void *log, size_t size, u64 offset)
+int nvme_get_log_lsi(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp,
+		u8 csi, void *log, size_t size, u64 offset, u16 lsi)
 {
 	struct nvme_command c = { };
 	u32 dwlen = nvme_bytes_to_numd(size);
@@ -2964,6 +3134,7 @@ int nvme_get_log(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp, u8 csi,
 	c.get_log_page.lsp = lsp;
 	c.get_log_page.numdl = cpu_to_le16(dwlen & ((1 << 16) - 1));
 	c.get_log_page.numdu = cpu_to_le16(dwlen >> 16);
+	c.get_log_page.lsi = cpu_to_le16(lsi);
 	c.get_log_page.lpol = cpu_to_le32(lower_32_bits(offset));
 	c.get_log_page.lpou = cpu_to_le32(upper_32_bits(offset));
 	c.get_log_page.csi = csi;
@@ -2971,6 +3142,13 @@ int nvme_get_log(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp, u8 csi,
 	return nvme_submit_sync_cmd(ctrl->admin_q, &c, log, size);
 }
 
+int nvme_get_log(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp, u8 csi,
+		void *log, size_t size, u64 offset)
+{
+	return nvme_get_log_lsi(ctrl, nsid, log_page, lsp, csi, log, size,
+			offset, 0);
+}
+
 static int nvme_get_effects_log(struct nvme_ctrl *ctrl, u8 csi,
 				struct nvme_effects_log **log)
 {
@@ -4862,6 +5040,7 @@ static inline void _nvme_check_size(void)
 	BUILD_BUG_ON(sizeof(struct nvme_write_zeroes_cmd) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_abort_cmd) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_get_log_page_command) != 64);
+	BUILD_BUG_ON(sizeof(struct nvme_io_mgmt_recv_cmd) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_command) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_id_ctrl) != NVME_IDENTIFY_DATA_SIZE);
 	BUILD_BUG_ON(sizeof(struct nvme_id_ns) != NVME_IDENTIFY_DATA_SIZE);
@@ -4876,6 +5055,10 @@ static inline void _nvme_check_size(void)
 	BUILD_BUG_ON(sizeof(struct nvme_dbbuf) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_directive_cmd) != 64);
 	BUILD_BUG_ON(sizeof(struct nvme_feat_host_behavior) != 512);
+	BUILD_BUG_ON(sizeof(struct nvme_fdp_config_desc) != 64);
+	BUILD_BUG_ON(sizeof(struct nvme_fdp_config_log) != 16);
+	BUILD_BUG_ON(sizeof(struct nvme_fdp_ruh_status_desc) != 32);
+	BUILD_BUG_ON(sizeof(struct nvme_fdp_ruh_status) != 16);
 }
 
 
@@ -17,6 +17,7 @@ MODULE_PARM_DESC(multipath,
 static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
+	[NVME_IOPOLICY_LAT]	= "latency",
 };
 
 static int iopolicy = NVME_IOPOLICY_NUMA;
@@ -29,6 +30,8 @@ static int nvme_set_iopolicy(const char *val, const struct kernel_param *kp)
 		iopolicy = NVME_IOPOLICY_NUMA;
 	else if (!strncmp(val, "round-robin", 11))
 		iopolicy = NVME_IOPOLICY_RR;
+	else if (!strncmp(val, "latency", 7))
+		iopolicy = NVME_IOPOLICY_LAT;
 	else
 		return -EINVAL;
 
@@ -43,7 +46,7 @@ static int nvme_get_iopolicy(char *buf, const struct kernel_param *kp)
 module_param_call(iopolicy, nvme_set_iopolicy, nvme_get_iopolicy,
 	&iopolicy, 0644);
 MODULE_PARM_DESC(iopolicy,
-	"Default multipath I/O policy; 'numa' (default) or 'round-robin'");
+	"Default multipath I/O policy; 'numa' (default), 'round-robin' or 'latency'");
 
 void nvme_mpath_default_iopolicy(struct nvme_subsystem *subsys)
 {
@@ -128,6 +131,13 @@ void nvme_mpath_start_request(struct request *rq)
 	struct nvme_ns *ns = rq->q->queuedata;
 	struct gendisk *disk = ns->head->disk;
 
+	if (READ_ONCE(ns->head->subsys->iopolicy) == NVME_IOPOLICY_LAT &&
+	    !(nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE)) {
+		atomic_inc(&ns->nr_active);
+		nvme_req(rq)->lat_start = ktime_get_ns();
+		nvme_req(rq)->flags |= NVME_MPATH_CNT_ACTIVE;
+	}
+
 	if (!blk_queue_io_stat(disk->queue) || blk_rq_is_passthrough(rq))
 		return;
 
@@ -137,10 +147,42 @@ void nvme_mpath_start_request(struct request *rq)
 }
 EXPORT_SYMBOL_GPL(nvme_mpath_start_request);
 
+/* A path without a sample for this long is measured again from scratch */
+#define NVME_LAT_STALE		HZ
+
+static bool nvme_mpath_lat_unmeasured(struct nvme_ns *ns)
+{
+	return !READ_ONCE(ns->lat_ewma) ||
+		time_after(jiffies, READ_ONCE(ns->lat_stamp) + NVME_LAT_STALE);
+}
+
+/*
+ * Fold a completion into the path's latency average with a weight of 1/8,
+ * or restart the average if the last sample is stale.  Concurrent
+ * completions may lose an update, which is fine for a hint.
+ */
+static void nvme_mpath_update_latency(struct nvme_ns *ns, u64 lat)
+{
+	u64 ewma = READ_ONCE(ns->lat_ewma);
+
+	if (nvme_mpath_lat_unmeasured(ns))
+		ewma = lat;
+	else
+		ewma = ewma - (ewma >> 3) + (lat >> 3);
+	WRITE_ONCE(ns->lat_ewma, ewma ?: 1);
+	WRITE_ONCE(ns->lat_stamp, jiffies);
+}
+
 void nvme_mpath_end_request(struct request *rq)
 {
 	struct nvme_ns *ns = rq->q->queuedata;
 
+	if (nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE) {
+		nvme_mpath_update_latency(ns,
+				ktime_get_ns() - nvme_req(rq)->lat_start);
+		atomic_dec(&ns->nr_active);
+	}
+
 	if (!(nvme_req(rq)->flags & NVME_MPATH_IO_STATS))
 		return;
 	bdev_end_io_acct(ns->head->disk->part0, req_op(rq),
@@ -334,6 +376,63 @@ static struct nvme_ns *nvme_round_robin_path(struct nvme_ns_head *head,
 	return found;
 }
 
+/*
+ * Pick the usable path with the lowest expected wait, estimated as the
+ * average completion latency scaled by the number of requests already in
+ * flight on the path.
+ *
+ * Paths without a recent sample, because they are new or were avoided for
+ * a while, would otherwise keep a stale or zero average forever.  An idle
+ * one gets the next request as a probe.  While the probe is in flight, the
+ * path is costed with the best measured latency, so it is not flooded.
+ */
+static struct nvme_ns *nvme_latency_path(struct nvme_ns_head *head)
+{
+	struct nvme_ns *best_opt = NULL, *best_nonopt = NULL, *ns;
+	u64 min_opt = U64_MAX, min_nonopt = U64_MAX, min_lat = U64_MAX;
+	u64 cost, lat;
+	int nr;
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (!nvme_path_is_disabled(ns) &&
+		    !nvme_mpath_lat_unmeasured(ns))
+			min_lat = min(min_lat, READ_ONCE(ns->lat_ewma));
+	}
+	if (min_lat == U64_MAX)
+		min_lat = 1;
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		nr = atomic_read(&ns->nr_active);
+		if (nvme_mpath_lat_unmeasured(ns))
+			lat = nr ? min_lat : 0;
+		else
+			lat = READ_ONCE(ns->lat_ewma);
+		cost = lat * (nr + 1);
+
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (cost < min_opt) {
+				min_opt = cost;
+				best_opt = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (cost < min_nonopt) {
+				min_nonopt = cost;
+				best_nonopt = ns;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return best_opt ? best_opt : best_nonopt;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return nvme_ctrl_state(ns->ctrl) == NVME_CTRL_LIVE &&
@@ -345,6 +444,9 @@ inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 	int node = numa_node_id();
 	struct nvme_ns *ns;
 
+	if (READ_ONCE(head->subsys->iopolicy) == NVME_IOPOLICY_LAT)
+		return nvme_latency_path(head);
+
 	ns = srcu_dereference(head->current_path[node], &head->srcu);
 	if (unlikely(!ns))
 		return __nvme_find_path(head, node);
@@ -838,6 +940,24 @@ static ssize_t ana_state_show(struct device *dev, struct device_attribute *attr,
 }
 DEVICE_ATTR_RO(ana_state);
 
+static ssize_t nr_active_show(struct device *dev, struct device_attribute *attr,
+		char *buf)
+{
+	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
+
+	return sysfs_emit(buf, "%d\n", atomic_read(&ns->nr_active));
+}
+DEVICE_ATTR_RO(nr_active);
+
+static ssize_t lat_ewma_ns_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(ns->lat_ewma));
+}
+DEVICE_ATTR_RO(lat_ewma_ns);
+
 static int nvme_lookup_ana_group_desc(struct nvme_ctrl *ctrl,
 		struct nvme_ana_group_desc *desc, void *data)
 {
@@ -182,6 +182,7 @@ struct nvme_request {
 	u16			status;
 #ifdef CONFIG_NVME_MULTIPATH
 	unsigned long		start_time;
+	u64			lat_start;
 #endif
 	struct nvme_ctrl	*ctrl;
 };
@@ -195,6 +196,7 @@ enum {
 	NVME_REQ_CANCELLED		= (1 << 0),
 	NVME_REQ_USERCMD		= (1 << 1),
 	NVME_MPATH_IO_STATS		= (1 << 2),
+	NVME_MPATH_CNT_ACTIVE		= (1 << 3),
 };
 
 static inline struct nvme_request *nvme_req(struct request *req)
@@ -408,6 +410,7 @@ static inline enum nvme_ctrl_state nvme_ctrl_state(struct nvme_ctrl *ctrl)
 enum nvme_iopolicy {
 	NVME_IOPOLICY_NUMA,
 	NVME_IOPOLICY_RR,
+	NVME_IOPOLICY_LAT,
 };
 
 struct nvme_subsystem {
@@ -477,6 +480,11 @@ struct nvme_ns_head {
 #endif
 	unsigned long		features;
 
+	/* FDP placement identifiers, indexed by write stream - 1 */
+	u16			nr_plids;
+	u16			*plids;
+	u32			runs;
+
 	struct ratelimit_state	rs_nuse;
 
 	struct cdev		cdev;
@@ -514,6 +522,10 @@ struct nvme_ns {
 #ifdef CONFIG_NVME_MULTIPATH
 	enum nvme_ana_state ana_state;
 	u32 ana_grpid;
+	/* in-flight requests and completion latency for the latency policy */
+	atomic_t nr_active;
+	u64 lat_ewma;
+	unsigned long lat_stamp;	/* jiffies of the last sample */
 #endif
 	struct list_head siblings;
 	struct kref kref;
@@ -898,6 +910,8 @@ int nvme_reset_ctrl(struct nvme_ctrl *ctrl);
 int nvme_reset_ctrl_sync(struct nvme_ctrl *ctrl);
 int nvme_delete_ctrl(struct nvme_ctrl *ctrl);
 void nvme_queue_scan(struct nvme_ctrl *ctrl);
+int nvme_get_log_lsi(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp,
+		u8 csi, void *log, size_t size, u64 offset, u16 lsi);
 int nvme_get_log(struct nvme_ctrl *ctrl, u32 nsid, u8 log_page, u8 lsp, u8 csi,
 		void *log, size_t size, u64 offset);
 bool nvme_tryget_ns_head(struct nvme_ns_head *head);
@@ -973,6 +987,8 @@ static inline void nvme_trace_bio_complete(struct request *req)
 extern bool multipath;
 extern struct device_attribute dev_attr_ana_grpid;
 extern struct device_attribute dev_attr_ana_state;
+extern struct device_attribute dev_attr_nr_active;
+extern struct device_attribute dev_attr_lat_ewma_ns;
 extern struct device_attribute subsys_attr_iopolicy;
 
 static inline bool nvme_disk_is_ns_head(struct gendisk *disk)
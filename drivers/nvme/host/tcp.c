@@ -1547,23 +1547,56 @@ static bool nvme_tcp_poll_queue(struct nvme_tcp_queue *queue)
 			  ctrl->io_queues[HCTX_TYPE_POLL];
 }
 
+/*
+ * Pick the first online cpu that blk-mq maps to this queue's hctx, so
+ * that submitters of this queue usually run on io_cpu and can take the
+ * direct send path in nvme_tcp_queue_request().
+ */
+static int nvme_tcp_mq_map_cpu(struct nvme_tcp_queue *queue,
+		enum hctx_type type)
+{
+	struct blk_mq_tag_set *set = &queue->ctrl->tag_set;
+	int qid = nvme_tcp_queue_id(queue);
+	int cpu;
+
+	if (type >= set->nr_maps || !set->map[type].mq_map)
+		return -1;
+
+	for_each_online_cpu(cpu) {
+		if (set->map[type].mq_map[cpu] == qid - 1)
+			return cpu;
+	}
+	return -1;
+}
+
 static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 {
 	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
 	int qid = nvme_tcp_queue_id(queue);
-	int n = 0;
+	enum hctx_type type = HCTX_MAX_TYPES;
+	int n = 0, cpu = -1;
 
-	if (nvme_tcp_default_queue(queue))
+	if (nvme_tcp_default_queue(queue)) {
 		n = qid - 1;
-	else if (nvme_tcp_read_queue(queue))
+		type = HCTX_TYPE_DEFAULT;
+	} else if (nvme_tcp_read_queue(queue)) {
 		n = qid - ctrl->io_queues[HCTX_TYPE_DEFAULT] - 1;
-	else if (nvme_tcp_poll_queue(queue))
+		type = HCTX_TYPE_READ;
+	} else if (nvme_tcp_poll_queue(queue)) {
 		n = qid - ctrl->io_queues[HCTX_TYPE_DEFAULT] -
 				ctrl->io_queues[HCTX_TYPE_READ] - 1;
-	if (wq_unbound)
+		type = HCTX_TYPE_POLL;
+	}
+	if (wq_unbound) {
 		queue->io_cpu = WORK_CPU_UNBOUND;
-	else
-		queue->io_cpu = cpumask_next_wrap(n - 1, cpu_online_mask, -1, false);
+		return;
+	}
+
+	if (type != HCTX_MAX_TYPES)
+		cpu = nvme_tcp_mq_map_cpu(queue, type);
+	if (cpu < 0)
+		cpu = cpumask_next_wrap(n - 1, cpu_online_mask, -1, false);
+	queue->io_cpu = cpu;
 }
 
 static void nvme_tcp_tls_done(void *data, int status, key_serial_t pskid)
@@ -1704,7 +1737,6 @@ static int nvme_tcp_alloc_queue(struct nvme_ctrl *nctrl, int qid,
 
 	queue->sock->sk->sk_allocation = GFP_ATOMIC;
 	queue->sock->sk->sk_use_task_frag = false;
-	nvme_tcp_set_queue_io_cpu(queue);
 	queue->request = NULL;
 	queue->data_remaining = 0;
 	queue->ddgst_remaining = 0;
@@ -1854,6 +1886,11 @@ static int nvme_tcp_start_queue(struct nvme_ctrl *nctrl, int idx)
 	struct nvme_tcp_queue *queue = &ctrl->queues[idx];
 	int ret;
 
+	/*
+	 * The I/O tag set, and with it the blk-mq cpu mapping, only exists
+	 * once the queues have been allocated, so pick io_cpu here.
+	 */
+	nvme_tcp_set_queue_io_cpu(queue);
 	queue->rd_enabled = true;
 	nvme_tcp_init_recv_ctx(queue);
 	nvme_tcp_setup_sock_ops(queue);
@@ -2012,7 +2049,7 @@ static void nvme_tcp_destroy_io_queues(struct nvme_ctrl *ctrl, bool remove)
 
 static int nvme_tcp_configure_io_queues(struct nvme_ctrl *ctrl, bool new)
 {
-	int ret, nr_queues;
+	int ret, nr_queues, i;
 
 	ret = nvme_tcp_alloc_io_queues(ctrl);
 	if (ret)
@@ -2052,6 +2089,12 @@ static int nvme_tcp_configure_io_queues(struct nvme_ctrl *ctrl, bool new)
 		}
 		blk_mq_update_nr_hw_queues(ctrl->tagset,
 			ctrl->queue_count - 1);
+		/*
+		 * The queues started above picked io_cpu from the old cpu
+		 * mapping, pick it again from the updated one.
+		 */
+		for (i = 1; i < nr_queues; i++)
+			nvme_tcp_set_queue_io_cpu(&to_tcp_ctrl(ctrl)->queues[i]);
 		nvme_unfreeze(ctrl);
 	}
 
@@ -127,6 +127,10 @@ struct vhost_net_virtqueue {
 	struct vhost_net_buf rxq;
 	/* Batched XDP buffs */
 	struct xdp_buff *xdp;
+	/* Adaptive busy poll time, bounded by vq.busyloop_timeout.
+	 * Protected by vq mutex.
+	 */
+	unsigned long busyloop_cur;
 };
 
 struct vhost_net {
@@ -526,10 +530,12 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 				bool *busyloop_intr,
 				bool poll_rx)
 {
+	struct vhost_net_virtqueue *nvq;
 	unsigned long busyloop_timeout;
-	unsigned long endtime;
+	unsigned long timeout, endtime;
 	struct socket *sock;
 	struct vhost_virtqueue *vq = poll_rx ? tvq : rvq;
+	bool found = false;
 
 	/* Try to hold the vq mutex of the paired virtqueue. We can't
 	 * use mutex_lock() here since we could not guarantee a
@@ -544,8 +550,16 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 	busyloop_timeout = poll_rx ? rvq->busyloop_timeout:
 				     tvq->busyloop_timeout;
 
+	/* The state is kept in the virtqueue we were called for, whose
+	 * mutex the caller holds.
+	 */
+	nvq = container_of(poll_rx ? rvq : tvq, struct vhost_net_virtqueue, vq);
+	timeout = nvq->busyloop_cur;
+	if (!timeout || timeout > busyloop_timeout)
+		timeout = busyloop_timeout;
+
 	preempt_disable();
-	endtime = busy_clock() + busyloop_timeout;
+	endtime = busy_clock() + timeout;
 
 	while (vhost_can_busy_poll(endtime)) {
 		if (vhost_vq_has_work(vq)) {
@@ -555,14 +569,26 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 
 		if ((sock_has_rx_data(sock) &&
 		     !vhost_vq_avail_empty(&net->dev, rvq)) ||
-		    !vhost_vq_avail_empty(&net->dev, tvq))
+		    !vhost_vq_avail_empty(&net->dev, tvq)) {
+			found = true;
 			break;
+		}
 
 		cpu_relax();
 	}
 
 	preempt_enable();
 
+	/* Poll longer when it pays off, and back off, down to a sixteenth
+	 * of the configured timeout, when the whole window was spent in
+	 * vain. The floor keeps polling often enough to notice when the
+	 * traffic picks up again.
+	 */
+	if (found)
+		nvq->busyloop_cur = min(timeout * 2, busyloop_timeout);
+	else if (!*busyloop_intr)
+		nvq->busyloop_cur = max(timeout / 2, busyloop_timeout / 16 ?: 1);
+
 	if (poll_rx || sock_has_rx_data(sock))
 		vhost_net_busy_poll_try_queue(net, vq);
 	else if (!poll_rx) /* On tx here, sock has no rx data. */
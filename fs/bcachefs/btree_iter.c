@@ -783,6 +783,21 @@ static inline int btree_path_lock_root(struct btree_trans *trans,
 	}
 }
 
+/*
+ * Recovery and fsck walk entire btrees, and are bottlenecked on node reads:
+ * keep a deep readahead window for them, including for online fsck, which
+ * runs after the filesystem has started. Otherwise only prefetch a couple of
+ * leaves, to avoid polluting the btree node cache:
+ */
+static unsigned btree_path_prefetch_nr(struct bch_fs *c, struct btree_path *path)
+{
+	if (!test_bit(BCH_FS_started, &c->flags) ||
+	    test_bit(BCH_FS_fsck_running, &c->flags))
+		return path->level > 1 ? 1 : 16;
+
+	return path->level > 1 ? 0 : 2;
+}
+
 noinline
 static int btree_path_prefetch(struct btree_trans *trans, struct btree_path *path)
 {
@@ -791,9 +806,7 @@ static int btree_path_prefetch(struct btree_trans *trans, struct btree_path *pat
 	struct btree_node_iter node_iter = l->iter;
 	struct bkey_packed *k;
 	struct bkey_buf tmp;
-	unsigned nr = test_bit(BCH_FS_started, &c->flags)
-		? (path->level > 1 ? 0 :  2)
-		: (path->level > 1 ? 1 : 16);
+	unsigned nr = btree_path_prefetch_nr(c, path);
 	bool was_locked = btree_node_locked(path, path->level);
 	int ret = 0;
 
@@ -826,9 +839,7 @@ static int btree_path_prefetch_j(struct btree_trans *trans, struct btree_path *p
 	struct bch_fs *c = trans->c;
 	struct bkey_s_c k;
 	struct bkey_buf tmp;
-	unsigned nr = test_bit(BCH_FS_started, &c->flags)
-		? (path->level > 1 ? 0 :  2)
-		: (path->level > 1 ? 1 : 16);
+	unsigned nr = btree_path_prefetch_nr(c, path);
 	bool was_locked = btree_node_locked(path, path->level);
 	int ret = 0;
 
@@ -606,7 +606,20 @@ static void run_one_async_done(struct btrfs_work *work, bool do_free)
 	__btrfs_submit_bio(bio, async->bioc, &async->smap, async->mirror_num);
 }
 
-static bool should_async_write(struct btrfs_bio *bbio)
+/*
+ * Bios at least this large are checksummed in the async workers even when the
+ * checksum implementation is fast.  Below this the workqueue round trip costs
+ * about as much as the checksum itself, above it a single submitter (usually
+ * the writeback thread of one file) becomes bound by checksum throughput.
+ */
+#define BTRFS_ASYNC_CSUM_MIN_SIZE	SZ_1M
+
+/*
+ * @length is the size of the bio before it was split at the stripe boundary.
+ * On striped profiles each piece is at most one stripe, so the size of the
+ * piece alone would almost never reach BTRFS_ASYNC_CSUM_MIN_SIZE.
+ */
+static bool should_async_write(struct btrfs_bio *bbio, u64 length)
 {
 	bool auto_csum_mode = true;
 
@@ -620,8 +633,12 @@ static bool should_async_write(struct btrfs_bio *bbio)
 	auto_csum_mode = (csum_mode == BTRFS_OFFLOAD_CSUM_AUTO);
 #endif
 
-	/* Submit synchronously if the checksum implementation is fast. */
-	if (auto_csum_mode && test_bit(BTRFS_FS_CSUM_IMPL_FAST, &bbio->fs_info->flags))
+	/*
+	 * Submit synchronously if the checksum implementation is fast, unless
+	 * the bio is large enough that spreading the work pays off.
+	 */
+	if (auto_csum_mode && test_bit(BTRFS_FS_CSUM_IMPL_FAST, &bbio->fs_info->flags) &&
+	    length < BTRFS_ASYNC_CSUM_MIN_SIZE)
 		return false;
 
 	/*
@@ -734,7 +751,7 @@ static bool btrfs_submit_chunk(struct btrfs_bio *bbio, int mirror_num)
 		if (inode && !(inode->flags & BTRFS_INODE_NODATASUM) &&
 		    !test_bit(BTRFS_FS_STATE_NO_CSUMS, &fs_info->fs_state) &&
 		    !btrfs_is_data_reloc_root(inode->root)) {
-			if (should_async_write(bbio) &&
+			if (should_async_write(bbio, length) &&
 			    btrfs_wq_submit_bio(bbio, bioc, &smap, mirror_num))
 				goto done;
 
@@ -2051,7 +2051,7 @@ static int btrfs_run_delayed_refs_for_head(struct btrfs_trans_handle *trans,
  * Returns -ENOMEM or -EIO on failure and will abort the transaction.
  */
 static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
-					     u64 min_bytes)
+					     u64 min_bytes, unsigned long *nr_heads)
 {
 	struct btrfs_fs_info *fs_info = trans->fs_info;
 	struct btrfs_delayed_ref_root *delayed_refs;
@@ -2127,6 +2127,8 @@ static noinline int __btrfs_run_delayed_refs(struct btrfs_trans_handle *trans,
 		 (max_count > 0 && count < max_count) ||
 		 locked_ref);
 
+	if (nr_heads)
+		*nr_heads += count;
 	return 0;
 }
 
@@ -2192,6 +2194,8 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans, u64 min_bytes)
 {
 	struct btrfs_fs_info *fs_info = trans->fs_info;
 	struct btrfs_delayed_ref_root *delayed_refs;
+	unsigned long nr_heads = 0;
+	u64 start_ns = 0;
 	int ret;
 
 	/* We'll clean this up in btrfs_cleanup_transaction */
@@ -2201,12 +2205,15 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans, u64 min_bytes)
 	if (test_bit(BTRFS_FS_CREATING_FREE_SPACE_TREE, &fs_info->flags))
 		return 0;
 
+	if (min_bytes == U64_MAX && trace_btrfs_run_delayed_refs_commit_enabled())
+		start_ns = ktime_get_ns();
+
 	delayed_refs = &trans->transaction->delayed_refs;
 again:
 #ifdef SCRAMBLE_DELAYED_REFS
 	delayed_refs->run_delayed_start = find_middle(&delayed_refs->root);
 #endif
-	ret = __btrfs_run_delayed_refs(trans, min_bytes);
+	ret = __btrfs_run_delayed_refs(trans, min_bytes, &nr_heads);
 	if (ret < 0) {
 		btrfs_abort_transaction(trans, ret);
 		return ret;
@@ -2218,6 +2225,10 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans, u64 min_bytes)
 		spin_lock(&delayed_refs->lock);
 		if (RB_EMPTY_ROOT(&delayed_refs->href_root.rb_root)) {
 			spin_unlock(&delayed_refs->lock);
+			if (start_ns)
+				trace_btrfs_run_delayed_refs_commit(fs_info,
+					trans->transid, nr_heads, 1,
+					ktime_get_ns() - start_ns);
 			return 0;
 		}
 		spin_unlock(&delayed_refs->lock);
@@ -2229,6 +2240,130 @@ int btrfs_run_delayed_refs(struct btrfs_trans_handle *trans, u64 min_bytes)
 	return 0;
 }
 
+/*
+ * Don't bother waking up helpers for fewer than this many ready ref heads per
+ * helper, the extent tree lock contention would eat the gain.
+ */
+#define BTRFS_DELAYED_REFS_PER_WORKER	256
+#define BTRFS_MAX_DELAYED_REF_WORKERS	8
+
+struct delayed_refs_parallel {
+	struct btrfs_fs_info *fs_info;
+	struct btrfs_transaction *cur_trans;
+	atomic_t pending;
+	struct completion done;
+	atomic_long_t nr_heads;
+	int error;
+};
+
+struct delayed_refs_worker {
+	struct work_struct work;
+	struct delayed_refs_parallel *ctx;
+};
+
+static void delayed_refs_worker_fn(struct work_struct *work)
+{
+	struct delayed_refs_worker *worker =
+		container_of(work, struct delayed_refs_worker, work);
+	struct delayed_refs_parallel *ctx = worker->ctx;
+	struct btrfs_trans_handle *trans;
+	unsigned long nr_heads = 0;
+	int ret;
+
+	/*
+	 * Join as TRANS_JOIN_NOLOCK: the committer keeps its own handle open
+	 * until we are done, so the transaction can't reach
+	 * TRANS_STATE_UNBLOCKED, the first state that blocks such a join.  A
+	 * regular join could end up waiting on a concurrent committer, which in
+	 * turn waits for the committer's handle, i.e. for us.
+	 */
+	trans = btrfs_join_transaction_spacecache(ctx->fs_info->tree_root);
+	if (IS_ERR(trans))
+		goto out;
+
+	if (trans->transaction == ctx->cur_trans && !TRANS_ABORTED(trans)) {
+		ret = __btrfs_run_delayed_refs(trans, 0, &nr_heads);
+		if (ret < 0) {
+			btrfs_abort_transaction(trans, ret);
+			cmpxchg(&ctx->error, 0, ret);
+		}
+		atomic_long_add(nr_heads, &ctx->nr_heads);
+	}
+	btrfs_end_transaction(trans);
+out:
+	if (atomic_dec_and_test(&ctx->pending))
+		complete(&ctx->done);
+}
+
+/*
+ * Run all delayed refs that are ready at the start of a transaction commit.
+ *
+ * Ref heads for different extents are independent, and btrfs_obtain_ref_head()
+ * hands each one to exactly one runner, so with a large backlog we let a few
+ * helpers joined to the same transaction work through disjoint heads next to
+ * the committing task.
+ */
+int btrfs_run_delayed_refs_parallel(struct btrfs_trans_handle *trans)
+{
+	struct btrfs_fs_info *fs_info = trans->fs_info;
+	struct btrfs_delayed_ref_root *delayed_refs;
+	struct delayed_refs_parallel ctx;
+	struct delayed_refs_worker *workers = NULL;
+	unsigned long nr_heads = 0;
+	u64 start_ns = ktime_get_ns();
+	int nr_workers;
+	int ret;
+	int i;
+
+	if (TRANS_ABORTED(trans))
+		return 0;
+
+	if (test_bit(BTRFS_FS_CREATING_FREE_SPACE_TREE, &fs_info->flags))
+		return 0;
+
+	delayed_refs = &trans->transaction->delayed_refs;
+	nr_workers = min3(num_online_cpus(), BTRFS_MAX_DELAYED_REF_WORKERS,
+			  READ_ONCE(delayed_refs->num_heads_ready) /
+			  BTRFS_DELAYED_REFS_PER_WORKER);
+	if (nr_workers > 1) {
+		workers = kcalloc(nr_workers - 1, sizeof(*workers), GFP_NOFS);
+		if (!workers)
+			nr_workers = 1;
+	} else {
+		nr_workers = 1;
+	}
+
+	ctx.fs_info = fs_info;
+	ctx.cur_trans = trans->transaction;
+	atomic_set(&ctx.pending, nr_workers - 1);
+	init_completion(&ctx.done);
+	atomic_long_set(&ctx.nr_heads, 0);
+	ctx.error = 0;
+
+	for (i = 0; i < nr_workers - 1; i++) {
+		workers[i].ctx = &ctx;
+		INIT_WORK(&workers[i].work, delayed_refs_worker_fn);
+		queue_work(system_unbound_wq, &workers[i].work);
+	}
+
+	ret = __btrfs_run_delayed_refs(trans, 0, &nr_heads);
+	if (ret < 0)
+		btrfs_abort_transaction(trans, ret);
+
+	if (nr_workers > 1) {
+		wait_for_completion(&ctx.done);
+		kfree(workers);
+		nr_heads += atomic_long_read(&ctx.nr_heads);
+		if (!ret)
+			ret = ctx.error;
+	}
+
+	trace_btrfs_run_delayed_refs_commit(fs_info, trans->transid, nr_heads,
+					    nr_workers,
+					    ktime_get_ns() - start_ns);
+	return ret;
+}
+
 int btrfs_set_disk_extent_flags(struct btrfs_trans_handle *trans,
 				struct extent_buffer *eb, u64 flags)
 {
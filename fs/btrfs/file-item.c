@@ -776,16 +776,15 @@ blk_status_t btrfs_csum_one_bio(struct btrfs_bio *bbio)
 						 bvec.bv_len + fs_info->sectorsize
 						 - 1);
 
+		data = bvec_kmap_local(&bvec);
 		for (i = 0; i < blockcount; i++) {
-			data = bvec_kmap_local(&bvec);
 			crypto_shash_digest(shash,
 					    data + (i * fs_info->sectorsize),
 					    fs_info->sectorsize,
 					    sums->sums + index);
-			kunmap_local(data);
 			index += fs_info->csum_size;
 		}
-
+		kunmap_local(data);
 	}
 
 	bbio->sums = sums;
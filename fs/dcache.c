@@ -128,6 +128,19 @@ static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
 static DEFINE_PER_CPU(long, nr_dentry_negative);
 
+/*
+ * Budget of unused negative dentries per superblock, 0 means unlimited.
+ * Going over it kicks a background walk that frees the coldest negative
+ * dentries of that superblock, rather than leaving them around until memory
+ * pressure and making every LRU operation pay for a huge list.
+ */
+static unsigned long sysctl_dentry_negative_limit __read_mostly;
+
+#define DENTRY_NEGATIVE_BATCH	64
+
+static void dentry_negative_prune_workfn(struct work_struct *work);
+static DECLARE_WORK(dentry_negative_prune_work, dentry_negative_prune_workfn);
+
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 /* Statistics gathering. */
 static struct dentry_stat_t dentry_stat = {
@@ -191,6 +204,13 @@ static struct ctl_table fs_dcache_sysctls[] = {
 		.mode		= 0444,
 		.proc_handler	= proc_nr_dentry,
 	},
+	{
+		.procname	= "dentry-negative-limit",
+		.data		= &sysctl_dentry_negative_limit,
+		.maxlen		= sizeof(sysctl_dentry_negative_limit),
+		.mode		= 0644,
+		.proc_handler	= proc_doulongvec_minmax,
+	},
 };
 
 static int __init init_fs_dcache_sysctls(void)
@@ -348,6 +368,27 @@ static inline void __d_set_inode_and_type(struct dentry *dentry,
 	smp_store_release(&dentry->d_flags, flags);
 }
 
+static void d_negative_inc(struct dentry *dentry)
+{
+	struct super_block *sb = dentry->d_sb;
+	unsigned long limit = READ_ONCE(sysctl_dentry_negative_limit);
+
+	this_cpu_inc(nr_dentry_negative);
+	percpu_counter_add_batch(&sb->s_nr_dentry_negative, 1,
+				 DENTRY_NEGATIVE_BATCH);
+	if (unlikely(limit) &&
+	    percpu_counter_read_positive(&sb->s_nr_dentry_negative) > limit &&
+	    !work_pending(&dentry_negative_prune_work))
+		queue_work(system_unbound_wq, &dentry_negative_prune_work);
+}
+
+static void d_negative_dec(struct dentry *dentry)
+{
+	this_cpu_dec(nr_dentry_negative);
+	percpu_counter_add_batch(&dentry->d_sb->s_nr_dentry_negative, -1,
+				 DENTRY_NEGATIVE_BATCH);
+}
+
 static inline void __d_clear_type_and_inode(struct dentry *dentry)
 {
 	unsigned flags = READ_ONCE(dentry->d_flags);
@@ -356,7 +397,7 @@ static inline void __d_clear_type_and_inode(struct dentry *dentry)
 	WRITE_ONCE(dentry->d_flags, flags);
 	dentry->d_inode = NULL;
 	if (flags & DCACHE_LRU_LIST)
-		this_cpu_inc(nr_dentry_negative);
+		d_negative_inc(dentry);
 }
 
 static void dentry_free(struct dentry *dentry)
@@ -426,7 +467,7 @@ static void d_lru_add(struct dentry *dentry)
 	dentry->d_flags |= DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_inc(nr_dentry_negative);
+		d_negative_inc(dentry);
 	WARN_ON_ONCE(!list_lru_add_obj(
 			&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
@@ -437,7 +478,7 @@ static void d_lru_del(struct dentry *dentry)
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		d_negative_dec(dentry);
 	WARN_ON_ONCE(!list_lru_del_obj(
 			&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
@@ -470,7 +511,7 @@ static void d_lru_isolate(struct list_lru_one *lru, struct dentry *dentry)
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		d_negative_dec(dentry);
 	list_lru_isolate(lru, &dentry->d_lru);
 }
 
@@ -480,7 +521,7 @@ static void d_lru_shrink_move(struct list_lru_one *lru, struct dentry *dentry,
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
 	dentry->d_flags |= DCACHE_SHRINK_LIST;
 	if (d_is_negative(dentry))
-		this_cpu_dec(nr_dentry_negative);
+		d_negative_dec(dentry);
 	list_lru_isolate_move(lru, &dentry->d_lru, list);
 }
 
@@ -585,6 +626,8 @@ static struct dentry *__dentry_kill(struct dentry *dentry)
 	 * The dentry is now unrecoverably dead to the world.
 	 */
 	lockref_mark_dead(&dentry->d_lockref);
+	if (unlikely(dentry->d_flags & DCACHE_PREFIX_CACHED))
+		path_prefix_cache_invalidate(dentry);
 
 	/*
 	 * inform the fs via d_prune that this dentry is about to be
@@ -1157,6 +1200,71 @@ long prune_dcache_sb(struct super_block *sb, struct shrink_control *sc)
 	return freed;
 }
 
+static enum lru_status dentry_lru_isolate_negative(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct list_head *freeable = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	if (dentry->d_lockref.count) {
+		d_lru_isolate(lru, dentry);
+		spin_unlock(&dentry->d_lock);
+		return LRU_REMOVED;
+	}
+
+	/*
+	 * Positive dentries are left to the shrinker, but rotated so that
+	 * repeated walks make progress towards the negative ones behind
+	 * them.  Referenced negative dentries get the usual second chance.
+	 */
+	if (d_is_positive(dentry) || (dentry->d_flags & DCACHE_REFERENCED)) {
+		dentry->d_flags &= ~DCACHE_REFERENCED;
+		spin_unlock(&dentry->d_lock);
+		return LRU_ROTATE;
+	}
+
+	d_lru_shrink_move(lru, dentry, freeable);
+	spin_unlock(&dentry->d_lock);
+
+	return LRU_REMOVED;
+}
+
+/*
+ * Bring a superblock that went over its negative dentry budget back to 7/8
+ * of it.  The walk is bounded by the LRU size and done in batches, so the
+ * per-node LRU locks are only held briefly.
+ */
+static void dentry_negative_prune_sb(struct super_block *sb, void *unused)
+{
+	unsigned long limit = READ_ONCE(sysctl_dentry_negative_limit);
+	long excess, nr_walk;
+
+	if (!limit)
+		return;
+
+	excess = percpu_counter_sum_positive(&sb->s_nr_dentry_negative) -
+		 (long)(limit - limit / 8);
+	nr_walk = list_lru_count(&sb->s_dentry_lru);
+	while (excess > 0 && nr_walk > 0) {
+		LIST_HEAD(dispose);
+
+		excess -= list_lru_walk(&sb->s_dentry_lru,
+					dentry_lru_isolate_negative, &dispose,
+					min(nr_walk, 1024L));
+		nr_walk -= 1024;
+		shrink_dentry_list(&dispose);
+		cond_resched();
+	}
+}
+
+static void dentry_negative_prune_workfn(struct work_struct *work)
+{
+	iterate_supers(dentry_negative_prune_sb, NULL);
+}
+
 static enum lru_status dentry_lru_isolate_shrink(struct list_head *item,
 		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
 {
@@ -1847,7 +1955,7 @@ static void __d_instantiate(struct dentry *dentry, struct inode *inode)
 	 * Decrement negative dentry count if it was in the LRU list.
 	 */
 	if (dentry->d_flags & DCACHE_LRU_LIST)
-		this_cpu_dec(nr_dentry_negative);
+		d_negative_dec(dentry);
 	hlist_add_head(&dentry->d_u.d_alias, &inode->i_dentry);
 	raw_write_seqcount_begin(&dentry->d_seq);
 	__d_set_inode_and_type(dentry, inode, add_flags);
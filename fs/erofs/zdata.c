@@ -1325,6 +1325,47 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 	return err;
 }
 
+static void z_erofs_decompressqueue_work(struct work_struct *work);
+
+/*
+ * Large readahead windows end up as one long chain of pclusters.  Keep the
+ * first Z_EROFS_PARALLEL_BATCH of them (the lowest file offsets, which is
+ * what the reader is usually waiting for) and hand the rest of the chain to
+ * another erofs worker, which will split it again in the same way.
+ */
+#define Z_EROFS_PARALLEL_BATCH		4
+
+static void z_erofs_spread_decompressqueue(const struct z_erofs_decompressqueue *io)
+{
+	z_erofs_next_pcluster_t owned = io->head;
+	struct z_erofs_decompressqueue *q;
+	struct z_erofs_pcluster *pcl;
+	int i;
+
+	if (num_online_cpus() < 2)
+		return;
+
+	for (i = 0; i < Z_EROFS_PARALLEL_BATCH; ++i) {
+		if (owned == Z_EROFS_PCLUSTER_TAIL)
+			return;
+		DBG_BUGON(owned == Z_EROFS_PCLUSTER_NIL);
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		owned = READ_ONCE(pcl->next);
+	}
+	if (owned == Z_EROFS_PCLUSTER_TAIL)
+		return;
+
+	q = kvzalloc(sizeof(*q), GFP_NOWAIT | __GFP_NOWARN);
+	if (!q)
+		return;
+	q->sb = io->sb;
+	q->eio = io->eio;
+	q->head = owned;
+	WRITE_ONCE(pcl->next, Z_EROFS_PCLUSTER_TAIL);
+	INIT_WORK(&q->u.work, z_erofs_decompressqueue_work);
+	queue_work(z_erofs_workqueue, &q->u.work);
+}
+
 static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 				     struct page **pagepool)
 {
@@ -1336,6 +1377,7 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 	};
 	z_erofs_next_pcluster_t owned = io->head;
 
+	z_erofs_spread_decompressqueue(io);
 	while (owned != Z_EROFS_PCLUSTER_TAIL) {
 		DBG_BUGON(owned == Z_EROFS_PCLUSTER_NIL);
 
@@ -37,6 +37,8 @@
 #include <linux/seq_file.h>
 #include <linux/compat.h>
 #include <linux/rculist.h>
+#include <linux/llist.h>
+#include <linux/percpu.h>
 #include <linux/capability.h>
 #include <net/busy_poll.h>
 
@@ -46,14 +48,14 @@
  *
  * 1) epnested_mutex (mutex)
  * 2) ep->mtx (mutex)
- * 3) ep->lock (rwlock)
+ * 3) ep->lock (spinlock)
  *
  * The acquire order is the one listed above, from 1 to 3.
- * We need a rwlock (ep->lock) because we manipulate objects
- * from inside the poll callback, that might be triggered from
- * a wake_up() that in turn might be called from IRQ context.
- * So we can't sleep inside the poll callback and hence we need
- * a spinlock. During the event transfer loop (from kernel to
+ * The poll callback, that might be triggered from a wake_up() that in
+ * turn might be called from IRQ context, takes no lock at all: it queues
+ * the item on a per-CPU ready list, and whoever looks for events next
+ * moves those items to ep->rdllist under ep->lock (a spinlock, as this
+ * happens with IRQs disabled). During the event transfer loop (from kernel to
  * user space) we could end up sleeping due a copy_to_user(), so
  * we need a lock that will allow us to sleep. This lock is a
  * mutex (ep->mtx). It is acquired during the event transfer loop,
@@ -140,10 +142,10 @@ struct epitem {
 	struct list_head rdllink;
 
 	/*
-	 * Works together "struct eventpoll"->ovflist in keeping the
-	 * single linked chain of items.
+	 * Links this item on one of the per-CPU ready lists of the
+	 * eventpoll, EP_UNACTIVE_PTR in ->next while it isn't queued.
 	 */
-	struct epitem *next;
+	struct llist_node ready_node;
 
 	/* The file descriptor information this item refers to */
 	struct epoll_filefd ffd;
@@ -194,18 +196,22 @@ struct eventpoll {
 	/* List of ready file descriptors */
 	struct list_head rdllist;
 
-	/* Lock which protects rdllist and ovflist */
-	rwlock_t lock;
+	/* Lock which protects rdllist */
+	spinlock_t lock;
 
 	/* RB tree root used to store monitored fd structs */
 	struct rb_root_cached rbr;
 
 	/*
-	 * This is a single linked list that chains all the "struct epitem" that
-	 * happened while transferring ready events to userspace w/out
-	 * holding ->lock.
+	 * Per-CPU lists the poll callback queues ready items on, without
+	 * taking any lock; they are moved to ->rdllist by ep_ready_drain().
+	 * A CPU is set in ->ready_cpus, and then ->ready_pending is set, when
+	 * its list became non-empty.  Both are allocated by the first
+	 * EPOLL_CTL_ADD.
 	 */
-	struct epitem *ovflist;
+	struct llist_head __percpu *ready_lists;
+	cpumask_var_t ready_cpus;
+	bool ready_pending;
 
 	/* wakeup_source used when ep_send_events or __ep_eventpoll_poll is running */
 	struct wakeup_source *ws;
@@ -389,7 +395,7 @@ static inline struct epitem *ep_item_from_wait(wait_queue_entry_t *p)
 static inline int ep_events_available(struct eventpoll *ep)
 {
 	return !list_empty_careful(&ep->rdllist) ||
-		READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR;
+		READ_ONCE(ep->ready_pending);
 }
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
@@ -430,6 +436,27 @@ static bool ep_busy_loop_end(void *p, unsigned long start_time)
 	return ep_events_available(ep) || busy_loop_ep_timeout(start_time, ep);
 }
 
+/*
+ * With prefer_busy_poll the application, not the device irq, drives the
+ * napi: keep its irqs suspended while we keep finding events, and hand
+ * it back to the irq as soon as a busy poll comes up empty.
+ */
+static void ep_suspend_napi_irqs(struct eventpoll *ep)
+{
+	unsigned int napi_id = READ_ONCE(ep->napi_id);
+
+	if (napi_id >= MIN_NAPI_ID && READ_ONCE(ep->prefer_busy_poll))
+		napi_suspend_irqs(napi_id);
+}
+
+static void ep_resume_napi_irqs(struct eventpoll *ep)
+{
+	unsigned int napi_id = READ_ONCE(ep->napi_id);
+
+	if (napi_id >= MIN_NAPI_ID && READ_ONCE(ep->prefer_busy_poll))
+		napi_resume_irqs(napi_id);
+}
+
 /*
  * Busy poll if globally on and supporting sockets found && no events,
  * busy loop will return if need_resched or ep_events_available.
@@ -455,6 +482,8 @@ static bool ep_busy_loop(struct eventpoll *ep, int nonblock)
 		 * it back in when we have moved a socket with a valid NAPI
 		 * ID onto the ready list.
 		 */
+		if (prefer_busy_poll)
+			napi_resume_irqs(napi_id);
 		ep->napi_id = 0;
 		return false;
 	}
@@ -521,6 +550,10 @@ static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
 		    !capable(CAP_NET_ADMIN))
 			return -EPERM;
 
+		/* Don't leave irqs suspended on behalf of a poller that left */
+		if (!epoll_params.prefer_busy_poll)
+			ep_resume_napi_irqs(ep);
+
 		WRITE_ONCE(ep->busy_poll_usecs, epoll_params.busy_poll_usecs);
 		WRITE_ONCE(ep->busy_poll_budget, epoll_params.busy_poll_budget);
 		WRITE_ONCE(ep->prefer_busy_poll, epoll_params.prefer_busy_poll);
@@ -549,6 +582,14 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 {
 }
 
+static inline void ep_suspend_napi_irqs(struct eventpoll *ep)
+{
+}
+
+static inline void ep_resume_napi_irqs(struct eventpoll *ep)
+{
+}
+
 static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
 				  unsigned long arg)
 {
@@ -697,6 +738,48 @@ static inline void ep_pm_stay_awake_rcu(struct epitem *epi)
 }
 
 
+/*
+ * Move the items queued by ep_poll_callback() on the per-CPU ready lists
+ * to ep->rdllist.  Items already on ep->rdllist, or on the "txlist" of a
+ * scan in progress, stay where they are.  Unless @force is set, this is
+ * skipped if none of the per-CPU lists got an item since the last drain.
+ */
+static void ep_ready_drain(struct eventpoll *ep, bool force)
+{
+	int cpu;
+
+	lockdep_assert_held(&ep->lock);
+
+	/* Pairs with wq_has_sleeper() in ep_poll_callback() */
+	smp_mb();
+	if (!force && !READ_ONCE(ep->ready_pending))
+		return;
+	WRITE_ONCE(ep->ready_pending, false);
+	/* Clear ->ready_pending before reading ->ready_cpus */
+	smp_mb();
+
+	for_each_cpu(cpu, ep->ready_cpus) {
+		struct llist_head *ready = per_cpu_ptr(ep->ready_lists, cpu);
+		struct llist_node *node, *next;
+
+		/* ep_ready_queue() sets the bit again if it refills the list */
+		cpumask_clear_cpu(cpu, ep->ready_cpus);
+		node = llist_reverse_order(llist_del_all(ready));
+		for (; node; node = next) {
+			struct epitem *epi;
+
+			epi = llist_entry(node, struct epitem, ready_node);
+			next = node->next;
+			/* From here on, ep_poll_callback() may queue it again */
+			smp_store_release(&node->next, EP_UNACTIVE_PTR);
+			if (!ep_is_linked(epi)) {
+				list_add_tail(&epi->rdllink, &ep->rdllist);
+				ep_pm_stay_awake(epi);
+			}
+		}
+	}
+}
+
 /*
  * ep->mutex needs to be held because we could be hit by
  * eventpoll_release_file() and epoll_ctl().
@@ -705,53 +788,29 @@ static void ep_start_scan(struct eventpoll *ep, struct list_head *txlist)
 {
 	/*
 	 * Steal the ready list, and re-init the original one to the
-	 * empty list. Also, set ep->ovflist to NULL so that events
-	 * happening while looping w/out locks, are not lost. We cannot
-	 * have the poll callback to queue directly on ep->rdllist,
-	 * because we want the "sproc" callback to be able to do it
-	 * in a lockless way.
+	 * empty list. Events happening while looping w/out locks are
+	 * left on the per-CPU ready lists by the poll callback and picked
+	 * up in ep_done_scan(), so that the "sproc" callback can requeue
+	 * items on ep->rdllist in a lockless way.
 	 */
 	lockdep_assert_irqs_enabled();
-	write_lock_irq(&ep->lock);
+	spin_lock_irq(&ep->lock);
+	ep_ready_drain(ep, false);
 	list_splice_init(&ep->rdllist, txlist);
-	WRITE_ONCE(ep->ovflist, NULL);
-	write_unlock_irq(&ep->lock);
+	spin_unlock_irq(&ep->lock);
 }
 
 static void ep_done_scan(struct eventpoll *ep,
 			 struct list_head *txlist)
 {
-	struct epitem *epi, *nepi;
-
-	write_lock_irq(&ep->lock);
+	spin_lock_irq(&ep->lock);
 	/*
 	 * During the time we spent inside the "sproc" callback, some
 	 * other events might have been queued by the poll callback.
-	 * We re-insert them inside the main ready-list here.
-	 */
-	for (nepi = READ_ONCE(ep->ovflist); (epi = nepi) != NULL;
-	     nepi = epi->next, epi->next = EP_UNACTIVE_PTR) {
-		/*
-		 * We need to check if the item is already in the list.
-		 * During the "sproc" callback execution time, items are
-		 * queued into ->ovflist but the "txlist" might already
-		 * contain them, and the list_splice() below takes care of them.
-		 */
-		if (!ep_is_linked(epi)) {
-			/*
-			 * ->ovflist is LIFO, so we have to reverse it in order
-			 * to keep in FIFO.
-			 */
-			list_add(&epi->rdllink, &ep->rdllist);
-			ep_pm_stay_awake(epi);
-		}
-	}
-	/*
-	 * We need to set back ep->ovflist to EP_UNACTIVE_PTR, so that after
-	 * releasing the lock, events will be queued in the normal way inside
-	 * ep->rdllist.
+	 * We re-insert them inside the main ready-list here; the ones
+	 * still on "txlist" are taken care of by the list_splice() below.
 	 */
-	WRITE_ONCE(ep->ovflist, EP_UNACTIVE_PTR);
+	ep_ready_drain(ep, false);
 
 	/*
 	 * Quickly re-inject items left on "txlist".
@@ -764,7 +823,7 @@ static void ep_done_scan(struct eventpoll *ep,
 			wake_up(&ep->wq);
 	}
 
-	write_unlock_irq(&ep->lock);
+	spin_unlock_irq(&ep->lock);
 }
 
 static void ep_get(struct eventpoll *ep)
@@ -786,6 +845,8 @@ static bool ep_refcount_dec_and_test(struct eventpoll *ep)
 
 static void ep_free(struct eventpoll *ep)
 {
+	free_percpu(ep->ready_lists);
+	free_cpumask_var(ep->ready_cpus);
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
@@ -837,10 +898,16 @@ static bool __ep_remove(struct eventpoll *ep, struct epitem *epi, bool force)
 
 	rb_erase_cached(&epi->rbn, &ep->rbr);
 
-	write_lock_irq(&ep->lock);
+	spin_lock_irq(&ep->lock);
+	/*
+	 * The poll callback can't queue it anymore, but might have before
+	 * we unregistered above.
+	 */
+	if (READ_ONCE(epi->ready_node.next) != EP_UNACTIVE_PTR)
+		ep_ready_drain(ep, true);
 	if (ep_is_linked(epi))
 		list_del_init(&epi->rdllink);
-	write_unlock_irq(&ep->lock);
+	spin_unlock_irq(&ep->lock);
 
 	wakeup_source_unregister(ep_wakeup_source(epi));
 	/*
@@ -1123,12 +1190,11 @@ static int ep_alloc(struct eventpoll **pep)
 		return -ENOMEM;
 
 	mutex_init(&ep->mtx);
-	rwlock_init(&ep->lock);
+	spin_lock_init(&ep->lock);
 	init_waitqueue_head(&ep->wq);
 	init_waitqueue_head(&ep->poll_wait);
 	INIT_LIST_HEAD(&ep->rdllist);
 	ep->rbr = RB_ROOT_CACHED;
-	ep->ovflist = EP_UNACTIVE_PTR;
 	ep->user = get_current_user();
 	refcount_set(&ep->refcount, 1);
 
@@ -1211,80 +1277,59 @@ struct file *get_epoll_tfile_raw_ptr(struct file *file, int tfd,
 #endif /* CONFIG_KCMP */
 
 /*
- * Adds a new entry to the tail of the list in a lockless way, i.e.
- * multiple CPUs are allowed to call this function concurrently.
- *
- * Beware: it is necessary to prevent any other modifications of the
- *         existing list until all changes are completed, in other words
- *         concurrent list_add_tail_lockless() calls should be protected
- *         with a read lock, where write lock acts as a barrier which
- *         makes sure all list_add_tail_lockless() calls are fully
- *         completed.
- *
- *        Also an element can be locklessly added to the list only in one
- *        direction i.e. either to the tail or to the head, otherwise
- *        concurrent access will corrupt the list.
+ * Queues @epi on this CPU's ready list of its eventpoll, in a lockless way,
+ * i.e. multiple CPUs are allowed to call this function concurrently.
  *
- * Return: %false if element has been already added to the list, %true
- * otherwise.
+ * Return: %false if @epi has already been queued, %true otherwise.
  */
-static inline bool list_add_tail_lockless(struct list_head *new,
-					  struct list_head *head)
+static inline bool ep_ready_queue(struct epitem *epi)
 {
-	struct list_head *prev;
+	struct eventpoll *ep = epi->ep;
+	int cpu = raw_smp_processor_id();
 
-	/*
-	 * This is simple 'new->next = head' operation, but cmpxchg()
-	 * is used in order to detect that same element has been just
-	 * added to the list from another CPU: the winner observes
-	 * new->next == new.
-	 */
-	if (!try_cmpxchg(&new->next, &new, head))
+	/* Check that the same epi has not been just queued from another CPU */
+	if (READ_ONCE(epi->ready_node.next) != EP_UNACTIVE_PTR ||
+	    cmpxchg(&epi->ready_node.next, EP_UNACTIVE_PTR, NULL) !=
+	    EP_UNACTIVE_PTR)
 		return false;
 
 	/*
-	 * Initially ->next of a new element must be updated with the head
-	 * (we are inserting to the tail) and only then pointers are atomically
-	 * exchanged.  XCHG guarantees memory ordering, thus ->next should be
-	 * updated before pointers are actually swapped and pointers are
-	 * swapped before prev->next is updated.
+	 * Only the first item on an empty list needs to tell the consumers.
+	 * Set the CPU bit before testing ->ready_pending, ep_ready_drain()
+	 * clears ->ready_pending before it reads the mask.
 	 */
-
-	prev = xchg(&head->prev, new);
-
-	/*
-	 * It is safe to modify prev->next and new->prev, because a new element
-	 * is added only to the tail and new->next is updated before XCHG.
-	 */
-
-	prev->next = new;
-	new->prev = prev;
+	if (llist_add(&epi->ready_node, per_cpu_ptr(ep->ready_lists, cpu))) {
+		cpumask_set_cpu(cpu, ep->ready_cpus);
+		smp_mb__after_atomic();
+		if (!READ_ONCE(ep->ready_pending))
+			WRITE_ONCE(ep->ready_pending, true);
+	}
 
 	return true;
 }
 
 /*
- * Chains a new epi entry to the tail of the ep->ovflist in a lockless way,
- * i.e. multiple CPUs are allowed to call this function concurrently.
- *
- * Return: %false if epi element has been already chained, %true otherwise.
+ * The per-CPU ready lists are only needed once something is watched, so
+ * don't pay for them on every epoll_create().
  */
-static inline bool chain_epi_lockless(struct epitem *epi)
+static int ep_alloc_ready_lists(struct eventpoll *ep)
 {
-	struct eventpoll *ep = epi->ep;
-
-	/* Fast preliminary check */
-	if (epi->next != EP_UNACTIVE_PTR)
-		return false;
-
-	/* Check that the same epi has not been just chained from another CPU */
-	if (cmpxchg(&epi->next, EP_UNACTIVE_PTR, NULL) != EP_UNACTIVE_PTR)
-		return false;
+	struct llist_head __percpu *ready_lists;
 
-	/* Atomically exchange tail */
-	epi->next = xchg(&ep->ovflist, epi);
+	lockdep_assert_held(&ep->mtx);
 
-	return true;
+	if (ep->ready_lists)
+		return 0;
+	if (!zalloc_cpumask_var(&ep->ready_cpus, GFP_KERNEL))
+		return -ENOMEM;
+	ready_lists = alloc_percpu(struct llist_head);
+	if (!ready_lists) {
+		free_cpumask_var(ep->ready_cpus);
+		return -ENOMEM;
+	}
+	/* Nothing polls @ep before the item that needs the lists is hooked */
+	ep->ready_lists = ready_lists;
+	return 0;
 }
 
 /*
@@ -1292,11 +1337,11 @@ static inline bool chain_epi_lockless(struct epitem *epi)
  * mechanism. It is called by the stored file descriptors when they
  * have events to report.
  *
- * This callback takes a read lock in order not to contend with concurrent
- * events from another file descriptor, thus all modifications to ->rdllist
- * or ->ovflist are lockless.  Read lock is paired with the write lock from
- * ep_start/done_scan(), which stops all list modifications and guarantees
- * that lists state is seen correctly.
+ * This callback takes no lock in order not to contend with concurrent
+ * events from other file descriptors or CPUs: items are queued on a per-CPU
+ * ready list, which ep_ready_drain() moves to ->rdllist under ep->lock.
+ * The waiter side in ep_poll() adds itself to ep->wq before checking for
+ * events, and wq_has_sleeper() below orders the queueing against that.
  *
  * Another thing worth to mention is that ep_poll_callback() can be called
  * concurrently for the same @epi from different CPUs if poll table was inited
@@ -1311,11 +1356,8 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	struct epitem *epi = ep_item_from_wait(wait);
 	struct eventpoll *ep = epi->ep;
 	__poll_t pollflags = key_to_poll(key);
-	unsigned long flags;
 	int ewake = 0;
 
-	read_lock_irqsave(&ep->lock, flags);
-
 	ep_set_busy_poll_napi_id(epi);
 
 	/*
@@ -1325,7 +1367,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * until the next EPOLL_CTL_MOD will be issued.
 	 */
 	if (!(epi->event.events & ~EP_PRIVATE_BITS))
-		goto out_unlock;
+		goto out;
 
 	/*
 	 * Check the events coming with the callback. At this stage, not
@@ -1334,28 +1376,21 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * test for "key" != NULL before the event match test.
 	 */
 	if (pollflags && !(pollflags & epi->event.events))
-		goto out_unlock;
+		goto out;
 
 	/*
-	 * If we are transferring events to userspace, we can hold no locks
-	 * (because we're accessing user memory, and because of linux f_op->poll()
-	 * semantics). All the events that happen during that period of time are
-	 * chained in ep->ovflist and requeued later on.
+	 * Items are always queued on the per-CPU list, even if they are on
+	 * ->rdllist already: a scan in progress may be about to drop them
+	 * from its "txlist" after having found them not ready.
 	 */
-	if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
-		if (chain_epi_lockless(epi))
-			ep_pm_stay_awake_rcu(epi);
-	} else if (!ep_is_linked(epi)) {
-		/* In the usual case, add event to ready list. */
-		if (list_add_tail_lockless(&epi->rdllink, &ep->rdllist))
-			ep_pm_stay_awake_rcu(epi);
-	}
+	if (ep_ready_queue(epi))
+		ep_pm_stay_awake_rcu(epi);
 
 	/*
 	 * Wake up ( if active ) both the eventpoll wait list and the ->poll()
 	 * wait list.
 	 */
-	if (waitqueue_active(&ep->wq)) {
+	if (wq_has_sleeper(&ep->wq)) {
 		if ((epi->event.events & EPOLLEXCLUSIVE) &&
 					!(pollflags & POLLFREE)) {
 			switch (pollflags & EPOLLINOUT_BITS) {
@@ -1377,10 +1412,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	if (waitqueue_active(&ep->poll_wait))
 		pwake++;
 
-out_unlock:
-	read_unlock_irqrestore(&ep->lock, flags);
-
-	/* We have to call this outside the lock */
+out:
 	if (pwake)
 		ep_poll_safewake(ep, epi, pollflags & EPOLL_URING_WAKE);
 
@@ -1632,6 +1664,9 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	if (unlikely(percpu_counter_compare(&ep->user->epoll_watches,
 					    max_user_watches) >= 0))
 		return -ENOSPC;
+	error = ep_alloc_ready_lists(ep);
+	if (error)
+		return error;
 	percpu_counter_inc(&ep->user->epoll_watches);
 
 	if (!(epi = kmem_cache_zalloc(epi_cache, GFP_KERNEL))) {
@@ -1644,7 +1679,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	epi->ep = ep;
 	ep_set_ffd(&epi->ffd, tfile, fd);
 	epi->event = *event;
-	epi->next = EP_UNACTIVE_PTR;
+	epi->ready_node.next = EP_UNACTIVE_PTR;
 
 	if (tep)
 		mutex_lock_nested(&tep->mtx, 1);
@@ -1712,7 +1747,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	}
 
 	/* We have to drop the new item inside our item list to keep track of it */
-	write_lock_irq(&ep->lock);
+	spin_lock_irq(&ep->lock);
 
 	/* record NAPI ID of new item if present */
 	ep_set_busy_poll_napi_id(epi);
@@ -1729,7 +1764,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 			pwake++;
 	}
 
-	write_unlock_irq(&ep->lock);
+	spin_unlock_irq(&ep->lock);
 
 	/* We have to call this outside the lock */
 	if (pwake)
@@ -1772,9 +1807,8 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 	 * 1) Flush epi changes above to other CPUs.  This ensures
 	 *    we do not miss events from ep_poll_callback if an
 	 *    event occurs immediately after we call f_op->poll().
-	 *    We need this because we did not take ep->lock while
-	 *    changing epi above (but ep_poll_callback does take
-	 *    ep->lock).
+	 *    We need this because neither we nor ep_poll_callback
+	 *    take ep->lock while accessing epi.
 	 *
 	 * 2) We also need to ensure we do not miss _past_ events
 	 *    when calling f_op->poll().  This barrier also
@@ -1793,7 +1827,7 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 	 * list, push it inside.
 	 */
 	if (ep_item_poll(epi, &pt, 1)) {
-		write_lock_irq(&ep->lock);
+		spin_lock_irq(&ep->lock);
 		if (!ep_is_linked(epi)) {
 			list_add_tail(&epi->rdllink, &ep->rdllist);
 			ep_pm_stay_awake(epi);
@@ -1804,7 +1838,7 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 			if (waitqueue_active(&ep->poll_wait))
 				pwake++;
 		}
-		write_unlock_irq(&ep->lock);
+		spin_unlock_irq(&ep->lock);
 	}
 
 	/* We have to call this outside the lock */
@@ -1894,7 +1928,8 @@ static int ep_send_events(struct eventpoll *ep,
 			 * into ep->rdllist besides us. The epoll_ctl()
 			 * callers are locked out by
 			 * ep_send_events() holding "mtx" and the
-			 * poll callback will queue them in ep->ovflist.
+			 * poll callback queues them on the per-CPU
+			 * ready lists.
 			 */
 			list_add_tail(&epi->rdllink, &ep->rdllist);
 			ep_pm_stay_awake(epi);
@@ -2003,8 +2038,11 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			 * trying again in search of more luck.
 			 */
 			res = ep_send_events(ep, events, maxevents);
-			if (res)
+			if (res) {
+				if (res > 0)
+					ep_suspend_napi_irqs(ep);
 				return res;
+			}
 		}
 
 		if (timed_out)
@@ -2025,7 +2063,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 * chance to harvest new event. Otherwise wakeup can be
 		 * lost. This is also good performance-wise, because on
 		 * normal wakeup path no need to call __remove_wait_queue()
-		 * explicitly, thus ep->lock is not taken, which halts the
+		 * explicitly, thus ep->wq.lock is not taken, which halts the
 		 * event delivery.
 		 *
 		 * In fact, we now use an even more aggressive function that
@@ -2037,26 +2075,29 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		init_wait(&wait);
 		wait.func = ep_autoremove_wake_function;
 
-		write_lock_irq(&ep->lock);
-		/*
-		 * Barrierless variant, waitqueue_active() is called under
-		 * the same lock on wakeup ep_poll_callback() side, so it
-		 * is safe to avoid an explicit barrier.
-		 */
+		spin_lock_irq(&ep->lock);
 		__set_current_state(TASK_INTERRUPTIBLE);
 
 		/*
-		 * Do the final check under the lock. ep_start/done_scan()
-		 * plays with two lists (->rdllist and ->ovflist) and there
-		 * is always a race when both lists are empty for short
-		 * period of time although events are pending, so lock is
-		 * important.
+		 * ep_poll_callback() takes no lock, so get on the wait queue
+		 * first and only then do the final check: either it sees us
+		 * in wq_has_sleeper(), or we see its item here.  ep->lock
+		 * keeps ep_start/done_scan() from emptying the lists under
+		 * us meanwhile.
 		 */
+		spin_lock(&ep->wq.lock);
+		__add_wait_queue_exclusive(&ep->wq, &wait);
+		spin_unlock(&ep->wq.lock);
+		smp_mb();
+
 		eavail = ep_events_available(ep);
-		if (!eavail)
-			__add_wait_queue_exclusive(&ep->wq, &wait);
+		if (eavail) {
+			spin_lock(&ep->wq.lock);
+			__remove_wait_queue(&ep->wq, &wait);
+			spin_unlock(&ep->wq.lock);
+		}
 
-		write_unlock_irq(&ep->lock);
+		spin_unlock_irq(&ep->lock);
 
 		if (!eavail)
 			timed_out = !schedule_hrtimeout_range(to, slack,
@@ -2071,7 +2112,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		eavail = 1;
 
 		if (!list_empty_careful(&wait.entry)) {
-			write_lock_irq(&ep->lock);
+			spin_lock_irq(&ep->wq.lock);
 			/*
 			 * If the thread timed out and is not on the wait queue,
 			 * it means that the thread was woken up after its
@@ -2082,7 +2123,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			if (timed_out)
 				eavail = list_empty(&wait.entry);
 			__remove_wait_queue(&ep->wq, &wait);
-			write_unlock_irq(&ep->lock);
+			spin_unlock_irq(&ep->wq.lock);
 		}
 	}
 }
@@ -2422,6 +2463,33 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 	return do_epoll_ctl(epfd, op, fd, &epds, false);
 }
 
+/*
+ * Non-blocking harvest of ready events for in-kernel users, like io_uring,
+ * that do their own waiting by polling the eventpoll file. Returns the number
+ * of events copied to @events, 0 if none were ready, or a negative error.
+ */
+int epoll_sendevents(struct file *file, struct epoll_event __user *events,
+		     int maxevents)
+{
+	struct eventpoll *ep;
+
+	if (!is_file_epoll(file))
+		return -EINVAL;
+	if (maxevents <= 0 || maxevents > EP_MAX_EVENTS)
+		return -EINVAL;
+	if (!access_ok(events, maxevents * sizeof(struct epoll_event)))
+		return -EFAULT;
+
+	ep = file->private_data;
+	/*
+	 * Racy call, but that's ok - it should get retried based on
+	 * poll readiness anyway.
+	 */
+	if (!ep_events_available(ep))
+		return 0;
+	return ep_send_events(ep, events, maxevents);
+}
+
 /*
  * Implement the event wait interface for the eventpoll file. It is the kernel
  * part of the user space epoll_wait(2).
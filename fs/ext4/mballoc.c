@@ -2130,13 +2130,27 @@ static int mb_mark_used(struct ext4_buddy *e4b, struct ext4_free_extent *ex)
 	return ret;
 }
 
+/*
+ * Stream allocations used to share a single global goal, which made every
+ * large writer on the filesystem chase the same group (and its lock).
+ * Instead each inode hashes to one of several goals, which start out spread
+ * over the flex groups, so parallel streams land in different places.
+ */
+static inline ext4_group_t *
+ext4_mb_stream_goal(struct ext4_allocation_context *ac)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
+
+	return &sbi->s_mb_last_groups[ac->ac_inode->i_ino %
+				      sbi->s_mb_nr_global_goals];
+}
+
 /*
  * Must be called under group lock!
  */
 static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 					struct ext4_buddy *e4b)
 {
-	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
 	int ret;
 
 	BUG_ON(ac->ac_b_ex.fe_group != e4b->bd_group);
@@ -2166,12 +2180,8 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	ac->ac_buddy_folio = e4b->bd_buddy_folio;
 	folio_get(ac->ac_buddy_folio);
 	/* store last allocated for subsequent stream allocation */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		WRITE_ONCE(*ext4_mb_stream_goal(ac), ac->ac_f_ex.fe_group);
 	/*
 	 * As we've just preallocated more space than
 	 * user requested originally, we store allocated
@@ -2793,6 +2803,39 @@ void ext4_mb_prefetch_fini(struct super_block *sb, ext4_group_t group,
 	}
 }
 
+/*
+ * Lock @group for scanning.  At the cheap criteria a group whose lock is
+ * held is skipped rather than waited for: another allocator is busy in it,
+ * other suitable groups are likely to exist, and queueing up behind it is
+ * what serializes parallel writers.  The expensive criteria still wait, so
+ * a contended group is never missed when space is tight.
+ */
+static bool ext4_mb_lock_group_for_scan(struct ext4_allocation_context *ac,
+					ext4_group_t group, enum criteria cr)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	spinlock_t *lock = ext4_group_lock_ptr(sb, group);
+
+	if (spin_trylock(lock)) {
+		atomic_add_unless(&sbi->s_lock_busy, -1, 0);
+		return true;
+	}
+
+	/* Contended, whether we skip the group or wait for it */
+	atomic_add_unless(&sbi->s_lock_busy, 1, EXT4_MAX_CONTENTION);
+	if (sbi->s_mb_stats)
+		atomic_inc(&sbi->s_bal_lock_busy);
+	if (!ext4_mb_cr_expensive(cr)) {
+		if (sbi->s_mb_stats)
+			atomic_inc(&sbi->s_bal_lock_skipped);
+		return false;
+	}
+
+	spin_lock(lock);
+	return true;
+}
+
 static noinline_for_stack int
 ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 {
@@ -2842,14 +2885,9 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 							   MB_NUM_ORDERS(sb));
 	}
 
-	/* if stream allocation is enabled, use global goal */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	/* if stream allocation is enabled, use the stream's global goal */
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		ac->ac_g_ex.fe_group = READ_ONCE(*ext4_mb_stream_goal(ac));
 
 	/*
 	 * Let's just scan groups to find more-less suitable blocks We
@@ -2911,7 +2949,10 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
+			if (!ext4_mb_lock_group_for_scan(ac, group, cr)) {
+				ext4_mb_unload_buddy(&e4b);
+				continue;
+			}
 
 			/*
 			 * We need to check again after locking the
@@ -3187,6 +3228,10 @@ int ext4_seq_mb_stats_show(struct seq_file *seq, void *offset)
 	seq_printf(seq, "\t\t2^n_hits: %u\n", atomic_read(&sbi->s_bal_2orders));
 	seq_printf(seq, "\t\tbreaks: %u\n", atomic_read(&sbi->s_bal_breaks));
 	seq_printf(seq, "\t\tlost: %u\n", atomic_read(&sbi->s_mb_lost_chunks));
+	seq_printf(seq, "\t\tgroup_lock_busy: %u\n",
+		   atomic_read(&sbi->s_bal_lock_busy));
+	seq_printf(seq, "\t\tgroup_lock_skipped: %u\n",
+		   atomic_read(&sbi->s_bal_lock_skipped));
 	seq_printf(seq, "\tbuddies_generated: %u/%u\n",
 		   atomic_read(&sbi->s_mb_buddies_generated),
 		   ext4_get_groups_count(sb));
@@ -3593,6 +3638,8 @@ int ext4_mb_init(struct super_block *sb)
 	unsigned i, j;
 	unsigned offset, offset_incr;
 	unsigned max;
+	ext4_group_t ngroups, nr_flex;
+	unsigned int log_flex;
 	int ret;
 
 	i = MB_NUM_ORDERS(sb) * sizeof(*sbi->s_mb_offsets);
@@ -3710,6 +3757,31 @@ int ext4_mb_init(struct super_block *sb)
 			sbi->s_mb_group_prealloc, EXT4_B2C(sbi, sbi->s_stripe));
 	}
 
+	/*
+	 * One stream goal per CPU, but no more than there are flex groups to
+	 * spread them over.  The flex group info is not set up yet, so look
+	 * at the superblock directly.
+	 */
+	log_flex = 0;
+	if (ext4_has_feature_flex_bg(sb) &&
+	    sbi->s_es->s_log_groups_per_flex >= 1 &&
+	    sbi->s_es->s_log_groups_per_flex <= 31)
+		log_flex = sbi->s_es->s_log_groups_per_flex;
+	ngroups = ext4_get_groups_count(sb);
+	nr_flex = max_t(ext4_group_t, ngroups >> log_flex, 1);
+	sbi->s_mb_nr_global_goals = min_t(unsigned int, nr_flex,
+					  num_possible_cpus());
+	sbi->s_mb_last_groups = kcalloc(sbi->s_mb_nr_global_goals,
+					sizeof(ext4_group_t), GFP_KERNEL);
+	if (!sbi->s_mb_last_groups) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < sbi->s_mb_nr_global_goals; i++)
+		sbi->s_mb_last_groups[i] =
+			div_u64((u64)nr_flex * i,
+				sbi->s_mb_nr_global_goals) << log_flex;
+
 	sbi->s_locality_groups = alloc_percpu(struct ext4_locality_group);
 	if (sbi->s_locality_groups == NULL) {
 		ret = -ENOMEM;
@@ -3739,6 +3811,8 @@ int ext4_mb_init(struct super_block *sb)
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
 out:
+	kfree(sbi->s_mb_last_groups);
+	sbi->s_mb_last_groups = NULL;
 	kfree(sbi->s_mb_avg_fragment_size);
 	kfree(sbi->s_mb_avg_fragment_size_locks);
 	kfree(sbi->s_mb_largest_free_orders);
@@ -3809,6 +3883,7 @@ void ext4_mb_release(struct super_block *sb)
 		kvfree(group_info);
 		rcu_read_unlock();
 	}
+	kfree(sbi->s_mb_last_groups);
 	kfree(sbi->s_mb_avg_fragment_size);
 	kfree(sbi->s_mb_avg_fragment_size_locks);
 	kfree(sbi->s_mb_largest_free_orders);
@@ -25,9 +25,6 @@
 
 static struct kmem_cache *victim_entry_slab;
 
-static unsigned int count_bits(const unsigned long *addr,
-				unsigned int offset, unsigned int len);
-
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -262,8 +259,8 @@ static void select_policy(struct f2fs_sb_info *sbi, int gc_type,
 		p->ofs_unit = SEGS_PER_SEC(sbi);
 		if (__is_large_section(sbi)) {
 			p->dirty_bitmap = dirty_i->dirty_secmap;
-			p->max_search = count_bits(p->dirty_bitmap,
-						0, MAIN_SECS(sbi));
+			p->max_search = bitmap_weight(p->dirty_bitmap,
+						MAIN_SECS(sbi));
 		} else {
 			p->dirty_bitmap = dirty_i->dirty_segmap[DIRTY];
 			p->max_search = dirty_i->nr_dirty[DIRTY];
@@ -378,16 +375,27 @@ static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 	return 0;
 }
 
-static unsigned int count_bits(const unsigned long *addr,
-				unsigned int offset, unsigned int len)
+/*
+ * Check whether dirty bitmap word @word may hold a better greedy victim than
+ * the one found so far.  If its lower bound doesn't rule that out, refresh
+ * the bound from the actual valid block counts of the word's dirty units.
+ */
+static bool victim_word_may_win(struct f2fs_sb_info *sbi,
+			struct victim_sel_policy *p, unsigned int word)
 {
-	unsigned int end = offset + len, sum = 0;
+	unsigned int *lb = &DIRTY_I(sbi)->victim_lb[word];
+	unsigned long bits = p->dirty_bitmap[word];
+	unsigned int bit, min = UINT_MAX;
 
-	while (offset < end) {
-		if (test_bit(offset++, addr))
-			++sum;
-	}
-	return sum;
+	if (READ_ONCE(*lb) >= p->min_cost)
+		return false;
+
+	for_each_set_bit(bit, &bits, BITS_PER_LONG)
+		min = min(min, get_valid_blocks(sbi,
+				(word * BITS_PER_LONG + bit) * p->ofs_unit,
+				true));
+	WRITE_ONCE(*lb, min);
+	return min < p->min_cost;
 }
 
 static bool f2fs_check_victim_tree(struct f2fs_sb_info *sbi,
@@ -750,7 +758,8 @@ int f2fs_get_victim(struct f2fs_sb_info *sbi, unsigned int *result,
 	unsigned int secno, last_victim;
 	unsigned int last_segment;
 	unsigned int nsearched;
-	bool is_atgc;
+	unsigned int cur_word;
+	bool is_atgc, use_bound;
 	int ret = 0;
 
 	mutex_lock(&dirty_i->seglist_lock);
@@ -769,6 +778,15 @@ int f2fs_get_victim(struct f2fs_sb_info *sbi, unsigned int *result,
 	is_atgc = (p.gc_mode == GC_AT || p.alloc_mode == AT_SSR);
 	nsearched = 0;
 
+	/*
+	 * Exhaustive greedy scans (foreground and urgent GC) can skip whole
+	 * dirty bitmap words using the valid block lower bounds.  Capped scans
+	 * depend on visiting each candidate to advance last_victim.
+	 */
+	use_bound = p.alloc_mode == LFS && p.gc_mode == GC_GREEDY &&
+		(gc_type == FG_GC || sbi->gc_mode == GC_URGENT_HIGH);
+	cur_word = UINT_MAX;
+
 	if (is_atgc)
 		SIT_I(sbi)->dirty_min_mtime = ULLONG_MAX;
 
@@ -832,6 +850,15 @@ int f2fs_get_victim(struct f2fs_sb_info *sbi, unsigned int *result,
 			break;
 		}
 
+		if (use_bound && unit_no / BITS_PER_LONG != cur_word) {
+			cur_word = unit_no / BITS_PER_LONG;
+			if (!victim_word_may_win(sbi, &p, cur_word)) {
+				p.offset = (cur_word + 1) * BITS_PER_LONG *
+					   p.ofs_unit;
+				continue;
+			}
+		}
+
 		p.offset = segno + p.ofs_unit;
 		nsearched++;
 
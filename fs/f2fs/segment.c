@@ -766,6 +766,8 @@ static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		if (!test_and_set_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]++;
 
+		f2fs_lower_victim_bound(sbi, segno);
+
 		if (__is_large_section(sbi)) {
 			unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
 			block_t valid_blocks =
@@ -2509,6 +2511,8 @@ static void update_sit_entry(struct f2fs_sb_info *sbi, block_t blkaddr, int del)
 
 	if (__is_large_section(sbi))
 		get_sec_entry(sbi, segno)->valid_blocks += del;
+	if (del < 0)
+		f2fs_lower_victim_bound(sbi, segno);
 }
 
 void f2fs_invalidate_blocks(struct f2fs_sb_info *sbi, block_t addr)
@@ -4979,6 +4983,14 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 			return -ENOMEM;
 	}
 
+	dirty_i->victim_lb = f2fs_kvzalloc(sbi,
+			array_size(BITS_TO_LONGS(__is_large_section(sbi) ?
+						 MAIN_SECS(sbi) :
+						 MAIN_SEGS(sbi)),
+				   sizeof(unsigned int)), GFP_KERNEL);
+	if (!dirty_i->victim_lb)
+		return -ENOMEM;
+
 	init_dirty_segmap(sbi);
 	return init_victim_secmap(sbi);
 }
@@ -5498,6 +5510,7 @@ static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 	}
 
 	destroy_victim_secmap(sbi);
+	kvfree(dirty_i->victim_lb);
 	SM_I(sbi)->dirty_info = NULL;
 	kfree(dirty_i);
 }
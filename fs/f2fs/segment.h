@@ -284,6 +284,7 @@ struct dirty_seglist_info {
 	unsigned long *pinned_secmap;		/* pinned victims from foreground GC */
 	unsigned int pinned_secmap_cnt;		/* count of victims which has pinned data */
 	bool enable_pin_section;		/* enable pinning section */
+	unsigned int *victim_lb;		/* valid blocks lower bound per dirty map word */
 };
 
 /* for active log information */
@@ -343,6 +344,27 @@ static inline unsigned int get_valid_blocks(struct f2fs_sb_info *sbi,
 		return get_seg_entry(sbi, segno)->valid_blocks;
 }
 
+/*
+ * Greedy victim selection keeps, for every word of the dirty bitmap it scans
+ * (dirty_secmap for large sections, the DIRTY segmap otherwise), a lower bound
+ * of the valid blocks in the GC units that word covers.  Outside of victim
+ * selection the bound is only ever lowered, when a unit loses valid blocks or
+ * becomes dirty, so whole words that can't beat the best candidate found so
+ * far are skipped without looking at their entries.
+ */
+static inline void f2fs_lower_victim_bound(struct f2fs_sb_info *sbi,
+						unsigned int segno)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int unit = __is_large_section(sbi) ?
+				GET_SEC_FROM_SEG(sbi, segno) : segno;
+	unsigned int *lb = &dirty_i->victim_lb[unit / BITS_PER_LONG];
+	unsigned int valid = get_valid_blocks(sbi, segno, true);
+
+	if (valid < READ_ONCE(*lb))
+		WRITE_ONCE(*lb, valid);
+}
+
 static inline unsigned int get_ckpt_valid_blocks(struct f2fs_sb_info *sbi,
 				unsigned int segno, bool use_section)
 {
@@ -87,6 +87,36 @@ static void copy_fdtable(struct fdtable *nfdt, struct fdtable *ofdt)
 	copy_fd_bitmaps(nfdt, ofdt, ofdt->max_fds);
 }
 
+/*
+ * Tables with an fd array of at least this many entries are copied without
+ * holding the files spinlock on expansion, see fdt_mark_dirty().
+ */
+#define FDTABLE_UNLOCKED_COPY	(SZ_1M / sizeof(struct file *))
+
+/*
+ * Copy the words of fd bits, and the matching file pointers, that changed
+ * while copy_fdtable() ran without the files spinlock.  Called with the
+ * files spinlock held.
+ */
+static void copy_fdtable_dirty(struct fdtable *nfdt, struct fdtable *ofdt,
+			       unsigned long *dirty)
+{
+	unsigned int i;
+
+	for_each_set_bit(i, dirty, ofdt->max_fds / BITS_PER_LONG) {
+		unsigned int fd = i * BITS_PER_LONG;
+
+		memcpy(&nfdt->fd[fd], &ofdt->fd[fd],
+		       BITS_PER_LONG * sizeof(struct file *));
+		nfdt->open_fds[i] = ofdt->open_fds[i];
+		nfdt->close_on_exec[i] = ofdt->close_on_exec[i];
+		if (!~nfdt->open_fds[i])
+			__set_bit(i, nfdt->full_fds_bits);
+		else
+			__clear_bit(i, nfdt->full_fds_bits);
+	}
+}
+
 /*
  * Note how the fdtable bitmap allocations very much have to be a multiple of
  * BITS_PER_LONG. This is not only because we walk those things in chunks of
@@ -133,6 +163,7 @@ static struct fdtable * alloc_fdtable(unsigned int nr)
 	if (!fdt)
 		goto out;
 	fdt->max_fds = nr;
+	fdt->resize_dirty = NULL;
 	data = kvmalloc_array(nr, sizeof(struct file *), GFP_KERNEL_ACCOUNT);
 	if (!data)
 		goto out_fdt;
@@ -171,9 +202,14 @@ static int expand_fdtable(struct files_struct *files, unsigned int nr)
 	__acquires(files->file_lock)
 {
 	struct fdtable *new_fdt, *cur_fdt;
+	unsigned long *dirty = NULL;
 
 	spin_unlock(&files->file_lock);
 	new_fdt = alloc_fdtable(nr);
+	/* nr is at least the current max_fds, see below */
+	if (new_fdt && nr >= FDTABLE_UNLOCKED_COPY)
+		dirty = bitmap_zalloc(nr / BITS_PER_LONG + 1,
+				      GFP_KERNEL_ACCOUNT);
 
 	/* make sure all fd_install() have seen resize_in_progress
 	 * or have finished their rcu_read_lock_sched() section.
@@ -190,11 +226,29 @@ static int expand_fdtable(struct files_struct *files, unsigned int nr)
 	 */
 	if (unlikely(new_fdt->max_fds <= nr)) {
 		__free_fdtable(new_fdt);
+		bitmap_free(dirty);
 		return -EMFILE;
 	}
 	cur_fdt = files_fdtable(files);
 	BUG_ON(nr < cur_fdt->max_fds);
-	copy_fdtable(new_fdt, cur_fdt);
+	if (dirty) {
+		/*
+		 * Copying a few megabytes under the spinlock would stall
+		 * every open and close in the meantime.  With
+		 * resize_in_progress set nobody touches the table without
+		 * the lock (see fd_install()), so copy it unlocked and have
+		 * those that change it meanwhile record what they changed.
+		 */
+		cur_fdt->resize_dirty = dirty;
+		spin_unlock(&files->file_lock);
+		copy_fdtable(new_fdt, cur_fdt);
+		spin_lock(&files->file_lock);
+		cur_fdt->resize_dirty = NULL;
+		copy_fdtable_dirty(new_fdt, cur_fdt, dirty);
+		bitmap_free(dirty);
+	} else {
+		copy_fdtable(new_fdt, cur_fdt);
+	}
 	rcu_assign_pointer(files->fdt, new_fdt);
 	if (cur_fdt != &files->fdtab)
 		call_rcu(&cur_fdt->rcu, free_fdtable_rcu);
@@ -246,19 +300,34 @@ static int expand_files(struct files_struct *files, unsigned int nr)
 	return expanded;
 }
 
+/*
+ * Record a change to the table while expand_fdtable() copies it without
+ * the files spinlock: one bit per word of fd bits.  Called with the files
+ * spinlock held.
+ */
+static inline void fdt_mark_dirty(struct fdtable *fdt, unsigned int fd)
+{
+	if (unlikely(fdt->resize_dirty))
+		__set_bit(fd / BITS_PER_LONG, fdt->resize_dirty);
+}
+
 static inline void __set_close_on_exec(unsigned int fd, struct fdtable *fdt)
 {
+	fdt_mark_dirty(fdt, fd);
 	__set_bit(fd, fdt->close_on_exec);
 }
 
 static inline void __clear_close_on_exec(unsigned int fd, struct fdtable *fdt)
 {
-	if (test_bit(fd, fdt->close_on_exec))
+	if (test_bit(fd, fdt->close_on_exec)) {
+		fdt_mark_dirty(fdt, fd);
 		__clear_bit(fd, fdt->close_on_exec);
+	}
 }
 
 static inline void __set_open_fd(unsigned int fd, struct fdtable *fdt)
 {
+	fdt_mark_dirty(fdt, fd);
 	__set_bit(fd, fdt->open_fds);
 	fd /= BITS_PER_LONG;
 	if (!~fdt->open_fds[fd])
@@ -267,6 +336,7 @@ static inline void __set_open_fd(unsigned int fd, struct fdtable *fdt)
 
 static inline void __clear_open_fd(unsigned int fd, struct fdtable *fdt)
 {
+	fdt_mark_dirty(fdt, fd);
 	__clear_bit(fd, fdt->open_fds);
 	__clear_bit(fd / BITS_PER_LONG, fdt->full_fds_bits);
 }
@@ -338,6 +408,7 @@ struct files_struct *dup_fd(struct files_struct *oldf, unsigned int max_fds, int
 	newf->next_fd = 0;
 	new_fdt = &newf->fdtab;
 	new_fdt->max_fds = NR_OPEN_DEFAULT;
+	new_fdt->resize_dirty = NULL;
 	new_fdt->close_on_exec = newf->close_on_exec_init;
 	new_fdt->open_fds = newf->open_fds_init;
 	new_fdt->full_fds_bits = newf->full_fds_bits_init;
@@ -489,6 +560,16 @@ static unsigned int find_next_fd(struct fdtable *fdt, unsigned int start)
 	unsigned int maxfd = fdt->max_fds; /* always multiple of BITS_PER_LONG */
 	unsigned int maxbit = maxfd / BITS_PER_LONG;
 	unsigned int bitbit = start / BITS_PER_LONG;
+	unsigned int bit;
+
+	/*
+	 * Try the word we start in first, with lots of descriptors the
+	 * second level bitmap is another cache miss under the spinlock.
+	 */
+	bit = find_next_zero_bit(&fdt->open_fds[bitbit], BITS_PER_LONG,
+				 start & (BITS_PER_LONG - 1));
+	if (bit < BITS_PER_LONG)
+		return bit + bitbit * BITS_PER_LONG;
 
 	bitbit = find_next_zero_bit(fdt->full_fds_bits, maxbit, bitbit) * BITS_PER_LONG;
 	if (bitbit >= maxfd)
@@ -515,7 +596,7 @@ static int alloc_fd(unsigned start, unsigned end, unsigned flags)
 	if (fd < files->next_fd)
 		fd = files->next_fd;
 
-	if (fd < fdt->max_fds)
+	if (likely(fd < fdt->max_fds))
 		fd = find_next_fd(fdt, fd);
 
 	/*
@@ -523,19 +604,21 @@ static int alloc_fd(unsigned start, unsigned end, unsigned flags)
 	 * will limit the total number of files that can be opened.
 	 */
 	error = -EMFILE;
-	if (fd >= end)
+	if (unlikely(fd >= end))
 		goto out;
 
-	error = expand_files(files, fd);
-	if (error < 0)
-		goto out;
+	if (unlikely(fd >= fdt->max_fds)) {
+		error = expand_files(files, fd);
+		if (error < 0)
+			goto out;
 
-	/*
-	 * If we needed to expand the fs array we
-	 * might have blocked - try again.
-	 */
-	if (error)
-		goto repeat;
+		/*
+		 * If we needed to expand the fs array we
+		 * might have blocked - try again.
+		 */
+		if (error)
+			goto repeat;
+	}
 
 	if (start <= files->next_fd)
 		files->next_fd = fd + 1;
@@ -619,6 +702,7 @@ void fd_install(unsigned int fd, struct file *file)
 		spin_lock(&files->file_lock);
 		fdt = files_fdtable(files);
 		BUG_ON(fdt->fd[fd] != NULL);
+		fdt_mark_dirty(fdt, fd);
 		rcu_assign_pointer(fdt->fd[fd], file);
 		spin_unlock(&files->file_lock);
 		return;
@@ -700,8 +784,12 @@ static inline void __range_cloexec(struct files_struct *cur_fds,
 	spin_lock(&cur_fds->file_lock);
 	fdt = files_fdtable(cur_fds);
 	max_fd = min(last_fd(fdt), max_fd);
-	if (fd <= max_fd)
+	if (fd <= max_fd) {
+		if (unlikely(fdt->resize_dirty))
+			bitmap_set(fdt->resize_dirty, fd / BITS_PER_LONG,
+				   max_fd / BITS_PER_LONG - fd / BITS_PER_LONG + 1);
 		bitmap_set(fdt->close_on_exec, fd, max_fd - fd + 1);
+	}
 	spin_unlock(&cur_fds->file_lock);
 }
 
@@ -840,6 +928,7 @@ void do_close_on_exec(struct files_struct *files)
 		set = fdt->close_on_exec[i];
 		if (!set)
 			continue;
+		fdt_mark_dirty(fdt, fd);
 		fdt->close_on_exec[i] = 0;
 		for ( ; set ; fd++, set >>= 1) {
 			struct file *file;
@@ -952,7 +1041,7 @@ struct file *get_file_active(struct file **f)
 EXPORT_SYMBOL_GPL(get_file_active);
 
 static inline struct file *__fget_files_rcu(struct files_struct *files,
-       unsigned int fd, fmode_t mask)
+       unsigned int fd, fmode_t mask, unsigned int refs)
 {
 	for (;;) {
 		struct file *file;
@@ -983,11 +1072,11 @@ static inline struct file *__fget_files_rcu(struct files_struct *files,
 		 * We need to confirm it by incrementing the refcount
 		 * and then check the lookup again.
 		 *
-		 * atomic_long_inc_not_zero() gives us a full memory
+		 * atomic_long_add_unless() gives us a full memory
 		 * barrier. We only really need an 'acquire' one to
 		 * protect the loads below, but we don't have that.
 		 */
-		if (unlikely(!atomic_long_inc_not_zero(&file->f_count)))
+		if (unlikely(!atomic_long_add_unless(&file->f_count, refs, 0)))
 			continue;
 
 		/*
@@ -1006,7 +1095,7 @@ static inline struct file *__fget_files_rcu(struct files_struct *files,
 		 */
 		if (unlikely(file != rcu_dereference_raw(*fdentry)) ||
 		    unlikely(rcu_dereference_raw(files->fdt) != fdt)) {
-			fput(file);
+			fput_many(file, refs);
 			continue;
 		}
 
@@ -1015,7 +1104,7 @@ static inline struct file *__fget_files_rcu(struct files_struct *files,
 		 * allowed to get a reference to it.
 		 */
 		if (unlikely(file->f_mode & mask)) {
-			fput(file);
+			fput_many(file, refs);
 			return NULL;
 		}
 
@@ -1028,31 +1117,37 @@ static inline struct file *__fget_files_rcu(struct files_struct *files,
 }
 
 static struct file *__fget_files(struct files_struct *files, unsigned int fd,
-				 fmode_t mask)
+				 fmode_t mask, unsigned int refs)
 {
 	struct file *file;
 
 	rcu_read_lock();
-	file = __fget_files_rcu(files, fd, mask);
+	file = __fget_files_rcu(files, fd, mask, refs);
 	rcu_read_unlock();
 
 	return file;
 }
 
-static inline struct file *__fget(unsigned int fd, fmode_t mask)
+static inline struct file *__fget(unsigned int fd, fmode_t mask,
+				  unsigned int refs)
+{
+	return __fget_files(current->files, fd, mask, refs);
+}
+
+struct file *fget_many(unsigned int fd, unsigned int refs)
 {
-	return __fget_files(current->files, fd, mask);
+	return __fget(fd, FMODE_PATH, refs);
 }
 
 struct file *fget(unsigned int fd)
 {
-	return __fget(fd, FMODE_PATH);
+	return __fget(fd, FMODE_PATH, 1);
 }
 EXPORT_SYMBOL(fget);
 
 struct file *fget_raw(unsigned int fd)
 {
-	return __fget(fd, 0);
+	return __fget(fd, 0, 1);
 }
 EXPORT_SYMBOL(fget_raw);
 
@@ -1062,7 +1157,7 @@ struct file *fget_task(struct task_struct *task, unsigned int fd)
 
 	task_lock(task);
 	if (task->files)
-		file = __fget_files(task->files, fd, 0);
+		file = __fget_files(task->files, fd, 0, 1);
 	task_unlock(task);
 
 	return file;
@@ -1070,7 +1165,7 @@ struct file *fget_task(struct task_struct *task, unsigned int fd)
 
 struct file *lookup_fdget_rcu(unsigned int fd)
 {
-	return __fget_files_rcu(current->files, fd, 0);
+	return __fget_files_rcu(current->files, fd, 0, 1);
 
 }
 EXPORT_SYMBOL_GPL(lookup_fdget_rcu);
@@ -1084,7 +1179,7 @@ struct file *task_lookup_fdget_rcu(struct task_struct *task, unsigned int fd)
 	task_lock(task);
 	files = task->files;
 	if (files)
-		file = __fget_files_rcu(files, fd, 0);
+		file = __fget_files_rcu(files, fd, 0, 1);
 	task_unlock(task);
 
 	return file;
@@ -1101,7 +1196,7 @@ struct file *task_lookup_next_fdget_rcu(struct task_struct *task, unsigned int *
 	files = task->files;
 	if (files) {
 		for (; fd < files_fdtable(files)->max_fds; fd++) {
-			file = __fget_files_rcu(files, fd, 0);
+			file = __fget_files_rcu(files, fd, 0, 1);
 			if (file)
 				break;
 		}
@@ -1148,7 +1243,7 @@ static unsigned long __fget_light(unsigned int fd, fmode_t mask)
 			return 0;
 		return (unsigned long)file;
 	} else {
-		file = __fget_files(files, fd, mask);
+		file = __fget_files(files, fd, mask, 1);
 		if (!file)
 			return 0;
 		return FDPUT_FPUT | (unsigned long)file;
@@ -1395,7 +1490,7 @@ SYSCALL_DEFINE2(dup2, unsigned int, oldfd, unsigned int, newfd)
 		int retval = oldfd;
 
 		rcu_read_lock();
-		f = __fget_files_rcu(files, oldfd, 0);
+		f = __fget_files_rcu(files, oldfd, 0, 1);
 		if (!f)
 			retval = -EBADF;
 		rcu_read_unlock();
@@ -2184,6 +2184,60 @@ static struct wb_writeback_work *get_next_work_item(struct bdi_writeback *wb)
 	return work;
 }
 
+/*
+ * Extra background flushers, started when bdi->wb_workers > 1.  They run
+ * the same background writeback as the wb's own flusher.  Inodes under
+ * writeback are marked I_SYNC, and WB_SYNC_NONE writeback skips those.
+ * So the helpers naturally spread the inodes on b_io among themselves.
+ */
+struct wb_bg_helper {
+	struct work_struct work;
+	struct bdi_writeback *wb;
+};
+
+static void wb_bg_helper_workfn(struct work_struct *work)
+{
+	struct wb_bg_helper *helper =
+		container_of(work, struct wb_bg_helper, work);
+	struct bdi_writeback *wb = helper->wb;
+	struct wb_writeback_work bg_work = {
+		.nr_pages	= LONG_MAX,
+		.sync_mode	= WB_SYNC_NONE,
+		.for_background	= 1,
+		.range_cyclic	= 1,
+		.reason		= WB_REASON_BACKGROUND,
+	};
+
+	kfree(helper);
+	set_worker_desc("flush-%s", bdi_dev_name(wb->bdi));
+
+	if (test_bit(WB_registered, &wb->state) &&
+	    !current_is_workqueue_rescuer() && wb_over_bg_thresh(wb))
+		wb_writeback(wb, &bg_work);
+
+	if (atomic_dec_and_test(&wb->bg_helpers))
+		wake_up_var(&wb->bg_helpers);
+	wb_put(wb);
+}
+
+static void wb_start_bg_helpers(struct bdi_writeback *wb)
+{
+	unsigned int workers = READ_ONCE(wb->bdi->wb_workers);
+	struct wb_bg_helper *helper;
+
+	/* only the wb's own flusher starts helpers, so this can't race */
+	while (atomic_read(&wb->bg_helpers) + 1 < workers) {
+		helper = kmalloc(sizeof(*helper), GFP_NOWAIT | __GFP_NOWARN);
+		if (!helper)
+			break;
+		wb_get(wb);
+		atomic_inc(&wb->bg_helpers);
+		helper->wb = wb;
+		INIT_WORK(&helper->work, wb_bg_helper_workfn);
+		queue_work(bdi_wq, &helper->work);
+	}
+}
+
 static long wb_check_background_flush(struct bdi_writeback *wb)
 {
 	if (wb_over_bg_thresh(wb)) {
@@ -2196,6 +2250,7 @@ static long wb_check_background_flush(struct bdi_writeback *wb)
 			.reason		= WB_REASON_BACKGROUND,
 		};
 
+		wb_start_bg_helpers(wb);
 		return wb_writeback(wb, &work);
 	}
 
@@ -2652,6 +2707,13 @@ static void wait_sb_inodes(struct super_block *sb)
 		if (!mapping_tagged(mapping, PAGECACHE_TAG_WRITEBACK))
 			continue;
 
+		/*
+		 * Don't let an agent that may never complete writeback, such
+		 * as a FUSE server, hang sync(2) for the whole system.
+		 */
+		if (mapping_writeback_indeterminate(mapping))
+			continue;
+
 		spin_unlock_irq(&sb->s_inode_wblist_lock);
 
 		spin_lock(&inode->i_lock);
@@ -0,0 +1,744 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * FUSE: Filesystem in Userspace
+ *
+ * Request transport over io-uring.
+ *
+ * The daemon registers ring entries with FUSE_IO_URING_CMD_REGISTER, one
+ * queue per CPU.  Each entry is a pair of userspace buffers, a header and a
+ * payload, and the command stays queued until a request is available.  A
+ * request is assigned to an entry of the submitting CPU's queue, copied into
+ * the entry buffers from the daemon's task context and the command is
+ * completed.  The daemon sends the reply and fetches the next request with a
+ * single FUSE_IO_URING_CMD_COMMIT_AND_FETCH.
+ *
+ * FORGET and INTERRUPT requests as well as notifications keep using
+ * /dev/fuse.
+ */
+
+#include "fuse_i.h"
+#include "dev_uring_i.h"
+#include "fuse_dev_i.h"
+
+#include <linux/fs.h>
+#include <linux/io_uring/cmd.h>
+#include <linux/uio.h>
+
+static bool __read_mostly enable_uring;
+module_param(enable_uring, bool, 0644);
+MODULE_PARM_DESC(enable_uring,
+		 "Enable userspace communication through io-uring");
+
+/* Overlays struct io_uring_cmd pdu */
+struct fuse_uring_pdu {
+	struct fuse_ring_ent *ent;
+};
+
+bool fuse_uring_enabled(void)
+{
+	return enable_uring;
+}
+
+static struct fuse_ring_ent *uring_cmd_to_ring_ent(struct io_uring_cmd *cmd)
+{
+	struct fuse_uring_pdu *pdu = (struct fuse_uring_pdu *)&cmd->pdu;
+
+	return pdu->ent;
+}
+
+static void uring_cmd_set_ring_ent(struct io_uring_cmd *cmd,
+				   struct fuse_ring_ent *ent)
+{
+	struct fuse_uring_pdu *pdu = (struct fuse_uring_pdu *)&cmd->pdu;
+
+	BUILD_BUG_ON(sizeof(struct fuse_uring_pdu) > sizeof(cmd->pdu));
+	pdu->ent = ent;
+}
+
+void fuse_uring_destruct(struct fuse_conn *fc)
+{
+	struct fuse_ring *ring = fc->ring;
+	int qid;
+
+	if (!ring)
+		return;
+
+	for (qid = 0; qid < ring->nr_queues; qid++) {
+		struct fuse_ring_queue *queue = ring->queues[qid];
+		struct fuse_ring_ent *ent, *next;
+
+		if (!queue)
+			continue;
+
+		WARN_ON(!list_empty(&queue->fuse_req_queue));
+		list_for_each_entry_safe(ent, next, &queue->ent_all, all) {
+			list_del(&ent->all);
+			kfree(ent);
+		}
+		kfree(queue);
+	}
+
+	kfree(ring->queues);
+	kfree(ring);
+	fc->ring = NULL;
+}
+
+static struct fuse_ring *fuse_uring_create(struct fuse_conn *fc)
+{
+	struct fuse_ring *ring;
+	size_t max_payload_size;
+
+	ring = kzalloc(sizeof(*fc->ring), GFP_KERNEL_ACCOUNT);
+	if (!ring)
+		return NULL;
+
+	ring->queues = kcalloc(nr_cpu_ids, sizeof(struct fuse_ring_queue *),
+			       GFP_KERNEL_ACCOUNT);
+	if (!ring->queues)
+		goto out_err;
+
+	/* Same constraints as for the read buffer of /dev/fuse */
+	max_payload_size = max_t(size_t,
+				 FUSE_MIN_READ_BUFFER -
+				 sizeof(struct fuse_in_header),
+				 sizeof(struct fuse_write_in) + fc->max_write);
+	max_payload_size = max_t(size_t, max_payload_size,
+				 fc->max_pages << PAGE_SHIFT);
+
+	spin_lock(&fc->lock);
+	if (fc->ring) {
+		/* race, another thread created the ring in the meantime */
+		spin_unlock(&fc->lock);
+		kfree(ring->queues);
+		kfree(ring);
+		return fc->ring;
+	}
+
+	ring->fc = fc;
+	ring->nr_queues = nr_cpu_ids;
+	ring->max_payload_sz = max_payload_size;
+	atomic_set(&ring->nr_ready_queues, 0);
+	smp_store_release(&fc->ring, ring);
+	spin_unlock(&fc->lock);
+
+	return ring;
+
+out_err:
+	kfree(ring);
+	return NULL;
+}
+
+static struct fuse_ring_queue *fuse_uring_create_queue(struct fuse_ring *ring,
+						       int qid)
+{
+	struct fuse_conn *fc = ring->fc;
+	struct fuse_ring_queue *queue;
+
+	queue = kzalloc_node(sizeof(*queue), GFP_KERNEL_ACCOUNT,
+			     cpu_to_node(qid));
+	if (!queue)
+		return NULL;
+
+	queue->qid = qid;
+	queue->ring = ring;
+	spin_lock_init(&queue->lock);
+	INIT_LIST_HEAD(&queue->ent_avail_queue);
+	INIT_LIST_HEAD(&queue->ent_in_userspace);
+	INIT_LIST_HEAD(&queue->ent_all);
+	INIT_LIST_HEAD(&queue->fuse_req_queue);
+
+	spin_lock(&fc->lock);
+	if (ring->queues[qid]) {
+		spin_unlock(&fc->lock);
+		kfree(queue);
+		return ring->queues[qid];
+	}
+	WRITE_ONCE(ring->queues[qid], queue);
+	spin_unlock(&fc->lock);
+
+	return queue;
+}
+
+/*
+ * Stop all queues and hand their requests to the connection abort, which
+ * ends them.  Entries waiting for a request get their command completed.
+ * Entries in the middle of a copy notice the stopped queue when they are
+ * done and end their request themselves.
+ */
+void fuse_uring_abort(struct fuse_conn *fc, struct list_head *to_end)
+{
+	struct fuse_ring *ring = fc->ring;
+	int qid;
+
+	if (!ring)
+		return;
+
+	for (qid = 0; qid < ring->nr_queues; qid++) {
+		struct fuse_ring_queue *queue = READ_ONCE(ring->queues[qid]);
+		struct fuse_ring_ent *ent, *next;
+		struct fuse_req *req;
+		LIST_HEAD(avail);
+
+		if (!queue)
+			continue;
+
+		spin_lock(&queue->lock);
+		queue->stopped = true;
+
+		list_for_each_entry(req, &queue->fuse_req_queue, list)
+			clear_bit(FR_PENDING, &req->flags);
+		list_splice_tail_init(&queue->fuse_req_queue, to_end);
+
+		list_for_each_entry_safe(ent, next, &queue->ent_in_userspace,
+					 list) {
+			list_add_tail(&ent->fuse_req->list, to_end);
+			ent->fuse_req = NULL;
+			ent->state = FRRS_INVALID;
+			list_del_init(&ent->list);
+		}
+
+		list_for_each_entry(ent, &queue->ent_avail_queue, list)
+			ent->state = FRRS_INVALID;
+		list_splice_init(&queue->ent_avail_queue, &avail);
+		spin_unlock(&queue->lock);
+
+		list_for_each_entry_safe(ent, next, &avail, list) {
+			struct io_uring_cmd *cmd = ent->cmd;
+
+			list_del_init(&ent->list);
+			ent->cmd = NULL;
+			io_uring_cmd_done(cmd, -ENOTCONN, 0, IO_URING_F_UNLOCKED);
+		}
+	}
+}
+
+/*
+ * Copy the request to the entry buffers: the in header goes into the header
+ * buffer, the arguments into the payload, laid out as on /dev/fuse.
+ */
+static int fuse_uring_copy_to_ring(struct fuse_ring_ent *ent,
+				   struct fuse_req *req)
+{
+	struct fuse_args *args = req->args;
+	struct fuse_uring_ent_in_out ent_in_out = {
+		.commit_id = req->in.h.unique,
+		.payload_sz = req->in.h.len - sizeof(struct fuse_in_header),
+	};
+	struct fuse_copy_state cs;
+	struct iov_iter iter;
+	int err;
+
+	if (ent_in_out.payload_sz > ent->payload_sz) {
+		/* SETXATTR is special, since it may contain too large data */
+		return args->opcode == FUSE_SETXATTR ? -E2BIG : -EIO;
+	}
+
+	err = import_ubuf(ITER_DEST, ent->payload, ent->payload_sz, &iter);
+	if (err)
+		return -EIO;
+
+	fuse_copy_init(&cs, 1, &iter);
+	cs.req = req;
+	err = fuse_copy_args(&cs, args->in_numargs, args->in_pages,
+			     (struct fuse_arg *) args->in_args, 0);
+	fuse_copy_finish(&cs);
+	clear_bit(FR_LOCKED, &req->flags);
+	if (err)
+		return -EIO;
+
+	if (copy_to_user(&ent->headers->in_out, &req->in.h,
+			 sizeof(req->in.h)) ||
+	    copy_to_user(&ent->headers->ring_ent_in_out, &ent_in_out,
+			 sizeof(ent_in_out)))
+		return -EIO;
+
+	return 0;
+}
+
+static int fuse_uring_copy_from_ring(struct fuse_ring_ent *ent,
+				     struct fuse_req *req)
+{
+	struct fuse_uring_ent_in_out ring_in_out;
+	struct fuse_out_header oh;
+	struct fuse_copy_state cs;
+	struct iov_iter iter;
+	int err;
+
+	if (copy_from_user(&oh, &ent->headers->in_out, sizeof(oh)) ||
+	    copy_from_user(&ring_in_out, &ent->headers->ring_ent_in_out,
+			   sizeof(ring_in_out)))
+		return -EFAULT;
+
+	if (oh.error <= -512 || oh.error > 0)
+		return -EINVAL;
+
+	req->out.h = oh;
+	if (oh.error)
+		return 0;
+
+	if (ring_in_out.payload_sz > ent->payload_sz)
+		return -EINVAL;
+
+	err = import_ubuf(ITER_SOURCE, ent->payload, ring_in_out.payload_sz,
+			  &iter);
+	if (err)
+		return err;
+
+	fuse_copy_init(&cs, 0, &iter);
+	cs.req = req;
+	err = fuse_copy_out_args(&cs, req->args, ring_in_out.payload_sz +
+				 sizeof(struct fuse_out_header));
+	fuse_copy_finish(&cs);
+	clear_bit(FR_LOCKED, &req->flags);
+
+	return err;
+}
+
+static void fuse_uring_add_req_to_ring_ent(struct fuse_ring_ent *ent,
+					   struct fuse_req *req)
+{
+	lockdep_assert_held(&ent->queue->lock);
+
+	clear_bit(FR_PENDING, &req->flags);
+	ent->fuse_req = req;
+	ent->state = FRRS_DISPATCH;
+	list_del_init(&ent->list);
+}
+
+/* Give the entry the next queued request, if there is any */
+static struct fuse_req *fuse_uring_ent_assign_req(struct fuse_ring_ent *ent)
+{
+	struct fuse_ring_queue *queue = ent->queue;
+	struct fuse_req *req;
+
+	lockdep_assert_held(&queue->lock);
+
+	req = list_first_entry_or_null(&queue->fuse_req_queue, struct fuse_req,
+				       list);
+	if (req) {
+		list_del_init(&req->list);
+		fuse_uring_add_req_to_ring_ent(ent, req);
+	}
+
+	return req;
+}
+
+/*
+ * The entry holds a command but no request.  Assign the next queued request
+ * or make the entry available.  Returns true if a request was assigned and
+ * needs to be dispatched.
+ */
+static bool fuse_uring_ent_next(struct fuse_ring_ent *ent,
+				unsigned int issue_flags)
+{
+	struct fuse_ring_queue *queue = ent->queue;
+	struct io_uring_cmd *cmd;
+
+	spin_lock(&queue->lock);
+	if (unlikely(queue->stopped)) {
+		cmd = ent->cmd;
+		ent->cmd = NULL;
+		ent->state = FRRS_INVALID;
+		spin_unlock(&queue->lock);
+		io_uring_cmd_done(cmd, -ENOTCONN, 0, issue_flags);
+		return false;
+	}
+
+	if (fuse_uring_ent_assign_req(ent)) {
+		spin_unlock(&queue->lock);
+		return true;
+	}
+
+	ent->state = FRRS_AVAILABLE;
+	list_add_tail(&ent->list, &queue->ent_avail_queue);
+	spin_unlock(&queue->lock);
+
+	return false;
+}
+
+/*
+ * Copy the assigned request to userspace and complete the command.  Runs in
+ * the context of the task that owns the ring entry buffers.
+ */
+static void fuse_uring_dispatch(struct fuse_ring_ent *ent,
+				unsigned int issue_flags)
+{
+	struct fuse_ring_queue *queue = ent->queue;
+	struct io_uring_cmd *cmd = ent->cmd;
+	struct fuse_req *req;
+	int err;
+
+	do {
+		req = ent->fuse_req;
+		err = fuse_uring_copy_to_ring(ent, req);
+
+		spin_lock(&queue->lock);
+		if (!err && !queue->stopped) {
+			set_bit(FR_SENT, &req->flags);
+			ent->state = FRRS_USERSPACE;
+			ent->cmd = NULL;
+			list_add_tail(&ent->list, &queue->ent_in_userspace);
+			/* matches barrier in request_wait_answer() */
+			smp_mb__after_atomic();
+			if (test_bit(FR_INTERRUPTED, &req->flags))
+				fuse_queue_interrupt(req);
+			spin_unlock(&queue->lock);
+
+			io_uring_cmd_done(cmd, 0, 0, issue_flags);
+			return;
+		}
+		if (queue->stopped)
+			err = -ECONNABORTED;
+		ent->fuse_req = NULL;
+		spin_unlock(&queue->lock);
+
+		req->out.h.error = err;
+		fuse_request_end(req);
+	} while (fuse_uring_ent_next(ent, issue_flags));
+}
+
+static void fuse_uring_send_in_task(struct io_uring_cmd *cmd,
+				    unsigned int issue_flags)
+{
+	fuse_uring_dispatch(uring_cmd_to_ring_ent(cmd), issue_flags);
+}
+
+void fuse_uring_queue_req(struct fuse_conn *fc, struct fuse_req *req)
+{
+	struct fuse_ring *ring = fc->ring;
+	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_ring_queue *queue;
+	struct fuse_ring_ent *ent;
+	unsigned int qid;
+
+	qid = task_cpu(current);
+	if (WARN_ONCE(qid >= ring->nr_queues,
+		      "Core number (%u) exceeds nr queues (%zu)\n", qid,
+		      ring->nr_queues))
+		qid = 0;
+	queue = ring->queues[qid];
+	req->ring_queue = queue;
+
+	spin_lock(&queue->lock);
+	if (unlikely(queue->stopped)) {
+		/*
+		 * Only reachable by racing with the connection abort, which
+		 * has already flushed the background queue.
+		 */
+		spin_unlock(&queue->lock);
+		req->out.h.error = -ENOTCONN;
+		clear_bit(FR_PENDING, &req->flags);
+		fuse_request_end(req);
+		return;
+	}
+
+	/*
+	 * The ring was found ready without the lock.  If the last entry of
+	 * this queue has been cancelled since, nothing would serve the
+	 * request here; send it over /dev/fuse instead.
+	 */
+	if (unlikely(!queue->nr_ents)) {
+		spin_lock(&fiq->lock);
+		list_add_tail(&req->list, &fiq->pending);
+		fiq->ops->wake_pending_and_unlock(fiq);
+		spin_unlock(&queue->lock);
+		return;
+	}
+
+	set_bit(FR_URING, &req->flags);
+	ent = list_first_entry_or_null(&queue->ent_avail_queue,
+				       struct fuse_ring_ent, list);
+	if (ent)
+		fuse_uring_add_req_to_ring_ent(ent, req);
+	else
+		list_add_tail(&req->list, &queue->fuse_req_queue);
+	spin_unlock(&queue->lock);
+
+	if (ent)
+		io_uring_cmd_complete_in_task(ent->cmd, fuse_uring_send_in_task);
+}
+
+/*
+ * Take a request that is still waiting for a ring entry off its queue.
+ * Returns false if the request is not owned by a ring queue, in which case it
+ * is on (or was read from) fiq->pending, protected by fiq->lock.  FR_URING is
+ * only changed under queue->lock, so it is stable while that is held.
+ */
+bool fuse_uring_remove_pending_req(struct fuse_req *req, bool *removed)
+{
+	struct fuse_ring_queue *queue = req->ring_queue;
+	bool owned;
+
+	*removed = false;
+	if (!queue)
+		return false;
+
+	spin_lock(&queue->lock);
+	owned = test_bit(FR_URING, &req->flags);
+	if (owned && test_bit(FR_PENDING, &req->flags)) {
+		list_del(&req->list);
+		*removed = true;
+	}
+	spin_unlock(&queue->lock);
+
+	return owned;
+}
+
+static struct fuse_ring_ent *fuse_uring_find_ent(struct fuse_ring_queue *queue,
+						 u64 commit_id)
+{
+	struct fuse_ring_ent *ent;
+
+	lockdep_assert_held(&queue->lock);
+
+	list_for_each_entry(ent, &queue->ent_in_userspace, list) {
+		if (ent->fuse_req->in.h.unique == commit_id)
+			return ent;
+	}
+
+	return NULL;
+}
+
+static int fuse_uring_commit_fetch(struct io_uring_cmd *cmd,
+				   unsigned int issue_flags,
+				   struct fuse_conn *fc)
+{
+	const struct fuse_uring_cmd_req *cmd_req = io_uring_sqe_cmd(cmd->sqe);
+	struct fuse_ring *ring = smp_load_acquire(&fc->ring);
+	u64 commit_id = READ_ONCE(cmd_req->commit_id);
+	unsigned int qid = READ_ONCE(cmd_req->qid);
+	struct fuse_ring_queue *queue;
+	struct fuse_ring_ent *ent;
+	struct fuse_req *req;
+	int err;
+
+	if (!ring || qid >= ring->nr_queues)
+		return -EINVAL;
+
+	queue = READ_ONCE(ring->queues[qid]);
+	if (!queue)
+		return -ENOTCONN;
+
+	spin_lock(&queue->lock);
+	if (queue->stopped) {
+		spin_unlock(&queue->lock);
+		return -ENOTCONN;
+	}
+
+	ent = fuse_uring_find_ent(queue, commit_id);
+	if (!ent) {
+		spin_unlock(&queue->lock);
+		return -ENOENT;
+	}
+
+	req = ent->fuse_req;
+	ent->fuse_req = NULL;
+	ent->state = FRRS_COMMIT;
+	list_del_init(&ent->list);
+	clear_bit(FR_SENT, &req->flags);
+	spin_unlock(&queue->lock);
+
+	ent->cmd = cmd;
+	uring_cmd_set_ring_ent(cmd, ent);
+	io_uring_cmd_mark_cancelable(cmd, issue_flags);
+
+	err = fuse_uring_copy_from_ring(ent, req);
+	if (err)
+		req->out.h.error = -EIO;
+	fuse_request_end(req);
+
+	if (fuse_uring_ent_next(ent, issue_flags))
+		fuse_uring_dispatch(ent, issue_flags);
+
+	return -EIOCBQUEUED;
+}
+
+static struct fuse_ring_ent *
+fuse_uring_create_ring_ent(struct io_uring_cmd *cmd,
+			   struct fuse_ring_queue *queue)
+{
+	struct fuse_ring *ring = queue->ring;
+	struct iovec iov_stack[FUSE_URING_IOV_SEGS], *iov = iov_stack;
+	struct fuse_ring_ent *ent;
+	struct iov_iter iter;
+	ssize_t ret;
+
+	if (READ_ONCE(cmd->sqe->len) != FUSE_URING_IOV_SEGS)
+		return ERR_PTR(-EINVAL);
+
+	ret = import_iovec(ITER_DEST,
+			   u64_to_user_ptr(READ_ONCE(cmd->sqe->addr)),
+			   FUSE_URING_IOV_SEGS, FUSE_URING_IOV_SEGS, &iov,
+			   &iter);
+	if (ret < 0)
+		return ERR_PTR(ret);
+	kfree(iov);
+
+	if (iov_stack[0].iov_len < sizeof(struct fuse_uring_req_header) ||
+	    iov_stack[1].iov_len < ring->max_payload_sz)
+		return ERR_PTR(-EINVAL);
+
+	ent = kzalloc(sizeof(*ent), GFP_KERNEL_ACCOUNT);
+	if (!ent)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&ent->list);
+	INIT_LIST_HEAD(&ent->all);
+	ent->queue = queue;
+	ent->headers = iov_stack[0].iov_base;
+	ent->payload = iov_stack[1].iov_base;
+	ent->payload_sz = iov_stack[1].iov_len;
+
+	return ent;
+}
+
+static int fuse_uring_register(struct io_uring_cmd *cmd,
+			       unsigned int issue_flags, struct fuse_conn *fc)
+{
+	const struct fuse_uring_cmd_req *cmd_req = io_uring_sqe_cmd(cmd->sqe);
+	struct fuse_ring *ring = smp_load_acquire(&fc->ring);
+	unsigned int qid = READ_ONCE(cmd_req->qid);
+	struct fuse_ring_queue *queue;
+	struct fuse_ring_ent *ent;
+	bool first, dispatch;
+
+	if (!ring) {
+		ring = fuse_uring_create(fc);
+		if (!ring)
+			return -ENOMEM;
+	}
+
+	if (qid >= ring->nr_queues || !cpu_possible(qid))
+		return -EINVAL;
+
+	queue = READ_ONCE(ring->queues[qid]);
+	if (!queue) {
+		queue = fuse_uring_create_queue(ring, qid);
+		if (!queue)
+			return -ENOMEM;
+	}
+
+	ent = fuse_uring_create_ring_ent(cmd, queue);
+	if (IS_ERR(ent))
+		return PTR_ERR(ent);
+
+	ent->cmd = cmd;
+	uring_cmd_set_ring_ent(cmd, ent);
+	io_uring_cmd_mark_cancelable(cmd, issue_flags);
+
+	spin_lock(&queue->lock);
+	if (queue->stopped) {
+		spin_unlock(&queue->lock);
+		kfree(ent);
+		io_uring_cmd_done(cmd, -ENOTCONN, 0, issue_flags);
+		return -EIOCBQUEUED;
+	}
+
+	first = !queue->nr_ents++;
+	list_add_tail(&ent->all, &queue->ent_all);
+	dispatch = fuse_uring_ent_assign_req(ent);
+	if (!dispatch) {
+		ent->state = FRRS_AVAILABLE;
+		list_add_tail(&ent->list, &queue->ent_avail_queue);
+	}
+	spin_unlock(&queue->lock);
+
+	/*
+	 * Requests are routed to the ring once every queue can take them,
+	 * again after a queue lost its last entry to a cancel.
+	 */
+	if (first && atomic_inc_return(&ring->nr_ready_queues) ==
+		     num_possible_cpus())
+		smp_store_release(&ring->ready, true);
+
+	if (dispatch)
+		fuse_uring_dispatch(ent, issue_flags);
+
+	return -EIOCBQUEUED;
+}
+
+/* The io-uring the command was queued on is going away */
+static void fuse_uring_cancel(struct io_uring_cmd *cmd,
+			      unsigned int issue_flags)
+{
+	struct fuse_ring_ent *ent = uring_cmd_to_ring_ent(cmd);
+	struct fuse_ring_queue *queue = ent->queue;
+	struct fuse_ring *ring = queue->ring;
+	struct fuse_iqueue *fiq = &ring->fc->iq;
+	bool need_cmd_done = false;
+	struct fuse_req *req;
+
+	spin_lock(&queue->lock);
+	if (ent->state == FRRS_AVAILABLE && ent->cmd == cmd) {
+		ent->state = FRRS_INVALID;
+		ent->cmd = NULL;
+		list_del_init(&ent->list);
+		need_cmd_done = true;
+	}
+	if (need_cmd_done && !--queue->nr_ents) {
+		/*
+		 * The ring no longer serves every cpu: send new requests over
+		 * /dev/fuse again, along with those still waiting for an entry.
+		 * Registering a new entry on this queue makes it ready again.
+		 */
+		atomic_dec(&ring->nr_ready_queues);
+		WRITE_ONCE(ring->ready, false);
+		if (!list_empty(&queue->fuse_req_queue)) {
+			spin_lock(&fiq->lock);
+			list_for_each_entry(req, &queue->fuse_req_queue, list)
+				clear_bit(FR_URING, &req->flags);
+			list_splice_tail_init(&queue->fuse_req_queue,
+					      &fiq->pending);
+			fiq->ops->wake_pending_and_unlock(fiq);
+		}
+	}
+	spin_unlock(&queue->lock);
+
+	if (need_cmd_done)
+		io_uring_cmd_done(cmd, -ENOTCONN, 0, issue_flags);
+}
+
+/*
+ * Entry function from io_uring to handle the given passthrough command
+ * (op code IORING_OP_URING_CMD)
+ */
+int fuse_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
+{
+	struct fuse_dev *fud;
+	struct fuse_conn *fc;
+
+	if (!enable_uring)
+		return -EOPNOTSUPP;
+
+	if (unlikely(issue_flags & IO_URING_F_CANCEL)) {
+		fuse_uring_cancel(cmd, issue_flags);
+		return 0;
+	}
+
+	/* The extra SQE size holds struct fuse_uring_cmd_req */
+	if (!(issue_flags & IO_URING_F_SQE128))
+		return -EINVAL;
+
+	fud = fuse_get_dev(cmd->file);
+	if (!fud)
+		return -ENOTCONN;
+	fc = fud->fc;
+
+	if (fc->aborted)
+		return -ECONNABORTED;
+	if (!fc->connected)
+		return -ENOTCONN;
+
+	/* io-uring is negotiated in the INIT reply */
+	if (!fc->initialized || !fc->io_uring)
+		return -EINVAL;
+
+	switch (cmd->cmd_op) {
+	case FUSE_IO_URING_CMD_REGISTER:
+		return fuse_uring_register(cmd, issue_flags, fc);
+	case FUSE_IO_URING_CMD_COMMIT_AND_FETCH:
+		return fuse_uring_commit_fetch(cmd, issue_flags, fc);
+	default:
+		return -EINVAL;
+	}
+}
@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: GPL-2.0
+ *
+ * FUSE: Filesystem in Userspace
+ */
+
+#ifndef _FS_FUSE_DEV_URING_I_H
+#define _FS_FUSE_DEV_URING_I_H
+
+#include "fuse_i.h"
+
+#ifdef CONFIG_FUSE_IO_URING
+
+/* number of iovecs passed with FUSE_IO_URING_CMD_REGISTER */
+#define FUSE_URING_IOV_SEGS 2
+
+enum fuse_ring_req_state {
+	FRRS_INVALID = 0,
+
+	/* The ring entry holds a fetch command and waits for a request */
+	FRRS_AVAILABLE,
+
+	/* A request was assigned, it is copied to userspace from task work */
+	FRRS_DISPATCH,
+
+	/* The request is in userspace, waiting for a commit */
+	FRRS_USERSPACE,
+
+	/* The reply is copied in from userspace */
+	FRRS_COMMIT,
+};
+
+/** A fuse ring entry, part of the ring queue */
+struct fuse_ring_ent {
+	/* userspace buffers */
+	struct fuse_uring_req_header __user *headers;
+	void __user *payload;
+	size_t payload_sz;
+
+	/* the ring queue that owns the request */
+	struct fuse_ring_queue *queue;
+
+	/* fetch command to complete, when a request is assigned */
+	struct io_uring_cmd *cmd;
+
+	/* entry on one of the queue lists, depending on the state */
+	struct list_head list;
+
+	/* entry on queue->ent_all, for freeing */
+	struct list_head all;
+
+	enum fuse_ring_req_state state;
+
+	struct fuse_req *fuse_req;
+};
+
+struct fuse_ring_queue {
+	/* back pointer to the main fuse uring structure */
+	struct fuse_ring *ring;
+
+	/* queue id, corresponds to the cpu core */
+	unsigned int qid;
+
+	/* protects the lists and states below */
+	spinlock_t lock;
+
+	/* available ring entries (struct fuse_ring_ent) */
+	struct list_head ent_avail_queue;
+
+	/* entries with a request in userspace */
+	struct list_head ent_in_userspace;
+
+	/* all entries of the queue */
+	struct list_head ent_all;
+
+	/* fuse requests waiting for an entry slot */
+	struct list_head fuse_req_queue;
+
+	/* registered entries that have not been cancelled */
+	unsigned int nr_ents;
+
+	bool stopped;
+};
+
+/**
+ * Describes if uring is for communication and holds alls the data needed
+ * for uring communication
+ */
+struct fuse_ring {
+	/* back pointer */
+	struct fuse_conn *fc;
+
+	/* number of ring queues */
+	size_t nr_queues;
+
+	/* maximum payload/arg size */
+	size_t max_payload_sz;
+
+	/* number of queues with at least one entry that is not cancelled */
+	atomic_t nr_ready_queues;
+
+	/* set once every queue has a registered entry */
+	bool ready;
+
+	struct fuse_ring_queue **queues;
+};
+
+bool fuse_uring_enabled(void);
+void fuse_uring_destruct(struct fuse_conn *fc);
+void fuse_uring_abort(struct fuse_conn *fc, struct list_head *to_end);
+int fuse_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags);
+void fuse_uring_queue_req(struct fuse_conn *fc, struct fuse_req *req);
+bool fuse_uring_remove_pending_req(struct fuse_req *req, bool *removed);
+
+static inline bool fuse_uring_ready(struct fuse_conn *fc)
+{
+	struct fuse_ring *ring = READ_ONCE(fc->ring);
+
+	return ring && smp_load_acquire(&ring->ready);
+}
+
+#else /* CONFIG_FUSE_IO_URING */
+
+struct fuse_ring;
+
+static inline bool fuse_uring_enabled(void)
+{
+	return false;
+}
+
+static inline void fuse_uring_destruct(struct fuse_conn *fc)
+{
+}
+
+static inline void fuse_uring_abort(struct fuse_conn *fc,
+				    struct list_head *to_end)
+{
+}
+
+static inline bool fuse_uring_ready(struct fuse_conn *fc)
+{
+	return false;
+}
+
+static inline void fuse_uring_queue_req(struct fuse_conn *fc,
+					struct fuse_req *req)
+{
+}
+
+static inline bool fuse_uring_remove_pending_req(struct fuse_req *req,
+						 bool *removed)
+{
+	*removed = false;
+	return false;
+}
+
+#endif /* CONFIG_FUSE_IO_URING */
+
+#endif /* _FS_FUSE_DEV_URING_I_H */
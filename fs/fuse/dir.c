@@ -1637,6 +1637,42 @@ static const char *fuse_get_link(struct dentry *dentry, struct inode *inode,
 	return ERR_PTR(err);
 }
 
+/*
+ * Directory opened with FOPEN_PASSTHROUGH: readdir is served from the backing
+ * directory, which requires the server to report the backing inode numbers
+ * (checked on the directory itself).  Unlike regular files, the fuse inode does not keep a reference
+ * to the backing file, since there is no io mode to arbitrate for directories.
+ */
+static int fuse_dir_passthrough_open(struct inode *inode, struct file *file)
+{
+	struct fuse_file *ff = file->private_data;
+	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct fuse_backing *fb;
+
+	if (!IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) || !fc->passthrough || !ff->args)
+		return -EINVAL;
+
+	fb = fuse_passthrough_open(file, inode,
+				   ff->args->open_outarg.backing_id);
+	if (IS_ERR(fb))
+		return PTR_ERR(fb);
+
+	fuse_backing_put(fb);
+
+	/*
+	 * Entries come straight from the backing directory, so their inode
+	 * numbers are only right if the server passes those through as well.
+	 */
+	if (file_inode(fuse_file_passthrough(ff))->i_ino !=
+	    get_fuse_inode(inode)->orig_ino)
+		return -EINVAL;
+
+	/* The backing filesystem caches the directory, don't cache it twice */
+	ff->open_flags &= ~FOPEN_CACHE_DIR;
+
+	return 0;
+}
+
 static int fuse_dir_open(struct inode *inode, struct file *file)
 {
 	struct fuse_mount *fm = get_fuse_mount(inode);
@@ -1660,6 +1696,14 @@ static int fuse_dir_open(struct inode *inode, struct file *file)
 		 */
 		if (ff->open_flags & (FOPEN_STREAM | FOPEN_NONSEEKABLE))
 			nonseekable_open(inode, file);
+
+		if (ff->open_flags & FOPEN_PASSTHROUGH) {
+			err = fuse_dir_passthrough_open(inode, file);
+			if (err) {
+				fuse_release_common(file, true);
+				err = -EIO;
+			}
+		}
 	}
 
 	return err;
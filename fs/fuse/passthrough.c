@@ -140,6 +140,117 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return backing_file_mmap(backing_file, vma, &ctx);
 }
 
+ssize_t fuse_passthrough_copy_file_range(struct file *file_in, loff_t pos_in,
+					 struct file *file_out, loff_t pos_out,
+					 size_t len, unsigned int flags)
+{
+	struct fuse_file *ff_in = file_in->private_data;
+	struct fuse_file *ff_out = file_out->private_data;
+	struct file *backing_in = fuse_file_passthrough(ff_in);
+	struct file *backing_out = fuse_file_passthrough(ff_out);
+	struct inode *inode_out = file_inode(file_out);
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	pr_debug("%s: backing_in=0x%p, pos_in=%lld, backing_out=0x%p, pos_out=%lld, len=%zu\n",
+		 __func__, backing_in, pos_in, backing_out, pos_out, len);
+
+	inode_lock(inode_out);
+	old_cred = override_creds(ff_out->cred);
+	ret = vfs_copy_file_range(backing_in, pos_in, backing_out, pos_out,
+				  len, flags);
+	revert_creds(old_cred);
+	inode_unlock(inode_out);
+
+	fuse_file_accessed(file_in);
+	if (ret > 0)
+		fuse_file_modified(file_out);
+
+	return ret;
+}
+
+struct fuse_passthrough_dir_ctx {
+	struct dir_context ctx;
+	struct dir_context *caller;
+	struct dentry *dir;
+};
+
+/*
+ * Report the inode numbers stat() sees on the fuse side: "." and ".." are
+ * the fuse directories, not the backing ones (which differ at the top of
+ * the backing tree), and entries already known to the fuse dcache use the
+ * number the server gave for them.
+ */
+static bool fuse_passthrough_filldir(struct dir_context *ctx, const char *name,
+				     int namelen, loff_t offset, u64 ino,
+				     unsigned int d_type)
+{
+	struct fuse_passthrough_dir_ctx *pctx =
+		container_of(ctx, struct fuse_passthrough_dir_ctx, ctx);
+	struct qstr qname = QSTR_INIT(name, namelen);
+	struct dentry *dir = pctx->dir;
+	struct dentry *child;
+
+	if (namelen == 1 && name[0] == '.') {
+		ino = get_fuse_inode(d_inode(dir))->orig_ino;
+	} else if (namelen == 2 && name[0] == '.' && name[1] == '.') {
+		child = dget_parent(dir);
+		ino = get_fuse_inode(d_inode(child))->orig_ino;
+		dput(child);
+	} else {
+		child = d_hash_and_lookup(dir, &qname);
+		if (!IS_ERR_OR_NULL(child)) {
+			if (d_really_is_positive(child))
+				ino = get_fuse_inode(d_inode(child))->orig_ino;
+			dput(child);
+		}
+	}
+
+	pctx->caller->pos = ctx->pos;
+	return pctx->caller->actor(pctx->caller, name, namelen, offset, ino,
+				   d_type);
+}
+
+/*
+ * Directory passthrough: entries are read from the backing directory, so the
+ * backing filesystem's own dcache and directory page cache serve repeated
+ * readdir instead of the server.  The fuse file position is authoritative and
+ * the backing file is repositioned when it got out of sync, e.g. after a seek.
+ */
+int fuse_passthrough_readdir(struct file *file, struct dir_context *ctx)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *backing_file = fuse_file_passthrough(ff);
+	struct fuse_passthrough_dir_ctx pctx = {
+		.ctx.actor = fuse_passthrough_filldir,
+		.ctx.pos = ctx->pos,
+		.caller = ctx,
+		.dir = file->f_path.dentry,
+	};
+	const struct cred *old_cred;
+	loff_t pos;
+	int ret;
+
+	pr_debug("%s: backing_file=0x%p, pos=%lld\n", __func__,
+		 backing_file, ctx->pos);
+
+	old_cred = override_creds(ff->cred);
+	if (backing_file->f_pos != ctx->pos) {
+		pos = vfs_llseek(backing_file, ctx->pos, SEEK_SET);
+		if (pos < 0) {
+			ret = pos;
+			goto out;
+		}
+	}
+	ret = iterate_dir(backing_file, &pctx.ctx);
+	ctx->pos = pctx.ctx.pos;
+out:
+	revert_creds(old_cred);
+	fuse_file_accessed(file);
+
+	return ret;
+}
+
 struct fuse_backing *fuse_backing_get(struct fuse_backing *fb)
 {
 	if (fb && refcount_inc_not_zero(&fb->count))
@@ -234,8 +345,12 @@ int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map)
 		goto out;
 
 	res = -EOPNOTSUPP;
-	if (!file->f_op->read_iter || !file->f_op->write_iter)
+	if (d_is_dir(file->f_path.dentry)) {
+		if (!file->f_op->iterate_shared)
+			goto out_fput;
+	} else if (!file->f_op->read_iter || !file->f_op->write_iter) {
 		goto out_fput;
+	}
 
 	backing_sb = file_inode(file)->i_sb;
 	res = -ELOOP;
@@ -15,6 +15,7 @@ struct mount;
 struct shrink_control;
 struct fs_context;
 struct pipe_inode_info;
+struct dirent_statx;
 struct iov_iter;
 struct mnt_idmap;
 
@@ -65,6 +66,9 @@ int do_linkat(int olddfd, struct filename *old, int newdfd,
 int vfs_tmpfile(struct mnt_idmap *idmap,
 		const struct path *parentpath,
 		struct file *file, umode_t mode);
+struct path_prefix_cache *alloc_path_prefix_cache(void);
+void free_path_prefix_cache(struct path_prefix_cache *cache);
+void path_prefix_cache_invalidate(struct dentry *dentry);
 
 /*
  * namespace.c
@@ -247,6 +251,15 @@ extern const struct dentry_operations ns_dentry_operations;
 int getname_statx_lookup_flags(int flags);
 int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	     unsigned int mask, struct statx __user *buffer);
+int statx_path_to_user(const struct path *path, unsigned int flags,
+		       unsigned int mask, struct statx __user *buffer);
+
+/*
+ * fs/readdir.c:
+ */
+int vfs_getdents_statx(struct file *file, struct dirent_statx __user *dirent,
+		       unsigned int count, unsigned int mask,
+		       unsigned int flags);
 
 /*
  * fs/splice.c:
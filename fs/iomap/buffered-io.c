@@ -156,7 +156,7 @@ static void iomap_clear_range_dirty(struct folio *folio, size_t off, size_t len)
 		ifs_clear_range_dirty(folio, ifs, off, len);
 }
 
-static void ifs_set_range_dirty(struct folio *folio,
+static void __ifs_set_range_dirty(struct folio *folio,
 		struct iomap_folio_state *ifs, size_t off, size_t len)
 {
 	struct inode *inode = folio->mapping->host;
@@ -164,10 +164,18 @@ static void ifs_set_range_dirty(struct folio *folio,
 	unsigned int first_blk = (off >> inode->i_blkbits);
 	unsigned int last_blk = (off + len - 1) >> inode->i_blkbits;
 	unsigned int nr_blks = last_blk - first_blk + 1;
+
+	lockdep_assert_held(&ifs->state_lock);
+	bitmap_set(ifs->state, first_blk + blks_per_folio, nr_blks);
+}
+
+static void ifs_set_range_dirty(struct folio *folio,
+		struct iomap_folio_state *ifs, size_t off, size_t len)
+{
 	unsigned long flags;
 
 	spin_lock_irqsave(&ifs->state_lock, flags);
-	bitmap_set(ifs->state, first_blk + blks_per_folio, nr_blks);
+	__ifs_set_range_dirty(folio, ifs, off, len);
 	spin_unlock_irqrestore(&ifs->state_lock, flags);
 }
 
@@ -179,6 +187,31 @@ static void iomap_set_range_dirty(struct folio *folio, size_t off, size_t len)
 		ifs_set_range_dirty(folio, ifs, off, len);
 }
 
+/*
+ * Mark @len bytes at @off uptodate and the first @copied of them dirty.  This
+ * is the buffered write completion path, which is hit once per folio per
+ * write, so both bitmaps are updated under a single ->state_lock round trip
+ * instead of one per bitmap.
+ */
+static void iomap_set_range_written(struct folio *folio, size_t off,
+		size_t len, size_t copied)
+{
+	struct iomap_folio_state *ifs = folio->private;
+	unsigned long flags;
+	bool uptodate = true;
+
+	if (ifs) {
+		spin_lock_irqsave(&ifs->state_lock, flags);
+		uptodate = ifs_set_range_uptodate(folio, ifs, off, len);
+		if (copied)
+			__ifs_set_range_dirty(folio, ifs, off, copied);
+		spin_unlock_irqrestore(&ifs->state_lock, flags);
+	}
+
+	if (uptodate && !folio_test_uptodate(folio))
+		folio_mark_uptodate(folio);
+}
+
 static struct iomap_folio_state *ifs_alloc(struct inode *inode,
 		struct folio *folio, unsigned int flags)
 {
@@ -847,8 +880,7 @@ static bool __iomap_write_end(struct inode *inode, loff_t pos, size_t len,
 	 */
 	if (unlikely(copied < len && !folio_test_uptodate(folio)))
 		return false;
-	iomap_set_range_uptodate(folio, offset_in_folio(folio, pos), len);
-	iomap_set_range_dirty(folio, offset_in_folio(folio, pos), copied);
+	iomap_set_range_written(folio, offset_in_folio(folio, pos), len, copied);
 	filemap_dirty_folio(inode->i_mapping, folio);
 	return true;
 }
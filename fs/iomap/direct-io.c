@@ -20,6 +20,7 @@
  * Private flags for iomap_dio, must not overlap with the public ones in
  * iomap.h:
  */
+#define IOMAP_DIO_NO_INVALIDATE	(1U << 25)
 #define IOMAP_DIO_CALLER_COMP	(1U << 26)
 #define IOMAP_DIO_INLINE_COMP	(1U << 27)
 #define IOMAP_DIO_WRITE_THROUGH	(1U << 28)
@@ -109,8 +110,12 @@ ssize_t iomap_dio_complete(struct iomap_dio *dio)
 	 * filesystems convert unwritten extents to real allocations in
 	 * ->end_io() when necessary, otherwise a racing buffer read would cache
 	 * zeros from unwritten extents.
+	 *
+	 * Writes completed from the bio end_io handler only get there when
+	 * nothing was cached, and must not sleep here.
 	 */
-	if (!dio->error && dio->size && (dio->flags & IOMAP_DIO_WRITE))
+	if (!dio->error && dio->size && (dio->flags & IOMAP_DIO_WRITE) &&
+	    !(dio->flags & IOMAP_DIO_NO_INVALIDATE))
 		kiocb_invalidate_post_direct_write(iocb, dio->size);
 
 	inode_dio_end(file_inode(iocb->ki_filp));
@@ -180,9 +185,17 @@ void iomap_dio_bio_end_io(struct bio *bio)
 	}
 
 	/*
-	 * Flagged with IOMAP_DIO_INLINE_COMP, we can complete it inline
+	 * Flagged with IOMAP_DIO_INLINE_COMP, we can complete it inline.
+	 * Writes additionally have to invalidate any page cache that was
+	 * instantiated over the range while the I/O was in flight, which may
+	 * block.  Those always go to the workqueue, only writes with nothing
+	 * cached are completed inline, and they skip the invalidation.
 	 */
-	if (dio->flags & IOMAP_DIO_INLINE_COMP) {
+	if ((dio->flags & IOMAP_DIO_INLINE_COMP) &&
+	    (!(dio->flags & IOMAP_DIO_WRITE) ||
+	     !iocb->ki_filp->f_mapping->nrpages)) {
+		if (dio->flags & IOMAP_DIO_WRITE)
+			dio->flags |= IOMAP_DIO_NO_INVALIDATE;
 		WRITE_ONCE(iocb->private, NULL);
 		iomap_dio_complete_work(&dio->aio.work);
 		goto release_bio;
@@ -345,6 +358,17 @@ static loff_t iomap_dio_bio_iter(const struct iomap_iter *iter,
 	    ((dio->flags & IOMAP_DIO_WRITE) && pos >= i_size_read(inode)))
 		dio->flags &= ~IOMAP_DIO_CALLER_COMP;
 
+	/*
+	 * Inline completion of writes runs ->end_io from the bio completion
+	 * handler, so on top of the above it also rules out COW remapping and
+	 * any size update at all, not just writes starting beyond EOF.
+	 */
+	if ((dio->flags & IOMAP_DIO_WRITE) &&
+	    (need_zeroout || (dio->flags & IOMAP_DIO_COW) ||
+	     ((dio->flags & IOMAP_DIO_NEED_SYNC) && !use_fua) ||
+	     pos + length > i_size_read(inode)))
+		dio->flags &= ~IOMAP_DIO_INLINE_COMP;
+
 	/*
 	 * The rules for polled IO completions follow the guidelines as the
 	 * ones we set for inline and deferred completions. If none of those
@@ -606,6 +630,15 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 		if (iocb->ki_flags & IOCB_DIO_CALLER_COMP)
 			dio->flags |= IOMAP_DIO_CALLER_COMP;
 
+		/*
+		 * Likewise, pure overwrites can be completed straight from
+		 * the bio end_io handler if the filesystem allows it.  This is
+		 * cleared again for any part of the write that needs more
+		 * work at completion time.
+		 */
+		if (dio_flags & IOMAP_DIO_INLINE_OVERWRITE)
+			dio->flags |= IOMAP_DIO_INLINE_COMP;
+
 		if (dio_flags & IOMAP_DIO_OVERWRITE_ONLY) {
 			ret = -EAGAIN;
 			if (iomi.pos >= dio->i_size ||
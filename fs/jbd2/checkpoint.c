@@ -117,6 +117,65 @@ __releases(&journal->j_state_lock)
 	}
 }
 
+/*
+ * Background checkpointing keeps at least this much of the log free, which
+ * is twice the threshold at which __jbd2_log_wait_for_space() makes new
+ * transactions wait.
+ */
+static inline int jbd2_bg_checkpoint_target(journal_t *journal)
+{
+	return journal->j_max_transaction_buffers * 2;
+}
+
+/*
+ * jbd2_log_kick_checkpoint: start background checkpointing if the log is
+ * filling up.  Called at the end of each commit.
+ */
+void jbd2_log_kick_checkpoint(journal_t *journal)
+{
+	bool low;
+
+	read_lock(&journal->j_state_lock);
+	low = jbd2_log_space_left(journal) < jbd2_bg_checkpoint_target(journal);
+	read_unlock(&journal->j_state_lock);
+
+	if (low && READ_ONCE(journal->j_checkpoint_transactions) &&
+	    !is_journal_aborted(journal))
+		queue_work(system_unbound_wq, &journal->j_checkpoint_work);
+}
+
+void jbd2_checkpoint_work(struct work_struct *work)
+{
+	journal_t *journal = container_of(work, journal_t, j_checkpoint_work);
+	bool low;
+
+	mutex_lock_io(&journal->j_checkpoint_mutex);
+	for (;;) {
+		if (is_journal_aborted(journal))
+			break;
+
+		read_lock(&journal->j_state_lock);
+		low = jbd2_log_space_left(journal) <
+			jbd2_bg_checkpoint_target(journal);
+		read_unlock(&journal->j_state_lock);
+		if (!low)
+			break;
+
+		spin_lock(&journal->j_list_lock);
+		if (!journal->j_checkpoint_transactions) {
+			spin_unlock(&journal->j_list_lock);
+			jbd2_cleanup_journal_tail(journal);
+			break;
+		}
+		spin_unlock(&journal->j_list_lock);
+
+		if (jbd2_log_do_checkpoint(journal) < 0)
+			break;
+		cond_resched();
+	}
+	mutex_unlock(&journal->j_checkpoint_mutex);
+}
+
 static void
 __flush_batch(journal_t *journal, int *batch_count)
 {
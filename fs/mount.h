@@ -5,6 +5,8 @@
 #include <linux/ns_common.h>
 #include <linux/fs_pin.h>
 
+struct path_prefix_cache;
+
 struct mnt_namespace {
 	struct ns_common	ns;
 	struct mount *	root;
@@ -16,6 +18,7 @@ struct mnt_namespace {
 	u64 event;
 	unsigned int		nr_mounts; /* # of mounts in the namespace */
 	unsigned int		pending_mounts;
+	struct path_prefix_cache *prefix_cache;	/* see fs/namei.c */
 } __randomize_layout;
 
 struct mnt_pcp {
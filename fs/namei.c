@@ -39,6 +39,7 @@
 #include <linux/hash.h>
 #include <linux/bitops.h>
 #include <linux/init_task.h>
+#include <linux/nsproxy.h>
 #include <linux/uaccess.h>
 
 #include "internal.h"
@@ -591,6 +592,8 @@ struct nameidata {
 #define ND_ROOT_PRESET 1
 #define ND_ROOT_GRABBED 2
 #define ND_JUMPED 4
+#define ND_PREFIX_HIT 8
+#define ND_PREFIX_NOCACHE 16
 
 static void __set_nameidata(struct nameidata *p, int dfd, struct filename *name)
 {
@@ -2238,6 +2241,333 @@ static inline u64 hash_name(const void *salt, const char *name)
 
 #endif
 
+/*
+ * Prefix cache for absolute pathwalks.
+ *
+ * Each mount namespace carries a small direct-mapped table that maps the
+ * directory part of an absolute pathname ("/usr/lib/gcc/x86_64/13/") to
+ * the directory it resolved to, along with every directory crossed on
+ * the way there and the ->d_seq each of them had.  RCU-walk consults it
+ * before starting on the components, which saves the hashing and dcache
+ * hash chain lookups for everything but the last component.
+ *
+ * A hit is only trusted if the mount tree hasn't changed since the entry
+ * was made (mount_lock), none of the recorded dentries has been moved,
+ * dropped or had its inode changed (->d_seq), the walk starts at the same
+ * root and the caller may still search every directory on the way, just
+ * as may_lookup() would have checked during a normal walk.  Anything that
+ * makes a prefix walk depend on more than that - symlinks, "..", scoped
+ * lookups, ->d_revalidate(), automount points - keeps it out of the cache.
+ *
+ * Entries hold no references to the dentries or mounts they record, so
+ * they never keep a deleted directory, an invalidated subtree or a
+ * superblock being unmounted alive.  Mounts are covered by mount_lock
+ * and RCU as usual.  Dentries get DCACHE_PREFIX_CACHED when recorded,
+ * and __dentry_kill() of such a dentry clears it and bumps the
+ * ->s_prefix_cache_gen of its superblock.  Every recorded dentry carries
+ * the generation of its superblock from before it was marked, and an
+ * entry is not dereferenced past a dentry whose superblock has moved on;
+ * an unchanged generation means the dentry is at worst being killed
+ * right now, which RCU-walk keeps from being freed.  The superblocks
+ * themselves stay around as long as the mount_lock sequence matches.
+ * So killing dentries on one filesystem leaves the entries that only go
+ * through others alone.  A dentry that has dropped out of every table
+ * still costs one bump when it goes.  An entry only gets filled after
+ * its slot has seen a miss for the same prefix twice in a row, so that
+ * a walk over many distinct directories doesn't keep marking dentries.
+ */
+#define PREFIX_CACHE_SLOTS	32
+#define PREFIX_CACHE_DEPTH	12
+#define PREFIX_CACHE_NAME	128
+
+struct prefix_step {
+	struct vfsmount	*mnt;	/* NULL for mountpoints, not searched */
+	struct dentry	*dentry;
+	struct super_block *sb;	/* ->d_sb of @dentry */
+	unsigned	seq;
+	unsigned int	gen;	/* ->s_prefix_cache_gen of @sb */
+};
+
+struct prefix_entry {
+	spinlock_t		lock;
+	seqcount_spinlock_t	seq;
+	bool			valid;
+	unsigned short		len, nr_steps;
+	unsigned int		hash, ghost;
+	unsigned		m_seq;
+	struct path		root;
+	struct path		path;
+	unsigned		path_seq;
+	unsigned int		path_gen;
+	/* from the parent of ->path up to ->root */
+	struct prefix_step	steps[PREFIX_CACHE_DEPTH];
+	char			name[PREFIX_CACHE_NAME];
+};
+
+struct path_prefix_cache {
+	struct prefix_entry	slots[PREFIX_CACHE_SLOTS];
+};
+
+struct path_prefix_cache *alloc_path_prefix_cache(void)
+{
+	struct path_prefix_cache *cache;
+	int i;
+
+	cache = kvzalloc(sizeof(*cache), GFP_KERNEL_ACCOUNT);
+	if (!cache)
+		return NULL;
+	for (i = 0; i < PREFIX_CACHE_SLOTS; i++) {
+		spin_lock_init(&cache->slots[i].lock);
+		seqcount_spinlock_init(&cache->slots[i].seq,
+				       &cache->slots[i].lock);
+	}
+	return cache;
+}
+
+void free_path_prefix_cache(struct path_prefix_cache *cache)
+{
+	kvfree(cache);
+}
+
+/*
+ * A dentry some table has recorded is being killed; called by
+ * __dentry_kill() with ->d_lock held, after the dentry was marked dead
+ * and before it is handed to RCU to be freed.
+ */
+void path_prefix_cache_invalidate(struct dentry *dentry)
+{
+	dentry->d_flags &= ~DCACHE_PREFIX_CACHED;
+	atomic_inc(&dentry->d_sb->s_prefix_cache_gen);
+}
+
+static inline unsigned int prefix_cache_gen(struct super_block *sb)
+{
+	return atomic_read(&sb->s_prefix_cache_gen);
+}
+
+static inline struct mnt_namespace *nd_mnt_ns(void)
+{
+	struct nsproxy *nsproxy = current->nsproxy;
+
+	return nsproxy ? nsproxy->mnt_ns : NULL;
+}
+
+/* length of everything up to the last component, trailing slash included */
+static unsigned int prefix_len(const char *s)
+{
+	unsigned int len = strlen(s);
+
+	while (len && s[len - 1] == '/')
+		len--;
+	while (len && s[len - 1] != '/')
+		len--;
+	return len;
+}
+
+/*
+ * Try to start an RCU-walk of absolute pathname @s in the directory its
+ * prefix resolved to last time.  Returns @s if there's no usable entry,
+ * otherwise the last component with nd->path set to its parent.
+ */
+static noinline const char *prefix_cache_lookup(struct nameidata *nd,
+						const char *s)
+{
+	struct mnt_namespace *ns = nd_mnt_ns();
+	struct path_prefix_cache *cache = ns ? ns->prefix_cache : NULL;
+	struct prefix_step steps[PREFIX_CACHE_DEPTH];
+	struct prefix_entry *e;
+	unsigned int len, hash, nr, seq, path_seq, path_gen;
+	struct inode *inode;
+	struct path path;
+
+	if (!cache || (nd->flags & (LOOKUP_IS_SCOPED | LOOKUP_NO_XDEV)))
+		return s;
+	len = prefix_len(s);
+	if (len <= 1 || len > PREFIX_CACHE_NAME)
+		return s;
+	hash = full_name_hash(cache, s, len);
+	e = &cache->slots[hash % PREFIX_CACHE_SLOTS];
+
+	seq = read_seqcount_begin(&e->seq);
+	if (!e->valid || e->hash != hash || e->len != len ||
+	    e->m_seq != nd->m_seq || !path_equal(&e->root, &nd->root) ||
+	    memcmp(e->name, s, len))
+		return s;
+	nr = min_t(unsigned int, e->nr_steps, PREFIX_CACHE_DEPTH);
+	memcpy(steps, e->steps, nr * sizeof(*steps));
+	path = e->path;
+	path_seq = e->path_seq;
+	path_gen = e->path_gen;
+	if (read_seqcount_retry(&e->seq, seq))
+		return s;
+
+	/* walk down from the root, checking what may_lookup() would */
+	while (nr--) {
+		struct prefix_step *step = &steps[nr];
+
+		/* the same mount_lock sequence keeps ->sb alive */
+		if (prefix_cache_gen(step->sb) != step->gen)
+			return s;
+		if (step->mnt) {
+			struct inode *dir = READ_ONCE(step->dentry->d_inode);
+
+			if (!dir || inode_permission(mnt_idmap(step->mnt), dir,
+						     MAY_EXEC | MAY_NOT_BLOCK))
+				return s;
+		}
+		if (read_seqcount_retry(&step->dentry->d_seq, step->seq))
+			return s;
+	}
+	if (prefix_cache_gen(path.mnt->mnt_sb) != path_gen)
+		return s;
+	inode = READ_ONCE(path.dentry->d_inode);
+	if (!inode || read_seqcount_retry(&path.dentry->d_seq, path_seq))
+		return s;
+
+	nd->path = path;
+	nd->inode = inode;
+	nd->seq = path_seq;
+	nd->state &= ~ND_JUMPED;
+	nd->state |= ND_PREFIX_HIT;
+	return s + len;
+}
+
+static bool prefix_step_add(struct prefix_step *steps, unsigned int *nr,
+			    struct vfsmount *mnt, struct dentry *dentry)
+{
+	struct prefix_step *step;
+
+	if (*nr == PREFIX_CACHE_DEPTH)
+		return false;
+	if (READ_ONCE(dentry->d_flags) & (DCACHE_OP_REVALIDATE |
+					  DCACHE_NEED_AUTOMOUNT |
+					  DCACHE_MANAGE_TRANSIT))
+		return false;
+	step = &steps[(*nr)++];
+	step->mnt = mnt;
+	step->dentry = dentry;
+	step->sb = dentry->d_sb;
+	step->seq = read_seqcount_begin(&dentry->d_seq);
+	/* a dropped dentry must not make it into the cache */
+	return IS_ROOT(dentry) || !d_unhashed(dentry);
+}
+
+/*
+ * Have __dentry_kill() of @dentry invalidate every entry that records it
+ * with generation @gen of its superblock; fails if it is already too late
+ * for that.  A kill that finds the flag set is seen by the lookup side as
+ * a generation change; one that got there first is seen here.
+ */
+static bool prefix_cache_mark(struct dentry *dentry, unsigned int *gen)
+{
+	bool alive;
+
+	*gen = prefix_cache_gen(dentry->d_sb);
+	spin_lock(&dentry->d_lock);
+	alive = !__lockref_is_dead(&dentry->d_lockref) &&
+		!(dentry->d_flags & DCACHE_NORCU);
+	if (alive)
+		dentry->d_flags |= DCACHE_PREFIX_CACHED;
+	spin_unlock(&dentry->d_lock);
+	return alive;
+}
+
+/*
+ * An absolute RCU-walk got to its last component without help from the
+ * cache; remember the directory it ended up in.
+ */
+static noinline void prefix_cache_record(struct nameidata *nd)
+{
+	struct mnt_namespace *ns = nd_mnt_ns();
+	struct path_prefix_cache *cache = ns ? ns->prefix_cache : NULL;
+	struct prefix_step steps[PREFIX_CACHE_DEPTH];
+	struct dentry *dentry = nd->path.dentry;
+	struct mount *mnt = real_mount(nd->path.mnt);
+	const char *s = nd->name->name;
+	struct prefix_entry *e;
+	unsigned int len, hash, path_gen, nr = 0, i;
+
+	if (!cache || nd->total_link_count ||
+	    (nd->state & (ND_PREFIX_HIT | ND_PREFIX_NOCACHE)) ||
+	    (nd->flags & (LOOKUP_IS_SCOPED | LOOKUP_NO_XDEV)))
+		return;
+	if (nd->last.name <= s || nd->last.name - s > PREFIX_CACHE_NAME)
+		return;
+	len = nd->last.name - s;
+	hash = full_name_hash(cache, s, len);
+	e = &cache->slots[hash % PREFIX_CACHE_SLOTS];
+	if (READ_ONCE(e->ghost) != hash) {
+		WRITE_ONCE(e->ghost, hash);
+		return;
+	}
+
+	if (READ_ONCE(dentry->d_flags) & (DCACHE_OP_REVALIDATE |
+					  DCACHE_NEED_AUTOMOUNT |
+					  DCACHE_MANAGE_TRANSIT))
+		return;
+	if (!IS_ROOT(dentry) && d_unhashed(dentry))
+		return;
+	if (read_seqcount_retry(&dentry->d_seq, nd->seq))
+		return;
+	if (READ_ONCE(mnt->mnt_ns) != ns)
+		return;
+	for (;;) {
+		struct dentry *parent;
+
+		if (dentry == nd->root.dentry && &mnt->mnt == nd->root.mnt)
+			break;
+		if (dentry == mnt->mnt.mnt_root) {
+			struct mount *m = READ_ONCE(mnt->mnt_parent);
+
+			if (m == mnt)
+				return;
+			dentry = READ_ONCE(mnt->mnt_mountpoint);
+			mnt = m;
+			if (dentry == mnt->mnt.mnt_root ||
+			    dentry == nd->root.dentry ||
+			    READ_ONCE(mnt->mnt_ns) != ns ||
+			    !prefix_step_add(steps, &nr, NULL, dentry))
+				return;
+		}
+		parent = READ_ONCE(dentry->d_parent);
+		if (parent == dentry)
+			return;
+		dentry = parent;
+		if (!prefix_step_add(steps, &nr, &mnt->mnt, dentry))
+			return;
+	}
+	if (nr < 2)
+		return;
+	/* the chain must be what the pathname resolved to */
+	if (read_seqretry(&rename_lock, nd->r_seq) ||
+	    read_seqretry(&mount_lock, nd->m_seq))
+		return;
+
+	/* ->root is the last step */
+	if (!prefix_cache_mark(nd->path.dentry, &path_gen))
+		return;
+	for (i = 0; i < nr; i++)
+		if (!prefix_cache_mark(steps[i].dentry, &steps[i].gen))
+			return;
+
+	if (!spin_trylock(&e->lock))
+		return;
+	write_seqcount_begin(&e->seq);
+	e->hash = hash;
+	e->len = len;
+	memcpy(e->name, s, len);
+	e->m_seq = nd->m_seq;
+	e->root = nd->root;
+	e->path = nd->path;
+	e->path_seq = nd->seq;
+	e->path_gen = path_gen;
+	memcpy(e->steps, steps, nr * sizeof(*steps));
+	e->nr_steps = nr;
+	e->valid = true;
+	write_seqcount_end(&e->seq);
+	spin_unlock(&e->lock);
+}
+
 /*
  * Name resolution.
  * This is the basic name resolution function, turning a pathname into
@@ -2255,6 +2585,8 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 	nd->flags |= LOOKUP_PARENT;
 	if (IS_ERR(name))
 		return PTR_ERR(name);
+	if (*name == '/' && name == nd->name->name && (nd->flags & LOOKUP_RCU))
+		name = prefix_cache_lookup(nd, name);
 	while (*name=='/')
 		name++;
 	if (!*name) {
@@ -2281,7 +2613,7 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 			case 2:
 				if (name[1] == '.') {
 					type = LAST_DOTDOT;
-					nd->state |= ND_JUMPED;
+					nd->state |= ND_JUMPED | ND_PREFIX_NOCACHE;
 				}
 				break;
 			case 1:
@@ -2318,6 +2650,9 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 OK:
 			/* pathname or trailing symlink, done */
 			if (!depth) {
+				if ((nd->flags & LOOKUP_RCU) &&
+				    *nd->name->name == '/')
+					prefix_cache_record(nd);
 				nd->dir_vfsuid = i_uid_into_vfsuid(idmap, nd->inode);
 				nd->dir_mode = nd->inode->i_mode;
 				nd->flags &= ~LOOKUP_PARENT;
@@ -2366,6 +2701,7 @@ static const char *path_init(struct nameidata *nd, unsigned flags)
 		nd->seq = nd->next_seq = 0;
 
 	nd->flags = flags;
+	nd->state &= ~(ND_PREFIX_HIT | ND_PREFIX_NOCACHE);
 	nd->state |= ND_JUMPED;
 
 	nd->m_seq = __read_seqcount_begin(&mount_lock.seqcount);
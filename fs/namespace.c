@@ -3706,6 +3706,7 @@ static void dec_mnt_namespaces(struct ucounts *ucounts)
 
 static void free_mnt_ns(struct mnt_namespace *ns)
 {
+	free_path_prefix_cache(ns->prefix_cache);
 	if (!is_anon_ns(ns))
 		ns_free_inum(&ns->ns);
 	dec_mnt_namespaces(ns->ucounts);
@@ -3753,6 +3754,9 @@ static struct mnt_namespace *alloc_mnt_ns(struct user_namespace *user_ns, bool a
 	init_waitqueue_head(&new_ns->poll);
 	new_ns->user_ns = get_user_ns(user_ns);
 	new_ns->ucounts = ucounts;
+	/* the walk prefix cache is an optimisation, carry on without it */
+	if (!anon)
+		new_ns->prefix_cache = alloc_path_prefix_cache();
 	return new_ns;
 }
 
@@ -944,6 +944,44 @@ nfsd4_lookup(struct svc_rqst *rqstp, struct nfsd4_compound_state *cstate,
 			   &cstate->current_fh);
 }
 
+/*
+ * Returns true if every operation following the current one in the
+ * COMPOUND leaves file data alone and has a small reply, which still
+ * fits in the head buffer after a spliced READ payload.
+ */
+static bool nfsd4_later_ops_splice_safe(struct svc_rqst *rqstp)
+{
+	struct nfsd4_compoundres *resp = rqstp->rq_resp;
+	struct nfsd4_compoundargs *argp = rqstp->rq_argp;
+	int i;
+
+	for (i = resp->opcnt; i < argp->opcnt; i++) {
+		struct nfsd4_op *op = &argp->ops[i];
+
+		switch (op->opnum) {
+		case OP_PUTFH:
+		case OP_PUTPUBFH:
+		case OP_PUTROOTFH:
+		case OP_SAVEFH:
+		case OP_RESTOREFH:
+		case OP_GETFH:
+		case OP_ACCESS:
+			break;
+		case OP_GETATTR:
+			/* these can be arbitrarily large */
+			if ((op->u.getattr.ga_bmval[0] &
+			     (FATTR4_WORD0_ACL | FATTR4_WORD0_FS_LOCATIONS)) ||
+			    (op->u.getattr.ga_bmval[2] &
+			     FATTR4_WORD2_SECURITY_LABEL))
+				return false;
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
 static __be32
 nfsd4_read(struct svc_rqst *rqstp, struct nfsd4_compound_state *cstate,
 	   union nfsd4_op_u *u)
@@ -968,9 +1006,10 @@ nfsd4_read(struct svc_rqst *rqstp, struct nfsd4_compound_state *cstate,
 	 * following compound.
 	 *
 	 * To ensure proper ordering, we therefore turn off zero copy if
-	 * the client wants us to do more in this compound:
+	 * the client wants us to do anything else in this compound but a
+	 * few ops that neither modify anything nor have large replies:
 	 */
-	if (!nfsd4_last_compound_op(rqstp)) {
+	if (!nfsd4_later_ops_splice_safe(rqstp)) {
 		struct nfsd4_compoundargs *argp = rqstp->rq_argp;
 
 		argp->splice_ok = false;
@@ -70,6 +70,11 @@ static __be32			nfsd_init_request(struct svc_rqst *,
  */
 DEFINE_MUTEX(nfsd_mutex);
 
+static unsigned int nfsd_max_dynamic_threads;
+module_param(nfsd_max_dynamic_threads, uint, 0644);
+MODULE_PARM_DESC(nfsd_max_dynamic_threads,
+		 "Threads each pool may start beyond the configured count when busy. Default: 0");
+
 /*
  * nfsd_drc_lock protects nfsd_drc_max_pages and nfsd_drc_pages_used.
  * nfsd_drc_max_pages limits the total amount of memory available for
@@ -902,6 +907,28 @@ nfsd_init_request(struct svc_rqst *rqstp,
 	return rpc_prog_mismatch;
 }
 
+/*
+ * Work was queued to this thread's pool while no thread was idle: start
+ * another one, within the nfsd_max_dynamic_threads allowance.  Idle extra
+ * threads are retired again by svc_recv().  Never wait for nfsd_mutex
+ * here, its holder may be waiting for this thread to exit.
+ */
+static void nfsd_grow_pool(struct svc_rqst *rqstp)
+{
+	struct svc_pool *pool = rqstp->rq_pool;
+
+	if (test_bit(RQ_VICTIM, &rqstp->rq_flags) ||
+	    !test_and_clear_bit(SP_NEED_THREAD, &pool->sp_flags))
+		return;
+	if (atomic_read(&pool->sp_nrthreads) >=
+	    READ_ONCE(pool->sp_nrthrmin) + READ_ONCE(nfsd_max_dynamic_threads))
+		return;
+	if (!mutex_trylock(&nfsd_mutex))
+		return;
+	svc_pool_grow(rqstp->rq_server, pool);
+	mutex_unlock(&nfsd_mutex);
+}
+
 /*
  * This is the NFS server kernel thread
  */
@@ -937,6 +964,7 @@ nfsd(void *vrqstp)
 		svc_recv(rqstp);
 
 		nfsd_file_net_dispose(nn);
+		nfsd_grow_pool(rqstp);
 	}
 
 	atomic_dec(&nfsd_th_cnt);
@@ -254,6 +254,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool copy_offload;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -281,6 +282,12 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	if (old_file->f_mode & FMODE_LSEEK)
 		skip_hole = true;
 
+	/*
+	 * Upper fs may be able to copy the data without moving it through
+	 * the page cache (e.g. server side copy), try that before splicing.
+	 */
+	copy_offload = new_file->f_op->copy_file_range != NULL;
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		ssize_t bytes;
@@ -331,9 +338,23 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 		if (error)
 			break;
 
-		bytes = do_splice_direct(old_file, &old_pos,
-					 new_file, &new_pos,
-					 this_len, SPLICE_F_MOVE);
+		bytes = 0;
+		if (copy_offload) {
+			bytes = vfs_copy_file_range(old_file, old_pos,
+						    new_file, new_pos,
+						    this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+			}
+			/* Splice the rest after a failure or a short copy */
+			if (bytes < (ssize_t)this_len)
+				copy_offload = false;
+		}
+		if (bytes <= 0)
+			bytes = do_splice_direct(old_file, &old_pos,
+						 new_file, &new_pos,
+						 this_len, SPLICE_F_MOVE);
 		if (bytes <= 0) {
 			error = bytes;
 			break;
@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0
 #include <linux/anon_inodes.h>
+#include <linux/cgroup.h>
+#include <linux/cred.h>
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/magic.h>
@@ -11,7 +13,13 @@
 #include <linux/proc_fs.h>
 #include <linux/proc_ns.h>
 #include <linux/pseudo_fs.h>
+#include <linux/ptrace.h>
+#include <linux/sched/cputime.h>
+#include <linux/sched/mm.h>
+#include <linux/sched/signal.h>
 #include <linux/seq_file.h>
+#include <linux/time_namespace.h>
+#include <linux/uaccess.h>
 #include <uapi/linux/pidfd.h>
 
 #include "internal.h"
@@ -108,8 +116,160 @@ static __poll_t pidfd_poll(struct file *file, struct poll_table_struct *pts)
 	return poll_flags;
 }
 
+static void pidfd_info_stats(struct task_struct *task, bool thread,
+			     struct pidfd_info *kinfo)
+{
+	unsigned long min_flt = 0, maj_flt = 0;
+	struct mm_struct *mm;
+	unsigned long flags;
+	u64 utime, stime;
+
+	if (thread) {
+		task_cputime_adjusted(task, &utime, &stime);
+		min_flt = task->min_flt;
+		maj_flt = task->maj_flt;
+	} else {
+		thread_group_cputime_adjusted(task, &utime, &stime);
+		if (lock_task_sighand(task, &flags)) {
+			struct signal_struct *sig = task->signal;
+			struct task_struct *t;
+
+			min_flt = sig->min_flt;
+			maj_flt = sig->maj_flt;
+			__for_each_thread(sig, t) {
+				min_flt += t->min_flt;
+				maj_flt += t->maj_flt;
+			}
+			unlock_task_sighand(task, &flags);
+		}
+	}
+
+	kinfo->utime = utime;
+	kinfo->stime = stime;
+	kinfo->min_flt = min_flt;
+	kinfo->maj_flt = maj_flt;
+	kinfo->nr_threads = thread ? 1 : get_nr_threads(task);
+	kinfo->start_boottime = timens_add_boottime_ns(task->start_boottime);
+
+	mm = get_task_mm(task);
+	if (mm) {
+		kinfo->vsize = (u64)mm->total_vm << PAGE_SHIFT;
+		kinfo->rss_anon = (u64)get_mm_counter(mm, MM_ANONPAGES) << PAGE_SHIFT;
+		kinfo->rss_file = (u64)get_mm_counter(mm, MM_FILEPAGES) << PAGE_SHIFT;
+		kinfo->rss_shmem = (u64)get_mm_counter(mm, MM_SHMEMPAGES) << PAGE_SHIFT;
+		kinfo->swap = (u64)get_mm_counter(mm, MM_SWAPENTS) << PAGE_SHIFT;
+		kinfo->rss_large = (u64)get_mm_counter(mm, MM_LARGEPAGES) << PAGE_SHIFT;
+		mmput(mm);
+	}
+}
+
+/*
+ * Fill a fixed binary record for the task a pidfd refers to. This is
+ * meant for monitoring agents that would otherwise format and re-parse
+ * /proc/<pid>/stat, status and smaps_rollup for every process.
+ */
+static long pidfd_info(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct pidfd_info __user *uinfo = (struct pidfd_info __user *)arg;
+	struct pid *pid = pidfd_pid(file);
+	bool thread = file->f_flags & PIDFD_THREAD;
+	size_t usize = _IOC_SIZE(cmd);
+	struct pidfd_info kinfo = {};
+	struct user_namespace *user_ns;
+	struct task_struct *task;
+	const struct cred *c;
+	__u64 mask;
+
+	BUILD_BUG_ON(sizeof(struct pidfd_info) != PIDFD_INFO_SIZE_VER1);
+
+	if (!uinfo)
+		return -EINVAL;
+	if (usize < PIDFD_INFO_SIZE_VER0)
+		return -EINVAL;
+	if (copy_from_user(&mask, &uinfo->mask, sizeof(mask)))
+		return -EFAULT;
+
+	task = get_pid_task(pid, PIDTYPE_PID);
+	if (!task)
+		return -ESRCH;
+
+	c = get_task_cred(task);
+	if (!c) {
+		put_task_struct(task);
+		return -ESRCH;
+	}
+
+	kinfo.mask |= PIDFD_INFO_CREDS;
+	user_ns = current_user_ns();
+	kinfo.ruid = from_kuid_munged(user_ns, c->uid);
+	kinfo.rgid = from_kgid_munged(user_ns, c->gid);
+	kinfo.euid = from_kuid_munged(user_ns, c->euid);
+	kinfo.egid = from_kgid_munged(user_ns, c->egid);
+	kinfo.suid = from_kuid_munged(user_ns, c->suid);
+	kinfo.sgid = from_kgid_munged(user_ns, c->sgid);
+	kinfo.fsuid = from_kuid_munged(user_ns, c->fsuid);
+	kinfo.fsgid = from_kgid_munged(user_ns, c->fsgid);
+	put_cred(c);
+
+#ifdef CONFIG_CGROUPS
+	if (mask & PIDFD_INFO_CGROUPID) {
+		struct cgroup *cgrp;
+
+		rcu_read_lock();
+		cgrp = task_dfl_cgroup(task);
+		kinfo.cgroupid = cgroup_id(cgrp);
+		kinfo.mask |= PIDFD_INFO_CGROUPID;
+		rcu_read_unlock();
+	}
+#endif
+
+	if ((mask & PIDFD_INFO_STATS) && usize >= PIDFD_INFO_SIZE_VER1 &&
+	    ptrace_may_access(task, PTRACE_MODE_READ_FSCREDS)) {
+		pidfd_info_stats(task, thread, &kinfo);
+		kinfo.mask |= PIDFD_INFO_STATS;
+	}
+
+	/*
+	 * Copy pid/tgid last to reduce the chances the information might be
+	 * stale. Note that it is not possible to ensure it will be valid as
+	 * the task might return as soon as the put_task_struct() below runs.
+	 */
+	kinfo.pid = task_pid_vnr(task);
+	kinfo.tgid = task_tgid_vnr(task);
+	kinfo.ppid = task_ppid_nr_ns(task, task_active_pid_ns(current));
+	kinfo.mask |= PIDFD_INFO_PID;
+	put_task_struct(task);
+
+	/* The task was reaped while we were looking at it. */
+	if (kinfo.pid == 0 || kinfo.tgid == 0)
+		return -ESRCH;
+
+	/* Older callers get the prefix they know, newer ones zeroed tail. */
+	if (copy_to_user(uinfo, &kinfo, min(usize, sizeof(kinfo))))
+		return -EFAULT;
+	if (usize > sizeof(kinfo) &&
+	    clear_user((void __user *)uinfo + sizeof(kinfo),
+		       usize - sizeof(kinfo)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long pidfd_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	/* The size is part of the command, match on type and number only. */
+	if (_IOC_TYPE(cmd) == _IOC_TYPE(PIDFD_GET_INFO) &&
+	    _IOC_NR(cmd) == _IOC_NR(PIDFD_GET_INFO) &&
+	    _IOC_DIR(cmd) == _IOC_DIR(PIDFD_GET_INFO))
+		return pidfd_info(file, cmd, arg);
+
+	return -ENOIOCTLCMD;
+}
+
 static const struct file_operations pidfs_file_operations = {
 	.poll		= pidfd_poll,
+	.unlocked_ioctl	= pidfd_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
 #ifdef CONFIG_PROC_FS
 	.show_fdinfo	= pidfd_show_fdinfo,
 #endif
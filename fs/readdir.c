@@ -21,9 +21,13 @@
 #include <linux/unistd.h>
 #include <linux/compat.h>
 #include <linux/uaccess.h>
+#include <linux/namei.h>
+#include <linux/slab.h>
 
 #include <asm/unaligned.h>
 
+#include "internal.h"
+
 /*
  * Some filesystems were never converted to '->iterate_shared()'
  * and their directory iterators want the inode lock held for
@@ -423,6 +427,203 @@ SYSCALL_DEFINE3(getdents64, unsigned int, fd,
 	return error;
 }
 
+/*
+ * Bulk directory read returning the attributes of each entry along with it.
+ *
+ * Entries found in the dcache are stat'ed from the actor, under the shared
+ * directory lock that iterate_dir() holds anyway, so a crawl over a hot tree
+ * costs neither a path walk nor a syscall per entry.  Entries that are not
+ * cached are looked up after the directory lock was dropped, just like a
+ * following statx() would do.
+ */
+struct getdents_statx_deferred {
+	struct list_head list;
+	struct statx __user *stx;
+	int namlen;
+	char name[];
+};
+
+struct getdents_statx_callback {
+	struct dir_context ctx;
+	struct dirent_statx __user *current_dir;
+	struct file *file;
+	struct list_head deferred;
+	unsigned int mask;
+	unsigned int flags;
+	int prev_reclen;
+	int count;
+	int error;
+};
+
+static int getdents_statx_path(struct getdents_statx_callback *buf,
+			       struct dentry *dentry, struct statx __user *stx)
+{
+	struct path path = { .mnt = buf->file->f_path.mnt, .dentry = dentry };
+	int error;
+
+	/* Leave stx_mask zero for anything a statx() would not resolve here */
+	if (!d_really_is_positive(dentry) || d_mountpoint(dentry))
+		return 0;
+
+	error = statx_path_to_user(&path, buf->flags, buf->mask, stx);
+	return error == -EFAULT ? error : 0;
+}
+
+static int getdents_statx_fill(struct getdents_statx_callback *buf,
+			       const char *name, int namlen,
+			       struct statx __user *stx)
+{
+	struct dentry *parent = buf->file->f_path.dentry;
+	struct getdents_statx_deferred *def;
+	struct dentry *dentry;
+	int error;
+
+	if (is_dot_dotdot(name, namlen)) {
+		if (namlen == 1)
+			return getdents_statx_path(buf, parent, stx);
+		return 0;
+	}
+
+	dentry = try_lookup_one_len(name, parent, namlen);
+	if (IS_ERR(dentry))
+		return 0;
+	if (dentry) {
+		error = getdents_statx_path(buf, dentry, stx);
+		dput(dentry);
+		return error;
+	}
+
+	def = kmalloc(struct_size(def, name, namlen + 1), GFP_KERNEL);
+	if (!def)
+		return 0;
+	def->stx = stx;
+	def->namlen = namlen;
+	memcpy(def->name, name, namlen);
+	def->name[namlen] = '\0';
+	list_add_tail(&def->list, &buf->deferred);
+	return 0;
+}
+
+static bool filldir_statx(struct dir_context *ctx, const char *name,
+			  int namlen, loff_t offset, u64 ino,
+			  unsigned int d_type)
+{
+	struct dirent_statx __user *dirent, *prev;
+	struct getdents_statx_callback *buf =
+		container_of(ctx, struct getdents_statx_callback, ctx);
+	int reclen = ALIGN(offsetof(struct dirent_statx, d_name) + namlen + 1,
+		sizeof(u64));
+	int prev_reclen;
+
+	buf->error = verify_dirent_name(name, namlen);
+	if (unlikely(buf->error))
+		return false;
+	buf->error = -EINVAL;	/* only used if we fail.. */
+	if (reclen > buf->count)
+		return false;
+	prev_reclen = buf->prev_reclen;
+	if (prev_reclen && signal_pending(current))
+		return false;
+	dirent = buf->current_dir;
+	prev = (void __user *)dirent - prev_reclen;
+	if (!user_write_access_begin(prev, reclen + prev_reclen))
+		goto efault;
+
+	/* This might be 'dirent->d_off', but if so it will get overwritten */
+	unsafe_put_user(offset, &prev->d_off, efault_end);
+	unsafe_put_user(ino, &dirent->d_ino, efault_end);
+	unsafe_put_user(reclen, &dirent->d_reclen, efault_end);
+	unsafe_put_user(d_type, &dirent->d_type, efault_end);
+	unsafe_put_user(0, &dirent->d_stx.stx_mask, efault_end);
+	unsafe_copy_dirent_name(dirent->d_name, name, namlen, efault_end);
+	user_write_access_end();
+
+	buf->error = getdents_statx_fill(buf, name, namlen, &dirent->d_stx);
+	if (unlikely(buf->error))
+		return false;
+
+	buf->prev_reclen = reclen;
+	buf->current_dir = (void __user *)dirent + reclen;
+	buf->count -= reclen;
+	return true;
+
+efault_end:
+	user_write_access_end();
+efault:
+	buf->error = -EFAULT;
+	return false;
+}
+
+/**
+ * vfs_getdents_statx - read directory entries along with their attributes
+ * @file:	directory to read from, at its current position
+ * @dirent:	user buffer receiving struct dirent_statx records
+ * @count:	size of @dirent in bytes
+ * @mask:	STATX_* attributes wanted for each entry
+ * @flags:	AT_STATX_* synchronisation flags
+ *
+ * Like getdents64(), returns the number of bytes filled in, 0 at the end of
+ * the directory, or a negative error.  The caller serializes against other
+ * users of the file position.
+ */
+int vfs_getdents_statx(struct file *file, struct dirent_statx __user *dirent,
+		       unsigned int count, unsigned int mask,
+		       unsigned int flags)
+{
+	struct getdents_statx_callback buf = {
+		.ctx.actor = filldir_statx,
+		.current_dir = dirent,
+		.file = file,
+		.mask = mask & ~STATX_CHANGE_COOKIE,
+		.flags = flags,
+		.count = count,
+	};
+	struct getdents_statx_deferred *def, *tmp;
+	int error;
+
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if ((flags & ~AT_STATX_SYNC_TYPE) ||
+	    (flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+
+	INIT_LIST_HEAD(&buf.deferred);
+
+	error = iterate_dir(file, &buf.ctx);
+	if (error >= 0)
+		error = buf.error;
+	if (buf.prev_reclen) {
+		struct dirent_statx __user *lastdirent;
+		typeof(lastdirent->d_off) d_off = buf.ctx.pos;
+
+		lastdirent = (void __user *) buf.current_dir - buf.prev_reclen;
+		if (put_user(d_off, &lastdirent->d_off))
+			error = -EFAULT;
+		else
+			error = count - buf.count;
+	}
+
+	/* Entries that missed the dcache, looked up without the dir lock */
+	list_for_each_entry_safe(def, tmp, &buf.deferred, list) {
+		struct dentry *dentry;
+
+		if (error >= 0) {
+			dentry = lookup_positive_unlocked(def->name,
+							  file->f_path.dentry,
+							  def->namlen);
+			if (!IS_ERR(dentry)) {
+				if (getdents_statx_path(&buf, dentry, def->stx))
+					error = -EFAULT;
+				dput(dentry);
+			}
+		}
+		list_del(&def->list);
+		kfree(def);
+	}
+
+	return error;
+}
+
 #ifdef CONFIG_COMPAT
 struct compat_old_linux_dirent {
 	compat_ulong_t	d_ino;
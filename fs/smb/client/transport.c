@@ -1024,7 +1024,10 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 {
 	uint index = 0;
 	unsigned int min_in_flight = UINT_MAX, max_in_flight = 0;
+	unsigned char candidates[CIFS_MAX_CHANNELS];
+	unsigned int nr_candidates = 0;
 	struct TCP_Server_Info *server = NULL;
+	bool have_credits = false;
 	int i;
 
 	if (!ses)
@@ -1032,6 +1035,8 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 
 	spin_lock(&ses->chan_lock);
 	for (i = 0; i < ses->chan_count; i++) {
+		unsigned int in_flight;
+
 		server = ses->chans[i].server;
 		if (!server || server->terminate)
 			continue;
@@ -1039,6 +1044,26 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 		if (CIFS_CHAN_NEEDS_RECONNECT(ses, i))
 			continue;
 
+		/*
+		 * A channel that is short of credits would block the request
+		 * until the server grants more, however lightly loaded it is:
+		 * smb2_wait_mtu_credits() keeps 8 credits in reserve before
+		 * it lets a large read or write through. Only consider such
+		 * channels if every channel is starved. Like in_flight below,
+		 * credits is read without req_lock; a stale value only costs
+		 * us a less than ideal choice.
+		 */
+		if (READ_ONCE(server->credits) > 8) {
+			if (!have_credits) {
+				have_credits = true;
+				min_in_flight = UINT_MAX;
+				max_in_flight = 0;
+				nr_candidates = 0;
+			}
+		} else if (have_credits) {
+			continue;
+		}
+
 		/*
 		 * strictly speaking, we should pick up req_lock to read
 		 * server->in_flight. But it shouldn't matter much here if we
@@ -1047,18 +1072,23 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 		 * taking the lock could help reduce wait time, which is
 		 * important for this function
 		 */
-		if (server->in_flight < min_in_flight) {
-			min_in_flight = server->in_flight;
+		in_flight = READ_ONCE(server->in_flight);
+		if (in_flight < min_in_flight) {
+			min_in_flight = in_flight;
 			index = i;
 		}
-		if (server->in_flight > max_in_flight)
-			max_in_flight = server->in_flight;
+		if (in_flight > max_in_flight)
+			max_in_flight = in_flight;
+		candidates[nr_candidates++] = i;
 	}
 
-	/* if all channels are equally loaded, fall back to round-robin */
-	if (min_in_flight == max_in_flight) {
+	/*
+	 * if all usable channels are equally loaded, fall back to
+	 * round-robin among them
+	 */
+	if (nr_candidates > 1 && min_in_flight == max_in_flight) {
 		index = (uint)atomic_inc_return(&ses->chan_seq);
-		index %= ses->chan_count;
+		index = candidates[index % nr_candidates];
 	}
 
 	server = ses->chans[index].server;
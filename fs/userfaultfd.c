@@ -1217,20 +1217,25 @@ static ssize_t userfaultfd_read_iter(struct kiocb *iocb, struct iov_iter *to)
 }
 
 static void __wake_userfault(struct userfaultfd_ctx *ctx,
-			     struct userfaultfd_wake_range *range)
+			     struct userfaultfd_wake_range *ranges, int nr)
 {
+	int i;
+
 	spin_lock_irq(&ctx->fault_pending_wqh.lock);
-	/* wake all in the range and autoremove */
-	if (waitqueue_active(&ctx->fault_pending_wqh))
-		__wake_up_locked_key(&ctx->fault_pending_wqh, TASK_NORMAL,
-				     range);
-	if (waitqueue_active(&ctx->fault_wqh))
-		__wake_up(&ctx->fault_wqh, TASK_NORMAL, 1, range);
+	for (i = 0; i < nr; i++) {
+		/* wake all in the range and autoremove */
+		if (waitqueue_active(&ctx->fault_pending_wqh))
+			__wake_up_locked_key(&ctx->fault_pending_wqh,
+					     TASK_NORMAL, &ranges[i]);
+		if (waitqueue_active(&ctx->fault_wqh))
+			__wake_up(&ctx->fault_wqh, TASK_NORMAL, 1, &ranges[i]);
+	}
 	spin_unlock_irq(&ctx->fault_pending_wqh.lock);
 }
 
-static __always_inline void wake_userfault(struct userfaultfd_ctx *ctx,
-					   struct userfaultfd_wake_range *range)
+static __always_inline void wake_userfault_vec(struct userfaultfd_ctx *ctx,
+					       struct userfaultfd_wake_range *ranges,
+					       int nr)
 {
 	unsigned seq;
 	bool need_wakeup;
@@ -1257,7 +1262,13 @@ static __always_inline void wake_userfault(struct userfaultfd_ctx *ctx,
 		cond_resched();
 	} while (read_seqcount_retry(&ctx->refile_seq, seq));
 	if (need_wakeup)
-		__wake_userfault(ctx, range);
+		__wake_userfault(ctx, ranges, nr);
+}
+
+static __always_inline void wake_userfault(struct userfaultfd_ctx *ctx,
+					   struct userfaultfd_wake_range *range)
+{
+	wake_userfault_vec(ctx, range, 1);
 }
 
 static __always_inline int validate_unaligned_range(
@@ -1691,6 +1702,27 @@ static int userfaultfd_wake(struct userfaultfd_ctx *ctx,
 	return ret;
 }
 
+static int userfaultfd_copy_validate(struct userfaultfd_ctx *ctx,
+				     struct uffdio_copy *uffdio_copy,
+				     uffd_flags_t *flags)
+{
+	int ret;
+
+	ret = validate_unaligned_range(ctx->mm, uffdio_copy->src,
+				       uffdio_copy->len);
+	if (ret)
+		return ret;
+	ret = validate_range(ctx->mm, uffdio_copy->dst, uffdio_copy->len);
+	if (ret)
+		return ret;
+
+	if (uffdio_copy->mode & ~(UFFDIO_COPY_MODE_DONTWAKE|UFFDIO_COPY_MODE_WP))
+		return -EINVAL;
+	if (uffdio_copy->mode & UFFDIO_COPY_MODE_WP)
+		*flags |= MFILL_ATOMIC_WP;
+	return 0;
+}
+
 static int userfaultfd_copy(struct userfaultfd_ctx *ctx,
 			    unsigned long arg)
 {
@@ -1712,19 +1744,10 @@ static int userfaultfd_copy(struct userfaultfd_ctx *ctx,
 			   sizeof(uffdio_copy)-sizeof(__s64)))
 		goto out;
 
-	ret = validate_unaligned_range(ctx->mm, uffdio_copy.src,
-				       uffdio_copy.len);
-	if (ret)
-		goto out;
-	ret = validate_range(ctx->mm, uffdio_copy.dst, uffdio_copy.len);
+	ret = userfaultfd_copy_validate(ctx, &uffdio_copy, &flags);
 	if (ret)
 		goto out;
 
-	ret = -EINVAL;
-	if (uffdio_copy.mode & ~(UFFDIO_COPY_MODE_DONTWAKE|UFFDIO_COPY_MODE_WP))
-		goto out;
-	if (uffdio_copy.mode & UFFDIO_COPY_MODE_WP)
-		flags |= MFILL_ATOMIC_WP;
 	if (mmget_not_zero(ctx->mm)) {
 		ret = mfill_atomic_copy(ctx, uffdio_copy.dst, uffdio_copy.src,
 					uffdio_copy.len, flags);
@@ -1748,6 +1771,103 @@ static int userfaultfd_copy(struct userfaultfd_ctx *ctx,
 	return ret;
 }
 
+/* Number of entries copied in and woken up together */
+#define UFFDIO_COPY_VEC_BATCH	64
+
+static int userfaultfd_copy_vec(struct userfaultfd_ctx *ctx,
+				unsigned long arg)
+{
+	struct uffdio_copy_vec uffdio_copy_vec;
+	struct uffdio_copy_vec __user *user_uffdio_copy_vec;
+	struct uffdio_copy __user *user_vec;
+	struct userfaultfd_wake_range *ranges = NULL;
+	struct uffdio_copy *vec = NULL;
+	unsigned long batch, done = 0;
+	int ret;
+
+	user_uffdio_copy_vec = (struct uffdio_copy_vec __user *) arg;
+
+	ret = -EAGAIN;
+	if (atomic_read(&ctx->mmap_changing))
+		goto out;
+
+	ret = -EFAULT;
+	if (copy_from_user(&uffdio_copy_vec, user_uffdio_copy_vec,
+			   /* don't copy "done" last field */
+			   sizeof(uffdio_copy_vec)-sizeof(__s64)))
+		goto out;
+
+	ret = -EINVAL;
+	if (!uffdio_copy_vec.nr || uffdio_copy_vec.nr > UFFDIO_COPY_VEC_MAX)
+		goto out;
+	user_vec = u64_to_user_ptr(uffdio_copy_vec.vec);
+
+	ret = -ENOMEM;
+	batch = min_t(u64, uffdio_copy_vec.nr, UFFDIO_COPY_VEC_BATCH);
+	vec = kmalloc_array(batch, sizeof(*vec), GFP_KERNEL);
+	ranges = kmalloc_array(batch, sizeof(*ranges), GFP_KERNEL);
+	if (!vec || !ranges)
+		goto out;
+
+	if (!mmget_not_zero(ctx->mm)) {
+		ret = -ESRCH;
+		goto out;
+	}
+
+	ret = 0;
+	while (!ret && done < uffdio_copy_vec.nr) {
+		int i, n, nr_wake = 0;
+
+		n = min_t(u64, uffdio_copy_vec.nr - done, batch);
+		if (copy_from_user(vec, user_vec + done, n * sizeof(*vec))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			uffd_flags_t flags = 0;
+			__s64 copied;
+
+			ret = userfaultfd_copy_validate(ctx, &vec[i], &flags);
+			if (ret)
+				break;
+			copied = mfill_atomic_copy(ctx, vec[i].dst, vec[i].src,
+						   vec[i].len, flags);
+			if (unlikely(put_user(copied, &user_vec[done].copy))) {
+				ret = -EFAULT;
+				break;
+			}
+			if (copied < 0) {
+				ret = copied;
+				break;
+			}
+			/* len == 0 would wake all */
+			if (!(vec[i].mode & UFFDIO_COPY_MODE_DONTWAKE)) {
+				ranges[nr_wake].start = vec[i].dst;
+				ranges[nr_wake].len = copied;
+				nr_wake++;
+			}
+			if (copied != vec[i].len) {
+				ret = -EAGAIN;
+				break;
+			}
+			done++;
+		}
+
+		if (nr_wake)
+			wake_userfault_vec(ctx, ranges, nr_wake);
+		cond_resched();
+	}
+	mmput(ctx->mm);
+
+	if (unlikely(put_user(done, &user_uffdio_copy_vec->done)))
+		ret = -EFAULT;
+out:
+	kfree(ranges);
+	kfree(vec);
+	return ret;
+}
+
 static int userfaultfd_zeropage(struct userfaultfd_ctx *ctx,
 				unsigned long arg)
 {
@@ -2142,6 +2262,9 @@ static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 	case UFFDIO_POISON:
 		ret = userfaultfd_poison(ctx, arg);
 		break;
+	case UFFDIO_COPY_VEC:
+		ret = userfaultfd_copy_vec(ctx, arg);
+		break;
 	}
 	return ret;
 }
@@ -75,9 +75,11 @@ xfs_buf_is_vmapped(
 	 *
 	 * b_addr is null if the buffer is not mapped, but the code is clever
 	 * enough to know it doesn't have to map a single page, so the check has
-	 * to be both for b_addr and bp->b_page_count > 1.
+	 * to be both for b_addr and bp->b_page_count > 1.  A buffer backed by
+	 * a single high-order folio is directly addressable and never vmapped.
 	 */
-	return bp->b_addr && bp->b_page_count > 1;
+	return bp->b_addr && bp->b_page_count > 1 &&
+		!(bp->b_flags & _XBF_FOLIO);
 }
 
 static inline int
@@ -289,16 +291,20 @@ xfs_buf_free_pages(
 	if (xfs_buf_is_vmapped(bp))
 		vm_unmap_ram(bp->b_addr, bp->b_page_count);
 
-	for (i = 0; i < bp->b_page_count; i++) {
-		if (bp->b_pages[i])
-			__free_page(bp->b_pages[i]);
+	if (bp->b_flags & _XBF_FOLIO) {
+		folio_put(page_folio(bp->b_pages[0]));
+	} else {
+		for (i = 0; i < bp->b_page_count; i++) {
+			if (bp->b_pages[i])
+				__free_page(bp->b_pages[i]);
+		}
 	}
 	mm_account_reclaimed_pages(bp->b_page_count);
 
 	if (bp->b_pages != bp->b_page_array)
 		kfree(bp->b_pages);
 	bp->b_pages = NULL;
-	bp->b_flags &= ~_XBF_PAGES;
+	bp->b_flags &= ~(_XBF_PAGES | _XBF_FOLIO);
 }
 
 static void
@@ -387,6 +393,27 @@ xfs_buf_alloc_pages(
 	if (!(flags & XBF_READ))
 		gfp_mask |= __GFP_ZERO;
 
+	/*
+	 * Multi-page buffers (directory and attr blocks mostly) are best
+	 * backed by a single folio: it is addressable without vm_map_ram(),
+	 * so we avoid the vmap setup and the TLB flushes of tearing it down
+	 * again.  Don't try hard though, a page array works just as well.
+	 */
+	if (bp->b_page_count > 1) {
+		struct folio	*folio;
+		long		i;
+
+		folio = folio_alloc(gfp_mask | __GFP_NORETRY,
+				    get_order(bp->b_page_count << PAGE_SHIFT));
+		if (folio) {
+			for (i = 0; i < bp->b_page_count; i++)
+				bp->b_pages[i] = folio_page(folio, i);
+			bp->b_flags |= _XBF_FOLIO;
+			XFS_STATS_INC(bp->b_mount, xb_page_found);
+			return 0;
+		}
+	}
+
 	/*
 	 * Bulk filling of pages can take multiple calls. Not filling the entire
 	 * array is not an allocation failure, so don't back off if we get at
@@ -425,8 +452,8 @@ _xfs_buf_map_pages(
 	xfs_buf_flags_t		flags)
 {
 	ASSERT(bp->b_flags & _XBF_PAGES);
-	if (bp->b_page_count == 1) {
-		/* A single page buffer is always mappable */
+	if (bp->b_page_count == 1 || (bp->b_flags & _XBF_FOLIO)) {
+		/* A single page or folio buffer is always mappable */
 		bp->b_addr = page_address(bp->b_pages[0]);
 	} else if (flags & XBF_UNMAPPED) {
 		bp->b_addr = NULL;
@@ -582,7 +609,7 @@ xfs_buf_find_lock(
 			return -ENOENT;
 		}
 		ASSERT((bp->b_flags & _XBF_DELWRI_Q) == 0);
-		bp->b_flags &= _XBF_KMEM | _XBF_PAGES;
+		bp->b_flags &= _XBF_KMEM | _XBF_PAGES | _XBF_FOLIO;
 		bp->b_ops = NULL;
 	}
 	return 0;
@@ -593,7 +593,8 @@ xfs_file_dio_write_aligned(
 	}
 	trace_xfs_file_direct_write(iocb, from);
 	ret = iomap_dio_rw(iocb, from, &xfs_direct_write_iomap_ops,
-			   &xfs_dio_write_ops, 0, NULL, 0);
+			   &xfs_dio_write_ops, IOMAP_DIO_INLINE_OVERWRITE,
+			   NULL, 0);
 out_unlock:
 	if (iolock)
 		xfs_iunlock(ip, iolock);
@@ -1411,6 +1411,9 @@ xlog_ioend_work(
  * Return size of each in-core log record buffer.
  *
  * All machines get 8 x 32kB buffers by default, unless tuned otherwise.
+ * V2 logs on non-rotational devices that are big enough get 8 x 256kB
+ * buffers instead: each CIL checkpoint then needs far fewer iclog writes
+ * and the pipelined pushes can keep more log I/O in flight.
  *
  * If the filesystem blocksize is too large, we may need to choose a
  * larger size since the directory code currently logs entire blocks.
@@ -1422,8 +1425,15 @@ xlog_get_iclog_buffer_size(
 {
 	if (mp->m_logbufs <= 0)
 		mp->m_logbufs = XLOG_MAX_ICLOGS;
-	if (mp->m_logbsize <= 0)
-		mp->m_logbsize = XLOG_BIG_RECORD_BSIZE;
+	if (mp->m_logbsize <= 0) {
+		if (xfs_has_logv2(mp) &&
+		    bdev_nonrot(log->l_targ->bt_bdev) &&
+		    BBTOB((int64_t)log->l_logBBsize) >=
+				64LL * mp->m_logbufs * XLOG_MAX_RECORD_BSIZE)
+			mp->m_logbsize = XLOG_MAX_RECORD_BSIZE;
+		else
+			mp->m_logbsize = XLOG_BIG_RECORD_BSIZE;
+	}
 
 	log->l_iclog_bufs = mp->m_logbufs;
 	log->l_iclog_size = mp->m_logbsize;
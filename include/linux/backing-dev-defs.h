@@ -115,6 +115,7 @@ struct bdi_writeback {
 	spinlock_t list_lock;		/* protects the b_* lists */
 
 	atomic_t writeback_inodes;	/* number of inodes under writeback */
+	atomic_t bg_helpers;		/* extra background flushers running */
 	struct percpu_counter stat[NR_WB_STAT_ITEMS];
 
 	unsigned long bw_time_stamp;	/* last time write bw is updated */
@@ -171,6 +172,7 @@ struct backing_dev_info {
 	unsigned int capabilities; /* Device capabilities */
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
+	unsigned int wb_workers;	/* flushers per wb for background writeback */
 
 	/*
 	 * Sum of avg_write_bw of wbs with dirty inodes.  > 0 if there are
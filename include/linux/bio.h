@@ -413,6 +413,7 @@ enum {
 	BIOSET_NEED_BVECS = BIT(0),
 	BIOSET_NEED_RESCUER = BIT(1),
 	BIOSET_PERCPU_CACHE = BIT(2),
+	BIOSET_CACHE_ALL = BIT(3),
 };
 extern int bioset_init(struct bio_set *, unsigned int, unsigned int, int flags);
 extern void bioset_exit(struct bio_set *);
@@ -701,6 +702,11 @@ struct bio_set {
 #endif
 
 	unsigned int back_pad;
+	/*
+	 * Use the per-cpu cache for all task context allocations, not only for
+	 * those passing REQ_ALLOC_CACHE
+	 */
+	bool cache_all;
 	/*
 	 * Deadlock avoidance for stacking block drivers: see comments in
 	 * bio_alloc_bioset() for details
@@ -137,6 +137,7 @@ struct request {
 #endif
 
 	enum rw_hint write_hint;
+	u8 write_stream;
 	unsigned short ioprio;
 
 	enum mq_rq_state state;
@@ -748,6 +749,12 @@ struct blk_mq_tags {
 	 * request pool
 	 */
 	spinlock_t lock;
+
+	/* per-CPU caches of free bitmap_tags, see blk_mq_tag_cache_get() */
+	struct blk_mq_tag_cache __percpu *cache;
+	/* CPUs whose cache may hold tags */
+	cpumask_var_t cache_cpus;
+	unsigned int cache_batch;
 };
 
 static inline struct request *blk_mq_tag_to_rq(struct blk_mq_tags *tags,
@@ -853,12 +860,7 @@ static inline bool blk_mq_add_to_batch(struct request *req,
 				       struct io_comp_batch *iob, int ioerror,
 				       void (*complete)(struct io_comp_batch *))
 {
-	/*
-	 * blk_mq_end_request_batch() can't end request allocated from
-	 * sched tags
-	 */
-	if (!iob || (req->rq_flags & RQF_SCHED_TAGS) || ioerror ||
-			(req->end_io && !blk_rq_is_passthrough(req)))
+	if (!iob || ioerror || (req->end_io && !blk_rq_is_passthrough(req)))
 		return false;
 
 	if (!iob->complete)
@@ -321,6 +321,13 @@ struct queue_limits {
 	unsigned int		max_open_zones;
 	unsigned int		max_active_zones;
 
+	/*
+	 * Number of device write streams (data placement handles), numbered
+	 * from 1, and the size of the reclaim unit backing each of them.
+	 */
+	unsigned short		max_write_streams;
+	unsigned int		write_stream_granularity;
+
 	/*
 	 * Drivers that set dma_alignment to less than 511 must be prepared to
 	 * handle individual bvec's that are not a multiple of a SECTOR_SIZE
@@ -432,6 +439,8 @@ struct request_queue {
 	struct blk_queue_stats	*stats;
 	struct rq_qos		*rq_qos;
 	struct mutex		rq_qos_mutex;
+	/* QoS policies that need wbt off, bits are enum wbt_qos_owner */
+	unsigned long		wbt_qos_off;
 
 	/*
 	 * ida allocated id for this queue.  Used to index queues from
@@ -980,8 +989,12 @@ void blk_mark_disk_dead(struct gendisk *disk);
  * or when attempting a merge. For details, please see schedule() where
  * blk_flush_plug() is called.
  */
+#define BLK_PLUG_HASH_BITS	3
+
 struct blk_plug {
 	struct request *mq_list; /* blk-mq requests */
+	/* mq_list requests hashed by end sector, for back merges */
+	struct hlist_head merge_hash[1 << BLK_PLUG_HASH_BITS];
 
 	/* if ios_left is > 1, we can batch tag/rq allocations */
 	struct request *cached_rq;
@@ -1278,6 +1291,13 @@ bdev_max_secure_erase_sectors(struct block_device *bdev)
 	return bdev_get_queue(bdev)->limits.max_secure_erase_sectors;
 }
 
+static inline unsigned short bdev_max_write_streams(struct block_device *bdev)
+{
+	if (bdev_is_partition(bdev))
+		return 0;
+	return bdev_get_queue(bdev)->limits.max_write_streams;
+}
+
 static inline unsigned int bdev_write_zeroes_sectors(struct block_device *bdev)
 {
 	struct request_queue *q = bdev_get_queue(bdev);
@@ -586,6 +586,8 @@ extern void ceph_osdc_put_request(struct ceph_osd_request *req);
 
 void ceph_osdc_start_request(struct ceph_osd_client *osdc,
 			     struct ceph_osd_request *req);
+void ceph_osdc_start_requests(struct ceph_osd_client *osdc,
+			      struct list_head *reqs);
 extern void ceph_osdc_cancel_request(struct ceph_osd_request *req);
 extern int ceph_osdc_wait_request(struct ceph_osd_client *osdc,
 				  struct ceph_osd_request *req);
@@ -105,6 +105,8 @@ struct damon_target {
  * @DAMOS_NOHUGEPAGE:	Call ``madvise()`` for the region with MADV_NOHUGEPAGE.
  * @DAMOS_LRU_PRIO:	Prioritize the region on its LRU lists.
  * @DAMOS_LRU_DEPRIO:	Deprioritize the region on its LRU lists.
+ * @DAMOS_MIGRATE_HOT:	Migrate the region to a faster memory tier.
+ * @DAMOS_MIGRATE_COLD:	Migrate the region to a slower memory tier.
  * @DAMOS_STAT:		Do nothing but count the stat.
  * @NR_DAMOS_ACTIONS:	Total number of DAMOS actions
  *
@@ -112,7 +114,8 @@ struct damon_target {
  * &enum DAMON_OPS_VADDR and &enum DAMON_OPS_FVADDR supports all actions except
  * &enum DAMOS_LRU_PRIO and &enum DAMOS_LRU_DEPRIO.  &enum DAMON_OPS_PADDR
  * supports only &enum DAMOS_PAGEOUT, &enum DAMOS_LRU_PRIO, &enum
- * DAMOS_LRU_DEPRIO, and &DAMOS_STAT.
+ * DAMOS_LRU_DEPRIO, &enum DAMOS_MIGRATE_HOT, &enum DAMOS_MIGRATE_COLD, and
+ * &DAMOS_STAT.
  */
 enum damos_action {
 	DAMOS_WILLNEED,
@@ -122,6 +125,8 @@ enum damos_action {
 	DAMOS_NOHUGEPAGE,
 	DAMOS_LRU_PRIO,
 	DAMOS_LRU_DEPRIO,
+	DAMOS_MIGRATE_HOT,
+	DAMOS_MIGRATE_COLD,
 	DAMOS_STAT,		/* Do nothing but only record the stat */
 	NR_DAMOS_ACTIONS,
 };
@@ -372,6 +377,7 @@ struct damos_access_pattern {
  * @pattern:		Access pattern of target regions.
  * @action:		&damo_action to be applied to the target regions.
  * @apply_interval_us:	The time between applying the @action.
+ * @target_nid:		Destination node of &DAMOS_MIGRATE_{HOT,COLD}.
  * @quota:		Control the aggressiveness of this scheme.
  * @wmarks:		Watermarks for automated (in)activation of this scheme.
  * @filters:		Additional set of &struct damos_filter for &action.
@@ -384,6 +390,10 @@ struct damos_access_pattern {
  *
  * If @apply_interval_us is zero, &damon_attrs->aggr_interval is used instead.
  *
+ * If @target_nid is %NUMA_NO_NODE, &DAMOS_MIGRATE_COLD migrates to the
+ * demotion target of each page's node, and &DAMOS_MIGRATE_HOT migrates the
+ * pages of lower tier nodes to their nearest top tier node.
+ *
  * To do the work only when needed, schemes can be activated for specific
  * system situations using &wmarks.  If all schemes that registered to the
  * monitoring context are inactive, DAMON stops monitoring either, and just
@@ -401,6 +411,7 @@ struct damos {
 	struct damos_access_pattern pattern;
 	enum damos_action action;
 	unsigned long apply_interval_us;
+	int target_nid;
 /* private: internal use only */
 	/*
 	 * number of sample intervals that should be passed before applying
@@ -422,12 +433,15 @@ struct damos {
  * @DAMON_OPS_FVADDR:	Monitoring operations for only fixed ranges of virtual
  *			address spaces
  * @DAMON_OPS_PADDR:	Monitoring operations for the physical address space
+ * @DAMON_OPS_PSAMPLE:	Monitoring operations for the physical address space
+ *			using hardware memory access samples
  * @NR_DAMON_OPS:	Number of monitoring operations implementations
  */
 enum damon_ops_id {
 	DAMON_OPS_VADDR,
 	DAMON_OPS_FVADDR,
 	DAMON_OPS_PADDR,
+	DAMON_OPS_PSAMPLE,
 	NR_DAMON_OPS,
 };
 
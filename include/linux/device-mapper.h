@@ -397,6 +397,15 @@ struct dm_target {
 	 * bio_set_dev(). NOTE: ideally a target should _not_ need this.
 	 */
 	bool needs_bio_set_dev:1;
+
+	/*
+	 * Set if the map function only remaps a normal bio, that does not
+	 * cross a max_io_len boundary, to a single underlying device and
+	 * returns DM_MAPIO_REMAPPED, without using per-bio data or
+	 * dm_accept_partial_bio(). Tables made of such targets only are
+	 * served by a shorter submission path.
+	 */
+	bool simple_remap:1;
 };
 
 void *dm_per_bio_data(struct bio *bio, size_t data_size);
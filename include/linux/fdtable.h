@@ -30,6 +30,7 @@ struct fdtable {
 	unsigned long *close_on_exec;
 	unsigned long *open_fds;
 	unsigned long *full_fds_bits;
+	unsigned long *resize_dirty;	/* see expand_fdtable() */
 	struct rcu_head rcu;
 };
 
@@ -31,6 +31,7 @@
 #include <linux/uidgid.h>
 #include <linux/lockdep.h>
 #include <linux/percpu-rwsem.h>
+#include <linux/percpu_counter.h>
 #include <linux/workqueue.h>
 #include <linux/delayed_call.h>
 #include <linux/uuid.h>
@@ -366,6 +367,7 @@ struct kiocb {
 	void			*private;
 	int			ki_flags;
 	u16			ki_ioprio; /* See linux/ioprio.h */
+	u8			ki_write_stream;
 	union {
 		/*
 		 * Only used for async buffered reads, where it denotes the
@@ -955,6 +957,9 @@ struct fown_struct {
  *      the first of these pages is accessed.
  * @ra_pages: Maximum size of a readahead request, copied from the bdi.
  * @mmap_miss: How many mmap accesses missed in the page cache.
+ * @order: Folio order that recent readahead windows were able to use.
+ *      Later windows ramp up from here, even after a non-sequential read.
+ * @min_order: Minimum folio order requested with POSIX_FADV_HUGEPAGE.
  * @prev_pos: The last byte in the most recent read request.
  *
  * When this structure is passed to ->readahead(), the "most recent"
@@ -966,6 +971,8 @@ struct file_ra_state {
 	unsigned int async_size;
 	unsigned int ra_pages;
 	unsigned int mmap_miss;
+	unsigned short order;
+	unsigned short min_order;
 	loff_t prev_pos;
 };
 
@@ -1301,6 +1308,9 @@ struct super_block {
 	/* Number of inodes with nlink == 0 but still referenced */
 	atomic_long_t s_remove_count;
 
+	/* Kills of dentries recorded by a pathwalk prefix cache, fs/namei.c */
+	atomic_t s_prefix_cache_gen;
+
 	/* Read-only state of the superblock is being changed */
 	int s_readonly_remount;
 
@@ -1325,6 +1335,8 @@ struct super_block {
 	 */
 	struct list_lru		s_dentry_lru;
 	struct list_lru		s_inode_lru;
+	/* Unused negative dentries on s_dentry_lru */
+	struct percpu_counter	s_nr_dentry_negative;
 	struct rcu_head		rcu;
 	struct work_struct	destroy_work;
 
@@ -2288,6 +2300,7 @@ static inline void kiocb_clone(struct kiocb *kiocb, struct kiocb *kiocb_src,
 		.ki_filp = filp,
 		.ki_flags = kiocb_src->ki_flags,
 		.ki_ioprio = kiocb_src->ki_ioprio,
+		.ki_write_stream = kiocb_src->ki_write_stream,
 		.ki_pos = kiocb_src->ki_pos,
 	};
 }
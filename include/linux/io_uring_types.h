@@ -208,6 +208,12 @@ struct io_submit_state {
 	bool			cq_flush;
 	unsigned short		submit_nr;
 	struct blk_plug		plug;
+
+	/* file references taken once per batch, see io_file_get_batched() */
+	struct file		*file;
+	int			file_fd;
+	unsigned int		file_refs;
+	unsigned int		ios_left;
 };
 
 struct io_ev_fd {
@@ -225,6 +231,12 @@ struct io_alloc_cache {
 	size_t			elem_size;
 };
 
+/* io-wq work run on the submitter's NUMA node vs. a remote one */
+struct io_iowq_stats {
+	unsigned long			local_work;
+	unsigned long			remote_work;
+};
+
 struct io_ring_ctx {
 	/* const or read-mostly hot data */
 	struct {
@@ -286,6 +298,11 @@ struct io_ring_ctx {
 		 */
 		bool			poll_multi_queue;
 		struct io_wq_work_list	iopoll_list;
+		/*
+		 * Estimated completion time in nsec for IORING_SETUP_HYBRID_IOPOLL,
+		 * LLONG_MAX until the first completion has been seen.
+		 */
+		u64			hybrid_poll_time;
 
 		struct io_file_table	file_table;
 		struct io_mapped_ubuf	**user_bufs;
@@ -401,6 +418,7 @@ struct io_ring_ctx {
 
 	/* io-wq management, e.g. thread count */
 	u32				iowq_limits[2];
+	struct io_iowq_stats __percpu	*iowq_stats;
 
 	struct callback_head		poll_wq_task_work;
 	struct list_head		defer_list;
@@ -413,6 +431,11 @@ struct io_ring_ctx {
 	unsigned int		napi_busy_poll_to;
 	bool			napi_prefer_busy_poll;
 	bool			napi_enabled;
+	u8			napi_track_mode;
+	u16			napi_busy_poll_budget;
+
+	/* app registered NAPI ids, protected by ->uring_lock and RCU */
+	struct io_napi_static __rcu *napi_static;
 
 	DECLARE_HASHTABLE(napi_ht, 4);
 #endif
@@ -428,6 +451,12 @@ struct io_ring_ctx {
 	unsigned short			n_sqe_pages;
 	struct page			**ring_pages;
 	struct page			**sqe_pages;
+
+	/* registered wait arguments, see IORING_REGISTER_CQWAIT_REG */
+	struct io_uring_reg_wait	*cq_wait_arg;
+	unsigned			cq_wait_reg_nr;
+	unsigned short			n_cq_wait_pages;
+	struct page			**cq_wait_pages;
 };
 
 struct io_tw_state {
@@ -472,6 +501,7 @@ enum {
 	REQ_F_BL_EMPTY_BIT,
 	REQ_F_BL_NO_RECYCLE_BIT,
 	REQ_F_BUFFERS_COMMIT_BIT,
+	REQ_F_IOPOLL_STATE_BIT,
 
 	/* not a real bit, just to check we're not overflowing the space */
 	__REQ_F_LAST_BIT,
@@ -552,6 +582,8 @@ enum {
 	REQ_F_BL_NO_RECYCLE	= IO_REQ_FLAG(REQ_F_BL_NO_RECYCLE_BIT),
 	/* buffer ring head needs incrementing on put */
 	REQ_F_BUFFERS_COMMIT	= IO_REQ_FLAG(REQ_F_BUFFERS_COMMIT_BIT),
+	/* hybrid iopoll already slept for this request */
+	REQ_F_IOPOLL_STATE	= IO_REQ_FLAG(REQ_F_IOPOLL_STATE_BIT),
 };
 
 typedef void (*io_req_tw_func_t)(struct io_kiocb *req, struct io_tw_state *ts);
@@ -649,8 +681,12 @@ struct io_kiocb {
 	atomic_t			refs;
 	bool				cancel_seq_set;
 	struct io_task_work		io_task_work;
-	/* for polled requests, i.e. IORING_OP_POLL_ADD and async armed poll */
-	struct hlist_node		hash_node;
+	union {
+		/* for polled requests, i.e. IORING_OP_POLL_ADD and async armed poll */
+		struct hlist_node	hash_node;
+		/* for IOPOLL setup queues, with hybrid polling */
+		u64			iopoll_start;
+	};
 	/* internal polling, see IORING_FEAT_FAST_POLL */
 	struct async_poll		*apoll;
 	/* opcode allocated if it needs to store data for async defer */
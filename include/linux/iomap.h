@@ -393,6 +393,14 @@ struct iomap_dio_ops {
  */
 #define IOMAP_DIO_PARTIAL		(1 << 2)
 
+/*
+ * The filesystem's ->end_io handler does not block for writes that neither
+ * cover unwritten or shared extents nor extend the file, so such pure
+ * overwrites may be completed directly from the bio completion handler
+ * instead of being punted to a workqueue.
+ */
+#define IOMAP_DIO_INLINE_OVERWRITE	(1 << 3)
+
 ssize_t iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 		const struct iomap_ops *ops, const struct iomap_dio_ops *dops,
 		unsigned int dio_flags, void *private, size_t done_before);
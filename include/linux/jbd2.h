@@ -865,6 +865,15 @@ struct journal_s
 	 */
 	struct mutex		j_checkpoint_mutex;
 
+	/**
+	 * @j_checkpoint_work:
+	 *
+	 * Background checkpointing, kicked at the end of a commit when the
+	 * log is more than half full so that new transactions rarely have
+	 * to checkpoint synchronously in __jbd2_log_wait_for_space().
+	 */
+	struct work_struct	j_checkpoint_work;
+
 	/**
 	 * @j_chkpt_bhs:
 	 *
@@ -1647,6 +1656,8 @@ int jbd2_log_do_checkpoint(journal_t *journal);
 int jbd2_trans_will_send_data_barrier(journal_t *journal, tid_t tid);
 
 void __jbd2_log_wait_for_space(journal_t *journal);
+void jbd2_log_kick_checkpoint(journal_t *journal);
+void jbd2_checkpoint_work(struct work_struct *work);
 extern void __jbd2_journal_drop_transaction(journal_t *, transaction_t *);
 extern int jbd2_cleanup_journal_tail(journal_t *);
 
@@ -347,6 +347,9 @@ struct kvm_vcpu {
 	sigset_t sigset;
 	unsigned int halt_poll_ns;
 	bool valid_wakeup;
+	/* log2 histogram of recent halt durations, see kvm_vcpu_halt() */
+	u8 halt_hist[HALT_POLL_HIST_COUNT];
+	u8 halt_hist_nr;
 
 #ifdef CONFIG_HAS_IOMEM
 	int mmio_needed;
@@ -1943,6 +1946,7 @@ struct _kvm_stats_desc {
 	STATS_DESC_COUNTER(VCPU_GENERIC, halt_successful_poll),		       \
 	STATS_DESC_COUNTER(VCPU_GENERIC, halt_attempted_poll),		       \
 	STATS_DESC_COUNTER(VCPU_GENERIC, halt_poll_invalid),		       \
+	STATS_DESC_COUNTER(VCPU_GENERIC, halt_poll_skipped),		       \
 	STATS_DESC_COUNTER(VCPU_GENERIC, halt_wakeup),			       \
 	STATS_DESC_TIME_NSEC(VCPU_GENERIC, halt_poll_success_ns),	       \
 	STATS_DESC_TIME_NSEC(VCPU_GENERIC, halt_poll_fail_ns),		       \
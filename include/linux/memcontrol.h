@@ -300,6 +300,9 @@ struct mem_cgroup {
 
 	struct memcg_vmstats_percpu __percpu *vmstats_percpu;
 
+	/* Page fault latency histograms, with cgroup.memory=faultlatency */
+	struct memcg_fault_latency __percpu *fault_latency;
+
 #ifdef CONFIG_CGROUP_WRITEBACK
 	struct list_head cgwb_list;
 	struct wb_domain cgwb_domain;
@@ -319,6 +322,12 @@ struct mem_cgroup {
 	struct lru_gen_mm_list mm_list;
 #endif
 
+#ifdef CONFIG_LRU_GEN
+	/* proactive aging, see lru_gen_set_aging_interval() */
+	struct delayed_work lru_gen_aging_work;
+	unsigned int lru_gen_aging_ms;
+#endif
+
 	struct mem_cgroup_per_node *nodeinfo[];
 };
 
@@ -696,7 +705,7 @@ int mem_cgroup_hugetlb_try_charge(struct mem_cgroup *memcg, gfp_t gfp,
 
 int mem_cgroup_swapin_charge_folio(struct folio *folio, struct mm_struct *mm,
 				  gfp_t gfp, swp_entry_t entry);
-void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry);
+void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry, unsigned int nr_pages);
 
 void __mem_cgroup_uncharge(struct folio *folio);
 
@@ -1026,6 +1035,8 @@ unsigned long lruvec_page_state_local(struct lruvec *lruvec,
 				      enum node_stat_item idx);
 
 void mem_cgroup_flush_stats(struct mem_cgroup *memcg);
+void mem_cgroup_flush_stats_bounded(struct mem_cgroup *memcg,
+				    unsigned int max_age_ms);
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg);
 
 void __mod_lruvec_kmem_state(void *p, enum node_stat_item idx, int val);
@@ -1078,6 +1089,26 @@ static inline void count_memcg_event_mm(struct mm_struct *mm,
 	rcu_read_unlock();
 }
 
+DECLARE_STATIC_KEY_FALSE(memcg_fault_latency_key);
+
+void __mem_cgroup_account_fault_latency(struct mm_struct *mm, bool anon,
+		unsigned int flags, vm_fault_t ret, u64 start);
+
+/* Returns the start time of a fault, 0 if fault latencies aren't tracked */
+static inline u64 mem_cgroup_fault_latency_start(void)
+{
+	if (static_branch_unlikely(&memcg_fault_latency_key))
+		return ktime_get_ns();
+	return 0;
+}
+
+static inline void mem_cgroup_account_fault_latency(struct mm_struct *mm,
+		bool anon, unsigned int flags, vm_fault_t ret, u64 start)
+{
+	if (start)
+		__mem_cgroup_account_fault_latency(mm, anon, flags, ret, start);
+}
+
 static inline void memcg_memory_event(struct mem_cgroup *memcg,
 				      enum memcg_memory_event event)
 {
@@ -1242,7 +1273,8 @@ static inline int mem_cgroup_swapin_charge_folio(struct folio *folio,
 	return 0;
 }
 
-static inline void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry)
+static inline void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry,
+						   unsigned int nr_pages)
 {
 }
 
@@ -1529,6 +1561,11 @@ static inline void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 {
 }
 
+static inline void mem_cgroup_flush_stats_bounded(struct mem_cgroup *memcg,
+						  unsigned int max_age_ms)
+{
+}
+
 static inline void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 }
@@ -1571,6 +1608,16 @@ void count_memcg_event_mm(struct mm_struct *mm, enum vm_event_item idx)
 {
 }
 
+static inline u64 mem_cgroup_fault_latency_start(void)
+{
+	return 0;
+}
+
+static inline void mem_cgroup_account_fault_latency(struct mm_struct *mm,
+		bool anon, unsigned int flags, vm_fault_t ret, u64 start)
+{
+}
+
 static inline void split_page_memcg(struct page *head, int old_order, int new_order)
 {
 }
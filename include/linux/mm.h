@@ -2367,6 +2367,7 @@ extern void pagefault_out_of_memory(void);
 struct zap_details {
 	struct folio *single_folio;	/* Locked folio to be unmapped */
 	bool even_cows;			/* Zap COWed private pages too? */
+	bool reclaim_pt;		/* Free PTE tables left empty? */
 	zap_flags_t zap_flags;		/* Extra flags for zapping */
 };
 
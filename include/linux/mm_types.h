@@ -826,6 +826,14 @@ struct mm_struct {
 		 */
 		unsigned long mm_cid_next_scan;
 #endif
+#ifdef CONFIG_SCHED_CACHE
+		/* Recent runtime of the tasks of the mm on each CPU */
+		struct mm_sched __percpu *pcpu_sched;
+		/* When the preferred CPU is next recomputed (in jiffies) */
+		unsigned long mm_sched_scan;
+		/* A CPU in the LLC the tasks of the mm ran most on, or -1 */
+		int mm_sched_cpu;
+#endif
 #ifdef CONFIG_MMU
 		atomic_long_t pgtables_bytes;	/* size of all page tables */
 #endif
@@ -1197,6 +1205,33 @@ static inline unsigned int mm_cid_size(void)
 }
 #endif /* CONFIG_SCHED_MM_CID */
 
+#ifdef CONFIG_SCHED_CACHE
+struct mm_sched {
+	u64 runtime;
+	unsigned long epoch;
+};
+
+static inline int mm_alloc_sched_noprof(struct mm_struct *mm)
+{
+	mm->pcpu_sched = alloc_percpu_noprof(struct mm_sched);
+	if (!mm->pcpu_sched)
+		return -ENOMEM;
+	mm->mm_sched_scan = jiffies;
+	mm->mm_sched_cpu = -1;
+	return 0;
+}
+#define mm_alloc_sched(...)	alloc_hooks(mm_alloc_sched_noprof(__VA_ARGS__))
+
+static inline void mm_destroy_sched(struct mm_struct *mm)
+{
+	free_percpu(mm->pcpu_sched);
+	mm->pcpu_sched = NULL;
+}
+#else /* CONFIG_SCHED_CACHE */
+static inline int mm_alloc_sched(struct mm_struct *mm) { return 0; }
+static inline void mm_destroy_sched(struct mm_struct *mm) { }
+#endif /* CONFIG_SCHED_CACHE */
+
 struct mmu_gather;
 extern void tlb_gather_mmu(struct mmu_gather *tlb, struct mm_struct *mm);
 extern void tlb_gather_mmu_fullmm(struct mmu_gather *tlb, struct mm_struct *mm);
@@ -30,6 +30,7 @@ enum {
 	MM_ANONPAGES,	/* Resident anonymous pages */
 	MM_SWAPENTS,	/* Anonymous swap entries */
 	MM_SHMEMPAGES,	/* Resident shared memory pages */
+	MM_LARGEPAGES,	/* Of the above, pages mapped from large folios */
 	NR_MM_COUNTERS
 };
 
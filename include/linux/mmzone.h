@@ -413,6 +413,13 @@ enum {
 #define NR_HIST_GENS		1U
 #endif
 
+/*
+ * The refault distance of a folio is the number of generations evicted after
+ * this folio and before its refault. The last bucket also covers all longer
+ * distances.
+ */
+#define NR_REFAULT_DISTS	8U
+
 /*
  * The youngest generation number is stored in max_seq for both anon and file
  * types as they are aged on an equal footing. The oldest generation numbers are
@@ -446,6 +453,8 @@ struct lru_gen_folio {
 	/* can be modified without holding the LRU lock */
 	atomic_long_t evicted[NR_HIST_GENS][ANON_AND_FILE][MAX_NR_TIERS];
 	atomic_long_t refaulted[NR_HIST_GENS][ANON_AND_FILE][MAX_NR_TIERS];
+	/* refaults by distance, decayed by half on each aging */
+	atomic_long_t refault_dist[ANON_AND_FILE][NR_REFAULT_DISTS];
 	/* whether the multi-gen LRU is enabled */
 	bool enabled;
 	/* the memcg generation this lru_gen_folio belongs to */
@@ -565,6 +574,8 @@ void lru_gen_online_memcg(struct mem_cgroup *memcg);
 void lru_gen_offline_memcg(struct mem_cgroup *memcg);
 void lru_gen_release_memcg(struct mem_cgroup *memcg);
 void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid);
+int lru_gen_set_aging_interval(struct mem_cgroup *memcg, unsigned int msecs);
+unsigned long lru_gen_memcg_wss(struct mem_cgroup *memcg);
 
 #else /* !CONFIG_LRU_GEN */
 
@@ -657,14 +668,21 @@ enum zone_watermarks {
  * One per migratetype for each PAGE_ALLOC_COSTLY_ORDER. Two additional lists
  * are added for THP. One PCP list is used by GPF_MOVABLE, and the other PCP list
  * is used by GFP_UNMOVABLE and GFP_RECLAIMABLE.
+ *
+ * mTHP orders above PAGE_ALLOC_COSTLY_ORDER up to PCP_MTHP_MAX_ORDER (and
+ * below the PMD order) get the same two lists per order.
  */
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 #define NR_PCP_THP 2
+#define PCP_MTHP_MAX_ORDER 8
+#define NR_PCP_MTHP_ORDERS (PCP_MTHP_MAX_ORDER - PAGE_ALLOC_COSTLY_ORDER)
 #else
 #define NR_PCP_THP 0
+#define NR_PCP_MTHP_ORDERS 0
 #endif
+#define NR_PCP_MTHP (NR_PCP_MTHP_ORDERS * 2)
 #define NR_LOWORDER_PCP_LISTS (MIGRATE_PCPTYPES * (PAGE_ALLOC_COSTLY_ORDER + 1))
-#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_THP)
+#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP + NR_PCP_THP)
 
 #define min_wmark_pages(z) (z->_watermark[WMARK_MIN] + z->watermark_boost)
 #define low_wmark_pages(z) (z->_watermark[WMARK_LOW] + z->watermark_boost)
@@ -699,6 +717,10 @@ struct per_cpu_pages {
 	u8 expire;		/* When 0, remote pagesets are drained */
 #endif
 	short free_count;	/* consecutive free count */
+#if NR_PCP_MTHP_ORDERS
+	/* per mTHP order batch scaling factor during allocate */
+	u8 mthp_alloc_factor[NR_PCP_MTHP_ORDERS];
+#endif
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[NR_PCP_LISTS];
@@ -343,6 +343,16 @@ struct gro_list {
 /*
  * Structure for NAPI scheduling similar to tasklet but with weighting
  */
+/*
+ * NAPI settings of one queue of a device; they survive the napi_struct
+ * instances that come and go with that queue, e.g. across a ring resize.
+ */
+struct napi_config {
+	u32			defer_hard_irqs;
+	unsigned long		gro_flush_timeout;
+	unsigned long		irq_suspend_timeout;
+};
+
 struct napi_struct {
 	/* The poll_list must only be managed by the entity which
 	 * changes the state of the NAPI_STATE_SCHED bit.  This means
@@ -355,7 +365,14 @@ struct napi_struct {
 	unsigned long		state;
 	int			weight;
 	int			defer_hard_irqs_count;
+	u32			defer_hard_irqs;
+	unsigned long		gro_flush_timeout;
+	unsigned long		irq_suspend_timeout;
+	struct napi_config	*config;
 	unsigned long		gro_bitmask;
+	/* GRO effectiveness: skbs offered to GRO, and how many were merged */
+	unsigned long		gro_packets;
+	unsigned long		gro_merged;
 	int			(*poll)(struct napi_struct *, int);
 #ifdef CONFIG_NETPOLL
 	/* CPU actively polling if netpoll is configured */
@@ -388,6 +405,7 @@ enum {
 	NAPI_STATE_PREFER_BUSY_POLL,	/* prefer busy-polling over softirq processing*/
 	NAPI_STATE_THREADED,		/* The poll is performed inside its own thread*/
 	NAPI_STATE_SCHED_THREADED,	/* Napi is currently scheduled in threaded mode */
+	NAPI_STATE_THREADED_BUSY_POLL,	/* The napi thread busy polls, irqs stay off */
 };
 
 enum {
@@ -401,6 +419,14 @@ enum {
 	NAPIF_STATE_PREFER_BUSY_POLL	= BIT(NAPI_STATE_PREFER_BUSY_POLL),
 	NAPIF_STATE_THREADED		= BIT(NAPI_STATE_THREADED),
 	NAPIF_STATE_SCHED_THREADED	= BIT(NAPI_STATE_SCHED_THREADED),
+	NAPIF_STATE_THREADED_BUSY_POLL	= BIT(NAPI_STATE_THREADED_BUSY_POLL),
+};
+
+/* Values of net_device->threaded, as written to /sys/class/net/<dev>/threaded */
+enum netdev_napi_threaded {
+	NETDEV_NAPI_THREADED_DISABLED,
+	NETDEV_NAPI_THREADED_ENABLED,
+	NETDEV_NAPI_THREADED_BUSY_POLL,
 };
 
 enum gro_result {
@@ -549,7 +575,8 @@ static inline bool napi_complete(struct napi_struct *n)
 	return napi_complete_done(n, 0);
 }
 
-int dev_set_threaded(struct net_device *dev, bool threaded);
+int dev_set_threaded(struct net_device *dev,
+		      enum netdev_napi_threaded threaded);
 
 /**
  *	napi_disable - prevent NAPI from scheduling
@@ -1762,6 +1789,7 @@ enum netdev_reg_state {
  *	@state:		Generic network queuing layer state, see netdev_state_t
  *	@dev_list:	The global list of network devices
  *	@napi_list:	List entry used for polling NAPI devices
+ *	@napi_config:	Per-queue NAPI settings, see netif_napi_add_config()
  *	@unreg_list:	List entry  when we are unregistering the
  *			device; see the function unregister_netdev
  *	@close_list:	List entry used when we are closing the device
@@ -1987,7 +2015,7 @@ enum netdev_reg_state {
  *
  *	@wol_enabled:	Wake-on-LAN is enabled
  *
- *	@threaded:	napi threaded mode is enabled
+ *	@threaded:	napi threaded mode, see enum netdev_napi_threaded
  *
  *	@net_notifier_list:	List of per-net netdev notifier block
  *				that follow this device when it is moved
@@ -2123,6 +2151,7 @@ struct net_device {
 
 	struct list_head	dev_list;
 	struct list_head	napi_list;
+	struct napi_config	*napi_config;
 	struct list_head	unreg_list;
 	struct list_head	close_list;
 	struct list_head	ptype_all;
@@ -2371,7 +2400,7 @@ struct net_device {
 	struct sfp_bus		*sfp_bus;
 	struct lock_class_key	*qdisc_tx_busylock;
 	bool			proto_down;
-	bool			threaded;
+	u8			threaded;
 	unsigned		wol_enabled:1;
 
 	struct list_head	net_notifier_list;
@@ -2621,6 +2650,9 @@ static inline void netif_napi_set_irq(struct napi_struct *napi, int irq)
 
 void netif_napi_add_weight(struct net_device *dev, struct napi_struct *napi,
 			   int (*poll)(struct napi_struct *, int), int weight);
+void netif_napi_add_config(struct net_device *dev, struct napi_struct *napi,
+			   int (*poll)(struct napi_struct *, int),
+			   unsigned int index);
 
 /**
  * netif_napi_add() - initialize a NAPI context
@@ -3209,6 +3241,13 @@ struct softnet_data {
 #endif
 
 	unsigned int		received_rps;
+#ifdef CONFIG_RPS
+	/* RFS steering decisions made by this cpu, see get_rps_cpu() */
+	unsigned int		rfs_hit;	/* delivered to the desired cpu */
+	unsigned int		rfs_miss;	/* no sock flow entry, used RPS */
+	unsigned int		rfs_switch;	/* flow moved to the desired cpu */
+	unsigned int		rfs_held;	/* kept on old cpu for ordering */
+#endif
 	bool			in_net_rx_action;
 	bool			in_napi_threaded_poll;
 
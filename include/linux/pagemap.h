@@ -209,6 +209,8 @@ enum mapping_flags {
 	AS_STABLE_WRITES,	/* must wait for writeback before modifying
 				   folio contents */
 	AS_UNMOVABLE,		/* The mapping cannot be moved, ever */
+	AS_WRITEBACK_INDETERMINATE, /* Writeback may not complete in a
+				   bounded time, e.g. a userspace server */
 };
 
 /**
@@ -309,6 +311,21 @@ static inline void mapping_clear_stable_writes(struct address_space *mapping)
 	clear_bit(AS_STABLE_WRITES, &mapping->flags);
 }
 
+/*
+ * Writeback of folios in this mapping depends on an agent that is not
+ * guaranteed to make progress (e.g. a FUSE server), so reclaim and
+ * migration must not wait for it.
+ */
+static inline void mapping_set_writeback_indeterminate(struct address_space *mapping)
+{
+	set_bit(AS_WRITEBACK_INDETERMINATE, &mapping->flags);
+}
+
+static inline bool mapping_writeback_indeterminate(const struct address_space *mapping)
+{
+	return test_bit(AS_WRITEBACK_INDETERMINATE, &mapping->flags);
+}
+
 static inline void mapping_set_unmovable(struct address_space *mapping)
 {
 	/*
@@ -37,6 +37,14 @@ static inline struct psi_group *cgroup_psi(struct cgroup *cgrp)
 	return cgroup_ino(cgrp) == 1 ? &psi_system : cgrp->psi;
 }
 
+/* Whether @cgrp has pressure accounting of its own, see psi_cgroup_alloc() */
+static inline bool cgroup_psi_accounted(struct cgroup *cgrp)
+{
+	struct cgroup *parent = cgroup_parent(cgrp);
+
+	return !parent || cgroup_psi(cgrp) != cgroup_psi(parent);
+}
+
 int psi_cgroup_alloc(struct cgroup *cgrp);
 void psi_cgroup_free(struct cgroup *cgrp);
 void cgroup_move_task(struct task_struct *p, struct css_set *to);
@@ -63,6 +71,10 @@ static inline void cgroup_move_task(struct task_struct *p, struct css_set *to)
 	rcu_assign_pointer(p->cgroups, to);
 }
 static inline void psi_cgroup_restart(struct psi_group *group) {}
+static inline bool cgroup_psi_accounted(struct cgroup *cgrp)
+{
+	return false;
+}
 #endif
 
 #endif /* CONFIG_PSI */
@@ -65,8 +65,22 @@ static inline void rseq_migrate(struct task_struct *t)
  * If parent process has a registered restartable sequences area, the
  * child inherits. Unregister rseq for a clone with CLONE_VM set.
  */
+int rseq_set_block_notify(int fd);
+void rseq_release_block_notify(struct task_struct *t);
+void __rseq_sched_block(struct task_struct *t);
+
+/* Called from schedule() when @t is about to block. */
+static inline void rseq_sched_block(struct task_struct *t)
+{
+	if (unlikely(t->rseq_block_notify))
+		__rseq_sched_block(t);
+}
+
 static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 {
+	/* The notification is for the thread that asked for it only */
+	t->rseq_block_notify = NULL;
+	t->rseq_blocked = false;
 	if (clone_flags & CLONE_VM) {
 		t->rseq = NULL;
 		t->rseq_len = 0;
@@ -82,6 +96,7 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 
 static inline void rseq_execve(struct task_struct *t)
 {
+	rseq_release_block_notify(t);
 	t->rseq = NULL;
 	t->rseq_len = 0;
 	t->rseq_sig = 0;
@@ -113,6 +128,16 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 static inline void rseq_execve(struct task_struct *t)
 {
 }
+static inline int rseq_set_block_notify(int fd)
+{
+	return -EINVAL;
+}
+static inline void rseq_release_block_notify(struct task_struct *t)
+{
+}
+static inline void rseq_sched_block(struct task_struct *t)
+{
+}
 
 #endif
 
@@ -55,12 +55,16 @@ struct rw_semaphore {
 	atomic_long_t owner;
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	struct optimistic_spin_queue osq; /* spinner MCS lock */
+	unsigned int spin_avg; /* recent optimistic spin time, in ns */
 #endif
 	raw_spinlock_t wait_lock;
 	struct list_head wait_list;
 #ifdef CONFIG_DEBUG_RWSEMS
 	void *magic;
 #endif
+#ifdef CONFIG_RWSEM_CONTENTION_HIST
+	const char *hist_name; /* contention histogram class */
+#endif
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	struct lockdep_map	dep_map;
 #endif
@@ -99,6 +103,12 @@ static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *
 #define __RWSEM_OPT_INIT(lockname)
 #endif
 
+#ifdef CONFIG_RWSEM_CONTENTION_HIST
+# define __RWSEM_HIST_INIT(lockname) .hist_name = #lockname,
+#else
+# define __RWSEM_HIST_INIT(lockname)
+#endif
+
 #define __RWSEM_INITIALIZER(name)				\
 	{ __RWSEM_COUNT_INIT(name),				\
 	  .owner = ATOMIC_LONG_INIT(0),				\
@@ -106,6 +116,7 @@ static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *
 	  .wait_lock = __RAW_SPIN_LOCK_UNLOCKED(name.wait_lock),\
 	  .wait_list = LIST_HEAD_INIT((name).wait_list),	\
 	  __RWSEM_DEBUG_INIT(name)				\
+	  __RWSEM_HIST_INIT(name)				\
 	  __RWSEM_DEP_MAP_INIT(name) }
 
 #define DECLARE_RWSEM(name) \
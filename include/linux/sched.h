@@ -55,6 +55,7 @@ struct bpf_local_storage;
 struct bpf_run_ctx;
 struct capture_control;
 struct cfs_rq;
+struct eventfd_ctx;
 struct fs_struct;
 struct futex_pi_state;
 struct io_context;
@@ -1189,6 +1190,13 @@ struct task_struct {
 	struct held_lock		held_locks[MAX_LOCK_DEPTH];
 #endif
 
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+	/* Sleeping lock this task is contending on, see trace_lock_contention.c */
+	void				*contended_lock;
+	u64				contended_start;
+	unsigned int			contended_flags;
+#endif
+
 #if defined(CONFIG_UBSAN) && !defined(CONFIG_UBSAN_TRAP)
 	unsigned int			in_ubsan;
 #endif
@@ -1318,6 +1326,10 @@ struct task_struct {
 	unsigned long			numa_faults_locality[3];
 
 	unsigned long			numa_pages_migrated;
+
+	/* Batched hinting fault migration budget, in pages per second */
+	unsigned int			numa_migrate_budget_start;
+	unsigned long			numa_migrate_budget_used;
 #endif /* CONFIG_NUMA_BALANCING */
 
 #ifdef CONFIG_RSEQ
@@ -1329,6 +1341,9 @@ struct task_struct {
 	 * with respect to preemption.
 	 */
 	unsigned long rseq_event_mask;
+	/* Signalled when the task blocks, see rseq_set_block_notify() */
+	struct eventfd_ctx *rseq_block_notify;
+	bool rseq_blocked;
 #endif
 
 #ifdef CONFIG_SCHED_MM_CID
@@ -1338,6 +1353,9 @@ struct task_struct {
 	int				mm_cid_active;	/* Whether cid bitmap is active */
 	struct callback_head		cid_work;
 #endif
+#ifdef CONFIG_SCHED_CACHE
+	struct callback_head		cache_work;
+#endif
 
 	struct tlbflush_unmap_batch	tlb_ubc;
 
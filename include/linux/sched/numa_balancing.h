@@ -32,6 +32,8 @@ extern void set_numabalancing_state(bool enabled);
 extern void task_numa_free(struct task_struct *p, bool final);
 bool should_numa_migrate_memory(struct task_struct *p, struct folio *folio,
 				int src_nid, int dst_cpu);
+bool task_numa_migrate_budget(struct task_struct *p, int nr_pages);
+void task_numa_migrate_charge(struct task_struct *p, int nr_pages);
 #else
 static inline void task_numa_fault(int last_node, int node, int pages,
 				   int flags)
@@ -52,6 +54,15 @@ static inline bool should_numa_migrate_memory(struct task_struct *p,
 {
 	return true;
 }
+static inline bool task_numa_migrate_budget(struct task_struct *p,
+					    int nr_pages)
+{
+	return false;
+}
+static inline void task_numa_migrate_charge(struct task_struct *p,
+					    int nr_pages)
+{
+}
 #endif
 
 #endif /* _LINUX_SCHED_NUMA_BALANCING_H */
@@ -82,6 +82,13 @@ struct sched_domain_shared {
 	atomic_t	nr_busy_cpus;
 	int		has_idle_cores;
 	int		nr_idle_scan;
+
+	/*
+	 * Superset of the idle CPUs of the LLC: a CPU sets its own bit when it
+	 * goes idle and clears it from the tick once it is busy, so the
+	 * wakeup path can skip known busy CPUs.
+	 */
+	unsigned long	idle_cpus[];
 };
 
 struct sched_domain {
@@ -139,6 +146,15 @@ struct sched_domain {
 	unsigned int ttwu_wake_remote;
 	unsigned int ttwu_move_affine;
 	unsigned int ttwu_move_balance;
+
+	/* select_idle_cpu() stats */
+	unsigned int sis_search;
+	unsigned int sis_scanned;
+	unsigned int sis_failed;
+
+	/* sched_balance_newidle() stats */
+	unsigned int nib_cost_stop;
+	unsigned int nib_hot_refused;
 #endif
 #ifdef CONFIG_SCHED_DEBUG
 	char *name;
@@ -165,6 +181,11 @@ static inline struct cpumask *sched_domain_span(struct sched_domain *sd)
 	return to_cpumask(sd->span);
 }
 
+static inline struct cpumask *sds_idle_cpus(struct sched_domain_shared *sds)
+{
+	return to_cpumask(sds->idle_cpus);
+}
+
 extern void partition_sched_domains_locked(int ndoms_new,
 					   cpumask_var_t doms_new[],
 					   struct sched_domain_attr *dattr_new);
@@ -58,6 +58,9 @@ enum _slab_flag_bits {
 	_SLAB_CMPXCHG_DOUBLE,
 #ifdef CONFIG_SLAB_OBJ_EXT
 	_SLAB_NO_OBJ_EXT,
+#endif
+#ifndef CONFIG_SLUB_TINY
+	_SLAB_SHEAVES,
 #endif
 	_SLAB_FLAGS_LAST_BIT
 };
@@ -183,6 +186,19 @@ enum _slab_flag_bits {
 #define SLAB_KASAN		__SLAB_FLAG_UNUSED
 #endif
 
+/*
+ * Cache objects in per-cpu arrays ("sheaves") in front of the slabs. Frees
+ * and allocations on the same cpu then only touch the local array, which
+ * is refilled from and flushed to the slabs in batches. Intended for caches
+ * with high allocation churn and many remote frees. Ignored for caches with
+ * debugging enabled.
+ */
+#ifndef CONFIG_SLUB_TINY
+#define SLAB_SHEAVES		__SLAB_FLAG_BIT(_SLAB_SHEAVES)
+#else
+#define SLAB_SHEAVES		__SLAB_FLAG_UNUSED
+#endif
+
 /*
  * Ignore user specified debugging flags.
  * Intended for caches created for self-tests so they have only flags
@@ -563,6 +579,29 @@ void kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
 int kmem_cache_alloc_bulk_noprof(struct kmem_cache *s, gfp_t flags, size_t size, void **p);
 #define kmem_cache_alloc_bulk(...)	alloc_hooks(kmem_cache_alloc_bulk_noprof(__VA_ARGS__))
 
+/*
+ * Preallocated object arrays. A caller that must not fail allocations in a
+ * critical section (e.g. while holding a spinlock) can prefill a sheaf with
+ * at least the number of objects it may need, allocate from it without ever
+ * entering the slab slowpath, and return it with the unused objects.
+ */
+struct slab_sheaf;
+
+struct slab_sheaf *
+kmem_cache_prefill_sheaf(struct kmem_cache *s, gfp_t gfp, unsigned int size);
+
+int kmem_cache_refill_sheaf(struct kmem_cache *s, gfp_t gfp,
+		struct slab_sheaf **sheafp, unsigned int size);
+
+void kmem_cache_return_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf);
+
+void *kmem_cache_alloc_from_sheaf_noprof(struct kmem_cache *cachep, gfp_t gfp,
+			struct slab_sheaf *sheaf) __assume_slab_alignment __malloc;
+#define kmem_cache_alloc_from_sheaf(...)	\
+			alloc_hooks(kmem_cache_alloc_from_sheaf_noprof(__VA_ARGS__))
+
+unsigned int kmem_cache_sheaf_size(struct slab_sheaf *sheaf);
+
 static __always_inline void kfree_bulk(size_t size, void **p)
 {
 	kmem_cache_free_bulk(NULL, size, p);
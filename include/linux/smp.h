@@ -41,8 +41,11 @@ do {						\
 /*
  * Enqueue a llist_node on the call_single_queue; be very careful, read
  * flush_smp_call_function_queue() in detail.
+ *
+ * Returns false when the node was batched behind entries that are still
+ * pending, so that no IPI had to be sent for it.
  */
-extern void __smp_call_single_queue(int cpu, struct llist_node *node);
+extern bool __smp_call_single_queue(int cpu, struct llist_node *node);
 
 /* total number of cpus in this system (may exceed NR_CPUS) */
 extern unsigned int total_cpus;
@@ -162,6 +165,9 @@ extern void smp_cpus_done(unsigned int max_cpus);
 void smp_call_function(smp_call_func_t func, void *info, int wait);
 void smp_call_function_many(const struct cpumask *mask,
 			    smp_call_func_t func, void *info, bool wait);
+void smp_call_function_many_coalesce(const struct cpumask *mask,
+				     smp_call_func_t func, void *info,
+				     bool wait);
 
 int smp_call_function_any(const struct cpumask *mask,
 			  smp_call_func_t func, void *info, int wait);
@@ -205,6 +211,8 @@ static inline void up_smp_call_function(smp_call_func_t func, void *info)
 static inline void smp_send_reschedule(int cpu) { }
 #define smp_call_function_many(mask, func, info, wait) \
 			(up_smp_call_function(func, info))
+#define smp_call_function_many_coalesce(mask, func, info, wait) \
+			(up_smp_call_function(func, info))
 static inline void call_function_init(void) { }
 
 static inline int
@@ -239,13 +239,15 @@ enum {
 
 /*
  * We use this to track usage of a cluster. A cluster is a block of swap disk
- * space with SWAPFILE_CLUSTER pages long and naturally aligns in disk. All
- * free clusters are organized into a list. We fetch an entry from the list to
- * get a free cluster.
+ * space with SWAPFILE_CLUSTER pages long and naturally aligns in disk. Every
+ * cluster with free slots sits on one of the swap_info_struct lists: free
+ * clusters on free_clusters, partially used ones on the nonfull or frag list
+ * of the order they are allocated for. Full clusters and the cluster a cpu
+ * is currently allocating from are on no list.
  *
- * The data field stores next cluster if the cluster is free or cluster usage
- * counter otherwise. The flags field determines if a cluster is free. This is
- * protected by swap_info_struct.lock.
+ * The count field is the usage counter. The flags field records which list
+ * the cluster is on, and order the allocation order it serves. flags, order
+ * and the list linkage are protected by swap_info_struct.lock.
  */
 struct swap_cluster_info {
 	spinlock_t lock;	/*
@@ -254,11 +256,21 @@ struct swap_cluster_info {
 				 * elements correspond to the swap
 				 * cluster
 				 */
-	unsigned int data:24;
-	unsigned int flags:8;
+	u16 count;
+	u8 flags;
+	u8 order;
+	struct list_head list;
+};
+
+enum swap_cluster_flags {
+	CLUSTER_FLAG_NONE = 0,	/* Not on any list, e.g. in setup */
+	CLUSTER_FLAG_FREE,	/* On free_clusters */
+	CLUSTER_FLAG_NONFULL,	/* On nonfull_clusters[order] */
+	CLUSTER_FLAG_FRAG,	/* On frag_clusters[order] */
+	CLUSTER_FLAG_FULL,	/* No free slot, not on any list */
+	CLUSTER_FLAG_PERCPU,	/* Owned by a cpu's percpu_cluster */
+	CLUSTER_FLAG_DISCARD,	/* On discard_clusters */
 };
-#define CLUSTER_FLAG_FREE 1 /* This cluster is free */
-#define CLUSTER_FLAG_NEXT_NULL 2 /* This cluster has no next cluster */
 
 /*
  * The first page in the swap file is the swap header, which is always marked
@@ -283,11 +295,6 @@ struct percpu_cluster {
 	unsigned int next[SWAP_NR_ORDERS]; /* Likely next allocation offset */
 };
 
-struct swap_cluster_list {
-	struct swap_cluster_info head;
-	struct swap_cluster_info tail;
-};
-
 /*
  * The in-memory structure used to track swap areas.
  */
@@ -300,7 +307,13 @@ struct swap_info_struct {
 	unsigned int	max;		/* extent of the swap_map */
 	unsigned char *swap_map;	/* vmalloc'ed array of usage counts */
 	struct swap_cluster_info *cluster_info; /* cluster info. Only for SSD */
-	struct swap_cluster_list free_clusters; /* free clusters list */
+	struct list_head free_clusters; /* free clusters list */
+	struct list_head nonfull_clusters[SWAP_NR_ORDERS];
+					/* clusters with free slots, by order */
+	struct list_head frag_clusters[SWAP_NR_ORDERS];
+					/* nonfull clusters without a free
+					 * naturally aligned range of their order
+					 */
 	unsigned int lowest_bit;	/* index of first free in swap_map */
 	unsigned int highest_bit;	/* index of last free in swap_map */
 	unsigned int pages;		/* total of usable pages of swap */
@@ -318,8 +331,8 @@ struct swap_info_struct {
 					 * swap_map, lowest_bit, highest_bit,
 					 * inuse_pages, cluster_next,
 					 * cluster_nr, lowest_alloc,
-					 * highest_alloc, free/discard cluster
-					 * list. other fields are only changed
+					 * highest_alloc, and the cluster
+					 * lists. other fields are only changed
 					 * at swapon/swapoff, so are protected
 					 * by swap_lock. changing flags need
 					 * hold this lock and swap_lock. If
@@ -331,7 +344,7 @@ struct swap_info_struct {
 					 * list.
 					 */
 	struct work_struct discard_work; /* discard worker */
-	struct swap_cluster_list discard_clusters; /* discard clusters list */
+	struct list_head discard_clusters; /* discard clusters list */
 	struct plist_node avail_lists[]; /*
 					   * entries in swap_avail_heads, one
 					   * entry per node.
@@ -477,7 +490,9 @@ extern int add_swap_count_continuation(swp_entry_t, gfp_t);
 extern void swap_shmem_alloc(swp_entry_t);
 extern int swap_duplicate(swp_entry_t);
 extern int swapcache_prepare(swp_entry_t);
+extern int swapcache_prepare_nr(swp_entry_t entry, int nr);
 extern void swap_free(swp_entry_t);
+extern void swap_free_nr(swp_entry_t entry, int nr);
 extern void swapcache_free_entries(swp_entry_t *entries, int n);
 extern void free_swap_and_cache_nr(swp_entry_t entry, int nr);
 int swap_type_of(dev_t device, sector_t offset);
@@ -555,10 +570,19 @@ static inline int swapcache_prepare(swp_entry_t swp)
 	return 0;
 }
 
+static inline int swapcache_prepare_nr(swp_entry_t entry, int nr)
+{
+	return 0;
+}
+
 static inline void swap_free(swp_entry_t swp)
 {
 }
 
+static inline void swap_free_nr(swp_entry_t entry, int nr)
+{
+}
+
 static inline void put_swap_folio(struct folio *folio, swp_entry_t swp)
 {
 }
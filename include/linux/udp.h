@@ -44,6 +44,12 @@ enum {
 	UDP_FLAGS_UDPLITE_RECV_CC, /* set via udplite setsockopt */
 };
 
+/* Lockless producer queue, one per NUMA node and per socket. */
+struct udp_prod_queue {
+	struct llist_head	ll_root ____cacheline_aligned_in_smp;
+	atomic_t		rmem_alloc;
+};
+
 struct udp_sock {
 	/* inet_sock has to be the first member */
 	struct inet_sock inet;
@@ -95,6 +101,13 @@ struct udp_sock {
 
 	/* Cache friendly copy of sk->sk_peek_off >= 0 */
 	bool		peeking_with_offset;
+
+	/* Producers add skbs here before they reach sk_receive_queue */
+	struct udp_prod_queue *udp_prod_queue;
+
+	/* Route of the last destination of unconnected sendmsg() */
+	struct udp_route_cache __rcu *route_cache;
+	u32		route_miss_hash;
 };
 
 #define udp_test_bit(nr, sk)			\
@@ -129,6 +129,8 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		NR_TLB_LOCAL_FLUSH_ALL,
 		NR_TLB_LOCAL_FLUSH_ONE,
 #endif /* CONFIG_DEBUG_TLBFLUSH */
+		UNMAP_TLB_FLUSH,	/* batched flushes after rmap unmap */
+		UNMAP_TLB_FLUSH_SAVED,	/* flushes folded into a batch */
 #ifdef CONFIG_SWAP
 		SWAP_RA,
 		SWAP_RA_HIT,
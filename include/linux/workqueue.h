@@ -402,6 +402,16 @@ enum wq_flags {
 	 */
 	WQ_POWER_EFFICIENT	= 1 << 7,
 
+	/*
+	 * Per-cpu work items of a WQ_LLC_STEAL workqueue which have been
+	 * waiting behind other work for longer than workqueue.llc_steal_msecs
+	 * may be moved to an idle worker of another CPU sharing the same last
+	 * level cache.  Only for work items which don't depend on the CPU they
+	 * were queued on.  Work items a flush_workqueue() in progress waits
+	 * for are not moved.
+	 */
+	WQ_LLC_STEAL		= 1 << 8,
+
 	__WQ_DESTROYING		= 1 << 15, /* internal: workqueue is destroying */
 	__WQ_DRAINING		= 1 << 16, /* internal: workqueue is draining */
 	__WQ_ORDERED		= 1 << 17, /* internal: workqueue is ordered */
@@ -581,6 +591,9 @@ extern void workqueue_set_max_active(struct workqueue_struct *wq,
 				     int max_active);
 extern void workqueue_set_min_active(struct workqueue_struct *wq,
 				     int min_active);
+extern void workqueue_set_bh_budget(struct workqueue_struct *wq,
+				    unsigned int usecs);
+extern bool bh_work_over_budget(void);
 extern struct work_struct *current_work(void);
 extern bool current_is_workqueue_rescuer(void);
 extern bool workqueue_congested(int cpu, struct workqueue_struct *wq);
@@ -29,6 +29,7 @@ struct zswap_lruvec_state {
 unsigned long zswap_total_pages(void);
 bool zswap_store(struct folio *folio);
 bool zswap_load(struct folio *folio);
+int zswap_present_nr(swp_entry_t swp, int nr_pages);
 void zswap_invalidate(swp_entry_t swp);
 int zswap_swapon(int type, unsigned long nr_pages);
 void zswap_swapoff(int type);
@@ -50,6 +51,11 @@ static inline bool zswap_load(struct folio *folio)
 	return false;
 }
 
+static inline int zswap_present_nr(swp_entry_t swp, int nr_pages)
+{
+	return 0;
+}
+
 static inline void zswap_invalidate(swp_entry_t swp) {}
 static inline int zswap_swapon(int type, unsigned long nr_pages)
 {
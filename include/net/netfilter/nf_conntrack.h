@@ -53,6 +53,7 @@ struct nf_conntrack_net {
 	/* only used when new connection is allocated: */
 	atomic_t count;
 	unsigned int expect_count;
+	unsigned long early_drop_fail;	/* jiffies of the last failed early drop */
 
 	/* only used from work queues, configuration plane, and so on: */
 	unsigned int users4;
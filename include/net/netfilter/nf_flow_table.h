@@ -73,10 +73,18 @@ enum nf_flowtable_flags {
 	NF_FLOWTABLE_COUNTER		= 0x2,	/* NFT_FLOWTABLE_COUNTER */
 };
 
+/* Last tuple found by a cpu, valid while @gen matches the flowtable's */
+struct flow_offload_last_hit {
+	struct flow_offload_tuple_rhash	*tuplehash;
+	unsigned long			gen;
+};
+
 struct nf_flowtable {
 	unsigned int			flags;		/* readonly in datapath */
 	int				priority;	/* control path (padding hole) */
 	struct rhashtable		rhashtable;	/* datapath, read-mostly members come first */
+	struct flow_offload_last_hit __percpu *last_hit; /* datapath, per cpu */
+	atomic_long_t			last_hit_gen;	/* bumped on flow removal */
 
 	struct list_head		list;		/* slowpath parts */
 	const struct nf_flowtable_type	*type;
@@ -175,13 +175,27 @@ INDIRECT_CALLABLE_DECLARE(int udpv6_rcv(struct sk_buff *));
 struct sk_buff *__udp_gso_segment(struct sk_buff *gso_skb,
 				  netdev_features_t features, bool is_ipv6);
 
-static inline void udp_lib_init_sock(struct sock *sk)
+static inline int udp_lib_init_sock(struct sock *sk)
 {
 	struct udp_sock *up = udp_sk(sk);
+	int i;
 
 	skb_queue_head_init(&up->reader_queue);
 	up->forward_threshold = sk->sk_rcvbuf >> 2;
 	set_bit(SOCK_CUSTOM_SOCKOPT, &sk->sk_socket->flags);
+
+	/*
+	 * Entries are cacheline aligned, so that producers of different nodes
+	 * don't share a line. kmalloc() only aligns the array accordingly
+	 * for power of two sizes.
+	 */
+	up->udp_prod_queue = kzalloc(roundup_pow_of_two(nr_node_ids *
+					sizeof(*up->udp_prod_queue)), GFP_KERNEL);
+	if (!up->udp_prod_queue)
+		return -ENOMEM;
+	for (i = 0; i < nr_node_ids; i++)
+		init_llist_head(&up->udp_prod_queue[i].ll_root);
+	return 0;
 }
 
 /* hash routines shared between UDPv4/6 and UDP-Litev4/6 */
@@ -200,6 +200,32 @@ TRACE_EVENT(btrfs_transaction_commit,
 		  __entry->generation)
 );
 
+TRACE_EVENT(btrfs_run_delayed_refs_commit,
+
+	TP_PROTO(const struct btrfs_fs_info *fs_info, u64 transid,
+		 unsigned long nr_heads, int nr_workers, u64 duration_ns),
+
+	TP_ARGS(fs_info, transid, nr_heads, nr_workers, duration_ns),
+
+	TP_STRUCT__entry_btrfs(
+		__field(	u64,		transid		)
+		__field(	unsigned long,	nr_heads	)
+		__field(	int,		nr_workers	)
+		__field(	u64,		duration_ns	)
+	),
+
+	TP_fast_assign_btrfs(fs_info,
+		__entry->transid	= transid;
+		__entry->nr_heads	= nr_heads;
+		__entry->nr_workers	= nr_workers;
+		__entry->duration_ns	= duration_ns;
+	),
+
+	TP_printk_btrfs("transid=%llu heads=%lu workers=%d duration_ns=%llu",
+		  __entry->transid, __entry->nr_heads, __entry->nr_workers,
+		  __entry->duration_ns)
+);
+
 DECLARE_EVENT_CLASS(btrfs__inode,
 
 	TP_PROTO(const struct inode *inode),
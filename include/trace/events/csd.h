@@ -66,6 +66,15 @@ DEFINE_EVENT(csd_function, csd_function_exit,
 	TP_ARGS(func, csd)
 );
 
+/*
+ * The csd of an idempotent function didn't get its own call as the same
+ * function and argument already ran on this CPU in the same flush.
+ */
+DEFINE_EVENT(csd_function, csd_function_coalesce,
+	TP_PROTO(smp_call_func_t func, call_single_data_t *csd),
+	TP_ARGS(func, csd)
+);
+
 #endif /* _TRACE_CSD_H */
 
 /* This part must be outside protection */
@@ -115,6 +115,37 @@ TRACE_EVENT(exit_mmap,
 	)
 );
 
+/*
+ * A fault attempt that has to be retried, e.g. because it had to wait for I/O
+ * or a page lock and dropped the mmap or VMA lock for that.
+ */
+TRACE_EVENT(mm_fault_retry,
+	TP_PROTO(struct mm_struct *mm, unsigned long address,
+		 unsigned int flags, vm_fault_t ret),
+
+	TP_ARGS(mm, address, flags, ret),
+
+	TP_STRUCT__entry(
+			__field(struct mm_struct *, mm)
+			__field(unsigned long, address)
+			__field(unsigned int, flags)
+			__field(vm_fault_t, ret)
+	),
+
+	TP_fast_assign(
+			__entry->mm		= mm;
+			__entry->address	= address;
+			__entry->flags		= flags;
+			__entry->ret		= ret;
+	),
+
+	TP_printk("mm=%p address=0x%lx flags=%s ret=%s",
+		  __entry->mm, __entry->address,
+		  __print_flags(__entry->flags, "|", FAULT_FLAG_TRACE),
+		  __print_flags(__entry->ret, "|", VM_FAULT_RESULT_TRACE)
+	)
+);
+
 #endif
 
 /* This part must be outside protection */
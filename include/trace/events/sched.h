@@ -769,6 +769,29 @@ TRACE_EVENT(sched_wake_idle_without_ipi,
 	TP_printk("cpu=%d", __entry->cpu)
 );
 
+/*
+ * Tracepoint for a remote wakeup queued behind others pending on the target
+ * cpu, which needs no IPI of its own.
+ */
+TRACE_EVENT(sched_wake_batched,
+
+	TP_PROTO(struct task_struct *p, int cpu),
+
+	TP_ARGS(p, cpu),
+
+	TP_STRUCT__entry(
+		__field(	pid_t,	pid	)
+		__field(	int,	cpu	)
+	),
+
+	TP_fast_assign(
+		__entry->pid	= p->pid;
+		__entry->cpu	= cpu;
+	),
+
+	TP_printk("pid=%d cpu=%d", __entry->pid, __entry->cpu)
+);
+
 /*
  * Following tracepoints are not exported in tracefs and provide hooking
  * mechanisms only for testing and debugging purposes.
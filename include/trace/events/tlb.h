@@ -56,6 +56,37 @@ TRACE_EVENT(tlb_flush,
 		__entry->reason)
 );
 
+/*
+ * Fan-out of a remote shootdown: how many other CPUs were in the mask, how
+ * many of them were in lazy TLB mode, and how many actually got an IPI.
+ */
+TRACE_EVENT(tlb_flush_ipi,
+
+	TP_PROTO(struct mm_struct *mm, unsigned int nr_cpus,
+		 unsigned int nr_lazy, unsigned int nr_ipis, bool freed_tables),
+	TP_ARGS(mm, nr_cpus, nr_lazy, nr_ipis, freed_tables),
+
+	TP_STRUCT__entry(
+		__field(struct mm_struct *, mm)
+		__field(unsigned int, nr_cpus)
+		__field(unsigned int, nr_lazy)
+		__field(unsigned int, nr_ipis)
+		__field(bool, freed_tables)
+	),
+
+	TP_fast_assign(
+		__entry->mm = mm;
+		__entry->nr_cpus = nr_cpus;
+		__entry->nr_lazy = nr_lazy;
+		__entry->nr_ipis = nr_ipis;
+		__entry->freed_tables = freed_tables;
+	),
+
+	TP_printk("mm=%p cpus=%u lazy=%u ipis=%u freed_tables=%d",
+		__entry->mm, __entry->nr_cpus, __entry->nr_lazy,
+		__entry->nr_ipis, __entry->freed_tables)
+);
+
 #endif /* _TRACE_TLB_H */
 
 /* This part must be outside protection */
@@ -126,6 +126,71 @@ TRACE_EVENT(workqueue_execute_end,
 	TP_printk("work struct %p: function %ps", __entry->work, __entry->function)
 );
 
+/**
+ * workqueue_bh_execute_end - called after the callback of a BH work item
+ * @work:	pointer to struct work_struct
+ * @function:	pointer to worker function
+ * @runtime:	time spent in @function in nanoseconds
+ *
+ * Allows to track how much softirq time each BH work function takes.
+ */
+TRACE_EVENT(workqueue_bh_execute_end,
+
+	TP_PROTO(struct work_struct *work, work_func_t function, u64 runtime),
+
+	TP_ARGS(work, function, runtime),
+
+	TP_STRUCT__entry(
+		__field( void *,	work	)
+		__field( void *,	function)
+		__field( u64,		runtime	)
+	),
+
+	TP_fast_assign(
+		__entry->work		= work;
+		__entry->function	= function;
+		__entry->runtime	= runtime;
+	),
+
+	TP_printk("work struct %p: function %ps runtime=%llu ns",
+		  __entry->work, __entry->function, __entry->runtime)
+);
+
+/**
+ * workqueue_bh_worker - called when a BH worker is done with a softirq round
+ * @cpu:	the CPU of the BH worker pool
+ * @highpri:	whether it's the highpri pool, run from HI_SOFTIRQ
+ * @runtime:	time spent in the round in nanoseconds
+ * @pending:	whether work items were left over for the next round
+ *
+ * Allows to track the softirq time of BH workqueues and how often their
+ * budget is exhausted.
+ */
+TRACE_EVENT(workqueue_bh_worker,
+
+	TP_PROTO(int cpu, bool highpri, u64 runtime, bool pending),
+
+	TP_ARGS(cpu, highpri, runtime, pending),
+
+	TP_STRUCT__entry(
+		__field( int,	cpu	)
+		__field( bool,	highpri	)
+		__field( bool,	pending	)
+		__field( u64,	runtime	)
+	),
+
+	TP_fast_assign(
+		__entry->cpu		= cpu;
+		__entry->highpri	= highpri;
+		__entry->pending	= pending;
+		__entry->runtime	= runtime;
+	),
+
+	TP_printk("cpu=%d highpri=%d runtime=%llu ns pending=%d",
+		  __entry->cpu, __entry->highpri, __entry->runtime,
+		  __entry->pending)
+);
+
 #endif /*  _TRACE_WORKQUEUE_H */
 
 /* This part must be outside protection */
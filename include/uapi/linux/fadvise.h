@@ -19,4 +19,7 @@
 #define POSIX_FADV_NOREUSE	5 /* Data will be accessed once.  */
 #endif
 
+/* Linux specific: read into the largest page cache folios available. */
+#define POSIX_FADV_HUGEPAGE	8
+
 #endif	/* FADVISE_H_INCLUDED */
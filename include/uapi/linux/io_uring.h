@@ -92,6 +92,10 @@ struct io_uring_sqe {
 			__u16	addr_len;
 			__u16	__pad3[1];
 		};
+		struct {
+			__u8	write_stream;
+			__u8	__pad4[3];
+		};
 	};
 	union {
 		struct {
@@ -200,6 +204,9 @@ enum io_uring_sqe_flags_bit {
  */
 #define IORING_SETUP_NO_SQARRAY		(1U << 16)
 
+/* Use hybrid poll in iopoll process */
+#define IORING_SETUP_HYBRID_IOPOLL	(1U << 17)
+
 enum io_uring_op {
 	IORING_OP_NOP,
 	IORING_OP_READV,
@@ -257,6 +264,10 @@ enum io_uring_op {
 	IORING_OP_FUTEX_WAITV,
 	IORING_OP_FIXED_FD_INSTALL,
 	IORING_OP_FTRUNCATE,
+	IORING_OP_READV_FIXED,
+	IORING_OP_WRITEV_FIXED,
+	IORING_OP_EPOLL_WAIT,
+	IORING_OP_GETDENTS_STATX,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -360,12 +371,22 @@ enum io_uring_op {
  *				the starting buffer ID in cqe->flags as per
  *				usual for provided buffer usage. The buffers
  *				will be	contigious from the starting buffer ID.
+ *
+ * IORING_SEND_ZC_COALESCE_NOTIF
+ *				If set, notifications of consecutive
+ *				SEND[MSG]_ZC requests with this flag that
+ *				complete together are merged. Only the most
+ *				recent request posts an IORING_CQE_F_NOTIF
+ *				cqe, with the number of notifications it
+ *				covers stored in cqe.res (see
+ *				IORING_NOTIF_COALESCED_MASK).
  */
 #define IORING_RECVSEND_POLL_FIRST	(1U << 0)
 #define IORING_RECV_MULTISHOT		(1U << 1)
 #define IORING_RECVSEND_FIXED_BUF	(1U << 2)
 #define IORING_SEND_ZC_REPORT_USAGE	(1U << 3)
 #define IORING_RECVSEND_BUNDLE		(1U << 4)
+#define IORING_SEND_ZC_COALESCE_NOTIF	(1U << 5)
 
 /*
  * cqe.res for IORING_CQE_F_NOTIF if
@@ -376,6 +397,14 @@ enum io_uring_op {
  */
 #define IORING_NOTIF_USAGE_ZC_COPIED    (1U << 31)
 
+/*
+ * cqe.res for IORING_CQE_F_NOTIF if IORING_SEND_ZC_COALESCE_NOTIF was
+ * requested: the number of send notifications this cqe covers, including
+ * its own. The covered requests are the ones issued on the same socket
+ * right before it that didn't post a notification of their own.
+ */
+#define IORING_NOTIF_COALESCED_MASK	(IORING_NOTIF_USAGE_ZC_COPIED - 1)
+
 /*
  * accept flags stored in sqe->ioprio
  */
@@ -383,6 +412,17 @@ enum io_uring_op {
 #define IORING_ACCEPT_DONTWAIT	(1U << 1)
 #define IORING_ACCEPT_POLL_FIRST	(1U << 2)
 
+/*
+ * IORING_OP_EPOLL_WAIT flags, stored in sqe->ioprio
+ *
+ * IORING_EPOLL_WAIT_MULTISHOT	Multishot epoll wait. Must be used with
+ *				IOSQE_BUFFER_SELECT, each CQE reports the
+ *				number of events stored in the selected
+ *				buffer and sets IORING_CQE_F_MORE if more
+ *				CQEs will follow.
+ */
+#define IORING_EPOLL_WAIT_MULTISHOT	(1U << 0)
+
 /*
  * IORING_OP_MSG_RING command types, stored in sqe->addr
  */
@@ -505,6 +545,7 @@ struct io_cqring_offsets {
 #define IORING_ENTER_SQ_WAIT		(1U << 2)
 #define IORING_ENTER_EXT_ARG		(1U << 3)
 #define IORING_ENTER_REGISTERED_RING	(1U << 4)
+#define IORING_ENTER_EXT_ARG_REG	(1U << 5)
 
 /*
  * Passed in for io_uring_setup(2). Copied back with updated info on success
@@ -593,6 +634,12 @@ enum io_uring_register_op {
 	IORING_REGISTER_NAPI			= 27,
 	IORING_UNREGISTER_NAPI			= 28,
 
+	/* register fixed wait arguments for io_uring_enter(2) */
+	IORING_REGISTER_CQWAIT_REG		= 29,
+
+	/* copy registered buffers (and files) from source ring to current ring */
+	IORING_REGISTER_CLONE_BUFFERS		= 30,
+
 	/* this goes last */
 	IORING_REGISTER_LAST,
 
@@ -730,8 +777,39 @@ struct io_uring_buf_status {
 struct io_uring_napi {
 	__u32	busy_poll_to;
 	__u8	prefer_busy_poll;
-	__u8	pad[3];
-	__u64	resv;
+
+	/* a io_uring_napi_op value */
+	__u8	opcode;
+	__u8	pad[2];
+
+	/*
+	 * for IO_URING_NAPI_REGISTER_OP, it is a
+	 * io_uring_napi_tracking_strategy value.
+	 *
+	 * for IO_URING_NAPI_STATIC_ADD_ID/IO_URING_NAPI_STATIC_DEL_ID
+	 * it is the napi id to add/del from napi_list.
+	 */
+	__u32	op_param;
+
+	/* packets polled per NAPI instance and loop, 0 means the default */
+	__u16	busy_poll_budget;
+	__u16	resv;
+};
+
+enum io_uring_napi_op {
+	/* register/unregister backward compatible opcode */
+	IO_URING_NAPI_REGISTER_OP = 0,
+
+	/* opcodes to update napi_list when static tracking is used */
+	IO_URING_NAPI_STATIC_ADD_ID = 1,
+	IO_URING_NAPI_STATIC_DEL_ID = 2
+};
+
+enum io_uring_napi_tracking_strategy {
+	/* value must be 0 for backward compatibility */
+	IO_URING_NAPI_TRACKING_DYNAMIC = 0,
+	IO_URING_NAPI_TRACKING_STATIC = 1,
+	IO_URING_NAPI_TRACKING_INACTIVE = 255
 };
 
 /*
@@ -756,10 +834,67 @@ enum io_uring_register_restriction_op {
 struct io_uring_getevents_arg {
 	__u64	sigmask;
 	__u32	sigmask_sz;
-	__u32	pad;
+	__u32	min_wait_usec;
 	__u64	ts;
 };
 
+/*
+ * Argument for IORING_REGISTER_CQWAIT_REG, registering a region of
+ * struct io_uring_reg_wait that can be indexed when io_uring_enter(2) is
+ * called with IORING_ENTER_EXT_ARG_REG, rather than passing in a
+ * struct io_uring_getevents_arg for every call.
+ */
+struct io_uring_cqwait_reg_arg {
+	__u32		flags;
+	__u32		struct_size;
+	__u32		nr_entries;
+	__u32		pad;
+	__u64		user_addr;
+	__u64		pad2[3];
+};
+
+/*
+ * Used in io_uring_reg_wait->flags
+ */
+enum {
+	IORING_REG_WAIT_TS		= (1U << 0),
+};
+
+/*
+ * Wait argument region entry. With IORING_ENTER_EXT_ARG_REG, the argp passed
+ * to io_uring_enter(2) is the index of the entry to use.
+ */
+struct io_uring_reg_wait {
+	struct __kernel_timespec	ts;
+	__u32				min_wait_usec;
+	__u32				flags;
+	__u64				sigmask;
+	__u32				sigmask_sz;
+	__u32				pad[3];
+	__u64				pad2[2];
+};
+
+/*
+ * Flags for IORING_REGISTER_CLONE_BUFFERS
+ */
+enum {
+	/* src_fd is a registered ring index, not a normal file descriptor */
+	IORING_REGISTER_SRC_REGISTERED	= (1U << 0),
+	/* also clone the fixed file table of the source ring */
+	IORING_REGISTER_CLONE_FILES	= (1U << 1),
+};
+
+/*
+ * Argument for IORING_REGISTER_CLONE_BUFFERS. The registered buffers of the
+ * ring identified by src_fd are shared with the ring the operation is issued
+ * against, which must not have any buffers registered yet.
+ */
+struct io_uring_clone_buffers {
+	__u32	src_fd;
+	__u32	flags;
+	__u32	pad[6];
+};
+
 /*
  * Argument for IORING_REGISTER_SYNC_CANCEL
  */
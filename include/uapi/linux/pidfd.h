@@ -5,6 +5,7 @@
 
 #include <linux/types.h>
 #include <linux/fcntl.h>
+#include <linux/ioctl.h>
 
 /* Flags for pidfd_open().  */
 #define PIDFD_NONBLOCK	O_NONBLOCK
@@ -15,4 +16,63 @@
 #define PIDFD_SIGNAL_THREAD_GROUP	(1UL << 1)
 #define PIDFD_SIGNAL_PROCESS_GROUP	(1UL << 2)
 
+/* Flags for pidfd_info.mask, selecting which groups of fields to fill. */
+#define PIDFD_INFO_PID			(1UL << 0) /* Always returned. */
+#define PIDFD_INFO_CREDS		(1UL << 1) /* Always returned. */
+#define PIDFD_INFO_CGROUPID		(1UL << 2) /* If CONFIG_CGROUPS. */
+#define PIDFD_INFO_EXIT			(1UL << 3) /* Not supported, never returned. */
+#define PIDFD_INFO_STATS		(1UL << 4) /* If ptrace read access. */
+
+#define PIDFD_INFO_SIZE_VER0		64 /* sizeof first published struct */
+#define PIDFD_INFO_SIZE_VER1		160 /* sizeof second published struct */
+
+/*
+ * Binary replacement for parsing /proc/<pid>/{stat,status,smaps_rollup}.
+ *
+ * On input @mask selects the field groups the caller is interested in, on
+ * output it reports the groups that were actually filled in. Fields of
+ * groups that were not returned are zeroed. The structure is versioned by
+ * its size, encoded in the ioctl command: new fields are only ever appended
+ * and older or newer callers see the common prefix.
+ *
+ * Pids are translated into the caller's pid namespace, ids into the
+ * caller's user namespace. Times are in nanoseconds, sizes in bytes.
+ * Unless the pidfd was opened with PIDFD_THREAD, the statistics cover the
+ * whole thread-group.
+ */
+struct pidfd_info {
+	__u64 mask;
+	__u64 cgroupid;
+	__u32 pid;
+	__u32 tgid;
+	__u32 ppid;
+	__u32 ruid;
+	__u32 rgid;
+	__u32 euid;
+	__u32 egid;
+	__u32 suid;
+	__u32 sgid;
+	__u32 fsuid;
+	__u32 fsgid;
+	__s32 exit_code;
+	/* PIDFD_INFO_STATS, needs at least PIDFD_INFO_SIZE_VER1 */
+	__u32 nr_threads;
+	__u32 spare0;
+	__u64 utime;
+	__u64 stime;
+	__u64 start_boottime;
+	__u64 min_flt;
+	__u64 maj_flt;
+	__u64 vsize;
+	__u64 rss_anon;
+	__u64 rss_file;
+	__u64 rss_shmem;
+	__u64 swap;
+	__u64 rss_large;
+};
+
+#define PIDFS_IOCTL_MAGIC 0xFF
+
+#define PIDFD_GET_INFO			_IOWR(PIDFS_IOCTL_MAGIC, 11, struct pidfd_info)
+
 #endif /* _UAPI_LINUX_PIDFD_H */
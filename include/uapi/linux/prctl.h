@@ -328,4 +328,10 @@ struct prctl_mm_map {
 # define PR_PPC_DEXCR_CTRL_CLEAR_ONEXEC	0x10 /* Clear the aspect on exec */
 # define PR_PPC_DEXCR_CTRL_MASK		0x1f
 
+/*
+ * Signal an eventfd each time the calling thread blocks in the kernel, and
+ * track it in the sched_state field of its rseq area; -1 turns this off.
+ */
+#define PR_SET_RSEQ_BLOCK_NOTIFY	74
+
 #endif /* _LINUX_PRCTL_H */
@@ -22,6 +22,10 @@ enum rseq_flags {
 	RSEQ_FLAG_UNREGISTER = (1 << 0),
 };
 
+enum rseq_sched_state {
+	RSEQ_SCHED_STATE_BLOCKED		= (1U << 0),
+};
+
 enum rseq_cs_flags_bit {
 	RSEQ_CS_FLAG_NO_RESTART_ON_PREEMPT_BIT	= 0,
 	RSEQ_CS_FLAG_NO_RESTART_ON_SIGNAL_BIT	= 1,
@@ -148,6 +152,16 @@ struct rseq {
 	 */
 	__u32 mm_cid;
 
+	/*
+	 * Restartable sequences sched_state field. Updated by the kernel.
+	 * Read by user-space with single-copy atomicity semantics. Aligned
+	 * on 32-bit. Only maintained for threads that asked to be notified
+	 * of blocking with prctl(PR_SET_RSEQ_BLOCK_NOTIFY): contains
+	 * RSEQ_SCHED_STATE_BLOCKED while the thread is blocked in the
+	 * kernel, and 0 again once it returns to user-space.
+	 */
+	__u32 sched_state;
+
 	/*
 	 * Flexible array member at end of structure, after last feature field.
 	 */
@@ -132,6 +132,23 @@ struct statx {
 	/* 0x100 */
 };
 
+/*
+ * Record returned by a bulk directory read with attributes
+ * (IORING_OP_GETDENTS_STATX): a directory entry followed by the attributes
+ * statx(2) with AT_SYMLINK_NOFOLLOW would return for it.  d_stx.stx_mask is
+ * zero if no attributes were returned for the entry, which is the case for
+ * "..", mount points and entries that went away while being looked up.
+ */
+struct dirent_statx {
+	__u64	d_ino;		/* Inode number */
+	__s64	d_off;		/* Offset to continue reading after this entry */
+	__u16	d_reclen;	/* Length of this record */
+	__u8	d_type;		/* File type */
+	__u8	__spare[5];
+	struct statx d_stx;	/* Attributes of the entry */
+	char	d_name[];	/* Filename (null-terminated) */
+};
+
 /*
  * Flags to be stx_mask
  *
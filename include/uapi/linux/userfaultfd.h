@@ -54,13 +54,15 @@
 	 (__u64)1 << _UFFDIO_MOVE |		\
 	 (__u64)1 << _UFFDIO_WRITEPROTECT |	\
 	 (__u64)1 << _UFFDIO_CONTINUE |		\
-	 (__u64)1 << _UFFDIO_POISON)
+	 (__u64)1 << _UFFDIO_POISON |		\
+	 (__u64)1 << _UFFDIO_COPY_VEC)
 #define UFFD_API_RANGE_IOCTLS_BASIC		\
 	((__u64)1 << _UFFDIO_WAKE |		\
 	 (__u64)1 << _UFFDIO_COPY |		\
 	 (__u64)1 << _UFFDIO_WRITEPROTECT |	\
 	 (__u64)1 << _UFFDIO_CONTINUE |		\
-	 (__u64)1 << _UFFDIO_POISON)
+	 (__u64)1 << _UFFDIO_POISON |		\
+	 (__u64)1 << _UFFDIO_COPY_VEC)
 
 /*
  * Valid ioctl command number range with this API is from 0x00 to
@@ -79,6 +81,7 @@
 #define _UFFDIO_WRITEPROTECT		(0x06)
 #define _UFFDIO_CONTINUE		(0x07)
 #define _UFFDIO_POISON			(0x08)
+#define _UFFDIO_COPY_VEC		(0x09)
 #define _UFFDIO_API			(0x3F)
 
 /* userfaultfd ioctl ids */
@@ -103,6 +106,8 @@
 				      struct uffdio_continue)
 #define UFFDIO_POISON		_IOWR(UFFDIO, _UFFDIO_POISON, \
 				      struct uffdio_poison)
+#define UFFDIO_COPY_VEC		_IOWR(UFFDIO, _UFFDIO_COPY_VEC, \
+				      struct uffdio_copy_vec)
 
 /* read() structure */
 struct uffd_msg {
@@ -293,6 +298,25 @@ struct uffdio_copy {
 	__s64 copy;
 };
 
+/*
+ * Resolve several, possibly discontiguous, ranges at once: "vec" points to an
+ * array of "nr" struct uffdio_copy, each handled like UFFDIO_COPY including
+ * the per entry "copy" result.  The wakeups of all entries are done in one
+ * pass.  Entries are processed in order and "done" is set to the number of
+ * entries copied in full; on error or a short copy the ioctl fails and the
+ * remaining entries are left untouched.
+ */
+#define UFFDIO_COPY_VEC_MAX			1024
+struct uffdio_copy_vec {
+	__u64 vec;
+	__u64 nr;
+	/*
+	 * "done" is written by the ioctl and must be at the end: the
+	 * copy_from_user will not read the last 8 bytes.
+	 */
+	__s64 done;
+};
+
 struct uffdio_zeropage {
 	struct uffdio_range range;
 #define UFFDIO_ZEROPAGE_MODE_DONTWAKE		((__u64)1<<0)
@@ -68,6 +68,7 @@ static bool io_fadvise_force_async(struct io_fadvise *fa)
 	case POSIX_FADV_NORMAL:
 	case POSIX_FADV_RANDOM:
 	case POSIX_FADV_SEQUENTIAL:
+	case POSIX_FADV_HUGEPAGE:
 		return false;
 	default:
 		return true;
@@ -10,6 +10,8 @@
 #include <uapi/linux/io_uring.h>
 
 #include "io_uring.h"
+#include "kbuf.h"
+#include "poll.h"
 #include "epoll.h"
 
 #if defined(CONFIG_EPOLL)
@@ -21,6 +23,13 @@ struct io_epoll {
 	struct epoll_event		event;
 };
 
+struct io_epoll_wait {
+	struct file			*file;
+	int				maxevents;
+	unsigned			flags;
+	struct epoll_event __user	*events;
+};
+
 int io_epoll_ctl_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_epoll *epoll = io_kiocb_to_cmd(req, struct io_epoll);
@@ -58,4 +67,85 @@ int io_epoll_ctl(struct io_kiocb *req, unsigned int issue_flags)
 	io_req_set_res(req, ret, 0);
 	return IOU_OK;
 }
+
+int io_epoll_wait_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_epoll_wait *iew = io_kiocb_to_cmd(req, struct io_epoll_wait);
+
+	if (sqe->off || sqe->rw_flags || sqe->splice_fd_in)
+		return -EINVAL;
+
+	iew->maxevents = READ_ONCE(sqe->len);
+	iew->events = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	iew->flags = READ_ONCE(sqe->ioprio);
+	if (iew->flags & ~IORING_EPOLL_WAIT_MULTISHOT)
+		return -EINVAL;
+
+	if (req->flags & REQ_F_BUFFER_SELECT) {
+		/* events go to the selected buffer, len caps the count */
+		if (iew->events)
+			return -EINVAL;
+	} else {
+		if (sqe->buf_index)
+			return -EINVAL;
+		if (iew->flags & IORING_EPOLL_WAIT_MULTISHOT)
+			return -EINVAL;
+	}
+
+	if (iew->flags & IORING_EPOLL_WAIT_MULTISHOT)
+		req->flags |= REQ_F_APOLL_MULTISHOT;
+	return 0;
+}
+
+int io_epoll_wait(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_epoll_wait *iew = io_kiocb_to_cmd(req, struct io_epoll_wait);
+	struct epoll_event __user *events = iew->events;
+	int maxevents = iew->maxevents;
+	unsigned int cflags = 0;
+	int ret;
+
+	if (io_do_buffer_select(req)) {
+		size_t len = (size_t)maxevents * sizeof(struct epoll_event);
+
+		events = io_buffer_select(req, &len, issue_flags);
+		if (!events)
+			return -ENOBUFS;
+		maxevents = len / sizeof(struct epoll_event);
+	}
+
+	ret = epoll_sendevents(req->file, events, maxevents);
+	if (ret == 0) {
+		/* nothing ready, recycle the buffer and wait for poll */
+		io_kbuf_recycle(req, issue_flags);
+		if (issue_flags & IO_URING_F_MULTISHOT)
+			return IOU_ISSUE_SKIP_COMPLETE;
+		return -EAGAIN;
+	}
+
+	if (ret > 0) {
+		cflags = io_put_kbuf(req, issue_flags);
+		if (req->flags & REQ_F_APOLL_MULTISHOT &&
+		    io_req_post_cqe(req, ret, cflags | IORING_CQE_F_MORE)) {
+			if (issue_flags & IO_URING_F_MULTISHOT) {
+				/*
+				 * More events may have been queued than fit
+				 * the buffer, retry rather than waiting for
+				 * the next wakeup.
+				 */
+				io_poll_multishot_retry(req);
+				return IOU_ISSUE_SKIP_COMPLETE;
+			}
+			return -EAGAIN;
+		}
+	} else {
+		io_kbuf_recycle(req, issue_flags);
+		req_set_fail(req);
+	}
+
+	io_req_set_res(req, ret, cflags);
+	if (issue_flags & IO_URING_F_MULTISHOT)
+		return IOU_STOP_MULTISHOT;
+	return IOU_OK;
+}
 #endif
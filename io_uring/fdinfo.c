@@ -66,8 +66,10 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	unsigned int sq_entries, cq_entries;
 	int sq_pid = -1, sq_cpu = -1;
 	u64 sq_total_time = 0, sq_work_time = 0;
+	unsigned long iowq_local = 0, iowq_remote = 0;
 	bool has_lock;
 	unsigned int i;
+	int cpu;
 
 	if (ctx->flags & IORING_SETUP_CQE32)
 		cq_shift = 1;
@@ -165,6 +167,14 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	seq_printf(m, "SqThreadCpu:\t%d\n", sq_cpu);
 	seq_printf(m, "SqTotalTime:\t%llu\n", sq_total_time);
 	seq_printf(m, "SqWorkTime:\t%llu\n", sq_work_time);
+	for_each_possible_cpu(cpu) {
+		struct io_iowq_stats *st = per_cpu_ptr(ctx->iowq_stats, cpu);
+
+		iowq_local += READ_ONCE(st->local_work);
+		iowq_remote += READ_ONCE(st->remote_work);
+	}
+	seq_printf(m, "IoWqLocalWork:\t%lu\n", iowq_local);
+	seq_printf(m, "IoWqRemoteWork:\t%lu\n", iowq_remote);
 	seq_printf(m, "UserFiles:\t%u\n", ctx->nr_user_files);
 	for (i = 0; has_lock && i < ctx->nr_user_files; i++) {
 		struct file *f = io_file_from_index(&ctx->file_table, i);
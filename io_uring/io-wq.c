@@ -24,6 +24,12 @@
 
 #define WORKER_IDLE_TIMEOUT	(5 * HZ)
 
+/*
+ * Bounded work queued from one node is only run by a worker on another node
+ * once this many items are pending for the submitting node.
+ */
+#define IO_WQ_NODE_STEAL_THRESHOLD	8
+
 enum {
 	IO_WORKER_F_UP		= 0,	/* up and active */
 	IO_WORKER_F_RUNNING	= 1,	/* account as running */
@@ -50,6 +56,7 @@ struct io_worker {
 	struct list_head all_list;
 	struct task_struct *task;
 	struct io_wq *wq;
+	int node;
 
 	struct io_wq_work *cur_work;
 	raw_spinlock_t lock;
@@ -81,6 +88,14 @@ struct io_wq_acct {
 	raw_spinlock_t lock;
 	struct io_wq_work_list work_list;
 	unsigned long flags;
+	/*
+	 * Per-node pending work (protected by ->lock) and idle workers
+	 * (changed under wq->lock, read locklessly). Only the bound acct
+	 * tracks these, see io_worker_may_run().
+	 */
+	unsigned nr_hashed;
+	unsigned *node_pending;
+	unsigned *node_idle;
 };
 
 enum {
@@ -132,7 +147,7 @@ struct io_cb_cancel_data {
 	bool cancel_all;
 };
 
-static bool create_io_worker(struct io_wq *wq, int index);
+static bool create_io_worker(struct io_wq *wq, int index, int node);
 static void io_wq_dec_running(struct io_worker *worker);
 static bool io_acct_cancel_pending_work(struct io_wq *wq,
 					struct io_wq_acct *acct,
@@ -167,6 +182,16 @@ static inline struct io_wq_acct *io_wq_get_acct(struct io_worker *worker)
 	return io_get_acct(worker->wq, test_bit(IO_WORKER_F_BOUND, &worker->flags));
 }
 
+/* @worker joins or leaves the free list, see io_acct_node_may_steal() */
+static inline void io_worker_node_idle(struct io_wq_acct *acct,
+				       struct io_worker *worker, int delta)
+	__must_hold(worker->wq->lock)
+{
+	if (acct->node_idle)
+		WRITE_ONCE(acct->node_idle[worker->node],
+			   acct->node_idle[worker->node] + delta);
+}
+
 static void io_worker_ref_put(struct io_wq *wq)
 {
 	if (atomic_dec_and_test(&wq->worker_refs))
@@ -209,6 +234,7 @@ static bool io_task_worker_match(struct callback_head *cb, void *data)
 
 static void io_worker_exit(struct io_worker *worker)
 {
+	struct io_wq_acct *acct = io_wq_get_acct(worker);
 	struct io_wq *wq = worker->wq;
 
 	while (1) {
@@ -224,8 +250,10 @@ static void io_worker_exit(struct io_worker *worker)
 	wait_for_completion(&worker->ref_done);
 
 	raw_spin_lock(&wq->lock);
-	if (test_bit(IO_WORKER_F_FREE, &worker->flags))
+	if (test_bit(IO_WORKER_F_FREE, &worker->flags)) {
 		hlist_nulls_del_rcu(&worker->nulls_node);
+		io_worker_node_idle(acct, worker, -1);
+	}
 	list_del_rcu(&worker->all_list);
 	raw_spin_unlock(&wq->lock);
 	io_wq_dec_running(worker);
@@ -247,6 +275,77 @@ static inline bool __io_acct_run_queue(struct io_wq_acct *acct)
 		!wq_list_empty(&acct->work_list);
 }
 
+/*
+ * Remote work is only stolen if the submitting node has built up a backlog,
+ * or if there's no idle worker on that node that could run it right away.
+ */
+static inline bool io_acct_node_may_steal(struct io_wq_acct *acct, int node)
+{
+	return acct->node_pending[node] > IO_WQ_NODE_STEAL_THRESHOLD ||
+		!READ_ONCE(acct->node_idle[node]);
+}
+
+/*
+ * Check if @worker may pick up work queued from @node. Workers prefer work
+ * submitted from their own node, as that's where the page cache and buffers
+ * it touches are most likely to live.
+ */
+static bool io_worker_may_run(struct io_wq_acct *acct,
+			      struct io_worker *worker, int node)
+	__must_hold(acct->lock)
+{
+	if (!acct->node_pending || worker->node == node)
+		return true;
+	if (test_bit(IO_WQ_BIT_EXIT, &worker->wq->state))
+		return true;
+	return io_acct_node_may_steal(acct, node);
+}
+
+static bool io_worker_has_work(struct io_wq_acct *acct,
+			       struct io_worker *worker)
+	__must_hold(acct->lock)
+{
+	int node;
+
+	if (!acct->node_pending || acct->nr_hashed ||
+	    acct->node_pending[worker->node])
+		return true;
+	for (node = 0; node < nr_node_ids; node++) {
+		if (acct->node_pending[node] &&
+		    io_worker_may_run(acct, worker, node))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Hashed work is serialized per hash bucket and a whole chain is run by one
+ * worker, so only unhashed work is subject to node placement.
+ */
+static inline void io_acct_inc_pending(struct io_wq_acct *acct,
+				       struct io_wq_work *work)
+	__must_hold(acct->lock)
+{
+	if (!acct->node_pending)
+		return;
+	if (io_wq_is_hashed(work))
+		acct->nr_hashed++;
+	else
+		acct->node_pending[io_wq_work_node(work)]++;
+}
+
+static inline void io_acct_dec_pending(struct io_wq_acct *acct,
+				       struct io_wq_work *work)
+	__must_hold(acct->lock)
+{
+	if (!acct->node_pending)
+		return;
+	if (io_wq_is_hashed(work))
+		acct->nr_hashed--;
+	else
+		acct->node_pending[io_wq_work_node(work)]--;
+}
+
 /*
  * If there's work to do, returns true with acct->lock acquired. If not,
  * returns false with no lock held.
@@ -262,12 +361,29 @@ static inline bool io_acct_run_queue(struct io_wq_acct *acct)
 	return false;
 }
 
+/*
+ * Like io_acct_run_queue(), but only returns true if there's work that
+ * @worker is allowed to run.
+ */
+static inline bool io_worker_run_queue(struct io_wq_acct *acct,
+				       struct io_worker *worker)
+	__acquires(&acct->lock)
+{
+	raw_spin_lock(&acct->lock);
+	if (__io_acct_run_queue(acct) && io_worker_has_work(acct, worker))
+		return true;
+
+	raw_spin_unlock(&acct->lock);
+	return false;
+}
+
 /*
  * Check head of free list for an available worker. If one isn't available,
- * caller must create one.
+ * caller must create one. If @node isn't NUMA_NO_NODE, only workers on that
+ * node are considered.
  */
 static bool io_wq_activate_free_worker(struct io_wq *wq,
-					struct io_wq_acct *acct)
+					struct io_wq_acct *acct, int node)
 	__must_hold(RCU)
 {
 	struct hlist_nulls_node *n;
@@ -281,7 +397,8 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
 	hlist_nulls_for_each_entry_rcu(worker, n, &wq->free_list, nulls_node) {
 		if (!io_worker_get(worker))
 			continue;
-		if (io_wq_get_acct(worker) != acct) {
+		if (io_wq_get_acct(worker) != acct ||
+		    (node != NUMA_NO_NODE && worker->node != node)) {
 			io_worker_release(worker);
 			continue;
 		}
@@ -302,7 +419,8 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
  * We need a worker. If we find a free one, we're good. If not, and we're
  * below the max number of workers, create one.
  */
-static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
+static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct,
+				int node)
 {
 	/*
 	 * Most likely an attempt to queue unbounded work on an io_wq that
@@ -320,7 +438,7 @@ static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
 	raw_spin_unlock(&wq->lock);
 	atomic_inc(&acct->nr_running);
 	atomic_inc(&wq->worker_refs);
-	return create_io_worker(wq, acct->index);
+	return create_io_worker(wq, acct->index, node);
 }
 
 static void io_wq_inc_running(struct io_worker *worker)
@@ -349,7 +467,7 @@ static void create_worker_cb(struct callback_head *cb)
 	}
 	raw_spin_unlock(&wq->lock);
 	if (do_create) {
-		create_io_worker(wq, worker->create_index);
+		create_io_worker(wq, worker->create_index, worker->node);
 	} else {
 		atomic_dec(&acct->nr_running);
 		io_worker_ref_put(wq);
@@ -433,6 +551,7 @@ static void __io_worker_busy(struct io_wq *wq, struct io_worker *worker)
 		clear_bit(IO_WORKER_F_FREE, &worker->flags);
 		raw_spin_lock(&wq->lock);
 		hlist_nulls_del_init_rcu(&worker->nulls_node);
+		io_worker_node_idle(io_wq_get_acct(worker), worker, -1);
 		raw_spin_unlock(&wq->lock);
 	}
 }
@@ -446,6 +565,7 @@ static void __io_worker_idle(struct io_wq *wq, struct io_worker *worker)
 	if (!test_bit(IO_WORKER_F_FREE, &worker->flags)) {
 		set_bit(IO_WORKER_F_FREE, &worker->flags);
 		hlist_nulls_add_head_rcu(&worker->nulls_node, &wq->free_list);
+		io_worker_node_idle(io_wq_get_acct(worker), worker, 1);
 	}
 }
 
@@ -487,7 +607,11 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 
 		/* not hashed, can run anytime */
 		if (!io_wq_is_hashed(work)) {
+			/* but leave work from other nodes to their own workers */
+			if (!io_worker_may_run(acct, worker, io_wq_work_node(work)))
+				continue;
 			wq_list_del(&acct->work_list, node, prev);
+			io_acct_dec_pending(acct, work);
 			return work;
 		}
 
@@ -499,6 +623,10 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 		if (!test_and_set_bit(hash, &wq->hash->map)) {
 			wq->hash_tail[hash] = NULL;
 			wq_list_cut(&acct->work_list, &tail->list, prev);
+			if (acct->node_pending) {
+				for (tail = work; tail; tail = wq_next_work(tail))
+					io_acct_dec_pending(acct, tail);
+			}
 			return work;
 		}
 		if (stall_hash == -1U)
@@ -589,6 +717,7 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 		do {
 			struct io_wq_work *next_hashed, *linked;
 			unsigned int hash = io_get_work_hash(work);
+			int node = io_wq_work_node(work);
 
 			next_hashed = wq_next_work(work);
 
@@ -600,6 +729,9 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 			linked = wq->free_work(work);
 			work = next_hashed;
 			if (!work && linked && !io_wq_is_hashed(linked)) {
+				/* inherits the submitting node of its parent */
+				linked->flags &= ~(IO_WQ_NODE_MASK << IO_WQ_NODE_SHIFT);
+				linked->flags |= node << IO_WQ_NODE_SHIFT;
 				work = linked;
 				linked = NULL;
 			}
@@ -647,7 +779,7 @@ static int io_wq_worker(void *data)
 		 * If we have work to do, io_acct_run_queue() returns with
 		 * the acct->lock held. If not, it will drop it.
 		 */
-		while (io_acct_run_queue(acct))
+		while (io_worker_run_queue(acct, worker))
 			io_worker_handle_work(acct, worker);
 
 		raw_spin_lock(&wq->lock);
@@ -724,17 +856,43 @@ void io_wq_worker_sleeping(struct task_struct *tsk)
 	io_wq_dec_running(worker);
 }
 
+/*
+ * Keep the worker on its home node, unless the io-wq affinity mask doesn't
+ * include any CPUs of that node.
+ */
+static void io_worker_set_affinity(struct io_wq *wq, struct io_worker *worker,
+				   struct task_struct *tsk)
+{
+	cpumask_var_t mask;
+
+	if (nr_node_ids > 1 && alloc_cpumask_var(&mask, GFP_KERNEL)) {
+		bool local;
+
+		local = cpumask_and(mask, wq->cpu_mask,
+				    cpumask_of_node(worker->node));
+		if (local)
+			set_cpus_allowed_ptr(tsk, mask);
+		free_cpumask_var(mask);
+		if (local)
+			return;
+	}
+	set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+}
+
 static void io_init_new_worker(struct io_wq *wq, struct io_worker *worker,
 			       struct task_struct *tsk)
 {
+	struct io_wq_acct *acct = io_wq_get_acct(worker);
+
 	tsk->worker_private = worker;
 	worker->task = tsk;
-	set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+	io_worker_set_affinity(wq, worker, tsk);
 
 	raw_spin_lock(&wq->lock);
 	hlist_nulls_add_head_rcu(&worker->nulls_node, &wq->free_list);
 	list_add_tail_rcu(&worker->all_list, &wq->all_list);
 	set_bit(IO_WORKER_F_FREE, &worker->flags);
+	io_worker_node_idle(acct, worker, 1);
 	raw_spin_unlock(&wq->lock);
 	wake_up_new_task(tsk);
 }
@@ -773,7 +931,7 @@ static void create_worker_cont(struct callback_head *cb)
 	worker = container_of(cb, struct io_worker, create_work);
 	clear_bit_unlock(0, &worker->create_state);
 	wq = worker->wq;
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, worker->node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 		io_worker_release(worker);
@@ -815,7 +973,7 @@ static void io_workqueue_create(struct work_struct *work)
 		kfree(worker);
 }
 
-static bool create_io_worker(struct io_wq *wq, int index)
+static bool create_io_worker(struct io_wq *wq, int index, int node)
 {
 	struct io_wq_acct *acct = &wq->acct[index];
 	struct io_worker *worker;
@@ -836,13 +994,14 @@ static bool create_io_worker(struct io_wq *wq, int index)
 
 	refcount_set(&worker->ref, 1);
 	worker->wq = wq;
+	worker->node = node;
 	raw_spin_lock_init(&worker->lock);
 	init_completion(&worker->ref_done);
 
 	if (index == IO_WQ_ACCT_BOUND)
 		set_bit(IO_WORKER_F_BOUND, &worker->flags);
 
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 	} else if (!io_should_retry_thread(PTR_ERR(tsk))) {
@@ -903,6 +1062,7 @@ static void io_wq_insert_work(struct io_wq *wq, struct io_wq_work *work)
 	unsigned int hash;
 	struct io_wq_work *tail;
 
+	io_acct_inc_pending(acct, work);
 	if (!io_wq_is_hashed(work)) {
 append:
 		wq_list_add_tail(&work->list, &acct->work_list);
@@ -926,13 +1086,14 @@ static bool io_wq_work_match_item(struct io_wq_work *work, void *data)
 void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 {
 	struct io_wq_acct *acct = io_work_get_acct(wq, work);
-	unsigned long work_flags = work->flags;
+	unsigned long work_flags;
 	struct io_cb_cancel_data match = {
 		.fn		= io_wq_work_match_item,
 		.data		= work,
 		.cancel_all	= false,
 	};
-	bool do_create;
+	bool do_create, may_steal = true;
+	int node = numa_node_id();
 
 	/*
 	 * If io-wq is exiting for this task, or if the request has explicitly
@@ -944,20 +1105,32 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 		return;
 	}
 
+	work->flags &= ~(IO_WQ_NODE_MASK << IO_WQ_NODE_SHIFT);
+	work->flags |= node << IO_WQ_NODE_SHIFT;
+	work_flags = work->flags;
+
 	raw_spin_lock(&acct->lock);
 	io_wq_insert_work(wq, work);
 	clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+	if (acct->node_pending && !io_wq_is_hashed(work))
+		may_steal = io_acct_node_may_steal(acct, node);
 	raw_spin_unlock(&acct->lock);
 
+	/*
+	 * Prefer an idle worker on the submitting node, and only fall back to
+	 * one from another node if it would be allowed to run this work.
+	 */
 	rcu_read_lock();
-	do_create = !io_wq_activate_free_worker(wq, acct);
+	do_create = !io_wq_activate_free_worker(wq, acct, node);
+	if (do_create && nr_node_ids > 1 && may_steal)
+		do_create = !io_wq_activate_free_worker(wq, acct, NUMA_NO_NODE);
 	rcu_read_unlock();
 
 	if (do_create && ((work_flags & IO_WQ_WORK_CONCURRENT) ||
 	    !atomic_read(&acct->nr_running))) {
 		bool did_create;
 
-		did_create = io_wq_create_worker(wq, acct);
+		did_create = io_wq_create_worker(wq, acct, node);
 		if (likely(did_create))
 			return;
 
@@ -1031,6 +1204,7 @@ static inline void io_wq_remove_pending(struct io_wq *wq,
 			wq->hash_tail[hash] = NULL;
 	}
 	wq_list_del(&acct->work_list, &work->list, prev);
+	io_acct_dec_pending(acct, work);
 }
 
 static bool io_acct_cancel_pending_work(struct io_wq *wq,
@@ -1133,7 +1307,7 @@ static int io_wq_hash_wake(struct wait_queue_entry *wait, unsigned mode,
 		struct io_wq_acct *acct = &wq->acct[i];
 
 		if (test_and_clear_bit(IO_ACCT_STALLED_BIT, &acct->flags))
-			io_wq_activate_free_worker(wq, acct);
+			io_wq_activate_free_worker(wq, acct, NUMA_NO_NODE);
 	}
 	rcu_read_unlock();
 	return 1;
@@ -1163,6 +1337,18 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 	if (!alloc_cpumask_var(&wq->cpu_mask, GFP_KERNEL))
 		goto err;
 	cpumask_copy(wq->cpu_mask, cpu_possible_mask);
+	if (nr_node_ids > 1) {
+		struct io_wq_acct *acct = &wq->acct[IO_WQ_ACCT_BOUND];
+
+		acct->node_pending = kcalloc(nr_node_ids,
+					     sizeof(*acct->node_pending),
+					     GFP_KERNEL);
+		acct->node_idle = kcalloc(nr_node_ids,
+					  sizeof(*acct->node_idle),
+					  GFP_KERNEL);
+		if (!acct->node_pending || !acct->node_idle)
+			goto err;
+	}
 	wq->acct[IO_WQ_ACCT_BOUND].max_workers = bounded;
 	wq->acct[IO_WQ_ACCT_UNBOUND].max_workers =
 				task_rlimit(current, RLIMIT_NPROC);
@@ -1192,6 +1378,8 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 err:
 	io_wq_put_hash(data->hash);
 	free_cpumask_var(wq->cpu_mask);
+	kfree(wq->acct[IO_WQ_ACCT_BOUND].node_pending);
+	kfree(wq->acct[IO_WQ_ACCT_BOUND].node_idle);
 	kfree(wq);
 	return ERR_PTR(ret);
 }
@@ -1260,6 +1448,8 @@ static void io_wq_destroy(struct io_wq *wq)
 	cpuhp_state_remove_instance_nocalls(io_wq_online, &wq->cpuhp_node);
 	io_wq_cancel_pending_work(wq, &match);
 	free_cpumask_var(wq->cpu_mask);
+	kfree(wq->acct[IO_WQ_ACCT_BOUND].node_pending);
+	kfree(wq->acct[IO_WQ_ACCT_BOUND].node_idle);
 	io_wq_put_hash(wq->hash);
 	kfree(wq);
 }
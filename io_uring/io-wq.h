@@ -12,6 +12,8 @@ enum {
 	IO_WQ_WORK_UNBOUND	= 4,
 	IO_WQ_WORK_CONCURRENT	= 16,
 
+	IO_WQ_NODE_SHIFT	= 8,	/* bits 8..23 hold the submitting node */
+	IO_WQ_NODE_MASK		= 0xffff,
 	IO_WQ_HASH_SHIFT	= 24,	/* upper 8 bits are used for hash key */
 };
 
@@ -59,6 +61,12 @@ static inline bool io_wq_is_hashed(struct io_wq_work *work)
 	return work->flags & IO_WQ_WORK_HASHED;
 }
 
+/* NUMA node of the task that queued @work, stamped by io_wq_enqueue() */
+static inline int io_wq_work_node(struct io_wq_work *work)
+{
+	return (work->flags >> IO_WQ_NODE_SHIFT) & IO_WQ_NODE_MASK;
+}
+
 typedef bool (work_cancel_fn)(struct io_wq_work *, void *);
 
 enum io_wq_cancel io_wq_cancel_cb(struct io_wq *wq, work_cancel_fn *cancel,
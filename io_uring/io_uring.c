@@ -297,6 +297,9 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	if (percpu_ref_init(&ctx->refs, io_ring_ctx_ref_free,
 			    0, GFP_KERNEL))
 		goto err;
+	ctx->iowq_stats = alloc_percpu(struct io_iowq_stats);
+	if (!ctx->iowq_stats)
+		goto err;
 
 	ctx->flags = p->flags;
 	atomic_set(&ctx->cq_wait_nr, IO_CQ_WAKE_INIT);
@@ -351,6 +354,7 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	io_alloc_cache_free(&ctx->rw_cache, io_rw_cache_free);
 	io_alloc_cache_free(&ctx->uring_cache, kfree);
 	io_futex_cache_free(ctx);
+	free_percpu(ctx->iowq_stats);
 	kfree(ctx->cancel_table.hbs);
 	kfree(ctx->cancel_table_locked.hbs);
 	xa_destroy(&ctx->io_bl_xa);
@@ -1623,6 +1627,9 @@ static void io_iopoll_req_issued(struct io_kiocb *req, unsigned int issue_flags)
 	 * For fast devices, IO may have already completed. If it has, add
 	 * it to the front so we find it first.
 	 */
+	if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)
+		req->iopoll_start = ktime_get_ns();
+
 	if (READ_ONCE(req->iopoll_completed))
 		wq_list_add_head(&req->comp_list, &ctx->iopoll_list);
 	else
@@ -1719,6 +1726,38 @@ static __cold void io_drain_req(struct io_kiocb *req)
 	spin_unlock(&ctx->completion_lock);
 }
 
+/*
+ * Inside io_submit_sqes(), grab enough file references upfront to cover the
+ * rest of the batch, so that SQEs targeting the same fd don't each have to
+ * bump the file refcount. Unused references are dropped when the batch ends.
+ */
+static struct file *io_file_get_batched(struct io_kiocb *req, int fd)
+	__must_hold(&req->ctx->uring_lock)
+{
+	struct io_submit_state *state = &req->ctx->submit_state;
+	struct file *file;
+
+	if (state->file_refs && state->file_fd == fd) {
+		state->file_refs--;
+		file = state->file;
+	} else {
+		io_submit_state_put_file(state);
+		file = fget_many(fd, state->ios_left);
+		if (file) {
+			state->file = file;
+			state->file_fd = fd;
+			state->file_refs = state->ios_left - 1;
+		}
+	}
+
+	trace_io_uring_file_get(req, fd);
+
+	/* we don't allow fixed io_uring files */
+	if (file && io_is_uring_fops(file))
+		io_req_track_inflight(req);
+	return file;
+}
+
 static bool io_assign_file(struct io_kiocb *req, const struct io_issue_def *def,
 			   unsigned int issue_flags)
 {
@@ -1727,6 +1766,9 @@ static bool io_assign_file(struct io_kiocb *req, const struct io_issue_def *def,
 
 	if (req->flags & REQ_F_FIXED_FILE)
 		req->file = io_file_get_fixed(req, req->cqe.fd, issue_flags);
+	else if (!(issue_flags & IO_URING_F_UNLOCKED) &&
+		 req->ctx->submit_state.ios_left)
+		req->file = io_file_get_batched(req, req->cqe.fd);
 	else
 		req->file = io_file_get_normal(req, req->cqe.fd);
 
@@ -1824,6 +1866,11 @@ void io_wq_submit_work(struct io_wq_work *work)
 		goto fail;
 	}
 
+	if (io_wq_work_node(work) == numa_node_id())
+		this_cpu_inc(req->ctx->iowq_stats->local_work);
+	else
+		this_cpu_inc(req->ctx->iowq_stats->remote_work);
+
 	/*
 	 * If DEFER_TASKRUN is set, it's only allowed to post CQEs from the
 	 * submitter task context. Final request completions are handed to the
@@ -2235,6 +2282,8 @@ static void io_submit_state_end(struct io_ring_ctx *ctx)
 	io_submit_flush_completions(ctx);
 	if (state->plug_started)
 		blk_finish_plug(&state->plug);
+	io_submit_state_put_file(state);
+	state->ios_left = 0;
 }
 
 /*
@@ -2328,6 +2377,7 @@ int io_submit_sqes(struct io_ring_ctx *ctx, unsigned int nr)
 			io_req_add_to_cache(req, ctx);
 			break;
 		}
+		ctx->submit_state.ios_left = left;
 
 		/*
 		 * Continue submitting even for sqe failure if the
@@ -2416,7 +2466,16 @@ static inline int io_cqring_wait_schedule(struct io_ring_ctx *ctx,
 	if (current_pending_io())
 		current->in_iowait = 1;
 	ret = 0;
-	if (iowq->timeout == KTIME_MAX)
+	if (iowq->min_timeout) {
+		if (!schedule_hrtimeout(&iowq->min_timeout, HRTIMER_MODE_ABS)) {
+			/*
+			 * The minimum wait time has passed, from now on any
+			 * available CQE is enough to return to the application.
+			 */
+			iowq->min_timeout = 0;
+			iowq->cq_tail = iowq->cq_min_tail + 1;
+		}
+	} else if (iowq->timeout == KTIME_MAX)
 		schedule();
 	else if (!schedule_hrtimeout(&iowq->timeout, HRTIMER_MODE_ABS))
 		ret = -ETIME;
@@ -2424,13 +2483,25 @@ static inline int io_cqring_wait_schedule(struct io_ring_ctx *ctx,
 	return ret;
 }
 
+struct ext_arg {
+	size_t argsz;
+	struct timespec64 ts;
+	const sigset_t __user *sig;
+	ktime_t min_time;
+	bool ts_set;
+};
+
 /*
  * Wait until events become available, if we don't already have some. The
  * application must reap them itself, as they reside on the shared cq ring.
+ *
+ * If a minimum wait time is given, wait for @min_events until that time has
+ * passed, and then return as soon as any CQE is available. This allows
+ * batching completions without risking unbounded latency if fewer than
+ * @min_events arrive.
  */
 static int io_cqring_wait(struct io_ring_ctx *ctx, int min_events,
-			  const sigset_t __user *sig, size_t sigsz,
-			  struct __kernel_timespec __user *uts)
+			  struct ext_arg *ext_arg)
 {
 	struct io_wait_queue iowq;
 	struct io_rings *rings = ctx->rings;
@@ -2452,27 +2523,32 @@ static int io_cqring_wait(struct io_ring_ctx *ctx, int min_events,
 	INIT_LIST_HEAD(&iowq.wq.entry);
 	iowq.ctx = ctx;
 	iowq.nr_timeouts = atomic_read(&ctx->cq_timeouts);
-	iowq.cq_tail = READ_ONCE(ctx->rings->cq.head) + min_events;
+	iowq.cq_min_tail = READ_ONCE(ctx->rings->cq.head);
+	iowq.cq_tail = iowq.cq_min_tail + min_events;
 	iowq.timeout = KTIME_MAX;
+	iowq.min_timeout = 0;
 
-	if (uts) {
-		struct timespec64 ts;
-
-		if (get_timespec64(&ts, uts))
-			return -EFAULT;
-
-		iowq.timeout = ktime_add_ns(timespec64_to_ktime(ts), ktime_get_ns());
-		io_napi_adjust_timeout(ctx, &iowq, &ts);
+	if (ext_arg->ts_set) {
+		iowq.timeout = ktime_add_ns(timespec64_to_ktime(ext_arg->ts),
+					    ktime_get_ns());
+		io_napi_adjust_timeout(ctx, &iowq, &ext_arg->ts);
+	}
+	if (ext_arg->min_time) {
+		iowq.min_timeout = ktime_add_ns(ext_arg->min_time,
+						ktime_get_ns());
+		/* a min wait past the overall timeout is just a timeout */
+		if (iowq.min_timeout >= iowq.timeout)
+			iowq.min_timeout = 0;
 	}
 
-	if (sig) {
+	if (ext_arg->sig) {
 #ifdef CONFIG_COMPAT
 		if (in_compat_syscall())
-			ret = set_compat_user_sigmask((const compat_sigset_t __user *)sig,
-						      sigsz);
+			ret = set_compat_user_sigmask((const compat_sigset_t __user *)ext_arg->sig,
+						      ext_arg->argsz);
 		else
 #endif
-			ret = set_user_sigmask(sig, sigsz);
+			ret = set_user_sigmask(ext_arg->sig, ext_arg->argsz);
 
 		if (ret)
 			return ret;
@@ -2651,6 +2727,7 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	io_alloc_cache_free(&ctx->uring_cache, kfree);
 	io_futex_cache_free(ctx);
 	io_destroy_buffers(ctx);
+	io_unregister_cqwait_reg(ctx);
 	mutex_unlock(&ctx->uring_lock);
 	if (ctx->sq_creds)
 		put_cred(ctx->sq_creds);
@@ -2672,6 +2749,7 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	io_rings_free(ctx);
 
 	percpu_ref_exit(&ctx->refs);
+	free_percpu(ctx->iowq_stats);
 	free_uid(ctx->user);
 	io_req_caches_free(ctx);
 	if (ctx->hash_map)
@@ -3134,32 +3212,77 @@ void __io_uring_cancel(bool cancel_all)
 	io_uring_cancel_generic(cancel_all, NULL);
 }
 
-static int io_validate_ext_arg(unsigned flags, const void __user *argp, size_t argsz)
+/*
+ * With IORING_ENTER_EXT_ARG_REG, argp is an index into the wait argument
+ * array registered with IORING_REGISTER_CQWAIT_REG.
+ */
+static struct io_uring_reg_wait *io_get_ext_arg_reg(struct io_ring_ctx *ctx,
+						    const void __user *argp)
 {
-	if (flags & IORING_ENTER_EXT_ARG) {
-		struct io_uring_getevents_arg arg;
+	unsigned long index = (unsigned long) argp;
 
-		if (argsz != sizeof(arg))
+	if (unlikely(index >= ctx->cq_wait_reg_nr))
+		return ERR_PTR(-EFAULT);
+	index = array_index_nospec(index, ctx->cq_wait_reg_nr);
+	return ctx->cq_wait_arg + index;
+}
+
+static int io_validate_ext_arg(struct io_ring_ctx *ctx, unsigned flags,
+			       const void __user *argp, size_t argsz)
+{
+	struct io_uring_getevents_arg arg;
+
+	if (!(flags & IORING_ENTER_EXT_ARG))
+		return 0;
+	if (flags & IORING_ENTER_EXT_ARG_REG) {
+		if (argsz != sizeof(struct io_uring_reg_wait))
 			return -EINVAL;
-		if (copy_from_user(&arg, argp, sizeof(arg)))
-			return -EFAULT;
+		return PTR_ERR_OR_ZERO(io_get_ext_arg_reg(ctx, argp));
 	}
+	if (argsz != sizeof(arg))
+		return -EINVAL;
+	if (copy_from_user(&arg, argp, sizeof(arg)))
+		return -EFAULT;
 	return 0;
 }
 
-static int io_get_ext_arg(unsigned flags, const void __user *argp, size_t *argsz,
-			  struct __kernel_timespec __user **ts,
-			  const sigset_t __user **sig)
+static int io_get_ext_arg(struct io_ring_ctx *ctx, unsigned flags,
+			  const void __user *argp, struct ext_arg *ext_arg)
 {
 	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec __user *uts;
 
 	/*
 	 * If EXT_ARG isn't set, then we have no timespec and the argp pointer
 	 * is just a pointer to the sigset_t.
 	 */
 	if (!(flags & IORING_ENTER_EXT_ARG)) {
-		*sig = (const sigset_t __user *) argp;
-		*ts = NULL;
+		ext_arg->sig = (const sigset_t __user *) argp;
+		return 0;
+	}
+
+	if (flags & IORING_ENTER_EXT_ARG_REG) {
+		struct io_uring_reg_wait *w;
+		u32 wflags;
+
+		if (ext_arg->argsz != sizeof(struct io_uring_reg_wait))
+			return -EINVAL;
+		w = io_get_ext_arg_reg(ctx, argp);
+		if (IS_ERR(w))
+			return PTR_ERR(w);
+
+		/* the region is shared with the application, read it once */
+		wflags = READ_ONCE(w->flags);
+		if (wflags & ~IORING_REG_WAIT_TS)
+			return -EINVAL;
+		if (wflags & IORING_REG_WAIT_TS) {
+			ext_arg->ts.tv_sec = READ_ONCE(w->ts.tv_sec);
+			ext_arg->ts.tv_nsec = READ_ONCE(w->ts.tv_nsec);
+			ext_arg->ts_set = true;
+		}
+		ext_arg->min_time = (u64) READ_ONCE(w->min_wait_usec) * NSEC_PER_USEC;
+		ext_arg->sig = u64_to_user_ptr(READ_ONCE(w->sigmask));
+		ext_arg->argsz = READ_ONCE(w->sigmask_sz);
 		return 0;
 	}
 
@@ -3167,15 +3290,19 @@ static int io_get_ext_arg(unsigned flags, const void __user *argp, size_t *argsz
 	 * EXT_ARG is set - ensure we agree on the size of it and copy in our
 	 * timespec and sigset_t pointers if good.
 	 */
-	if (*argsz != sizeof(arg))
+	if (ext_arg->argsz != sizeof(arg))
 		return -EINVAL;
 	if (copy_from_user(&arg, argp, sizeof(arg)))
 		return -EFAULT;
-	if (arg.pad)
-		return -EINVAL;
-	*sig = u64_to_user_ptr(arg.sigmask);
-	*argsz = arg.sigmask_sz;
-	*ts = u64_to_user_ptr(arg.ts);
+	ext_arg->min_time = (u64) arg.min_wait_usec * NSEC_PER_USEC;
+	ext_arg->sig = u64_to_user_ptr(arg.sigmask);
+	ext_arg->argsz = arg.sigmask_sz;
+	uts = u64_to_user_ptr(arg.ts);
+	if (uts) {
+		if (get_timespec64(&ext_arg->ts, uts))
+			return -EFAULT;
+		ext_arg->ts_set = true;
+	}
 	return 0;
 }
 
@@ -3189,7 +3316,12 @@ SYSCALL_DEFINE6(io_uring_enter, unsigned int, fd, u32, to_submit,
 
 	if (unlikely(flags & ~(IORING_ENTER_GETEVENTS | IORING_ENTER_SQ_WAKEUP |
 			       IORING_ENTER_SQ_WAIT | IORING_ENTER_EXT_ARG |
-			       IORING_ENTER_REGISTERED_RING)))
+			       IORING_ENTER_REGISTERED_RING |
+			       IORING_ENTER_EXT_ARG_REG)))
+		return -EINVAL;
+	/* a registered wait argument is a kind of extended argument */
+	if (unlikely((flags & (IORING_ENTER_EXT_ARG | IORING_ENTER_EXT_ARG_REG)) ==
+		     IORING_ENTER_EXT_ARG_REG))
 		return -EINVAL;
 
 	/*
@@ -3272,7 +3404,7 @@ SYSCALL_DEFINE6(io_uring_enter, unsigned int, fd, u32, to_submit,
 			 */
 			mutex_lock(&ctx->uring_lock);
 iopoll_locked:
-			ret2 = io_validate_ext_arg(flags, argp, argsz);
+			ret2 = io_validate_ext_arg(ctx, flags, argp, argsz);
 			if (likely(!ret2)) {
 				min_complete = min(min_complete,
 						   ctx->cq_entries);
@@ -3280,15 +3412,14 @@ SYSCALL_DEFINE6(io_uring_enter, unsigned int, fd, u32, to_submit,
 			}
 			mutex_unlock(&ctx->uring_lock);
 		} else {
-			const sigset_t __user *sig;
-			struct __kernel_timespec __user *ts;
+			struct ext_arg ext_arg = { .argsz = argsz };
 
-			ret2 = io_get_ext_arg(flags, argp, &argsz, &ts, &sig);
+			ret2 = io_get_ext_arg(ctx, flags, argp, &ext_arg);
 			if (likely(!ret2)) {
 				min_complete = min(min_complete,
 						   ctx->cq_entries);
-				ret2 = io_cqring_wait(ctx, min_complete, sig,
-						      argsz, ts);
+				ret2 = io_cqring_wait(ctx, min_complete,
+						      &ext_arg);
 			}
 		}
 
@@ -3484,6 +3615,14 @@ static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
 	    !(ctx->flags & IORING_SETUP_SQPOLL))
 		ctx->syscall_iopoll = 1;
 
+	/* HYBRID_IOPOLL only valid with IOPOLL */
+	if ((ctx->flags & (IORING_SETUP_IOPOLL|IORING_SETUP_HYBRID_IOPOLL)) ==
+	    IORING_SETUP_HYBRID_IOPOLL) {
+		ret = -EINVAL;
+		goto err;
+	}
+	ctx->hybrid_poll_time = LLONG_MAX;
+
 	ctx->compat = in_compat_syscall();
 	if (!ns_capable_noaudit(&init_user_ns, CAP_IPC_LOCK))
 		ctx->user = get_uid(current_user());
@@ -3638,7 +3777,7 @@ static long io_uring_setup(u32 entries, struct io_uring_params __user *params)
 			IORING_SETUP_SQE128 | IORING_SETUP_CQE32 |
 			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN |
 			IORING_SETUP_NO_MMAP | IORING_SETUP_REGISTERED_FD_ONLY |
-			IORING_SETUP_NO_SQARRAY))
+			IORING_SETUP_NO_SQARRAY | IORING_SETUP_HYBRID_IOPOLL))
 		return -EINVAL;
 
 	return io_uring_create(entries, &p, params);
@@ -3721,6 +3860,7 @@ static int __init io_uring_init(void)
 	BUILD_BUG_SQE_ELEM(44, __s32,  splice_fd_in);
 	BUILD_BUG_SQE_ELEM(44, __u32,  file_index);
 	BUILD_BUG_SQE_ELEM(44, __u16,  addr_len);
+	BUILD_BUG_SQE_ELEM(44, __u8,   write_stream);
 	BUILD_BUG_SQE_ELEM(46, __u16,  __pad3[0]);
 	BUILD_BUG_SQE_ELEM(48, __u64,  addr3);
 	BUILD_BUG_SQE_ELEM_SIZE(48, 0, cmd);
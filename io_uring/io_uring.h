@@ -39,8 +39,10 @@ struct io_wait_queue {
 	struct wait_queue_entry wq;
 	struct io_ring_ctx *ctx;
 	unsigned cq_tail;
+	unsigned cq_min_tail;
 	unsigned nr_timeouts;
 	ktime_t timeout;
+	ktime_t min_timeout;
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	unsigned int napi_busy_poll_to;
@@ -357,6 +359,18 @@ static inline void io_req_complete_defer(struct io_kiocb *req)
 	wq_list_add_tail(&req->comp_list, &state->compl_reqs);
 }
 
+/*
+ * Drop the references cached for the current submission batch. Must be done
+ * before an fd can get rebound within the batch, e.g. by IORING_OP_CLOSE.
+ */
+static inline void io_submit_state_put_file(struct io_submit_state *state)
+{
+	if (state->file_refs)
+		fput_many(state->file, state->file_refs);
+	state->file = NULL;
+	state->file_refs = 0;
+}
+
 static inline void io_commit_cqring_flush(struct io_ring_ctx *ctx)
 {
 	if (unlikely(ctx->off_timeout_used || ctx->drain_active ||
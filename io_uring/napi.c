@@ -8,6 +8,9 @@
 /* Timeout for cleanout of stale entries. */
 #define NAPI_TIMEOUT		(60 * SEC_CONVERSION)
 
+/* Max number of NAPI ids that can be registered for static tracking. */
+#define IO_NAPI_MAX_STATIC_IDS	128
+
 struct io_napi_entry {
 	unsigned int		napi_id;
 	struct list_head	list;
@@ -18,6 +21,16 @@ struct io_napi_entry {
 	struct rcu_head		rcu;
 };
 
+/*
+ * NAPI ids registered by the application for static tracking. Replaced as a
+ * whole on updates, so the wait path can walk it under RCU without locking.
+ */
+struct io_napi_static {
+	struct rcu_head		rcu;
+	unsigned int		nr;
+	unsigned int		ids[];
+};
+
 static struct io_napi_entry *io_napi_hash_find(struct hlist_head *hash_list,
 					       unsigned int napi_id)
 {
@@ -132,17 +145,30 @@ static bool io_napi_busy_loop_should_end(void *data,
 
 static bool __io_napi_do_busy_loop(struct io_ring_ctx *ctx,
 				   void *loop_end_arg)
+	__must_hold(RCU)
 {
-	struct io_napi_entry *e;
 	bool (*loop_end)(void *, unsigned long) = NULL;
+	u16 budget = READ_ONCE(ctx->napi_busy_poll_budget);
+	bool prefer = READ_ONCE(ctx->napi_prefer_busy_poll);
+	struct io_napi_entry *e;
 	bool is_stale = false;
 
 	if (loop_end_arg)
 		loop_end = io_napi_busy_loop_should_end;
 
+	if (READ_ONCE(ctx->napi_track_mode) == IO_URING_NAPI_TRACKING_STATIC) {
+		struct io_napi_static *ns = rcu_dereference(ctx->napi_static);
+		unsigned int i;
+
+		for (i = 0; ns && i < ns->nr; i++)
+			napi_busy_loop_rcu(ns->ids[i], loop_end, loop_end_arg,
+					   prefer, budget);
+		return false;
+	}
+
 	list_for_each_entry_rcu(e, &ctx->napi_list, list) {
 		napi_busy_loop_rcu(e->napi_id, loop_end, loop_end_arg,
-				   ctx->napi_prefer_busy_poll, BUSY_POLL_BUDGET);
+				   prefer, budget);
 
 		if (time_after(jiffies, e->timeout))
 			is_stale = true;
@@ -151,6 +177,21 @@ static bool __io_napi_do_busy_loop(struct io_ring_ctx *ctx,
 	return is_stale;
 }
 
+static bool io_napi_is_singular(struct io_ring_ctx *ctx)
+{
+	if (READ_ONCE(ctx->napi_track_mode) == IO_URING_NAPI_TRACKING_STATIC) {
+		struct io_napi_static *ns;
+		bool ret;
+
+		rcu_read_lock();
+		ns = rcu_dereference(ctx->napi_static);
+		ret = ns && ns->nr == 1;
+		rcu_read_unlock();
+		return ret;
+	}
+	return list_is_singular(&ctx->napi_list);
+}
+
 static void io_napi_blocking_busy_loop(struct io_ring_ctx *ctx,
 				       struct io_wait_queue *iowq)
 {
@@ -161,7 +202,7 @@ static void io_napi_blocking_busy_loop(struct io_ring_ctx *ctx,
 	/* Singular lists use a different napi loop end check function and are
 	 * only executed once.
 	 */
-	if (list_is_singular(&ctx->napi_list))
+	if (io_napi_is_singular(ctx))
 		loop_end_arg = iowq;
 
 	rcu_read_lock();
@@ -185,28 +226,133 @@ void io_napi_init(struct io_ring_ctx *ctx)
 	spin_lock_init(&ctx->napi_lock);
 	ctx->napi_prefer_busy_poll = false;
 	ctx->napi_busy_poll_to = READ_ONCE(sysctl_net_busy_poll);
+	ctx->napi_busy_poll_budget = BUSY_POLL_BUDGET;
+	ctx->napi_track_mode = IO_URING_NAPI_TRACKING_DYNAMIC;
 }
 
-/*
- * io_napi_free() - Deallocate napi
- * @ctx: pointer to io-uring context structure
- *
- * Free the napi list and the hash table in the io-uring context.
- */
-void io_napi_free(struct io_ring_ctx *ctx)
+static void io_napi_free_dynamic(struct io_ring_ctx *ctx)
 {
 	struct io_napi_entry *e;
-	LIST_HEAD(napi_list);
 	unsigned int i;
 
 	spin_lock(&ctx->napi_lock);
 	hash_for_each(ctx->napi_ht, i, e, node) {
+		list_del_rcu(&e->list);
 		hash_del_rcu(&e->node);
 		kfree_rcu(e, rcu);
 	}
 	spin_unlock(&ctx->napi_lock);
 }
 
+static void io_napi_free_static(struct io_ring_ctx *ctx)
+{
+	struct io_napi_static *ns;
+
+	ns = rcu_replace_pointer(ctx->napi_static, NULL,
+				 lockdep_is_held(&ctx->uring_lock));
+	if (ns)
+		kfree_rcu(ns, rcu);
+}
+
+/*
+ * Add or remove a NAPI id for static tracking. The table is copied, updated
+ * and then swapped in, so that busy pollers never see a partial update.
+ */
+static int io_napi_static_update(struct io_ring_ctx *ctx, unsigned int napi_id,
+				 bool add)
+{
+	struct io_napi_static *old, *new;
+	unsigned int i, nr, found = -1U;
+
+	if (ctx->napi_track_mode != IO_URING_NAPI_TRACKING_STATIC)
+		return -EINVAL;
+	if (napi_id < MIN_NAPI_ID)
+		return -EINVAL;
+
+	old = rcu_dereference_protected(ctx->napi_static,
+					lockdep_is_held(&ctx->uring_lock));
+	nr = old ? old->nr : 0;
+	for (i = 0; i < nr; i++) {
+		if (old->ids[i] == napi_id) {
+			found = i;
+			break;
+		}
+	}
+
+	if (add) {
+		if (found != -1U)
+			return -EEXIST;
+		if (nr >= IO_NAPI_MAX_STATIC_IDS)
+			return -ENOSPC;
+		new = kmalloc(struct_size(new, ids, nr + 1), GFP_KERNEL);
+		if (!new)
+			return -ENOMEM;
+		if (nr)
+			memcpy(new->ids, old->ids, nr * sizeof(new->ids[0]));
+		new->ids[nr] = napi_id;
+		new->nr = nr + 1;
+	} else {
+		if (found == -1U)
+			return -ENOENT;
+		if (nr == 1) {
+			new = NULL;
+		} else {
+			new = kmalloc(struct_size(new, ids, nr - 1), GFP_KERNEL);
+			if (!new)
+				return -ENOMEM;
+			memcpy(new->ids, old->ids, found * sizeof(new->ids[0]));
+			memcpy(&new->ids[found], &old->ids[found + 1],
+			       (nr - found - 1) * sizeof(new->ids[0]));
+			new->nr = nr - 1;
+		}
+	}
+
+	rcu_assign_pointer(ctx->napi_static, new);
+	if (old)
+		kfree_rcu(old, rcu);
+	return 0;
+}
+
+/*
+ * io_napi_free() - Deallocate napi
+ * @ctx: pointer to io-uring context structure
+ *
+ * Free the napi list and the hash table in the io-uring context.
+ */
+void io_napi_free(struct io_ring_ctx *ctx)
+{
+	io_napi_free_dynamic(ctx);
+	/* ctx is going away, nobody else can be updating the static table */
+	kfree(rcu_dereference_raw(ctx->napi_static));
+	RCU_INIT_POINTER(ctx->napi_static, NULL);
+}
+
+static int io_napi_register_napi(struct io_ring_ctx *ctx,
+				 struct io_uring_napi *napi)
+{
+	switch (napi->op_param) {
+	case IO_URING_NAPI_TRACKING_DYNAMIC:
+	case IO_URING_NAPI_TRACKING_STATIC:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	/* clean the napi list for a new tracking mode */
+	if (ctx->napi_track_mode != napi->op_param) {
+		io_napi_free_dynamic(ctx);
+		io_napi_free_static(ctx);
+	}
+
+	WRITE_ONCE(ctx->napi_busy_poll_to, napi->busy_poll_to);
+	WRITE_ONCE(ctx->napi_prefer_busy_poll, !!napi->prefer_busy_poll);
+	WRITE_ONCE(ctx->napi_busy_poll_budget,
+		   napi->busy_poll_budget ?: BUSY_POLL_BUDGET);
+	WRITE_ONCE(ctx->napi_track_mode, napi->op_param);
+	WRITE_ONCE(ctx->napi_enabled, true);
+	return 0;
+}
+
 /*
  * io_napi_register() - Register napi with io-uring
  * @ctx: pointer to io-uring context structure
@@ -218,22 +364,29 @@ int io_register_napi(struct io_ring_ctx *ctx, void __user *arg)
 {
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ctx->napi_busy_poll_to,
-		.prefer_busy_poll = ctx->napi_prefer_busy_poll
+		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
+		.op_param	  = ctx->napi_track_mode,
+		.busy_poll_budget = ctx->napi_busy_poll_budget,
 	};
 	struct io_uring_napi napi;
 
 	if (copy_from_user(&napi, arg, sizeof(napi)))
 		return -EFAULT;
-	if (napi.pad[0] || napi.pad[1] || napi.pad[2] || napi.resv)
+	if (napi.pad[0] || napi.pad[1] || napi.resv)
 		return -EINVAL;
 
-	if (copy_to_user(arg, &curr, sizeof(curr)))
-		return -EFAULT;
-
-	WRITE_ONCE(ctx->napi_busy_poll_to, napi.busy_poll_to);
-	WRITE_ONCE(ctx->napi_prefer_busy_poll, !!napi.prefer_busy_poll);
-	WRITE_ONCE(ctx->napi_enabled, true);
-	return 0;
+	switch (napi.opcode) {
+	case IO_URING_NAPI_REGISTER_OP:
+		if (copy_to_user(arg, &curr, sizeof(curr)))
+			return -EFAULT;
+		return io_napi_register_napi(ctx, &napi);
+	case IO_URING_NAPI_STATIC_ADD_ID:
+		return io_napi_static_update(ctx, napi.op_param, true);
+	case IO_URING_NAPI_STATIC_DEL_ID:
+		return io_napi_static_update(ctx, napi.op_param, false);
+	default:
+		return -EINVAL;
+	}
 }
 
 /*
@@ -248,7 +401,9 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
 {
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ctx->napi_busy_poll_to,
-		.prefer_busy_poll = ctx->napi_prefer_busy_poll
+		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
+		.op_param	  = ctx->napi_track_mode,
+		.busy_poll_budget = ctx->napi_busy_poll_budget,
 	};
 
 	if (arg && copy_to_user(arg, &curr, sizeof(curr)))
@@ -256,7 +411,11 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
 
 	WRITE_ONCE(ctx->napi_busy_poll_to, 0);
 	WRITE_ONCE(ctx->napi_prefer_busy_poll, false);
+	WRITE_ONCE(ctx->napi_busy_poll_budget, BUSY_POLL_BUDGET);
+	WRITE_ONCE(ctx->napi_track_mode, IO_URING_NAPI_TRACKING_INACTIVE);
 	WRITE_ONCE(ctx->napi_enabled, false);
+	io_napi_free_dynamic(ctx);
+	io_napi_free_static(ctx);
 	return 0;
 }
 
@@ -320,7 +479,7 @@ int io_napi_sqpoll_busy_poll(struct io_ring_ctx *ctx)
 
 	if (!READ_ONCE(ctx->napi_busy_poll_to))
 		return 0;
-	if (list_empty_careful(&ctx->napi_list))
+	if (!io_napi(ctx))
 		return 0;
 
 	rcu_read_lock();
@@ -24,7 +24,9 @@ int io_napi_sqpoll_busy_poll(struct io_ring_ctx *ctx);
 
 static inline bool io_napi(struct io_ring_ctx *ctx)
 {
-	return !list_empty(&ctx->napi_list);
+	if (READ_ONCE(ctx->napi_track_mode) == IO_URING_NAPI_TRACKING_STATIC)
+		return rcu_access_pointer(ctx->napi_static) != NULL;
+	return !list_empty_careful(&ctx->napi_list);
 }
 
 static inline void io_napi_adjust_timeout(struct io_ring_ctx *ctx,
@@ -57,6 +59,9 @@ static inline void io_napi_add(struct io_kiocb *req)
 
 	if (!READ_ONCE(ctx->napi_busy_poll_to))
 		return;
+	/* statically tracked ids never need the socket looked at */
+	if (READ_ONCE(ctx->napi_track_mode) != IO_URING_NAPI_TRACKING_DYNAMIC)
+		return;
 
 	sock = sock_from_file(req->file);
 	if (sock)
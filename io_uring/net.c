@@ -1192,7 +1192,8 @@ void io_send_zc_cleanup(struct io_kiocb *req)
 }
 
 #define IO_ZC_FLAGS_COMMON (IORING_RECVSEND_POLL_FIRST | IORING_RECVSEND_FIXED_BUF)
-#define IO_ZC_FLAGS_VALID  (IO_ZC_FLAGS_COMMON | IORING_SEND_ZC_REPORT_USAGE)
+#define IO_ZC_FLAGS_VALID  (IO_ZC_FLAGS_COMMON | IORING_SEND_ZC_REPORT_USAGE | \
+			    IORING_SEND_ZC_COALESCE_NOTIF)
 
 int io_send_zc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
@@ -1228,6 +1229,8 @@ int io_send_zc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 			nd->zc_used = false;
 			nd->zc_copied = false;
 		}
+		if (zc->flags & IORING_SEND_ZC_COALESCE_NOTIF)
+			io_notif_to_data(notif)->coalesce = true;
 	}
 
 	if (zc->flags & IORING_RECVSEND_FIXED_BUF) {
@@ -11,16 +11,60 @@
 
 static const struct ubuf_info_ops io_ubuf_ops;
 
+static inline bool io_notif_zc_copied(struct io_notif_data *nd)
+{
+	return unlikely(nd->zc_report) && (nd->zc_copied || !nd->zc_used);
+}
+
+/*
+ * Pick the notification that reports for all coalescing notifications in
+ * the chain and fold their results into it. Entries after the head are
+ * linked newest first, so the first coalescing one found there belongs to
+ * the most recent request.
+ */
+static void io_notif_coalesce(struct io_notif_data *nd)
+{
+	struct io_notif_data *target = NULL, *cur;
+	bool zc_copied = false;
+	unsigned nr = 0;
+
+	for (cur = nd->next; ; cur = cur->next) {
+		if (!cur)
+			cur = nd;
+		if (cur->coalesce) {
+			if (!target)
+				target = cur;
+			else
+				cmd_to_io_kiocb(cur)->flags |= REQ_F_CQE_SKIP;
+			zc_copied |= io_notif_zc_copied(cur);
+			nr++;
+		}
+		if (cur == nd)
+			break;
+	}
+
+	if (target) {
+		struct io_kiocb *notif = cmd_to_io_kiocb(target);
+
+		notif->cqe.res |= min(nr, IORING_NOTIF_COALESCED_MASK);
+		if (zc_copied)
+			notif->cqe.res |= IORING_NOTIF_USAGE_ZC_COPIED;
+	}
+}
+
 static void io_notif_tw_complete(struct io_kiocb *notif, struct io_tw_state *ts)
 {
 	struct io_notif_data *nd = io_notif_to_data(notif);
 
+	if (nd->coalesce || nd->next)
+		io_notif_coalesce(nd);
+
 	do {
 		notif = cmd_to_io_kiocb(nd);
 
 		lockdep_assert(refcount_read(&nd->uarg.refcnt) == 0);
 
-		if (unlikely(nd->zc_report) && (nd->zc_copied || !nd->zc_used))
+		if (io_notif_zc_copied(nd))
 			notif->cqe.res |= IORING_NOTIF_USAGE_ZC_COPIED;
 
 		if (nd->account_pages && notif->ctx->user) {
@@ -85,7 +129,7 @@ static int io_link_skb(struct sk_buff *skb, struct ubuf_info *uarg)
 		return -EEXIST;
 
 	prev_nd = container_of(prev_uarg, struct io_notif_data, uarg);
-	prev_notif = cmd_to_io_kiocb(nd);
+	prev_notif = cmd_to_io_kiocb(prev_nd);
 
 	/* make sure all noifications can be finished in the same task_work */
 	if (unlikely(notif->ctx != prev_notif->ctx ||
@@ -121,6 +165,7 @@ struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx)
 
 	nd = io_notif_to_data(notif);
 	nd->zc_report = false;
+	nd->coalesce = false;
 	nd->account_pages = 0;
 	nd->next = NULL;
 	nd->head = nd;
@@ -19,6 +19,7 @@ struct io_notif_data {
 
 	unsigned		account_pages;
 	bool			zc_report;
+	bool			coalesce;
 	bool			zc_used;
 	bool			zc_copied;
 };
@@ -218,6 +218,10 @@ int io_close_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	if (close->file_slot && close->fd)
 		return -EINVAL;
 
+	/* later SQEs in this batch must not reuse a cached ref to this fd */
+	if (!close->file_slot)
+		io_submit_state_put_file(&req->ctx->submit_state);
+
 	return 0;
 }
 
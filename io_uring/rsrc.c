@@ -17,6 +17,7 @@
 #include "openclose.h"
 #include "rsrc.h"
 #include "memmap.h"
+#include "register.h"
 
 struct io_rsrc_update {
 	struct file			*file;
@@ -140,12 +141,16 @@ static void io_buffer_unmap(struct io_ring_ctx *ctx, struct io_mapped_ubuf **slo
 	unsigned int i;
 
 	if (imu != &dummy_ubuf) {
+		/* buffers may be shared with rings set up via clone */
+		if (!refcount_dec_and_test(&imu->refs))
+			goto out;
 		for (i = 0; i < imu->nr_bvecs; i++)
 			unpin_user_page(imu->bvec[i].bv_page);
 		if (imu->acct_pages)
 			io_unaccount_mem(ctx, imu->acct_pages);
 		kvfree(imu);
 	}
+out:
 	*slot = NULL;
 }
 
@@ -938,6 +943,7 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 	imu->ubuf = (unsigned long) iov->iov_base;
 	imu->ubuf_end = imu->ubuf + iov->iov_len;
 	imu->nr_bvecs = nr_pages;
+	refcount_set(&imu->refs, 1);
 	*pimu = imu;
 	ret = 0;
 
@@ -1020,6 +1026,151 @@ int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
 	return ret;
 }
 
+static void lock_two_rings(struct io_ring_ctx *ctx1, struct io_ring_ctx *ctx2)
+{
+	if (ctx1 > ctx2)
+		swap(ctx1, ctx2);
+	mutex_lock(&ctx1->uring_lock);
+	mutex_lock_nested(&ctx2->uring_lock, SINGLE_DEPTH_NESTING);
+}
+
+static int io_clone_files(struct io_ring_ctx *ctx, struct io_ring_ctx *src_ctx)
+{
+	unsigned int i, nr = src_ctx->nr_user_files;
+	int ret;
+
+	if (ctx->file_data)
+		return -EBUSY;
+	/* source table may be in the middle of being unregistered */
+	if (!nr)
+		return -ENXIO;
+	ret = io_rsrc_data_alloc(ctx, IORING_RSRC_FILE, NULL, nr,
+				 &ctx->file_data);
+	if (ret)
+		return ret;
+	if (!io_alloc_file_tables(&ctx->file_table, nr)) {
+		io_rsrc_data_free(ctx->file_data);
+		ctx->file_data = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct io_fixed_file *src_slot;
+		struct file *file;
+
+		src_slot = io_fixed_file_slot(&src_ctx->file_table, i);
+		file = io_slot_file(src_slot);
+		if (!file)
+			continue;
+		get_file(file);
+		/* copy the slot as is, it carries the cached file flags */
+		io_fixed_file_slot(&ctx->file_table, i)->file_ptr =
+							src_slot->file_ptr;
+		io_file_bitmap_set(&ctx->file_table, i);
+	}
+	ctx->nr_user_files = nr;
+	io_file_table_set_alloc_range(ctx, src_ctx->file_alloc_start,
+			src_ctx->file_alloc_end - src_ctx->file_alloc_start);
+	return 0;
+}
+
+static int io_clone_buffers(struct io_ring_ctx *ctx, struct io_ring_ctx *src_ctx,
+			    unsigned int flags)
+{
+	struct io_rsrc_data *data;
+	unsigned int i, nr;
+	int ret;
+
+	if (ctx->user_bufs)
+		return -EBUSY;
+	if (flags & IORING_REGISTER_CLONE_FILES) {
+		if (ctx->file_data)
+			return -EBUSY;
+		if (!src_ctx->file_data)
+			return -ENXIO;
+	}
+
+	/*
+	 * Pinned pages stay accounted to the ring that registered them, and
+	 * are unaccounted by whichever ring drops the last reference. Only
+	 * allow sharing between rings that charge the same user and mm.
+	 */
+	if (ctx->user != src_ctx->user || ctx->mm_account != src_ctx->mm_account)
+		return -EPERM;
+
+	nr = src_ctx->nr_user_bufs;
+	if (!nr)
+		return -ENXIO;
+	ret = io_rsrc_data_alloc(ctx, IORING_RSRC_BUFFER, NULL, nr, &data);
+	if (ret)
+		return ret;
+	ret = io_buffers_map_alloc(ctx, nr);
+	if (ret) {
+		io_rsrc_data_free(data);
+		return ret;
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct io_mapped_ubuf *imu = src_ctx->user_bufs[i];
+
+		if (imu != &dummy_ubuf)
+			refcount_inc(&imu->refs);
+		ctx->user_bufs[i] = imu;
+	}
+	ctx->nr_user_bufs = nr;
+	ctx->buf_data = data;
+
+	if (flags & IORING_REGISTER_CLONE_FILES) {
+		ret = io_clone_files(ctx, src_ctx);
+		if (ret)
+			__io_sqe_buffers_unregister(ctx);
+	}
+	return ret;
+}
+
+/*
+ * Copy the registered buffers from the source ring whose file descriptor
+ * is given in the src_fd to the current ring. This is identical to registering
+ * the buffers with ctx, except faster as mappings already exist and the
+ * pages are already pinned.
+ *
+ * Since the memory is already accounted once, don't account it again.
+ */
+int io_register_clone_buffers(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_uring_clone_buffers buf;
+	struct io_ring_ctx *src_ctx;
+	bool registered_src;
+	struct file *file;
+	int ret;
+
+	if (copy_from_user(&buf, arg, sizeof(buf)))
+		return -EFAULT;
+	if (buf.flags & ~(IORING_REGISTER_SRC_REGISTERED|IORING_REGISTER_CLONE_FILES))
+		return -EINVAL;
+	if (memchr_inv(buf.pad, 0, sizeof(buf.pad)))
+		return -EINVAL;
+
+	registered_src = (buf.flags & IORING_REGISTER_SRC_REGISTERED) != 0;
+	file = io_uring_register_get_file(buf.src_fd, registered_src);
+	if (IS_ERR(file))
+		return PTR_ERR(file);
+	src_ctx = file->private_data;
+	if (src_ctx == ctx) {
+		ret = -ELOOP;
+		goto out_put;
+	}
+
+	mutex_unlock(&ctx->uring_lock);
+	lock_two_rings(ctx, src_ctx);
+	ret = io_clone_buffers(ctx, src_ctx, buf.flags);
+	mutex_unlock(&src_ctx->uring_lock);
+out_put:
+	if (!registered_src)
+		fput(file);
+	return ret;
+}
+
 int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len)
@@ -1086,3 +1237,87 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 
 	return 0;
 }
+
+static int io_vec_fill_bvec(struct bio_vec *bvec, struct io_mapped_ubuf *imu,
+			    const struct iovec *iov)
+{
+	const struct bio_vec *src = imu->bvec;
+	size_t offset = (u64)(unsigned long)iov->iov_base - imu->ubuf;
+	size_t len = iov->iov_len;
+	unsigned int idx = 0;
+	int nr = 0;
+
+	/* same segment layout assumptions as io_import_fixed() */
+	if (offset >= src->bv_len) {
+		offset -= src->bv_len;
+		idx = 1 + (offset >> PAGE_SHIFT);
+		offset &= ~PAGE_MASK;
+	}
+
+	while (len) {
+		size_t seg_len;
+
+		if (WARN_ON_ONCE(idx >= imu->nr_bvecs))
+			return -EFAULT;
+		seg_len = min_t(size_t, len, src[idx].bv_len - offset);
+		bvec_set_page(&bvec[nr++], src[idx].bv_page, seg_len,
+			      src[idx].bv_offset + offset);
+		len -= seg_len;
+		offset = 0;
+		idx++;
+	}
+	return nr;
+}
+
+/*
+ * Vectored variant of io_import_fixed(). Every iovec in @iov must lie within
+ * the registered buffer @imu. The resulting bvec array is returned in @pbvec
+ * and must be freed by the caller once the iterator is no longer used.
+ */
+int io_import_fixed_vec(int ddir, struct iov_iter *iter,
+			struct io_mapped_ubuf *imu,
+			const struct iovec *iov, unsigned int nr_iovs,
+			struct bio_vec **pbvec)
+{
+	struct bio_vec *bvec;
+	size_t total_len = 0;
+	unsigned int i, max_segs = 0;
+	int nr_bvecs = 0;
+
+	if (WARN_ON_ONCE(!imu))
+		return -EFAULT;
+
+	for (i = 0; i < nr_iovs; i++) {
+		u64 buf_addr = (u64)(unsigned long)iov[i].iov_base;
+		size_t len = iov[i].iov_len;
+		u64 buf_end;
+
+		if (unlikely(check_add_overflow(buf_addr, (u64)len, &buf_end)))
+			return -EFAULT;
+		if (unlikely(buf_addr < imu->ubuf || buf_end > imu->ubuf_end))
+			return -EFAULT;
+		if (unlikely(len > MAX_RW_COUNT - total_len))
+			return -EINVAL;
+		total_len += len;
+		/* a range can start and end in partial segments */
+		max_segs += (len >> PAGE_SHIFT) + 2;
+	}
+
+	bvec = kvmalloc_array(max_segs, sizeof(*bvec), GFP_KERNEL);
+	if (!bvec)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_iovs; i++) {
+		int ret = io_vec_fill_bvec(&bvec[nr_bvecs], imu, &iov[i]);
+
+		if (unlikely(ret < 0)) {
+			kvfree(bvec);
+			return ret;
+		}
+		nr_bvecs += ret;
+	}
+
+	iov_iter_bvec(iter, ddir, bvec, nr_bvecs, total_len);
+	*pbvec = bvec;
+	return 0;
+}
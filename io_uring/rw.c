@@ -12,6 +12,7 @@
 #include <linux/compat.h>
 #include <linux/io_uring/cmd.h>
 #include <linux/indirect_call_wrapper.h>
+#include <linux/hrtimer.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -136,8 +137,17 @@ static inline int io_import_iovec(int rw, struct io_kiocb *req,
 	return 0;
 }
 
+static void io_rw_bvec_free(struct io_async_rw *rw)
+{
+	if (rw->bvec) {
+		kvfree(rw->bvec);
+		rw->bvec = NULL;
+	}
+}
+
 static void io_rw_iovec_free(struct io_async_rw *rw)
 {
+	io_rw_bvec_free(rw);
 	if (rw->free_iovec) {
 		kfree(rw->free_iovec);
 		rw->free_iov_nr = 0;
@@ -154,6 +164,7 @@ static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
 		io_rw_iovec_free(rw);
 		return;
 	}
+	io_rw_bvec_free(rw);
 	iov = rw->free_iovec;
 	if (io_alloc_cache_put(&req->ctx->rw_cache, rw)) {
 		if (iov)
@@ -219,6 +230,7 @@ static int io_rw_alloc_async(struct io_kiocb *req)
 		rw = req->async_data;
 		rw->free_iovec = NULL;
 		rw->free_iov_nr = 0;
+		rw->bvec = NULL;
 done:
 		rw->bytes_done = 0;
 		return 0;
@@ -269,6 +281,7 @@ static int io_prep_rw(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 		rw->kiocb.ki_ioprio = get_current_ioprio();
 	}
 	rw->kiocb.dio_complete = NULL;
+	rw->kiocb.ki_write_stream = READ_ONCE(sqe->write_stream);
 
 	rw->addr = READ_ONCE(sqe->addr);
 	rw->len = READ_ONCE(sqe->len);
@@ -350,6 +363,64 @@ int io_prep_write_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	return io_prep_rw_fixed(req, sqe, ITER_SOURCE);
 }
 
+/*
+ * Vectored fixed buffer read/write. sqe->addr points to an iovec array of
+ * sqe->len entries, each of which has to be contained in the registered
+ * buffer selected by sqe->buf_index. The ranges are resolved to the buffer's
+ * pinned pages upfront, hence no page pinning happens at issue time.
+ */
+static int io_prep_rwv_fixed(struct io_kiocb *req,
+			     const struct io_uring_sqe *sqe, int ddir)
+{
+	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_async_rw *io;
+	struct iovec *iov;
+	u16 index;
+	int ret;
+
+	ret = io_prep_rw(req, sqe, ddir, false);
+	if (unlikely(ret))
+		return ret;
+	if (unlikely(req->flags & REQ_F_BUFFER_SELECT))
+		return -EINVAL;
+	if (unlikely(!rw->len || rw->len > UIO_MAXIOV))
+		return -EINVAL;
+
+	if (unlikely(req->buf_index >= ctx->nr_user_bufs))
+		return -EFAULT;
+	index = array_index_nospec(req->buf_index, ctx->nr_user_bufs);
+	req->imu = ctx->user_bufs[index];
+	io_req_set_rsrc_node(req, ctx, 0);
+
+	io = req->async_data;
+	iov = iovec_from_user(u64_to_user_ptr(rw->addr), rw->len, 1,
+			      &io->fast_iov, ctx->compat);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	ret = io_import_fixed_vec(ddir, &io->iter, req->imu, iov, rw->len,
+				  &io->bvec);
+	if (iov != &io->fast_iov)
+		kfree(iov);
+	if (unlikely(ret))
+		return ret;
+
+	req->flags |= REQ_F_NEED_CLEANUP;
+	iov_iter_save_state(&io->iter, &io->iter_state);
+	return 0;
+}
+
+int io_prep_readv_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_DEST);
+}
+
+int io_prep_writev_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_SOURCE);
+}
+
 /*
  * Multishot read is prepared just like a normal read/write request, only
  * difference is that we set the MULTISHOT flag.
@@ -1106,12 +1177,97 @@ void io_rw_fail(struct io_kiocb *req)
 	io_req_set_res(req, res, req->cqe.flags);
 }
 
+static int io_uring_classic_poll(struct io_kiocb *req, struct io_comp_batch *iob,
+				unsigned int poll_flags)
+{
+	struct file *file = req->file;
+
+	if (req->opcode == IORING_OP_URING_CMD) {
+		struct io_uring_cmd *ioucmd;
+
+		ioucmd = io_kiocb_to_cmd(req, struct io_uring_cmd);
+		return file->f_op->uring_cmd_iopoll(ioucmd, iob, poll_flags);
+	} else {
+		struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+
+		return file->f_op->iopoll(&rw->kiocb, iob, poll_flags);
+	}
+}
+
+/*
+ * Sleep for part of the expected completion time before polling starts, so
+ * we don't burn the CPU spinning on a device that won't complete for a while.
+ * The sleep is only done once per request, and only for what is left of the
+ * sleep budget once the time since issue is taken into account.
+ */
+static void io_hybrid_iopoll_delay(struct io_ring_ctx *ctx,
+				   struct io_kiocb *req)
+{
+	struct hrtimer_sleeper timer;
+	enum hrtimer_mode mode;
+	u64 sleep_time, elapsed;
+
+	if (req->flags & REQ_F_IOPOLL_STATE)
+		return;
+	req->flags |= REQ_F_IOPOLL_STATE;
+
+	/* no completion seen yet, nothing to base the sleep time on */
+	if (ctx->hybrid_poll_time == LLONG_MAX)
+		return;
+
+	/* use half the expected completion time to sleep */
+	sleep_time = ctx->hybrid_poll_time / 2;
+	elapsed = ktime_get_ns() - req->iopoll_start;
+	if (elapsed >= sleep_time)
+		return;
+	sleep_time -= elapsed;
+
+	mode = HRTIMER_MODE_REL;
+	hrtimer_init_sleeper_on_stack(&timer, CLOCK_MONOTONIC, mode);
+	hrtimer_set_expires(&timer.timer, ns_to_ktime(sleep_time));
+	set_current_state(TASK_INTERRUPTIBLE);
+	hrtimer_sleeper_start_expires(&timer, mode);
+
+	if (timer.task)
+		io_schedule();
+
+	hrtimer_cancel(&timer.timer);
+	__set_current_state(TASK_RUNNING);
+	destroy_hrtimer_on_stack(&timer.timer);
+}
+
+static int io_uring_hybrid_poll(struct io_kiocb *req,
+				struct io_comp_batch *iob,
+				unsigned int poll_flags)
+{
+	io_hybrid_iopoll_delay(req->ctx, req);
+	return io_uring_classic_poll(req, iob, poll_flags);
+}
+
+/*
+ * Feed the observed issue to completion time into the per-ring estimate. This
+ * is a moving average weighted 7/8 towards history, so a single outlier
+ * doesn't make us oversleep, but a device getting slower or faster is tracked
+ * within a handful of completions.
+ */
+static void io_hybrid_iopoll_update(struct io_ring_ctx *ctx,
+				    struct io_kiocb *req, u64 now)
+{
+	u64 runtime = now - req->iopoll_start;
+
+	if (ctx->hybrid_poll_time == LLONG_MAX)
+		ctx->hybrid_poll_time = runtime;
+	else
+		ctx->hybrid_poll_time = (ctx->hybrid_poll_time * 7 + runtime) >> 3;
+}
+
 int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 {
 	struct io_wq_work_node *pos, *start, *prev;
 	unsigned int poll_flags = 0;
 	DEFINE_IO_COMP_BATCH(iob);
 	int nr_events = 0;
+	u64 now = 0;
 
 	/*
 	 * Only spin for completions if we don't have multiple devices hanging
@@ -1122,7 +1278,6 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 
 	wq_list_for_each(pos, start, &ctx->iopoll_list) {
 		struct io_kiocb *req = container_of(pos, struct io_kiocb, comp_list);
-		struct file *file = req->file;
 		int ret;
 
 		/*
@@ -1133,17 +1288,11 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		if (READ_ONCE(req->iopoll_completed))
 			break;
 
-		if (req->opcode == IORING_OP_URING_CMD) {
-			struct io_uring_cmd *ioucmd;
-
-			ioucmd = io_kiocb_to_cmd(req, struct io_uring_cmd);
-			ret = file->f_op->uring_cmd_iopoll(ioucmd, &iob,
-								poll_flags);
-		} else {
-			struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+		if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)
+			ret = io_uring_hybrid_poll(req, &iob, poll_flags);
+		else
+			ret = io_uring_classic_poll(req, &iob, poll_flags);
 
-			ret = file->f_op->iopoll(&rw->kiocb, &iob, poll_flags);
-		}
 		if (unlikely(ret < 0))
 			return ret;
 		else if (ret)
@@ -1160,6 +1309,9 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 	else if (!pos)
 		return 0;
 
+	if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)
+		now = ktime_get_ns();
+
 	prev = start;
 	wq_list_for_each_resume(pos, prev) {
 		struct io_kiocb *req = container_of(pos, struct io_kiocb, comp_list);
@@ -1167,6 +1319,8 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		/* order with io_complete_rw_iopoll(), e.g. ->result updates */
 		if (!smp_load_acquire(&req->iopoll_completed))
 			break;
+		if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)
+			io_hybrid_iopoll_update(ctx, req, now);
 		nr_events++;
 		req->cqe.flags = io_put_kbuf(req, 0);
 		if (req->opcode != IORING_OP_URING_CMD)
@@ -64,6 +64,52 @@ int io_statx(struct io_kiocb *req, unsigned int issue_flags)
 	return IOU_OK;
 }
 
+struct io_getdents_statx {
+	struct file			*file;
+	struct dirent_statx __user	*dirent;
+	unsigned int			count;
+	unsigned int			mask;
+	unsigned int			flags;
+};
+
+/*
+ * sqe->fd is the directory, sqe->addr and sqe->len the buffer for struct
+ * dirent_statx records, sqe->addr2 the STATX_* mask and sqe->statx_flags the
+ * AT_STATX_* flags.  Reads continue at the directory file position.
+ */
+int io_getdents_statx_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_getdents_statx *gd = io_kiocb_to_cmd(req, struct io_getdents_statx);
+
+	if (sqe->buf_index || sqe->splice_fd_in)
+		return -EINVAL;
+
+	gd->dirent = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	gd->count = READ_ONCE(sqe->len);
+	gd->mask = READ_ONCE(sqe->addr2);
+	gd->flags = READ_ONCE(sqe->statx_flags);
+
+	req->flags |= REQ_F_FORCE_ASYNC;
+	return 0;
+}
+
+int io_getdents_statx(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_getdents_statx *gd = io_kiocb_to_cmd(req, struct io_getdents_statx);
+	struct file *file = req->file;
+	int ret;
+
+	WARN_ON_ONCE(issue_flags & IO_URING_F_NONBLOCK);
+
+	mutex_lock(&file->f_pos_lock);
+	ret = vfs_getdents_statx(file, gd->dirent, gd->count, gd->mask,
+				 gd->flags);
+	mutex_unlock(&file->f_pos_lock);
+
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
+
 void io_statx_cleanup(struct io_kiocb *req)
 {
 	struct io_statx *sx = io_kiocb_to_cmd(req, struct io_statx);
@@ -249,6 +249,7 @@ extern struct mutex audit_filter_mutex;
 extern int audit_del_rule(struct audit_entry *entry);
 extern void audit_free_rule_rcu(struct rcu_head *head);
 extern struct list_head audit_filter_list[];
+extern u32 audit_exit_mask[AUDIT_BITMASK_SIZE];
 
 extern struct audit_entry *audit_dupe_rule(struct audit_krule *old);
 
@@ -49,6 +49,28 @@ struct list_head audit_filter_list[AUDIT_NR_FILTERS] = {
 #error Fix audit_filter_list initialiser
 #endif
 };
+/*
+ * Union of the syscall masks of the rules on the AUDIT_FILTER_EXIT list.
+ * Bits are only cleared by recomputing it in audit_del_rule(), so it is
+ * always a superset of what the list can match and a syscall whose bit
+ * is clear can skip the list walk.  Protected by audit_filter_mutex.
+ */
+u32 audit_exit_mask[AUDIT_BITMASK_SIZE];
+
+static void audit_exit_mask_recalc(void)
+{
+	u32 mask[AUDIT_BITMASK_SIZE] = { 0 };
+	struct audit_entry *e;
+	int i;
+
+	list_for_each_entry(e, &audit_filter_list[AUDIT_FILTER_EXIT], list)
+		for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+			mask[i] |= e->rule.mask[i];
+
+	for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+		WRITE_ONCE(audit_exit_mask[i], mask[i]);
+}
+
 static struct list_head audit_rules_list[AUDIT_NR_FILTERS] = {
 	LIST_HEAD_INIT(audit_rules_list[0]),
 	LIST_HEAD_INIT(audit_rules_list[1]),
@@ -998,6 +1020,15 @@ static inline int audit_add_rule(struct audit_entry *entry)
 			entry->rule.prio = --prio_low;
 	}
 
+	if (list == &audit_filter_list[AUDIT_FILTER_EXIT]) {
+		int i;
+
+		/* Publish the bits before the rule becomes visible. */
+		for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+			WRITE_ONCE(audit_exit_mask[i],
+				   audit_exit_mask[i] | entry->rule.mask[i]);
+	}
+
 	if (entry->rule.flags & AUDIT_FILTER_PREPEND) {
 		list_add(&entry->rule.list,
 			 &audit_rules_list[entry->rule.listnr]);
@@ -1066,6 +1097,8 @@ int audit_del_rule(struct audit_entry *entry)
 	list_del_rcu(&e->list);
 	list_del(&e->rule.list);
 	call_rcu(&e->rcu, audit_free_rule_rcu);
+	if (e->rule.listnr == AUDIT_FILTER_EXIT)
+		audit_exit_mask_recalc();
 
 out:
 	mutex_unlock(&audit_filter_mutex);
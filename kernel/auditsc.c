@@ -867,6 +867,13 @@ static void audit_filter_uring(struct task_struct *tsk,
 static void audit_filter_syscall(struct task_struct *tsk,
 				 struct audit_context *ctx)
 {
+	unsigned long major = ctx->major;
+
+	/* No rule on the exit list can match this syscall. */
+	if (major > 0xffffffff || AUDIT_WORD(major) >= AUDIT_BITMASK_SIZE ||
+	    !(READ_ONCE(audit_exit_mask[AUDIT_WORD(major)]) & AUDIT_BIT(major)))
+		return;
+
 	if (auditd_test_task(tsk))
 		return;
 
@@ -8,6 +8,7 @@
 #include "bpf_lru_list.h"
 
 #define LOCAL_FREE_TARGET		(128)
+#define LOCAL_FREE_TARGET_MAX		(1024)
 #define LOCAL_NR_SCANS			LOCAL_FREE_TARGET
 
 #define PERCPU_FREE_TARGET		(4)
@@ -324,6 +325,7 @@ static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
 					   struct bpf_lru_locallist *loc_l)
 {
 	struct bpf_lru_list *l = &lru->common_lru.lru_list;
+	unsigned int target_free = lru->common_lru.target_free;
 	struct bpf_lru_node *node, *tmp_node;
 	unsigned int nfree = 0;
 
@@ -337,12 +339,12 @@ static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
 				 list) {
 		__bpf_lru_node_move_to_free(l, node, local_free_list(loc_l),
 					    BPF_LRU_LOCAL_LIST_T_FREE);
-		if (++nfree == LOCAL_FREE_TARGET)
+		if (++nfree == target_free)
 			break;
 	}
 
-	if (nfree < LOCAL_FREE_TARGET)
-		__bpf_lru_list_shrink(lru, l, LOCAL_FREE_TARGET - nfree,
+	if (nfree < target_free)
+		__bpf_lru_list_shrink(lru, l, target_free - nfree,
 				      local_free_list(loc_l),
 				      BPF_LRU_LOCAL_LIST_T_FREE);
 
@@ -568,6 +570,15 @@ static void bpf_common_lru_populate(struct bpf_lru *lru, void *buf,
 	struct bpf_lru_list *l = &lru->common_lru.lru_list;
 	u32 i;
 
+	/* Refill the local free lists in batches that scale with the map,
+	 * so the global lock is taken less often on large maps, while a
+	 * small map doesn't end up with all its free nodes parked on the
+	 * local lists of a few CPUs.
+	 */
+	lru->common_lru.target_free =
+		clamp(nr_elems / num_possible_cpus() / 4, 1,
+		      LOCAL_FREE_TARGET_MAX);
+
 	for (i = 0; i < nr_elems; i++) {
 		struct bpf_lru_node *node;
 
@@ -680,6 +691,7 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 		}
 
 		bpf_lru_list_init(&clru->lru_list);
+		clru->target_free = LOCAL_FREE_TARGET;
 		lru->nr_scans = LOCAL_NR_SCANS;
 	}
 
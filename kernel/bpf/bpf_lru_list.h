@@ -46,6 +46,8 @@ struct bpf_lru_locallist {
 struct bpf_common_lru {
 	struct bpf_lru_list lru_list;
 	struct bpf_lru_locallist __percpu *local_list;
+	/* number of free nodes moved to a local list per refill */
+	unsigned int target_free;
 };
 
 typedef bool (*del_from_htab_func)(void *arg, struct bpf_lru_node *node);
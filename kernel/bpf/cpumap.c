@@ -34,6 +34,7 @@
 #include <linux/btf_ids.h>
 
 #include <linux/netdevice.h>   /* netif_receive_skb_list */
+#include <net/gro.h>
 #include <linux/etherdevice.h> /* eth_type_trans */
 
 /* General idea: XDP packets getting XDP redirected to another CPU,
@@ -71,6 +72,9 @@ struct bpf_cpu_map_entry {
 
 	struct completion kthread_running;
 	struct rcu_work free_work;
+
+	/* GRO state for the frames of a batch, never scheduled or polled */
+	struct napi_struct napi;
 };
 
 struct bpf_cpu_map {
@@ -340,6 +344,11 @@ static int cpu_map_kthread_run(void *data)
 		}
 
 		local_bh_disable();
+		netif_receive_skb_list(&list);
+
+		/* Frames redirected here lost the GRO pass of the original
+		 * NAPI poll, coalesce them before passing them up.
+		 */
 		for (i = 0; i < nframes; i++) {
 			struct xdp_frame *xdpf = frames[i];
 			struct sk_buff *skb = skbs[i];
@@ -351,9 +360,10 @@ static int cpu_map_kthread_run(void *data)
 				continue;
 			}
 
-			list_add_tail(&skb->list, &list);
+			napi_gro_receive(&rcpu->napi, skb);
 		}
-		netif_receive_skb_list(&list);
+		napi_gro_flush(&rcpu->napi, false);
+		gro_normal_list(&rcpu->napi);
 
 		/* Feedback loop via tracepoint */
 		trace_xdp_cpumap_kthread(rcpu->map_id, n, kmem_alloc_drops,
@@ -428,6 +438,10 @@ __cpu_map_entry_alloc(struct bpf_map *map, struct bpf_cpumap_val *value,
 	rcpu->map_id = map->id;
 	rcpu->value.qsize  = value->qsize;
 
+	for (i = 0; i < GRO_HASH_BUCKETS; i++)
+		INIT_LIST_HEAD(&rcpu->napi.gro_hash[i].list);
+	INIT_LIST_HEAD(&rcpu->napi.rx_list);
+
 	if (fd > 0 && __cpu_map_load_bpf_program(rcpu, map, fd))
 		goto free_ptr_ring;
 
@@ -159,13 +159,16 @@ static inline int extract_bit(const u8 *data, size_t index)
  * @trie:	The trie to get internal sizes from
  * @node:	The node to operate on
  * @key:	The key to compare to @node
+ * @matched:	Number of leading bits already known to match
  *
  * Determine the longest prefix of @node that matches the bits in @key.
+ * Whole 32 bit words within the first @matched bits are not compared.
  */
 static __always_inline
 size_t __longest_prefix_match(const struct lpm_trie *trie,
 			      const struct lpm_trie_node *node,
-			      const struct bpf_lpm_trie_key_u8 *key)
+			      const struct bpf_lpm_trie_key_u8 *key,
+			      u32 matched)
 {
 	u32 limit = min(node->prefixlen, key->prefixlen);
 	u32 prefixlen = 0, i = 0;
@@ -178,7 +181,7 @@ size_t __longest_prefix_match(const struct lpm_trie *trie,
 	/* data_size >= 16 has very small probability.
 	 * We do not use a loop for optimal code generation.
 	 */
-	if (trie->data_size >= 8) {
+	if (trie->data_size >= 8 && matched < 64) {
 		u64 diff = be64_to_cpu(*(__be64 *)node->data ^
 				       *(__be64 *)key->data);
 
@@ -191,6 +194,12 @@ size_t __longest_prefix_match(const struct lpm_trie *trie,
 	}
 #endif
 
+	while (trie->data_size >= i + 4 && matched >= (i + 4) * 8)
+		i += 4;
+	prefixlen = i * 8;
+	if (prefixlen >= limit)
+		return limit;
+
 	while (trie->data_size >= i + 4) {
 		u32 diff = be32_to_cpu(*(__be32 *)&node->data[i] ^
 				       *(__be32 *)&key->data[i]);
@@ -229,7 +238,7 @@ static size_t longest_prefix_match(const struct lpm_trie *trie,
 				   const struct lpm_trie_node *node,
 				   const struct bpf_lpm_trie_key_u8 *key)
 {
-	return __longest_prefix_match(trie, node, key);
+	return __longest_prefix_match(trie, node, key, 0);
 }
 
 /* Called from syscall or from eBPF program */
@@ -238,6 +247,7 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 	struct lpm_trie *trie = container_of(map, struct lpm_trie, map);
 	struct lpm_trie_node *node, *found = NULL;
 	struct bpf_lpm_trie_key_u8 *key = _key;
+	u32 matched = 0;
 
 	if (key->prefixlen > trie->max_prefixlen)
 		return NULL;
@@ -253,7 +263,7 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 		 * If it's the maximum possible prefix for this trie, we have
 		 * an exact match and can return it directly.
 		 */
-		matchlen = __longest_prefix_match(trie, node, key);
+		matchlen = __longest_prefix_match(trie, node, key, matched);
 		if (matchlen == trie->max_prefixlen) {
 			found = node;
 			break;
@@ -277,6 +287,10 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 		 * traverse down.
 		 */
 		next_bit = extract_bit(key->data, node->prefixlen);
+		/* Children share the prefix of their parent, which the key
+		 * was just found to match.
+		 */
+		matched = node->prefixlen;
 		node = rcu_dereference_check(node->child[next_bit],
 					     rcu_read_lock_bh_held());
 	}
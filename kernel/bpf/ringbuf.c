@@ -431,16 +431,24 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 	prod_pos = rb->producer_pos;
 	new_prod_pos = prod_pos + len;
 
-	while (pend_pos < prod_pos) {
-		hdr = (void *)rb->data + (pend_pos & rb->mask);
-		hdr_len = READ_ONCE(hdr->len);
-		if (hdr_len & BPF_RINGBUF_BUSY_BIT)
-			break;
-		tmp_size = hdr_len & ~BPF_RINGBUF_DISCARD_BIT;
-		tmp_size = round_up(tmp_size + BPF_RINGBUF_HDR_SZ, 8);
-		pend_pos += tmp_size;
+	/* A stale pending position only makes the check below more
+	 * conservative, so walk the headers of records committed since,
+	 * all of them likely written by other CPUs, only once the new
+	 * record would not fit otherwise. This keeps the lock hold time
+	 * short when the ring buffer has room.
+	 */
+	if (new_prod_pos - pend_pos > rb->mask) {
+		while (pend_pos < prod_pos) {
+			hdr = (void *)rb->data + (pend_pos & rb->mask);
+			hdr_len = READ_ONCE(hdr->len);
+			if (hdr_len & BPF_RINGBUF_BUSY_BIT)
+				break;
+			tmp_size = hdr_len & ~BPF_RINGBUF_DISCARD_BIT;
+			tmp_size = round_up(tmp_size + BPF_RINGBUF_HDR_SZ, 8);
+			pend_pos += tmp_size;
+		}
+		rb->pending_pos = pend_pos;
 	}
-	rb->pending_pos = pend_pos;
 
 	/* check for out of ringbuf space:
 	 * - by ensuring producer position doesn't advance more than
@@ -16561,21 +16561,21 @@ static bool check_ids(u32 old_id, u32 cur_id, struct bpf_idmap *idmap)
 	if (old_id == 0) /* cur_id == 0 as well */
 		return true;
 
-	for (i = 0; i < BPF_ID_MAP_SIZE; i++) {
-		if (!map[i].old) {
-			/* Reached an empty slot; haven't seen this id before */
-			map[i].old = old_id;
-			map[i].cur = cur_id;
-			return true;
-		}
+	for (i = 0; i < idmap->cnt; i++) {
 		if (map[i].old == old_id)
 			return map[i].cur == cur_id;
 		if (map[i].cur == cur_id)
 			return false;
 	}
 	/* We ran out of idmap slots, which should be impossible */
-	WARN_ON_ONCE(1);
-	return false;
+	if (WARN_ON_ONCE(i == BPF_ID_MAP_SIZE))
+		return false;
+
+	/* Haven't seen this id before */
+	map[i].old = old_id;
+	map[i].cur = cur_id;
+	idmap->cnt++;
+	return true;
 }
 
 /* Similar to check_ids(), but allocate a unique temporary ID
@@ -17050,7 +17050,7 @@ static bool func_states_equal(struct bpf_verifier_env *env, struct bpf_func_stat
 static void reset_idmap_scratch(struct bpf_verifier_env *env)
 {
 	env->idmap_scratch.tmp_id_gen = env->id_gen;
-	memset(&env->idmap_scratch.map, 0, sizeof(env->idmap_scratch.map));
+	env->idmap_scratch.cnt = 0;
 }
 
 static bool states_equal(struct bpf_verifier_env *env,
@@ -17063,8 +17063,6 @@ static bool states_equal(struct bpf_verifier_env *env,
 	if (old->curframe != cur->curframe)
 		return false;
 
-	reset_idmap_scratch(env);
-
 	/* Verification state from speculative execution simulation
 	 * must never prune a non-speculative execution one.
 	 */
@@ -17080,10 +17078,6 @@ static bool states_equal(struct bpf_verifier_env *env,
 	if (!!old->active_lock.id != !!cur->active_lock.id)
 		return false;
 
-	if (old->active_lock.id &&
-	    !check_ids(old->active_lock.id, cur->active_lock.id, &env->idmap_scratch))
-		return false;
-
 	if (old->active_rcu_lock != cur->active_rcu_lock)
 		return false;
 
@@ -17099,6 +17093,18 @@ static bool states_equal(struct bpf_verifier_env *env,
 	for (i = 0; i <= old->curframe; i++) {
 		if (old->frame[i]->callsite != cur->frame[i]->callsite)
 			return false;
+	}
+
+	/* Most explored states are rejected by the checks above, only
+	 * start an id mapping for the ones that get this far.
+	 */
+	reset_idmap_scratch(env);
+
+	if (old->active_lock.id &&
+	    !check_ids(old->active_lock.id, cur->active_lock.id, &env->idmap_scratch))
+		return false;
+
+	for (i = 0; i <= old->curframe; i++) {
 		if (!func_states_equal(env, old->frame[i], cur->frame[i], exact))
 			return false;
 	}
@@ -1706,7 +1706,7 @@ static void css_clear_dir(struct cgroup_subsys_state *css)
 		if (cgroup_on_dfl(cgrp)) {
 			cgroup_addrm_files(css, cgrp,
 					   cgroup_base_files, false);
-			if (cgroup_psi_enabled())
+			if (cgroup_psi_enabled() && cgroup_psi_accounted(cgrp))
 				cgroup_addrm_files(css, cgrp,
 						   cgroup_psi_files, false);
 		} else {
@@ -1741,7 +1741,7 @@ static int css_populate_dir(struct cgroup_subsys_state *css)
 			if (ret < 0)
 				return ret;
 
-			if (cgroup_psi_enabled()) {
+			if (cgroup_psi_enabled() && cgroup_psi_accounted(cgrp)) {
 				ret = cgroup_addrm_files(css, cgrp,
 							 cgroup_psi_files, true);
 				if (ret < 0)
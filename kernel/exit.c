@@ -63,6 +63,7 @@
 #include <linux/kmsan.h>
 #include <linux/random.h>
 #include <linux/rcuwait.h>
+#include <linux/rseq.h>
 #include <linux/compat.h>
 #include <linux/io_uring.h>
 #include <linux/kprobes.h>
@@ -867,6 +868,7 @@ void __noreturn do_exit(long code)
 	exit_sem(tsk);
 	exit_shm(tsk);
 	exit_files(tsk);
+	rseq_release_block_notify(tsk);
 	exit_fs(tsk);
 	if (group_dead)
 		disassociate_ctty(1);
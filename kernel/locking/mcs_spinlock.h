@@ -17,7 +17,7 @@
 
 struct mcs_spinlock {
 	struct mcs_spinlock *next;
-	int locked; /* 1 if lock acquired */
+	unsigned int locked; /* 1 if lock acquired, see qspinlock_cna.h */
 	int count;  /* nesting count, see qspinlock.c */
 };
 
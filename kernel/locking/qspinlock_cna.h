@@ -0,0 +1,281 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+
+/*
+ * Implement a NUMA-aware version of MCS (aka CNA, or compact NUMA-aware lock).
+ *
+ * In CNA, spinning threads are organized in two queues, a primary queue for
+ * threads running on the same NUMA node as the current lock holder, and a
+ * secondary queue for threads running on other nodes.  Schematically, it
+ * looks like this:
+ *
+ *    cna_node
+ *   +----------+     +--------+         +--------+
+ *   |mcs:next  | --> |mcs:next| --> ... |mcs:next| --> NULL  [Primary queue]
+ *   |mcs:locked| -.  +--------+         +--------+
+ *   +----------+  |
+ *                 `----------------------.
+ *                                        v
+ *                 +--------+         +--------+
+ *                 |mcs:next| --> ... |mcs:next|            [Secondary queue]
+ *                 +--------+         +--------+
+ *                     ^                    |
+ *                     `--------------------'
+ *
+ * N.B. locked := 1 if secondary queue is absent. Otherwise, it contains the
+ * encoded tail of the secondary queue, which is organized as a circular list.
+ *
+ * When the lock is handed over, the holder looks for the first waiter on its
+ * own node in the primary queue and moves the waiters in front of it to the
+ * tail of the secondary queue.  No waiter of the primary queue that may be
+ * its tail is ever moved, so concurrent xchg_tail() callers are not affected.
+ *
+ * The secondary queue is spliced back in front of the primary queue when no
+ * local waiter is found, when the primary queue runs empty, or after
+ * numa_spinlock_threshold consecutive handoffs within the same node, which
+ * bounds the delay of the remote waiters.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u16			intra_count;
+	u32			encoded_tail;	/* self */
+};
+
+static unsigned int numa_spinlock_threshold __ro_after_init = 256;
+
+enum {
+	NUMA_SPINLOCK_AUTO,
+	NUMA_SPINLOCK_ON,
+	NUMA_SPINLOCK_OFF,
+};
+
+static int numa_spinlock_flag __initdata = NUMA_SPINLOCK_AUTO;
+
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!str)
+		return -EINVAL;
+
+	if (!strcmp(str, "auto"))
+		numa_spinlock_flag = NUMA_SPINLOCK_AUTO;
+	else if (!strcmp(str, "on"))
+		numa_spinlock_flag = NUMA_SPINLOCK_ON;
+	else if (!strcmp(str, "off"))
+		numa_spinlock_flag = NUMA_SPINLOCK_OFF;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+early_param("numa_spinlock", numa_spinlock_setup);
+
+static int __init numa_spinlock_threshold_setup(char *str)
+{
+	unsigned int val;
+
+	if (kstrtouint(str, 0, &val))
+		return -EINVAL;
+
+	numa_spinlock_threshold = clamp(val, 1U, (unsigned int)U16_MAX);
+	return 0;
+}
+early_param("numa_spinlock_threshold", numa_spinlock_threshold_setup);
+
+static __always_inline struct cna_node *to_cna_node(struct mcs_spinlock *node)
+{
+	return (struct cna_node *)node;
+}
+
+static void __init cna_init_nodes_per_cpu(unsigned int cpu)
+{
+	struct mcs_spinlock *base = per_cpu_ptr(&qnodes[0].mcs, cpu);
+	int numa_node = cpu_to_node(cpu);
+	int i;
+
+	for (i = 0; i < MAX_NODES; i++) {
+		struct cna_node *cn = to_cna_node(grab_mcs_node(base, i));
+
+		cn->numa_node = numa_node;
+		cn->encoded_tail = encode_tail(cpu, i);
+		/*
+		 * make sure @encoded_tail is not confused with other valid
+		 * values for @locked (0 or 1)
+		 */
+		WARN_ON(cn->encoded_tail <= 1);
+	}
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node)
+{
+	to_cna_node(node)->intra_count = 0;
+}
+
+/*
+ * cna_splice_head -- splice the secondary queue in front of @next, and
+ * return the new head of the primary queue.
+ */
+static __always_inline struct mcs_spinlock *
+cna_splice_head(struct mcs_spinlock *node, struct mcs_spinlock *next)
+{
+	struct mcs_spinlock *tail_2nd = decode_tail(node->locked);
+	struct mcs_spinlock *head_2nd = tail_2nd->next;
+
+	tail_2nd->next = next;
+	node->locked = 1;
+	lockevent_inc(cna_splice);
+
+	return head_2nd;
+}
+
+/*
+ * cna_splice_tail -- move the waiters from @first to @last of the primary
+ * queue to the tail of the secondary queue.
+ */
+static __always_inline void cna_splice_tail(struct mcs_spinlock *node,
+					    struct mcs_spinlock *first,
+					    struct mcs_spinlock *last)
+{
+	if (node->locked <= 1) {
+		/* create the secondary queue */
+		last->next = first;
+	} else {
+		/* add to the tail of the secondary queue */
+		struct mcs_spinlock *tail_2nd = decode_tail(node->locked);
+		struct mcs_spinlock *head_2nd = tail_2nd->next;
+
+		tail_2nd->next = first;
+		last->next = head_2nd;
+	}
+
+	node->locked = to_cna_node(last)->encoded_tail;
+	lockevent_inc(cna_reorder);
+}
+
+/*
+ * cna_order_queue -- find the first waiter on the node of the lock holder,
+ * moving the waiters in front of it to the secondary queue.
+ *
+ * Return: the waiter found, or NULL if there is none that can be reached
+ * without passing the (possibly moving) tail of the primary queue.
+ */
+static __always_inline struct mcs_spinlock *
+cna_order_queue(struct mcs_spinlock *node, struct mcs_spinlock *next)
+{
+	int numa_node = to_cna_node(node)->numa_node;
+	struct mcs_spinlock *last = NULL, *cur = next;
+
+	while (to_cna_node(cur)->numa_node != numa_node) {
+		struct mcs_spinlock *nnext = READ_ONCE(cur->next);
+
+		if (!nnext)
+			return NULL;
+
+		last = cur;
+		cur = nnext;
+	}
+
+	if (last)
+		cna_splice_tail(node, next, last);
+
+	return cur;
+}
+
+/*
+ * The queue head found the lock word pointing to itself; if there are waiters
+ * in the secondary queue, make them the primary queue and wake up their head.
+ */
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock, u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct mcs_spinlock *tail_2nd, *head_2nd;
+	u32 new;
+
+	if (node->locked <= 1)
+		return __try_clear_tail(lock, val, node);
+
+	tail_2nd = decode_tail(node->locked);
+	head_2nd = tail_2nd->next;
+	new = to_cna_node(tail_2nd)->encoded_tail + _Q_LOCKED_VAL;
+
+	/*
+	 * Terminate the secondary queue before it is exposed as the primary
+	 * one, as the next xchg_tail() caller links itself to @tail_2nd.
+	 */
+	tail_2nd->next = NULL;
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val, new)) {
+		tail_2nd->next = head_2nd;
+		return false;
+	}
+
+	lockevent_inc(cna_splice);
+	lockevent_inc(cna_inter_node);
+	to_cna_node(head_2nd)->intra_count = 0;
+	arch_mcs_spin_unlock_contended(&head_2nd->locked);
+
+	return true;
+}
+
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next)
+{
+	struct cna_node *cn = to_cna_node(node);
+	struct mcs_spinlock *local = NULL;
+	u32 val = 1;
+
+	if (cn->intra_count < numa_spinlock_threshold)
+		local = cna_order_queue(node, next);
+
+	if (local) {
+		next = local;
+		if (node->locked > 1)
+			val = node->locked;
+		to_cna_node(next)->intra_count = cn->intra_count + 1;
+	} else {
+		if (node->locked > 1)
+			next = cna_splice_head(node, next);
+		to_cna_node(next)->intra_count = 0;
+	}
+
+	if (to_cna_node(next)->numa_node == cn->numa_node)
+		lockevent_inc(cna_intra_node);
+	else
+		lockevent_inc(cna_inter_node);
+
+	/* pass the secondary queue along with the lock */
+	smp_store_release(&next->locked, val);
+}
+
+/*
+ * Switch to the NUMA-aware slow path, unless running under a hypervisor that
+ * installed its own, or on a single node machine.  Must be called before the
+ * paravirt call sites are patched.
+ */
+void __init cna_configure_spin_lock_slowpath(void)
+{
+	unsigned int cpu;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (numa_spinlock_flag == NUMA_SPINLOCK_OFF)
+		return;
+
+	if (numa_spinlock_flag == NUMA_SPINLOCK_AUTO &&
+	    (nr_node_ids == 1 ||
+	     pv_ops.lock.queued_spin_lock_slowpath !=
+	     native_queued_spin_lock_slowpath))
+		return;
+
+	for_each_possible_cpu(cpu)
+		cna_init_nodes_per_cpu(cpu);
+
+	pv_ops.lock.queued_spin_lock_slowpath = __cna_queued_spin_lock_slowpath;
+
+	pr_info("Enabling CNA spinlock, threshold %u\n",
+		numa_spinlock_threshold);
+}
@@ -31,6 +31,7 @@
 
 #ifndef CONFIG_PREEMPT_RT
 #include "lock_events.h"
+#include "rwsem_hist.h"
 
 /*
  * The least significant 2 bits of the owner value has the following
@@ -326,6 +327,10 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	atomic_long_set(&sem->owner, 0L);
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
+	sem->spin_avg = 0;
+#endif
+#ifdef CONFIG_RWSEM_CONTENTION_HIST
+	sem->hist_name = name;
 #endif
 }
 EXPORT_SYMBOL(__init_rwsem);
@@ -702,6 +707,44 @@ static inline bool rwsem_try_write_lock_unqueued(struct rw_semaphore *sem)
 	return false;
 }
 
+/*
+ * Adaptive optimistic spinning
+ *
+ * sem->spin_avg is a moving average, with a weight of 1/8, of the time the
+ * recent optimistic spinners took to get the lock; a spin that failed counts
+ * as RWSEM_SPIN_FAIL_NS.  When the average exceeds RWSEM_SPIN_MAX_NS the lock
+ * is held for too long to be worth spinning on, and acquirers go to sleep
+ * right away.  Each skipped spin decays the average, so that a spin is tried
+ * again after a while in case the lock hold times got shorter.
+ */
+#define RWSEM_SPIN_MAX_NS	(25 * NSEC_PER_USEC)
+#define RWSEM_SPIN_FAIL_NS	(4 * RWSEM_SPIN_MAX_NS)
+
+static inline bool rwsem_spin_worthwhile(struct rw_semaphore *sem)
+{
+	unsigned int avg = READ_ONCE(sem->spin_avg);
+
+	if (likely(avg <= RWSEM_SPIN_MAX_NS))
+		return true;
+
+	WRITE_ONCE(sem->spin_avg, avg - (avg >> 3));
+	lockevent_inc(rwsem_opt_skip);
+	return false;
+}
+
+static inline void rwsem_spin_update(struct rw_semaphore *sem, u64 start,
+				     bool taken)
+{
+	unsigned int avg = READ_ONCE(sem->spin_avg);
+	u64 delta = RWSEM_SPIN_FAIL_NS;
+
+	if (taken)
+		delta = min_t(u64, sched_clock() - start, RWSEM_SPIN_FAIL_NS);
+
+	/* Racy updates are fine, this is only a hint */
+	WRITE_ONCE(sem->spin_avg, avg - (avg >> 3) + (delta >> 3));
+}
+
 static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 {
 	struct task_struct *owner;
@@ -713,6 +756,9 @@ static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 		return false;
 	}
 
+	if (!rwsem_spin_worthwhile(sem))
+		return false;
+
 	/*
 	 * Disable preemption is equal to the RCU read-side crital section,
 	 * thus the task_strcut structure won't go away.
@@ -822,6 +868,7 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	int prev_owner_state = OWNER_NULL;
 	int loop = 0;
 	u64 rspin_threshold = 0;
+	u64 start = sched_clock();
 
 	/* sem->wait_lock should not be held when doing optimistic spinning */
 	if (!osq_lock(&sem->osq))
@@ -930,10 +977,63 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	}
 	osq_unlock(&sem->osq);
 done:
+	rwsem_spin_update(sem, start, taken);
 	lockevent_cond_inc(rwsem_opt_fail, !taken);
 	return taken;
 }
 
+/*
+ * Reader optimistic spinning on a running writer
+ *
+ * The reader has already added its RWSEM_READER_BIAS, so it owns the lock as
+ * soon as the writer lets go, as long as no waiter set the handoff bit. There
+ * is no need for the osq, spinning readers don't compete with each other.
+ *
+ * Return: true if the read lock was taken, with *@cntp updated.
+ */
+static bool rwsem_reader_spin(struct rw_semaphore *sem, long *cntp)
+{
+	u64 start, deadline;
+	bool taken = false;
+	int loop = 0;
+
+	if (!rwsem_can_spin_on_owner(sem))
+		return false;
+
+	start = sched_clock();
+	deadline = start + RWSEM_SPIN_FAIL_NS;
+	for (;;) {
+		enum owner_state owner_state = rwsem_spin_on_owner(sem);
+		long count = atomic_long_read(&sem->count);
+
+		if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF))) {
+			/* Provide lock ACQUIRE */
+			smp_acquire__after_ctrl_dep();
+			*cntp = count;
+			taken = true;
+			break;
+		}
+
+		if (!(owner_state & OWNER_SPINNABLE) ||
+		    (count & RWSEM_FLAG_HANDOFF))
+			break;
+
+		/* See rwsem_optimistic_spin() on RT tasks */
+		if (owner_state != OWNER_WRITER &&
+		    (need_resched() || rt_task(current)))
+			break;
+
+		if (!(++loop & 0xf) && sched_clock() > deadline)
+			break;
+
+		cpu_relax();
+	}
+
+	rwsem_spin_update(sem, start, taken);
+	lockevent_cond_inc(rwsem_opt_rlock, taken);
+	return taken;
+}
+
 /*
  * Clear the owner's RWSEM_NONSPINNABLE bit if it is set. This should
  * only be called when the reader count reaches 0.
@@ -955,6 +1055,11 @@ static inline bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return false;
 }
 
+static inline bool rwsem_reader_spin(struct rw_semaphore *sem, long *cntp)
+{
+	return false;
+}
+
 static inline void clear_nonspinnable(struct rw_semaphore *sem) { }
 
 static inline enum owner_state
@@ -997,6 +1102,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 {
 	long adjustment = -RWSEM_READER_BIAS;
 	long rcnt = (count >> RWSEM_READER_SHIFT);
+	u64 wait_start = rwsem_hist_start();
 	struct rwsem_waiter waiter;
 	DEFINE_WAKE_Q(wake_q);
 
@@ -1010,9 +1116,12 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 		goto queue;
 
 	/*
-	 * Reader optimistic lock stealing.
+	 * Reader optimistic lock stealing, possibly after spinning on a
+	 * writer that is likely to release the lock soon.
 	 */
-	if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF))) {
+	if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF)) ||
+	    (!(count & RWSEM_FLAG_HANDOFF) && rwsem_reader_spin(sem, &count))) {
+		rcnt = count >> RWSEM_READER_SHIFT;
 		rwsem_set_reader_owned(sem);
 		lockevent_inc(rwsem_rlock_steal);
 
@@ -1028,6 +1137,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 			raw_spin_unlock_irq(&sem->wait_lock);
 			wake_up_q(&wake_q);
 		}
+		rwsem_hist_record(sem, false, wait_start);
 		return sem;
 	}
 
@@ -1051,6 +1161,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 			raw_spin_unlock_irq(&sem->wait_lock);
 			rwsem_set_reader_owned(sem);
 			lockevent_inc(rwsem_rlock_fast);
+			rwsem_hist_record(sem, false, wait_start);
 			return sem;
 		}
 		adjustment += RWSEM_FLAG_WAITERS;
@@ -1090,6 +1201,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	__set_current_state(TASK_RUNNING);
 	lockevent_inc(rwsem_rlock);
 	trace_contention_end(sem, 0);
+	rwsem_hist_record(sem, false, wait_start);
 	return sem;
 
 out_nolock:
@@ -1106,12 +1218,14 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 static struct rw_semaphore __sched *
 rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 {
+	u64 wait_start = rwsem_hist_start();
 	struct rwsem_waiter waiter;
 	DEFINE_WAKE_Q(wake_q);
 
 	/* do optimistic spinning and steal lock if possible */
 	if (rwsem_can_spin_on_owner(sem) && rwsem_optimistic_spin(sem)) {
 		/* rwsem_optimistic_spin() implies ACQUIRE on success */
+		rwsem_hist_record(sem, true, wait_start);
 		return sem;
 	}
 
@@ -1185,6 +1299,7 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	raw_spin_unlock_irq(&sem->wait_lock);
 	lockevent_inc(rwsem_wlock);
 	trace_contention_end(sem, 0);
+	rwsem_hist_record(sem, true, wait_start);
 	return sem;
 
 out_nolock:
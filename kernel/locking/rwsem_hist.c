@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Contention latency histograms for rwsems
+ *
+ * Each contended rwsem acquisition accounts the time spent in the slow path,
+ * spinning or sleeping, into a log2 histogram of the class of the rwsem, where
+ * the class is the name the rwsem was initialized with.  The counts are
+ * per-cpu and summed when <debugfs>/rwsem_contention is read, which keeps the
+ * overhead low enough for production use.  Writing to the file resets them.
+ */
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+#include "rwsem_hist.h"
+
+#define RWSEM_HIST_CLASS_BITS	6
+#define RWSEM_HIST_CLASSES	(1 << RWSEM_HIST_CLASS_BITS)
+/* Classes that don't fit, or rwsems without a name */
+#define RWSEM_HIST_OTHER	RWSEM_HIST_CLASSES
+
+/*
+ * Bucket 0 counts waits below 1us, bucket n waits of [2^(n-1), 2^n) us, and
+ * the last bucket everything longer.
+ */
+#define RWSEM_HIST_BUCKETS	20
+
+struct rwsem_hist {
+	u32 counts[RWSEM_HIST_CLASSES + 1][2][RWSEM_HIST_BUCKETS];
+};
+
+static const char *rwsem_hist_names[RWSEM_HIST_CLASSES];
+static struct rwsem_hist __percpu *rwsem_hists;
+
+/*
+ * Find or claim the slot of @name; classes are never released, the names
+ * are string literals of the init sites.
+ */
+static unsigned int rwsem_hist_slot(const char *name)
+{
+	unsigned int i, slot;
+
+	if (!name)
+		return RWSEM_HIST_OTHER;
+
+	slot = hash_ptr(name, RWSEM_HIST_CLASS_BITS);
+	for (i = 0; i < RWSEM_HIST_CLASSES; i++) {
+		const char *cur = READ_ONCE(rwsem_hist_names[slot]);
+
+		if (!cur)
+			cur = cmpxchg(&rwsem_hist_names[slot], NULL, name);
+		if (!cur || cur == name)
+			return slot;
+
+		slot = (slot + 1) & (RWSEM_HIST_CLASSES - 1);
+	}
+
+	return RWSEM_HIST_OTHER;
+}
+
+static unsigned int rwsem_hist_bucket(u64 delta)
+{
+	u64 us = delta >> 10;	/* close enough to a microsecond */
+
+	if (!us)
+		return 0;
+
+	return min_t(unsigned int, ilog2(us) + 1, RWSEM_HIST_BUCKETS - 1);
+}
+
+void __rwsem_hist_record(struct rw_semaphore *sem, bool write, u64 start)
+{
+	struct rwsem_hist __percpu *hists = READ_ONCE(rwsem_hists);
+	unsigned int slot, bucket;
+
+	if (!hists)
+		return;
+
+	slot = rwsem_hist_slot(sem->hist_name);
+	bucket = rwsem_hist_bucket(sched_clock() - start);
+	this_cpu_inc(hists->counts[slot][write][bucket]);
+}
+
+static void rwsem_hist_show_row(struct seq_file *m, unsigned int slot,
+				bool write)
+{
+	u64 sum[RWSEM_HIST_BUCKETS] = { };
+	u64 total = 0;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct rwsem_hist *h = per_cpu_ptr(rwsem_hists, cpu);
+
+		for (i = 0; i < RWSEM_HIST_BUCKETS; i++)
+			sum[i] += h->counts[slot][write][i];
+	}
+	for (i = 0; i < RWSEM_HIST_BUCKETS; i++)
+		total += sum[i];
+	if (!total)
+		return;
+
+	seq_printf(m, "%-32s %-5s %llu",
+		   slot == RWSEM_HIST_OTHER ? "(other)" : rwsem_hist_names[slot],
+		   write ? "write" : "read", total);
+	for (i = 0; i < RWSEM_HIST_BUCKETS; i++)
+		seq_printf(m, " %llu", sum[i]);
+	seq_putc(m, '\n');
+}
+
+static int rwsem_hist_show(struct seq_file *m, void *v)
+{
+	unsigned int slot;
+	int i;
+
+	seq_printf(m, "%-32s %-5s %s", "class", "type", "total");
+	for (i = 0; i < RWSEM_HIST_BUCKETS - 1; i++)
+		seq_printf(m, " <%luus", 1UL << i);
+	seq_puts(m, " more\n");
+
+	for (slot = 0; slot <= RWSEM_HIST_OTHER; slot++) {
+		if (slot != RWSEM_HIST_OTHER && !READ_ONCE(rwsem_hist_names[slot]))
+			continue;
+		rwsem_hist_show_row(m, slot, false);
+		rwsem_hist_show_row(m, slot, true);
+	}
+
+	return 0;
+}
+
+static int rwsem_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rwsem_hist_show, NULL);
+}
+
+static ssize_t rwsem_hist_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(rwsem_hists, cpu), 0,
+		       sizeof(struct rwsem_hist));
+
+	return count;
+}
+
+static const struct file_operations rwsem_hist_fops = {
+	.open		= rwsem_hist_open,
+	.read		= seq_read,
+	.write		= rwsem_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init rwsem_hist_init(void)
+{
+	struct rwsem_hist __percpu *hists = alloc_percpu(struct rwsem_hist);
+
+	if (!hists)
+		return -ENOMEM;
+
+	WRITE_ONCE(rwsem_hists, hists);
+	debugfs_create_file("rwsem_contention", 0600, NULL, NULL,
+			    &rwsem_hist_fops);
+	return 0;
+}
+fs_initcall(rwsem_hist_init);
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __LOCKING_RWSEM_HIST_H
+#define __LOCKING_RWSEM_HIST_H
+
+#include <linux/rwsem.h>
+#include <linux/sched/clock.h>
+
+#ifdef CONFIG_RWSEM_CONTENTION_HIST
+
+extern void __rwsem_hist_record(struct rw_semaphore *sem, bool write,
+				u64 start);
+
+static inline u64 rwsem_hist_start(void)
+{
+	return sched_clock();
+}
+
+/*
+ * Account the time since @start, as returned by rwsem_hist_start(), to the
+ * histogram of the class of @sem.
+ */
+static inline void rwsem_hist_record(struct rw_semaphore *sem, bool write,
+				     u64 start)
+{
+	__rwsem_hist_record(sem, write, start);
+}
+
+#else /* CONFIG_RWSEM_CONTENTION_HIST */
+
+static inline u64 rwsem_hist_start(void)
+{
+	return 0;
+}
+
+static inline void rwsem_hist_record(struct rw_semaphore *sem, bool write,
+				     u64 start) { }
+
+#endif /* CONFIG_RWSEM_CONTENTION_HIST */
+
+#endif /* __LOCKING_RWSEM_HIST_H */
@@ -94,6 +94,8 @@ struct find_symbol_arg {
 	const char *name;
 	bool gplok;
 	bool warn;
+	/* (optional) module to search before walking the module list */
+	struct module *hint;
 
 	/* Output */
 	struct module *owner;
@@ -297,9 +297,34 @@ static bool find_exported_symbol_in_section(const struct symsearch *syms,
 	return true;
 }
 
+static bool find_exported_symbol_in_module(struct module *mod,
+					   struct find_symbol_arg *fsa)
+{
+	struct symsearch arr[] = {
+		{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
+		  NOT_GPL_ONLY },
+		{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
+		  mod->gpl_crcs,
+		  GPL_ONLY },
+	};
+	unsigned int i;
+
+	if (mod->state == MODULE_STATE_UNFORMED)
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(arr); i++)
+		if (find_exported_symbol_in_section(&arr[i], mod, fsa))
+			return true;
+	return false;
+}
+
 /*
  * Find an exported symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex.
+ *
+ * Exported symbol names are unique, so searching fsa->hint first does not
+ * change the result; it only saves walking the module list when a module
+ * imports many symbols from the same provider.
  */
 bool find_symbol(struct find_symbol_arg *fsa)
 {
@@ -319,22 +344,13 @@ bool find_symbol(struct find_symbol_arg *fsa)
 		if (find_exported_symbol_in_section(&arr[i], NULL, fsa))
 			return true;
 
+	if (fsa->hint && find_exported_symbol_in_module(fsa->hint, fsa))
+		return true;
+
 	list_for_each_entry_rcu(mod, &modules, list,
 				lockdep_is_held(&module_mutex)) {
-		struct symsearch arr[] = {
-			{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
-			  NOT_GPL_ONLY },
-			{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
-			  mod->gpl_crcs,
-			  GPL_ONLY },
-		};
-
-		if (mod->state == MODULE_STATE_UNFORMED)
-			continue;
-
-		for (i = 0; i < ARRAY_SIZE(arr); i++)
-			if (find_exported_symbol_in_section(&arr[i], mod, fsa))
-				return true;
+		if (mod != fsa->hint && find_exported_symbol_in_module(mod, fsa))
+			return true;
 	}
 
 	pr_debug("Failed to find symbol %s\n", fsa->name);
@@ -1107,16 +1123,22 @@ static bool inherit_taint(struct module *mod, struct module *owner, const char *
 	return true;
 }
 
-/* Resolve a symbol for this module.  I.e. if we find one, record usage. */
+/*
+ * Resolve a symbol for this module.  I.e. if we find one, record usage.
+ * @hint is the module that provided the previous symbol; it holds a
+ * reference from us, so it stays valid for the rest of the load.
+ */
 static const struct kernel_symbol *resolve_symbol(struct module *mod,
 						  const struct load_info *info,
 						  const char *name,
-						  char ownername[])
+						  char ownername[],
+						  struct module **hint)
 {
 	struct find_symbol_arg fsa = {
 		.name	= name,
 		.gplok	= !(mod->taints & (1 << TAINT_PROPRIETARY_MODULE)),
 		.warn	= true,
+		.hint	= *hint,
 	};
 	int err;
 
@@ -1155,6 +1177,9 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 		goto getname;
 	}
 
+	if (fsa.owner)
+		*hint = fsa.owner;
+
 getname:
 	/* We must make copy under the lock if we failed to get ref. */
 	strncpy(ownername, module_name(fsa.owner), MODULE_NAME_LEN);
@@ -1166,13 +1191,15 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 static const struct kernel_symbol *
 resolve_symbol_wait(struct module *mod,
 		    const struct load_info *info,
-		    const char *name)
+		    const char *name,
+		    struct module **hint)
 {
 	const struct kernel_symbol *ksym;
 	char owner[MODULE_NAME_LEN];
 
 	if (wait_event_interruptible_timeout(module_wq,
-			!IS_ERR(ksym = resolve_symbol(mod, info, name, owner))
+			!IS_ERR(ksym = resolve_symbol(mod, info, name, owner,
+						      hint))
 			|| PTR_ERR(ksym) != -EBUSY,
 					     30 * HZ) <= 0) {
 		pr_warn("%s: gave up waiting for init of module %s.\n",
@@ -1393,6 +1420,7 @@ static int simplify_symbols(struct module *mod, const struct load_info *info)
 {
 	Elf_Shdr *symsec = &info->sechdrs[info->index.sym];
 	Elf_Sym *sym = (void *)symsec->sh_addr;
+	struct module *hint = NULL;
 	unsigned long secbase;
 	unsigned int i;
 	int ret = 0;
@@ -1428,7 +1456,7 @@ static int simplify_symbols(struct module *mod, const struct load_info *info)
 			break;
 
 		case SHN_UNDEF:
-			ksym = resolve_symbol_wait(mod, info, name);
+			ksym = resolve_symbol_wait(mod, info, name, &hint);
 			/* Ok if resolved.  */
 			if (ksym && !IS_ERR(ksym)) {
 				sym[i].st_value = kernel_symbol_value(ksym);
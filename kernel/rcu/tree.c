@@ -150,6 +150,7 @@ static void rcu_report_qs_rnp(unsigned long mask, struct rcu_node *rnp,
 			      unsigned long gps, unsigned long flags);
 static struct task_struct *rcu_boost_task(struct rcu_node *rnp);
 static void invoke_rcu_core(void);
+static void invoke_rcu_core_kthread(void);
 static void rcu_report_exp_rdp(struct rcu_data *rdp);
 static void sync_sched_exp_online_cleanup(int cpu);
 static void check_cb_ovld_locked(struct rcu_data *rdp, struct rcu_node *rnp);
@@ -433,6 +434,23 @@ module_param(rcu_divisor, int, 0644);
 static long rcu_resched_ns = 3 * NSEC_PER_MSEC;
 module_param(rcu_resched_ns, long, 0644);
 
+/*
+ * If non-zero, RCU_SOFTIRQ invokes callbacks for at most this many
+ * nanoseconds, then leaves the rest of the ready callbacks to this CPU's
+ * rcuc kthread instead of raising the softirq again.  The rcuc kthreads
+ * are only spawned alongside of use_softirq if this is set at boot.
+ */
+static long rcu_softirq_cb_ns;
+module_param(rcu_softirq_cb_ns, long, 0444);
+
+/*
+ * If non-zero, expedited grace periods do not IPI nohz_full CPUs right away,
+ * but first give them up to this many jiffies to pass through an extended
+ * quiescent state on their own, for example by returning to user mode.
+ */
+static int rcu_exp_nohz_full_delay;
+module_param(rcu_exp_nohz_full_delay, int, 0644);
+
 /*
  * How long the grace period must be before we start recruiting
  * quiescent-state help from rcu_note_context_switch().
@@ -2451,6 +2469,16 @@ static bool rcu_do_batch_check_time(long count, long tlimit,
 	       local_clock() >= tlimit;
 }
 
+/*
+ * Callbacks that ran RCU_SOFTIRQ out of its rcu_softirq_cb_ns budget are left
+ * to the rcuc kthread, unless it has not got to them within a second.
+ */
+static bool rcu_cbs_deferred(struct rcu_data *rdp)
+{
+	return rdp->cb_deferred && in_serving_softirq() &&
+	       time_before(jiffies, rdp->cb_deferred_at + HZ);
+}
+
 /*
  * Invoke any RCU callbacks that have made it to the end of their grace
  * period.  Throttle as specified by rdp->blimit.
@@ -2507,6 +2535,11 @@ static void rcu_do_batch(struct rcu_data *rdp)
 		jlimit = jiffies + (rrn + npj + 1) / npj;
 		jlimit_check = true;
 	}
+	if (in_serving_softirq() && READ_ONCE(rcu_softirq_cb_ns) > 0) {
+		long scn = local_clock() + READ_ONCE(rcu_softirq_cb_ns);
+
+		tlimit = tlimit ? min(tlimit, scn) : scn;
+	}
 	trace_rcu_batch_start(rcu_state.name,
 			      rcu_segcblist_n_cbs(&rdp->cblist), bl);
 	rcu_segcblist_extract_done_cbs(&rdp->cblist, &rcl);
@@ -2546,8 +2579,13 @@ static void rcu_do_batch(struct rcu_data *rdp)
 			 * Make sure we don't spend too much time here and deprive other
 			 * softirq vectors of CPU cycles.
 			 */
-			if (rcu_do_batch_check_time(count, tlimit, jlimit_check, jlimit))
+			if (rcu_do_batch_check_time(count, tlimit, jlimit_check, jlimit)) {
+				if (READ_ONCE(rcu_softirq_cb_ns) > 0 && !rdp->cb_deferred) {
+					rdp->cb_deferred = true;
+					rdp->cb_deferred_at = jiffies;
+				}
 				break;
+			}
 		} else {
 			// In rcuc/rcuoc context, so no worries about
 			// depriving other softirq vectors of CPU cycles.
@@ -2806,9 +2844,14 @@ static __latent_entropy void rcu_core(void)
 	/* If there are callbacks ready, invoke them. */
 	if (do_batch && rcu_segcblist_ready_cbs(&rdp->cblist) &&
 	    likely(READ_ONCE(rcu_scheduler_fully_active))) {
-		rcu_do_batch(rdp);
+		if (!rcu_cbs_deferred(rdp))
+			rcu_do_batch(rdp);
 		/* Re-invoke RCU core processing if there are callbacks remaining. */
-		if (rcu_segcblist_ready_cbs(&rdp->cblist))
+		if (!rcu_segcblist_ready_cbs(&rdp->cblist))
+			rdp->cb_deferred = false;
+		else if (rdp->cb_deferred)
+			invoke_rcu_core_kthread();
+		else
 			invoke_rcu_core();
 	}
 
@@ -2928,7 +2971,7 @@ static int __init rcu_spawn_core_kthreads(void)
 
 	for_each_possible_cpu(cpu)
 		per_cpu(rcu_data.rcu_cpu_has_work, cpu) = 0;
-	if (use_softirq)
+	if (use_softirq && rcu_softirq_cb_ns <= 0)
 		return 0;
 	WARN_ONCE(smpboot_register_percpu_thread(&rcu_cpu_thread_spec),
 		  "%s: Could not start rcuc kthread, OOM is now expected behavior\n", __func__);
@@ -3043,6 +3086,152 @@ static void check_cb_ovld(struct rcu_data *rdp)
 	raw_spin_unlock_rcu_node(rnp);
 }
 
+#ifdef CONFIG_RCU_LAZY
+static bool enable_rcu_lazy __read_mostly = !IS_ENABLED(CONFIG_RCU_LAZY_DEFAULT_OFF);
+module_param(enable_rcu_lazy, bool, 0444);
+
+/*
+ * CPUs that are not offloaded keep their lazy callbacks on ->lazy_cblist
+ * until either ->lazy_timer fires, qhimark of them have piled up, a non-lazy
+ * callback or rcu_barrier() comes along, or the shrinker asks for memory.
+ * They are then all moved to ->cblist at once, so that a whole batch of them
+ * waits for the same grace period.
+ */
+
+static long rcu_lazy_n_cbs(struct rcu_data *rdp)
+{
+	return data_race(rdp->lazy_cblist.len);
+}
+
+/*
+ * Move the lazy callbacks of @rdp to its ->cblist.  Called with irqs disabled,
+ * either on @rdp's CPU or once that CPU is offline.
+ */
+static void rcu_lazy_flush(struct rcu_data *rdp)
+{
+	if (!rdp->lazy_cblist.len)
+		return;
+	rcu_segcblist_insert_pend_cbs(&rdp->cblist, &rdp->lazy_cblist);
+	rcu_cblist_init(&rdp->lazy_cblist);
+	timer_delete(&rdp->lazy_timer);
+}
+
+static void rcu_lazy_timer_fn(struct timer_list *t)
+{
+	struct rcu_data *rdp = from_timer(rdp, t, lazy_timer);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	/* The callbacks of an offline CPU are flushed by rcutree_migrate_callbacks(). */
+	if (rdp->cpu == smp_processor_id()) {
+		rcu_lazy_flush(rdp);
+		invoke_rcu_core();
+	}
+	local_irq_restore(flags);
+}
+
+/*
+ * Queue @head on ->lazy_cblist if it is lazy, else flush ->lazy_cblist so
+ * that it goes ahead of @head.  Returns true if @head was queued.
+ */
+static bool rcu_lazy_enqueue(struct rcu_data *rdp, struct rcu_head *head, bool lazy)
+{
+	if (!lazy || rcu_scheduler_active != RCU_SCHEDULER_RUNNING ||
+	    cpu_is_offline(rdp->cpu)) {
+		rcu_lazy_flush(rdp);
+		return false;
+	}
+
+	rcu_cblist_enqueue(&rdp->lazy_cblist, head);
+	trace_rcu_callback(rcu_state.name, head,
+			   rcu_segcblist_n_cbs(&rdp->cblist) + rdp->lazy_cblist.len);
+	if (rdp->lazy_cblist.len == 1) {
+		mod_timer(&rdp->lazy_timer, jiffies + rcu_get_jiffies_lazy_flush());
+	} else if (rdp->lazy_cblist.len >= qhimark) {
+		rcu_lazy_flush(rdp);
+		invoke_rcu_core();
+	}
+	return true;
+}
+
+static void rcu_lazy_flush_ipi(void *unused)
+{
+	struct rcu_data *rdp = this_cpu_ptr(&rcu_data);
+
+	if (!rcu_rdp_is_offloaded(rdp) && rdp->lazy_cblist.len) {
+		rcu_lazy_flush(rdp);
+		invoke_rcu_core();
+	}
+}
+
+static unsigned long
+lazy_cblist_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		count += rcu_lazy_n_cbs(per_cpu_ptr(&rcu_data, cpu));
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long
+lazy_cblist_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int cpu;
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		long len = rcu_lazy_n_cbs(per_cpu_ptr(&rcu_data, cpu));
+
+		if (!len)
+			continue;
+		smp_call_function_single(cpu, rcu_lazy_flush_ipi, NULL, 1);
+		count += len;
+		if (count >= sc->nr_to_scan)
+			break;
+	}
+	cpus_read_unlock();
+
+	return count ? count : SHRINK_STOP;
+}
+
+static void __init rcu_boot_init_lazy_percpu_data(struct rcu_data *rdp)
+{
+	rcu_cblist_init(&rdp->lazy_cblist);
+	timer_setup(&rdp->lazy_timer, rcu_lazy_timer_fn, TIMER_PINNED);
+}
+
+static int __init rcu_lazy_cblist_init(void)
+{
+	struct shrinker *shrinker;
+
+	if (!enable_rcu_lazy)
+		return 0;
+
+	shrinker = shrinker_alloc(0, "rcu-lazy-cblist");
+	if (!shrinker) {
+		pr_err("Failed to allocate lazy_cblist shrinker!\n");
+		return 0;
+	}
+	shrinker->count_objects = lazy_cblist_shrink_count;
+	shrinker->scan_objects = lazy_cblist_shrink_scan;
+	shrinker_register(shrinker);
+	return 0;
+}
+core_initcall(rcu_lazy_cblist_init);
+#else /* #ifdef CONFIG_RCU_LAZY */
+static long rcu_lazy_n_cbs(struct rcu_data *rdp) { return 0; }
+static void rcu_lazy_flush(struct rcu_data *rdp) { }
+static bool rcu_lazy_enqueue(struct rcu_data *rdp, struct rcu_head *head, bool lazy)
+{
+	return false;
+}
+static void __init rcu_boot_init_lazy_percpu_data(struct rcu_data *rdp) { }
+#endif /* #else #ifdef CONFIG_RCU_LAZY */
+
 static void
 __call_rcu_common(struct rcu_head *head, rcu_callback_t func, bool lazy_in)
 {
@@ -3089,15 +3278,12 @@ __call_rcu_common(struct rcu_head *head, rcu_callback_t func, bool lazy_in)
 
 	if (unlikely(rcu_rdp_is_offloaded(rdp)))
 		call_rcu_nocb(rdp, head, func, flags, lazy);
-	else
+	else if (!rcu_lazy_enqueue(rdp, head, lazy))
 		call_rcu_core(rdp, head, func, flags);
 	local_irq_restore(flags);
 }
 
 #ifdef CONFIG_RCU_LAZY
-static bool enable_rcu_lazy __read_mostly = !IS_ENABLED(CONFIG_RCU_LAZY_DEFAULT_OFF);
-module_param(enable_rcu_lazy, bool, 0444);
-
 /**
  * call_rcu_hurry() - Queue RCU callback for invocation after grace period, and
  * flush all lazy callbacks (including the new one) to the main ->cblist while
@@ -4398,6 +4584,7 @@ static void rcu_barrier_entrain(struct rcu_data *rdp)
 	was_alldone = rcu_rdp_is_offloaded(rdp) && !rcu_segcblist_pend_cbs(&rdp->cblist);
 	WARN_ON_ONCE(!rcu_nocb_flush_bypass(rdp, NULL, jiffies, false));
 	wake_nocb = was_alldone && rcu_segcblist_pend_cbs(&rdp->cblist);
+	rcu_lazy_flush(rdp);
 	if (rcu_segcblist_entrain(&rdp->cblist, &rdp->barrier_head)) {
 		atomic_inc(&rcu_state.barrier_cpu_count);
 	} else {
@@ -4483,7 +4670,7 @@ void rcu_barrier(void)
 		if (smp_load_acquire(&rdp->barrier_seq_snap) == gseq)
 			continue;
 		raw_spin_lock_irqsave(&rcu_state.barrier_lock, flags);
-		if (!rcu_segcblist_n_cbs(&rdp->cblist)) {
+		if (!rcu_segcblist_n_cbs(&rdp->cblist) && !rcu_lazy_n_cbs(rdp)) {
 			WRITE_ONCE(rdp->barrier_seq_snap, gseq);
 			raw_spin_unlock_irqrestore(&rcu_state.barrier_lock, flags);
 			rcu_barrier_trace(TPS("NQ"), cpu, rcu_state.barrier_sequence);
@@ -4776,6 +4963,7 @@ rcu_boot_init_percpu_data(int cpu)
 	rdp->last_sched_clock = jiffies;
 	rdp->cpu = cpu;
 	rcu_boot_init_nocb_percpu_data(rdp);
+	rcu_boot_init_lazy_percpu_data(rdp);
 }
 
 struct kthread_worker *rcu_exp_gp_kworker;
@@ -5110,6 +5298,11 @@ void rcutree_migrate_callbacks(int cpu)
 	struct rcu_data *rdp = per_cpu_ptr(&rcu_data, cpu);
 	bool needwake;
 
+	if (rcu_lazy_n_cbs(rdp)) {
+		local_irq_save(flags);
+		rcu_lazy_flush(rdp);
+		local_irq_restore(flags);
+	}
 	if (rcu_rdp_is_offloaded(rdp) ||
 	    rcu_segcblist_empty(&rdp->cblist))
 		return;  /* No callbacks to migrate. */
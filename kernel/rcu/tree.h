@@ -216,6 +216,7 @@ struct rcu_data {
 	unsigned long barrier_seq_snap;	/* Snap of rcu_state.barrier_sequence. */
 	struct rcu_head barrier_head;
 	int exp_dynticks_snap;		/* Double-check need for IPI. */
+	bool exp_ipi_deferred;		/* Expedited IPI held back, nohz_full. */
 
 	/* 5) Callback offloading. */
 #ifdef CONFIG_RCU_NOCB_CPU
@@ -282,6 +283,12 @@ struct rcu_data {
 					    /* the first RCU stall timeout */
 
 	long lazy_len;			/* Length of buffered lazy callbacks. */
+#ifdef CONFIG_RCU_LAZY
+	struct rcu_cblist lazy_cblist;	/* Lazy CBs of a non-offloaded CPU. */
+	struct timer_list lazy_timer;	/* Flushes ->lazy_cblist. */
+#endif
+	bool cb_deferred;		/* CB invocation left to rcuc kthread. */
+	unsigned long cb_deferred_at;	/* Jiffies when ->cb_deferred was set. */
 	int cpu;
 };
 
@@ -353,6 +353,7 @@ static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 		unsigned long mask = rdp->grpmask;
 		int snap;
 
+		WRITE_ONCE(rdp->exp_ipi_deferred, false);
 		if (raw_smp_processor_id() == cpu ||
 		    !(rnp->qsmaskinitnext & mask)) {
 			mask_ofl_test |= mask;
@@ -385,6 +386,12 @@ static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 			mask_ofl_test |= mask;
 			continue;
 		}
+		/* Leave it to synchronize_rcu_expedited_wait(), see rcu_exp_nohz_full_delay. */
+		if (READ_ONCE(rcu_exp_nohz_full_delay) > 0 && tick_nohz_full_cpu(cpu) &&
+		    rcu_inkernel_boot_has_ended() && raw_smp_processor_id() != cpu) {
+			WRITE_ONCE(rdp->exp_ipi_deferred, true);
+			continue;
+		}
 		if (get_cpu() == cpu) {
 			mask_ofl_test |= mask;
 			put_cpu();
@@ -523,6 +530,58 @@ static bool synchronize_rcu_expedited_wait_once(long tlimit)
 	return false;
 }
 
+/*
+ * Report the quiescent states of the nohz_full CPUs whose IPI was held back
+ * and that have since passed through an extended quiescent state.  If @ipi,
+ * the others are sent their IPI after all.  Returns true if any CPU still
+ * has its IPI held back.
+ */
+static bool rcu_exp_check_deferred_ipis(bool ipi)
+{
+	int cpu;
+	unsigned long flags;
+	unsigned long mask;
+	unsigned long mask_qs;
+	bool ret = false;
+	struct rcu_data *rdp;
+	struct rcu_node *rnp;
+
+	rcu_for_each_leaf_node(rnp) {
+		mask_qs = 0;
+		for_each_leaf_node_cpu_mask(rnp, cpu, READ_ONCE(rnp->expmask)) {
+			rdp = per_cpu_ptr(&rcu_data, cpu);
+			mask = rdp->grpmask;
+			if (!READ_ONCE(rdp->exp_ipi_deferred))
+				continue;
+			if (rcu_dynticks_in_eqs_since(rdp, rdp->exp_dynticks_snap)) {
+				WRITE_ONCE(rdp->exp_ipi_deferred, false);
+				mask_qs |= mask;
+				continue;
+			}
+			if (!ipi) {
+				ret = true;
+				continue;
+			}
+			if (!smp_call_function_single(cpu, rcu_exp_handler, NULL, 0)) {
+				WRITE_ONCE(rdp->exp_ipi_deferred, false);
+				continue;
+			}
+			/* Raced with CPU hotplug, as in __sync_rcu_exp_select_node_cpus(). */
+			raw_spin_lock_irqsave_rcu_node(rnp, flags);
+			if (!(rnp->qsmaskinitnext & mask)) {
+				WRITE_ONCE(rdp->exp_ipi_deferred, false);
+				mask_qs |= mask;
+			} else {
+				ret = true;
+			}
+			raw_spin_unlock_irqrestore_rcu_node(rnp, flags);
+		}
+		if (mask_qs)
+			rcu_report_exp_cpu_mult(rnp, mask_qs, true);
+	}
+	return ret;
+}
+
 /*
  * Wait for the expedited grace period to elapse, issuing any needed
  * RCU CPU stall warnings along the way.
@@ -544,6 +603,11 @@ static void synchronize_rcu_expedited_wait(void)
 	jiffies_stall = rcu_exp_jiffies_till_stall_check();
 	jiffies_start = jiffies;
 	if (tick_nohz_full_enabled() && rcu_inkernel_boot_has_ended()) {
+		j = jiffies_start + READ_ONCE(rcu_exp_nohz_full_delay);
+		while (rcu_exp_check_deferred_ipis(time_after_eq(jiffies, j))) {
+			if (synchronize_rcu_expedited_wait_once(1))
+				return;
+		}
 		if (synchronize_rcu_expedited_wait_once(1))
 			return;
 		rcu_for_each_leaf_node(rnp) {
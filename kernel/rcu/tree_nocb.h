@@ -1262,6 +1262,8 @@ static long rcu_nocb_rdp_offload(void *arg)
 	 * is set.
 	 */
 	raw_spin_lock_irqsave(&rdp->nocb_lock, flags);
+	/* From now on, the bypass list batches the lazy callbacks. */
+	rcu_lazy_flush(rdp);
 
 	/*
 	 * We didn't take the nocb lock while working on the
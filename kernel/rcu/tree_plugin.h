@@ -1008,8 +1008,11 @@ static void rcu_cpu_kthread_setup(unsigned int cpu)
 #ifdef CONFIG_RCU_BOOST
 	struct sched_param sp;
 
-	sp.sched_priority = kthread_prio;
-	sched_setscheduler_nocheck(current, SCHED_FIFO, &sp);
+	/* With softirq, rcuc only gets the callbacks deferred by rcu_do_batch(). */
+	if (!use_softirq) {
+		sp.sched_priority = kthread_prio;
+		sched_setscheduler_nocheck(current, SCHED_FIFO, &sp);
+	}
 #endif /* #ifdef CONFIG_RCU_BOOST */
 
 	WRITE_ONCE(rdp->rcuc_activity, jiffies);
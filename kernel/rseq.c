@@ -13,6 +13,7 @@
 #include <linux/syscalls.h>
 #include <linux/rseq.h>
 #include <linux/types.h>
+#include <linux/eventfd.h>
 #include <asm/ptrace.h>
 
 #define CREATE_TRACE_POINTS
@@ -104,6 +105,11 @@ static int rseq_update_cpu_node_id(struct task_struct *t)
 	 * need to be conditionally updated only if
 	 * t->rseq_len != ORIG_RSEQ_SIZE.
 	 */
+	if (t->rseq_blocked) {
+		/* Only set when the area has room, see rseq_set_block_notify() */
+		unsafe_put_user(0, &rseq->sched_state, efault_end);
+		t->rseq_blocked = false;
+	}
 	user_write_access_end();
 	trace_rseq_update(t);
 	return 0;
@@ -339,6 +345,64 @@ void __rseq_handle_notify_resume(struct ksignal *ksig, struct pt_regs *regs)
 	force_sigsegv(sig);
 }
 
+/*
+ * Blocking notification: a user-space scheduler multiplexing fibers over
+ * its threads can ask to learn when a thread blocks in the kernel, to run
+ * another fiber on that CPU in the meantime.  Each time the thread blocks,
+ * the eventfd is signalled and RSEQ_SCHED_STATE_BLOCKED is set in the
+ * sched_state field of its rseq area, until the thread returns to user-space.
+ */
+int rseq_set_block_notify(int fd)
+{
+	struct task_struct *t = current;
+	struct eventfd_ctx *ctx = NULL;
+
+	if (fd >= 0) {
+		if (!t->rseq ||
+		    t->rseq_len < offsetofend(struct rseq, sched_state))
+			return -EINVAL;
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	} else if (fd != -1) {
+		return -EINVAL;
+	}
+
+	rseq_release_block_notify(t);
+	t->rseq_block_notify = ctx;
+	return 0;
+}
+
+void rseq_release_block_notify(struct task_struct *t)
+{
+	struct eventfd_ctx *ctx = t->rseq_block_notify;
+
+	if (!ctx)
+		return;
+	/* Cleared before the put, schedule() may look at it meanwhile */
+	WRITE_ONCE(t->rseq_block_notify, NULL);
+	eventfd_ctx_put(ctx);
+}
+
+/*
+ * This runs from schedule() for a task going to sleep, possibly with locks
+ * such as mmap_lock held: it must neither sleep nor fault.  If the rseq area
+ * isn't present, the state update is skipped but the eventfd still fires.
+ */
+void __rseq_sched_block(struct task_struct *t)
+{
+	u32 __user *state = &t->rseq->sched_state;
+
+	pagefault_disable();
+	if (!put_user(RSEQ_SCHED_STATE_BLOCKED, state))
+		t->rseq_blocked = true;
+	pagefault_enable();
+
+	/* Reset the state on the way back to user-space */
+	rseq_set_notify_resume(t);
+	eventfd_signal(t->rseq_block_notify);
+}
+
 #ifdef CONFIG_DEBUG_RSEQ
 
 /*
@@ -380,6 +444,7 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 		ret = rseq_reset_rseq_cpu_node_id(current);
 		if (ret)
 			return ret;
+		rseq_release_block_notify(current);
 		current->rseq = NULL;
 		current->rseq_sig = 0;
 		current->rseq_len = 0;
@@ -245,6 +245,7 @@ void sched_core_enqueue(struct rq *rq, struct task_struct *p)
 		return;
 
 	rb_add(&p->core_node, &rq->core_tree, rb_sched_core_less);
+	rq->core_nr_cookied++;
 }
 
 void sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags)
@@ -254,6 +255,7 @@ void sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags)
 	if (sched_core_enqueued(p)) {
 		rb_erase(&p->core_node, &rq->core_tree);
 		RB_CLEAR_NODE(&p->core_node);
+		rq->core_nr_cookied--;
 	}
 
 	/*
@@ -3938,7 +3940,12 @@ static void __ttwu_queue_wakelist(struct task_struct *p, int cpu, int wake_flags
 	p->sched_remote_wakeup = !!(wake_flags & WF_MIGRATED);
 
 	WRITE_ONCE(rq->ttwu_pending, 1);
-	__smp_call_single_queue(cpu, &p->wake_entry.llist);
+	if (__smp_call_single_queue(cpu, &p->wake_entry.llist))
+		return;
+
+	/* Batched with the earlier wakeups the target has yet to handle */
+	schedstat_inc(this_rq()->ttwu_batched);
+	trace_sched_wake_batched(p, cpu);
 }
 
 void wake_up_if_idle(int cpu)
@@ -4564,6 +4571,7 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 #ifdef CONFIG_SMP
 	p->wake_entry.u_flags = CSD_TYPE_TTWU;
 	p->migration_pending = NULL;
+	init_sched_mm(p);
 #endif
 	init_sched_mm_cid(p);
 }
@@ -5699,6 +5707,7 @@ void sched_tick(void)
 
 #ifdef CONFIG_SMP
 	rq->idle_balance = idle_cpu(cpu);
+	update_idle_cpus(rq, rq->idle_balance);
 	sched_balance_trigger(rq);
 #endif
 }
@@ -6099,6 +6108,52 @@ static inline struct task_struct *pick_task(struct rq *rq)
 	BUG(); /* The idle class should always have a runnable task. */
 }
 
+/*
+ * Returns the cookie all the tasks queued on the siblings of @rq carry, or 0
+ * if any of them is untagged or differs.  The core tree of each runqueue is
+ * ordered by cookie, so its first and last entries give the range.
+ *
+ * The counts are only a hint: tasks on a throttled cfs_rq stay in the core
+ * tree but drop out of nr_running, so an untagged runnable task can hide
+ * behind them.  The caller must still check the task it picks, and the
+ * tasks the other siblings are running are checked here.
+ */
+static unsigned long sched_core_uniform_cookie(struct rq *rq)
+{
+	unsigned long cookie = 0;
+	int i;
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		struct rq *rq_i = cpu_rq(i);
+		unsigned long first, last;
+
+		if (!rq_i->nr_running)
+			continue;
+		if (rq_i->core_nr_cookied != rq_i->nr_running)
+			return 0;
+
+		first = __node_2_sc(rb_first(&rq_i->core_tree))->core_cookie;
+		last = __node_2_sc(rb_last(&rq_i->core_tree))->core_cookie;
+		if (first != last || (cookie && cookie != first))
+			return 0;
+		cookie = first;
+	}
+
+	if (!cookie)
+		return 0;
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		struct rq *rq_i = cpu_rq(i);
+
+		if (rq_i == rq || rq_i->curr == rq_i->idle)
+			continue;
+		if (rq_i->curr->core_cookie != cookie)
+			return 0;
+	}
+
+	return cookie;
+}
+
 extern void task_vruntime_update(struct rq *rq, struct task_struct *p, bool in_fi);
 
 static void queue_core_balance(struct rq *rq);
@@ -6206,6 +6261,28 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 		}
 	}
 
+	/*
+	 * When all the tasks queued on the core carry the same cookie, the
+	 * siblings can't end up running incompatible tasks whatever each of
+	 * them picks, so neither a core wide selection nor forced idle is
+	 * needed.  Each sibling validates its own pick the same way, so the
+	 * fast path is only taken when the task picked here carries that
+	 * cookie.
+	 */
+	if (!fi_before) {
+		cookie = sched_core_uniform_cookie(rq);
+		if (cookie) {
+			next = pick_task(rq);
+			if (next->core_cookie == cookie) {
+				rq->core_pick = NULL;
+				rq->core->core_cookie = cookie;
+				rq->core->core_uniform_picks++;
+				task_vruntime_update(rq, next, false);
+				goto out_set_next;
+			}
+		}
+	}
+
 	/*
 	 * For each thread: do the regular task pick and find the max prio task
 	 * amongst them.
@@ -6787,6 +6864,8 @@ static inline void sched_submit_work(struct task_struct *tsk)
 	else if (task_flags & PF_IO_WORKER)
 		io_wq_worker_sleeping(tsk);
 
+	rseq_sched_block(tsk);
+
 	/*
 	 * spinlock and rwlock must not flush block requests.  This will
 	 * deadlock if the callback attempts to acquire a lock which is
@@ -10595,13 +10674,83 @@ static int cpu_cgroup_can_attach(struct cgroup_taskset *tset)
 }
 #endif
 
+/*
+ * Groups without a timer slack of their own use the one of their nearest
+ * ancestor that has one.  Zero means none is set up to the root.
+ */
+static u64 tg_timer_slack(struct task_group *tg)
+{
+	for (; tg; tg = tg->parent) {
+		u64 slack = READ_ONCE(tg->timer_slack_ns);
+
+		if (slack)
+			return slack;
+	}
+	return 0;
+}
+
+/* Like PR_SET_TIMERSLACK, a zero @slack restores the task's default. */
+static void sched_set_timer_slack(struct task_struct *p, u64 slack)
+{
+	/* Real-time tasks don't use timer slack, see hrtimer_nanosleep() */
+	if (rt_task(p))
+		return;
+	WRITE_ONCE(p->timer_slack_ns, slack ? slack : p->default_timer_slack_ns);
+}
+
+/* Set once any group had a timer slack, until then moves leave it alone */
+static bool tg_timer_slack_used;
+
 static void cpu_cgroup_attach(struct cgroup_taskset *tset)
 {
 	struct task_struct *task;
 	struct cgroup_subsys_state *css;
+	bool slack_used = READ_ONCE(tg_timer_slack_used);
 
-	cgroup_taskset_for_each(task, css, tset)
+	cgroup_taskset_for_each(task, css, tset) {
 		sched_move_task(task);
+		/*
+		 * A group without a slack resets a task coming from a group
+		 * that had one back to its default.
+		 */
+		if (slack_used)
+			sched_set_timer_slack(task, tg_timer_slack(css_tg(css)));
+	}
+}
+
+static DEFINE_MUTEX(timer_slack_mutex);
+
+static u64 cpu_timer_slack_read_u64(struct cgroup_subsys_state *css,
+				    struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->timer_slack_ns);
+}
+
+static int cpu_timer_slack_write_u64(struct cgroup_subsys_state *css,
+				     struct cftype *cft, u64 slack)
+{
+	struct cgroup_subsys_state *pos;
+	struct css_task_iter it;
+	struct task_struct *p;
+
+	if (slack > ULONG_MAX)
+		return -EINVAL;
+
+	guard(mutex)(&timer_slack_mutex);
+	WRITE_ONCE(css_tg(css)->timer_slack_ns, slack);
+	if (slack)
+		WRITE_ONCE(tg_timer_slack_used, true);
+
+	guard(rcu)();
+	css_for_each_descendant_pre(pos, css) {
+		u64 eff = tg_timer_slack(css_tg(pos));
+
+		css_task_iter_start(pos, 0, &it);
+		while ((p = css_task_iter_next(&it)))
+			sched_set_timer_slack(p, eff);
+		css_task_iter_end(&it);
+	}
+	return 0;
 }
 
 #ifdef CONFIG_UCLAMP_TASK_GROUP
@@ -11182,6 +11331,12 @@ static int cpu_idle_write_s64(struct cgroup_subsys_state *css,
 #endif
 
 static struct cftype cpu_legacy_files[] = {
+	{
+		.name = "timer_slack_ns",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_timer_slack_read_u64,
+		.write_u64 = cpu_timer_slack_write_u64,
+	},
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
 		.name = "shares",
@@ -11353,6 +11508,18 @@ static int cpu_weight_nice_write_s64(struct cgroup_subsys_state *css,
 
 	return sched_group_set_shares(css_tg(css), scale_load(weight));
 }
+
+static s64 cpu_latency_nice_read_s64(struct cgroup_subsys_state *css,
+				     struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->latency_nice);
+}
+
+static int cpu_latency_nice_write_s64(struct cgroup_subsys_state *css,
+				      struct cftype *cft, s64 nice)
+{
+	return sched_group_set_latency_nice(css_tg(css), nice);
+}
 #endif
 
 static void __maybe_unused cpu_period_quota_print(struct seq_file *sf,
@@ -11413,6 +11580,12 @@ static ssize_t cpu_max_write(struct kernfs_open_file *of,
 #endif
 
 static struct cftype cpu_files[] = {
+	{
+		.name = "timer_slack_ns",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_timer_slack_read_u64,
+		.write_u64 = cpu_timer_slack_write_u64,
+	},
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
 		.name = "weight",
@@ -11432,6 +11605,12 @@ static struct cftype cpu_files[] = {
 		.read_s64 = cpu_idle_read_s64,
 		.write_s64 = cpu_idle_write_s64,
 	},
+	{
+		.name = "latency.nice",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_s64 = cpu_latency_nice_read_s64,
+		.write_s64 = cpu_latency_nice_write_s64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -257,6 +257,7 @@ void __sched_core_account_forceidle(struct rq *rq)
 		return;
 
 	rq->core->core_forceidle_start = now;
+	rq->core->core_forceidle_sum += delta * rq->core->core_forceidle_count;
 
 	if (WARN_ON_ONCE(!rq->core->core_forceidle_occupation)) {
 		/* can't be forced idle without a running task */
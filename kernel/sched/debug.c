@@ -804,6 +804,15 @@ do {									\
 #undef P64
 #endif
 
+#ifdef CONFIG_SCHED_CORE
+	if (sched_core_enabled(rq)) {
+		SEQ_printf(m, "  .%-30s: %Ld.%06ld\n", "core_forceidle_sum",
+			   SPLIT_NS(rq->core->core_forceidle_sum));
+		SEQ_printf(m, "  .%-30s: %u\n", "core_uniform_picks",
+			   rq->core->core_uniform_picks);
+	}
+#endif
+
 #define P(n) SEQ_printf(m, "  .%-30s: %d\n", #n, schedstat_val(rq->n));
 	if (schedstat_enabled()) {
 		P(yld_count);
@@ -127,6 +127,12 @@ static unsigned int sysctl_sched_cfs_bandwidth_slice		= 5000UL;
 #ifdef CONFIG_NUMA_BALANCING
 /* Restrict the NUMA promotion throughput (MB/s) for each target node. */
 static unsigned int sysctl_numa_balancing_promote_rate_limit = 65536;
+/*
+ * Restrict the throughput (MB/s) of hinting fault migrations for each task,
+ * and migrate them in batches off the fault path.  Zero migrates synchronously
+ * in the faulting task without a limit.
+ */
+unsigned int sysctl_numa_balancing_batch_migrate_rate_limit;
 #endif
 
 #ifdef CONFIG_SYSCTL
@@ -150,6 +156,14 @@ static struct ctl_table sched_fair_sysctls[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= SYSCTL_ZERO,
 	},
+	{
+		.procname	= "numa_balancing_batch_migrate_MBps",
+		.data		= &sysctl_numa_balancing_batch_migrate_rate_limit,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
 #endif /* CONFIG_NUMA_BALANCING */
 };
 
@@ -974,6 +988,34 @@ static void clear_buddies(struct cfs_rq *cfs_rq, struct sched_entity *se);
  * XXX: strictly: vd_i += N*r_i/w_i such that: vd_i > ve_i
  * this is probably good enough.
  */
+/* Bounds of the request size latency nice can give */
+#define SLICE_MIN	(100 * NSEC_PER_USEC)
+#define SLICE_MAX	(100 * NSEC_PER_MSEC)
+
+/*
+ * The request size of @se: sysctl_sched_base_slice, scaled by the latency nice
+ * of the group it belongs to (a task) or represents (a group entity).  Like
+ * the weights, each latency nice step changes the slice by about 25%.  A
+ * shorter request gives an earlier deadline, so such entities preempt and get
+ * picked sooner, in shorter bursts.
+ */
+static u64 se_slice(struct sched_entity *se)
+{
+	u64 slice = sysctl_sched_base_slice;
+#ifdef CONFIG_FAIR_GROUP_SCHED
+	struct cfs_rq *cfs_rq = entity_is_task(se) ? cfs_rq_of(se) : group_cfs_rq(se);
+	int nice = READ_ONCE(cfs_rq->tg->latency_nice);
+
+	if (nice) {
+		/* slice * NICE_0 weight / weight(nice) */
+		slice = mul_u64_u32_shr(slice * 1024,
+					sched_prio_to_wmult[nice - MIN_NICE], 32);
+		slice = clamp_t(u64, slice, SLICE_MIN, SLICE_MAX);
+	}
+#endif
+	return slice;
+}
+
 static void update_deadline(struct cfs_rq *cfs_rq, struct sched_entity *se)
 {
 	if ((s64)(se->vruntime - se->deadline) < 0)
@@ -982,9 +1024,9 @@ static void update_deadline(struct cfs_rq *cfs_rq, struct sched_entity *se)
 	/*
 	 * For EEVDF the virtual time slope is determined by w_i (iow.
 	 * nice) while the request time r_i is determined by
-	 * sysctl_sched_base_slice.
+	 * sysctl_sched_base_slice and the latency nice, see se_slice().
 	 */
-	se->slice = sysctl_sched_base_slice;
+	se->slice = se_slice(se);
 
 	/*
 	 * EEVDF: vd_i = ve_i + r_i / w_i
@@ -1126,6 +1168,176 @@ static s64 update_curr_se(struct rq *rq, struct sched_entity *curr)
 	return delta_exec;
 }
 
+#ifdef CONFIG_SCHED_CACHE
+/*
+ * Cache aware wakeup placement.
+ *
+ * The runtime of the tasks of each mm is accounted per CPU, halving every
+ * EPOCH_PERIOD, and every so often the LLC that saw most of it recently is
+ * picked as the preferred LLC of the mm.  With SCHED_CACHE, wakeups of the
+ * tasks of the mm are steered into that LLC as long as it has idle CPUs, so
+ * that threads working on the same data also end up sharing a cache.
+ */
+#define EPOCH_PERIOD	(HZ / 100)	/* 10 ms */
+#define EPOCH_OLD	5		/* 50 ms */
+
+static u64 mm_sched_runtime(struct mm_sched *pcpu_sched, unsigned long epoch)
+{
+	unsigned long n = epoch - READ_ONCE(pcpu_sched->epoch);
+
+	if (n >= EPOCH_OLD)
+		return 0;
+	return READ_ONCE(pcpu_sched->runtime) >> n;
+}
+
+static void account_mm_sched(struct rq *rq, struct task_struct *p,
+			     s64 delta_exec)
+{
+	struct mm_struct *mm = p->mm;
+	struct mm_sched *pcpu_sched;
+	unsigned long epoch;
+
+	if (!mm || !mm->pcpu_sched)
+		return;
+
+	/* The per-cpu values are serialized by the runqueue lock */
+	pcpu_sched = per_cpu_ptr(mm->pcpu_sched, cpu_of(rq));
+	epoch = jiffies / EPOCH_PERIOD;
+	WRITE_ONCE(pcpu_sched->runtime,
+		   mm_sched_runtime(pcpu_sched, epoch) + delta_exec);
+	WRITE_ONCE(pcpu_sched->epoch, epoch);
+}
+
+static void task_cache_work(struct callback_head *work)
+{
+	unsigned long now = jiffies, epoch = now / EPOCH_PERIOD;
+	u64 best_runtime = 0, cur_runtime = 0;
+	struct task_struct *p = current;
+	int cpu, i, best_cpu = -1, cur_cpu;
+	struct mm_struct *mm = p->mm;
+	unsigned long next_scan;
+	cpumask_var_t cpus;
+
+	SCHED_WARN_ON(p != container_of(work, struct task_struct, cache_work));
+
+	work->next = work;	/* Prevent double-add */
+	if (p->flags & PF_EXITING)
+		return;
+	if (!mm || !mm->pcpu_sched)
+		return;
+
+	next_scan = READ_ONCE(mm->mm_sched_scan);
+	if (time_before(now, next_scan) ||
+	    !try_cmpxchg(&mm->mm_sched_scan, &next_scan,
+			 now + EPOCH_PERIOD * EPOCH_OLD))
+		return;
+
+	if (!zalloc_cpumask_var(&cpus, GFP_KERNEL))
+		return;
+
+	cur_cpu = READ_ONCE(mm->mm_sched_cpu);
+
+	rcu_read_lock();
+	cpumask_copy(cpus, cpu_active_mask);
+	for_each_cpu(cpu, cpus) {
+		struct sched_domain *sd = rcu_dereference(per_cpu(sd_llc, cpu));
+		u64 llc_runtime = 0, max_runtime = 0;
+		int max_cpu = cpu;
+
+		if (!sd)
+			continue;
+
+		/* Sum up the LLC of @cpu, and take it out of the walk */
+		for_each_cpu_and(i, sched_domain_span(sd), cpus) {
+			u64 runtime = mm_sched_runtime(per_cpu_ptr(mm->pcpu_sched, i),
+						       epoch);
+
+			llc_runtime += runtime;
+			if (runtime > max_runtime) {
+				max_runtime = runtime;
+				max_cpu = i;
+			}
+		}
+		cpumask_andnot(cpus, cpus, sched_domain_span(sd));
+
+		if (cur_cpu >= 0 && cpumask_test_cpu(cur_cpu, sched_domain_span(sd)))
+			cur_runtime = llc_runtime;
+		if (llc_runtime > best_runtime) {
+			best_runtime = llc_runtime;
+			best_cpu = max_cpu;
+		}
+	}
+	rcu_read_unlock();
+	free_cpumask_var(cpus);
+
+	/* Only move to another LLC once it is clearly preferable */
+	if (best_cpu >= 0 && cur_runtime && cur_runtime >= best_runtime * 3 / 4)
+		return;
+	WRITE_ONCE(mm->mm_sched_cpu, best_cpu);
+}
+
+void init_sched_mm(struct task_struct *p)
+{
+	struct callback_head *work = &p->cache_work;
+
+	work->next = work;	/* Protect against double add */
+	init_task_work(work, task_cache_work);
+}
+
+static void task_tick_cache(struct rq *rq, struct task_struct *p)
+{
+	struct callback_head *work = &p->cache_work;
+	struct mm_struct *mm = p->mm;
+
+	if (!sched_feat(SCHED_CACHE))
+		return;
+	if (!mm || !mm->pcpu_sched || (p->flags & (PF_EXITING | PF_KTHREAD)) ||
+	    work->next != work)
+		return;
+	/* A single thread has nobody to share its cache with */
+	if (atomic_read(&mm->mm_users) <= 1)
+		return;
+	if (time_before(jiffies, READ_ONCE(mm->mm_sched_scan)))
+		return;
+	task_work_add(p, work, TWA_RESUME);
+}
+
+/*
+ * Wake @p in the preferred LLC of its mm rather than around @target, unless
+ * that LLC has no idle CPU left that @p could use.
+ */
+static int select_cache_cpu(struct task_struct *p, int target)
+{
+	struct sched_domain_shared *sds;
+	struct mm_struct *mm = p->mm;
+	int cpu;
+
+	if (!sched_feat(SCHED_CACHE) || !mm)
+		return target;
+
+	cpu = READ_ONCE(mm->mm_sched_cpu);
+	if (cpu < 0 || cpus_share_cache(cpu, target) ||
+	    !cpumask_test_cpu(cpu, p->cpus_ptr))
+		return target;
+
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (!sds || !cpumask_intersects(sds_idle_cpus(sds), p->cpus_ptr))
+		return target;
+
+	return cpu;
+}
+#else /* !CONFIG_SCHED_CACHE */
+static inline void account_mm_sched(struct rq *rq, struct task_struct *p,
+				    s64 delta_exec) { }
+static inline void task_tick_cache(struct rq *rq, struct task_struct *p) { }
+#ifdef CONFIG_SMP
+static inline int select_cache_cpu(struct task_struct *p, int target)
+{
+	return target;
+}
+#endif
+#endif /* CONFIG_SCHED_CACHE */
+
 static inline void update_curr_task(struct task_struct *p, s64 delta_exec)
 {
 	trace_sched_stat_runtime(p, delta_exec);
@@ -1169,8 +1381,10 @@ static void update_curr(struct cfs_rq *cfs_rq)
 	update_deadline(cfs_rq, curr);
 	update_min_vruntime(cfs_rq);
 
-	if (entity_is_task(curr))
+	if (entity_is_task(curr)) {
 		update_curr_task(task_of(curr), delta_exec);
+		account_mm_sched(rq_of(cfs_rq), task_of(curr), delta_exec);
+	}
 
 	account_cfs_rq_runtime(cfs_rq, delta_exec);
 }
@@ -1794,6 +2008,31 @@ static bool numa_promotion_rate_limit(struct pglist_data *pgdat,
 	return false;
 }
 
+/*
+ * Check whether @p, which must be current, has budget left in this second for
+ * @nr_pages of batched hinting fault migration.  The pages are only charged
+ * once they are actually queued, see task_numa_migrate_charge().
+ */
+bool task_numa_migrate_budget(struct task_struct *p, int nr_pages)
+{
+	unsigned long budget;
+	unsigned int now;
+
+	budget = READ_ONCE(sysctl_numa_balancing_batch_migrate_rate_limit) <<
+		(20 - PAGE_SHIFT);
+	now = jiffies_to_msecs(jiffies);
+	if (now - p->numa_migrate_budget_start > MSEC_PER_SEC) {
+		p->numa_migrate_budget_start = now;
+		p->numa_migrate_budget_used = 0;
+	}
+	return p->numa_migrate_budget_used + nr_pages <= budget;
+}
+
+void task_numa_migrate_charge(struct task_struct *p, int nr_pages)
+{
+	p->numa_migrate_budget_used += nr_pages;
+}
+
 #define NUMA_MIGRATION_ADJUST_STEPS	16
 
 static void numa_promotion_adjust_threshold(struct pglist_data *pgdat,
@@ -3459,6 +3698,8 @@ void init_numa_balancing(unsigned long clone_flags, struct task_struct *p)
 	p->numa_work.next		= &p->numa_work;
 	p->numa_faults			= NULL;
 	p->numa_pages_migrated		= 0;
+	p->numa_migrate_budget_start	= 0;
+	p->numa_migrate_budget_used	= 0;
 	p->total_numa_faults		= 0;
 	RCU_INIT_POINTER(p->numa_group, NULL);
 	p->last_task_numa_placement	= 0;
@@ -5179,7 +5420,7 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	u64 vslice, vruntime = avg_vruntime(cfs_rq);
 	s64 lag = 0;
 
-	se->slice = sysctl_sched_base_slice;
+	se->slice = se_slice(se);
 	vslice = calc_delta_fair(se->slice, se);
 
 	/*
@@ -7398,6 +7639,32 @@ static inline int select_idle_smt(struct task_struct *p, struct sched_domain *sd
 
 #endif /* CONFIG_SCHED_SMT */
 
+/*
+ * Keep the bit of this CPU in sd_llc_shared->idle_cpus up to date.  Only the
+ * CPU itself writes its bit: it is set on entering idle and cleared from the
+ * tick once busy, so the mask may briefly contain busy CPUs but never misses
+ * an idle one.  The shared mask is only written when the state changes.
+ */
+void update_idle_cpus(struct rq *rq, bool idle)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+
+	/* CPUs only running SCHED_IDLE tasks are as good as idle for wakeups */
+	if (!idle && sched_idle_rq(rq))
+		idle = true;
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (sds && cpumask_test_cpu(cpu, sds_idle_cpus(sds)) != idle) {
+		if (idle)
+			cpumask_set_cpu(cpu, sds_idle_cpus(sds));
+		else
+			cpumask_clear_cpu(cpu, sds_idle_cpus(sds));
+	}
+	rcu_read_unlock();
+}
+
 /*
  * Scan the LLC domain for idle CPUs; this is dynamically regulated by
  * comparing the average scan cost (tracked in sd->avg_scan_cost) against the
@@ -7411,15 +7678,18 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
 
-	if (sched_feat(SIS_UTIL)) {
-		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
-		if (sd_share) {
+	sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
+	if (sd_share) {
+		if (sched_feat(SIS_UTIL)) {
 			/* because !--nr is the condition to stop scan */
 			nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
 			/* overloaded LLC is unlikely to have idle cpu/core */
 			if (nr == 1)
 				return -1;
 		}
+		/* don't bother visiting CPUs that were busy at their last tick */
+		if (sched_feat(SIS_FILTER))
+			cpumask_and(cpus, cpus, sds_idle_cpus(sd_share));
 	}
 
 	if (static_branch_unlikely(&sched_cluster_active)) {
@@ -7430,6 +7700,7 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 				if (!cpumask_test_cpu(cpu, cpus))
 					continue;
 
+				schedstat_inc(sd->sis_scanned);
 				if (has_idle_core) {
 					i = select_idle_core(p, cpu, cpus, &idle_cpu);
 					if ((unsigned int)i < nr_cpumask_bits)
@@ -7447,6 +7718,7 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 	}
 
 	for_each_cpu_wrap(cpu, cpus, target + 1) {
+		schedstat_inc(sd->sis_scanned);
 		if (has_idle_core) {
 			i = select_idle_core(p, cpu, cpus, &idle_cpu);
 			if ((unsigned int)i < nr_cpumask_bits)
@@ -7647,9 +7919,11 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 		}
 	}
 
+	schedstat_inc(sd->sis_search);
 	i = select_idle_cpu(p, sd, has_idle_core, target);
 	if ((unsigned)i < nr_cpumask_bits)
 		return i;
+	schedstat_inc(sd->sis_failed);
 
 	/*
 	 * For cluster machines which have lower sharing cache like L2 or
@@ -8247,6 +8521,7 @@ select_task_rq_fair(struct task_struct *p, int prev_cpu, int wake_flags)
 		new_cpu = sched_balance_find_dst_cpu(sd, p, cpu, prev_cpu, sd_flag);
 	} else if (wake_flags & WF_TTWU) { /* XXX always ? */
 		/* Fast path */
+		new_cpu = select_cache_cpu(p, new_cpu);
 		new_cpu = select_idle_sibling(p, prev_cpu, new_cpu);
 	}
 	rcu_read_unlock();
@@ -9058,6 +9333,19 @@ int can_migrate_task(struct task_struct *p, struct lb_env *env)
 	if (tsk_cache_hot == -1)
 		tsk_cache_hot = task_hot(p, env);
 
+	/*
+	 * Newidle balancing only pulls opportunistically. Across nodes, leave
+	 * tasks that are cache hot or on their preferred node to the periodic
+	 * balance, rather than have them lose their cache and memory locality
+	 * for what may be a short idle period.
+	 */
+	if (tsk_cache_hot == 1 && env->idle == CPU_NEWLY_IDLE &&
+	    (env->sd->flags & SD_NUMA)) {
+		schedstat_inc(env->sd->nib_hot_refused);
+		schedstat_inc(p->stats.nr_failed_migrations_hot);
+		return 0;
+	}
+
 	if (tsk_cache_hot <= 0 ||
 	    env->sd->nr_balance_failed > env->sd->cache_nice_tries) {
 		if (tsk_cache_hot == 1) {
@@ -12413,12 +12701,22 @@ static int sched_balance_newidle(struct rq *this_rq, struct rq_flags *rf)
 
 	rcu_read_lock();
 	for_each_domain(this_cpu, sd) {
-		u64 domain_cost;
+		u64 domain_cost = sd->max_newidle_lb_cost;
 
 		update_next_balance(sd, &next_balance);
 
-		if (this_rq->avg_idle < curr_cost + sd->max_newidle_lb_cost)
+		/*
+		 * A task pulled from another node starts out with a cold cache
+		 * and remote memory; only go there if the expected idle time
+		 * also covers warming the task up again.
+		 */
+		if (sd->flags & SD_NUMA)
+			domain_cost += sysctl_sched_migration_cost;
+
+		if (this_rq->avg_idle < curr_cost + domain_cost) {
+			schedstat_inc(sd->nib_cost_stop);
 			break;
+		}
 
 		if (sd->flags & SD_BALANCE_NEWIDLE) {
 
@@ -12689,6 +12987,8 @@ static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 	if (static_branch_unlikely(&sched_numa_balancing))
 		task_tick_numa(rq, curr);
 
+	task_tick_cache(rq, curr);
+
 	update_misfit_status(curr, rq);
 	check_update_overutilized_status(task_rq(curr));
 
@@ -13091,6 +13391,22 @@ int sched_group_set_shares(struct task_group *tg, unsigned long shares)
 	return ret;
 }
 
+/*
+ * The new request size is picked up as the entities of the group place or
+ * renew their requests, within a slice.
+ */
+int sched_group_set_latency_nice(struct task_group *tg, long nice)
+{
+	if (tg == &root_task_group)
+		return -EINVAL;
+
+	if (nice < MIN_NICE || nice > MAX_NICE)
+		return -ERANGE;
+
+	WRITE_ONCE(tg->latency_nice, nice);
+	return 0;
+}
+
 int sched_group_set_idle(struct task_group *tg, long idle)
 {
 	int i;
@@ -51,6 +51,18 @@ SCHED_FEAT(TTWU_QUEUE, true)
  */
 SCHED_FEAT(SIS_UTIL, true)
 
+/*
+ * Only scan the CPUs of the LLC that were idle as of their last tick.
+ */
+SCHED_FEAT(SIS_FILTER, true)
+
+#ifdef CONFIG_SCHED_CACHE
+/*
+ * Steer wakeups into the LLC where the tasks of the same mm ran recently.
+ */
+SCHED_FEAT(SCHED_CACHE, false)
+#endif
+
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
  * in a single rq->lock section. Default disabled because the
@@ -296,7 +296,7 @@ static int membarrier_global_expedited(void)
 	rcu_read_unlock();
 
 	preempt_disable();
-	smp_call_function_many(tmpmask, ipi_mb, NULL, 1);
+	smp_call_function_many_coalesce(tmpmask, ipi_mb, NULL, true);
 	preempt_enable();
 
 	free_cpumask_var(tmpmask);
@@ -153,6 +153,18 @@ static int __init setup_psi(char *str)
 }
 __setup("psi=", setup_psi);
 
+/*
+ * Cgroups nested deeper than this share the pressure accounting of their
+ * ancestor at this level, so that task state changes don't have to update
+ * every level of deep hierarchies.  Their pressure files are hidden.
+ */
+static unsigned int psi_cgroup_depth __read_mostly = UINT_MAX;
+static int __init setup_psi_cgroup_depth(char *str)
+{
+	return kstrtouint(str, 0, &psi_cgroup_depth) == 0;
+}
+__setup("psi_cgroup_depth=", setup_psi_cgroup_depth);
+
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
@@ -1094,6 +1106,11 @@ int psi_cgroup_alloc(struct cgroup *cgroup)
 	if (!static_branch_likely(&psi_cgroups_enabled))
 		return 0;
 
+	if (cgroup->level > psi_cgroup_depth) {
+		cgroup->psi = cgroup_psi(cgroup_parent(cgroup));
+		return 0;
+	}
+
 	cgroup->psi = kzalloc(sizeof(struct psi_group), GFP_KERNEL);
 	if (!cgroup->psi)
 		return -ENOMEM;
@@ -1113,6 +1130,10 @@ void psi_cgroup_free(struct cgroup *cgroup)
 	if (!static_branch_likely(&psi_cgroups_enabled))
 		return;
 
+	/* Shared with an ancestor, see psi_cgroup_alloc() */
+	if (cgroup->level > psi_cgroup_depth)
+		return;
+
 	cancel_delayed_work_sync(&cgroup->psi->avgs_work);
 	free_percpu(cgroup->psi->pcpu);
 	/* All triggers must be removed by now */
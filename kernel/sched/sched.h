@@ -402,6 +402,8 @@ struct task_group {
 
 	/* A positive value indicates that this is a SCHED_IDLE group. */
 	int			idle;
+	/* Scales the request size of the entities of the group, see se_slice() */
+	int			latency_nice;
 
 #ifdef	CONFIG_SMP
 	/*
@@ -433,6 +435,9 @@ struct task_group {
 
 	struct cfs_bandwidth	cfs_bandwidth;
 
+	/* Timer slack of the tasks of the group, 0 to use the parent's */
+	u64			timer_slack_ns;
+
 #ifdef CONFIG_UCLAMP_TASK_GROUP
 	/* The two decimal precision [%] value requested from user-space */
 	unsigned int		uclamp_pct[UCLAMP_CNT];
@@ -523,6 +528,7 @@ extern void sched_move_task(struct task_struct *tsk);
 extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
 
 extern int sched_group_set_idle(struct task_group *tg, long idle);
+extern int sched_group_set_latency_nice(struct task_group *tg, long nice);
 
 #ifdef CONFIG_SMP
 extern void set_task_rq_fair(struct sched_entity *se,
@@ -1162,6 +1168,7 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int		ttwu_count;
 	unsigned int		ttwu_local;
+	unsigned int		ttwu_batched;
 #endif
 
 #ifdef CONFIG_CPU_IDLE
@@ -1182,6 +1189,7 @@ struct rq {
 	unsigned int		core_enabled;
 	unsigned int		core_sched_seq;
 	struct rb_root		core_tree;
+	unsigned int		core_nr_cookied;
 
 	/* shared state -- careful with sched_core_cpu_deactivate() */
 	unsigned int		core_task_seq;
@@ -1191,6 +1199,9 @@ struct rq {
 	unsigned int		core_forceidle_seq;
 	unsigned int		core_forceidle_occupation;
 	u64			core_forceidle_start;
+	/* time the siblings spent forced idle, and picks of uniform cookies */
+	u64			core_forceidle_sum;
+	unsigned int		core_uniform_picks;
 #endif
 
 	/* Scratch cpumask to be temporarily used under rq_lock */
@@ -2401,6 +2412,13 @@ extern struct task_struct *pick_next_task_idle(struct rq *rq);
 extern void update_group_capacity(struct sched_domain *sd, int cpu);
 
 extern void sched_balance_trigger(struct rq *rq);
+extern void update_idle_cpus(struct rq *rq, bool idle);
+
+#ifdef CONFIG_SCHED_CACHE
+extern void init_sched_mm(struct task_struct *p);
+#else
+static inline void init_sched_mm(struct task_struct *p) { }
+#endif
 
 extern void set_cpus_allowed_common(struct task_struct *p, struct affinity_context *ctx);
 
@@ -166,11 +166,16 @@ struct notification {
  * @allow_compat: A bitmap where each bit represents whether the
  *		  filter will always allow the syscall, for the
  *		  compat architecture.
+ * @self_native: Like @allow_native, but for this filter alone rather
+ *		 than the whole stack ending at it.
+ * @self_compat: Like @allow_compat, but for this filter alone.
  */
 struct action_cache {
 	DECLARE_BITMAP(allow_native, SECCOMP_ARCH_NATIVE_NR);
+	DECLARE_BITMAP(self_native, SECCOMP_ARCH_NATIVE_NR);
 #ifdef SECCOMP_ARCH_COMPAT
 	DECLARE_BITMAP(allow_compat, SECCOMP_ARCH_COMPAT_NR);
+	DECLARE_BITMAP(self_compat, SECCOMP_ARCH_COMPAT_NR);
 #endif
 };
 #else
@@ -182,6 +187,12 @@ static inline bool seccomp_cache_check_allow(const struct seccomp_filter *sfilte
 	return false;
 }
 
+static inline bool seccomp_cache_check_self(const struct seccomp_filter *sfilter,
+					    const struct seccomp_data *sd)
+{
+	return false;
+}
+
 static inline void seccomp_cache_prepare(struct seccomp_filter *sfilter)
 {
 }
@@ -391,6 +402,37 @@ static inline bool seccomp_cache_check_allow(const struct seccomp_filter *sfilte
 	WARN_ON_ONCE(true);
 	return false;
 }
+
+/**
+ * seccomp_cache_check_self - lookup the per-filter seccomp cache
+ * @sfilter: The seccomp filter
+ * @sd: The seccomp data to lookup the cache with
+ *
+ * Returns true if @sfilter alone always allows the seccomp_data, so it
+ * can be skipped while evaluating the rest of the stack.
+ */
+static inline bool seccomp_cache_check_self(const struct seccomp_filter *sfilter,
+					    const struct seccomp_data *sd)
+{
+	int syscall_nr = sd->nr;
+	const struct action_cache *cache = &sfilter->cache;
+
+#ifndef SECCOMP_ARCH_COMPAT
+	return seccomp_cache_check_allow_bitmap(cache->self_native,
+						SECCOMP_ARCH_NATIVE_NR,
+						syscall_nr);
+#else
+	if (likely(sd->arch == SECCOMP_ARCH_NATIVE))
+		return seccomp_cache_check_allow_bitmap(cache->self_native,
+							SECCOMP_ARCH_NATIVE_NR,
+							syscall_nr);
+	if (likely(sd->arch == SECCOMP_ARCH_COMPAT))
+		return seccomp_cache_check_allow_bitmap(cache->self_compat,
+							SECCOMP_ARCH_COMPAT_NR,
+							syscall_nr);
+	return false;
+#endif /* SECCOMP_ARCH_COMPAT */
+}
 #endif /* SECCOMP_ARCH_NATIVE */
 
 #define ACTION_ONLY(ret) ((s32)((ret) & (SECCOMP_RET_ACTION_FULL)))
@@ -420,10 +462,16 @@ static u32 seccomp_run_filters(const struct seccomp_data *sd,
 
 	/*
 	 * All filters in the list are evaluated and the lowest BPF return
-	 * value always takes priority (ignoring the DATA).
+	 * value always takes priority (ignoring the DATA). Filters known to
+	 * allow this syscall cannot lower it and are skipped.
 	 */
 	for (; f; f = f->prev) {
-		u32 cur_ret = bpf_prog_run_pin_on_cpu(f->prog, sd);
+		u32 cur_ret;
+
+		if (seccomp_cache_check_self(f, sd))
+			continue;
+
+		cur_ret = bpf_prog_run_pin_on_cpu(f->prog, sd);
 
 		if (ACTION_ONLY(cur_ret) < ACTION_ONLY(ret)) {
 			ret = cur_ret;
@@ -800,38 +848,33 @@ static bool seccomp_is_const_allow(struct sock_fprog_kern *fprog,
 }
 
 static void seccomp_cache_prepare_bitmap(struct seccomp_filter *sfilter,
-					 void *bitmap, const void *bitmap_prev,
+					 void *bitmap, void *bitmap_self,
+					 const void *bitmap_prev,
 					 size_t bitmap_size, int arch)
 {
 	struct sock_fprog_kern *fprog = sfilter->prog->orig_prog;
 	struct seccomp_data sd;
 	int nr;
 
-	if (bitmap_prev) {
-		/* The new filter must be as restrictive as the last. */
-		bitmap_copy(bitmap, bitmap_prev, bitmap_size);
-	} else {
-		/* Before any filters, all syscalls are always allowed. */
-		bitmap_fill(bitmap, bitmap_size);
-	}
-
+	/*
+	 * Record which syscalls this filter alone always allows.
+	 * Non-atomic bitops are fine, the filter is not visible yet.
+	 */
+	bitmap_zero(bitmap_self, bitmap_size);
 	for (nr = 0; nr < bitmap_size; nr++) {
-		/* No bitmap change: not a cacheable action. */
-		if (!test_bit(nr, bitmap))
-			continue;
-
 		sd.nr = nr;
 		sd.arch = arch;
 
-		/* No bitmap change: continue to always allow. */
 		if (seccomp_is_const_allow(fprog, &sd))
-			continue;
+			__set_bit(nr, bitmap_self);
+	}
 
-		/*
-		 * Not a cacheable action: always run filters.
-		 * atomic clear_bit() not needed, filter not visible yet.
-		 */
-		__clear_bit(nr, bitmap);
+	if (bitmap_prev) {
+		/* The new filter must be as restrictive as the last. */
+		bitmap_and(bitmap, bitmap_prev, bitmap_self, bitmap_size);
+	} else {
+		/* Before any filters, all syscalls are always allowed. */
+		bitmap_copy(bitmap, bitmap_self, bitmap_size);
 	}
 }
 
@@ -848,12 +891,14 @@ static void seccomp_cache_prepare(struct seccomp_filter *sfilter)
 		sfilter->prev ? &sfilter->prev->cache : NULL;
 
 	seccomp_cache_prepare_bitmap(sfilter, cache->allow_native,
+				     cache->self_native,
 				     cache_prev ? cache_prev->allow_native : NULL,
 				     SECCOMP_ARCH_NATIVE_NR,
 				     SECCOMP_ARCH_NATIVE);
 
 #ifdef SECCOMP_ARCH_COMPAT
 	seccomp_cache_prepare_bitmap(sfilter, cache->allow_compat,
+				     cache->self_compat,
 				     cache_prev ? cache_prev->allow_compat : NULL,
 				     SECCOMP_ARCH_COMPAT_NR,
 				     SECCOMP_ARCH_COMPAT);
@@ -38,8 +38,11 @@
 
 struct call_function_data {
 	call_single_data_t	__percpu *csd;
+	call_single_data_t	__percpu *csd_fwd;
 	cpumask_var_t		cpumask;
 	cpumask_var_t		cpumask_ipi;
+	cpumask_var_t		cpumask_fwd;
+	unsigned int		fanout;
 };
 
 static DEFINE_PER_CPU_ALIGNED(struct call_function_data, cfd_data);
@@ -58,18 +61,29 @@ int smpcfd_prepare_cpu(unsigned int cpu)
 				     cpu_to_node(cpu)))
 		return -ENOMEM;
 	if (!zalloc_cpumask_var_node(&cfd->cpumask_ipi, GFP_KERNEL,
-				     cpu_to_node(cpu))) {
-		free_cpumask_var(cfd->cpumask);
-		return -ENOMEM;
-	}
+				     cpu_to_node(cpu)))
+		goto free_cpumask;
+	if (!zalloc_cpumask_var_node(&cfd->cpumask_fwd, GFP_KERNEL,
+				     cpu_to_node(cpu)))
+		goto free_cpumask_ipi;
 	cfd->csd = alloc_percpu(call_single_data_t);
-	if (!cfd->csd) {
-		free_cpumask_var(cfd->cpumask);
-		free_cpumask_var(cfd->cpumask_ipi);
-		return -ENOMEM;
-	}
+	if (!cfd->csd)
+		goto free_cpumask_fwd;
+	cfd->csd_fwd = alloc_percpu(call_single_data_t);
+	if (!cfd->csd_fwd)
+		goto free_csd;
 
 	return 0;
+
+free_csd:
+	free_percpu(cfd->csd);
+free_cpumask_fwd:
+	free_cpumask_var(cfd->cpumask_fwd);
+free_cpumask_ipi:
+	free_cpumask_var(cfd->cpumask_ipi);
+free_cpumask:
+	free_cpumask_var(cfd->cpumask);
+	return -ENOMEM;
 }
 
 int smpcfd_dead_cpu(unsigned int cpu)
@@ -78,7 +92,9 @@ int smpcfd_dead_cpu(unsigned int cpu)
 
 	free_cpumask_var(cfd->cpumask);
 	free_cpumask_var(cfd->cpumask_ipi);
+	free_cpumask_var(cfd->cpumask_fwd);
 	free_percpu(cfd->csd);
+	free_percpu(cfd->csd_fwd);
 	return 0;
 }
 
@@ -346,7 +362,7 @@ static __always_inline void csd_unlock(call_single_data_t *csd)
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(call_single_data_t, csd_data);
 
-void __smp_call_single_queue(int cpu, struct llist_node *node)
+bool __smp_call_single_queue(int cpu, struct llist_node *node)
 {
 	/*
 	 * We have to check the type of the CSD before queueing it, because
@@ -378,8 +394,11 @@ void __smp_call_single_queue(int cpu, struct llist_node *node)
 	 * locking and barrier primitives. Generic code isn't really
 	 * equipped to do the right thing...
 	 */
-	if (llist_add(node, &per_cpu(call_single_queue, cpu)))
-		send_call_function_single_ipi(cpu);
+	if (!llist_add(node, &per_cpu(call_single_queue, cpu)))
+		return false;
+
+	send_call_function_single_ipi(cpu);
+	return true;
 }
 
 /*
@@ -417,6 +436,29 @@ static int generic_exec_single(int cpu, call_single_data_t *csd)
 	return 0;
 }
 
+/*
+ * Callbacks queued with CSD_FLAG_COALESCE are idempotent: any invocation which
+ * starts after the csd got queued does the job. @csd can thus share the
+ * invocation of an identical callback which this flush already ran, e.g. when
+ * several CPUs broadcast the same membarrier or kick IPI at once.
+ */
+static __always_inline bool csd_coalesce(call_single_data_t *csd,
+					 smp_call_func_t *last_func,
+					 void **last_info)
+{
+	if (!(csd->node.u_flags & CSD_FLAG_COALESCE))
+		return false;
+
+	if (csd->func == *last_func && csd->info == *last_info) {
+		trace_csd_function_coalesce(csd->func, csd);
+		return true;
+	}
+
+	*last_func = csd->func;
+	*last_info = csd->info;
+	return false;
+}
+
 /**
  * generic_smp_call_function_single_interrupt - Execute SMP IPI callbacks
  *
@@ -447,6 +489,8 @@ static void __flush_smp_call_function_queue(bool warn_cpu_offline)
 	call_single_data_t *csd, *csd_next;
 	struct llist_node *entry, *prev;
 	struct llist_head *head;
+	smp_call_func_t last_func = NULL;
+	void *last_info = NULL;
 	static bool warned;
 	atomic_t *tbt;
 
@@ -507,6 +551,11 @@ static void __flush_smp_call_function_queue(bool warn_cpu_offline)
 				entry = &csd_next->node.llist;
 			}
 
+			if (csd_coalesce(csd, &last_func, &last_info)) {
+				csd_unlock(csd);
+				continue;
+			}
+
 			csd_lock_record(csd);
 			csd_do_func(func, info, csd);
 			csd_unlock(csd);
@@ -537,6 +586,11 @@ static void __flush_smp_call_function_queue(bool warn_cpu_offline)
 				smp_call_func_t func = csd->func;
 				void *info = csd->info;
 
+				if (csd_coalesce(csd, &last_func, &last_info)) {
+					csd_unlock(csd);
+					continue;
+				}
+
 				csd_lock_record(csd);
 				csd_unlock(csd);
 				csd_do_func(func, info, csd);
@@ -749,9 +803,73 @@ EXPORT_SYMBOL_GPL(smp_call_function_any);
  *
  * %SCF_WAIT:		Wait until function execution is completed
  * %SCF_RUN_LOCAL:	Run also locally if local cpu is set in cpumask
+ * %SCF_COALESCE:	The function is idempotent, see csd_coalesce()
  */
 #define SCF_WAIT	(1U << 0)
 #define SCF_RUN_LOCAL	(1U << 1)
+#define SCF_COALESCE	(1U << 2)
+
+/*
+ * Waiting broadcasts to more than twice this many CPUs are sent as a tree: the
+ * sender only IPIs every ipi_fanout'th target, which in turn IPIs the
+ * following ipi_fanout - 1 targets, so that the IPIs to the leaves go out in
+ * parallel. The sender has to wait for the forwarders before it can reuse its
+ * cpumask, which only comes for free when it waits for the targets anyway, so
+ * asynchronous broadcasts are never sent as a tree. 0 disables it.
+ */
+static unsigned int ipi_fanout = 16;
+module_param(ipi_fanout, uint, 0644);
+
+/*
+ * Runs from the IPI handler of a forwarding CPU, queued by
+ * smp_call_function_many_cond() on behalf of the sender owning @info.
+ */
+static void smp_ipi_forward(void *info)
+{
+	struct call_function_data *cfd = info;
+	int cpu = smp_processor_id();
+	unsigned int i;
+
+	for (i = 1; i < cfd->fanout; i++) {
+		cpu = cpumask_next(cpu, cfd->cpumask_ipi);
+		if (cpu >= nr_cpu_ids)
+			break;
+		send_call_function_single_ipi(cpu);
+	}
+}
+
+/*
+ * Send the IPIs for the csds queued on the CPUs of @cfd->cpumask_ipi, picking
+ * every @cfd->fanout'th of them as a forwarder for the following ones.
+ */
+static void send_call_function_ipi_tree(struct call_function_data *cfd)
+{
+	unsigned int i = 0;
+	int cpu;
+
+	cpumask_clear(cfd->cpumask_fwd);
+	for_each_cpu(cpu, cfd->cpumask_ipi) {
+		call_single_data_t *csd;
+
+		if (i++ % cfd->fanout)
+			continue;
+
+		csd = per_cpu_ptr(cfd->csd_fwd, cpu);
+		csd_lock(csd);
+		csd->node.u_flags |= CSD_TYPE_SYNC;
+		csd->func = smp_ipi_forward;
+		csd->info = cfd;
+#ifdef CONFIG_CSD_LOCK_WAIT_DEBUG
+		csd->node.src = smp_processor_id();
+		csd->node.dst = cpu;
+#endif
+		trace_csd_queue_cpu(cpu, _RET_IP_, smp_ipi_forward, csd);
+		llist_add(&csd->node.llist, &per_cpu(call_single_queue, cpu));
+		__cpumask_set_cpu(cpu, cfd->cpumask_fwd);
+	}
+
+	send_call_function_ipi_mask(cfd->cpumask_fwd);
+}
 
 static void smp_call_function_many_cond(const struct cpumask *mask,
 					smp_call_func_t func, void *info,
@@ -761,9 +879,11 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 	int cpu, last_cpu, this_cpu = smp_processor_id();
 	struct call_function_data *cfd;
 	bool wait = scf_flags & SCF_WAIT;
+	unsigned int fanout = READ_ONCE(ipi_fanout);
 	int nr_cpus = 0;
 	bool run_remote = false;
 	bool run_local = false;
+	bool tree = false;
 
 	lockdep_assert_preemption_disabled();
 
@@ -813,6 +933,8 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 			csd_lock(csd);
 			if (wait)
 				csd->node.u_flags |= CSD_TYPE_SYNC;
+			if (scf_flags & SCF_COALESCE)
+				csd->node.u_flags |= CSD_FLAG_COALESCE;
 			csd->func = func;
 			csd->info = info;
 #ifdef CONFIG_CSD_LOCK_WAIT_DEBUG
@@ -833,10 +955,15 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 		 * number of CPUs might be zero due to concurrent changes to the
 		 * provided mask.
 		 */
-		if (nr_cpus == 1)
+		if (nr_cpus == 1) {
 			send_call_function_single_ipi(last_cpu);
-		else if (likely(nr_cpus > 1))
+		} else if (wait && fanout > 1 && nr_cpus > 2 * fanout) {
+			cfd->fanout = fanout;
+			send_call_function_ipi_tree(cfd);
+			tree = true;
+		} else if (likely(nr_cpus > 1)) {
 			send_call_function_ipi_mask(cfd->cpumask_ipi);
+		}
 	}
 
 	if (run_local && (!cond_func || cond_func(this_cpu, info))) {
@@ -855,6 +982,12 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 			csd_lock_wait(csd);
 		}
 	}
+
+	/* The forwarders walk @cfd->cpumask_ipi, don't let it be reused early */
+	if (tree) {
+		for_each_cpu(cpu, cfd->cpumask_fwd)
+			csd_lock_wait(per_cpu_ptr(cfd->csd_fwd, cpu));
+	}
 }
 
 /**
@@ -880,6 +1013,27 @@ void smp_call_function_many(const struct cpumask *mask,
 }
 EXPORT_SYMBOL(smp_call_function_many);
 
+/**
+ * smp_call_function_many_coalesce(): Run an idempotent function on a set of CPUs.
+ * @mask: The set of cpus to run on (only runs on online subset).
+ * @func: The function to run. This must be fast and non-blocking.
+ * @info: An arbitrary pointer to pass to the function.
+ * @wait: If true, wait (atomically) until function has completed on other CPUs.
+ *
+ * Like smp_call_function_many(), but a remote CPU which has several calls of
+ * @func with @info pending at once, from different senders, may run @func
+ * only once for all of them. Only use this for functions where any invocation
+ * after the call was made does the job, like memory barriers.
+ */
+void smp_call_function_many_coalesce(const struct cpumask *mask,
+				     smp_call_func_t func, void *info,
+				     bool wait)
+{
+	smp_call_function_many_cond(mask, func, info,
+				    wait * SCF_WAIT | SCF_COALESCE, NULL);
+}
+EXPORT_SYMBOL_GPL(smp_call_function_many_coalesce);
+
 /**
  * smp_call_function(): Run a function on all other CPUs.
  * @func: The function to run. This must be fast and non-blocking.
@@ -1044,7 +1198,9 @@ void kick_all_cpus_sync(void)
 {
 	/* Make sure the change is visible before we kick the cpus */
 	smp_mb();
-	smp_call_function(do_nothing, NULL, 1);
+	preempt_disable();
+	smp_call_function_many_coalesce(cpu_online_mask, do_nothing, NULL, true);
+	preempt_enable();
 }
 EXPORT_SYMBOL_GPL(kick_all_cpus_sync);
 
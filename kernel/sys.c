@@ -27,6 +27,7 @@
 #include <linux/posix-timers.h>
 #include <linux/security.h>
 #include <linux/random.h>
+#include <linux/rseq.h>
 #include <linux/suspend.h>
 #include <linux/tty.h>
 #include <linux/signal.h>
@@ -2748,6 +2749,11 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 	case PR_SET_VMA:
 		error = prctl_set_vma(arg2, arg3, arg4, arg5);
 		break;
+	case PR_SET_RSEQ_BLOCK_NOTIFY:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = rseq_set_block_notify((int)arg2);
+		break;
 	case PR_GET_AUXV:
 		if (arg4 || arg5)
 			return -EINVAL;
@@ -41,6 +41,8 @@
 #include <linux/sched/isolation.h>
 #include <linux/timer.h>
 #include <linux/freezer.h>
+#include <linux/math64.h>
+#include <linux/sysctl.h>
 #include <linux/compat.h>
 
 #include <linux/uaccess.h>
@@ -1186,6 +1188,50 @@ static inline ktime_t hrtimer_update_lowres(struct hrtimer *timer, ktime_t tim,
 	return tim;
 }
 
+/*
+ * If non-zero, the hard expiry of a timer with slack is moved back to the
+ * last multiple of this many nanoseconds within its slack window, so that
+ * timers with overlapping windows expire from a single interrupt.
+ */
+static unsigned long hrtimer_coalesce_ns __read_mostly;
+
+static void hrtimer_coalesce(struct hrtimer *timer, struct hrtimer_clock_base *base)
+{
+	unsigned long slot = READ_ONCE(hrtimer_coalesce_ns);
+	ktime_t hard = hrtimer_get_expires(timer);
+	ktime_t offs = base->offset;
+	u64 rem;
+
+	if (!slot || hard == KTIME_MAX ||
+	    hrtimer_get_softexpires(timer) >= hard)
+		return;
+
+	/* Align on the clock the clock event device is programmed with */
+	div64_u64_rem(ktime_sub(hard, offs), slot, &rem);
+	hard = ktime_sub_ns(hard, rem);
+	if (hard >= hrtimer_get_softexpires(timer))
+		timer->node.expires = hard;
+}
+
+#ifdef CONFIG_SYSCTL
+static struct ctl_table hrtimer_sysctl[] = {
+	{
+		.procname	= "hrtimer_coalesce_ns",
+		.data		= &hrtimer_coalesce_ns,
+		.maxlen		= sizeof(unsigned long),
+		.mode		= 0644,
+		.proc_handler	= proc_doulongvec_minmax,
+	},
+};
+
+static int __init hrtimer_sysctl_init(void)
+{
+	register_sysctl("kernel", hrtimer_sysctl);
+	return 0;
+}
+device_initcall(hrtimer_sysctl_init);
+#endif /* CONFIG_SYSCTL */
+
 static void
 hrtimer_update_softirq_timer(struct hrtimer_cpu_base *cpu_base, bool reprogram)
 {
@@ -1248,6 +1294,7 @@ static int __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 	tim = hrtimer_update_lowres(timer, tim, mode);
 
 	hrtimer_set_expires_range_ns(timer, tim, delta_ns);
+	hrtimer_coalesce(timer, base);
 
 	/* Switch the timer base, if necessary: */
 	if (!force_local) {
@@ -187,6 +187,9 @@ EXPORT_SYMBOL(jiffies_64);
  */
 #define WHEEL_SIZE	(LVL_SIZE * LVL_DEPTH)
 
+/* Number of expired timers run per lock drop, see expire_timers() */
+#define TIMER_EXPIRE_BATCH	16
+
 #ifdef CONFIG_NO_HZ_COMMON
 /*
  * If multiple bases need to be locked, use the base ordering for lock
@@ -223,6 +226,14 @@ EXPORT_SYMBOL(jiffies_64);
  * @timer_waiters:	PREEMPT_RT only: Tells, if there is a waiter
  *			waiting for the end of the timer callback function
  *			execution.
+ * @nr_batch:		Number of timers in @batch; only changed with the
+ *			lock held
+ * @batch:		Expired timers, detached from the wheel, which are run
+ *			in one go with the lock dropped. The expiry code claims
+ *			an entry by clearing it after making the timer
+ *			@running_timer. Entries which are not claimed yet can
+ *			be cleared by anyone holding the lock, to modify or
+ *			delete the timer as if it was still pending.
  * @clk:		clock of the timer base; is updated before enqueue
  *			of a timer; during expiry, it is 1 offset ahead of
  *			jiffies to avoid endless requeuing to current
@@ -255,6 +266,8 @@ struct timer_base {
 	spinlock_t		expiry_lock;
 	atomic_t		timer_waiters;
 #endif
+	unsigned int		nr_batch;
+	struct timer_list	*batch[TIMER_EXPIRE_BATCH];
 	unsigned long		clk;
 	unsigned long		next_expiry;
 	unsigned int		cpu;
@@ -937,13 +950,49 @@ static inline void detach_timer(struct timer_list *timer, bool clear_pending)
 	entry->next = LIST_POISON2;
 }
 
+static int timer_batch_idx(struct timer_base *base, struct timer_list *timer)
+{
+	unsigned int i;
+
+	for (i = 0; i < base->nr_batch; i++) {
+		if (READ_ONCE(base->batch[i]) == timer)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * Take @timer out of the batch being expired, if the expiry code did not claim
+ * it yet. To the caller, the timer was still pending. Called with the lock
+ * held, from any CPU.
+ *
+ * If this fails, the timer is either not batched or it was claimed, in which
+ * case base->running_timer was set to it before the claim. The barrier makes
+ * sure that the caller sees that when it checks base->running_timer next.
+ */
+static int timer_unbatch(struct timer_base *base, struct timer_list *timer)
+{
+	int idx;
+
+	if (!base->nr_batch)
+		return 0;
+
+	idx = timer_batch_idx(base, timer);
+	if (idx >= 0 && cmpxchg(&base->batch[idx], timer, NULL) == timer)
+		return 1;
+
+	smp_mb();
+	return 0;
+}
+
 static int detach_if_pending(struct timer_list *timer, struct timer_base *base,
 			     bool clear_pending)
 {
 	unsigned idx = timer_get_idx(timer);
+	int ret = timer_unbatch(base, timer);
 
 	if (!timer_pending(timer))
-		return 0;
+		return ret;
 
 	if (hlist_is_singular_node(&timer->entry, base->vectors + idx)) {
 		__clear_bit(idx, base->pending_map);
@@ -1389,6 +1438,17 @@ void add_timer_on(struct timer_list *timer, int cpu)
 }
 EXPORT_SYMBOL_GPL(add_timer_on);
 
+/*
+ * Lockless hint for __timer_delete() that @timer might sit in a batch, where
+ * it is not pending but can still be taken out.
+ */
+static inline bool timer_maybe_batched(struct timer_list *timer)
+{
+	struct timer_base *base = get_timer_base(READ_ONCE(timer->flags));
+
+	return READ_ONCE(base->nr_batch);
+}
+
 /**
  * __timer_delete - Internal function: Deactivate a timer
  * @timer:	The timer to be deactivated
@@ -1423,7 +1483,7 @@ static int __timer_delete(struct timer_list *timer, bool shutdown)
 	 * If timer->function is currently executed, then this makes sure
 	 * that the callback cannot requeue the timer.
 	 */
-	if (timer_pending(timer) || shutdown) {
+	if (timer_pending(timer) || shutdown || timer_maybe_batched(timer)) {
 		base = lock_timer_base(timer, &flags);
 		ret = detach_if_pending(timer, base, true);
 		if (shutdown)
@@ -1505,8 +1565,12 @@ static int __try_to_del_timer_sync(struct timer_list *timer, bool shutdown)
 
 	base = lock_timer_base(timer, &flags);
 
-	if (base->running_timer != timer)
+	if (base->running_timer != timer) {
 		ret = detach_if_pending(timer, base, true);
+		/* Claimed from the batch meanwhile, see timer_unbatch() */
+		if (!ret && READ_ONCE(base->running_timer) == timer)
+			ret = -1;
+	}
 	if (shutdown)
 		timer->function = NULL;
 
@@ -1807,6 +1871,50 @@ static void call_timer_fn(struct timer_list *timer,
 	}
 }
 
+/*
+ * Run the batched timers with the lock dropped once for all of them, instead
+ * of once per timer. Called with the lock held and interrupts disabled.
+ */
+static void expire_timer_batch(struct timer_base *base, unsigned long baseclk)
+{
+	unsigned int i, nr = base->nr_batch;
+
+	if (!nr)
+		return;
+
+	raw_spin_unlock_irq(&base->lock);
+
+	for (i = 0; i < nr; i++) {
+		struct timer_list *timer;
+		void (*fn)(struct timer_list *);
+
+		timer = READ_ONCE(base->batch[i]);
+		if (!timer)
+			continue;
+
+		/*
+		 * Publish the timer as running before claiming it, so whoever
+		 * fails to take it out of the batch sees it running. The
+		 * cmpxchg() implies a full barrier when it succeeds.
+		 */
+		WRITE_ONCE(base->running_timer, timer);
+		if (cmpxchg(&base->batch[i], timer, NULL) != timer) {
+			WRITE_ONCE(base->running_timer, NULL);
+			continue;
+		}
+
+		/* A NULL function means the timer was shut down meanwhile */
+		fn = READ_ONCE(timer->function);
+		if (fn)
+			call_timer_fn(timer, fn, baseclk);
+	}
+
+	raw_spin_lock_irq(&base->lock);
+	WRITE_ONCE(base->nr_batch, 0);
+	base->running_timer = NULL;
+	timer_sync_wait_running(base);
+}
+
 static void expire_timers(struct timer_base *base, struct hlist_head *head)
 {
 	/*
@@ -1822,6 +1930,24 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 
 		timer = hlist_entry(head->first, struct timer_list, entry);
 
+		/*
+		 * Irqsafe timers run with interrupts disabled, so they are
+		 * expired one at a time, after the batch that precedes them.
+		 */
+		if (!(timer->flags & TIMER_IRQSAFE) && timer->function) {
+			detach_timer(timer, true);
+			base->batch[base->nr_batch] = timer;
+			WRITE_ONCE(base->nr_batch, base->nr_batch + 1);
+			if (base->nr_batch == TIMER_EXPIRE_BATCH)
+				expire_timer_batch(base, baseclk);
+			continue;
+		}
+		expire_timer_batch(base, baseclk);
+		/* The lock was dropped, so @timer may be gone */
+		if (hlist_empty(head) ||
+		    timer != hlist_entry(head->first, struct timer_list, entry))
+			continue;
+
 		base->running_timer = timer;
 		detach_timer(timer, true);
 
@@ -1846,6 +1972,7 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 			timer_sync_wait_running(base);
 		}
 	}
+	expire_timer_batch(base, baseclk);
 }
 
 static int collect_expired_timers(struct timer_base *base,
@@ -2391,7 +2518,11 @@ static inline void __run_timers(struct timer_base *base)
 
 	lockdep_assert_held(&base->lock);
 
-	if (base->running_timer)
+	/*
+	 * A batch being expired has the lock dropped with no running timer
+	 * in between two callbacks. A remote expiry must not add to it.
+	 */
+	if (base->running_timer || base->nr_batch)
 		return;
 
 	while (time_after_eq(jiffies, base->clk) &&
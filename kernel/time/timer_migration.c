@@ -5,6 +5,8 @@
  * Copyright(C) 2022 linutronix GmbH
  */
 #include <linux/cpuhotplug.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/smp.h>
 #include <linux/spinlock.h>
@@ -422,6 +424,11 @@ static unsigned int tmigr_crossnode_level __read_mostly;
 
 static DEFINE_PER_CPU(struct tmigr_cpu, tmigr_cpu);
 
+/* Per CPU array of tmigr_hierarchy_levels entries */
+static struct tmigr_level_stats __percpu *tmigr_stats __read_mostly;
+
+#define tmigr_stat_inc(group, field)	this_cpu_inc(tmigr_stats[(group)->level].field)
+
 #define TMIGR_NONE	0xFF
 #define BIT_CNT		8
 
@@ -666,6 +673,7 @@ static bool tmigr_active_up(struct tmigr_group *group,
 	 */
 	group->groupevt.ignore = true;
 
+	tmigr_stat_inc(group, active);
 	trace_tmigr_group_set_cpu_active(group, newstate, childmask);
 
 	return walk_done;
@@ -1027,6 +1035,7 @@ static bool tmigr_handle_remote_up(struct tmigr_group *group,
 
 		raw_spin_unlock_irq(&group->lock);
 
+		tmigr_stat_inc(group, remote);
 		tmigr_handle_remote_cpu(remote_cpu, now, jif);
 
 		/* check if there is another event, that needs to be handled */
@@ -1312,6 +1321,10 @@ static bool tmigr_inactive_up(struct tmigr_group *group,
 		smp_mb__after_atomic();
 	}
 
+	tmigr_stat_inc(group, idle);
+	if (newstate.migrator != curstate.migrator && newstate.migrator != TMIGR_NONE)
+		tmigr_stat_inc(group, handover);
+
 	data->remote = false;
 
 	/* Event Handling */
@@ -1740,6 +1753,40 @@ static int tmigr_cpu_offline(unsigned int cpu)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int tmigr_stats_show(struct seq_file *m, void *v)
+{
+	unsigned int lvl;
+	int cpu;
+
+	seq_puts(m, "level active idle handover remote\n");
+	for (lvl = 0; lvl < tmigr_hierarchy_levels; lvl++) {
+		struct tmigr_level_stats sum = {};
+
+		for_each_possible_cpu(cpu) {
+			struct tmigr_level_stats *s = per_cpu_ptr(tmigr_stats, cpu) + lvl;
+
+			sum.active += data_race(s->active);
+			sum.idle += data_race(s->idle);
+			sum.handover += data_race(s->handover);
+			sum.remote += data_race(s->remote);
+		}
+		seq_printf(m, "%u %lu %lu %lu %lu\n", lvl, sum.active, sum.idle,
+			   sum.handover, sum.remote);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tmigr_stats);
+
+static void __init tmigr_debugfs_init(void)
+{
+	debugfs_create_file("timer_migration", 0444, NULL, NULL,
+			    &tmigr_stats_fops);
+}
+#else
+static inline void tmigr_debugfs_init(void) { }
+#endif
+
 static int __init tmigr_init(void)
 {
 	unsigned int cpulvl, nodelvl, cpus_per_node, i;
@@ -1791,6 +1838,11 @@ static int __init tmigr_init(void)
 	for (i = 0; i < tmigr_hierarchy_levels; i++)
 		INIT_LIST_HEAD(&tmigr_level_list[i]);
 
+	tmigr_stats = __alloc_percpu(tmigr_hierarchy_levels * sizeof(*tmigr_stats),
+				     __alignof__(*tmigr_stats));
+	if (!tmigr_stats)
+		goto err;
+
 	pr_info("Timer migration: %d hierarchy levels; %d children per group;"
 		" %d crossnode level\n",
 		tmigr_hierarchy_levels, TMIGR_CHILDREN_PER_GROUP,
@@ -1801,6 +1853,7 @@ static int __init tmigr_init(void)
 	if (ret)
 		goto err;
 
+	tmigr_debugfs_init();
 	return 0;
 
 err:
@@ -97,6 +97,22 @@ struct tmigr_cpu {
 	struct tmigr_event	cpuevt;
 };
 
+/**
+ * struct tmigr_level_stats - per CPU statistics of a hierarchy level
+ * @active:	Number of times a child became active in a group of the level
+ * @idle:	Number of times a child went idle in a group of the level
+ * @handover:	Number of times the migrator role of a group of the level
+ *		was handed over to another active child
+ * @remote:	Number of remote CPU timer expiries done on behalf of a
+ *		group of the level
+ */
+struct tmigr_level_stats {
+	unsigned long		active;
+	unsigned long		idle;
+	unsigned long		handover;
+	unsigned long		remote;
+};
+
 /**
  * union tmigr_state - state of tmigr_group
  * @state:	Combined version of the state - only used for atomic
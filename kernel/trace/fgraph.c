@@ -69,7 +69,6 @@ static int
 ftrace_push_return_trace(unsigned long ret, unsigned long func,
 			 unsigned long frame_pointer, unsigned long *retp)
 {
-	unsigned long long calltime;
 	int index;
 
 	if (unlikely(ftrace_graph_is_dead()))
@@ -90,13 +89,11 @@ ftrace_push_return_trace(unsigned long ret, unsigned long func,
 		return -EBUSY;
 	}
 
-	calltime = trace_clock_local();
-
 	index = ++current->curr_ret_stack;
 	barrier();
 	current->ret_stack[index].ret = ret;
 	current->ret_stack[index].func = func;
-	current->ret_stack[index].calltime = calltime;
+	current->ret_stack[index].calltime = 0;
 #ifdef HAVE_FUNCTION_GRAPH_FP_TEST
 	current->ret_stack[index].fp = frame_pointer;
 #endif
@@ -135,6 +132,13 @@ int function_graph_enter(unsigned long ret, unsigned long func,
 	if (!ftrace_graph_entry(&trace))
 		goto out_ret;
 
+	/*
+	 * Most functions are rejected by set_graph_function and friends,
+	 * only read the clock for the ones whose return will be traced.
+	 */
+	current->ret_stack[current->curr_ret_stack].calltime =
+		trace_clock_local();
+
 	return 0;
  out_ret:
 	current->curr_ret_stack--;
@@ -4667,18 +4667,12 @@ rb_get_reader_page(struct ring_buffer_per_cpu *cpu_buffer)
 	return reader;
 }
 
-static void rb_advance_reader(struct ring_buffer_per_cpu *cpu_buffer)
+/* Consume the next event of a reader page known to have one */
+static void __rb_advance_reader(struct ring_buffer_per_cpu *cpu_buffer)
 {
 	struct ring_buffer_event *event;
-	struct buffer_page *reader;
 	unsigned length;
 
-	reader = rb_get_reader_page(cpu_buffer);
-
-	/* This function should not be called when buffer is empty */
-	if (RB_WARN_ON(cpu_buffer, !reader))
-		return;
-
 	event = rb_reader_event(cpu_buffer);
 
 	if (event->type_len <= RINGBUF_TYPE_DATA_TYPE_LEN_MAX)
@@ -4691,6 +4685,19 @@ static void rb_advance_reader(struct ring_buffer_per_cpu *cpu_buffer)
 	cpu_buffer->read_bytes += length;
 }
 
+static void rb_advance_reader(struct ring_buffer_per_cpu *cpu_buffer)
+{
+	struct buffer_page *reader;
+
+	reader = rb_get_reader_page(cpu_buffer);
+
+	/* This function should not be called when buffer is empty */
+	if (RB_WARN_ON(cpu_buffer, !reader))
+		return;
+
+	__rb_advance_reader(cpu_buffer);
+}
+
 static void rb_advance_iter(struct ring_buffer_iter *iter)
 {
 	struct ring_buffer_per_cpu *cpu_buffer;
@@ -6444,10 +6451,14 @@ int ring_buffer_map_get_reader(struct trace_buffer *buffer, int cpu)
 	 * There are data to be read on the current reader page, we can
 	 * return to the caller. But before that, we assume the latter will read
 	 * everything. Let's update the kernel reader accordingly.
+	 *
+	 * The reader page can't be swapped under the reader_lock, so there
+	 * is no need to go through rb_get_reader_page() and its arch lock
+	 * for every single event.
 	 */
 	if (cpu_buffer->reader_page->read < reader_size) {
 		while (cpu_buffer->reader_page->read < reader_size)
-			rb_advance_reader(cpu_buffer);
+			__rb_advance_reader(cpu_buffer);
 		goto out;
 	}
 
@@ -0,0 +1,430 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Lock contention profiler
+ *
+ * Hooks the lock:contention_begin and lock:contention_end tracepoints, which
+ * all the lock slow paths in kernel/locking/ fire, and aggregates the wait
+ * times by lock address and caller stack in per-cpu tables.  Nothing is done
+ * on uncontended acquisitions, and nothing at all while disabled, as the
+ * tracepoints are static keys.
+ *
+ * The tables are only ever written by their own CPU with interrupts disabled;
+ * reading and resetting them is done from IPIs for the same reason.
+ */
+
+#include <linux/cpu.h>
+#include <linux/fs.h>
+#include <linux/hash.h>
+#include <linux/jhash.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/stacktrace.h>
+#include <linux/vmalloc.h>
+#include <trace/events/lock.h>
+
+#include "trace.h"
+
+#define LC_STACK_DEPTH		6
+/* Skip the probe and the tracepoint iterator */
+#define LC_STACK_SKIP		2
+#define LC_TABLE_BITS		7
+#define LC_TABLE_SIZE		(1 << LC_TABLE_BITS)
+#define LC_TABLE_PROBES		8
+
+struct lc_entry {
+	void		*lock;
+	u32		hash;		/* of the stack */
+	unsigned int	flags;		/* LCB_F_* */
+	u64		count;
+	u64		total_ns;
+	u64		max_ns;
+	unsigned long	stack[LC_STACK_DEPTH];
+};
+
+struct lc_table {
+	struct lc_entry	entries[LC_TABLE_SIZE];
+	unsigned long	dropped;
+};
+
+/* A spinning wait in progress, one per interrupt context level */
+struct lc_spin_wait {
+	void		*lock;
+	u64		start;
+	unsigned int	flags;
+};
+
+struct lc_cpu {
+	struct lc_spin_wait	spin[4];
+	struct lc_table		table;
+};
+
+static struct lc_cpu __percpu *lc_cpus;
+static DEFINE_MUTEX(lc_mutex);
+static bool lc_enabled;
+static bool lc_boot_enabled __initdata;
+/* Waits that began before the profiler got enabled are ignored */
+static u64 lc_enable_time;
+
+static int __init setup_lock_contention(char *str)
+{
+	if (str && !strcmp(str, "on"))
+		lc_boot_enabled = true;
+	return 1;
+}
+__setup("lock_contention=", setup_lock_contention);
+
+/* Spinning waits can nest in interrupts, the others are per task */
+static inline bool lc_spin_only(unsigned int flags)
+{
+	return (flags & LCB_F_SPIN) && !(flags & LCB_F_MUTEX);
+}
+
+static void lc_probe_begin(void *data, void *lock, unsigned int flags)
+{
+	struct lc_spin_wait *wait;
+	u64 now;
+
+	if (in_nmi())
+		return;
+
+	now = local_clock();
+	if (!lc_spin_only(flags)) {
+		/* The mutex slow path begins again after the optimistic spin */
+		if (current->contended_lock == lock)
+			return;
+		current->contended_lock = lock;
+		current->contended_start = now;
+		current->contended_flags = flags;
+		return;
+	}
+
+	wait = this_cpu_ptr(&lc_cpus->spin[interrupt_context_level()]);
+	if (wait->lock == lock)
+		return;
+	wait->lock = lock;
+	wait->start = now;
+	wait->flags = flags;
+}
+
+static void lc_record(struct lc_table *table, void *lock, unsigned int flags,
+		      u64 delta)
+{
+	unsigned long stack[LC_STACK_DEPTH] = { };
+	unsigned int nr, i, idx;
+	u32 hash;
+
+	nr = stack_trace_save(stack, LC_STACK_DEPTH, LC_STACK_SKIP);
+	hash = jhash(stack, nr * sizeof(stack[0]), 0);
+	idx = hash_32(hash ^ hash_ptr(lock, 32), LC_TABLE_BITS);
+
+	for (i = 0; i < LC_TABLE_PROBES; i++) {
+		struct lc_entry *e = &table->entries[(idx + i) & (LC_TABLE_SIZE - 1)];
+
+		if (!e->lock) {
+			e->lock = lock;
+			e->hash = hash;
+			e->flags = flags;
+			memcpy(e->stack, stack, sizeof(stack));
+		} else if (e->lock != lock || e->hash != hash) {
+			continue;
+		}
+
+		e->count++;
+		e->total_ns += delta;
+		if (delta > e->max_ns)
+			e->max_ns = delta;
+		return;
+	}
+
+	table->dropped++;
+}
+
+static void lc_probe_end(void *data, void *lock, int ret)
+{
+	struct lc_spin_wait *wait;
+	unsigned long irqflags;
+	unsigned int flags;
+	u64 start;
+
+	if (in_nmi())
+		return;
+
+	local_irq_save(irqflags);
+	wait = this_cpu_ptr(&lc_cpus->spin[interrupt_context_level()]);
+	if (wait->lock == lock) {
+		wait->lock = NULL;
+		start = wait->start;
+		flags = wait->flags;
+	} else if (in_task() && current->contended_lock == lock) {
+		current->contended_lock = NULL;
+		start = current->contended_start;
+		flags = current->contended_flags;
+	} else {
+		goto out;
+	}
+
+	if (start >= READ_ONCE(lc_enable_time))
+		lc_record(this_cpu_ptr(&lc_cpus->table), lock, flags,
+			  local_clock() - start);
+out:
+	local_irq_restore(irqflags);
+}
+
+static int lc_enable(bool enable)
+{
+	int ret = 0;
+
+	lockdep_assert_held(&lc_mutex);
+
+	if (enable == lc_enabled)
+		return 0;
+
+	if (enable) {
+		WRITE_ONCE(lc_enable_time, local_clock());
+		ret = register_trace_contention_begin(lc_probe_begin, NULL);
+		if (ret)
+			return ret;
+		ret = register_trace_contention_end(lc_probe_end, NULL);
+		if (ret) {
+			unregister_trace_contention_begin(lc_probe_begin, NULL);
+			tracepoint_synchronize_unregister();
+			return ret;
+		}
+	} else {
+		unregister_trace_contention_end(lc_probe_end, NULL);
+		unregister_trace_contention_begin(lc_probe_begin, NULL);
+		tracepoint_synchronize_unregister();
+	}
+
+	lc_enabled = enable;
+	return 0;
+}
+
+static void lc_reset_cpu(void *info)
+{
+	struct lc_table *table = this_cpu_ptr(&lc_cpus->table);
+
+	memset(table, 0, sizeof(*table));
+}
+
+static void lc_copy_cpu(void *info)
+{
+	memcpy(info, this_cpu_ptr(&lc_cpus->table), sizeof(struct lc_table));
+}
+
+static int lc_cmp_key(const void *a, const void *b)
+{
+	const struct lc_entry *x = a, *y = b;
+
+	if (x->lock != y->lock)
+		return x->lock < y->lock ? -1 : 1;
+	if (x->hash != y->hash)
+		return x->hash < y->hash ? -1 : 1;
+	return 0;
+}
+
+/* Merge the tables of all CPUs into @out, return the number of entries */
+static unsigned int lc_collect(struct lc_entry *out, struct lc_table *tmp,
+			       unsigned long *dropped)
+{
+	unsigned int nr = 0, i, j;
+	int cpu;
+
+	*dropped = 0;
+	cpus_read_lock();
+	for_each_possible_cpu(cpu) {
+		if (cpu_online(cpu))
+			smp_call_function_single(cpu, lc_copy_cpu, tmp, 1);
+		else
+			memcpy(tmp, per_cpu_ptr(&lc_cpus->table, cpu),
+			       sizeof(*tmp));
+
+		*dropped += tmp->dropped;
+		for (i = 0; i < LC_TABLE_SIZE; i++) {
+			if (tmp->entries[i].lock)
+				out[nr++] = tmp->entries[i];
+		}
+	}
+	cpus_read_unlock();
+
+	if (!nr)
+		return 0;
+
+	sort(out, nr, sizeof(*out), lc_cmp_key, NULL);
+	for (i = 1, j = 0; i < nr; i++) {
+		if (!lc_cmp_key(&out[i], &out[j])) {
+			out[j].count += out[i].count;
+			out[j].total_ns += out[i].total_ns;
+			out[j].max_ns = max(out[j].max_ns, out[i].max_ns);
+		} else {
+			out[++j] = out[i];
+		}
+	}
+
+	return j + 1;
+}
+
+static int lc_cmp_total(const void *a, const void *b)
+{
+	const struct lc_entry *x = a, *y = b;
+
+	if (x->total_ns > y->total_ns)
+		return -1;
+	return x->total_ns < y->total_ns;
+}
+
+static const char *lc_type(unsigned int flags)
+{
+	if (flags & LCB_F_MUTEX)
+		return "mutex";
+	if (flags & LCB_F_RT)
+		return flags & (LCB_F_READ | LCB_F_WRITE) ? "rwlock:rt" : "rtmutex";
+	if (flags & LCB_F_PERCPU)
+		return flags & LCB_F_WRITE ? "pcpu-sem:write" : "pcpu-sem:read";
+	if (flags & LCB_F_SPIN) {
+		if (flags & LCB_F_READ)
+			return "rwlock:read";
+		if (flags & LCB_F_WRITE)
+			return "rwlock:write";
+		return "spinlock";
+	}
+	if (flags & LCB_F_READ)
+		return "rwsem:read";
+	if (flags & LCB_F_WRITE)
+		return "rwsem:write";
+	return "unknown";
+}
+
+static int lc_show(struct seq_file *m, void *v)
+{
+	struct lc_entry *entries;
+	struct lc_table *tmp;
+	unsigned long dropped;
+	unsigned int nr, i, j;
+
+	entries = vmalloc_array(num_possible_cpus() * LC_TABLE_SIZE,
+				sizeof(*entries));
+	tmp = kmalloc(sizeof(*tmp), GFP_KERNEL);
+	if (!entries || !tmp) {
+		vfree(entries);
+		kfree(tmp);
+		return -ENOMEM;
+	}
+
+	nr = lc_collect(entries, tmp, &dropped);
+	sort(entries, nr, sizeof(*entries), lc_cmp_total, NULL);
+
+	seq_printf(m, "# enabled: %d, dropped: %lu\n", lc_enabled, dropped);
+	seq_puts(m, "# lock type count total_ns max_ns avg_ns\n");
+	for (i = 0; i < nr; i++) {
+		struct lc_entry *e = &entries[i];
+
+		seq_printf(m, "%pS %s %llu %llu %llu %llu\n", e->lock,
+			   lc_type(e->flags), e->count, e->total_ns, e->max_ns,
+			   div64_u64(e->total_ns, e->count));
+		for (j = 0; j < LC_STACK_DEPTH && e->stack[j]; j++)
+			seq_printf(m, "\t%pS\n", (void *)e->stack[j]);
+	}
+
+	kfree(tmp);
+	vfree(entries);
+	return 0;
+}
+
+static int lc_open(struct inode *inode, struct file *file)
+{
+	int ret;
+
+	ret = tracing_check_open_get_tr(NULL);
+	if (ret)
+		return ret;
+
+	/* If this file was opened for write, then erase contents */
+	if ((file->f_mode & FMODE_WRITE) && (file->f_flags & O_TRUNC))
+		on_each_cpu(lc_reset_cpu, NULL, 1);
+
+	if (!(file->f_mode & FMODE_READ))
+		return 0;
+
+	return single_open(file, lc_show, NULL);
+}
+
+static ssize_t lc_write(struct file *file, const char __user *buffer,
+			size_t count, loff_t *ppos)
+{
+	return count;
+}
+
+static int lc_release(struct inode *inode, struct file *file)
+{
+	if (file->f_mode & FMODE_READ)
+		return single_release(inode, file);
+	return 0;
+}
+
+static const struct file_operations lc_fops = {
+	.open		= lc_open,
+	.write		= lc_write,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= lc_release,
+};
+
+static ssize_t lc_enable_read(struct file *filp, char __user *ubuf,
+			      size_t cnt, loff_t *ppos)
+{
+	char buf[4];
+	int r;
+
+	r = scnprintf(buf, sizeof(buf), "%d\n", READ_ONCE(lc_enabled));
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, r);
+}
+
+static ssize_t lc_enable_write(struct file *filp, const char __user *ubuf,
+			       size_t cnt, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(ubuf, cnt, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&lc_mutex);
+	ret = lc_enable(enable);
+	mutex_unlock(&lc_mutex);
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations lc_enable_fops = {
+	.open		= tracing_open_generic,
+	.read		= lc_enable_read,
+	.write		= lc_enable_write,
+	.llseek		= default_llseek,
+};
+
+static __init int init_lock_contention(void)
+{
+	lc_cpus = alloc_percpu(struct lc_cpu);
+	if (!lc_cpus)
+		return -ENOMEM;
+
+	trace_create_file("lock_contention", TRACE_MODE_WRITE, NULL, NULL,
+			  &lc_fops);
+	trace_create_file("lock_contention_enable", TRACE_MODE_WRITE, NULL,
+			  NULL, &lc_enable_fops);
+
+	if (lc_boot_enabled) {
+		mutex_lock(&lc_mutex);
+		if (lc_enable(true))
+			pr_warn("lock_contention: cannot enable the profiler\n");
+		mutex_unlock(&lc_mutex);
+	}
+
+	return 0;
+}
+fs_initcall(init_lock_contention);
@@ -51,6 +51,7 @@
 #include <linux/uaccess.h>
 #include <linux/sched/isolation.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/clock.h>
 #include <linux/nmi.h>
 #include <linux/kvm_para.h>
 #include <linux/delay.h>
@@ -128,14 +129,6 @@ enum wq_internal_consts {
 	WORKER_ID_LEN		= 10 + WQ_NAME_LEN, /* "kworker/R-" + WQ_NAME_LEN */
 };
 
-/*
- * We don't want to trap softirq for too long. See MAX_SOFTIRQ_TIME and
- * MAX_SOFTIRQ_RESTART in kernel/softirq.c. These are macros because
- * msecs_to_jiffies() can't be an initializer.
- */
-#define BH_WORKER_JIFFIES	msecs_to_jiffies(2)
-#define BH_WORKER_RESTARTS	10
-
 /*
  * Structure fields follow one of the following exclusion rules.
  *
@@ -245,6 +238,7 @@ enum pool_workqueue_stats {
 	PWQ_STAT_REPATRIATED,	/* unbound workers brought back into scope */
 	PWQ_STAT_MAYDAY,	/* maydays to rescuer */
 	PWQ_STAT_RESCUED,	/* linked work items executed by rescuer */
+	PWQ_STAT_STOLEN,	/* work items moved to another CPU in the LLC */
 
 	PWQ_NR_STATS,
 };
@@ -363,6 +357,10 @@ struct workqueue_struct {
 #ifdef CONFIG_SYSFS
 	struct wq_device	*wq_dev;	/* I: for sysfs interface */
 #endif
+#ifdef CONFIG_WQ_LATENCY_HIST
+	unsigned long __percpu	*lat_hist;	/* I: only for WQ_SYSFS wqs */
+#endif
+	u64			bh_budget_ns;	/* WO: per work budget of BH wqs */
 #ifdef CONFIG_LOCKDEP
 	char			*lock_name;
 	struct lock_class_key	key;
@@ -423,6 +421,25 @@ static unsigned int wq_cpu_intensive_warning_thresh = 4;
 module_param_named(cpu_intensive_warning_thresh, wq_cpu_intensive_warning_thresh, uint, 0644);
 #endif
 
+/*
+ * Pending work items of WQ_LLC_STEAL workqueues are moved to idle workers of
+ * other CPUs in the same cache pod once their pool made no progress for this
+ * long.  0 disables it.
+ */
+static unsigned long wq_llc_steal_msecs;
+module_param_named(llc_steal_msecs, wq_llc_steal_msecs, ulong, 0644);
+
+/*
+ * We don't want to trap softirq for too long. See MAX_SOFTIRQ_TIME and
+ * MAX_SOFTIRQ_RESTART in kernel/softirq.c. A BH worker stops picking up work
+ * items once it ran for bh_budget_usecs or went through the worklist
+ * bh_budget_restarts times, and leaves the rest to the next softirq round.
+ */
+static unsigned int wq_bh_budget_usecs = 2000;
+module_param_named(bh_budget_usecs, wq_bh_budget_usecs, uint, 0644);
+static unsigned int wq_bh_budget_restarts = 10;
+module_param_named(bh_budget_restarts, wq_bh_budget_restarts, uint, 0644);
+
 /* see the comment above the definition of WQ_POWER_EFFICIENT */
 static bool wq_power_efficient = IS_ENABLED(CONFIG_WQ_POWER_EFFICIENT_DEFAULT);
 module_param_named(power_efficient, wq_power_efficient, bool, 0444);
@@ -482,6 +499,9 @@ static DEFINE_PER_CPU_SHARED_ALIGNED(struct irq_work [NR_STD_WORKER_POOLS],
 static DEFINE_PER_CPU_SHARED_ALIGNED(struct worker_pool [NR_STD_WORKER_POOLS],
 				     bh_worker_pools);
 
+/* end of the budget of the BH work item running on this CPU, 0 if none */
+static DEFINE_PER_CPU(u64, bh_work_deadline);
+
 /* the per-cpu worker pools */
 static DEFINE_PER_CPU_SHARED_ALIGNED(struct worker_pool [NR_STD_WORKER_POOLS],
 				     cpu_worker_pools);
@@ -2257,6 +2277,51 @@ static int wq_select_unbound_cpu(int cpu)
 	return new_cpu;
 }
 
+static void wq_barrier_func(struct work_struct *work);
+
+#ifdef CONFIG_WQ_LATENCY_HIST
+/* log2 buckets of microseconds, the last one takes everything above */
+#define WQ_LAT_BUCKETS		20
+
+static void wq_lat_queued(struct work_struct *work)
+{
+	work->queued_ns = ktime_get_mono_fast_ns();
+}
+
+static void wq_lat_record(struct workqueue_struct *wq, struct work_struct *work)
+{
+	u64 us;
+
+	/* flush barriers aren't stamped, see insert_wq_barrier() */
+	if (!wq->lat_hist || work->func == wq_barrier_func)
+		return;
+
+	us = div_u64(ktime_get_mono_fast_ns() - work->queued_ns, NSEC_PER_USEC);
+	this_cpu_inc(wq->lat_hist[min_t(u64, us ? ilog2(us) + 1 : 0,
+					WQ_LAT_BUCKETS - 1)]);
+}
+
+static int wq_alloc_lat_hist(struct workqueue_struct *wq)
+{
+	if (!(wq->flags & WQ_SYSFS))
+		return 0;
+
+	wq->lat_hist = __alloc_percpu(WQ_LAT_BUCKETS * sizeof(unsigned long),
+				      __alignof__(unsigned long));
+	return wq->lat_hist ? 0 : -ENOMEM;
+}
+
+static void wq_free_lat_hist(struct workqueue_struct *wq)
+{
+	free_percpu(wq->lat_hist);
+}
+#else
+static void wq_lat_queued(struct work_struct *work) { }
+static void wq_lat_record(struct workqueue_struct *wq, struct work_struct *work) { }
+static int wq_alloc_lat_hist(struct workqueue_struct *wq) { return 0; }
+static void wq_free_lat_hist(struct workqueue_struct *wq) { }
+#endif /* CONFIG_WQ_LATENCY_HIST */
+
 static void __queue_work(int cpu, struct workqueue_struct *wq,
 			 struct work_struct *work)
 {
@@ -2344,6 +2409,7 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 	if (WARN_ON(!list_empty(&work->entry)))
 		goto out;
 
+	wq_lat_queued(work);
 	pwq->nr_in_flight[pwq->work_color]++;
 	work_flags = work_color_to_flags(pwq->work_color);
 
@@ -3153,6 +3219,7 @@ __acquires(&pool->lock)
 	unsigned long work_data;
 	int lockdep_start_depth, rcu_start_depth;
 	bool bh_draining = pool->flags & POOL_BH_DRAINING;
+	u64 bh_start = 0;
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -3211,11 +3278,22 @@ __acquires(&pool->lock)
 	 * PENDING and queued state changes happen together while IRQ is
 	 * disabled.
 	 */
+	wq_lat_record(pwq->wq, work);
 	set_work_pool_and_clear_pending(work, pool->id, pool_offq_flags(pool));
 
 	pwq->stats[PWQ_STAT_STARTED]++;
 	raw_spin_unlock_irq(&pool->lock);
 
+	if (pool->flags & POOL_BH) {
+		u64 budget = READ_ONCE(pwq->wq->bh_budget_ns);
+		u64 deadline = worker->bh_deadline;
+
+		bh_start = local_clock();
+		if (budget)
+			deadline = min(deadline, bh_start + budget);
+		__this_cpu_write(bh_work_deadline, deadline);
+	}
+
 	rcu_start_depth = rcu_preempt_depth();
 	lockdep_start_depth = lockdep_depth(current);
 	/* see drain_dead_softirq_workfn() */
@@ -3251,6 +3329,11 @@ __acquires(&pool->lock)
 	 * point will only record its address.
 	 */
 	trace_workqueue_execute_end(work, worker->current_func);
+	if (pool->flags & POOL_BH) {
+		__this_cpu_write(bh_work_deadline, 0);
+		trace_workqueue_bh_execute_end(work, worker->current_func,
+					       local_clock() - bh_start);
+	}
 	pwq->stats[PWQ_STAT_COMPLETED]++;
 	lock_map_release(&lockdep_map);
 	if (!bh_draining)
@@ -3340,6 +3423,109 @@ static void set_pf_worker(bool val)
 	mutex_unlock(&wq_pool_attach_mutex);
 }
 
+/*
+ * Move one pending work item of a WQ_LLC_STEAL workqueue from the worklist of
+ * @victim to the pwq of the same workqueue on @pool.  Both pool locks are
+ * held, so the work item is accounted in flight on one of the two pwqs at any
+ * time and neither flush_work() nor a drain can miss it.  It keeps its
+ * queueing timestamp.
+ */
+static bool move_stealable_work(struct worker_pool *victim,
+				struct worker_pool *pool)
+{
+	struct work_struct *work;
+
+	lockdep_assert_held(&victim->lock);
+	lockdep_assert_held(&pool->lock);
+
+	list_for_each_entry(work, &victim->worklist, entry) {
+		struct pool_workqueue *pwq = get_work_pwq(work);
+		unsigned long work_data = *work_data_bits(work);
+		struct pool_workqueue *dst;
+
+		/*
+		 * Barriers and the work items they are linked to stay, and
+		 * draining only allows chained queueing.  A work item queued
+		 * before the current flush color was started is waited for by
+		 * a flush_workqueue() in progress.  Requeueing would give it
+		 * the current color and the flush would miss it, so it stays.
+		 */
+		if ((pwq->wq->flags & (WQ_LLC_STEAL | __WQ_DRAINING)) != WQ_LLC_STEAL ||
+		    (work_data & WORK_STRUCT_LINKED) ||
+		    work->func == wq_barrier_func ||
+		    get_work_color(work_data) != pwq->work_color)
+			continue;
+
+		/* Same color on the new pwq, and no jumping the max_active queue */
+		dst = rcu_dereference(*per_cpu_ptr(pwq->wq->cpu_pwq, pool->cpu));
+		if (dst->pool != pool || dst->work_color != pwq->work_color ||
+		    !list_empty(&dst->inactive_works) ||
+		    !pwq_tryinc_nr_active(dst, false))
+			continue;
+
+		debug_work_deactivate(work);
+		list_del_init(&work->entry);
+		pwq->stats[PWQ_STAT_STOLEN]++;
+
+		dst->nr_in_flight[dst->work_color]++;
+		if (list_empty(&pool->worklist))
+			pool->watchdog_ts = jiffies;
+		insert_work(dst, work, &pool->worklist,
+			    work_color_to_flags(dst->work_color));
+
+		/* @work points to @dst now, @pwq may go away after this */
+		pwq_dec_nr_in_flight(pwq, work_data);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Called by an idle worker of the per-cpu @pool before going to sleep.  Look
+ * for a pool of the same priority on another CPU of the cache pod which made
+ * no progress for wq_llc_steal_msecs, and queue one of its stealable work
+ * items on this CPU.  Returns %true if a work item was moved.
+ */
+static bool steal_llc_work(struct worker_pool *pool)
+{
+	unsigned long thresh = msecs_to_jiffies(READ_ONCE(wq_llc_steal_msecs));
+	struct wq_pod_type *pt = &wq_pod_types[WQ_AFFN_CACHE];
+	bool moved;
+	int cpu, idx;
+
+	if (!thresh || pool->cpu < 0 || (pool->flags & POOL_DISASSOCIATED) ||
+	    !pt->nr_pods)
+		return false;
+
+	idx = pool - per_cpu(cpu_worker_pools, pool->cpu);
+
+	for_each_cpu(cpu, pt->pod_cpus[pt->cpu_pod[pool->cpu]]) {
+		struct worker_pool *victim = &per_cpu(cpu_worker_pools, cpu)[idx];
+
+		if (cpu == pool->cpu || list_empty(&victim->worklist) ||
+		    time_before(jiffies, READ_ONCE(victim->watchdog_ts) + thresh))
+			continue;
+
+		/* Two pools of the same kind, lock them in address order */
+		rcu_read_lock();
+		if (pool < victim) {
+			raw_spin_lock_irq(&pool->lock);
+			raw_spin_lock_nested(&victim->lock, SINGLE_DEPTH_NESTING);
+		} else {
+			raw_spin_lock_irq(&victim->lock);
+			raw_spin_lock_nested(&pool->lock, SINGLE_DEPTH_NESTING);
+		}
+		moved = !((pool->flags | victim->flags) & POOL_DISASSOCIATED) &&
+			move_stealable_work(victim, pool);
+		raw_spin_unlock(&victim->lock);
+		raw_spin_unlock_irq(&pool->lock);
+		rcu_read_unlock();
+		if (moved)
+			return true;
+	}
+	return false;
+}
+
 /**
  * worker_thread - the worker thread function
  * @__worker: self
@@ -3421,7 +3607,10 @@ static int worker_thread(void *__worker)
 	worker_enter_idle(worker);
 	__set_current_state(TASK_IDLE);
 	raw_spin_unlock_irq(&pool->lock);
-	schedule();
+	if (steal_llc_work(pool))
+		__set_current_state(TASK_RUNNING);
+	else
+		schedule();
 	goto woke_up;
 }
 
@@ -3563,8 +3752,12 @@ static int rescuer_thread(void *__rescuer)
 static void bh_worker(struct worker *worker)
 {
 	struct worker_pool *pool = worker->pool;
-	int nr_restarts = BH_WORKER_RESTARTS;
-	unsigned long end = jiffies + BH_WORKER_JIFFIES;
+	int nr_restarts = max(READ_ONCE(wq_bh_budget_restarts), 1U);
+	u64 start = local_clock();
+	bool pending;
+
+	worker->bh_deadline = start +
+		(u64)READ_ONCE(wq_bh_budget_usecs) * NSEC_PER_USEC;
 
 	raw_spin_lock_irq(&pool->lock);
 	worker_leave_idle(worker);
@@ -3587,14 +3780,42 @@ static void bh_worker(struct worker *worker)
 		if (assign_work(work, worker, NULL))
 			process_scheduled_works(worker);
 	} while (keep_working(pool) &&
-		 --nr_restarts && time_before(jiffies, end));
+		 --nr_restarts && local_clock() < worker->bh_deadline);
 
 	worker_set_flags(worker, WORKER_PREP);
 done:
 	worker_enter_idle(worker);
-	kick_pool(pool);
+	pending = kick_pool(pool);
 	raw_spin_unlock_irq(&pool->lock);
+
+	trace_workqueue_bh_worker(pool->cpu,
+				  pool->attrs->nice == HIGHPRI_NICE_LEVEL,
+				  local_clock() - start, pending);
+}
+
+/**
+ * bh_work_over_budget - test whether the running BH work item should yield
+ *
+ * A BH work item which processes a batch of events, the way NAPI pollers and
+ * tasklets usually do, can call this between events and, once it returns
+ * %true, requeue itself and return instead of hogging the CPU's softirq. The
+ * budget ends when the work item used up the budget set with
+ * workqueue_set_bh_budget() or when the BH worker as a whole used up
+ * workqueue.bh_budget_usecs, whichever comes first.
+ *
+ * CONTEXT:
+ * Softirq.
+ *
+ * Return: %true if the budget is exhausted, %false if there's some left or if
+ * not called from a BH work item.
+ */
+bool bh_work_over_budget(void)
+{
+	u64 deadline = this_cpu_read(bh_work_deadline);
+
+	return deadline && local_clock() >= deadline;
 }
+EXPORT_SYMBOL_GPL(bh_work_over_budget);
 
 /*
  * TODO: Convert all tasklet users to workqueue and use softirq directly.
@@ -4876,6 +5097,7 @@ static void rcu_free_wq(struct rcu_head *rcu)
 		free_node_nr_active(wq->node_nr_active);
 
 	wq_free_lockdep(wq);
+	wq_free_lat_hist(wq);
 	free_percpu(wq->cpu_pwq);
 	free_workqueue_attrs(wq->unbound_attrs);
 	kfree(wq);
@@ -5728,6 +5950,9 @@ struct workqueue_struct *alloc_workqueue(const char *fmt,
 	wq_init_lockdep(wq);
 	INIT_LIST_HEAD(&wq->list);
 
+	if (wq_alloc_lat_hist(wq) < 0)
+		goto err_unreg_lockdep;
+
 	if (flags & WQ_UNBOUND) {
 		if (alloc_node_nr_active(wq->node_nr_active) < 0)
 			goto err_unreg_lockdep;
@@ -5766,6 +5991,7 @@ struct workqueue_struct *alloc_workqueue(const char *fmt,
 	wq_unregister_lockdep(wq);
 	wq_free_lockdep(wq);
 err_free_wq:
+	wq_free_lat_hist(wq);
 	free_workqueue_attrs(wq->unbound_attrs);
 	kfree(wq);
 	return NULL;
@@ -5939,6 +6165,24 @@ void workqueue_set_min_active(struct workqueue_struct *wq, int min_active)
 	mutex_unlock(&wq->mutex);
 }
 
+/**
+ * workqueue_set_bh_budget - limit how long each work item of a BH wq may run
+ * @wq: target BH workqueue
+ * @usecs: budget in microseconds, 0 to only use the BH worker's budget
+ *
+ * Make bh_work_over_budget() return %true for a work item of @wq once it ran
+ * for @usecs. This lets batching work items of a latency sensitive BH
+ * workqueue yield well before the BH worker runs out of its own budget.
+ */
+void workqueue_set_bh_budget(struct workqueue_struct *wq, unsigned int usecs)
+{
+	if (WARN_ON(!(wq->flags & WQ_BH)))
+		return;
+
+	WRITE_ONCE(wq->bh_budget_ns, (u64)usecs * NSEC_PER_USEC);
+}
+EXPORT_SYMBOL_GPL(workqueue_set_bh_budget);
+
 /**
  * current_work - retrieve %current task's work struct
  *
@@ -7031,9 +7275,38 @@ static ssize_t max_active_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(max_active);
 
+#ifdef CONFIG_WQ_LATENCY_HIST
+static ssize_t latency_hist_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int written = 0;
+	int i, cpu;
+
+	for (i = 0; i < WQ_LAT_BUCKETS; i++) {
+		unsigned long sum = 0;
+
+		for_each_possible_cpu(cpu)
+			sum += data_race(per_cpu_ptr(wq->lat_hist, cpu)[i]);
+		/* bucket i holds latencies below 2^i usecs */
+		if (i < WQ_LAT_BUCKETS - 1)
+			written += scnprintf(buf + written, PAGE_SIZE - written,
+					     "<%lu %lu\n", 1UL << i, sum);
+		else
+			written += scnprintf(buf + written, PAGE_SIZE - written,
+					     ">=%lu %lu\n", 1UL << (i - 1), sum);
+	}
+	return written;
+}
+static DEVICE_ATTR_RO(latency_hist);
+#endif
+
 static struct attribute *wq_sysfs_attrs[] = {
 	&dev_attr_per_cpu.attr,
 	&dev_attr_max_active.attr,
+#ifdef CONFIG_WQ_LATENCY_HIST
+	&dev_attr_latency_hist.attr,
+#endif
 	NULL,
 };
 ATTRIBUTE_GROUPS(wq_sysfs);
@@ -45,6 +45,12 @@ static void crc_t10dif_rehash(struct work_struct *work)
 		mutex_unlock(&crc_t10dif_mutex);
 		return;
 	}
+	/* The generic driver is the fallback behind an indirect call */
+	if (!strcmp(crypto_shash_driver_name(new), "crct10dif-generic")) {
+		mutex_unlock(&crc_t10dif_mutex);
+		crypto_free_shash(new);
+		return;
+	}
 	rcu_assign_pointer(crct10dif_tfm, new);
 	mutex_unlock(&crc_t10dif_mutex);
 
@@ -39,6 +39,15 @@ static void crc64_rocksoft_rehash(struct work_struct *work)
 		mutex_unlock(&crc64_rocksoft_mutex);
 		return;
 	}
+	/*
+	 * The generic driver wraps the same table-driven code as the
+	 * fallback, only behind an indirect call, keep calling it directly.
+	 */
+	if (!strcmp(crypto_shash_driver_name(new), "crc64-rocksoft-generic")) {
+		mutex_unlock(&crc64_rocksoft_mutex);
+		crypto_free_shash(new);
+		return;
+	}
 	rcu_assign_pointer(crc64_rocksoft_tfm, new);
 	mutex_unlock(&crc64_rocksoft_mutex);
 
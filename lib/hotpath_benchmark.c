@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Latency benchmark for common kernel hot paths.
+ *
+ * Each test times one operation many times and records the samples in a
+ * shared statistics block (min/avg/max plus a log2 histogram), so results
+ * are comparable across tests and across kernel versions.  The tests run
+ * once at module load and again whenever "1" is written to
+ * <debugfs>/hotpath_benchmark/run; the last results can be read back from
+ * <debugfs>/hotpath_benchmark/results.
+ *
+ * Syscall entry and page fault latency have to be measured from user
+ * space and are not covered here.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/completion.h>
+#include <linux/cpumask.h>
+#include <linux/debugfs.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/smp.h>
+
+#define HPB_HIST_BUCKETS	32
+
+static unsigned int iterations = 10000;
+module_param(iterations, uint, 0644);
+MODULE_PARM_DESC(iterations, "Number of samples taken per test (default 10000)");
+
+struct hpb_stats {
+	u64 min;
+	u64 max;
+	u64 sum;
+	u64 cnt;
+	/* bucket i counts samples in [2^i, 2^(i+1)) ns, bucket 0 also 0 ns */
+	u32 hist[HPB_HIST_BUCKETS];
+};
+
+struct hpb_test {
+	const char *name;
+	int (*run)(struct hpb_stats *stats);
+	struct hpb_stats stats;
+	int err;
+};
+
+static DEFINE_MUTEX(hpb_mutex);
+
+static void hpb_stats_reset(struct hpb_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->min = U64_MAX;
+}
+
+static void hpb_record(struct hpb_stats *stats, u64 ns)
+{
+	unsigned int bucket = ns ? min(ilog2(ns), HPB_HIST_BUCKETS - 1) : 0;
+
+	stats->min = min(stats->min, ns);
+	stats->max = max(stats->max, ns);
+	stats->sum += ns;
+	stats->cnt++;
+	stats->hist[bucket]++;
+}
+
+static int hpb_kmalloc(struct hpb_stats *stats)
+{
+	unsigned int i;
+	u64 start;
+	void *p;
+
+	for (i = 0; i < iterations; i++) {
+		start = ktime_get_ns();
+		p = kmalloc(64, GFP_KERNEL);
+		if (!p)
+			return -ENOMEM;
+		kfree(p);
+		hpb_record(stats, ktime_get_ns() - start);
+		cond_resched();
+	}
+	return 0;
+}
+
+static void hpb_ipi_func(void *info)
+{
+}
+
+static int hpb_ipi(struct hpb_stats *stats)
+{
+	unsigned int i;
+	int cpu, target;
+	u64 start;
+
+	for (i = 0; i < iterations; i++) {
+		cpu = get_cpu();
+		target = cpumask_any_but(cpu_online_mask, cpu);
+		if (target >= nr_cpu_ids) {
+			put_cpu();
+			return -ENODEV;
+		}
+		start = ktime_get_ns();
+		smp_call_function_single(target, hpb_ipi_func, NULL, 1);
+		hpb_record(stats, ktime_get_ns() - start);
+		put_cpu();
+		cond_resched();
+	}
+	return 0;
+}
+
+struct hpb_wakeup {
+	struct completion req;
+	struct completion done;
+	struct hpb_stats *stats;
+	u64 stamp;
+	bool stop;
+};
+
+static int hpb_wakeup_thread(void *data)
+{
+	struct hpb_wakeup *w = data;
+
+	for (;;) {
+		wait_for_completion(&w->req);
+		if (w->stop)
+			break;
+		hpb_record(w->stats, ktime_get_ns() - w->stamp);
+		complete(&w->done);
+	}
+	return 0;
+}
+
+static int hpb_wakeup(struct hpb_stats *stats)
+{
+	struct hpb_wakeup w = { .stats = stats };
+	struct task_struct *tsk;
+	unsigned int i;
+	int cpu;
+
+	init_completion(&w.req);
+	init_completion(&w.done);
+
+	tsk = kthread_create(hpb_wakeup_thread, &w, "hpb_wakeup");
+	if (IS_ERR(tsk))
+		return PTR_ERR(tsk);
+	/* The thread exits on its own, keep it around for kthread_stop(). */
+	get_task_struct(tsk);
+
+	/*
+	 * Measure a cross-cpu wakeup when there is another cpu to use, and
+	 * keep the caller off that cpu for the whole run.
+	 */
+	migrate_disable();
+	cpu = cpumask_any_but(cpu_online_mask, smp_processor_id());
+	if (cpu < nr_cpu_ids)
+		kthread_bind(tsk, cpu);
+	wake_up_process(tsk);
+
+	for (i = 0; i < iterations; i++) {
+		w.stamp = ktime_get_ns();
+		complete(&w.req);
+		wait_for_completion(&w.done);
+		cond_resched();
+	}
+
+	w.stop = true;
+	complete(&w.req);
+	migrate_enable();
+	kthread_stop(tsk);
+	put_task_struct(tsk);
+	return 0;
+}
+
+static struct hpb_test hpb_tests[] = {
+	{ .name = "kmalloc64_free",	.run = hpb_kmalloc },
+	{ .name = "ipi_roundtrip",	.run = hpb_ipi },
+	{ .name = "wakeup",		.run = hpb_wakeup },
+};
+
+static void hpb_run_all(void)
+{
+	struct hpb_test *t;
+	int i;
+
+	mutex_lock(&hpb_mutex);
+	for (i = 0; i < ARRAY_SIZE(hpb_tests); i++) {
+		t = &hpb_tests[i];
+		hpb_stats_reset(&t->stats);
+		t->err = t->run(&t->stats);
+		if (t->err)
+			pr_info("%-16s failed: %d\n", t->name, t->err);
+		else if (t->stats.cnt)
+			pr_info("%-16s min %llu avg %llu max %llu ns\n", t->name,
+				t->stats.min, div64_u64(t->stats.sum,
+							t->stats.cnt),
+				t->stats.max);
+	}
+	mutex_unlock(&hpb_mutex);
+}
+
+static int hpb_results_show(struct seq_file *m, void *v)
+{
+	struct hpb_test *t;
+	int i, b;
+
+	mutex_lock(&hpb_mutex);
+	for (i = 0; i < ARRAY_SIZE(hpb_tests); i++) {
+		t = &hpb_tests[i];
+		if (t->err) {
+			seq_printf(m, "%s: error %d\n", t->name, t->err);
+			continue;
+		}
+		if (!t->stats.cnt)
+			continue;
+		seq_printf(m, "%s: samples %llu min %llu avg %llu max %llu ns\n",
+			   t->name, t->stats.cnt, t->stats.min,
+			   div64_u64(t->stats.sum, t->stats.cnt), t->stats.max);
+		for (b = 0; b < HPB_HIST_BUCKETS; b++) {
+			if (t->stats.hist[b])
+				seq_printf(m, "  >= %10llu ns: %u\n",
+					   b ? 1ULL << b : 0ULL,
+					   t->stats.hist[b]);
+		}
+	}
+	mutex_unlock(&hpb_mutex);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hpb_results);
+
+static ssize_t hpb_run_write(struct file *file, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	bool run;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &run);
+	if (ret)
+		return ret;
+	if (run)
+		hpb_run_all();
+	return count;
+}
+
+static const struct file_operations hpb_run_fops = {
+	.owner	= THIS_MODULE,
+	.write	= hpb_run_write,
+};
+
+static struct dentry *hpb_dir;
+
+static int __init hotpath_benchmark_init(void)
+{
+	hpb_dir = debugfs_create_dir("hotpath_benchmark", NULL);
+	debugfs_create_file("results", 0444, hpb_dir, NULL, &hpb_results_fops);
+	debugfs_create_file("run", 0200, hpb_dir, NULL, &hpb_run_fops);
+
+	hpb_run_all();
+	return 0;
+}
+module_init(hotpath_benchmark_init);
+
+static void __exit hotpath_benchmark_exit(void)
+{
+	debugfs_remove_recursive(hpb_dir);
+}
+module_exit(hotpath_benchmark_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Latency benchmark for common kernel hot paths");
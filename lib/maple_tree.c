@@ -6304,7 +6304,7 @@ void __init maple_tree_init(void)
 {
 	maple_node_cache = kmem_cache_create("maple_node",
 			sizeof(struct maple_node), sizeof(struct maple_node),
-			SLAB_PANIC, NULL);
+			SLAB_PANIC | SLAB_SHEAVES, NULL);
 }
 
 /**
@@ -54,6 +54,7 @@ __param(int, run_test_mask, INT_MAX,
 		"\t\tid: 256,  name: kvfree_rcu_1_arg_vmalloc_test\n"
 		"\t\tid: 512,  name: kvfree_rcu_2_arg_vmalloc_test\n"
 		"\t\tid: 1024, name: vm_map_ram_test\n"
+		"\t\tid: 2048, name: large_node_alloc_test\n"
 		/* Add a new test case description here. */
 );
 
@@ -394,6 +395,35 @@ vm_map_ram_test(void)
 	return nr_allocated != map_nr_pages;
 }
 
+static int
+large_node_alloc_test(void)
+{
+	unsigned long size;
+	int node, i;
+	void *ptr;
+
+	/*
+	 * Node-local allocations of PMD_SIZE or more, which can be mapped
+	 * with huge pages when booted with "hugevmalloc=auto".
+	 */
+	size = max_t(unsigned long, nr_pages, 1) * PAGE_SIZE;
+	size = max_t(unsigned long, size, PMD_SIZE);
+	node = numa_node_id();
+
+	for (i = 0; i < test_loop_count / 1000 + 1; i++) {
+		ptr = vmalloc_node(size, node);
+		if (!ptr)
+			return -1;
+
+		*((__u8 *)ptr) = 0;
+		*((__u8 *)ptr + size - 1) = 0;
+
+		vfree(ptr);
+	}
+
+	return 0;
+}
+
 struct test_case_desc {
 	const char *test_name;
 	int (*test_func)(void);
@@ -411,6 +441,7 @@ static struct test_case_desc test_case_array[] = {
 	{ "kvfree_rcu_1_arg_vmalloc_test", kvfree_rcu_1_arg_vmalloc_test },
 	{ "kvfree_rcu_2_arg_vmalloc_test", kvfree_rcu_2_arg_vmalloc_test },
 	{ "vm_map_ram_test", vm_map_ram_test },
+	{ "large_node_alloc_test", large_node_alloc_test },
 	/* Add a new test case here. */
 };
 
@@ -456,6 +456,25 @@ static ssize_t strict_limit_show(struct device *dev,
 }
 static DEVICE_ATTR_RW(strict_limit);
 
+static ssize_t writeback_workers_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int workers;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &workers);
+	if (ret < 0)
+		return ret;
+
+	if (!workers || workers > BDI_MAX_WB_WORKERS)
+		return -EINVAL;
+
+	WRITE_ONCE(bdi->wb_workers, workers);
+	return count;
+}
+BDI_SHOW(writeback_workers, READ_ONCE(bdi->wb_workers))
+
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
@@ -466,6 +485,7 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_max_bytes.attr,
 	&dev_attr_stable_pages_required.attr,
 	&dev_attr_strict_limit.attr,
+	&dev_attr_writeback_workers.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(bdi_dev);
@@ -528,6 +548,7 @@ static int wb_init(struct bdi_writeback *wb, struct backing_dev_info *bdi,
 	spin_lock_init(&wb->list_lock);
 
 	atomic_set(&wb->writeback_inodes, 0);
+	atomic_set(&wb->bg_helpers, 0);
 	wb->bw_time_stamp = jiffies;
 	wb->balanced_dirty_ratelimit = INIT_BW;
 	wb->dirty_ratelimit = INIT_BW;
@@ -574,6 +595,8 @@ static void wb_shutdown(struct bdi_writeback *wb)
 	mod_delayed_work(bdi_wq, &wb->dwork, 0);
 	flush_delayed_work(&wb->dwork);
 	WARN_ON(!list_empty(&wb->work_list));
+	/* background flush helpers stop once they see !WB_registered */
+	wait_var_event(&wb->bg_helpers, !atomic_read(&wb->bg_helpers));
 	flush_delayed_work(&wb->bw_dwork);
 }
 
@@ -1006,6 +1029,7 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100 * BDI_RATIO_SCALE;
 	bdi->max_prop_frac = FPROP_FRAC_BASE;
+	bdi->wb_workers = 1;
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
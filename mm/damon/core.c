@@ -364,6 +364,7 @@ struct damos *damon_new_scheme(struct damos_access_pattern *pattern,
 	scheme->pattern = *pattern;
 	scheme->action = action;
 	scheme->apply_interval_us = apply_interval_us;
+	scheme->target_nid = NUMA_NO_NODE;
 	/*
 	 * next_apply_sis will be set when kdamond starts.  While kdamond is
 	 * running, it will also updated when it is added to the DAMON context,
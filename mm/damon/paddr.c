@@ -7,6 +7,8 @@
 
 #define pr_fmt(fmt) "damon-pa: " fmt
 
+#include <linux/memory-tiers.h>
+#include <linux/migrate.h>
 #include <linux/mmu_notifier.h>
 #include <linux/page_idle.h>
 #include <linux/pagemap.h>
@@ -325,7 +327,110 @@ static unsigned long damon_pa_deactivate_pages(struct damon_region *r,
 	return damon_pa_mark_accessed_or_deactivate(r, s, false);
 }
 
-static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
+/* Find the nearest top tier node for the pages of @nid to be promoted to */
+static int damon_pa_promotion_node(int nid)
+{
+	int n, target = NUMA_NO_NODE, min_dist = INT_MAX;
+
+	if (node_is_toptier(nid))
+		return NUMA_NO_NODE;
+
+	for_each_node_state(n, N_MEMORY) {
+		if (!node_is_toptier(n))
+			continue;
+		if (node_distance(nid, n) < min_dist) {
+			min_dist = node_distance(nid, n);
+			target = n;
+		}
+	}
+	return target;
+}
+
+static int damon_pa_migrate_target(struct damos *s, int nid)
+{
+	if (s->target_nid != NUMA_NO_NODE) {
+		/* the node may have been offlined since it was set */
+		if (s->target_nid == nid || !node_state(s->target_nid, N_MEMORY))
+			return NUMA_NO_NODE;
+		return s->target_nid;
+	}
+	if (s->action == DAMOS_MIGRATE_HOT)
+		return damon_pa_promotion_node(nid);
+	return next_demotion_node(nid);
+}
+
+static unsigned long damon_pa_migrate_pages(struct list_head *folio_list,
+		int src_nid, int target_nid)
+{
+	struct migration_target_control mtc = {
+		/*
+		 * Fail the allocation instead of reclaiming or falling back to
+		 * another node.  The migration is only an optimization.
+		 */
+		.gfp_mask = (GFP_HIGHUSER_MOVABLE & ~__GFP_RECLAIM) |
+			__GFP_THISNODE | __GFP_NOWARN | __GFP_NOMEMALLOC |
+			GFP_NOWAIT,
+		.nid = target_nid,
+		.reason = MR_DAMON,
+	};
+	unsigned int nr_succeeded = 0;
+
+	if (list_empty(folio_list))
+		return 0;
+
+	migrate_pages(folio_list, alloc_migration_target, NULL,
+			(unsigned long)&mtc, MIGRATE_ASYNC, MR_DAMON,
+			&nr_succeeded);
+	putback_movable_pages(folio_list);
+#ifdef CONFIG_NUMA_BALANCING
+	if (node_is_toptier(target_nid) && !node_is_toptier(src_nid))
+		mod_node_page_state(NODE_DATA(target_nid), PGPROMOTE_SUCCESS,
+				    nr_succeeded);
+#endif
+	return nr_succeeded;
+}
+
+/*
+ * Migrate the folios of @r to the node that damon_pa_migrate_target() decides
+ * for the node of the first folio.  Folios of other nodes are left alone, as
+ * a region usually doesn't span nodes.
+ */
+static unsigned long damon_pa_migrate(struct damon_region *r, struct damos *s)
+{
+	unsigned long addr, applied;
+	int nid = NUMA_NO_NODE, target_nid = NUMA_NO_NODE;
+	LIST_HEAD(folio_list);
+
+	for (addr = r->ar.start; addr < r->ar.end; addr += PAGE_SIZE) {
+		struct folio *folio = damon_get_folio(PHYS_PFN(addr));
+
+		if (!folio)
+			continue;
+
+		if (nid == NUMA_NO_NODE) {
+			nid = folio_nid(folio);
+			target_nid = damon_pa_migrate_target(s, nid);
+		}
+		if (target_nid == NUMA_NO_NODE || folio_nid(folio) != nid)
+			goto put_folio;
+
+		if (damos_pa_filter_out(s, folio))
+			goto put_folio;
+
+		if (!folio_isolate_lru(folio))
+			goto put_folio;
+		node_stat_mod_folio(folio, NR_ISOLATED_ANON +
+				folio_is_file_lru(folio), folio_nr_pages(folio));
+		list_add(&folio->lru, &folio_list);
+put_folio:
+		folio_put(folio);
+	}
+	applied = damon_pa_migrate_pages(&folio_list, nid, target_nid);
+	cond_resched();
+	return applied * PAGE_SIZE;
+}
+
+unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		struct damon_target *t, struct damon_region *r,
 		struct damos *scheme)
 {
@@ -336,6 +441,9 @@ static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		return damon_pa_mark_accessed(r, scheme);
 	case DAMOS_LRU_DEPRIO:
 		return damon_pa_deactivate_pages(r, scheme);
+	case DAMOS_MIGRATE_HOT:
+	case DAMOS_MIGRATE_COLD:
+		return damon_pa_migrate(r, scheme);
 	case DAMOS_STAT:
 		break;
 	default:
@@ -345,7 +453,7 @@ static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 	return 0;
 }
 
-static int damon_pa_scheme_score(struct damon_ctx *context,
+int damon_pa_scheme_score(struct damon_ctx *context,
 		struct damon_target *t, struct damon_region *r,
 		struct damos *scheme)
 {
@@ -356,6 +464,10 @@ static int damon_pa_scheme_score(struct damon_ctx *context,
 		return damon_hot_score(context, r, scheme);
 	case DAMOS_LRU_DEPRIO:
 		return damon_cold_score(context, r, scheme);
+	case DAMOS_MIGRATE_HOT:
+		return damon_hot_score(context, r, scheme);
+	case DAMOS_MIGRATE_COLD:
+		return damon_cold_score(context, r, scheme);
 	default:
 		break;
 	}
@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON-based Hot Page Promotion Between Memory Tiers
+ *
+ * Instead of NUMA hinting faults, this finds hot memory on lower tier nodes
+ * with DAMON, preferably from hardware access samples, and promotes it to the
+ * nearest top tier node in batches, under a per node rate limit.
+ */
+
+#define pr_fmt(fmt) "damon-promote: " fmt
+
+#include <linux/damon.h>
+#include <linux/kstrtox.h>
+#include <linux/memory-tiers.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+
+#include "modules-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_promote."
+
+/*
+ * Enable or disable DAMON_PROMOTE.
+ *
+ * You can enable DAMON_PROMOTE by setting the value of this parameter as
+ * ``Y``.  Setting it as ``N`` disables DAMON_PROMOTE.  The memory tiers are
+ * read when it is enabled, and when the inputs are committed.
+ */
+static bool enabled __read_mostly;
+
+/*
+ * Make DAMON_PROMOTE reads the input parameters again, except ``enabled`` and
+ * ``hw_samples``.
+ *
+ * Input parameters that updated while DAMON_PROMOTE is running are not applied
+ * by default.  Once this parameter is set as ``Y``, DAMON_PROMOTE reads values
+ * of parametrs except ``enabled`` again.  Once the re-reading is done, this
+ * parameter is set as ``N``.  If invalid parameters are found while the
+ * re-reading, DAMON_PROMOTE will be disabled.
+ */
+static bool commit_inputs __read_mostly;
+module_param(commit_inputs, bool, 0600);
+
+/*
+ * Use hardware access samples for the monitoring.
+ *
+ * If this is ``Y``, DAMON_PROMOTE monitors the accesses with the 'psample'
+ * operations set, which only needs the PMU sampling to be configured via the
+ * ``damon_psample.`` parameters and doesn't touch the page tables.  Else, the
+ * Accessed bits are checked with the 'paddr' operations set.  Applied when
+ * DAMON_PROMOTE is enabled.  ``Y`` by default.
+ */
+static bool hw_samples __read_mostly = true;
+module_param(hw_samples, bool, 0600);
+
+/*
+ * Access frequency threshold for hot memory regions identification in permil.
+ *
+ * If a memory region on a lower tier node is accessed in frequency of this or
+ * higher, DAMON_PROMOTE identifies the region as hot, and promotes it.  20% by
+ * default.
+ */
+static unsigned long hot_thres_access_freq = 200;
+module_param(hot_thres_access_freq, ulong, 0600);
+
+/*
+ * Minimum age of hot memory regions in microseconds.
+ *
+ * Regions need to keep being hot for this long before being promoted, so that
+ * short access bursts don't cause migrations. One second by default.
+ */
+static unsigned long hot_min_age __read_mostly = 1000000;
+module_param(hot_min_age, ulong, 0600);
+
+static struct damos_quota damon_promote_quota = {
+	/* Use up to 10 ms per 1 sec, by default */
+	.ms = 10,
+	/* Promote up to 256 MiB per 1 sec from each node, by default */
+	.sz = 256 * 1024 * 1024,
+	.reset_interval = 1000,
+	/* Within the quota, promote hotter regions first. */
+	.weight_sz = 0,
+	.weight_nr_accesses = 1,
+	.weight_age = 0,
+};
+DEFINE_DAMON_MODULES_DAMOS_QUOTAS(damon_promote_quota);
+
+static struct damon_attrs damon_promote_mon_attrs = {
+	.sample_interval = 5000,	/* 5 ms */
+	.aggr_interval = 100000,	/* 100 ms */
+	.ops_update_interval = 0,
+	.min_nr_regions = 10,
+	.max_nr_regions = 1000,
+};
+DEFINE_DAMON_MODULES_MON_ATTRS_PARAMS(damon_promote_mon_attrs);
+
+/*
+ * PID of the DAMON thread
+ *
+ * If DAMON_PROMOTE is enabled, this becomes the PID of the worker thread.
+ * Else, -1.
+ */
+static int kdamond_pid __read_mostly = -1;
+module_param(kdamond_pid, int, 0400);
+
+/* Sum of the stats of the schemes for all lower tier nodes */
+static struct damos_stat damon_promote_stat;
+DEFINE_DAMON_MODULES_DAMOS_STATS_PARAMS(damon_promote_stat,
+		promote_tried_regions, promoted_regions, quota_exceeds);
+
+static struct damos_watermarks damon_promote_wmarks = {
+	.metric = DAMOS_WMARK_NONE,
+};
+
+static struct damon_ctx *ctx;
+static struct damon_target *target;
+
+/* Create a scheme promoting the hot regions of @nid, under its own quota */
+static struct damos *damon_promote_new_scheme(int nid, unsigned int hot_thres,
+		unsigned int min_age)
+{
+	struct damos_access_pattern pattern = {
+		.min_sz_region = PAGE_SIZE,
+		.max_sz_region = ULONG_MAX,
+		.min_nr_accesses = hot_thres,
+		.max_nr_accesses = UINT_MAX,
+		.min_age_region = min_age,
+		.max_age_region = UINT_MAX,
+	};
+	struct damos_filter *filter;
+	struct damos *scheme;
+
+	scheme = damon_new_scheme(&pattern, DAMOS_MIGRATE_HOT, 0,
+			&damon_promote_quota, &damon_promote_wmarks);
+	if (!scheme)
+		return NULL;
+
+	/* Filter out anything that is not on @nid */
+	filter = damos_new_filter(DAMOS_FILTER_TYPE_ADDR, false);
+	if (!filter) {
+		damon_destroy_scheme(scheme);
+		return NULL;
+	}
+	filter->addr_range.start = PFN_PHYS(node_start_pfn(nid));
+	filter->addr_range.end = PFN_PHYS(node_end_pfn(nid));
+	damos_add_filter(scheme, filter);
+
+	return scheme;
+}
+
+static int damon_promote_apply_parameters(void)
+{
+	struct damon_addr_range *ranges;
+	struct damos **schemes;
+	unsigned int hot_thres, min_age;
+	int nid, nr = 0, i, err;
+
+	err = damon_set_attrs(ctx, &damon_promote_mon_attrs);
+	if (err)
+		return err;
+
+	ranges = kcalloc(nr_node_ids, sizeof(*ranges), GFP_KERNEL);
+	schemes = kcalloc(nr_node_ids, sizeof(*schemes), GFP_KERNEL);
+	if (!ranges || !schemes) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	hot_thres = damon_max_nr_accesses(&damon_promote_mon_attrs) *
+		hot_thres_access_freq / 1000;
+	min_age = hot_min_age / damon_promote_mon_attrs.aggr_interval;
+
+	for_each_node_state(nid, N_MEMORY) {
+		if (node_is_toptier(nid) || !node_spanned_pages(nid))
+			continue;
+
+		schemes[nr] = damon_promote_new_scheme(nid, hot_thres, min_age);
+		if (!schemes[nr]) {
+			err = -ENOMEM;
+			goto free_schemes;
+		}
+		ranges[nr].start = PFN_PHYS(node_start_pfn(nid));
+		ranges[nr].end = PFN_PHYS(node_end_pfn(nid));
+		nr++;
+	}
+
+	if (!nr) {
+		pr_warn("no lower tier node to promote from\n");
+		err = -EINVAL;
+		goto out;
+	}
+
+	/* Node spans are in ascending order, as damon_set_regions() wants */
+	err = damon_set_regions(target, ranges, nr);
+	if (err)
+		goto free_schemes;
+	damon_set_schemes(ctx, schemes, nr);
+	goto out;
+
+free_schemes:
+	for (i = 0; i < nr; i++)
+		damon_destroy_scheme(schemes[i]);
+out:
+	kfree(schemes);
+	kfree(ranges);
+	return err;
+}
+
+static int damon_promote_turn(bool on)
+{
+	int err;
+
+	if (!on) {
+		err = damon_stop(&ctx, 1);
+		if (!err)
+			kdamond_pid = -1;
+		return err;
+	}
+
+	err = damon_select_ops(ctx, hw_samples ? DAMON_OPS_PSAMPLE :
+			DAMON_OPS_PADDR);
+	if (err)
+		return err;
+
+	err = damon_promote_apply_parameters();
+	if (err)
+		return err;
+
+	err = damon_start(&ctx, 1, true);
+	if (err)
+		return err;
+	kdamond_pid = ctx->kdamond->pid;
+	return 0;
+}
+
+static int damon_promote_enabled_store(const char *val,
+		const struct kernel_param *kp)
+{
+	bool is_enabled = enabled;
+	bool enable;
+	int err;
+
+	err = kstrtobool(val, &enable);
+	if (err)
+		return err;
+
+	if (is_enabled == enable)
+		return 0;
+
+	/* Called before init function.  The function will handle this. */
+	if (!ctx)
+		goto set_param_out;
+
+	err = damon_promote_turn(enable);
+	if (err)
+		return err;
+
+set_param_out:
+	enabled = enable;
+	return err;
+}
+
+static const struct kernel_param_ops enabled_param_ops = {
+	.set = damon_promote_enabled_store,
+	.get = param_get_bool,
+};
+
+module_param_cb(enabled, &enabled_param_ops, &enabled, 0600);
+MODULE_PARM_DESC(enabled,
+	"Enable or disable DAMON_PROMOTE (default: disabled)");
+
+static int damon_promote_handle_commit_inputs(void)
+{
+	int err;
+
+	if (!commit_inputs)
+		return 0;
+
+	err = damon_promote_apply_parameters();
+	commit_inputs = false;
+	return err;
+}
+
+static int damon_promote_after_aggregation(struct damon_ctx *c)
+{
+	struct damos_stat stat = {};
+	struct damos *s;
+
+	/* update the stats parameter */
+	damon_for_each_scheme(s, c) {
+		stat.nr_tried += s->stat.nr_tried;
+		stat.sz_tried += s->stat.sz_tried;
+		stat.nr_applied += s->stat.nr_applied;
+		stat.sz_applied += s->stat.sz_applied;
+		stat.qt_exceeds += s->stat.qt_exceeds;
+	}
+	damon_promote_stat = stat;
+
+	return damon_promote_handle_commit_inputs();
+}
+
+static int __init damon_promote_init(void)
+{
+	int err = damon_modules_new_paddr_ctx_target(&ctx, &target);
+
+	if (err)
+		return err;
+
+	ctx->callback.after_aggregation = damon_promote_after_aggregation;
+
+	/* 'enabled' has set before this function, probably via command line */
+	if (enabled)
+		err = damon_promote_turn(true);
+
+	return err;
+}
+
+module_init(damon_promote_init);
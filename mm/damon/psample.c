@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON Primitives for The Physical Address Space, Using Hardware Samples
+ *
+ * Instead of clearing and checking the Accessed bits of a sampling address in
+ * each region, this operations set relies on the data addresses of memory
+ * access samples that the PMU hands out via perf, such as Intel PEBS, AMD IBS
+ * or Arm SPE.  A region is counted as accessed in a sampling interval if any
+ * sample hit it.
+ */
+
+#define pr_fmt(fmt) "damon-psample: " fmt
+
+#include <linux/cpu.h>
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
+#include <linux/perf_event.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+
+#include "ops-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_psample."
+
+/*
+ * The PMU event to sample with, described like for perf_event_open().  Which
+ * events report data addresses is hardware specific.  For example, the
+ * 'mem-loads' event of Intel PEBS, or the 'type' of the 'ibs_op' or
+ * 'arm_spe_0' PMU found in /sys/bus/event_source/devices/.
+ */
+static unsigned int event_type __read_mostly = PERF_TYPE_RAW;
+module_param(event_type, uint, 0600);
+
+static unsigned long event_config __read_mostly;
+module_param(event_config, ulong, 0600);
+
+static unsigned long event_config1 __read_mostly;
+module_param(event_config1, ulong, 0600);
+
+static unsigned int event_precise_ip __read_mostly;
+module_param(event_precise_ip, uint, 0600);
+
+/* Take a sample every this many events, per CPU */
+static unsigned long sample_period __read_mostly = 10007;
+module_param(sample_period, ulong, 0600);
+
+/* Samples buffered per CPU between two access checks; the rest are dropped */
+#define DAMON_PSAMPLE_CPU_SAMPLES	512
+
+struct damon_psample_cpu {
+	struct perf_event *event;
+	unsigned int nr;
+	u64 *addrs;
+};
+
+static struct damon_psample_cpu __percpu *damon_psample_cpus;
+
+/* Scratch buffer for the samples of all CPUs, sorted by address */
+static u64 *damon_psample_addrs;
+static unsigned int damon_psample_max_addrs;
+
+/* Only one context at a time can own the PMU events */
+static struct damon_ctx *damon_psample_owner;
+static DEFINE_MUTEX(damon_psample_lock);
+
+/*
+ * Called from NMI context.  Only ever appends to this CPU's buffer; the
+ * cmpxchg() lets damon_psample_drain() reset the buffer concurrently, in which
+ * case this sample is lost.
+ */
+static void damon_psample_overflow(struct perf_event *event,
+		struct perf_sample_data *data, struct pt_regs *regs)
+{
+	struct damon_psample_cpu *pcpu = this_cpu_ptr(damon_psample_cpus);
+	unsigned int nr = READ_ONCE(pcpu->nr);
+
+	if (nr >= DAMON_PSAMPLE_CPU_SAMPLES)
+		return;
+
+	perf_prepare_sample(data, event, regs);
+	if (!(data->sample_flags & PERF_SAMPLE_PHYS_ADDR) || !data->phys_addr)
+		return;
+
+	pcpu->addrs[nr] = data->phys_addr;
+	cmpxchg(&pcpu->nr, nr, nr + 1);
+}
+
+static unsigned int damon_psample_drain(void)
+{
+	unsigned int total = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct damon_psample_cpu *pcpu = per_cpu_ptr(damon_psample_cpus,
+				cpu);
+		unsigned int nr;
+
+		if (!pcpu->event)
+			continue;
+		/* The scratch buffer has room for a full buffer of each CPU */
+		do {
+			nr = smp_load_acquire(&pcpu->nr);
+			memcpy(damon_psample_addrs + total, pcpu->addrs,
+					nr * sizeof(*pcpu->addrs));
+		} while (cmpxchg(&pcpu->nr, nr, 0) != nr);
+		total += nr;
+	}
+	return total;
+}
+
+static int damon_psample_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	if (x < y)
+		return -1;
+	return x > y;
+}
+
+static void damon_psample_release_events(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct damon_psample_cpu *pcpu = per_cpu_ptr(damon_psample_cpus,
+				cpu);
+
+		if (pcpu->event) {
+			perf_event_release_kernel(pcpu->event);
+			pcpu->event = NULL;
+		}
+		kfree(pcpu->addrs);
+		pcpu->addrs = NULL;
+		pcpu->nr = 0;
+	}
+}
+
+/*
+ * CPUs that come online while the monitoring is running don't contribute
+ * samples until the next start.
+ */
+static void damon_psample_init(struct damon_ctx *ctx)
+{
+	struct perf_event_attr attr = {
+		.type = event_type,
+		.size = sizeof(attr),
+		.config = event_config,
+		.config1 = event_config1,
+		.sample_period = sample_period,
+		.sample_type = PERF_SAMPLE_ADDR | PERF_SAMPLE_PHYS_ADDR,
+		.precise_ip = event_precise_ip,
+	};
+	int cpu, nr_events = 0;
+
+	mutex_lock(&damon_psample_lock);
+	if (damon_psample_owner) {
+		pr_warn("already in use by another context\n");
+		goto out;
+	}
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		struct damon_psample_cpu *pcpu = per_cpu_ptr(damon_psample_cpus,
+				cpu);
+		struct perf_event *event;
+
+		pcpu->addrs = kmalloc_array_node(DAMON_PSAMPLE_CPU_SAMPLES,
+				sizeof(*pcpu->addrs), GFP_KERNEL,
+				cpu_to_node(cpu));
+		if (!pcpu->addrs)
+			continue;
+		event = perf_event_create_kernel_counter(&attr, cpu, NULL,
+				damon_psample_overflow, NULL);
+		if (IS_ERR(event)) {
+			pr_warn_once("cannot create event on cpu %d (%ld)\n",
+					cpu, PTR_ERR(event));
+			kfree(pcpu->addrs);
+			pcpu->addrs = NULL;
+			continue;
+		}
+		pcpu->event = event;
+		nr_events++;
+	}
+	cpus_read_unlock();
+
+	if (!nr_events)
+		goto out;
+
+	damon_psample_max_addrs = nr_events * DAMON_PSAMPLE_CPU_SAMPLES;
+	damon_psample_addrs = kvmalloc_array(damon_psample_max_addrs,
+			sizeof(*damon_psample_addrs), GFP_KERNEL);
+	if (!damon_psample_addrs) {
+		damon_psample_release_events();
+		goto out;
+	}
+	damon_psample_owner = ctx;
+out:
+	mutex_unlock(&damon_psample_lock);
+}
+
+/*
+ * Called when kdamond finishes, and from damon_destroy_targets(), which leaves
+ * freeing the targets to the operations set when it has a cleanup callback.
+ */
+static void damon_psample_cleanup(struct damon_ctx *ctx)
+{
+	struct damon_target *t, *next;
+
+	mutex_lock(&damon_psample_lock);
+	if (damon_psample_owner == ctx) {
+		damon_psample_release_events();
+		kvfree(damon_psample_addrs);
+		damon_psample_addrs = NULL;
+		damon_psample_owner = NULL;
+	}
+	mutex_unlock(&damon_psample_lock);
+
+	if (ctx->kdamond == current)
+		return;
+	damon_for_each_target_safe(t, next, ctx)
+		damon_destroy_target(t);
+}
+
+static unsigned int damon_psample_check_accesses(struct damon_ctx *ctx)
+{
+	struct damon_target *t;
+	struct damon_region *r;
+	unsigned int max_nr_accesses = 0;
+	unsigned int nr = 0, i = 0;
+
+	if (damon_psample_owner == ctx) {
+		nr = damon_psample_drain();
+		sort(damon_psample_addrs, nr, sizeof(*damon_psample_addrs),
+				damon_psample_cmp, NULL);
+	}
+
+	/* Regions are sorted by address, so walk them along the samples */
+	damon_for_each_target(t, ctx) {
+		i = 0;
+		damon_for_each_region(r, t) {
+			bool accessed;
+
+			while (i < nr && damon_psample_addrs[i] < r->ar.start)
+				i++;
+			accessed = i < nr && damon_psample_addrs[i] < r->ar.end;
+			damon_update_region_access_rate(r, accessed, &ctx->attrs);
+			max_nr_accesses = max(r->nr_accesses, max_nr_accesses);
+		}
+	}
+
+	return max_nr_accesses;
+}
+
+static int __init damon_psample_initcall(void)
+{
+	struct damon_operations ops = {
+		.id = DAMON_OPS_PSAMPLE,
+		.init = damon_psample_init,
+		.update = NULL,
+		.prepare_access_checks = NULL,
+		.check_accesses = damon_psample_check_accesses,
+		.reset_aggregated = NULL,
+		.target_valid = NULL,
+		.cleanup = damon_psample_cleanup,
+		.apply_scheme = damon_pa_apply_scheme,
+		.get_scheme_score = damon_pa_scheme_score,
+	};
+
+	damon_psample_cpus = alloc_percpu(struct damon_psample_cpu);
+	if (!damon_psample_cpus)
+		return -ENOMEM;
+
+	return damon_register_ops(&ops);
+};
+
+subsys_initcall(damon_psample_initcall);
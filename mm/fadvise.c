@@ -56,6 +56,7 @@ int generic_fadvise(struct file *file, loff_t offset, loff_t len, int advice)
 		case POSIX_FADV_WILLNEED:
 		case POSIX_FADV_NOREUSE:
 		case POSIX_FADV_DONTNEED:
+		case POSIX_FADV_HUGEPAGE:
 			/* no bad return value, but ignore advice */
 			break;
 		default:
@@ -78,6 +79,7 @@ int generic_fadvise(struct file *file, loff_t offset, loff_t len, int advice)
 	switch (advice) {
 	case POSIX_FADV_NORMAL:
 		file->f_ra.ra_pages = bdi->ra_pages;
+		WRITE_ONCE(file->f_ra.min_order, 0);
 		spin_lock(&file->f_lock);
 		file->f_mode &= ~(FMODE_RANDOM | FMODE_NOREUSE);
 		spin_unlock(&file->f_lock);
@@ -93,6 +95,18 @@ int generic_fadvise(struct file *file, loff_t offset, loff_t len, int advice)
 		file->f_mode &= ~FMODE_RANDOM;
 		spin_unlock(&file->f_lock);
 		break;
+	case POSIX_FADV_HUGEPAGE:
+		/*
+		 * Readahead windows get widened and aligned so that they can be
+		 * filled with folios of this order. Silently ignored where the
+		 * mapping cannot hold large folios.
+		 */
+		if (mapping_large_folio_support(mapping))
+			WRITE_ONCE(file->f_ra.min_order, MAX_PAGECACHE_ORDER);
+		spin_lock(&file->f_lock);
+		file->f_mode &= ~FMODE_RANDOM;
+		spin_unlock(&file->f_lock);
+		break;
 	case POSIX_FADV_WILLNEED:
 		/* First and last PARTIAL page! */
 		start_index = offset >> PAGE_SHIFT;
@@ -2825,6 +2825,13 @@ size_t splice_folio_into_pipe(struct pipe_inode_info *pipe,
 		struct pipe_buffer *buf = pipe_head_buf(pipe);
 		size_t part = min_t(size_t, PAGE_SIZE - offset, size - spliced);
 
+		/*
+		 * Without highmem the rest of the folio is directly mapped
+		 * and contiguous, so a single buffer can cover all of it.
+		 */
+		if (!IS_ENABLED(CONFIG_HIGHMEM))
+			part = size - spliced;
+
 		*buf = (struct pipe_buffer) {
 			.ops	= &page_cache_pipe_buf_ops,
 			.page	= page,
@@ -2877,10 +2884,18 @@ ssize_t filemap_splice_read(struct file *in, loff_t *ppos,
 	init_sync_kiocb(&iocb, in);
 	iocb.ki_pos = *ppos;
 
-	/* Work out how much data we can actually add into the pipe */
+	/*
+	 * Work out how much data we can actually add into the pipe.  Each
+	 * buffer can take up to a whole folio unless they are mapped a page
+	 * at a time.
+	 */
 	used = pipe_occupancy(pipe->head, pipe->tail);
 	npages = max_t(ssize_t, pipe->max_usage - used, 0);
-	len = min_t(size_t, len, npages * PAGE_SIZE);
+	if (IS_ENABLED(CONFIG_HIGHMEM))
+		len = min_t(size_t, len, npages * PAGE_SIZE);
+	else
+		len = min_t(size_t, len,
+			    npages * mapping_max_folio_size(in->f_mapping));
 
 	folio_batch_init(&fbatch);
 
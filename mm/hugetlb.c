@@ -3756,6 +3756,114 @@ static int adjust_pool_surplus(struct hstate *h, nodemask_t *nodes_allowed,
 }
 
 #define persistent_huge_pages(h) (h->nr_huge_pages - h->surplus_huge_pages)
+/*
+ * Growing the pool by a lot at runtime is dominated by clearing and
+ * allocating the pages.  Like hugetlb_pages_alloc_boot(), spread the work over
+ * a couple of workers per allowed node, each allocating on its own node and
+ * adding its share to the pool with a single vmemmap optimization batch.
+ */
+#define HUGETLB_RESIZE_WORKERS_PER_NODE	2
+#define HUGETLB_RESIZE_MIN_PARALLEL	64
+
+struct hugetlb_resize_job {
+	struct hstate *h;
+	nodemask_t *nodes_allowed;
+	nodemask_t *node_alloc_noretry;
+	atomic_long_t allocated;
+	atomic_t pending;
+	bool stop;
+	struct completion done;
+};
+
+struct hugetlb_resize_work {
+	struct work_struct work;
+	struct hugetlb_resize_job *job;
+	unsigned long nr;
+	int nid;
+};
+
+static void hugetlb_resize_workfn(struct work_struct *work)
+{
+	struct hugetlb_resize_work *rw = container_of(work,
+					struct hugetlb_resize_work, work);
+	struct hugetlb_resize_job *job = rw->job;
+	gfp_t gfp_mask = htlb_alloc_mask(job->h) | __GFP_THISNODE;
+	unsigned long i;
+	LIST_HEAD(folio_list);
+
+	for (i = 0; i < rw->nr && !READ_ONCE(job->stop); i++) {
+		struct folio *folio;
+
+		folio = only_alloc_fresh_hugetlb_folio(job->h, gfp_mask, rw->nid,
+					job->nodes_allowed, job->node_alloc_noretry);
+		if (!folio)
+			break;
+
+		list_add(&folio->lru, &folio_list);
+		cond_resched();
+	}
+
+	if (i) {
+		prep_and_add_allocated_folios(job->h, &folio_list);
+		atomic_long_add(i, &job->allocated);
+	}
+
+	if (atomic_dec_and_test(&job->pending))
+		complete(&job->done);
+}
+
+/*
+ * Try to add @count fresh pages to the pool, interleaved over @nodes_allowed.
+ * Returns the number of pages added, which may be short if a node ran out of
+ * memory; the caller tops up the difference the usual way.
+ */
+static unsigned long alloc_pool_huge_folios_parallel(struct hstate *h,
+		unsigned long count, nodemask_t *nodes_allowed,
+		nodemask_t *node_alloc_noretry)
+{
+	struct hugetlb_resize_job job = {
+		.h			= h,
+		.nodes_allowed		= nodes_allowed,
+		.node_alloc_noretry	= node_alloc_noretry,
+		.allocated		= ATOMIC_LONG_INIT(0),
+	};
+	struct hugetlb_resize_work *works;
+	int nr_works, i, node;
+
+	nr_works = nodes_weight(*nodes_allowed) * HUGETLB_RESIZE_WORKERS_PER_NODE;
+	if (!nr_works)
+		return 0;
+	works = kcalloc(nr_works, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return 0;
+
+	init_completion(&job.done);
+	atomic_set(&job.pending, nr_works);
+
+	i = 0;
+	for_each_node_mask(node, *nodes_allowed) {
+		int j;
+
+		for (j = 0; j < HUGETLB_RESIZE_WORKERS_PER_NODE; j++, i++) {
+			works[i].job = &job;
+			works[i].nid = node;
+			works[i].nr = count / nr_works + (i < count % nr_works);
+			INIT_WORK(&works[i].work, hugetlb_resize_workfn);
+		}
+	}
+	for (i = 0; i < nr_works; i++)
+		queue_work_node(works[i].nid, system_unbound_wq, &works[i].work);
+
+	/* Bail for signals, but wait for the pages already being allocated */
+	if (wait_for_completion_interruptible(&job.done)) {
+		WRITE_ONCE(job.stop, true);
+		wait_for_completion(&job.done);
+	}
+
+	kfree(works);
+	return atomic_long_read(&job.allocated);
+}
+
 static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 			      nodemask_t *nodes_allowed)
 {
@@ -3838,6 +3946,17 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 			break;
 	}
 
+	if (count >= persistent_huge_pages(h) + HUGETLB_RESIZE_MIN_PARALLEL) {
+		unsigned long needed = count - persistent_huge_pages(h);
+
+		spin_unlock_irq(&hugetlb_lock);
+		alloc_pool_huge_folios_parallel(h, needed, nodes_allowed,
+						node_alloc_noretry);
+		spin_lock_irq(&hugetlb_lock);
+		if (signal_pending(current))
+			goto out;
+	}
+
 	allocated = 0;
 	while (count > (persistent_huge_pages(h) + allocated)) {
 		/*
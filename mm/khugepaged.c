@@ -448,13 +448,28 @@ void __khugepaged_enter(struct mm_struct *mm)
 		wake_up_interruptible(&khugepaged_wait);
 }
 
+/*
+ * Orders khugepaged may collapse a VMA to: the PMD order, plus any enabled
+ * smaller order for anonymous memory.
+ */
+static unsigned long khugepaged_collapse_orders(struct vm_area_struct *vma,
+						unsigned long vm_flags)
+{
+	unsigned long orders = BIT(PMD_ORDER);
+
+	if (vma_is_anonymous(vma))
+		orders = THP_ORDERS_ALL_ANON;
+
+	return thp_vma_allowable_orders(vma, vm_flags, TVA_ENFORCE_SYSFS,
+					orders);
+}
+
 void khugepaged_enter_vma(struct vm_area_struct *vma,
 			  unsigned long vm_flags)
 {
 	if (!test_bit(MMF_VM_HUGEPAGE, &vma->vm_mm->flags) &&
 	    hugepage_flags_enabled()) {
-		if (thp_vma_allowable_order(vma, vm_flags, TVA_ENFORCE_SYSFS,
-					    PMD_ORDER))
+		if (khugepaged_collapse_orders(vma, vm_flags))
 			__khugepaged_enter(vma->vm_mm);
 	}
 }
@@ -538,9 +553,20 @@ static bool is_refcount_suitable(struct folio *folio)
 	return folio_ref_count(folio) == expected_refcount;
 }
 
+/*
+ * The max_ptes_* tunables are expressed in PTEs per PMD; scale them down
+ * proportionally when collapsing to a smaller order.
+ */
+static unsigned int khugepaged_max_ptes(unsigned int max_ptes,
+					unsigned int order)
+{
+	return max_ptes >> (HPAGE_PMD_ORDER - order);
+}
+
 static int __collapse_huge_page_isolate(struct vm_area_struct *vma,
 					unsigned long address,
 					pte_t *pte,
+					unsigned int order,
 					struct collapse_control *cc,
 					struct list_head *compound_pagelist)
 {
@@ -548,9 +574,11 @@ static int __collapse_huge_page_isolate(struct vm_area_struct *vma,
 	struct folio *folio = NULL;
 	pte_t *_pte;
 	int none_or_zero = 0, shared = 0, result = SCAN_FAIL, referenced = 0;
+	unsigned int max_ptes_none = khugepaged_max_ptes(khugepaged_max_ptes_none, order);
+	unsigned int max_ptes_shared = khugepaged_max_ptes(khugepaged_max_ptes_shared, order);
 	bool writable = false;
 
-	for (_pte = pte; _pte < pte + HPAGE_PMD_NR;
+	for (_pte = pte; _pte < pte + (1 << order);
 	     _pte++, address += PAGE_SIZE) {
 		pte_t pteval = ptep_get(_pte);
 		if (pte_none(pteval) || (pte_present(pteval) &&
@@ -558,7 +586,7 @@ static int __collapse_huge_page_isolate(struct vm_area_struct *vma,
 			++none_or_zero;
 			if (!userfaultfd_armed(vma) &&
 			    (!cc->is_khugepaged ||
-			     none_or_zero <= khugepaged_max_ptes_none)) {
+			     none_or_zero <= max_ptes_none)) {
 				continue;
 			} else {
 				result = SCAN_EXCEED_NONE_PTE;
@@ -586,8 +614,7 @@ static int __collapse_huge_page_isolate(struct vm_area_struct *vma,
 		/* See hpage_collapse_scan_pmd(). */
 		if (folio_likely_mapped_shared(folio)) {
 			++shared;
-			if (cc->is_khugepaged &&
-			    shared > khugepaged_max_ptes_shared) {
+			if (cc->is_khugepaged && shared > max_ptes_shared) {
 				result = SCAN_EXCEED_SHARED_PTE;
 				count_vm_event(THP_SCAN_EXCEED_SHARED_PTE);
 				goto out;
@@ -685,6 +712,7 @@ static int __collapse_huge_page_isolate(struct vm_area_struct *vma,
 }
 
 static void __collapse_huge_page_copy_succeeded(pte_t *pte,
+						unsigned int nr_pages,
 						struct vm_area_struct *vma,
 						unsigned long address,
 						spinlock_t *ptl,
@@ -694,7 +722,7 @@ static void __collapse_huge_page_copy_succeeded(pte_t *pte,
 	pte_t *_pte;
 	pte_t pteval;
 
-	for (_pte = pte; _pte < pte + HPAGE_PMD_NR;
+	for (_pte = pte; _pte < pte + nr_pages;
 	     _pte++, address += PAGE_SIZE) {
 		pteval = ptep_get(_pte);
 		if (pte_none(pteval) || is_zero_pfn(pte_pfn(pteval))) {
@@ -738,6 +766,7 @@ static void __collapse_huge_page_copy_succeeded(pte_t *pte,
 }
 
 static void __collapse_huge_page_copy_failed(pte_t *pte,
+					     unsigned int nr_pages,
 					     pmd_t *pmd,
 					     pmd_t orig_pmd,
 					     struct vm_area_struct *vma,
@@ -758,7 +787,7 @@ static void __collapse_huge_page_copy_failed(pte_t *pte,
 	 * Release both raw and compound pages isolated
 	 * in __collapse_huge_page_isolate.
 	 */
-	release_pte_pages(pte, pte + HPAGE_PMD_NR, compound_pagelist);
+	release_pte_pages(pte, pte + nr_pages, compound_pagelist);
 }
 
 /*
@@ -768,7 +797,7 @@ static void __collapse_huge_page_copy_failed(pte_t *pte,
  * Returns SCAN_SUCCEED if copying succeeds, otherwise returns SCAN_COPY_MC.
  *
  * @pte: starting of the PTEs to copy from
- * @folio: the new hugepage to copy contents to
+ * @folio: the new hugepage to copy contents to; one PTE is copied per page
  * @pmd: pointer to the new hugepage's PMD
  * @orig_pmd: the original raw pages' PMD
  * @vma: the original raw pages' virtual memory area
@@ -781,13 +810,13 @@ static int __collapse_huge_page_copy(pte_t *pte, struct folio *folio,
 		unsigned long address, spinlock_t *ptl,
 		struct list_head *compound_pagelist)
 {
-	unsigned int i;
+	unsigned int i, nr_pages = folio_nr_pages(folio);
 	int result = SCAN_SUCCEED;
 
 	/*
 	 * Copying pages' contents is subject to memory poison at any iteration.
 	 */
-	for (i = 0; i < HPAGE_PMD_NR; i++) {
+	for (i = 0; i < nr_pages; i++) {
 		pte_t pteval = ptep_get(pte + i);
 		struct page *page = folio_page(folio, i);
 		unsigned long src_addr = address + i * PAGE_SIZE;
@@ -805,11 +834,11 @@ static int __collapse_huge_page_copy(pte_t *pte, struct folio *folio,
 	}
 
 	if (likely(result == SCAN_SUCCEED))
-		__collapse_huge_page_copy_succeeded(pte, vma, address, ptl,
-						    compound_pagelist);
+		__collapse_huge_page_copy_succeeded(pte, nr_pages, vma, address,
+						    ptl, compound_pagelist);
 	else
-		__collapse_huge_page_copy_failed(pte, pmd, orig_pmd, vma,
-						 compound_pagelist);
+		__collapse_huge_page_copy_failed(pte, nr_pages, pmd, orig_pmd,
+						 vma, compound_pagelist);
 
 	return result;
 }
@@ -895,7 +924,7 @@ static int hpage_collapse_find_target_node(struct collapse_control *cc)
  */
 
 static int hugepage_vma_revalidate(struct mm_struct *mm, unsigned long address,
-				   bool expect_anon,
+				   bool expect_anon, unsigned int order,
 				   struct vm_area_struct **vmap,
 				   struct collapse_control *cc)
 {
@@ -909,9 +938,13 @@ static int hugepage_vma_revalidate(struct mm_struct *mm, unsigned long address,
 	if (!vma)
 		return SCAN_VMA_NULL;
 
+	/*
+	 * Even an mTHP collapse needs the whole PMD range: the page table is
+	 * detached from the PMD while the collapse is in progress.
+	 */
 	if (!thp_vma_suitable_order(vma, address, PMD_ORDER))
 		return SCAN_ADDRESS_RANGE;
-	if (!thp_vma_allowable_order(vma, vma->vm_flags, tva_flags, PMD_ORDER))
+	if (!thp_vma_allowable_order(vma, vma->vm_flags, tva_flags, order))
 		return SCAN_VMA_CHECK;
 	/*
 	 * Anon VMA expected, the address may be unmapped then
@@ -1043,35 +1076,45 @@ static int __collapse_huge_page_swapin(struct mm_struct *mm,
 }
 
 static int alloc_charge_folio(struct folio **foliop, struct mm_struct *mm,
-			      struct collapse_control *cc)
+			      unsigned int order, struct collapse_control *cc)
 {
 	gfp_t gfp = (cc->is_khugepaged ? alloc_hugepage_khugepaged_gfpmask() :
 		     GFP_TRANSHUGE);
 	int node = hpage_collapse_find_target_node(cc);
 	struct folio *folio;
 
-	folio = __folio_alloc(gfp, HPAGE_PMD_ORDER, node, &cc->alloc_nmask);
+	folio = __folio_alloc(gfp, order, node, &cc->alloc_nmask);
 	if (!folio) {
 		*foliop = NULL;
-		count_vm_event(THP_COLLAPSE_ALLOC_FAILED);
+		if (order == HPAGE_PMD_ORDER)
+			count_vm_event(THP_COLLAPSE_ALLOC_FAILED);
+		count_mthp_stat(order, MTHP_STAT_COLLAPSE_ALLOC_FAILED);
 		return SCAN_ALLOC_HUGE_PAGE_FAIL;
 	}
 
-	count_vm_event(THP_COLLAPSE_ALLOC);
+	if (order == HPAGE_PMD_ORDER)
+		count_vm_event(THP_COLLAPSE_ALLOC);
+	count_mthp_stat(order, MTHP_STAT_COLLAPSE_ALLOC);
 	if (unlikely(mem_cgroup_charge(folio, mm, gfp))) {
 		folio_put(folio);
 		*foliop = NULL;
 		return SCAN_CGROUP_CHARGE_FAIL;
 	}
 
-	count_memcg_folio_events(folio, THP_COLLAPSE_ALLOC, 1);
+	if (order == HPAGE_PMD_ORDER)
+		count_memcg_folio_events(folio, THP_COLLAPSE_ALLOC, 1);
 
 	*foliop = folio;
 	return SCAN_SUCCEED;
 }
 
+/*
+ * Collapse the naturally aligned range of 1 << @order PTEs at @address into a
+ * single folio. For the PMD order the result is mapped by a huge PMD; smaller
+ * orders are mapped by PTEs in the original page table.
+ */
 static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
-			      int referenced, int unmapped,
+			      int referenced, int unmapped, unsigned int order,
 			      struct collapse_control *cc)
 {
 	LIST_HEAD(compound_pagelist);
@@ -1083,8 +1126,11 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	int result = SCAN_FAIL;
 	struct vm_area_struct *vma;
 	struct mmu_notifier_range range;
+	unsigned long haddr = address & HPAGE_PMD_MASK;
+	unsigned int nr_pages = 1 << order;
 
-	VM_BUG_ON(address & ~HPAGE_PMD_MASK);
+	VM_BUG_ON(!IS_ALIGNED(address, PAGE_SIZE << order));
+	VM_BUG_ON(order != HPAGE_PMD_ORDER && unmapped);
 
 	/*
 	 * Before allocating the hugepage, release the mmap_lock read lock.
@@ -1094,12 +1140,12 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	 */
 	mmap_read_unlock(mm);
 
-	result = alloc_charge_folio(&folio, mm, cc);
+	result = alloc_charge_folio(&folio, mm, order, cc);
 	if (result != SCAN_SUCCEED)
 		goto out_nolock;
 
 	mmap_read_lock(mm);
-	result = hugepage_vma_revalidate(mm, address, true, &vma, cc);
+	result = hugepage_vma_revalidate(mm, address, true, order, &vma, cc);
 	if (result != SCAN_SUCCEED) {
 		mmap_read_unlock(mm);
 		goto out_nolock;
@@ -1133,7 +1179,7 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	 * mmap_lock.
 	 */
 	mmap_write_lock(mm);
-	result = hugepage_vma_revalidate(mm, address, true, &vma, cc);
+	result = hugepage_vma_revalidate(mm, address, true, order, &vma, cc);
 	if (result != SCAN_SUCCEED)
 		goto out_up_write;
 	/* check if the pmd is still valid */
@@ -1145,7 +1191,7 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	anon_vma_lock_write(vma->anon_vma);
 
 	mmu_notifier_range_init(&range, MMU_NOTIFY_CLEAR, 0, mm, address,
-				address + HPAGE_PMD_SIZE);
+				address + (PAGE_SIZE << order));
 	mmu_notifier_invalidate_range_start(&range);
 
 	pmd_ptl = pmd_lock(mm, pmd); /* probably unnecessary */
@@ -1157,15 +1203,15 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	 * Parallel GUP-fast is fine since GUP-fast will back off when
 	 * it detects PMD is changed.
 	 */
-	_pmd = pmdp_collapse_flush(vma, address, pmd);
+	_pmd = pmdp_collapse_flush(vma, haddr, pmd);
 	spin_unlock(pmd_ptl);
 	mmu_notifier_invalidate_range_end(&range);
 	tlb_remove_table_sync_one();
 
 	pte = pte_offset_map_lock(mm, &_pmd, address, &pte_ptl);
 	if (pte) {
-		result = __collapse_huge_page_isolate(vma, address, pte, cc,
-						      &compound_pagelist);
+		result = __collapse_huge_page_isolate(vma, address, pte, order,
+						      cc, &compound_pagelist);
 		spin_unlock(pte_ptl);
 	} else {
 		result = SCAN_PMD_NULL;
@@ -1196,9 +1242,10 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	result = __collapse_huge_page_copy(pte, folio, pmd, _pmd,
 					   vma, address, pte_ptl,
 					   &compound_pagelist);
-	pte_unmap(pte);
-	if (unlikely(result != SCAN_SUCCEED))
+	if (unlikely(result != SCAN_SUCCEED)) {
+		pte_unmap(pte);
 		goto out_up_write;
+	}
 
 	/*
 	 * The smp_wmb() inside __folio_mark_uptodate() ensures the
@@ -1208,6 +1255,31 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	__folio_mark_uptodate(folio);
 	pgtable = pmd_pgtable(_pmd);
 
+	if (order != HPAGE_PMD_ORDER) {
+		pte_t entry = mk_pte(&folio->page, vma->vm_page_prot);
+
+		entry = maybe_mkwrite(pte_mkdirty(entry), vma);
+
+		/*
+		 * The page table is still detached, so nobody else can see
+		 * the PTEs until the PMD is repopulated below.
+		 */
+		spin_lock(pmd_ptl);
+		BUG_ON(!pmd_none(*pmd));
+		folio_ref_add(folio, nr_pages - 1);
+		folio_add_new_anon_rmap(folio, vma, address);
+		folio_add_lru_vma(folio, vma);
+		set_ptes(mm, address, pte, entry, nr_pages);
+		update_mmu_cache_range(NULL, vma, address, pte, nr_pages);
+		/* make the PTEs visible before the PMD, see pmd_install() */
+		smp_wmb();
+		pmd_populate(mm, pmd, pgtable);
+		spin_unlock(pmd_ptl);
+		pte_unmap(pte);
+		goto out_mapped;
+	}
+	pte_unmap(pte);
+
 	_pmd = mk_huge_pmd(&folio->page, vma->vm_page_prot);
 	_pmd = maybe_pmd_mkwrite(pmd_mkdirty(_pmd), vma);
 
@@ -1219,7 +1291,7 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	set_pmd_at(mm, address, pmd, _pmd);
 	update_mmu_cache_pmd(vma, address, pmd);
 	spin_unlock(pmd_ptl);
-
+out_mapped:
 	folio = NULL;
 
 	result = SCAN_SUCCEED;
@@ -1232,6 +1304,167 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	return result;
 }
 
+/*
+ * Check whether the 1 << @order PTEs at @pte can be collapsed into a single
+ * mTHP. Called with the PTE lock held; the checks mirror those done by
+ * hpage_collapse_scan_pmd() for the whole PMD.
+ */
+static int hpage_collapse_check_mthp(struct vm_area_struct *vma,
+				     unsigned long address, pte_t *pte,
+				     unsigned int order)
+{
+	unsigned int nr_pages = 1 << order;
+	unsigned int max_ptes_shared = khugepaged_max_ptes(khugepaged_max_ptes_shared, order);
+	unsigned int max_ptes_none = khugepaged_max_ptes(khugepaged_max_ptes_none, order);
+	struct folio *folio, *first = NULL;
+	int none_or_zero = 0, shared = 0, referenced = 0;
+	bool writable = false, single_folio = true;
+	unsigned int i;
+
+	/*
+	 * Never let an mTHP collapse more than double the memory it covers.
+	 * This also keeps a freshly collapsed range from qualifying for the
+	 * next order up on its own.
+	 */
+	max_ptes_none = min(max_ptes_none, nr_pages / 2 - 1);
+
+	for (i = 0; i < nr_pages; i++, address += PAGE_SIZE) {
+		pte_t pteval = ptep_get(pte + i);
+		struct page *page;
+
+		if (pte_none(pteval) || (pte_present(pteval) &&
+				is_zero_pfn(pte_pfn(pteval)))) {
+			if (userfaultfd_armed(vma) ||
+			    ++none_or_zero > max_ptes_none)
+				return SCAN_EXCEED_NONE_PTE;
+			single_folio = false;
+			continue;
+		}
+		if (!pte_present(pteval))
+			return SCAN_PTE_NON_PRESENT;
+		if (pte_uffd_wp(pteval))
+			return SCAN_PTE_UFFD_WP;
+		if (pte_write(pteval))
+			writable = true;
+
+		page = vm_normal_page(vma, address, pteval);
+		if (unlikely(!page) || unlikely(is_zone_device_page(page)))
+			return SCAN_PAGE_NULL;
+		folio = page_folio(page);
+		if (!folio_test_anon(folio))
+			return SCAN_PAGE_ANON;
+
+		if (!first)
+			first = folio;
+		else if (folio != first)
+			single_folio = false;
+
+		if (folio_likely_mapped_shared(folio) &&
+		    ++shared > max_ptes_shared)
+			return SCAN_EXCEED_SHARED_PTE;
+		if (!folio_test_lru(folio))
+			return SCAN_PAGE_LRU;
+		if (folio_test_locked(folio))
+			return SCAN_PAGE_LOCK;
+		if (!is_refcount_suitable(folio))
+			return SCAN_PAGE_COUNT;
+
+		if (pte_young(pteval) || folio_test_young(folio) ||
+		    folio_test_referenced(folio) ||
+		    mmu_notifier_test_young(vma->vm_mm, address))
+			referenced++;
+	}
+
+	/* Nothing to gain if a large enough folio already maps the range. */
+	if (single_folio && folio_order(first) >= order)
+		return SCAN_PTE_MAPPED_HUGEPAGE;
+	if (!writable)
+		return SCAN_PAGE_RO;
+	if (!referenced)
+		return SCAN_LACK_REFERENCED_PAGE;
+	return SCAN_SUCCEED;
+}
+
+/*
+ * Collapse parts of the PTE table at @address into the enabled mTHP @orders,
+ * picking the largest order whose naturally aligned range is populated enough
+ * and repeating until no range qualifies. Returns with the mmap_lock released
+ * if a collapse was attempted, like collapse_huge_page().
+ */
+static int hpage_collapse_scan_mthp(struct mm_struct *mm,
+				    struct vm_area_struct *vma,
+				    unsigned long address, unsigned long orders,
+				    bool *mmap_locked,
+				    struct collapse_control *cc)
+{
+	int result = SCAN_FAIL, nr_collapsed = 0;
+
+	orders &= BIT(PMD_ORDER) - 1;
+
+	while (true) {
+		unsigned long iter = orders;
+		unsigned int i, j, nr_pages;
+		spinlock_t *ptl;
+		pmd_t *pmd;
+		pte_t *pte;
+		int order;
+
+		if (!*mmap_locked) {
+			mmap_read_lock(mm);
+			*mmap_locked = true;
+			result = hugepage_vma_revalidate(mm, address, true,
+						highest_order(orders), &vma, cc);
+			if (result != SCAN_SUCCEED)
+				break;
+		}
+
+		result = find_pmd_or_thp_or_none(mm, address, &pmd);
+		if (result != SCAN_SUCCEED)
+			break;
+		pte = pte_offset_map_lock(mm, pmd, address, &ptl);
+		if (!pte) {
+			result = SCAN_PMD_NULL;
+			break;
+		}
+
+		order = highest_order(iter);
+		while (iter) {
+			nr_pages = 1 << order;
+			for (i = 0; i < HPAGE_PMD_NR; i += nr_pages) {
+				result = hpage_collapse_check_mthp(vma,
+						address + i * PAGE_SIZE,
+						pte + i, order);
+				if (result == SCAN_SUCCEED)
+					goto found;
+			}
+			order = next_order(&iter, order);
+		}
+		pte_unmap_unlock(pte, ptl);
+		break;
+found:
+		/* Allocate the new folio where most of the range lives. */
+		memset(cc->node_load, 0, sizeof(cc->node_load));
+		nodes_clear(cc->alloc_nmask);
+		for (j = i; j < i + nr_pages; j++) {
+			pte_t pteval = ptep_get(pte + j);
+
+			if (pte_present(pteval) && !is_zero_pfn(pte_pfn(pteval)))
+				cc->node_load[pfn_to_nid(pte_pfn(pteval))]++;
+		}
+		pte_unmap_unlock(pte, ptl);
+
+		result = collapse_huge_page(mm, address + i * PAGE_SIZE, 0, 0,
+					    order, cc);
+		/* collapse_huge_page will return with the mmap_lock released */
+		*mmap_locked = false;
+		if (result != SCAN_SUCCEED)
+			break;
+		nr_collapsed++;
+	}
+
+	return nr_collapsed ? SCAN_SUCCEED : result;
+}
+
 static int hpage_collapse_scan_pmd(struct mm_struct *mm,
 				   struct vm_area_struct *vma,
 				   unsigned long address, bool *mmap_locked,
@@ -1243,7 +1476,7 @@ static int hpage_collapse_scan_pmd(struct mm_struct *mm,
 	int none_or_zero = 0, shared = 0;
 	struct page *page = NULL;
 	struct folio *folio = NULL;
-	unsigned long _address;
+	unsigned long _address, orders = BIT(PMD_ORDER);
 	spinlock_t *ptl;
 	int node = NUMA_NO_NODE, unmapped = 0;
 	bool writable = false;
@@ -1254,6 +1487,13 @@ static int hpage_collapse_scan_pmd(struct mm_struct *mm,
 	if (result != SCAN_SUCCEED)
 		goto out;
 
+	if (cc->is_khugepaged)
+		orders = khugepaged_collapse_orders(vma, vma->vm_flags);
+	if (!(orders & BIT(PMD_ORDER))) {
+		result = SCAN_VMA_CHECK;
+		goto try_mthp;
+	}
+
 	memset(cc->node_load, 0, sizeof(cc->node_load));
 	nodes_clear(cc->alloc_nmask);
 	pte = pte_offset_map_lock(mm, pmd, address, &ptl);
@@ -1400,10 +1640,21 @@ static int hpage_collapse_scan_pmd(struct mm_struct *mm,
 	pte_unmap_unlock(pte, ptl);
 	if (result == SCAN_SUCCEED) {
 		result = collapse_huge_page(mm, address, referenced,
-					    unmapped, cc);
+					    unmapped, HPAGE_PMD_ORDER, cc);
 		/* collapse_huge_page will return with the mmap_lock released */
 		*mmap_locked = false;
 	}
+try_mthp:
+	/*
+	 * The range is too sparse for the PMD order, or the PMD order is not
+	 * enabled: see whether smaller enabled orders fit parts of it.
+	 */
+	if (*mmap_locked && (orders & (BIT(PMD_ORDER) - 1)) &&
+	    (result == SCAN_VMA_CHECK || result == SCAN_EXCEED_NONE_PTE ||
+	     result == SCAN_EXCEED_SWAP_PTE ||
+	     result == SCAN_EXCEED_SHARED_PTE))
+		result = hpage_collapse_scan_mthp(mm, vma, address, orders,
+						  mmap_locked, cc);
 out:
 	trace_mm_khugepaged_scan_pmd(mm, &folio->page, writable, referenced,
 				     none_or_zero, result, unmapped);
@@ -1798,7 +2049,7 @@ static int collapse_file(struct mm_struct *mm, unsigned long addr,
 	VM_BUG_ON(!IS_ENABLED(CONFIG_READ_ONLY_THP_FOR_FS) && !is_shmem);
 	VM_BUG_ON(start & (HPAGE_PMD_NR - 1));
 
-	result = alloc_charge_folio(&new_folio, mm, cc);
+	result = alloc_charge_folio(&new_folio, mm, HPAGE_PMD_ORDER, cc);
 	if (result != SCAN_SUCCEED)
 		goto out;
 
@@ -2362,8 +2613,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 			progress++;
 			break;
 		}
-		if (!thp_vma_allowable_order(vma, vma->vm_flags,
-					TVA_ENFORCE_SYSFS, PMD_ORDER)) {
+		if (!khugepaged_collapse_orders(vma, vma->vm_flags)) {
 skip:
 			progress++;
 			continue;
@@ -2721,7 +2971,8 @@ int madvise_collapse(struct vm_area_struct *vma, struct vm_area_struct **prev,
 			cond_resched();
 			mmap_read_lock(mm);
 			mmap_locked = true;
-			result = hugepage_vma_revalidate(mm, addr, false, &vma,
+			result = hugepage_vma_revalidate(mm, addr, false,
+							 HPAGE_PMD_ORDER, &vma,
 							 cc);
 			if (result  != SCAN_SUCCEED) {
 				last_fail = result;
@@ -37,6 +37,7 @@
 #include <linux/swap.h>
 #include <linux/ksm.h>
 #include <linux/hashtable.h>
+#include <linux/hash.h>
 #include <linux/freezer.h>
 #include <linux/oom.h>
 #include <linux/numa.h>
@@ -155,6 +156,7 @@ struct ksm_scan {
  * @kpfn: page frame number of this ksm page (perhaps temporarily on wrong nid)
  * @chain_prune_time: time of the last full garbage collection
  * @rmap_hlist_len: number of rmap_item entries in hlist or STABLE_NODE_CHAIN
+ * @checksum: checksum of this ksm page, accounted in ksm_stable_filter
  * @nid: NUMA node id of stable tree in which linked (may not match kpfn)
  */
 struct ksm_stable_node {
@@ -180,6 +182,7 @@ struct ksm_stable_node {
 	 */
 #define STABLE_NODE_CHAIN -1024
 	int rmap_hlist_len;
+	u32 checksum;
 #ifdef CONFIG_NUMA
 	int nid;
 #endif
@@ -288,6 +291,16 @@ static unsigned int ksm_thread_sleep_millisecs = 20;
 /* Checksum of an empty (zeroed) page */
 static unsigned int zero_checksum __read_mostly;
 
+/*
+ * Counting filter over the checksums of the pages in the stable trees:
+ * a page whose checksum has no entry cannot be identical to any ksm page,
+ * so stable_tree_search() can be skipped for it. ksm pages are write
+ * protected, so their checksum stays valid for as long as they are in the
+ * tree. Saturated counters stick, which only costs a needless tree walk.
+ */
+static u8 *ksm_stable_filter __read_mostly;
+static unsigned int ksm_stable_filter_bits __read_mostly;
+
 /* Whether to merge empty (zeroed) pages with actual zero pages */
 static bool ksm_use_zero_pages __read_mostly;
 
@@ -592,10 +605,51 @@ static inline struct ksm_stable_node *alloc_stable_node(void)
 	return kmem_cache_alloc(stable_node_cache, GFP_KERNEL | __GFP_HIGH);
 }
 
+static void ksm_stable_filter_add(u32 checksum)
+{
+	u8 *count;
+
+	if (!ksm_stable_filter)
+		return;
+	count = &ksm_stable_filter[hash_32(checksum, ksm_stable_filter_bits)];
+	if (*count < U8_MAX)
+		(*count)++;
+}
+
+static void ksm_stable_filter_del(u32 checksum)
+{
+	u8 *count;
+
+	if (!ksm_stable_filter)
+		return;
+	count = &ksm_stable_filter[hash_32(checksum, ksm_stable_filter_bits)];
+	if (*count && *count < U8_MAX)
+		(*count)--;
+}
+
+static bool ksm_stable_filter_test(u32 checksum)
+{
+	return !ksm_stable_filter ||
+	       ksm_stable_filter[hash_32(checksum, ksm_stable_filter_bits)];
+}
+
+static void __init ksm_stable_filter_init(void)
+{
+	/* One counter per 64 pages of memory, but at least 64k of them */
+	unsigned long entries = max(totalram_pages() >> 6, 1UL << 16);
+
+	ksm_stable_filter_bits = ilog2(entries);
+	/* Without the filter, every page just walks the stable tree */
+	ksm_stable_filter = kvzalloc(1UL << ksm_stable_filter_bits,
+				     GFP_KERNEL);
+}
+
 static inline void free_stable_node(struct ksm_stable_node *stable_node)
 {
 	VM_BUG_ON(stable_node->rmap_hlist_len &&
 		  !is_stable_node_chain(stable_node));
+	if (!is_stable_node_chain(stable_node))
+		ksm_stable_filter_del(stable_node->checksum);
 	kmem_cache_free(stable_node_cache, stable_node);
 }
 
@@ -2153,6 +2207,8 @@ static struct ksm_stable_node *stable_tree_insert(struct folio *kfolio)
 	INIT_HLIST_HEAD(&stable_node_dup->hlist);
 	stable_node_dup->kpfn = kpfn;
 	stable_node_dup->rmap_hlist_len = 0;
+	stable_node_dup->checksum = calc_checksum(&kfolio->page);
+	ksm_stable_filter_add(stable_node_dup->checksum);
 	DO_NUMA(stable_node_dup->nid = nid);
 	if (!need_chain) {
 		rb_link_node(&stable_node_dup->node, parent, new);
@@ -2335,8 +2391,16 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 			max_page_sharing_bypass = true;
 	}
 
-	/* We first start with searching the page inside the stable tree */
-	kpage = stable_tree_search(page);
+	checksum = calc_checksum(page);
+
+	/*
+	 * We first start with searching the page inside the stable tree,
+	 * unless the checksum says no ksm page can have the same content.
+	 */
+	if (stable_node || ksm_stable_filter_test(checksum))
+		kpage = stable_tree_search(page);
+	else
+		kpage = NULL;
 	if (kpage == page && rmap_item->head == stable_node) {
 		put_page(kpage);
 		return;
@@ -2369,7 +2433,6 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	 * don't want to insert it in the unstable tree, and we don't want
 	 * to waste our time searching for something identical to it there.
 	 */
-	checksum = calc_checksum(page);
 	if (rmap_item->oldchecksum != checksum) {
 		rmap_item->oldchecksum = checksum;
 		return;
@@ -3917,6 +3980,8 @@ static int __init ksm_init(void)
 	/* Default to false for backwards compatibility */
 	ksm_use_zero_pages = false;
 
+	ksm_stable_filter_init();
+
 	err = ksm_slab_init();
 	if (err)
 		goto out;
@@ -3947,6 +4012,8 @@ static int __init ksm_init(void)
 	return 0;
 
 out_free:
+	kvfree(ksm_stable_filter);
+	ksm_stable_filter = NULL;
 	ksm_slab_free();
 out:
 	return err;
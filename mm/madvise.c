@@ -45,7 +45,9 @@ struct madvise_walk_private {
 /*
  * Any behaviour which results in changes to the vma->vm_flags needs to
  * take mmap_lock for writing. Others, which simply traverse vmas, need
- * to only take it for reading.
+ * to only take it for reading.  Some of those are even fine with only the
+ * per-VMA lock if the range stays within a single vma, see
+ * madvise_vma_lockable().
  */
 static int madvise_need_mmap_write(int behavior)
 {
@@ -843,7 +845,12 @@ static int madvise_free_single_vma(struct vm_area_struct *vma,
 static long madvise_dontneed_single_vma(struct vm_area_struct *vma,
 					unsigned long start, unsigned long end)
 {
-	zap_page_range_single(vma, start, end - start, NULL);
+	struct zap_details details = {
+		.even_cows = true,
+		.reclaim_pt = true,
+	};
+
+	zap_page_range_single(vma, start, end - start, &details);
 	return 0;
 }
 
@@ -1348,7 +1355,9 @@ int madvise_set_anon_name(struct mm_struct *mm, unsigned long start,
  *		cation will need more than what it asks for.
  *  MADV_SEQUENTIAL - pages in the given range will probably be accessed
  *		once, so they can be aggressively read ahead, and
- *		can be freed soon after they are accessed.
+ *		can be freed soon after they are accessed. On private
+ *		anonymous memory, write faults also populate the
+ *		following pages up to fault_around_bytes.
  *  MADV_WILLNEED - the application is notifying the system to read
  *		some pages ahead.
  *  MADV_DONTNEED - the application is finished with the given range,
@@ -1403,6 +1412,65 @@ int madvise_set_anon_name(struct mm_struct *mm, unsigned long start,
  *  -EAGAIN - a kernel resource was temporarily unavailable.
  *  -EPERM  - memory is sealed.
  */
+#ifdef CONFIG_PER_VMA_LOCK
+/*
+ * MADV_DONTNEED only zaps the page tables of the vma, which is safe against
+ * the page fault handlers running under the per-VMA lock.  MADV_FREE still
+ * needs mmap_lock for its page table walk.
+ */
+static bool madvise_vma_lockable(int behavior)
+{
+	switch (behavior) {
+	case MADV_DONTNEED:
+	case MADV_DONTNEED_LOCKED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Try to apply @behavior to [@start, @end) under the per-VMA lock instead of
+ * mmap_lock, so that threads freeing memory don't contend with the faults of
+ * other threads.  Returns -EAGAIN if the range spans more than one vma or the
+ * vma can't be handled without mmap_lock, in which case nothing is done.
+ */
+static int madvise_single_vma_locked(struct mm_struct *mm, unsigned long start,
+				     unsigned long end, int behavior)
+{
+	struct vm_area_struct *vma, *prev;
+	int error;
+
+	if (!madvise_vma_lockable(behavior))
+		return -EAGAIN;
+
+	vma = lock_vma_under_rcu(mm, start);
+	if (!vma)
+		return -EAGAIN;
+
+	/*
+	 * userfaultfd_remove() drops mmap_lock, which we don't hold, to
+	 * notify the monitor.  Leave those vmas, and hugetlb ones with their
+	 * own locking, to the slow path.
+	 */
+	if (end > vma->vm_end || userfaultfd_armed(vma) ||
+	    is_vm_hugetlb_page(vma) || !can_modify_vma_madv(vma, behavior)) {
+		vma_end_read(vma);
+		return -EAGAIN;
+	}
+
+	error = madvise_dontneed_free(vma, &prev, start, end, behavior);
+	vma_end_read(vma);
+	return error;
+}
+#else
+static int madvise_single_vma_locked(struct mm_struct *mm, unsigned long start,
+				     unsigned long end, int behavior)
+{
+	return -EAGAIN;
+}
+#endif
+
 int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int behavior)
 {
 	unsigned long end;
@@ -1434,6 +1502,14 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 		return madvise_inject_error(behavior, start, start + len_in);
 #endif
 
+	if (mm == current->mm) {
+		error = madvise_single_vma_locked(mm, untagged_addr(start),
+						  untagged_addr(start) + len,
+						  behavior);
+		if (error != -EAGAIN)
+			return error;
+	}
+
 	write = madvise_need_mmap_write(behavior);
 	if (write) {
 		if (mmap_write_lock_killable(mm))
@@ -94,6 +94,35 @@ static bool cgroup_memory_nokmem __ro_after_init;
 /* BPF memory accounting disabled? */
 static bool cgroup_memory_nobpf __ro_after_init;
 
+/* Page fault latency histograms enabled? */
+static bool cgroup_memory_fault_latency __ro_after_init;
+DEFINE_STATIC_KEY_FALSE(memcg_fault_latency_key);
+
+enum memcg_fault_type {
+	MEMCG_FAULT_MINOR,
+	MEMCG_FAULT_MAJOR,
+	MEMCG_FAULT_ANON,
+	MEMCG_FAULT_FILE,
+	MEMCG_FAULT_WRITE,
+	/* attempts that ended with VM_FAULT_RETRY, not in the above */
+	MEMCG_FAULT_RETRY,
+	NR_MEMCG_FAULT_TYPES,
+};
+
+static const char *const memcg_fault_type_names[NR_MEMCG_FAULT_TYPES] = {
+	"minor", "major", "anon", "file", "write", "retry",
+};
+
+/*
+ * Bucket 0 counts faults under 1us, bucket i up to 2^i us, and the last one
+ * everything longer.
+ */
+#define MEMCG_FAULT_LATENCY_BUCKETS	16
+
+struct memcg_fault_latency {
+	u64 count[NR_MEMCG_FAULT_TYPES][MEMCG_FAULT_LATENCY_BUCKETS];
+};
+
 #ifdef CONFIG_CGROUP_WRITEBACK
 static DECLARE_WAIT_QUEUE_HEAD(memcg_cgwb_frn_waitq);
 #endif
@@ -791,6 +820,11 @@ struct memcg_vmstats {
 
 	/* Stats updates since the last flush */
 	atomic64_t		stats_updates;
+
+	/* A flush of this subtree is in progress */
+	atomic_t		flushing;
+	/* When the last flush of this subtree completed, in jiffies */
+	u64			last_flush;
 };
 
 /*
@@ -807,6 +841,13 @@ struct memcg_vmstats {
  *    (MEMCG_CHARGE_BATCH * nr_cpus) update events. Though this optimization
  *    will let stats be out of sync by atmost (MEMCG_CHARGE_BATCH * nr_cpus) but
  *    only for 2 seconds due to (1).
+ *
+ * 3) Only flush the subtree of the reader, and only once at a time: readers
+ *    that find a flush of their subtree in progress wait for it instead of
+ *    queueing up on the global rstat lock.  Readers that can live with stats
+ *    of a bounded age use mem_cgroup_flush_stats_bounded(), which doesn't
+ *    flush if the subtree or one of its ancestors has been flushed recently
+ *    enough.
  */
 static void flush_memcg_stats_dwork(struct work_struct *w);
 static DECLARE_DEFERRABLE_WORK(stats_flush_dwork, flush_memcg_stats_dwork);
@@ -873,10 +914,22 @@ static inline void memcg_rstat_updated(struct mem_cgroup *memcg, int val)
 
 static void do_flush_stats(struct mem_cgroup *memcg)
 {
+	struct memcg_vmstats *vmstats = memcg->vmstats;
+
+	if (atomic_xchg(&vmstats->flushing, 1)) {
+		wait_var_event(&vmstats->flushing,
+			       !atomic_read(&vmstats->flushing));
+		return;
+	}
+
 	if (mem_cgroup_is_root(memcg))
 		WRITE_ONCE(flush_last_time, jiffies_64);
 
 	cgroup_rstat_flush(memcg->css.cgroup);
+
+	WRITE_ONCE(vmstats->last_flush, get_jiffies_64());
+	atomic_set_release(&vmstats->flushing, 0);
+	wake_up_var(&vmstats->flushing);
 }
 
 /*
@@ -900,11 +953,38 @@ void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 		do_flush_stats(memcg);
 }
 
+/**
+ * mem_cgroup_flush_stats_bounded - flush stats older than a given age
+ * @memcg: root of the subtree to flush
+ * @max_age_ms: how old the stats of @memcg may be
+ *
+ * Like mem_cgroup_flush_stats(), but don't flush if @memcg or one of its
+ * ancestors has been flushed in the last @max_age_ms milliseconds.
+ */
+void mem_cgroup_flush_stats_bounded(struct mem_cgroup *memcg,
+				    unsigned int max_age_ms)
+{
+	u64 since = get_jiffies_64() - msecs_to_jiffies(max_age_ms);
+	struct mem_cgroup *iter;
+
+	if (mem_cgroup_disabled())
+		return;
+
+	if (!memcg)
+		memcg = root_mem_cgroup;
+
+	for (iter = memcg; iter; iter = parent_mem_cgroup(iter)) {
+		if (time_after64(READ_ONCE(iter->vmstats->last_flush), since))
+			return;
+	}
+
+	mem_cgroup_flush_stats(memcg);
+}
+
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 	/* Only flush if the periodic flusher is one full cycle late */
-	if (time_after64(jiffies_64, READ_ONCE(flush_last_time) + 2*FLUSH_TIME))
-		mem_cgroup_flush_stats(memcg);
+	mem_cgroup_flush_stats_bounded(memcg, jiffies_to_msecs(2*FLUSH_TIME));
 }
 
 static void flush_memcg_stats_dwork(struct work_struct *w)
@@ -2409,10 +2489,18 @@ void folio_memcg_unlock(struct folio *folio)
 	__folio_memcg_unlock(folio_memcg(folio));
 }
 
+/*
+ * Number of memcgs whose charges are cached per CPU.  Hosts that consolidate
+ * many cgroups run tasks of several of them on each CPU, and a single cached
+ * memcg would be drained on nearly every switch between them.
+ */
+#define NR_MEMCG_STOCK 7
+
 struct memcg_stock_pcp {
 	local_lock_t stock_lock;
-	struct mem_cgroup *cached; /* this never be root cgroup */
-	unsigned int nr_pages;
+	/* most recently used first, these never be root cgroup */
+	struct mem_cgroup *cached[NR_MEMCG_STOCK];
+	unsigned int nr_pages[NR_MEMCG_STOCK];
 
 #ifdef CONFIG_MEMCG_KMEM
 	struct obj_cgroup *cached_objcg;
@@ -2457,8 +2545,8 @@ static void memcg_account_kmem(struct mem_cgroup *memcg, int nr_pages)
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
- * stock, and at least @nr_pages are available in that stock.  Failure to
+ * The charges will only happen if @memcg is one of the current cpu's memcg
+ * stocks, and at least @nr_pages are available in that stock.  Failure to
  * service an allocation will refill the stock.
  *
  * returns true if successful, false otherwise.
@@ -2469,6 +2557,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	unsigned int stock_pages;
 	unsigned long flags;
 	bool ret = false;
+	int i;
 
 	if (nr_pages > MEMCG_CHARGE_BATCH)
 		return ret;
@@ -2476,10 +2565,15 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	local_lock_irqsave(&memcg_stock.stock_lock, flags);
 
 	stock = this_cpu_ptr(&memcg_stock);
-	stock_pages = READ_ONCE(stock->nr_pages);
-	if (memcg == READ_ONCE(stock->cached) && stock_pages >= nr_pages) {
-		WRITE_ONCE(stock->nr_pages, stock_pages - nr_pages);
-		ret = true;
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		if (memcg != READ_ONCE(stock->cached[i]))
+			continue;
+		stock_pages = READ_ONCE(stock->nr_pages[i]);
+		if (stock_pages >= nr_pages) {
+			WRITE_ONCE(stock->nr_pages[i], stock_pages - nr_pages);
+			ret = true;
+		}
+		break;
 	}
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -2488,12 +2582,12 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns stocks cached in percpu slot @i and reset cached information.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock(struct memcg_stock_pcp *stock, int i)
 {
-	unsigned int stock_pages = READ_ONCE(stock->nr_pages);
-	struct mem_cgroup *old = READ_ONCE(stock->cached);
+	unsigned int stock_pages = READ_ONCE(stock->nr_pages[i]);
+	struct mem_cgroup *old = READ_ONCE(stock->cached[i]);
 
 	if (!old)
 		return;
@@ -2503,11 +2597,33 @@ static void drain_stock(struct memcg_stock_pcp *stock)
 		if (do_memsw_account())
 			page_counter_uncharge(&old->memsw, stock_pages);
 
-		WRITE_ONCE(stock->nr_pages, 0);
+		WRITE_ONCE(stock->nr_pages[i], 0);
 	}
 
 	css_put(&old->css);
-	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->cached[i], NULL);
+}
+
+static void drain_stock_fully(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < NR_MEMCG_STOCK; i++)
+		drain_stock(stock, i);
+}
+
+/* Move slot @i to the front, shifting the more recently used ones back */
+static void rotate_stock(struct memcg_stock_pcp *stock, int i)
+{
+	struct mem_cgroup *memcg = stock->cached[i];
+	unsigned int nr_pages = stock->nr_pages[i];
+
+	for (; i > 0; i--) {
+		WRITE_ONCE(stock->cached[i], stock->cached[i - 1]);
+		WRITE_ONCE(stock->nr_pages[i], stock->nr_pages[i - 1]);
+	}
+	WRITE_ONCE(stock->cached[0], memcg);
+	WRITE_ONCE(stock->nr_pages[0], nr_pages);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -2525,7 +2641,7 @@ static void drain_local_stock(struct work_struct *dummy)
 
 	stock = this_cpu_ptr(&memcg_stock);
 	old = drain_obj_stock(stock);
-	drain_stock(stock);
+	drain_stock_fully(stock);
 	clear_bit(FLUSHING_CACHED_CHARGE, &stock->flags);
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -2534,24 +2650,41 @@ static void drain_local_stock(struct work_struct *dummy)
 
 /*
  * Cache charges(val) to local per_cpu area.
- * This will be consumed by consume_stock() function, later.
+ * This will be consumed by consume_stock() function, later.  If all slots
+ * are taken by other memcgs, the least recently refilled one is drained.
  */
 static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock;
 	unsigned int stock_pages;
+	int i, empty = -1;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (READ_ONCE(stock->cached) != memcg) { /* reset if necessary */
-		drain_stock(stock);
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		struct mem_cgroup *cached = READ_ONCE(stock->cached[i]);
+
+		if (cached == memcg)
+			break;
+		if (!cached && empty < 0)
+			empty = i;
+	}
+	if (i == NR_MEMCG_STOCK) {
+		if (empty < 0) {
+			empty = NR_MEMCG_STOCK - 1;
+			drain_stock(stock, empty);
+		}
 		css_get(&memcg->css);
-		WRITE_ONCE(stock->cached, memcg);
+		WRITE_ONCE(stock->cached[empty], memcg);
+		i = empty;
 	}
-	stock_pages = READ_ONCE(stock->nr_pages) + nr_pages;
-	WRITE_ONCE(stock->nr_pages, stock_pages);
+	if (i)
+		rotate_stock(stock, i);
+
+	stock_pages = READ_ONCE(stock->nr_pages[0]) + nr_pages;
+	WRITE_ONCE(stock->nr_pages[0], stock_pages);
 
 	if (stock_pages > MEMCG_CHARGE_BATCH)
-		drain_stock(stock);
+		drain_stock(stock, 0);
 }
 
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
@@ -2586,13 +2719,18 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
 		bool flush = false;
+		int i;
 
 		rcu_read_lock();
-		memcg = READ_ONCE(stock->cached);
-		if (memcg && READ_ONCE(stock->nr_pages) &&
-		    mem_cgroup_is_descendant(memcg, root_memcg))
-			flush = true;
-		else if (obj_stock_flush_required(stock, root_memcg))
+		for (i = 0; i < NR_MEMCG_STOCK; i++) {
+			memcg = READ_ONCE(stock->cached[i]);
+			if (memcg && READ_ONCE(stock->nr_pages[i]) &&
+			    mem_cgroup_is_descendant(memcg, root_memcg)) {
+				flush = true;
+				break;
+			}
+		}
+		if (!flush && obj_stock_flush_required(stock, root_memcg))
 			flush = true;
 		rcu_read_unlock();
 
@@ -2613,7 +2751,7 @@ static int memcg_hotplug_cpu_dead(unsigned int cpu)
 	struct memcg_stock_pcp *stock;
 
 	stock = &per_cpu(memcg_stock, cpu);
-	drain_stock(stock);
+	drain_stock_fully(stock);
 
 	return 0;
 }
@@ -3726,10 +3864,11 @@ static inline size_t obj_full_size(struct kmem_cache *s)
 bool __memcg_slab_post_alloc_hook(struct kmem_cache *s, struct list_lru *lru,
 				  gfp_t flags, size_t size, void **p)
 {
+	struct pglist_data *pgdat = NULL;
 	struct obj_cgroup *objcg;
 	struct slab *slab;
 	unsigned long off;
-	size_t i;
+	size_t i, nr = 0, nr_charged = 0;
 
 	/*
 	 * The obtained objcg pointer is safe to use within the current scope,
@@ -3776,18 +3915,45 @@ bool __memcg_slab_post_alloc_hook(struct kmem_cache *s, struct list_lru *lru,
 		}
 
 		off = obj_to_index(s, slab, p[i]);
-		obj_cgroup_get(objcg);
 		slab_obj_exts(slab)[off].objcg = objcg;
-		mod_objcg_state(objcg, slab_pgdat(slab),
-				cache_vmstat_idx(s), obj_full_size(s));
+
+		/* Update the stats once per run of objects on the same node */
+		if (slab_pgdat(slab) != pgdat) {
+			if (nr)
+				mod_objcg_state(objcg, pgdat, cache_vmstat_idx(s),
+						nr * obj_full_size(s));
+			pgdat = slab_pgdat(slab);
+			nr = 0;
+		}
+		nr++;
+		nr_charged++;
 	}
 
+	if (nr)
+		mod_objcg_state(objcg, pgdat, cache_vmstat_idx(s),
+				nr * obj_full_size(s));
+	if (nr_charged)
+		obj_cgroup_get_many(objcg, nr_charged);
+
 	return true;
 }
 
+static void memcg_slab_uncharge_objs(struct kmem_cache *s, struct slab *slab,
+				     struct obj_cgroup *objcg, int nr)
+{
+	obj_cgroup_uncharge(objcg, nr * obj_full_size(s));
+	mod_objcg_state(objcg, slab_pgdat(slab), cache_vmstat_idx(s),
+			-nr * obj_full_size(s));
+	percpu_ref_put_many(&objcg->refcnt, nr);
+}
+
 void __memcg_slab_free_hook(struct kmem_cache *s, struct slab *slab,
 			    void **p, int objects, struct slabobj_ext *obj_exts)
 {
+	struct obj_cgroup *batch = NULL;
+	int nr = 0;
+
+	/* Uncharge runs of objects of the same objcg at once */
 	for (int i = 0; i < objects; i++) {
 		struct obj_cgroup *objcg;
 		unsigned int off;
@@ -3798,11 +3964,16 @@ void __memcg_slab_free_hook(struct kmem_cache *s, struct slab *slab,
 			continue;
 
 		obj_exts[off].objcg = NULL;
-		obj_cgroup_uncharge(objcg, obj_full_size(s));
-		mod_objcg_state(objcg, slab_pgdat(slab), cache_vmstat_idx(s),
-				-obj_full_size(s));
-		obj_cgroup_put(objcg);
+		if (objcg != batch) {
+			if (batch)
+				memcg_slab_uncharge_objs(s, slab, batch, nr);
+			batch = objcg;
+			nr = 0;
+		}
+		nr++;
 	}
+	if (batch)
+		memcg_slab_uncharge_objs(s, slab, batch, nr);
 }
 #endif /* CONFIG_MEMCG_KMEM */
 
@@ -5684,6 +5855,7 @@ static void __mem_cgroup_free(struct mem_cgroup *memcg)
 		free_mem_cgroup_per_node_info(memcg, node);
 	kfree(memcg->vmstats);
 	free_percpu(memcg->vmstats_percpu);
+	free_percpu(memcg->fault_latency);
 	kfree(memcg);
 }
 
@@ -5723,6 +5895,13 @@ static struct mem_cgroup *mem_cgroup_alloc(struct mem_cgroup *parent)
 	if (!memcg->vmstats_percpu)
 		goto fail;
 
+	if (cgroup_memory_fault_latency) {
+		memcg->fault_latency = alloc_percpu_gfp(struct memcg_fault_latency,
+							GFP_KERNEL_ACCOUNT);
+		if (!memcg->fault_latency)
+			goto fail;
+	}
+
 	for_each_possible_cpu(cpu) {
 		if (parent)
 			pstatc = per_cpu_ptr(parent->vmstats_percpu, cpu);
@@ -7110,6 +7289,85 @@ static int memory_stat_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+void __mem_cgroup_account_fault_latency(struct mm_struct *mm, bool anon,
+		unsigned int flags, vm_fault_t ret, u64 start)
+{
+	struct memcg_fault_latency __percpu *fl;
+	struct mem_cgroup *memcg;
+	u64 us = (ktime_get_ns() - start) / NSEC_PER_USEC;
+	int bucket = min_t(int, fls64(us), MEMCG_FAULT_LATENCY_BUCKETS - 1);
+
+	if (mem_cgroup_disabled() || (ret & VM_FAULT_ERROR))
+		return;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(rcu_dereference(mm->owner));
+	if (unlikely(!memcg || !memcg->fault_latency))
+		goto out;
+	fl = memcg->fault_latency;
+
+	if (ret & VM_FAULT_RETRY) {
+		this_cpu_inc(fl->count[MEMCG_FAULT_RETRY][bucket]);
+		goto out;
+	}
+	if ((ret & VM_FAULT_MAJOR) || (flags & FAULT_FLAG_TRIED))
+		this_cpu_inc(fl->count[MEMCG_FAULT_MAJOR][bucket]);
+	else
+		this_cpu_inc(fl->count[MEMCG_FAULT_MINOR][bucket]);
+	if (anon)
+		this_cpu_inc(fl->count[MEMCG_FAULT_ANON][bucket]);
+	else
+		this_cpu_inc(fl->count[MEMCG_FAULT_FILE][bucket]);
+	if (flags & FAULT_FLAG_WRITE)
+		this_cpu_inc(fl->count[MEMCG_FAULT_WRITE][bucket]);
+out:
+	rcu_read_unlock();
+}
+
+static int memory_fault_latency_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	struct mem_cgroup *iter;
+	u64 *sum;
+	int type, i, cpu;
+
+	if (!memcg->fault_latency)
+		return -EOPNOTSUPP;
+
+	sum = kcalloc(NR_MEMCG_FAULT_TYPES * MEMCG_FAULT_LATENCY_BUCKETS,
+		      sizeof(*sum), GFP_KERNEL);
+	if (!sum)
+		return -ENOMEM;
+
+	/* Hierarchical, like memory.stat */
+	for_each_mem_cgroup_tree(iter, memcg) {
+		for_each_possible_cpu(cpu) {
+			struct memcg_fault_latency *fl;
+
+			fl = per_cpu_ptr(iter->fault_latency, cpu);
+			for (type = 0; type < NR_MEMCG_FAULT_TYPES; type++)
+				for (i = 0; i < MEMCG_FAULT_LATENCY_BUCKETS; i++)
+					sum[type * MEMCG_FAULT_LATENCY_BUCKETS + i] +=
+						fl->count[type][i];
+		}
+	}
+
+	seq_puts(m, "le_us");
+	for (i = 0; i < MEMCG_FAULT_LATENCY_BUCKETS - 1; i++)
+		seq_printf(m, " %lu", 1UL << i);
+	seq_puts(m, " inf\n");
+	for (type = 0; type < NR_MEMCG_FAULT_TYPES; type++) {
+		seq_puts(m, memcg_fault_type_names[type]);
+		for (i = 0; i < MEMCG_FAULT_LATENCY_BUCKETS; i++)
+			seq_printf(m, " %llu",
+				   sum[type * MEMCG_FAULT_LATENCY_BUCKETS + i]);
+		seq_putc(m, '\n');
+	}
+
+	kfree(sum);
+	return 0;
+}
+
 #ifdef CONFIG_NUMA
 static inline unsigned long lruvec_page_state_output(struct lruvec *lruvec,
 						     int item)
@@ -7222,6 +7480,43 @@ static ssize_t memory_reclaim(struct kernfs_open_file *of, char *buf,
 	return nbytes;
 }
 
+#ifdef CONFIG_LRU_GEN
+static int memory_lru_gen_aging_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+
+	seq_printf(m, "%u\n", READ_ONCE(memcg->lru_gen_aging_ms));
+
+	return 0;
+}
+
+static ssize_t memory_lru_gen_aging_write(struct kernfs_open_file *of,
+					  char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned int msecs;
+	int err;
+
+	err = kstrtouint(strstrip(buf), 0, &msecs);
+	if (err)
+		return err;
+
+	err = lru_gen_set_aging_interval(memcg, msecs);
+	if (err)
+		return err;
+
+	return nbytes;
+}
+
+static u64 memory_lru_gen_wss_read(struct cgroup_subsys_state *css,
+				   struct cftype *cft)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(css);
+
+	return (u64)lru_gen_memcg_wss(memcg) * PAGE_SIZE;
+}
+#endif
+
 static struct cftype memory_files[] = {
 	{
 		.name = "current",
@@ -7273,6 +7568,10 @@ static struct cftype memory_files[] = {
 		.name = "stat",
 		.seq_show = memory_stat_show,
 	},
+	{
+		.name = "fault_latency",
+		.seq_show = memory_fault_latency_show,
+	},
 #ifdef CONFIG_NUMA
 	{
 		.name = "numa_stat",
@@ -7290,6 +7589,19 @@ static struct cftype memory_files[] = {
 		.flags = CFTYPE_NS_DELEGATABLE,
 		.write = memory_reclaim,
 	},
+#ifdef CONFIG_LRU_GEN
+	{
+		.name = "lru_gen.aging_ms",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_lru_gen_aging_show,
+		.write = memory_lru_gen_aging_write,
+	},
+	{
+		.name = "lru_gen.wss",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = memory_lru_gen_wss_read,
+	},
+#endif
 	{ }	/* terminate */
 };
 
@@ -7584,15 +7896,14 @@ int mem_cgroup_swapin_charge_folio(struct folio *folio, struct mm_struct *mm,
 }
 
 /*
- * mem_cgroup_swapin_uncharge_swap - uncharge swap slot
- * @entry: swap entry for which the page is charged
+ * mem_cgroup_swapin_uncharge_swap - uncharge swap slots
+ * @entry: first swap entry for which the folio is charged
+ * @nr_pages: number of contiguous swap slots backing the folio
  *
- * Call this function after successfully adding the charged page to swapcache.
- *
- * Note: This function assumes the page for which swap slot is being uncharged
- * is order 0 page.
+ * Call this function after successfully adding the charged folio to swapcache,
+ * or after charging a folio that bypasses the swapcache.
  */
-void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry)
+void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry, unsigned int nr_pages)
 {
 	/*
 	 * Cgroup1's unified memory+swap counter has been charged with the
@@ -7612,7 +7923,7 @@ void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry)
 		 * let's not wait for it.  The page already received a
 		 * memory+swap charge, drop the swap entry duplicate.
 		 */
-		mem_cgroup_uncharge_swap(entry, 1);
+		mem_cgroup_uncharge_swap(entry, nr_pages);
 	}
 }
 
@@ -7934,6 +8245,8 @@ static int __init cgroup_memory(char *s)
 			cgroup_memory_nokmem = true;
 		if (!strcmp(token, "nobpf"))
 			cgroup_memory_nobpf = true;
+		if (!strcmp(token, "faultlatency"))
+			cgroup_memory_fault_latency = true;
 	}
 	return 1;
 }
@@ -7959,6 +8272,9 @@ static int __init mem_cgroup_init(void)
 	 */
 	BUILD_BUG_ON(MEMCG_CHARGE_BATCH > S32_MAX / PAGE_SIZE);
 
+	if (cgroup_memory_fault_latency)
+		static_branch_enable(&memcg_fault_latency_key);
+
 	cpuhp_setup_state_nocalls(CPUHP_MM_MEMCQ_DEAD, "mm/memctrl:dead", NULL,
 				  memcg_hotplug_cpu_dead);
 
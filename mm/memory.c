@@ -78,8 +78,10 @@
 #include <linux/ptrace.h>
 #include <linux/vmalloc.h>
 #include <linux/sched/sysctl.h>
+#include <linux/zswap.h>
 
 #include <trace/events/kmem.h>
+#include <trace/events/mmap.h>
 
 #include <asm/io.h>
 #include <asm/mmu_context.h>
@@ -843,6 +845,8 @@ copy_nonpresent_pte(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 		 */
 		folio_get(folio);
 		rss[mm_counter(folio)]++;
+		if (folio_test_large(folio))
+			rss[MM_LARGEPAGES]++;
 		/* Cannot fail as these pages cannot get pinned. */
 		folio_try_dup_anon_rmap_pte(folio, page, src_vma);
 
@@ -1005,6 +1009,7 @@ copy_present_ptes(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma
 			folio_dup_file_rmap_ptes(folio, page, nr);
 			rss[mm_counter_file(folio)] += nr;
 		}
+		rss[MM_LARGEPAGES] += nr;
 		if (any_writable)
 			pte = pte_mkwrite(pte, src_vma);
 		__copy_present_ptes(dst_vma, src_vma, dst_pte, src_pte, pte,
@@ -1033,6 +1038,8 @@ copy_present_ptes(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma
 		folio_dup_file_rmap_pte(folio, page);
 		rss[mm_counter_file(folio)]++;
 	}
+	if (folio_test_large(folio))
+		rss[MM_LARGEPAGES]++;
 
 copy_pte:
 	__copy_present_ptes(dst_vma, src_vma, dst_pte, src_pte, pte, addr, 1);
@@ -1687,13 +1694,113 @@ static unsigned long zap_pte_range(struct mmu_gather *tlb,
 	return addr;
 }
 
+#ifdef CONFIG_PT_RECLAIM
+/* Empty PTE tables are freed in batches of this many, after one TLB flush */
+#define ZAP_PT_RECLAIM_BATCH	32
+
+struct zap_pt_reclaim {
+	pgtable_t tables[ZAP_PT_RECLAIM_BATCH];
+	int nr;
+};
+
+static inline void zap_pt_reclaim_init(struct zap_pt_reclaim *pr)
+{
+	pr->nr = 0;
+}
+
+static void zap_free_empty_ptes(struct mmu_gather *tlb,
+				struct zap_pt_reclaim *pr)
+{
+	int i;
+
+	if (!pr->nr)
+		return;
+
+	/*
+	 * Flush the paging-structure caches before the tables can be reused.
+	 * Lockless walkers are kept away by freeing the tables through RCU.
+	 */
+	tlb_flush_mmu_tlbonly(tlb);
+	for (i = 0; i < pr->nr; i++)
+		pte_free_defer(tlb->mm, pr->tables[i]);
+	pr->nr = 0;
+}
+
+/*
+ * Unhook the PTE table mapping [@addr, @addr + PMD_SIZE) from @pmd if all of
+ * its entries are none, like retract_page_tables() does for file THPs.  Page
+ * table walkers recheck *pmd under the PTE lock and back off.
+ */
+static void zap_try_reclaim_pte(struct mmu_gather *tlb, pmd_t *pmd,
+				unsigned long addr, struct zap_pt_reclaim *pr)
+{
+	struct mm_struct *mm = tlb->mm;
+	spinlock_t *pml, *ptl;
+	pte_t *start_pte, *pte;
+	pmd_t pmdval;
+	int i;
+
+	pml = pmd_lock(mm, pmd);
+	start_pte = pte_offset_map_nolock(mm, pmd, addr, &ptl);
+	if (!start_pte) {
+		spin_unlock(pml);
+		return;
+	}
+	if (ptl != pml)
+		spin_lock_nested(ptl, SINGLE_DEPTH_NESTING);
+
+	for (i = 0, pte = start_pte; i < PTRS_PER_PTE; i++, pte++) {
+		if (!pte_none(ptep_get(pte)))
+			goto out;
+	}
+
+	pmdval = pmdp_get(pmd);
+	pmd_clear(pmd);
+	mm_dec_nr_ptes(mm);
+	tlb_flush_pmd_range(tlb, addr, PMD_SIZE);
+	tlb->freed_tables = 1;
+	pr->tables[pr->nr++] = pmd_pgtable(pmdval);
+out:
+	pte_unmap(start_pte);
+	if (ptl != pml)
+		spin_unlock(ptl);
+	spin_unlock(pml);
+
+	if (pr->nr == ZAP_PT_RECLAIM_BATCH)
+		zap_free_empty_ptes(tlb, pr);
+}
+#else
+struct zap_pt_reclaim {
+};
+
+static inline void zap_pt_reclaim_init(struct zap_pt_reclaim *pr)
+{
+}
+
+static inline void zap_free_empty_ptes(struct mmu_gather *tlb,
+				       struct zap_pt_reclaim *pr)
+{
+}
+
+static inline void zap_try_reclaim_pte(struct mmu_gather *tlb, pmd_t *pmd,
+				unsigned long addr, struct zap_pt_reclaim *pr)
+{
+}
+#endif /* CONFIG_PT_RECLAIM */
+
 static inline unsigned long zap_pmd_range(struct mmu_gather *tlb,
 				struct vm_area_struct *vma, pud_t *pud,
 				unsigned long addr, unsigned long end,
 				struct zap_details *details)
 {
+	bool reclaim_pt = details && details->reclaim_pt &&
+			  IS_ENABLED(CONFIG_PT_RECLAIM);
+	struct zap_pt_reclaim pr;
 	pmd_t *pmd;
-	unsigned long next;
+	unsigned long next, start;
+
+	if (reclaim_pt)
+		zap_pt_reclaim_init(&pr);
 
 	pmd = pmd_offset(pud, addr);
 	do {
@@ -1721,11 +1828,17 @@ static inline unsigned long zap_pmd_range(struct mmu_gather *tlb,
 			addr = next;
 			continue;
 		}
+		start = addr;
 		addr = zap_pte_range(tlb, vma, pmd, addr, next, details);
 		if (addr != next)
 			pmd--;
+		else if (reclaim_pt && next - start == PMD_SIZE)
+			zap_try_reclaim_pte(tlb, pmd, start, &pr);
 	} while (pmd++, cond_resched(), addr != end);
 
+	if (reclaim_pt)
+		zap_free_empty_ptes(tlb, &pr);
+
 	return addr;
 }
 
@@ -3936,6 +4049,126 @@ static vm_fault_t handle_pte_marker(struct vm_fault *vmf)
 	return VM_FAULT_SIGBUS;
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Check whether the @nr_pages swap ptes starting at @ptep can be read back
+ * into a single large folio bypassing the swapcache: they must map aligned,
+ * contiguous entries that are exclusively ours (swap count of one, not in
+ * the swapcache), and zswap must hold either all of them or none.
+ */
+static bool can_swapin_thp(struct vm_fault *vmf, pte_t *ptep, int nr_pages)
+{
+	struct swap_info_struct *si;
+	swp_entry_t entry;
+	pgoff_t offset;
+	pte_t pte;
+	int i, nr;
+
+	pte = ptep_get(ptep);
+	if (!is_swap_pte(pte))
+		return false;
+	entry = pte_to_swp_entry(pte);
+	if (non_swap_entry(entry) ||
+	    swp_type(entry) != swp_type(pte_to_swp_entry(vmf->orig_pte)))
+		return false;
+	offset = swp_offset(entry);
+	if (!IS_ALIGNED(offset, nr_pages))
+		return false;
+	if (swap_pte_batch(ptep, nr_pages, pte) != nr_pages)
+		return false;
+
+	si = swp_swap_info(entry);
+	for (i = 0; i < nr_pages; i++) {
+		if (data_race(si->swap_map[offset + i]) != 1)
+			return false;
+	}
+
+	nr = zswap_present_nr(entry, nr_pages);
+	return !nr || nr == nr_pages;
+}
+#endif
+
+/*
+ * Allocate and charge the folio to read a swap entry into when bypassing
+ * the swapcache on SWP_SYNCHRONOUS_IO devices. Like alloc_anon_folio(),
+ * try the largest enabled order whose aligned range can be swapped in as
+ * a whole, and fall back to a single page otherwise.
+ */
+static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	swp_entry_t entry = pte_to_swp_entry(vmf->orig_pte);
+	struct folio *folio;
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	unsigned long orders;
+	unsigned long addr;
+	pte_t *pte;
+	gfp_t gfp;
+	int order;
+
+	/*
+	 * If uffd is active for the vma we need per-page fault fidelity to
+	 * maintain the uffd semantics.
+	 */
+	if (unlikely(userfaultfd_armed(vma)))
+		goto fallback;
+
+	orders = thp_vma_allowable_orders(vma, vma->vm_flags,
+			TVA_IN_PF | TVA_ENFORCE_SYSFS, BIT(PMD_ORDER) - 1);
+	orders = thp_vma_suitable_orders(vma, vmf->address, orders);
+
+	if (!orders)
+		goto fallback;
+
+	pte = pte_offset_map(vmf->pmd, vmf->address & PMD_MASK);
+	if (unlikely(!pte))
+		goto fallback;
+
+	/*
+	 * Find the highest order whose aligned range can be swapped in as a
+	 * whole. All remaining orders then qualify as well.
+	 */
+	order = highest_order(orders);
+	while (orders) {
+		addr = ALIGN_DOWN(vmf->address, PAGE_SIZE << order);
+		if (can_swapin_thp(vmf, pte + pte_index(addr), 1 << order))
+			break;
+		order = next_order(&orders, order);
+	}
+
+	pte_unmap(pte);
+
+	if (!orders)
+		goto fallback;
+
+	gfp = vma_thp_gfp_mask(vma);
+	while (orders) {
+		swp_entry_t aligned;
+
+		addr = ALIGN_DOWN(vmf->address, PAGE_SIZE << order);
+		aligned.val = ALIGN_DOWN(entry.val, 1 << order);
+		folio = vma_alloc_folio(gfp, order, vma, addr, true);
+		if (folio) {
+			if (!mem_cgroup_swapin_charge_folio(folio, vma->vm_mm,
+							    gfp, aligned))
+				return folio;
+			folio_put(folio);
+		}
+		order = next_order(&orders, order);
+	}
+
+fallback:
+#endif
+	folio = vma_alloc_folio(GFP_HIGHUSER_MOVABLE, 0, vma, vmf->address,
+				false);
+	if (folio && mem_cgroup_swapin_charge_folio(folio, vma->vm_mm,
+						    GFP_KERNEL, entry)) {
+		folio_put(folio);
+		folio = NULL;
+	}
+	return folio;
+}
+
 /*
  * We enter with non-exclusive mmap_lock (to exclude vma changes,
  * but allow concurrent faults), and pte mapped but not yet locked.
@@ -3957,6 +4190,9 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	pte_t pte;
 	vm_fault_t ret = 0;
 	void *shadow = NULL;
+	int nr_pages = 1;
+	unsigned long address = vmf->address;
+	pte_t *ptep;
 
 	if (!pte_unmap_same(vmf))
 		goto out;
@@ -4020,35 +4256,39 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	if (!folio) {
 		if (data_race(si->flags & SWP_SYNCHRONOUS_IO) &&
 		    __swap_count(entry) == 1) {
-			/*
-			 * Prevent parallel swapin from proceeding with
-			 * the cache flag. Otherwise, another thread may
-			 * finish swapin first, free the entry, and swapout
-			 * reusing the same entry. It's undetectable as
-			 * pte_same() returns true due to entry reuse.
-			 */
-			if (swapcache_prepare(entry)) {
-				/* Relax a bit to prevent rapid repeated page faults */
-				schedule_timeout_uninterruptible(1);
-				goto out;
-			}
-			need_clear_cache = true;
-
 			/* skip swapcache */
-			folio = vma_alloc_folio(GFP_HIGHUSER_MOVABLE, 0,
-						vma, vmf->address, false);
-			page = &folio->page;
+			folio = alloc_swap_folio(vmf);
 			if (folio) {
 				__folio_set_locked(folio);
 				__folio_set_swapbacked(folio);
 
-				if (mem_cgroup_swapin_charge_folio(folio,
-							vma->vm_mm, GFP_KERNEL,
-							entry)) {
-					ret = VM_FAULT_OOM;
+				nr_pages = folio_nr_pages(folio);
+				if (folio_test_large(folio)) {
+					entry.val = ALIGN_DOWN(entry.val, nr_pages);
+					address = ALIGN_DOWN(vmf->address,
+							     nr_pages * PAGE_SIZE);
+				}
+				page = folio_page(folio, 0);
+
+				/*
+				 * Prevent parallel swapin from proceeding with
+				 * the cache flag. Otherwise, another thread may
+				 * finish swapin first, free the entry, and
+				 * swapout reusing the same entry. It's
+				 * undetectable as pte_same() returns true due
+				 * to entry reuse.
+				 */
+				if (swapcache_prepare_nr(entry, nr_pages)) {
+					/*
+					 * Relax a bit to prevent rapid
+					 * repeated page faults.
+					 */
+					schedule_timeout_uninterruptible(1);
 					goto out_page;
 				}
-				mem_cgroup_swapin_uncharge_swap(entry);
+				need_clear_cache = true;
+
+				mem_cgroup_swapin_uncharge_swap(entry, nr_pages);
 
 				shadow = get_shadow_from_swap_cache(entry);
 				if (shadow)
@@ -4150,6 +4390,23 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	if (unlikely(!vmf->pte || !pte_same(ptep_get(vmf->pte), vmf->orig_pte)))
 		goto out_nomap;
 
+	ptep = vmf->pte;
+	if (folio_test_large(folio) && !folio_test_swapcache(folio)) {
+		/*
+		 * A large folio read from swap bypassing the swapcache:
+		 * recheck that the whole range still maps the entries it
+		 * was read from.
+		 */
+		pte_t folio_pte;
+
+		ptep = vmf->pte - (vmf->address - address) / PAGE_SIZE;
+		folio_pte = ptep_get(ptep);
+		if (!is_swap_pte(folio_pte) ||
+		    pte_to_swp_entry(folio_pte).val != entry.val ||
+		    swap_pte_batch(ptep, nr_pages, folio_pte) != nr_pages)
+			goto out_nomap;
+	}
+
 	if (unlikely(!folio_test_uptodate(folio))) {
 		ret = VM_FAULT_SIGBUS;
 		goto out_nomap;
@@ -4214,12 +4471,12 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	 * We're already holding a reference on the page but haven't mapped it
 	 * yet.
 	 */
-	swap_free(entry);
+	swap_free_nr(entry, nr_pages);
 	if (should_try_to_free_swap(folio, vma, vmf->flags))
 		folio_free_swap(folio);
 
-	inc_mm_counter(vma->vm_mm, MM_ANONPAGES);
-	dec_mm_counter(vma->vm_mm, MM_SWAPENTS);
+	add_mm_counter(vma->vm_mm, MM_ANONPAGES, nr_pages);
+	add_mm_counter(vma->vm_mm, MM_SWAPENTS, -nr_pages);
 	pte = mk_pte(page, vma->vm_page_prot);
 
 	/*
@@ -4236,17 +4493,21 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 		}
 		rmap_flags |= RMAP_EXCLUSIVE;
 	}
-	flush_icache_page(vma, page);
+	flush_icache_pages(vma, page, nr_pages);
 	if (pte_swp_soft_dirty(vmf->orig_pte))
 		pte = pte_mksoft_dirty(pte);
 	if (pte_swp_uffd_wp(vmf->orig_pte))
 		pte = pte_mkuffd_wp(pte);
-	vmf->orig_pte = pte;
+	vmf->orig_pte = pte_advance_pfn(pte, (vmf->address - address) / PAGE_SIZE);
 
 	/* ksm created a completely new copy */
 	if (unlikely(folio != swapcache && swapcache)) {
 		folio_add_new_anon_rmap(folio, vma, vmf->address);
 		folio_add_lru_vma(folio, vma);
+	} else if (folio_test_large(folio) && !swapcache) {
+		/* fresh large folio read bypassing the swapcache */
+		folio_add_new_anon_rmap(folio, vma, address);
+		count_mthp_stat(folio_order(folio), MTHP_STAT_SWPIN);
 	} else {
 		folio_add_anon_rmap_pte(folio, page, vma, vmf->address,
 					rmap_flags);
@@ -4254,7 +4515,7 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 
 	VM_BUG_ON(!folio_test_anon(folio) ||
 			(pte_write(pte) && !PageAnonExclusive(page)));
-	set_pte_at(vma->vm_mm, vmf->address, vmf->pte, pte);
+	set_ptes(vma->vm_mm, address, ptep, pte, nr_pages);
 	arch_do_swap_page(vma->vm_mm, vma, vmf->address, pte, vmf->orig_pte);
 
 	folio_unlock(folio);
@@ -4279,14 +4540,14 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	}
 
 	/* No need to invalidate - it was non-present before */
-	update_mmu_cache_range(vmf, vma, vmf->address, vmf->pte, 1);
+	update_mmu_cache_range(vmf, vma, address, ptep, nr_pages);
 unlock:
 	if (vmf->pte)
 		pte_unmap_unlock(vmf->pte, vmf->ptl);
 out:
 	/* Clear the swap cache pin for direct swapin after PTL unlock */
 	if (need_clear_cache)
-		swapcache_clear(si, entry);
+		swapcache_clear(si, entry, nr_pages);
 	if (si)
 		put_swap_device(si);
 	return ret;
@@ -4302,7 +4563,7 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 		folio_put(swapcache);
 	}
 	if (need_clear_cache)
-		swapcache_clear(si, entry);
+		swapcache_clear(si, entry, nr_pages);
 	if (si)
 		put_swap_device(si);
 	return ret;
@@ -4320,6 +4581,120 @@ static bool pte_range_none(pte_t *pte, int nr_pages)
 	return true;
 }
 
+static unsigned long fault_around_pages __read_mostly =
+	65536 >> PAGE_SHIFT;
+
+/*
+ * Anonymous fault-around: on a private anonymous mapping marked with
+ * MADV_SEQUENTIAL, a write fault served by a single page also populates the
+ * empty PTEs following it, up to fault_around_bytes. The extra pages are
+ * allocated and zeroed before the PTE lock is taken, and are then mapped
+ * together with the faulting page.
+ */
+static inline bool should_anon_fault_around(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+
+	if (!(vma->vm_flags & VM_SEQ_READ) || !(vmf->flags & FAULT_FLAG_WRITE))
+		return false;
+
+	if (userfaultfd_armed(vma))
+		return false;
+
+	/* A single page implies no faulting 'around' at all. */
+	return READ_ONCE(fault_around_pages) > 1;
+}
+
+static void anon_fault_around_alloc(struct vm_fault *vmf,
+				    struct list_head *folios)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	unsigned long addr = vmf->address & PAGE_MASK;
+	unsigned long end = addr + (READ_ONCE(fault_around_pages) << PAGE_SHIFT);
+	gfp_t gfp = GFP_HIGHUSER_MOVABLE | __GFP_NORETRY | __GFP_NOWARN;
+	unsigned int i, nr;
+	struct folio *folio;
+	pte_t *pte;
+
+	/* Don't cross VMA or page table boundaries. */
+	end = min(end, pmd_addr_end(addr, vma->vm_end));
+
+	/* Only populate up to the next PTE that is already in use. */
+	pte = pte_offset_map(vmf->pmd, addr);
+	if (!pte)
+		return;
+	for (nr = 0; addr + (nr + 1) * PAGE_SIZE < end; nr++) {
+		if (!pte_none(ptep_get_lockless(pte + nr + 1)))
+			break;
+	}
+	pte_unmap(pte);
+
+	for (i = 1; i <= nr; i++) {
+		unsigned long vaddr = addr + i * PAGE_SIZE;
+
+		folio = vma_alloc_folio(gfp, 0, vma, vaddr, false);
+		if (!folio)
+			break;
+		if (mem_cgroup_charge(folio, vma->vm_mm, gfp)) {
+			folio_put(folio);
+			break;
+		}
+		folio_throttle_swaprate(folio, gfp);
+		clear_user_highpage(&folio->page, vaddr);
+		__folio_mark_uptodate(folio);
+		list_add_tail(&folio->lru, folios);
+	}
+}
+
+/*
+ * Map the folios preallocated by anon_fault_around_alloc() into the PTEs
+ * following @addr, which must be mapped and locked in vmf->pte. Stops at the
+ * first PTE that got populated in the meantime.
+ */
+static void anon_fault_around_map(struct vm_fault *vmf, unsigned long addr,
+				  struct list_head *folios)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct folio *folio, *tmp;
+	pte_t *pte = vmf->pte;
+	int nr = 0;
+
+	list_for_each_entry_safe(folio, tmp, folios, lru) {
+		pte_t entry;
+
+		addr += PAGE_SIZE;
+		pte++;
+		if (!pte_none(ptep_get(pte)))
+			break;
+
+		list_del(&folio->lru);
+		entry = mk_pte(&folio->page, vma->vm_page_prot);
+		if (arch_wants_old_prefaulted_pte())
+			entry = pte_mkold(entry);
+		else
+			entry = pte_sw_mkyoung(entry);
+		if (vma->vm_flags & VM_WRITE)
+			entry = pte_mkwrite(pte_mkdirty(entry), vma);
+
+		folio_add_new_anon_rmap(folio, vma, addr);
+		folio_add_lru_vma(folio, vma);
+		set_pte_at(vma->vm_mm, addr, pte, entry);
+		update_mmu_cache_range(NULL, vma, addr, pte, 1);
+		nr++;
+	}
+	add_mm_counter(vma->vm_mm, MM_ANONPAGES, nr);
+}
+
+static void anon_fault_around_free(struct list_head *folios)
+{
+	struct folio *folio, *tmp;
+
+	list_for_each_entry_safe(folio, tmp, folios, lru) {
+		list_del(&folio->lru);
+		folio_put(folio);
+	}
+}
+
 static struct folio *alloc_anon_folio(struct vm_fault *vmf)
 {
 	struct vm_area_struct *vma = vmf->vma;
@@ -4406,6 +4781,7 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 {
 	struct vm_area_struct *vma = vmf->vma;
 	unsigned long addr = vmf->address;
+	LIST_HEAD(around);
 	struct folio *folio;
 	vm_fault_t ret = 0;
 	int nr_pages = 1;
@@ -4461,6 +4837,9 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 	nr_pages = folio_nr_pages(folio);
 	addr = ALIGN_DOWN(vmf->address, nr_pages * PAGE_SIZE);
 
+	if (nr_pages == 1 && should_anon_fault_around(vmf))
+		anon_fault_around_alloc(vmf, &around);
+
 	/*
 	 * The memory barrier inside __folio_mark_uptodate makes sure that
 	 * preceding stores to the page contents become visible before
@@ -4493,6 +4872,7 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 	if (userfaultfd_missing(vma)) {
 		pte_unmap_unlock(vmf->pte, vmf->ptl);
 		folio_put(folio);
+		anon_fault_around_free(&around);
 		return handle_userfault(vmf, VM_UFFD_MISSING);
 	}
 
@@ -4510,9 +4890,12 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 
 	/* No need to invalidate - it was non-present before */
 	update_mmu_cache_range(vmf, vma, addr, vmf->pte, nr_pages);
+	if (!list_empty(&around))
+		anon_fault_around_map(vmf, addr, &around);
 unlock:
 	if (vmf->pte)
 		pte_unmap_unlock(vmf->pte, vmf->ptl);
+	anon_fault_around_free(&around);
 	return ret;
 release:
 	folio_put(folio);
@@ -4792,9 +5175,6 @@ vm_fault_t finish_fault(struct vm_fault *vmf)
 	return ret;
 }
 
-static unsigned long fault_around_pages __read_mostly =
-	65536 >> PAGE_SHIFT;
-
 #ifdef CONFIG_DEBUG_FS
 static int fault_around_bytes_get(void *data, u64 *val)
 {
@@ -5209,6 +5589,18 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 		folio_put(folio);
 		goto out_map;
 	}
+
+	/* Leave the migration to the destination node, and map it back */
+	if (READ_ONCE(sysctl_numa_balancing_batch_migrate_rate_limit)) {
+		if (migrate_misplaced_folio_queue(folio, vma, target_nid)) {
+			nid = target_nid;
+			flags |= TNF_MIGRATED;
+		} else {
+			flags |= TNF_MIGRATE_FAIL;
+		}
+		goto out_map;
+	}
+
 	pte_unmap_unlock(vmf->pte, vmf->ptl);
 	writable = false;
 	ignore_writable = true;
@@ -5546,8 +5938,10 @@ static inline void mm_account_fault(struct mm_struct *mm, struct pt_regs *regs,
 	bool major;
 
 	/* Incomplete faults will be accounted upon completion. */
-	if (ret & VM_FAULT_RETRY)
+	if (ret & VM_FAULT_RETRY) {
+		trace_mm_fault_retry(mm, address, flags, ret);
 		return;
+	}
 
 	/*
 	 * To preserve the behavior of older kernels, PGFAULT counters record
@@ -5659,6 +6053,8 @@ vm_fault_t handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 {
 	/* If the fault handler drops the mmap_lock, vma may be freed */
 	struct mm_struct *mm = vma->vm_mm;
+	u64 start = mem_cgroup_fault_latency_start();
+	bool anon = vma_is_anonymous(vma);
 	vm_fault_t ret;
 
 	__set_current_state(TASK_RUNNING);
@@ -5703,6 +6099,7 @@ vm_fault_t handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 	}
 out:
 	mm_account_fault(mm, regs, address, flags, ret);
+	mem_cgroup_account_fault_latency(mm, anon, flags, ret, start);
 
 	return ret;
 }
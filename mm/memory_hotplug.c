@@ -738,6 +738,74 @@ static inline void section_taint_zone_device(unsigned long pfn)
 }
 #endif
 
+/*
+ * Initializing the memmap of a large memory block is the bulk of onlining it.
+ * Split it in section aligned pieces handled by unbound workers, preferably
+ * on the CPUs of the node the memory belongs to.
+ */
+#define MEMMAP_INIT_MAX_WORKERS	16
+
+struct memmap_init_work {
+	struct work_struct work;
+	unsigned long start_pfn;
+	unsigned long nr_pages;
+	struct zone *zone;
+	int migratetype;
+};
+
+static void memmap_init_workfn(struct work_struct *work)
+{
+	struct memmap_init_work *mw = container_of(work,
+					struct memmap_init_work, work);
+
+	memmap_init_range(mw->nr_pages, zone_to_nid(mw->zone),
+			  zone_idx(mw->zone), mw->start_pfn, 0,
+			  MEMINIT_HOTPLUG, NULL, mw->migratetype);
+}
+
+static bool memmap_init_hotplug_mt(struct zone *zone, unsigned long start_pfn,
+				   unsigned long nr_pages, int migratetype)
+{
+	unsigned long end_pfn = start_pfn + nr_pages;
+	unsigned long pfn, per_work;
+	struct memmap_init_work *works;
+	int nid = zone_to_nid(zone);
+	int nr_works, nr_cpus, i;
+
+	nr_cpus = cpumask_weight(cpumask_of_node(nid));
+	if (!nr_cpus)
+		nr_cpus = num_online_cpus();
+	nr_works = min3(nr_cpus, MEMMAP_INIT_MAX_WORKERS,
+			(int)DIV_ROUND_UP(nr_pages, PAGES_PER_SECTION));
+	if (nr_works <= 1)
+		return false;
+
+	works = kcalloc(nr_works, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return false;
+
+	/* Keep the workers from racing on it, memmap_init_range() won't update it */
+	if (highest_memmap_pfn < end_pfn - 1)
+		highest_memmap_pfn = end_pfn - 1;
+
+	per_work = roundup(DIV_ROUND_UP(nr_pages, nr_works), PAGES_PER_SECTION);
+	for (i = 0, pfn = start_pfn; i < nr_works && pfn < end_pfn; i++) {
+		works[i].start_pfn = pfn;
+		works[i].nr_pages = min(per_work, end_pfn - pfn);
+		works[i].zone = zone;
+		works[i].migratetype = migratetype;
+		INIT_WORK(&works[i].work, memmap_init_workfn);
+		queue_work_node(nid, system_unbound_wq, &works[i].work);
+		pfn += works[i].nr_pages;
+	}
+	nr_works = i;
+
+	for (i = 0; i < nr_works; i++)
+		flush_work(&works[i].work);
+	kfree(works);
+	return true;
+}
+
 /*
  * Associate the pfn range with the given zone, initializing the memmaps
  * and resizing the pgdat/zone data to span the added pages. After this
@@ -780,8 +848,10 @@ void __ref move_pfn_range_to_zone(struct zone *zone, unsigned long start_pfn,
 	 * expects the zone spans the pfn range. All the pages in the range
 	 * are reserved so nobody should be touching them so we should be safe
 	 */
-	memmap_init_range(nr_pages, nid, zone_idx(zone), start_pfn, 0,
-			 MEMINIT_HOTPLUG, altmap, migratetype);
+	if (zone_is_zone_device(zone) ||
+	    !memmap_init_hotplug_mt(zone, start_pfn, nr_pages, migratetype))
+		memmap_init_range(nr_pages, nid, zone_idx(zone), start_pfn, 0,
+				 MEMINIT_HOTPLUG, altmap, migratetype);
 
 	set_zone_contiguous(zone);
 }
@@ -49,6 +49,8 @@
 #include <linux/memory.h>
 #include <linux/random.h>
 #include <linux/sched/sysctl.h>
+#include <linux/sched/numa_balancing.h>
+#include <linux/sysctl.h>
 #include <linux/memory-tiers.h>
 
 #include <asm/tlbflush.h>
@@ -1172,15 +1174,22 @@ static int migrate_folio_unmap(new_folio_t get_new_folio,
 		old_page_state |= PAGE_WAS_MLOCKED;
 
 	if (folio_test_writeback(src)) {
+		struct address_space *mapping = folio_mapping(src);
+
 		/*
 		 * Only in the case of a full synchronous migration is it
 		 * necessary to wait for PageWriteback. In the async case,
 		 * the retry loop is too short and in the sync-light case,
-		 * the overhead of stalling is too much
+		 * the overhead of stalling is too much.  Never wait for
+		 * writeback that is not guaranteed to complete.
 		 */
 		switch (mode) {
 		case MIGRATE_SYNC:
 		case MIGRATE_SYNC_NO_COPY:
+			if (mapping && mapping_writeback_indeterminate(mapping)) {
+				rc = -EBUSY;
+				goto out;
+			}
 			break;
 		default:
 			rc = -EBUSY;
@@ -1502,6 +1511,174 @@ static inline int try_split_folio(struct folio *folio, struct list_head *split_f
 #define NR_MAX_MIGRATE_SYNC_RETRY					\
 	(NR_MAX_MIGRATE_PAGES_RETRY - NR_MAX_MIGRATE_ASYNC_RETRY)
 
+/*
+ * The copy phase of a batch can be split across this many threads.  The
+ * helpers are work items on migrate_copy_wq, queued on the destination node
+ * of each share, and the migrating task copies the first share itself.
+ * Migration runs on behalf of reclaim and compaction, so the workqueue has a
+ * rescuer.
+ */
+static unsigned int sysctl_migrate_copy_threads __read_mostly = 1;
+static struct workqueue_struct *migrate_copy_wq __ro_after_init;
+
+#define MIGRATE_COPY_MAX_THREADS	16
+/* Don't bother waking a helper thread for less than this many pages */
+#define MIGRATE_COPY_MIN_PAGES		64
+/* Folios of a batch that are considered for the batched copy */
+#define MIGRATE_COPY_MAX_FOLIOS		512
+
+struct migrate_copy_work {
+	struct work_struct work;
+	struct folio **folios;
+	int start, end;
+};
+
+#ifdef CONFIG_SYSCTL
+static unsigned int migrate_copy_max_threads = MIGRATE_COPY_MAX_THREADS;
+
+static struct ctl_table migrate_sysctls[] = {
+	{
+		.procname	= "migrate_copy_threads",
+		.data		= &sysctl_migrate_copy_threads,
+		.maxlen		= sizeof(sysctl_migrate_copy_threads),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &migrate_copy_max_threads,
+	},
+};
+
+static int __init migrate_sysctl_init(void)
+{
+	register_sysctl_init("vm", migrate_sysctls);
+	return 0;
+}
+late_initcall(migrate_sysctl_init);
+#endif
+
+static int __init migrate_copy_init(void)
+{
+	/* Without it, batches are copied by the migrating task alone */
+	migrate_copy_wq = alloc_workqueue("migrate_copy",
+					  WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	return 0;
+}
+subsys_initcall(migrate_copy_init);
+
+static void migrate_copy_folios(struct folio **folios, int start, int end)
+{
+	int i;
+
+	/* folios[] holds src, dst pairs */
+	for (i = start; i < end; i++)
+		folio_copy(folios[2 * i + 1], folios[2 * i]);
+}
+
+static void migrate_copy_work_fn(struct work_struct *work)
+{
+	struct migrate_copy_work *cw = container_of(work,
+			struct migrate_copy_work, work);
+
+	migrate_copy_folios(cw->folios, cw->start, cw->end);
+}
+
+/*
+ * A folio can be copied before move_to_new_folio() only if nobody can modify
+ * it meanwhile: it must be anonymous without swap cache, fully unmapped, and
+ * hold no other references than ours.  folio_migrate_mapping() then rechecks
+ * the reference count, so a reference taken after the copy fails the
+ * migration as usual.
+ */
+static bool migrate_folio_can_precopy(struct folio *src)
+{
+	if (__folio_test_movable(src) || folio_mapping(src))
+		return false;
+	if (folio_mapped(src))
+		return false;
+	return folio_ref_count(src) == folio_expected_refs(NULL, src);
+}
+
+/*
+ * Copy the contents of the folios of an unmapped batch up front, split across
+ * sysctl_migrate_copy_threads threads.  Set the index in @copied of every
+ * folio whose contents have been copied, so that it is moved with
+ * MIGRATE_SYNC_NO_COPY.
+ */
+static void migrate_folios_batch_copy(struct list_head *src_folios,
+		struct list_head *dst_folios, unsigned long *copied)
+{
+	struct migrate_copy_work *works;
+	unsigned int nr_threads = READ_ONCE(sysctl_migrate_copy_threads);
+	unsigned long nr_pages = 0, share, sum;
+	struct folio *src, *dst, **folios;
+	int i = 0, nr = 0, nr_works = 0, start, own_end = 0;
+
+	nr_threads = min(nr_threads, MIGRATE_COPY_MAX_THREADS);
+	if (nr_threads <= 1 || !migrate_copy_wq)
+		return;
+
+	folios = kmalloc_array(2 * MIGRATE_COPY_MAX_FOLIOS, sizeof(*folios),
+			       GFP_NOWAIT | __GFP_NOWARN);
+	if (!folios)
+		return;
+
+	dst = list_first_entry(dst_folios, struct folio, lru);
+	list_for_each_entry(src, src_folios, lru) {
+		if (i >= MIGRATE_COPY_MAX_FOLIOS)
+			break;
+		if (migrate_folio_can_precopy(src)) {
+			__set_bit(i, copied);
+			folios[2 * nr] = src;
+			folios[2 * nr + 1] = dst;
+			nr_pages += folio_nr_pages(src);
+			nr++;
+		}
+		dst = list_next_entry(dst, lru);
+		i++;
+	}
+
+	nr_threads = min_t(unsigned long, nr_threads,
+			   nr_pages / MIGRATE_COPY_MIN_PAGES);
+	works = NULL;
+	if (nr_threads > 1)
+		works = kmalloc_array(nr_threads, sizeof(*works),
+				      GFP_NOWAIT | __GFP_NOWARN);
+	if (!works) {
+		migrate_copy_folios(folios, 0, nr);
+		goto out;
+	}
+
+	/* Split the folios into shares of about the same number of pages */
+	share = DIV_ROUND_UP(nr_pages, nr_threads);
+	for (i = 0, start = 0, sum = 0; i < nr; i++) {
+		sum += folio_nr_pages(folios[2 * i]);
+		if (sum < share && i < nr - 1)
+			continue;
+		if (start) {
+			struct migrate_copy_work *cw = &works[nr_works++];
+
+			INIT_WORK(&cw->work, migrate_copy_work_fn);
+			cw->folios = folios;
+			cw->start = start;
+			cw->end = i + 1;
+			queue_work_node(folio_nid(folios[2 * start + 1]),
+					migrate_copy_wq, &cw->work);
+		} else {
+			/* Copied by ourselves below */
+			own_end = i + 1;
+		}
+		start = i + 1;
+		sum = 0;
+	}
+
+	migrate_copy_folios(folios, 0, own_end);
+	for (i = 0; i < nr_works; i++)
+		flush_work(&works[i].work);
+	kfree(works);
+out:
+	kfree(folios);
+}
+
 struct migrate_pages_stats {
 	int nr_succeeded;	/* Normal and large folios migrated successfully, in
 				   units of base pages */
@@ -1636,6 +1813,8 @@ static int migrate_pages_batch(struct list_head *from,
 	LIST_HEAD(unmap_folios);
 	LIST_HEAD(dst_folios);
 	bool nosplit = (reason == MR_NUMA_MISPLACED);
+	DECLARE_BITMAP(copied, MIGRATE_COPY_MAX_FOLIOS) = { 0 };
+	int i;
 
 	VM_WARN_ON_ONCE(mode != MIGRATE_ASYNC &&
 			!list_empty(from) && !list_is_singular(from));
@@ -1795,22 +1974,32 @@ static int migrate_pages_batch(struct list_head *from,
 	/* Flush TLBs for all unmapped folios */
 	try_to_unmap_flush();
 
+	if (mode != MIGRATE_SYNC_NO_COPY)
+		migrate_folios_batch_copy(&unmap_folios, &dst_folios, copied);
+
 	retry = 1;
 	for (pass = 0; pass < nr_pass && retry; pass++) {
 		retry = 0;
 		thp_retry = 0;
 		nr_retry_pages = 0;
+		i = 0;
 
 		dst = list_first_entry(&dst_folios, struct folio, lru);
 		dst2 = list_next_entry(dst, lru);
 		list_for_each_entry_safe(folio, folio2, &unmap_folios, lru) {
+			/* Folios retried after the first pass are copied again */
+			bool precopied = !pass && i < MIGRATE_COPY_MAX_FOLIOS &&
+					 test_bit(i, copied);
+
 			is_thp = folio_test_large(folio) && folio_test_pmd_mappable(folio);
 			nr_pages = folio_nr_pages(folio);
+			i++;
 
 			cond_resched();
 
 			rc = migrate_folio_move(put_new_folio, private,
-						folio, dst, mode,
+						folio, dst,
+						precopied ? MIGRATE_SYNC_NO_COPY : mode,
 						reason, ret_folios);
 			/*
 			 * The rules are:
@@ -2586,21 +2775,9 @@ static int numamigrate_isolate_folio(pg_data_t *pgdat, struct folio *folio)
 	return 1;
 }
 
-/*
- * Attempt to migrate a misplaced folio to the specified destination
- * node. Caller is expected to have an elevated reference count on
- * the folio that will be dropped by this function before returning.
- */
-int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
-			    int node)
+static bool numamigrate_folio_suitable(struct folio *folio,
+				      struct vm_area_struct *vma)
 {
-	pg_data_t *pgdat = NODE_DATA(node);
-	int isolated;
-	int nr_remaining;
-	unsigned int nr_succeeded;
-	LIST_HEAD(migratepages);
-	int nr_pages = folio_nr_pages(folio);
-
 	/*
 	 * Don't migrate file folios that are mapped in multiple processes
 	 * with execute permissions as they are probably shared libraries.
@@ -2610,13 +2787,34 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	 */
 	if (folio_likely_mapped_shared(folio) && folio_is_file_lru(folio) &&
 	    (vma->vm_flags & VM_EXEC))
-		goto out;
+		return false;
 
 	/*
 	 * Also do not migrate dirty folios as not all filesystems can move
 	 * dirty folios in MIGRATE_ASYNC mode which is a waste of cycles.
 	 */
 	if (folio_is_file_lru(folio) && folio_test_dirty(folio))
+		return false;
+
+	return true;
+}
+
+/*
+ * Attempt to migrate a misplaced folio to the specified destination
+ * node. Caller is expected to have an elevated reference count on
+ * the folio that will be dropped by this function before returning.
+ */
+int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
+			    int node)
+{
+	pg_data_t *pgdat = NODE_DATA(node);
+	int isolated;
+	int nr_remaining;
+	unsigned int nr_succeeded;
+	LIST_HEAD(migratepages);
+	int nr_pages = folio_nr_pages(folio);
+
+	if (!numamigrate_folio_suitable(folio, vma))
 		goto out;
 
 	isolated = numamigrate_isolate_folio(pgdat, folio);
@@ -2649,5 +2847,129 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	folio_put(folio);
 	return 0;
 }
+
+/*
+ * With kernel.numa_balancing_batch_migrate_MBps set, hinting faults don't
+ * migrate misplaced folios themselves.  They isolate the folios and queue them
+ * on their destination node, and a work item running on that node migrates
+ * the whole queue at once.  This keeps the migration cost out of the fault
+ * latency of the application, and lets migrate_pages() batch the TLB flushes
+ * and copies.
+ */
+#define NUMA_MIGRATE_QUEUE_MAX_PAGES	(4 * NR_MAX_BATCHED_MIGRATION)
+
+struct numa_migrate_queue {
+	spinlock_t lock;
+	struct list_head folios;
+	unsigned int nr_pages;
+	int nid;
+	struct work_struct work;
+};
+
+static struct numa_migrate_queue *numa_migrate_queues[MAX_NUMNODES];
+
+static unsigned int numa_migrate_queued_folios(struct list_head *folios,
+					       int node)
+{
+	unsigned int nr_succeeded = 0;
+
+	if (list_empty(folios))
+		return 0;
+
+	migrate_pages(folios, alloc_misplaced_dst_folio, NULL, node,
+		      MIGRATE_ASYNC, MR_NUMA_MISPLACED, &nr_succeeded);
+	putback_movable_pages(folios);
+	return nr_succeeded;
+}
+
+static void numa_migrate_queue_work(struct work_struct *work)
+{
+	struct numa_migrate_queue *q = container_of(work,
+			struct numa_migrate_queue, work);
+	bool toptier = node_is_toptier(q->nid);
+	unsigned int nr_succeeded, nr_promoted;
+	struct folio *folio, *next;
+	LIST_HEAD(migratepages);
+	LIST_HEAD(promotepages);
+
+	spin_lock(&q->lock);
+	list_for_each_entry_safe(folio, next, &q->folios, lru) {
+		if (toptier && !node_is_toptier(folio_nid(folio)))
+			list_move_tail(&folio->lru, &promotepages);
+		else
+			list_move_tail(&folio->lru, &migratepages);
+	}
+	q->nr_pages = 0;
+	spin_unlock(&q->lock);
+
+	nr_promoted = numa_migrate_queued_folios(&promotepages, q->nid);
+	nr_succeeded = numa_migrate_queued_folios(&migratepages, q->nid);
+
+	if (nr_succeeded + nr_promoted)
+		count_vm_numa_events(NUMA_PAGE_MIGRATE,
+				     nr_succeeded + nr_promoted);
+	if (nr_promoted)
+		mod_node_page_state(NODE_DATA(q->nid), PGPROMOTE_SUCCESS,
+				    nr_promoted);
+}
+
+/*
+ * Like migrate_misplaced_folio(), but only isolate the folio and queue it for
+ * the batched migration to @node.  A queued folio is charged to the budget of
+ * the current task, see task_numa_migrate_budget().  May be called with the
+ * page table lock held.  Returns 1 if the folio has been queued.
+ */
+int migrate_misplaced_folio_queue(struct folio *folio,
+				  struct vm_area_struct *vma, int node)
+{
+	struct numa_migrate_queue *q = numa_migrate_queues[node];
+	int nr_pages = folio_nr_pages(folio);
+
+	if (!q || READ_ONCE(q->nr_pages) >= NUMA_MIGRATE_QUEUE_MAX_PAGES)
+		goto out;
+
+	if (!numamigrate_folio_suitable(folio, vma))
+		goto out;
+
+	if (!task_numa_migrate_budget(current, nr_pages))
+		goto out;
+
+	/* Drops our reference on success */
+	if (!numamigrate_isolate_folio(NODE_DATA(node), folio))
+		goto out;
+	task_numa_migrate_charge(current, nr_pages);
+
+	spin_lock(&q->lock);
+	list_add_tail(&folio->lru, &q->folios);
+	q->nr_pages += nr_pages;
+	spin_unlock(&q->lock);
+
+	queue_work_node(node, system_unbound_wq, &q->work);
+	return 1;
+
+out:
+	folio_put(folio);
+	return 0;
+}
+
+static int __init numa_migrate_queue_init(void)
+{
+	int nid;
+
+	for_each_node(nid) {
+		struct numa_migrate_queue *q;
+
+		q = kzalloc_node(sizeof(*q), GFP_KERNEL, nid);
+		if (!q)
+			return -ENOMEM;
+		spin_lock_init(&q->lock);
+		INIT_LIST_HEAD(&q->folios);
+		q->nid = nid;
+		INIT_WORK(&q->work, numa_migrate_queue_work);
+		numa_migrate_queues[nid] = q;
+	}
+	return 0;
+}
+subsys_initcall(numa_migrate_queue_init);
 #endif /* CONFIG_NUMA_BALANCING */
 #endif /* CONFIG_NUMA */
@@ -83,6 +83,18 @@ bool can_modify_mm(struct mm_struct *mm, unsigned long start, unsigned long end)
 	return true;
 }
 
+/*
+ * Check if a vma is allowed to be modified by madvise.
+ * return true, if it is allowed.
+ */
+bool can_modify_vma_madv(struct vm_area_struct *vma, int behavior)
+{
+	if (!is_madv_discard(behavior))
+		return true;
+
+	return !(is_ro_anon(vma) && !can_modify_vma(vma));
+}
+
 /*
  * Check if the vmas of a memory range are allowed to be modified by madvise.
  * the memory ranger can have a gap (unallocated memory).
@@ -100,7 +112,7 @@ bool can_modify_mm_madv(struct mm_struct *mm, unsigned long start, unsigned long
 
 	/* going through each vma to check. */
 	for_each_vma_range(vmi, vma, end)
-		if (unlikely(is_ro_anon(vma) && !can_modify_vma(vma)))
+		if (unlikely(!can_modify_vma_madv(vma, behavior)))
 			return false;
 
 	/* Allow by default. */
@@ -508,11 +508,14 @@ static inline unsigned int order_to_pindex(int migratetype, int order)
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	if (order > PAGE_ALLOC_COSTLY_ORDER) {
-		VM_BUG_ON(order != HPAGE_PMD_ORDER);
-
 		movable = migratetype == MIGRATE_MOVABLE;
 
-		return NR_LOWORDER_PCP_LISTS + movable;
+		if (order == HPAGE_PMD_ORDER)
+			return NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP + movable;
+
+		VM_BUG_ON(order > PCP_MTHP_MAX_ORDER);
+		return NR_LOWORDER_PCP_LISTS +
+		       2 * (order - PAGE_ALLOC_COSTLY_ORDER - 1) + movable;
 	}
 #else
 	VM_BUG_ON(order > PAGE_ALLOC_COSTLY_ORDER);
@@ -526,8 +529,11 @@ static inline int pindex_to_order(unsigned int pindex)
 	int order = pindex / MIGRATE_PCPTYPES;
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	if (pindex >= NR_LOWORDER_PCP_LISTS)
+	if (pindex >= NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP)
 		order = HPAGE_PMD_ORDER;
+	else if (pindex >= NR_LOWORDER_PCP_LISTS)
+		order = PAGE_ALLOC_COSTLY_ORDER + 1 +
+			(pindex - NR_LOWORDER_PCP_LISTS) / 2;
 #else
 	VM_BUG_ON(order > PAGE_ALLOC_COSTLY_ORDER);
 #endif
@@ -542,10 +548,37 @@ static inline bool pcp_allowed_order(unsigned int order)
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	if (order == HPAGE_PMD_ORDER)
 		return true;
+	if (order <= PCP_MTHP_MAX_ORDER && order < HPAGE_PMD_ORDER)
+		return true;
 #endif
 	return false;
 }
 
+#if NR_PCP_MTHP_ORDERS
+static inline bool pcp_mthp_order(unsigned int order)
+{
+	return order > PAGE_ALLOC_COSTLY_ORDER && order <= PCP_MTHP_MAX_ORDER &&
+	       order < HPAGE_PMD_ORDER;
+}
+
+static inline u8 *pcp_mthp_alloc_factor(struct per_cpu_pages *pcp,
+					unsigned int order)
+{
+	return &pcp->mthp_alloc_factor[order - PAGE_ALLOC_COSTLY_ORDER - 1];
+}
+#else
+static inline bool pcp_mthp_order(unsigned int order)
+{
+	return false;
+}
+
+static inline u8 *pcp_mthp_alloc_factor(struct per_cpu_pages *pcp,
+					unsigned int order)
+{
+	return NULL;
+}
+#endif
+
 /*
  * Higher-order pages are called "compound pages".  They are structured thusly:
  *
@@ -2535,6 +2568,8 @@ static void free_unref_page_commit(struct zone *zone, struct per_cpu_pages *pcp,
 	 * allocations.
 	 */
 	pcp->alloc_factor >>= 1;
+	if (pcp_mthp_order(order))
+		*pcp_mthp_alloc_factor(pcp, order) >>= 1;
 	__count_vm_events(PGFREE, 1 << order);
 	pindex = order_to_pindex(migratetype, order);
 	list_add(&page->pcp_list, &pcp->lists[pindex]);
@@ -2880,10 +2915,12 @@ static int nr_pcp_alloc(struct per_cpu_pages *pcp, struct zone *zone, int order)
 	if (unlikely(high < base_batch))
 		return 1;
 
-	if (order)
-		batch = base_batch;
-	else
+	if (!order)
 		batch = (base_batch << pcp->alloc_factor);
+	else if (pcp_mthp_order(order))
+		batch = (base_batch << *pcp_mthp_alloc_factor(pcp, order));
+	else
+		batch = base_batch;
 
 	/*
 	 * If we had larger pcp->high, we could avoid to allocate from
@@ -2902,6 +2939,21 @@ static int nr_pcp_alloc(struct per_cpu_pages *pcp, struct zone *zone, int order)
 		    pcp->alloc_factor < CONFIG_PCP_BATCH_SCALE_MAX)
 			pcp->alloc_factor++;
 		batch = min(batch, max_nr_alloc);
+	} else if (pcp_mthp_order(order)) {
+		u8 *factor = pcp_mthp_alloc_factor(pcp, order);
+
+		max_nr_alloc = max(high - pcp->count - base_batch, base_batch);
+		/*
+		 * Track the refill rate of each mTHP order separately, so a
+		 * steady stream of e.g. 64K folio allocations grows its own
+		 * batch without inflating the others. Only grow batches for
+		 * node-local zones, a remote zone's pages shouldn't be hoarded
+		 * on this CPU.
+		 */
+		if (batch <= max_nr_alloc && *factor < CONFIG_PCP_BATCH_SCALE_MAX &&
+		    zone_to_nid(zone) == numa_node_id())
+			(*factor)++;
+		batch = min(batch, max_nr_alloc);
 	}
 
 	/*
@@ -1725,6 +1725,49 @@ static void pcpu_alloc_tag_free_hook(struct pcpu_chunk *chunk, int off, size_t s
 }
 #endif
 
+/**
+ * pcpu_alloc_populated - allocate from already populated areas
+ * @size: size of area to allocate in bytes
+ * @bits: size of area in allocation units
+ * @bit_align: alignment of area in allocation units
+ * @chunkp: out param for the chunk the area was allocated from
+ *
+ * Search the normal chunks for a fully populated fit.  Unlike the main loop of
+ * pcpu_alloc(), chunks that don't fit are left in their slot, as they may still
+ * be useful to a caller that can populate them.
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * Offset of the allocated area in *@chunkp, -1 if nothing fits.
+ */
+static int pcpu_alloc_populated(size_t size, size_t bits, size_t bit_align,
+				struct pcpu_chunk **chunkp)
+{
+	struct pcpu_chunk *chunk;
+	int slot, off;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
+		list_for_each_entry(chunk, &pcpu_chunk_lists[slot], list) {
+			off = pcpu_find_block_fit(chunk, bits, bit_align, true);
+			if (off < 0)
+				continue;
+
+			off = pcpu_alloc_area(chunk, bits, bit_align, off);
+			if (off >= 0) {
+				pcpu_reintegrate_chunk(chunk);
+				*chunkp = chunk;
+				return off;
+			}
+		}
+	}
+
+	return -1;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1746,6 +1789,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	gfp_t pcpu_gfp;
 	bool is_atomic;
 	bool do_warn;
+	bool populated = false;
 	struct obj_cgroup *objcg = NULL;
 	static int warn_limit = 10;
 	struct pcpu_chunk *chunk, *next;
@@ -1784,6 +1828,23 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	if (!is_atomic && !(reserved && pcpu_reserved_chunk)) {
+		/*
+		 * Most allocations fit into already populated pages.  Try
+		 * those first under pcpu_lock alone, the way atomic
+		 * allocations do, so that creating many cgroups or netdevs
+		 * doesn't serialize on pcpu_alloc_mutex behind chunk
+		 * creation and population.
+		 */
+		spin_lock_irqsave(&pcpu_lock, flags);
+		off = pcpu_alloc_populated(size, bits, bit_align, &chunk);
+		if (off >= 0) {
+			populated = true;
+			goto area_found;
+		}
+		spin_unlock_irqrestore(&pcpu_lock, flags);
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
@@ -1867,7 +1928,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
 	/* populate if not all pages are already there */
-	if (!is_atomic) {
+	if (!is_atomic && !populated) {
 		unsigned int page_end, rs, re;
 
 		rs = PFN_DOWN(off);
@@ -487,33 +487,80 @@ static inline int ra_alloc_folio(struct readahead_control *ractl, pgoff_t index,
 	return 0;
 }
 
+/*
+ * Widen the readahead window starting at the current index and align it to
+ * 1 << min_order pages, so that it can be filled with folios of that order.
+ * The start only moves back over pages that are not cached yet; adding a
+ * folio on top of a cached page would fail and end the window early.
+ */
+static void ra_align_window(struct readahead_control *ractl,
+		struct file_ra_state *ra, unsigned int min_order)
+{
+	unsigned long nr = 1UL << min_order;
+	pgoff_t first = round_down(ra->start, nr);
+	pgoff_t end = round_up(ra->start + ra->size, nr);
+	pgoff_t start = ra->start;
+
+	while (start > first) {
+		struct folio *folio = xa_load(&ractl->mapping->i_pages,
+					      start - 1);
+
+		if (folio && !xa_is_value(folio))
+			break;
+		start--;
+	}
+
+	ra->size = end - start;
+	ra->async_size = min_t(unsigned int, max_t(unsigned int,
+					ra->async_size, nr), ra->size);
+	ra->start = start;
+	ractl->_index = start;
+}
+
 void page_cache_ra_order(struct readahead_control *ractl,
 		struct file_ra_state *ra, unsigned int new_order)
 {
 	struct address_space *mapping = ractl->mapping;
-	pgoff_t index = readahead_index(ractl);
-	pgoff_t limit = (i_size_read(mapping->host) - 1) >> PAGE_SHIFT;
-	pgoff_t mark = index + ra->size - ra->async_size;
+	unsigned int min_order = READ_ONCE(ra->min_order);
+	pgoff_t index, limit, mark;
+	unsigned int order, max_order = 0;
 	unsigned int nofs;
 	int err = 0;
 	gfp_t gfp = readahead_gfp_mask(mapping);
 
-	if (!mapping_large_folio_support(mapping) || ra->size < 4)
+	if (!mapping_large_folio_support(mapping))
 		goto fallback;
 
+	min_order = min_t(unsigned int, min_order, MAX_PAGECACHE_ORDER);
+	if (min_order && readahead_index(ractl) == ra->start)
+		ra_align_window(ractl, ra, min_order);
+
+	if (ra->size < 4)
+		goto fallback;
+
+	index = readahead_index(ractl);
+	mark = index + ra->size - ra->async_size;
+	limit = (i_size_read(mapping->host) - 1) >> PAGE_SHIFT;
 	limit = min(limit, index + ra->size - 1);
 
+	/*
+	 * Ramp up from the order of the folio that triggered this readahead,
+	 * or from what earlier windows of this file managed, so that a
+	 * non-sequential read does not drop us back to small folios.
+	 */
+	new_order = max_t(unsigned int, new_order, ra->order);
 	if (new_order < MAX_PAGECACHE_ORDER) {
 		new_order += 2;
 		new_order = min_t(unsigned int, MAX_PAGECACHE_ORDER, new_order);
 		new_order = min_t(unsigned int, new_order, ilog2(ra->size));
 	}
+	new_order = max(new_order, min_order);
 
 	/* See comment in page_cache_ra_unbounded() */
 	nofs = memalloc_nofs_save();
 	filemap_invalidate_lock_shared(mapping);
 	while (index <= limit) {
-		unsigned int order = new_order;
+		order = new_order;
 
 		/* Align with smaller pages if needed */
 		if (index & ((1UL << order) - 1))
@@ -524,9 +571,19 @@ void page_cache_ra_order(struct readahead_control *ractl,
 		err = ra_alloc_folio(ractl, index, mark, order, gfp);
 		if (err)
 			break;
+		max_order = max(max_order, order);
 		index += 1UL << order;
 	}
 
+	/*
+	 * Remember the order for the next window. Back off when we could not
+	 * allocate, so that we don't keep failing on a fragmented system.
+	 */
+	if (err == -ENOMEM)
+		ra->order = order / 2;
+	else if (!err)
+		ra->order = max_order;
+
 	if (index > limit) {
 		ra->size += index - limit - 1;
 		ra->async_size += index - limit - 1;
@@ -648,6 +648,7 @@ void try_to_unmap_flush(void)
 		return;
 
 	arch_tlbbatch_flush(&tlb_ubc->arch);
+	count_vm_event(UNMAP_TLB_FLUSH);
 	tlb_ubc->flush_required = false;
 	tlb_ubc->writable = false;
 }
@@ -681,6 +682,10 @@ static void set_tlb_ubc_flush_pending(struct mm_struct *mm, pte_t pteval,
 	if (!pte_accessible(mm, pteval))
 		return;
 
+	/* every entry after the first one shares the flush */
+	if (tlb_ubc->flush_required)
+		count_vm_event(UNMAP_TLB_FLUSH_SAVED);
+
 	arch_tlbbatch_add_pending(&tlb_ubc->arch, mm, uaddr);
 	tlb_ubc->flush_required = true;
 
@@ -1269,6 +1274,18 @@ static void __page_check_anon_rmap(struct folio *folio, struct page *page,
 		       page);
 }
 
+/*
+ * Pages mapped from large folios are counted per mm as they are mapped and
+ * unmapped, so that THP and mTHP usage can be reported without walking the
+ * page tables. Hugetlb folios never come through here.
+ */
+static __always_inline void folio_account_large_mapping(struct folio *folio,
+		struct vm_area_struct *vma, int nr_pages)
+{
+	if (folio_test_large(folio))
+		add_mm_counter(vma->vm_mm, MM_LARGEPAGES, nr_pages);
+}
+
 static __always_inline void __folio_add_anon_rmap(struct folio *folio,
 		struct page *page, int nr_pages, struct vm_area_struct *vma,
 		unsigned long address, rmap_t flags, enum rmap_level level)
@@ -1280,6 +1297,7 @@ static __always_inline void __folio_add_anon_rmap(struct folio *folio,
 		__lruvec_stat_mod_folio(folio, NR_ANON_THPS, nr_pmdmapped);
 	if (nr)
 		__lruvec_stat_mod_folio(folio, NR_ANON_MAPPED, nr);
+	folio_account_large_mapping(folio, vma, nr_pages);
 
 	if (unlikely(!folio_test_anon(folio))) {
 		VM_WARN_ON_FOLIO(!folio_test_locked(folio), folio);
@@ -1429,6 +1447,7 @@ void folio_add_new_anon_rmap(struct folio *folio, struct vm_area_struct *vma,
 	}
 
 	__lruvec_stat_mod_folio(folio, NR_ANON_MAPPED, nr);
+	folio_account_large_mapping(folio, vma, nr);
 }
 
 static __always_inline void __folio_add_file_rmap(struct folio *folio,
@@ -1446,6 +1465,7 @@ static __always_inline void __folio_add_file_rmap(struct folio *folio,
 			NR_SHMEM_PMDMAPPED : NR_FILE_PMDMAPPED, nr_pmdmapped);
 	if (nr)
 		__lruvec_stat_mod_folio(folio, NR_FILE_MAPPED, nr);
+	folio_account_large_mapping(folio, vma, nr_pages);
 
 	/* See comments in folio_add_anon_rmap_*() */
 	if (!folio_test_large(folio))
@@ -1500,6 +1520,7 @@ static __always_inline void __folio_remove_rmap(struct folio *folio,
 	enum node_stat_item idx;
 
 	__folio_rmap_sanity_checks(folio, page, nr_pages, level);
+	folio_account_large_mapping(folio, vma, -nr_pages);
 
 	switch (level) {
 	case RMAP_LEVEL_PTE:
@@ -1618,6 +1639,61 @@ void folio_remove_rmap_pmd(struct folio *folio, struct page *page,
 /*
  * @arg: enum ttu_flags will be passed to this argument
  */
+/*
+ * PTEs of a large folio cleared by try_to_unmap_one() whose TLB flush is
+ * still pending.
+ */
+struct unmap_tlb_range {
+	unsigned long start;
+	unsigned long end;
+	unsigned int nr;
+};
+
+static void unmap_tlb_range_add(struct unmap_tlb_range *tlb,
+				unsigned long address)
+{
+	if (!tlb->nr)
+		tlb->start = address;
+	tlb->end = address + PAGE_SIZE;
+	tlb->nr++;
+}
+
+/*
+ * Whether the PTE just handled is the last one of the folio which the walk
+ * will find under the current PTL. page_vma_mapped_walk() drops the PTL at
+ * the end of the page table, and may finish the walk without returning if
+ * the remaining PTEs do not map the folio.
+ */
+static bool unmap_tlb_range_last(struct page_vma_mapped_walk *pvmw,
+				 unsigned long pfn, unsigned long walk_end)
+{
+	unsigned long next = pvmw->address + PAGE_SIZE;
+	pte_t pte;
+
+	if (!(next & ~PMD_MASK) || next >= walk_end)
+		return true;
+
+	pte = ptep_get(pvmw->pte + 1);
+
+	return !pte_present(pte) || pte_pfn(pte) != pfn + 1;
+}
+
+/*
+ * This must be called before the PTL is released, for the same reason as
+ * explained above flush_tlb_batched_pending().
+ */
+static void unmap_tlb_range_flush(struct vm_area_struct *vma,
+				  struct unmap_tlb_range *tlb)
+{
+	if (!tlb->nr)
+		return;
+
+	flush_tlb_range(vma, tlb->start, tlb->end);
+	count_vm_event(UNMAP_TLB_FLUSH);
+	count_vm_events(UNMAP_TLB_FLUSH_SAVED, tlb->nr - 1);
+	tlb->nr = 0;
+}
+
 static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 		     unsigned long address, void *arg)
 {
@@ -1628,6 +1704,9 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 	bool anon_exclusive, ret = true;
 	struct mmu_notifier_range range;
 	enum ttu_flags flags = (enum ttu_flags)(long)arg;
+	struct unmap_tlb_range tlb = {};
+	bool batch_range;
+	unsigned long walk_end;
 	unsigned long pfn;
 	unsigned long hsz = 0;
 
@@ -1652,6 +1731,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 	 * try_to_unmap() must hold a reference on the folio.
 	 */
 	range.end = vma_address_end(&pvmw);
+	walk_end = range.end;
 	mmu_notifier_range_init(&range, MMU_NOTIFY_CLEAR, 0, vma->vm_mm,
 				address, range.end);
 	if (folio_test_hugetlb(folio)) {
@@ -1667,6 +1747,16 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 	}
 	mmu_notifier_invalidate_range_start(&range);
 
+	/*
+	 * If the flush cannot be deferred to the end of the reclaim batch,
+	 * flush the PTEs mapping a large folio once per page table rather
+	 * than once per PTE. MADV_FREE folios are excluded: whether they
+	 * can be discarded depends on the dirty state after the flush.
+	 */
+	batch_range = folio_test_large(folio) && !folio_test_hugetlb(folio) &&
+		      !should_defer_flush(mm, flags) &&
+		      (!folio_test_anon(folio) || folio_test_swapbacked(folio));
+
 	while (page_vma_mapped_walk(&pvmw)) {
 		/* Unexpected PMD-mapped THP? */
 		VM_BUG_ON_FOLIO(!pvmw.pte, folio);
@@ -1679,9 +1769,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 			/* Restore the mlock which got missed */
 			if (!folio_test_large(folio))
 				mlock_vma_folio(folio, vma);
-			page_vma_mapped_walk_done(&pvmw);
-			ret = false;
-			break;
+			goto walk_abort;
 		}
 
 		pfn = pte_pfn(ptep_get(pvmw.pte));
@@ -1720,9 +1808,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 			if (!anon) {
 				VM_BUG_ON(!(flags & TTU_RMAP_LOCKED));
 				if (!hugetlb_vma_trylock_write(vma)) {
-					page_vma_mapped_walk_done(&pvmw);
-					ret = false;
-					break;
+					goto walk_abort;
 				}
 				if (huge_pmd_unshare(mm, vma, address, pvmw.pte)) {
 					hugetlb_vma_unlock_write(vma);
@@ -1738,8 +1824,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 					 * actual page and drop map count
 					 * to zero.
 					 */
-					page_vma_mapped_walk_done(&pvmw);
-					break;
+					goto walk_done;
 				}
 				hugetlb_vma_unlock_write(vma);
 			}
@@ -1759,6 +1844,10 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 				pteval = ptep_get_and_clear(mm, address, pvmw.pte);
 
 				set_tlb_ubc_flush_pending(mm, pteval, address);
+			} else if (batch_range) {
+				pteval = ptep_get_and_clear(mm, address, pvmw.pte);
+
+				unmap_tlb_range_add(&tlb, address);
 			} else {
 				pteval = ptep_clear_flush(vma, address, pvmw.pte);
 			}
@@ -1811,9 +1900,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 			if (unlikely(folio_test_swapbacked(folio) !=
 					folio_test_swapcache(folio))) {
 				WARN_ON_ONCE(1);
-				ret = false;
-				page_vma_mapped_walk_done(&pvmw);
-				break;
+				goto walk_abort;
 			}
 
 			/* MADV_FREE page check */
@@ -1852,23 +1939,17 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 				 */
 				set_pte_at(mm, address, pvmw.pte, pteval);
 				folio_set_swapbacked(folio);
-				ret = false;
-				page_vma_mapped_walk_done(&pvmw);
-				break;
+				goto walk_abort;
 			}
 
 			if (swap_duplicate(entry) < 0) {
 				set_pte_at(mm, address, pvmw.pte, pteval);
-				ret = false;
-				page_vma_mapped_walk_done(&pvmw);
-				break;
+				goto walk_abort;
 			}
 			if (arch_unmap_one(mm, vma, address, pteval) < 0) {
 				swap_free(entry);
 				set_pte_at(mm, address, pvmw.pte, pteval);
-				ret = false;
-				page_vma_mapped_walk_done(&pvmw);
-				break;
+				goto walk_abort;
 			}
 
 			/* See folio_try_share_anon_rmap(): clear PTE first. */
@@ -1876,9 +1957,7 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 			    folio_try_share_anon_rmap_pte(folio, subpage)) {
 				swap_free(entry);
 				set_pte_at(mm, address, pvmw.pte, pteval);
-				ret = false;
-				page_vma_mapped_walk_done(&pvmw);
-				break;
+				goto walk_abort;
 			}
 			if (list_empty(&mm->mmlist)) {
 				spin_lock(&mmlist_lock);
@@ -1918,6 +1997,16 @@ static bool try_to_unmap_one(struct folio *folio, struct vm_area_struct *vma,
 		if (vma->vm_flags & VM_LOCKED)
 			mlock_drain_local();
 		folio_put(folio);
+
+		if (tlb.nr && unmap_tlb_range_last(&pvmw, pfn, walk_end))
+			unmap_tlb_range_flush(vma, &tlb);
+		continue;
+walk_abort:
+		ret = false;
+walk_done:
+		unmap_tlb_range_flush(vma, &tlb);
+		page_vma_mapped_walk_done(&pvmw);
+		break;
 	}
 
 	mmu_notifier_invalidate_range_end(&range);
@@ -541,6 +541,15 @@ static bool shmem_confirm_swap(struct address_space *mapping,
 
 static int shmem_huge __read_mostly = SHMEM_HUGE_NEVER;
 
+/*
+ * Per-size policies under hugepages-<size>kB/shmem_enabled.  "inherit" follows
+ * shmem_is_huge(), i.e. the top level shmem_enabled and the huge= mount option.
+ */
+static unsigned long huge_shmem_orders_always __read_mostly;
+static unsigned long huge_shmem_orders_madvise __read_mostly;
+static unsigned long huge_shmem_orders_inherit __read_mostly;
+static unsigned long huge_shmem_orders_within_size __read_mostly;
+
 bool shmem_is_huge(struct inode *inode, pgoff_t index, bool shmem_huge_force,
 		   struct mm_struct *mm, unsigned long vm_flags)
 {
@@ -573,6 +582,55 @@ bool shmem_is_huge(struct inode *inode, pgoff_t index, bool shmem_huge_force,
 	}
 }
 
+/*
+ * Return the large folio orders that may be used for a new folio at @index
+ * of @inode: the per-size policies combined with the PMD sized policy of
+ * shmem_is_huge() for the sizes set to "inherit".
+ */
+static unsigned long shmem_allowable_huge_orders(struct inode *inode,
+		struct vm_area_struct *vma, pgoff_t index, bool shmem_huge_force)
+{
+	struct mm_struct *mm = vma ? vma->vm_mm : NULL;
+	unsigned long vm_flags = vma ? vma->vm_flags : 0;
+	unsigned long within_size_orders, mask;
+	loff_t i_size;
+	int order;
+
+	if (!S_ISREG(inode->i_mode))
+		return 0;
+	if (mm && ((vm_flags & VM_NOHUGEPAGE) || test_bit(MMF_DISABLE_THP, &mm->flags)))
+		return 0;
+	if (shmem_huge == SHMEM_HUGE_DENY)
+		return 0;
+	/*
+	 * huge=never on a tmpfs mount also rules out the per-size policies.
+	 * The internal mount has no huge= option of its own, it just mirrors
+	 * the top level shmem_enabled, which "inherit" already follows.
+	 */
+	if (SHMEM_SB(inode->i_sb)->huge == SHMEM_HUGE_NEVER &&
+	    !shmem_huge_force && shmem_huge != SHMEM_HUGE_FORCE &&
+	    (IS_ERR(shm_mnt) || inode->i_sb != shm_mnt->mnt_sb))
+		return 0;
+
+	mask = READ_ONCE(huge_shmem_orders_always);
+	if (vm_flags & VM_HUGEPAGE)
+		mask |= READ_ONCE(huge_shmem_orders_madvise);
+
+	within_size_orders = READ_ONCE(huge_shmem_orders_within_size);
+	i_size = round_up(i_size_read(inode), PAGE_SIZE);
+	order = highest_order(within_size_orders);
+	while (within_size_orders) {
+		if ((i_size >> PAGE_SHIFT) >= round_up(index + 1, 1 << order))
+			mask |= BIT(order);
+		order = next_order(&within_size_orders, order);
+	}
+
+	if (shmem_is_huge(inode, index, shmem_huge_force, mm, vm_flags))
+		mask |= READ_ONCE(huge_shmem_orders_inherit);
+
+	return mask;
+}
+
 #if defined(CONFIG_SYSFS)
 static int shmem_parse_huge(const char *str)
 {
@@ -753,6 +811,12 @@ static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 {
 	return 0;
 }
+
+static unsigned long shmem_allowable_huge_orders(struct inode *inode,
+		struct vm_area_struct *vma, pgoff_t index, bool shmem_huge_force)
+{
+	return 0;
+}
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
 /*
@@ -1604,14 +1668,14 @@ static gfp_t limit_gfp_mask(gfp_t huge_gfp, gfp_t limit_gfp)
 }
 
 static struct folio *shmem_alloc_hugefolio(gfp_t gfp,
-		struct shmem_inode_info *info, pgoff_t index)
+		struct shmem_inode_info *info, pgoff_t index, int order)
 {
 	struct mempolicy *mpol;
 	pgoff_t ilx;
 	struct page *page;
 
-	mpol = shmem_get_pgoff_policy(info, index, HPAGE_PMD_ORDER, &ilx);
-	page = alloc_pages_mpol(gfp, HPAGE_PMD_ORDER, mpol, ilx, numa_node_id());
+	mpol = shmem_get_pgoff_policy(info, index, order, &ilx);
+	page = alloc_pages_mpol(gfp, order, mpol, ilx, numa_node_id());
 	mpol_cond_put(mpol);
 
 	return page_rmappable_folio(page);
@@ -1631,38 +1695,57 @@ static struct folio *shmem_alloc_folio(gfp_t gfp,
 	return (struct folio *)page;
 }
 
+/*
+ * Allocate a folio for @index of @inode and add it to the page cache.  With
+ * @orders, try the large folio orders in it from the highest one down, and
+ * fail with -E2BIG rather than falling back to order-0.
+ */
 static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		struct inode *inode, pgoff_t index,
-		struct mm_struct *fault_mm, bool huge)
+		struct mm_struct *fault_mm, unsigned long orders)
 {
 	struct address_space *mapping = inode->i_mapping;
 	struct shmem_inode_info *info = SHMEM_I(inode);
-	struct folio *folio;
+	struct folio *folio = NULL;
+	bool huge = false;
 	long pages;
-	int error;
+	int error, order;
 
 	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE))
-		huge = false;
+		orders = 0;
 
-	if (huge) {
-		pages = HPAGE_PMD_NR;
-		index = round_down(index, HPAGE_PMD_NR);
+	if (orders) {
+		pgoff_t aligned_index;
 
-		/*
-		 * Check for conflict before waiting on a huge allocation.
-		 * Conflict might be that a huge page has just been allocated
-		 * and added to page cache by a racing thread, or that there
-		 * is already at least one small page in the huge extent.
-		 * Be careful to retry when appropriate, but not forever!
-		 * Elsewhere -EEXIST would be the right code, but not here.
-		 */
-		if (xa_find(&mapping->i_pages, &index,
-				index + HPAGE_PMD_NR - 1, XA_PRESENT))
-			return ERR_PTR(-E2BIG);
-
-		folio = shmem_alloc_hugefolio(gfp, info, index);
+		order = highest_order(orders);
+		while (orders) {
+			pages = 1UL << order;
+			aligned_index = round_down(index, pages);
+			/*
+			 * Check for conflict before waiting on a huge
+			 * allocation.  Conflict might be that a huge page has
+			 * just been allocated and added to page cache by a
+			 * racing thread, or that there is already at least
+			 * one small page in the huge extent.  Be careful to
+			 * retry when appropriate, but not forever!  Elsewhere
+			 * -EEXIST would be the right code, but not here.
+			 */
+			if (!xa_find(&mapping->i_pages, &aligned_index,
+				     aligned_index + pages - 1, XA_PRESENT)) {
+				aligned_index = round_down(index, pages);
+				folio = shmem_alloc_hugefolio(gfp, info,
+							      aligned_index, order);
+				if (folio)
+					break;
+				if (order == HPAGE_PMD_ORDER)
+					count_vm_event(THP_FILE_FALLBACK);
+			}
+			order = next_order(&orders, order);
+		}
 		if (!folio)
-			count_vm_event(THP_FILE_FALLBACK);
+			return ERR_PTR(-E2BIG);
+		index = aligned_index;
+		huge = order == HPAGE_PMD_ORDER;
 	} else {
 		pages = 1;
 		folio = shmem_alloc_folio(gfp, info, index);
@@ -1963,6 +2046,7 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 	struct vm_area_struct *vma = vmf ? vmf->vma : NULL;
 	struct mm_struct *fault_mm;
 	struct folio *folio;
+	unsigned long orders;
 	int error;
 	bool alloced;
 
@@ -2036,23 +2120,24 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 		return 0;
 	}
 
-	if (shmem_is_huge(inode, index, false, fault_mm,
-			  vma ? vma->vm_flags : 0)) {
+	orders = shmem_allowable_huge_orders(inode, vma, index, false);
+	if (orders) {
 		gfp_t huge_gfp;
 
 		huge_gfp = vma_thp_gfp_mask(vma);
 		huge_gfp = limit_gfp_mask(huge_gfp, gfp);
 		folio = shmem_alloc_and_add_folio(huge_gfp,
-				inode, index, fault_mm, true);
+				inode, index, fault_mm, orders);
 		if (!IS_ERR(folio)) {
-			count_vm_event(THP_FILE_ALLOC);
+			if (folio_test_pmd_mappable(folio))
+				count_vm_event(THP_FILE_ALLOC);
 			goto alloced;
 		}
 		if (PTR_ERR(folio) == -EEXIST)
 			goto repeat;
 	}
 
-	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, false);
+	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, 0);
 	if (IS_ERR(folio)) {
 		error = PTR_ERR(folio);
 		if (error == -EEXIST)
@@ -4685,6 +4770,12 @@ void __init shmem_init(void)
 		SHMEM_SB(shm_mnt->mnt_sb)->huge = shmem_huge;
 	else
 		shmem_huge = SHMEM_HUGE_NEVER; /* just in case it was patched */
+
+	/*
+	 * Default to setting PMD-sized THP to inherit the global setting and
+	 * disable all other multi-size THPs.
+	 */
+	huge_shmem_orders_inherit = BIT(HPAGE_PMD_ORDER);
 #endif
 	return;
 
@@ -4751,6 +4842,64 @@ static ssize_t shmem_enabled_store(struct kobject *kobj,
 }
 
 struct kobj_attribute shmem_enabled_attr = __ATTR_RW(shmem_enabled);
+
+static DEFINE_SPINLOCK(huge_shmem_orders_lock);
+
+static ssize_t thpsize_shmem_enabled_show(struct kobject *kobj,
+					  struct kobj_attribute *attr, char *buf)
+{
+	int order = to_thpsize(kobj)->order;
+	const char *output;
+
+	if (test_bit(order, &huge_shmem_orders_always))
+		output = "[always] inherit within_size advise never";
+	else if (test_bit(order, &huge_shmem_orders_inherit))
+		output = "always [inherit] within_size advise never";
+	else if (test_bit(order, &huge_shmem_orders_within_size))
+		output = "always inherit [within_size] advise never";
+	else if (test_bit(order, &huge_shmem_orders_madvise))
+		output = "always inherit within_size [advise] never";
+	else
+		output = "always inherit within_size advise [never]";
+
+	return sysfs_emit(buf, "%s\n", output);
+}
+
+static ssize_t thpsize_shmem_enabled_store(struct kobject *kobj,
+					   struct kobj_attribute *attr,
+					   const char *buf, size_t count)
+{
+	int order = to_thpsize(kobj)->order;
+	unsigned long *set = NULL;
+
+	if (sysfs_streq(buf, "always"))
+		set = &huge_shmem_orders_always;
+	else if (sysfs_streq(buf, "inherit"))
+		set = &huge_shmem_orders_inherit;
+	else if (sysfs_streq(buf, "within_size"))
+		set = &huge_shmem_orders_within_size;
+	else if (sysfs_streq(buf, "advise"))
+		set = &huge_shmem_orders_madvise;
+	else if (!sysfs_streq(buf, "never"))
+		return -EINVAL;
+
+	if (set && !has_transparent_hugepage())
+		return -EINVAL;
+
+	spin_lock(&huge_shmem_orders_lock);
+	clear_bit(order, &huge_shmem_orders_always);
+	clear_bit(order, &huge_shmem_orders_inherit);
+	clear_bit(order, &huge_shmem_orders_within_size);
+	clear_bit(order, &huge_shmem_orders_madvise);
+	if (set)
+		set_bit(order, set);
+	spin_unlock(&huge_shmem_orders_lock);
+
+	return count;
+}
+
+struct kobj_attribute thpsize_shmem_enabled_attr =
+	__ATTR(shmem_enabled, 0644, thpsize_shmem_enabled_show, thpsize_shmem_enabled_store);
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE && CONFIG_SYSFS */
 
 #else /* !CONFIG_SHMEM */
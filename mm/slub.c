@@ -373,6 +373,8 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	FREE_REMOTE,		/* Remote node free buffered in percpu sheaves */
+	FREE_REMOTE_FLUSH,	/* Batch of remote node frees flushed */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -419,6 +421,107 @@ void stat_add(const struct kmem_cache *s, enum stat_item si, int v)
 #endif
 }
 
+/*
+ * An array of free objects, either a percpu sheaf, a sheaf stored in a barn,
+ * or a sheaf prefilled by kmem_cache_prefill_sheaf(). The objects have been
+ * through the free hooks and are otherwise still allocated from the slab's
+ * point of view.
+ */
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	unsigned int capacity;
+	void *objects[];
+};
+
+static int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags,
+				   size_t size, void **p);
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
+
+static struct slab_sheaf *__alloc_empty_sheaf(unsigned int capacity, gfp_t gfp)
+{
+	struct slab_sheaf *sheaf;
+
+	gfp &= ~(__GFP_ZERO | __GFP_ACCOUNT);
+	sheaf = kzalloc(struct_size(sheaf, objects, capacity), gfp);
+	if (unlikely(!sheaf))
+		return NULL;
+
+	sheaf->capacity = capacity;
+	return sheaf;
+}
+
+static void free_empty_sheaf(struct slab_sheaf *sheaf)
+{
+	kfree(sheaf);
+}
+
+/* Fill the sheaf up to its capacity, either completely or not at all. */
+static int refill_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf,
+			gfp_t gfp)
+{
+	unsigned int to_fill = sheaf->capacity - sheaf->size;
+
+	if (!to_fill)
+		return 0;
+
+	if (!__kmem_cache_alloc_bulk(s, gfp, to_fill,
+				     &sheaf->objects[sheaf->size]))
+		return -ENOMEM;
+
+	sheaf->size = sheaf->capacity;
+	return 0;
+}
+
+/*
+ * Return all objects of the sheaf to the slabs. They went through the free
+ * hooks (or never through the alloc hooks) already.
+ */
+static void sheaf_flush(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	__kmem_cache_free_bulk(s, sheaf->size, &sheaf->objects[0]);
+	sheaf->size = 0;
+}
+
+#ifndef CONFIG_SLUB_TINY
+/* Maximal number of full and empty sheaves kept per node */
+#define MAX_FULL_SHEAVES	10
+#define MAX_EMPTY_SHEAVES	10
+
+/*
+ * Per node store of full and empty sheaves, used to exchange sheaves with
+ * the percpu caches before falling back to the slabs.
+ */
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
+
+/*
+ * Objects freed on a cpu of a different node than their slab are collected
+ * per target node and freed in batches, so that the remote node's slabs and
+ * list_lock are touched once per batch rather than once per object.
+ */
+#define PCS_REMOTE_SLOTS	4
+#define PCS_REMOTE_BATCH	16
+
+struct pcs_remote_free {
+	int node;
+	unsigned int nr;		/* slot is unused when 0 */
+	void *objects[PCS_REMOTE_BATCH];
+};
+
+struct slub_percpu_sheaves {
+	local_lock_t lock;
+	struct slab_sheaf *main;	/* never NULL */
+	struct slab_sheaf *spare;	/* empty or full, may be NULL */
+	struct pcs_remote_free remote[PCS_REMOTE_SLOTS];
+};
+#endif
+
 /*
  * The slab lists for all objects.
  */
@@ -431,6 +534,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn barn;
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -3080,6 +3186,231 @@ static inline void put_partials_cpu(struct kmem_cache *s,
 
 #endif	/* CONFIG_SLUB_CPU_PARTIAL */
 
+static inline bool slab_has_sheaves(struct kmem_cache *s)
+{
+	return s->cpu_sheaves;
+}
+
+static struct node_barn *get_barn(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+
+	return n ? &n->barn : NULL;
+}
+
+static bool barn_put_full_sheaf(struct node_barn *barn, struct slab_sheaf *sheaf)
+{
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (barn->nr_full < MAX_FULL_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return ret;
+}
+
+static bool barn_put_empty_sheaf(struct node_barn *barn, struct slab_sheaf *sheaf)
+{
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (barn->nr_empty < MAX_EMPTY_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_empty);
+		barn->nr_empty++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return ret;
+}
+
+static struct slab_sheaf *barn_get_full_sheaf(struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf = NULL;
+	unsigned long flags;
+
+	if (!data_race(barn->nr_full))
+		return NULL;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (likely(barn->nr_full)) {
+		sheaf = list_first_entry(&barn->sheaves_full, struct slab_sheaf,
+					 barn_list);
+		list_del(&sheaf->barn_list);
+		barn->nr_full--;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return sheaf;
+}
+
+/*
+ * Exchange an empty sheaf for a full one. If there is no room for the empty
+ * sheaf in the barn, it's freed. Returns NULL and leaves the empty sheaf
+ * alone if there is no full sheaf.
+ */
+static struct slab_sheaf *
+barn_replace_empty_sheaf(struct node_barn *barn, struct slab_sheaf *empty)
+{
+	struct slab_sheaf *full = NULL;
+	unsigned long flags;
+
+	if (!data_race(barn->nr_full))
+		return NULL;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (likely(barn->nr_full)) {
+		full = list_first_entry(&barn->sheaves_full, struct slab_sheaf,
+					barn_list);
+		list_del(&full->barn_list);
+		barn->nr_full--;
+		if (barn->nr_empty < MAX_EMPTY_SHEAVES) {
+			list_add(&empty->barn_list, &barn->sheaves_empty);
+			barn->nr_empty++;
+			empty = NULL;
+		}
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	if (full && empty)
+		free_empty_sheaf(empty);
+	return full;
+}
+
+/*
+ * Exchange a full sheaf for an empty one. Returns NULL and leaves the full
+ * sheaf alone if there is no empty sheaf or no room for another full one.
+ */
+static struct slab_sheaf *
+barn_replace_full_sheaf(struct node_barn *barn, struct slab_sheaf *full)
+{
+	struct slab_sheaf *empty = NULL;
+	unsigned long flags;
+
+	if (!data_race(barn->nr_empty) ||
+	    data_race(barn->nr_full) >= MAX_FULL_SHEAVES)
+		return NULL;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (likely(barn->nr_empty && barn->nr_full < MAX_FULL_SHEAVES)) {
+		empty = list_first_entry(&barn->sheaves_empty, struct slab_sheaf,
+					 barn_list);
+		list_del(&empty->barn_list);
+		barn->nr_empty--;
+		list_add(&full->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return empty;
+}
+
+static void barn_shrink(struct kmem_cache *s, struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf, *tmp;
+	unsigned long flags;
+	LIST_HEAD(full_list);
+	LIST_HEAD(empty_list);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &full_list);
+	barn->nr_full = 0;
+	list_splice_init(&barn->sheaves_empty, &empty_list);
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, tmp, &full_list, barn_list) {
+		sheaf_flush(s, sheaf);
+		free_empty_sheaf(sheaf);
+	}
+	list_for_each_entry_safe(sheaf, tmp, &empty_list, barn_list)
+		free_empty_sheaf(sheaf);
+}
+
+static void flush_barns(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n;
+	int node;
+
+	if (!slab_has_sheaves(s))
+		return;
+
+	for_each_kmem_cache_node(s, node, n)
+		barn_shrink(s, &n->barn);
+}
+
+static void pcs_flush_remote(struct kmem_cache *s,
+			     struct slub_percpu_sheaves *pcs)
+{
+	int i;
+
+	for (i = 0; i < PCS_REMOTE_SLOTS; i++) {
+		struct pcs_remote_free *rf = &pcs->remote[i];
+
+		if (!rf->nr)
+			continue;
+		__kmem_cache_free_bulk(s, rf->nr, rf->objects);
+		rf->nr = 0;
+		stat(s, FREE_REMOTE_FLUSH);
+	}
+}
+
+/* Flush the percpu sheaves of the current cpu. */
+static void pcs_flush(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *spare;
+	unsigned long flags;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+	spare = pcs->spare;
+	pcs->spare = NULL;
+	sheaf_flush(s, pcs->main);
+	pcs_flush_remote(s, pcs);
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (spare) {
+		sheaf_flush(s, spare);
+		free_empty_sheaf(spare);
+	}
+}
+
+/* Flush the percpu sheaves of a dead cpu, nobody else can access them. */
+static void __pcs_flush_cpu(struct kmem_cache *s, int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	if (pcs->spare) {
+		sheaf_flush(s, pcs->spare);
+		free_empty_sheaf(pcs->spare);
+		pcs->spare = NULL;
+	}
+	sheaf_flush(s, pcs->main);
+	pcs_flush_remote(s, pcs);
+}
+
+static bool pcs_has_objects(int cpu, struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+	int i;
+
+	if (pcs->main->size || pcs->spare)
+		return true;
+
+	for (i = 0; i < PCS_REMOTE_SLOTS; i++) {
+		if (data_race(pcs->remote[i].nr))
+			return true;
+	}
+	return false;
+}
+
 static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 {
 	unsigned long flags;
@@ -3119,6 +3450,9 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	}
 
 	put_partials_cpu(s, c);
+
+	if (slab_has_sheaves(s))
+		__pcs_flush_cpu(s, cpu);
 }
 
 struct slub_flush_work {
@@ -3147,12 +3481,18 @@ static void flush_cpu_slab(struct work_struct *w)
 		flush_slab(s, c);
 
 	put_partials(s);
+
+	if (slab_has_sheaves(s))
+		pcs_flush(s);
 }
 
 static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
+	if (slab_has_sheaves(s) && pcs_has_objects(cpu, s))
+		return true;
+
 	return c->slab || slub_percpu_partial(c);
 }
 
@@ -3212,6 +3552,8 @@ static int slub_cpu_dead(unsigned int cpu)
 }
 
 #else /* CONFIG_SLUB_TINY */
+static inline bool slab_has_sheaves(struct kmem_cache *s) { return false; }
+static inline void flush_barns(struct kmem_cache *s) { }
 static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
@@ -3963,6 +4305,226 @@ bool slab_post_alloc_hook(struct kmem_cache *s, struct list_lru *lru,
 	return memcg_slab_post_alloc_hook(s, lru, flags, size, p);
 }
 
+#ifndef CONFIG_SLUB_TINY
+/*
+ * Replace the empty main sheaf with a full one: the spare, one from the barn
+ * or, as the last resort, a freshly allocated and filled one. Called with
+ * the percpu sheaves locked; returns with them locked and a non-empty main
+ * sheaf, or unlocked and NULL if there are no objects to be had.
+ */
+static struct slub_percpu_sheaves *
+__pcs_refill_main(struct kmem_cache *s, struct slub_percpu_sheaves *pcs,
+		  gfp_t gfp, unsigned long *flags, struct slab_sheaf **to_flush)
+{
+	struct node_barn *barn;
+	struct slab_sheaf *full;
+
+	if (pcs->spare && pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return pcs;
+	}
+
+	barn = get_barn(s);
+	if (barn) {
+		full = barn_replace_empty_sheaf(barn, pcs->main);
+		if (full) {
+			pcs->main = full;
+			return pcs;
+		}
+	}
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, *flags);
+
+	full = __alloc_empty_sheaf(s->sheaf_capacity, gfp);
+	if (!full)
+		return NULL;
+	if (refill_sheaf(s, full, gfp)) {
+		free_empty_sheaf(full);
+		return NULL;
+	}
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, *flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+	barn = get_barn(s);
+
+	/* We might have been migrated, or raced with a free on this cpu */
+	if (!pcs->main->size) {
+		if (!pcs->spare)
+			pcs->spare = pcs->main;
+		else if (!barn || !barn_put_empty_sheaf(barn, pcs->main))
+			free_empty_sheaf(pcs->main);
+		pcs->main = full;
+	} else if (!pcs->spare) {
+		pcs->spare = full;
+	} else if (!barn || !barn_put_full_sheaf(barn, full)) {
+		*to_flush = full;
+	}
+	return pcs;
+}
+
+static void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slab_sheaf *to_flush = NULL;
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+	void *object;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(!pcs->main->size)) {
+		pcs = __pcs_refill_main(s, pcs, gfp, &flags, &to_flush);
+		if (!pcs)
+			return NULL;
+	}
+
+	object = pcs->main->objects[--pcs->main->size];
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (unlikely(to_flush)) {
+		sheaf_flush(s, to_flush);
+		free_empty_sheaf(to_flush);
+	}
+	return object;
+}
+
+/*
+ * Make room in the full main sheaf by switching to an empty sheaf. Called
+ * and returns with the percpu sheaves locked, so only non-blocking
+ * allocations are possible.
+ */
+static bool __pcs_replace_full_main(struct kmem_cache *s,
+				    struct slub_percpu_sheaves *pcs)
+{
+	struct node_barn *barn;
+	struct slab_sheaf *empty;
+
+	if (pcs->spare && !pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return true;
+	}
+
+	barn = get_barn(s);
+	if (barn) {
+		empty = barn_replace_full_sheaf(barn, pcs->main);
+		if (empty) {
+			pcs->main = empty;
+			return true;
+		}
+	}
+
+	/* Nowhere to put the full main sheaf, don't bother allocating */
+	if (pcs->spare &&
+	    (!barn || data_race(barn->nr_full) >= MAX_FULL_SHEAVES))
+		return false;
+
+	empty = __alloc_empty_sheaf(s->sheaf_capacity,
+				    GFP_NOWAIT | __GFP_NOWARN);
+	if (!empty)
+		return false;
+
+	if (!pcs->spare) {
+		pcs->spare = pcs->main;
+	} else if (!barn_put_full_sheaf(barn, pcs->main)) {
+		free_empty_sheaf(empty);
+		return false;
+	}
+	pcs->main = empty;
+	return true;
+}
+
+/*
+ * Free an object to the percpu sheaves. Returns false if the object has to
+ * be freed to its slab instead.
+ */
+static bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == s->sheaf_capacity) &&
+	    !__pcs_replace_full_main(s, pcs)) {
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+		return false;
+	}
+
+	pcs->main->objects[pcs->main->size++] = object;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+	return true;
+}
+
+/*
+ * Buffer an object whose slab belongs to another node. Once a batch for
+ * that node is complete, or its slot is needed for a different node, the
+ * batch is freed to the slabs in one go.
+ */
+static bool free_remote_to_pcs(struct kmem_cache *s, void *object, int node)
+{
+	void *batch[PCS_REMOTE_BATCH];
+	struct slub_percpu_sheaves *pcs;
+	struct pcs_remote_free *rf = NULL;
+	unsigned int nr = 0;
+	unsigned long flags;
+	int i;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	for (i = 0; i < PCS_REMOTE_SLOTS; i++) {
+		struct pcs_remote_free *slot = &pcs->remote[i];
+
+		if (slot->nr && slot->node == node) {
+			rf = slot;
+			break;
+		}
+		/* prefer an unused slot, otherwise evict the fullest one */
+		if (!rf || (rf->nr && (!slot->nr || slot->nr > rf->nr)))
+			rf = slot;
+	}
+
+	if (rf->nr && rf->node != node) {
+		nr = rf->nr;
+		memcpy(batch, rf->objects, nr * sizeof(void *));
+		rf->nr = 0;
+	}
+	rf->node = node;
+	rf->objects[rf->nr++] = object;
+
+	if (rf->nr == PCS_REMOTE_BATCH && !nr) {
+		nr = rf->nr;
+		memcpy(batch, rf->objects, nr * sizeof(void *));
+		rf->nr = 0;
+	}
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, FREE_REMOTE);
+	if (nr) {
+		__kmem_cache_free_bulk(s, nr, batch);
+		stat(s, FREE_REMOTE_FLUSH);
+	}
+	return true;
+}
+#else /* CONFIG_SLUB_TINY */
+static inline void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	return NULL;
+}
+
+static inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	return false;
+}
+
+static inline bool free_remote_to_pcs(struct kmem_cache *s, void *object,
+				      int node)
+{
+	return false;
+}
+#endif /* CONFIG_SLUB_TINY */
+
 /*
  * Inlined fastpath so that allocation functions (kmalloc, kmem_cache_alloc)
  * have the fastpath folded into their functions. So no function call
@@ -3987,7 +4549,11 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	if (slab_has_sheaves(s) &&
+	    (node == NUMA_NO_NODE || node == numa_mem_id()))
+		object = alloc_from_pcs(s, gfpflags);
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -4435,8 +5001,25 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 	memcg_slab_free_hook(s, slab, &object, 1);
 	alloc_tagging_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s))))
-		do_slab_free(s, slab, object, object, 1, addr);
+	if (unlikely(!slab_free_hook(s, object, slab_want_init_on_free(s))))
+		return;
+
+	/*
+	 * Only keep node-local objects in the percpu sheaves, remote ones are
+	 * batched per node on their way back to the slabs.
+	 */
+	if (slab_has_sheaves(s)) {
+		int node = slab_nid(slab);
+
+		if (likely(node == numa_mem_id())) {
+			if (free_to_pcs(s, object))
+				return;
+		} else if (free_remote_to_pcs(s, object, node)) {
+			return;
+		}
+	}
+
+	do_slab_free(s, slab, object, object, 1, addr);
 }
 
 #ifdef CONFIG_MEMCG_KMEM
@@ -4809,6 +5392,151 @@ int kmem_cache_alloc_bulk_noprof(struct kmem_cache *s, gfp_t flags, size_t size,
 }
 EXPORT_SYMBOL(kmem_cache_alloc_bulk_noprof);
 
+static unsigned int cache_sheaf_capacity(struct kmem_cache *s)
+{
+#ifndef CONFIG_SLUB_TINY
+	return s->sheaf_capacity;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * kmem_cache_prefill_sheaf - Preallocate objects for later allocation
+ * @s: The cache to allocate from.
+ * @gfp: GFP flags for the preallocation.
+ * @size: Minimal number of objects to preallocate.
+ *
+ * The objects are allocated with kmem_cache_alloc_from_sheaf(), which can't
+ * fail as long as fewer than @size objects are taken. Unused objects are
+ * released with kmem_cache_return_sheaf(). Works for any cache, but is
+ * cheapest for caches created with %SLAB_SHEAVES, where a full sheaf can
+ * be taken from the per node barn.
+ *
+ * Return: the prefilled sheaf or %NULL on failure.
+ */
+struct slab_sheaf *
+kmem_cache_prefill_sheaf(struct kmem_cache *s, gfp_t gfp, unsigned int size)
+{
+	unsigned int capacity = cache_sheaf_capacity(s);
+	struct slab_sheaf *sheaf = NULL;
+
+	s = slab_pre_alloc_hook(s, gfp);
+	if (unlikely(!s))
+		return NULL;
+
+#ifndef CONFIG_SLUB_TINY
+	if (slab_has_sheaves(s) && size <= capacity) {
+		struct node_barn *barn = get_barn(s);
+
+		if (barn)
+			sheaf = barn_get_full_sheaf(barn);
+		if (sheaf)
+			return sheaf;
+	}
+#endif
+
+	sheaf = __alloc_empty_sheaf(max(size, capacity), gfp);
+	if (!sheaf)
+		return NULL;
+
+	if (refill_sheaf(s, sheaf, gfp)) {
+		free_empty_sheaf(sheaf);
+		return NULL;
+	}
+	return sheaf;
+}
+
+/**
+ * kmem_cache_refill_sheaf - Make sure a prefilled sheaf holds enough objects
+ * @s: The cache the sheaf was prefilled from.
+ * @gfp: GFP flags for the preallocation.
+ * @sheafp: Pointer to the sheaf, may be replaced by a larger one.
+ * @size: Minimal number of objects the sheaf should hold.
+ *
+ * Return: 0 on success, -ENOMEM if the objects could not be allocated, in
+ * which case the original sheaf is left untouched.
+ */
+int kmem_cache_refill_sheaf(struct kmem_cache *s, gfp_t gfp,
+			    struct slab_sheaf **sheafp, unsigned int size)
+{
+	struct slab_sheaf *sheaf = *sheafp;
+
+	if (sheaf->size >= size)
+		return 0;
+
+	if (likely(size <= sheaf->capacity))
+		return refill_sheaf(s, sheaf, gfp);
+
+	sheaf = kmem_cache_prefill_sheaf(s, gfp, size);
+	if (!sheaf)
+		return -ENOMEM;
+
+	kmem_cache_return_sheaf(s, *sheafp);
+	*sheafp = sheaf;
+	return 0;
+}
+
+/**
+ * kmem_cache_return_sheaf - Release a prefilled sheaf
+ * @s: The cache the sheaf was prefilled from.
+ * @sheaf: The sheaf, with any number of unused objects.
+ *
+ * Full sheaves of the cache's own capacity are kept in the barn for later
+ * use, others are flushed back to the slabs.
+ */
+void kmem_cache_return_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+#ifndef CONFIG_SLUB_TINY
+	if (slab_has_sheaves(s) && sheaf->capacity == s->sheaf_capacity) {
+		struct node_barn *barn = get_barn(s);
+
+		if (barn && sheaf->size == sheaf->capacity &&
+		    barn_put_full_sheaf(barn, sheaf))
+			return;
+
+		sheaf_flush(s, sheaf);
+		if (barn && barn_put_empty_sheaf(barn, sheaf))
+			return;
+		free_empty_sheaf(sheaf);
+		return;
+	}
+#endif
+	sheaf_flush(s, sheaf);
+	free_empty_sheaf(sheaf);
+}
+
+/**
+ * kmem_cache_alloc_from_sheaf - Allocate an object from a prefilled sheaf
+ * @s: The cache the sheaf was prefilled from.
+ * @gfp: GFP flags, only used for the allocation hooks.
+ * @sheaf: The prefilled sheaf.
+ *
+ * Return: an object, or %NULL if the sheaf is exhausted.
+ */
+void *kmem_cache_alloc_from_sheaf_noprof(struct kmem_cache *s, gfp_t gfp,
+					 struct slab_sheaf *sheaf)
+{
+	void *ret;
+
+	if (WARN_ON_ONCE(!sheaf->size))
+		return NULL;
+
+	ret = sheaf->objects[--sheaf->size];
+
+	/* The sheaf was reserved up front, don't let memcg charging fail */
+	slab_post_alloc_hook(s, NULL, gfp | __GFP_NOFAIL, 1, &ret,
+			     slab_want_init_on_alloc(gfp, s), s->object_size);
+
+	trace_kmem_cache_alloc(_RET_IP_, ret, s, gfp, NUMA_NO_NODE);
+
+	return ret;
+}
+
+unsigned int kmem_cache_sheaf_size(struct slab_sheaf *sheaf)
+{
+	return sheaf->size;
+}
 
 /*
  * Object placement in a slab is made very easy because we always start at
@@ -4953,6 +5681,13 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	spin_lock_init(&n->barn.lock);
+	INIT_LIST_HEAD(&n->barn.sheaves_full);
+	INIT_LIST_HEAD(&n->barn.sheaves_empty);
+	n->barn.nr_full = 0;
+	n->barn.nr_empty = 0;
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -4976,11 +5711,82 @@ static inline int alloc_kmem_cache_cpus(struct kmem_cache *s)
 
 	return 1;
 }
+
+static unsigned int calculate_sheaf_capacity(struct kmem_cache *s)
+{
+	struct slab_sheaf *sheaf;
+	unsigned int capacity;
+
+	if (s->size >= PAGE_SIZE)
+		capacity = 8;
+	else if (s->size >= 1024)
+		capacity = 16;
+	else if (s->size >= 256)
+		capacity = 32;
+	else
+		capacity = 64;
+
+	/* Use up the rest of the kmalloc bucket the sheaf ends up in */
+	return (kmalloc_size_roundup(struct_size(sheaf, objects, capacity)) -
+		sizeof(*sheaf)) / sizeof(void *);
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	/* Sheaves would bypass the debugging checks done when freeing */
+	if (!(s->flags & SLAB_SHEAVES) || kmem_cache_debug(s) ||
+	    slab_state < UP)
+		return 1;
+
+	s->sheaf_capacity = calculate_sheaf_capacity(s);
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs;
+
+		pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+		local_lock_init(&pcs->lock);
+		pcs->main = __alloc_empty_sheaf(s->sheaf_capacity, GFP_KERNEL);
+		if (!pcs->main)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs;
+
+		pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+		if (pcs->spare)
+			free_empty_sheaf(pcs->spare);
+		if (pcs->main)
+			free_empty_sheaf(pcs->main);
+	}
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
 #else
 static inline int alloc_kmem_cache_cpus(struct kmem_cache *s)
 {
 	return 1;
 }
+
+static inline int init_percpu_sheaves(struct kmem_cache *s)
+{
+	return 1;
+}
 #endif /* CONFIG_SLUB_TINY */
 
 static struct kmem_cache *kmem_cache_node;
@@ -5043,6 +5849,7 @@ void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
 #ifndef CONFIG_SLUB_TINY
+	free_percpu_sheaves(s);
 	free_percpu(s->cpu_slab);
 #endif
 	free_kmem_cache_nodes(s);
@@ -5296,7 +6103,7 @@ static int kmem_cache_open(struct kmem_cache *s, slab_flags_t flags)
 	if (!init_kmem_cache_nodes(s))
 		goto error;
 
-	if (alloc_kmem_cache_cpus(s))
+	if (alloc_kmem_cache_cpus(s) && init_percpu_sheaves(s))
 		return 0;
 
 error:
@@ -5374,6 +6181,7 @@ int __kmem_cache_shutdown(struct kmem_cache *s)
 	struct kmem_cache_node *n;
 
 	flush_all_cpus_locked(s);
+	flush_barns(s);
 	/* Attempt to free all objects */
 	for_each_kmem_cache_node(s, node, n) {
 		free_partial(s, n);
@@ -5557,6 +6365,8 @@ static int __kmem_cache_do_shrink(struct kmem_cache *s)
 	unsigned long flags;
 	int ret = 0;
 
+	flush_barns(s);
+
 	for_each_kmem_cache_node(s, node, n) {
 		INIT_LIST_HEAD(&discard);
 		for (i = 0; i < SHRINK_PROMOTE_MAX; i++)
@@ -6684,6 +7494,8 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(FREE_REMOTE, free_remote);
+STAT_ATTR(FREE_REMOTE_FLUSH, free_remote_flush);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -6771,6 +7583,8 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&free_remote_attr.attr,
+	&free_remote_flush_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -290,62 +290,35 @@ static void discard_swap_cluster(struct swap_info_struct *si,
 #endif
 #define LATENCY_LIMIT		256
 
-static inline void cluster_set_flag(struct swap_cluster_info *info,
-	unsigned int flag)
-{
-	info->flags = flag;
-}
-
-static inline unsigned int cluster_count(struct swap_cluster_info *info)
-{
-	return info->data;
-}
-
-static inline void cluster_set_count(struct swap_cluster_info *info,
-				     unsigned int c)
-{
-	info->data = c;
-}
-
-static inline void cluster_set_count_flag(struct swap_cluster_info *info,
-					 unsigned int c, unsigned int f)
-{
-	info->flags = f;
-	info->data = c;
-}
-
-static inline unsigned int cluster_next(struct swap_cluster_info *info)
-{
-	return info->data;
-}
-
-static inline void cluster_set_next(struct swap_cluster_info *info,
-				    unsigned int n)
-{
-	info->data = n;
-}
-
-static inline void cluster_set_next_flag(struct swap_cluster_info *info,
-					 unsigned int n, unsigned int f)
+static inline bool cluster_is_free(struct swap_cluster_info *info)
 {
-	info->flags = f;
-	info->data = n;
+	return info->flags == CLUSTER_FLAG_FREE;
 }
 
-static inline bool cluster_is_free(struct swap_cluster_info *info)
+static inline unsigned int cluster_index(struct swap_info_struct *si,
+					 struct swap_cluster_info *ci)
 {
-	return info->flags & CLUSTER_FLAG_FREE;
+	return ci - si->cluster_info;
 }
 
-static inline bool cluster_is_null(struct swap_cluster_info *info)
+static inline unsigned int cluster_offset(struct swap_info_struct *si,
+					  struct swap_cluster_info *ci)
 {
-	return info->flags & CLUSTER_FLAG_NEXT_NULL;
+	return cluster_index(si, ci) * SWAPFILE_CLUSTER;
 }
 
-static inline void cluster_set_null(struct swap_cluster_info *info)
+/*
+ * Move the cluster to the tail of list, or off all lists if list is NULL,
+ * and record its new state. Caller holds si->lock.
+ */
+static void move_cluster(struct swap_cluster_info *ci, struct list_head *list,
+			 enum swap_cluster_flags new_flags)
 {
-	info->flags = CLUSTER_FLAG_NEXT_NULL;
-	info->data = 0;
+	if (list)
+		list_move_tail(&ci->list, list);
+	else
+		list_del_init(&ci->list);
+	ci->flags = new_flags;
 }
 
 static inline struct swap_cluster_info *lock_cluster(struct swap_info_struct *si,
@@ -394,65 +367,12 @@ static inline void unlock_cluster_or_swap_info(struct swap_info_struct *si,
 		spin_unlock(&si->lock);
 }
 
-static inline bool cluster_list_empty(struct swap_cluster_list *list)
-{
-	return cluster_is_null(&list->head);
-}
-
-static inline unsigned int cluster_list_first(struct swap_cluster_list *list)
-{
-	return cluster_next(&list->head);
-}
-
-static void cluster_list_init(struct swap_cluster_list *list)
-{
-	cluster_set_null(&list->head);
-	cluster_set_null(&list->tail);
-}
-
-static void cluster_list_add_tail(struct swap_cluster_list *list,
-				  struct swap_cluster_info *ci,
-				  unsigned int idx)
-{
-	if (cluster_list_empty(list)) {
-		cluster_set_next_flag(&list->head, idx, 0);
-		cluster_set_next_flag(&list->tail, idx, 0);
-	} else {
-		struct swap_cluster_info *ci_tail;
-		unsigned int tail = cluster_next(&list->tail);
-
-		/*
-		 * Nested cluster lock, but both cluster locks are
-		 * only acquired when we held swap_info_struct->lock
-		 */
-		ci_tail = ci + tail;
-		spin_lock_nested(&ci_tail->lock, SINGLE_DEPTH_NESTING);
-		cluster_set_next(ci_tail, idx);
-		spin_unlock(&ci_tail->lock);
-		cluster_set_next_flag(&list->tail, idx, 0);
-	}
-}
-
-static unsigned int cluster_list_del_first(struct swap_cluster_list *list,
-					   struct swap_cluster_info *ci)
-{
-	unsigned int idx;
-
-	idx = cluster_next(&list->head);
-	if (cluster_next(&list->tail) == idx) {
-		cluster_set_null(&list->head);
-		cluster_set_null(&list->tail);
-	} else
-		cluster_set_next_flag(&list->head,
-				      cluster_next(&ci[idx]), 0);
-
-	return idx;
-}
-
 /* Add a cluster to discard list and schedule it to do discard */
 static void swap_cluster_schedule_discard(struct swap_info_struct *si,
-		unsigned int idx)
+		struct swap_cluster_info *ci)
 {
+	unsigned int idx = cluster_index(si, ci);
+
 	/*
 	 * If scan_swap_map_slots() can't find a free cluster, it will check
 	 * si->swap_map directly. To make sure the discarding cluster isn't
@@ -462,17 +382,16 @@ static void swap_cluster_schedule_discard(struct swap_info_struct *si,
 	memset(si->swap_map + idx * SWAPFILE_CLUSTER,
 			SWAP_MAP_BAD, SWAPFILE_CLUSTER);
 
-	cluster_list_add_tail(&si->discard_clusters, si->cluster_info, idx);
+	move_cluster(ci, &si->discard_clusters, CLUSTER_FLAG_DISCARD);
 
 	schedule_work(&si->discard_work);
 }
 
-static void __free_cluster(struct swap_info_struct *si, unsigned long idx)
+static void __free_cluster(struct swap_info_struct *si,
+			   struct swap_cluster_info *ci)
 {
-	struct swap_cluster_info *ci = si->cluster_info;
-
-	cluster_set_flag(ci + idx, CLUSTER_FLAG_FREE);
-	cluster_list_add_tail(&si->free_clusters, ci, idx);
+	ci->order = 0;
+	move_cluster(ci, &si->free_clusters, CLUSTER_FLAG_FREE);
 }
 
 /*
@@ -481,24 +400,25 @@ static void __free_cluster(struct swap_info_struct *si, unsigned long idx)
 */
 static void swap_do_scheduled_discard(struct swap_info_struct *si)
 {
-	struct swap_cluster_info *info, *ci;
+	struct swap_cluster_info *ci;
 	unsigned int idx;
 
-	info = si->cluster_info;
-
-	while (!cluster_list_empty(&si->discard_clusters)) {
-		idx = cluster_list_del_first(&si->discard_clusters, info);
+	while (!list_empty(&si->discard_clusters)) {
+		ci = list_first_entry(&si->discard_clusters,
+				      struct swap_cluster_info, list);
+		move_cluster(ci, NULL, CLUSTER_FLAG_NONE);
+		idx = cluster_index(si, ci);
 		spin_unlock(&si->lock);
 
 		discard_swap_cluster(si, idx * SWAPFILE_CLUSTER,
 				SWAPFILE_CLUSTER);
 
 		spin_lock(&si->lock);
-		ci = lock_cluster(si, idx * SWAPFILE_CLUSTER);
-		__free_cluster(si, idx);
+		spin_lock(&ci->lock);
+		__free_cluster(si, ci);
 		memset(si->swap_map + idx * SWAPFILE_CLUSTER,
 				0, SWAPFILE_CLUSTER);
-		unlock_cluster(ci);
+		spin_unlock(&ci->lock);
 	}
 }
 
@@ -521,20 +441,10 @@ static void swap_users_ref_free(struct percpu_ref *ref)
 	complete(&si->comp);
 }
 
-static void alloc_cluster(struct swap_info_struct *si, unsigned long idx)
+static void free_cluster(struct swap_info_struct *si,
+			 struct swap_cluster_info *ci)
 {
-	struct swap_cluster_info *ci = si->cluster_info;
-
-	VM_BUG_ON(cluster_list_first(&si->free_clusters) != idx);
-	cluster_list_del_first(&si->free_clusters, ci);
-	cluster_set_count_flag(ci + idx, 0, 0);
-}
-
-static void free_cluster(struct swap_info_struct *si, unsigned long idx)
-{
-	struct swap_cluster_info *ci = si->cluster_info + idx;
-
-	VM_BUG_ON(cluster_count(ci) != 0);
+	VM_BUG_ON(ci->count != 0);
 	/*
 	 * If the swap is discardable, prepare discard the cluster
 	 * instead of free it immediately. The cluster will be freed
@@ -542,37 +452,46 @@ static void free_cluster(struct swap_info_struct *si, unsigned long idx)
 	 */
 	if ((si->flags & (SWP_WRITEOK | SWP_PAGE_DISCARD)) ==
 	    (SWP_WRITEOK | SWP_PAGE_DISCARD)) {
-		swap_cluster_schedule_discard(si, idx);
+		swap_cluster_schedule_discard(si, ci);
 		return;
 	}
 
-	__free_cluster(si, idx);
+	__free_cluster(si, ci);
 }
 
 /*
- * The cluster corresponding to page_nr will be used. The cluster will be
- * removed from free cluster list and its usage counter will be increased by
- * count.
+ * The cluster corresponding to page_nr will be used. Its usage counter is
+ * increased by count. A free cluster moves to the nonfull list of its order,
+ * and a cluster that has no free slot left is taken off the lists.
  */
 static void add_cluster_info_page(struct swap_info_struct *p,
 	struct swap_cluster_info *cluster_info, unsigned long page_nr,
 	unsigned long count)
 {
 	unsigned long idx = page_nr / SWAPFILE_CLUSTER;
+	struct swap_cluster_info *ci;
 
 	if (!cluster_info)
 		return;
-	if (cluster_is_free(&cluster_info[idx]))
-		alloc_cluster(p, idx);
 
-	VM_BUG_ON(cluster_count(&cluster_info[idx]) + count > SWAPFILE_CLUSTER);
-	cluster_set_count(&cluster_info[idx],
-		cluster_count(&cluster_info[idx]) + count);
+	ci = cluster_info + idx;
+	VM_BUG_ON(ci->count + count > SWAPFILE_CLUSTER);
+	ci->count += count;
+
+	/* Still setting up, the lists are populated afterwards */
+	if (ci->flags == CLUSTER_FLAG_NONE)
+		return;
+
+	if (ci->count == SWAPFILE_CLUSTER)
+		move_cluster(ci, NULL, CLUSTER_FLAG_FULL);
+	else if (cluster_is_free(ci))
+		move_cluster(ci, &p->nonfull_clusters[ci->order],
+			     CLUSTER_FLAG_NONFULL);
 }
 
 /*
- * The cluster corresponding to page_nr will be used. The cluster will be
- * removed from free cluster list and its usage counter will be increased by 1.
+ * The cluster corresponding to page_nr will be used. Its usage counter will
+ * be increased by 1.
  */
 static void inc_cluster_info_page(struct swap_info_struct *p,
 	struct swap_cluster_info *cluster_info, unsigned long page_nr)
@@ -583,46 +502,30 @@ static void inc_cluster_info_page(struct swap_info_struct *p,
 /*
  * The cluster corresponding to page_nr decreases one usage. If the usage
  * counter becomes 0, which means no page in the cluster is in using, we can
- * optionally discard the cluster and add it to free cluster list.
+ * optionally discard the cluster and add it to free cluster list. A full or
+ * fragmented cluster that regains a slot goes back to the nonfull list.
  */
 static void dec_cluster_info_page(struct swap_info_struct *p,
 	struct swap_cluster_info *cluster_info, unsigned long page_nr)
 {
 	unsigned long idx = page_nr / SWAPFILE_CLUSTER;
+	struct swap_cluster_info *ci;
 
 	if (!cluster_info)
 		return;
 
-	VM_BUG_ON(cluster_count(&cluster_info[idx]) == 0);
-	cluster_set_count(&cluster_info[idx],
-		cluster_count(&cluster_info[idx]) - 1);
-
-	if (cluster_count(&cluster_info[idx]) == 0)
-		free_cluster(p, idx);
-}
-
-/*
- * It's possible scan_swap_map_slots() uses a free cluster in the middle of free
- * cluster list. Avoiding such abuse to avoid list corruption.
- */
-static bool
-scan_swap_map_ssd_cluster_conflict(struct swap_info_struct *si,
-	unsigned long offset, int order)
-{
-	struct percpu_cluster *percpu_cluster;
-	bool conflict;
-
-	offset /= SWAPFILE_CLUSTER;
-	conflict = !cluster_list_empty(&si->free_clusters) &&
-		offset != cluster_list_first(&si->free_clusters) &&
-		cluster_is_free(&si->cluster_info[offset]);
+	ci = cluster_info + idx;
+	VM_BUG_ON(ci->count == 0);
+	ci->count--;
 
-	if (!conflict)
-		return false;
+	if (!ci->count) {
+		free_cluster(p, ci);
+		return;
+	}
 
-	percpu_cluster = this_cpu_ptr(si->percpu_cluster);
-	percpu_cluster->next[order] = SWAP_NEXT_INVALID;
-	return true;
+	if (ci->flags == CLUSTER_FLAG_FULL || ci->flags == CLUSTER_FLAG_FRAG)
+		move_cluster(ci, &p->nonfull_clusters[ci->order],
+			     CLUSTER_FLAG_NONFULL);
 }
 
 static inline bool swap_range_empty(char *swap_map, unsigned int start,
@@ -639,63 +542,131 @@ static inline bool swap_range_empty(char *swap_map, unsigned int start,
 }
 
 /*
- * Try to get swap entries with specified order from current cpu's swap entry
- * pool (a cluster). This might involve allocating a new cluster for current CPU
- * too.
+ * Look for a naturally aligned range of 1 << order free slots in the
+ * cluster, starting at offset. Returns the start of the range, or
+ * SWAP_NEXT_INVALID if there is none.
  */
-static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
-	unsigned long *offset, unsigned long *scan_base, int order)
+static unsigned int cluster_scan_range(struct swap_info_struct *si,
+				       struct swap_cluster_info *ci,
+				       unsigned int offset, int order)
 {
 	unsigned int nr_pages = 1 << order;
+	unsigned int end;
+
+	if (ci->count + nr_pages > SWAPFILE_CLUSTER)
+		return SWAP_NEXT_INVALID;
+
+	end = min_t(unsigned long, si->max,
+		    cluster_offset(si, ci) + SWAPFILE_CLUSTER);
+
+	spin_lock(&ci->lock);
+	while (offset + nr_pages <= end) {
+		if (swap_range_empty(si->swap_map, offset, nr_pages))
+			break;
+		offset += nr_pages;
+	}
+	spin_unlock(&ci->lock);
+
+	return offset + nr_pages <= end ? offset : SWAP_NEXT_INVALID;
+}
+
+/* The current cpu is done allocating from the cluster, hand it back */
+static void cluster_release_percpu(struct swap_info_struct *si,
+				   struct swap_cluster_info *ci)
+{
+	if (ci->flags == CLUSTER_FLAG_PERCPU)
+		move_cluster(ci, &si->nonfull_clusters[ci->order],
+			     CLUSTER_FLAG_NONFULL);
+}
+
+/*
+ * Find the offset for an allocation of 1 << order swap entries. Each cpu
+ * allocates sequentially from a cluster it owns. When that is used up, it
+ * takes a nonfull cluster of the same order or else a free cluster, so
+ * this is O(1) in the number of clusters. Nonfull clusters that have no
+ * aligned range left for their order are parked on the frag list, so they
+ * are not scanned again for it until a slot is freed. Order 0 may finally
+ * take single slots from any partially used cluster.
+ *
+ * Called with si->lock held, which still serializes every allocation and
+ * every list move on the device.  The per-cpu cluster keeps the critical
+ * section short, but the lock itself remains contended under parallel
+ * swapout; moving the lists under a lock of their own is not done here.
+ *
+ * Returns SWAP_NEXT_INVALID if nothing suitable is left.
+ */
+static unsigned int cluster_alloc_swap_entry(struct swap_info_struct *si,
+					     int order)
+{
 	struct percpu_cluster *cluster;
-	struct swap_cluster_info *ci;
-	unsigned int tmp, max;
+	struct swap_cluster_info *ci, *n;
+	unsigned int offset;
+	int o;
 
 new_cluster:
 	cluster = this_cpu_ptr(si->percpu_cluster);
-	tmp = cluster->next[order];
-	if (tmp == SWAP_NEXT_INVALID) {
-		if (!cluster_list_empty(&si->free_clusters)) {
-			tmp = cluster_next(&si->free_clusters.head) *
-					SWAPFILE_CLUSTER;
-		} else if (!cluster_list_empty(&si->discard_clusters)) {
-			/*
-			 * we don't have free cluster but have some clusters in
-			 * discarding, do discard now and reclaim them, then
-			 * reread cluster_next_cpu since we dropped si->lock
-			 */
-			swap_do_scheduled_discard(si);
-			*scan_base = this_cpu_read(*si->cluster_next_cpu);
-			*offset = *scan_base;
-			goto new_cluster;
-		} else
-			return false;
+	offset = cluster->next[order];
+	if (offset != SWAP_NEXT_INVALID) {
+		ci = si->cluster_info + offset / SWAPFILE_CLUSTER;
+		/* The cluster may have been freed and reused meanwhile */
+		if (ci->flags == CLUSTER_FLAG_PERCPU && ci->order == order) {
+			offset = cluster_scan_range(si, ci, offset, order);
+			if (offset != SWAP_NEXT_INVALID)
+				return offset;
+			cluster_release_percpu(si, ci);
+		}
+		cluster->next[order] = SWAP_NEXT_INVALID;
 	}
 
-	/*
-	 * Other CPUs can use our cluster if they can't find a free cluster,
-	 * check if there is still free entry in the cluster, maintaining
-	 * natural alignment.
-	 */
-	max = min_t(unsigned long, si->max, ALIGN(tmp + 1, SWAPFILE_CLUSTER));
-	if (tmp < max) {
-		ci = lock_cluster(si, tmp);
-		while (tmp < max) {
-			if (swap_range_empty(si->swap_map, tmp, nr_pages))
-				break;
-			tmp += nr_pages;
-		}
-		unlock_cluster(ci);
+	list_for_each_entry_safe(ci, n, &si->nonfull_clusters[order], list) {
+		offset = cluster_scan_range(si, ci, cluster_offset(si, ci), order);
+		if (offset != SWAP_NEXT_INVALID)
+			goto take;
+		move_cluster(ci, &si->frag_clusters[order], CLUSTER_FLAG_FRAG);
 	}
-	if (tmp >= max) {
-		cluster->next[order] = SWAP_NEXT_INVALID;
+
+	if (!list_empty(&si->free_clusters)) {
+		ci = list_first_entry(&si->free_clusters,
+				      struct swap_cluster_info, list);
+		ci->order = order;
+		offset = cluster_offset(si, ci);
+		goto take;
+	}
+
+	if (!list_empty(&si->discard_clusters)) {
+		/*
+		 * we don't have free cluster but have some clusters in
+		 * discarding, do discard now and reclaim them, then
+		 * recheck since we dropped si->lock
+		 */
+		swap_do_scheduled_discard(si);
 		goto new_cluster;
 	}
-	*offset = tmp;
-	*scan_base = tmp;
-	tmp += nr_pages;
-	cluster->next[order] = tmp < max ? tmp : SWAP_NEXT_INVALID;
-	return true;
+
+	if (order)
+		return SWAP_NEXT_INVALID;
+
+	for (o = 0; o < SWAP_NR_ORDERS; o++) {
+		list_for_each_entry(ci, &si->frag_clusters[o], list) {
+			offset = cluster_scan_range(si, ci,
+					cluster_offset(si, ci), 0);
+			if (offset != SWAP_NEXT_INVALID)
+				return offset;
+		}
+		if (!o)
+			continue;
+		list_for_each_entry(ci, &si->nonfull_clusters[o], list) {
+			offset = cluster_scan_range(si, ci,
+					cluster_offset(si, ci), 0);
+			if (offset != SWAP_NEXT_INVALID)
+				return offset;
+		}
+	}
+	return SWAP_NEXT_INVALID;
+
+take:
+	move_cluster(ci, NULL, CLUSTER_FLAG_PERCPU);
+	return offset;
 }
 
 static void __del_from_avail_list(struct swap_info_struct *p)
@@ -822,6 +793,46 @@ static bool swap_offset_available_and_locked(struct swap_info_struct *si,
 	return false;
 }
 
+/*
+ * Allocate up to nr ranges of 1 << order swap entries from the clusters.
+ * Caller holds si->lock.
+ */
+static int cluster_alloc_swap(struct swap_info_struct *si,
+			      unsigned char usage, int nr,
+			      swp_entry_t slots[], int order)
+{
+	unsigned int nr_pages = 1 << order;
+	struct percpu_cluster *cluster;
+	struct swap_cluster_info *ci;
+	unsigned int offset;
+	int n_ret = 0;
+
+	while (n_ret < nr) {
+		offset = cluster_alloc_swap_entry(si, order);
+		if (offset == SWAP_NEXT_INVALID)
+			break;
+
+		ci = lock_cluster(si, offset);
+		memset(si->swap_map + offset, usage, nr_pages);
+		add_cluster_info_page(si, si->cluster_info, offset, nr_pages);
+		unlock_cluster(ci);
+
+		swap_range_alloc(si, offset, nr_pages);
+		slots[n_ret++] = swp_entry(si->type, offset);
+
+		cluster = this_cpu_ptr(si->percpu_cluster);
+		offset += nr_pages;
+		if (ci->flags == CLUSTER_FLAG_PERCPU && offset % SWAPFILE_CLUSTER) {
+			cluster->next[order] = offset;
+		} else {
+			cluster_release_percpu(si, ci);
+			cluster->next[order] = SWAP_NEXT_INVALID;
+		}
+	}
+
+	return n_ret;
+}
+
 static int scan_swap_map_slots(struct swap_info_struct *si,
 			       unsigned char usage, int nr,
 			       swp_entry_t slots[], int order)
@@ -879,11 +890,19 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 
 	/* SSD algorithm */
 	if (si->cluster_info) {
-		if (!scan_swap_map_try_ssd_cluster(si, &offset, &scan_base, order)) {
-			if (order > 0)
-				goto no_page;
-			goto scan;
+		if (!(si->flags & SWP_WRITEOK))
+			goto no_page;
+		n_ret = cluster_alloc_swap(si, usage, nr, slots, order);
+		if (n_ret || order > 0) {
+			si->flags -= SWP_SCANNING;
+			return n_ret;
 		}
+		/*
+		 * Every cluster is full or being discarded. Fall back to
+		 * scanning swap_map, which can still reclaim slots only
+		 * held by the swap cache.
+		 */
+		goto scan;
 	} else if (unlikely(!si->cluster_nr--)) {
 		if (si->pages - si->inuse_pages < SWAPFILE_CLUSTER) {
 			si->cluster_nr = SWAPFILE_CLUSTER - 1;
@@ -896,7 +915,7 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 		 * If seek is expensive, start searching for new cluster from
 		 * start of partition, to minimize the span of allocated swap.
 		 * If seek is cheap, that is the SWP_SOLIDSTATE si->cluster_info
-		 * case, just handled by scan_swap_map_try_ssd_cluster() above.
+		 * case, just handled by cluster_alloc_swap() above.
 		 */
 		scan_base = offset = si->lowest_bit;
 		last_in_cluster = offset + SWAPFILE_CLUSTER - 1;
@@ -924,19 +943,6 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 	}
 
 checks:
-	if (si->cluster_info) {
-		while (scan_swap_map_ssd_cluster_conflict(si, offset, order)) {
-		/* take a break if we already got some slots */
-			if (n_ret)
-				goto done;
-			if (!scan_swap_map_try_ssd_cluster(si, &offset,
-							&scan_base, order)) {
-				if (order > 0)
-					goto no_page;
-				goto scan;
-			}
-		}
-	}
 	if (!(si->flags & SWP_WRITEOK))
 		goto no_page;
 	if (!si->highest_bit)
@@ -988,13 +994,8 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 		latency_ration = LATENCY_LIMIT;
 	}
 
-	/* try to get more slots in cluster */
-	if (si->cluster_info) {
-		if (scan_swap_map_try_ssd_cluster(si, &offset, &scan_base, order))
-			goto checks;
-		if (order > 0)
-			goto done;
-	} else if (si->cluster_nr && !si->swap_map[++offset]) {
+	/* non-ssd case, still more slots in cluster? */
+	if (!si->cluster_info && si->cluster_nr && !si->swap_map[++offset]) {
 		/* non-ssd case, still more slots in cluster? */
 		--si->cluster_nr;
 		goto checks;
@@ -1062,8 +1063,8 @@ static void swap_free_cluster(struct swap_info_struct *si, unsigned long idx)
 
 	ci = lock_cluster(si, offset);
 	memset(si->swap_map + offset, 0, SWAPFILE_CLUSTER);
-	cluster_set_count_flag(ci, 0, 0);
-	free_cluster(si, idx);
+	ci->count = 0;
+	free_cluster(si, ci);
 	unlock_cluster(ci);
 	swap_range_free(si, offset, SWAPFILE_CLUSTER);
 }
@@ -1356,6 +1357,20 @@ void swap_free(swp_entry_t entry)
 		__swap_entry_free(p, entry);
 }
 
+/*
+ * Drop one swap map reference from each of @nr contiguous entries starting
+ * at @entry, e.g. after mapping a large folio read back from them.
+ */
+void swap_free_nr(swp_entry_t entry, int nr)
+{
+	unsigned long offset = swp_offset(entry);
+	int type = swp_type(entry);
+	int i;
+
+	for (i = 0; i < nr; i++)
+		swap_free(swp_entry(type, offset + i));
+}
+
 /*
  * Called after dropping swapcache to decrease refcnt to swap entries.
  */
@@ -2961,12 +2976,17 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 	int nr_extents;
 	unsigned long nr_clusters = DIV_ROUND_UP(maxpages, SWAPFILE_CLUSTER);
 	unsigned long col = p->cluster_next / SWAPFILE_CLUSTER % SWAP_CLUSTER_COLS;
+	struct swap_cluster_info *ci;
 	unsigned long i, idx;
 
 	nr_good_pages = maxpages - 1;	/* omit header page */
 
-	cluster_list_init(&p->free_clusters);
-	cluster_list_init(&p->discard_clusters);
+	INIT_LIST_HEAD(&p->free_clusters);
+	INIT_LIST_HEAD(&p->discard_clusters);
+	for (i = 0; i < SWAP_NR_ORDERS; i++) {
+		INIT_LIST_HEAD(&p->nonfull_clusters[i]);
+		INIT_LIST_HEAD(&p->frag_clusters[i]);
+	}
 
 	for (i = 0; i < swap_header->info.nr_badpages; i++) {
 		unsigned int page_nr = swap_header->info.badpages[i];
@@ -3020,11 +3040,14 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 			idx = i * SWAP_CLUSTER_COLS + j;
 			if (idx >= nr_clusters)
 				continue;
-			if (cluster_count(&cluster_info[idx]))
-				continue;
-			cluster_set_flag(&cluster_info[idx], CLUSTER_FLAG_FREE);
-			cluster_list_add_tail(&p->free_clusters, cluster_info,
-					      idx);
+			ci = cluster_info + idx;
+			if (!ci->count)
+				__free_cluster(p, ci);
+			else if (ci->count < SWAPFILE_CLUSTER)
+				move_cluster(ci, &p->nonfull_clusters[0],
+					     CLUSTER_FLAG_NONFULL);
+			else
+				ci->flags = CLUSTER_FLAG_FULL;
 		}
 	}
 	return nr_extents;
@@ -3156,8 +3179,10 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 			goto bad_swap_unlock_inode;
 		}
 
-		for (ci = 0; ci < nr_cluster; ci++)
+		for (ci = 0; ci < nr_cluster; ci++) {
 			spin_lock_init(&((cluster_info + ci)->lock));
+			INIT_LIST_HEAD(&((cluster_info + ci)->list));
+		}
 
 		p->percpu_cluster = alloc_percpu(struct percpu_cluster);
 		if (!p->percpu_cluster) {
@@ -3422,17 +3447,60 @@ int swapcache_prepare(swp_entry_t entry)
 	return __swap_duplicate(entry, SWAP_HAS_CACHE);
 }
 
-void swapcache_clear(struct swap_info_struct *si, swp_entry_t entry)
+/*
+ * @entry: first of @nr contiguous swap entries within one swap cluster.
+ *
+ * Like swapcache_prepare(), but for a whole range: either all entries get
+ * SWAP_HAS_CACHE or, if any of them is unused, bad or already cached, none
+ * does and -ENOENT or -EEXIST is returned.
+ */
+int swapcache_prepare_nr(swp_entry_t entry, int nr)
 {
-	struct swap_cluster_info *ci;
+	struct swap_info_struct *si = swp_swap_info(entry);
 	unsigned long offset = swp_offset(entry);
-	unsigned char usage;
+	struct swap_cluster_info *ci;
+	unsigned char count;
+	int i, err = 0;
+
+	VM_WARN_ON(offset % SWAPFILE_CLUSTER + nr > SWAPFILE_CLUSTER);
 
 	ci = lock_cluster_or_swap_info(si, offset);
-	usage = __swap_entry_free_locked(si, offset, SWAP_HAS_CACHE);
+	for (i = 0; i < nr; i++) {
+		count = si->swap_map[offset + i];
+
+		if (unlikely(swap_count(count) == SWAP_MAP_BAD) ||
+		    !swap_count(count)) {
+			err = -ENOENT;
+			goto unlock_out;
+		}
+		if (count & SWAP_HAS_CACHE) {
+			err = -EEXIST;
+			goto unlock_out;
+		}
+	}
+
+	for (i = 0; i < nr; i++)
+		WRITE_ONCE(si->swap_map[offset + i],
+			   si->swap_map[offset + i] | SWAP_HAS_CACHE);
+unlock_out:
 	unlock_cluster_or_swap_info(si, ci);
-	if (!usage)
-		free_swap_slot(entry);
+	return err;
+}
+
+void swapcache_clear(struct swap_info_struct *si, swp_entry_t entry, int nr)
+{
+	struct swap_cluster_info *ci;
+	unsigned long offset = swp_offset(entry);
+	unsigned char usage;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		ci = lock_cluster_or_swap_info(si, offset + i);
+		usage = __swap_entry_free_locked(si, offset + i, SWAP_HAS_CACHE);
+		unlock_cluster_or_swap_info(si, ci);
+		if (!usage)
+			free_swap_slot(swp_entry(swp_type(entry), offset + i));
+	}
 }
 
 struct swap_info_struct *swp_swap_info(swp_entry_t entry)
@@ -72,8 +72,24 @@ static int __init set_nohugevmalloc(char *str)
 	return 0;
 }
 early_param("nohugevmalloc", set_nohugevmalloc);
+
+/*
+ * With "hugevmalloc=auto" plain PAGE_KERNEL vmalloc() allocations of at
+ * least PMD_SIZE which are served from a single node are mapped with huge
+ * pages even if the caller did not pass VM_ALLOW_HUGE_VMAP.
+ */
+static bool __ro_after_init vmap_auto_huge;
+
+static int __init set_hugevmalloc(char *str)
+{
+	if (str && !strcmp(str, "auto"))
+		vmap_auto_huge = true;
+	return 0;
+}
+early_param("hugevmalloc", set_hugevmalloc);
 #else /* CONFIG_HAVE_ARCH_HUGE_VMALLOC */
 static const bool vmap_allow_huge = false;
+static const bool vmap_auto_huge = false;
 #endif	/* CONFIG_HAVE_ARCH_HUGE_VMALLOC */
 
 bool is_vmalloc_addr(const void *x)
@@ -2108,6 +2124,27 @@ static atomic_long_t vmap_lazy_nr = ATOMIC_LONG_INIT(0);
  */
 static DEFINE_MUTEX(vmap_purge_lock);
 
+/*
+ * Small lazily-freed areas are first collected on a per-CPU list and then
+ * spilled to the per-node lazy trees in one go. That keeps the vmap_lazy_nr
+ * counter and the vn->lazy.lock out of the hot vfree() path of workloads
+ * which churn through many small areas, e.g. thread stacks.
+ *
+ * Areas sitting on a per-CPU list are not accounted in vmap_lazy_nr until
+ * they are spilled, therefore the amount of address space which may stay
+ * there is capped by VMAP_LAZY_PCPU_MAX_PAGES.
+ */
+#define VMAP_LAZY_PCPU_AREA_PAGES	16
+#define VMAP_LAZY_PCPU_MAX_PAGES	512
+
+struct vmap_lazy_pcpu {
+	spinlock_t lock;
+	struct list_head head;
+	unsigned long nr_pages;
+};
+
+static DEFINE_PER_CPU(struct vmap_lazy_pcpu, vmap_lazy_pcpu);
+
 /* for per-CPU blocks */
 static void purge_fragmented_blocks_allcpus(void);
 static cpumask_t purge_nodes;
@@ -2221,6 +2258,69 @@ static void purge_vmap_node(struct work_struct *work)
 	reclaim_list_global(&local_list);
 }
 
+static void lazy_add_vmap_area(struct vmap_area *va, unsigned long nr_lazy)
+{
+	unsigned long va_start = va->va_start;
+	unsigned int vn_id = decode_vn_id(va->flags);
+	struct vmap_node *vn;
+
+	/*
+	 * If it was request by a certain node we would like to
+	 * return it to that node, i.e. its pool for later reuse.
+	 */
+	vn = is_vn_id_valid(vn_id) ?
+		id_to_node(vn_id):addr_to_node(va->va_start);
+
+	spin_lock(&vn->lazy.lock);
+	insert_vmap_area(va, &vn->lazy.root, &vn->lazy.head);
+	spin_unlock(&vn->lazy.lock);
+
+	trace_free_vmap_area_noflush(va_start, nr_lazy, lazy_max_pages());
+}
+
+/*
+ * Hand the areas detached from a per-CPU list over to the nodes. Returns
+ * the updated number of lazily-freed pages.
+ */
+static unsigned long
+spill_lazy_list(struct list_head *head, unsigned long nr_pages)
+{
+	struct vmap_area *va, *n_va;
+	unsigned long nr_lazy;
+
+	nr_lazy = atomic_long_add_return(nr_pages, &vmap_lazy_nr);
+
+	list_for_each_entry_safe(va, n_va, head, list) {
+		list_del_init(&va->list);
+		lazy_add_vmap_area(va, nr_lazy);
+	}
+
+	return nr_lazy;
+}
+
+static void drain_lazy_pcpu_lists(void)
+{
+	struct vmap_lazy_pcpu *lp;
+	unsigned long nr_pages;
+	LIST_HEAD(local_list);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		lp = &per_cpu(vmap_lazy_pcpu, cpu);
+
+		if (!READ_ONCE(lp->nr_pages))
+			continue;
+
+		spin_lock(&lp->lock);
+		list_replace_init(&lp->head, &local_list);
+		nr_pages = lp->nr_pages;
+		WRITE_ONCE(lp->nr_pages, 0);
+		spin_unlock(&lp->lock);
+
+		spill_lazy_list(&local_list, nr_pages);
+	}
+}
+
 /*
  * Purges all lazily-freed vmap areas.
  */
@@ -2235,6 +2335,12 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 
 	lockdep_assert_held(&vmap_purge_lock);
 
+	/*
+	 * Move whatever is cached on the per-CPU lists to the nodes, so
+	 * it is covered by the TLB flush below.
+	 */
+	drain_lazy_pcpu_lists();
+
 	/*
 	 * Use cpumask to mark which node has to be processed.
 	 */
@@ -2331,30 +2437,41 @@ static void drain_vmap_area_work(struct work_struct *work)
  */
 static void free_vmap_area_noflush(struct vmap_area *va)
 {
+	unsigned long nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
 	unsigned long nr_lazy_max = lazy_max_pages();
-	unsigned long va_start = va->va_start;
-	unsigned int vn_id = decode_vn_id(va->flags);
-	struct vmap_node *vn;
+	struct vmap_lazy_pcpu *lp;
 	unsigned long nr_lazy;
+	LIST_HEAD(local_list);
 
 	if (WARN_ON_ONCE(!list_empty(&va->list)))
 		return;
 
-	nr_lazy = atomic_long_add_return((va->va_end - va->va_start) >>
-				PAGE_SHIFT, &vmap_lazy_nr);
+	if (nr <= VMAP_LAZY_PCPU_AREA_PAGES) {
+		/*
+		 * The lock protects the list, so it does not matter if
+		 * we migrate to another CPU once the pointer is taken.
+		 */
+		lp = raw_cpu_ptr(&vmap_lazy_pcpu);
 
-	/*
-	 * If it was request by a certain node we would like to
-	 * return it to that node, i.e. its pool for later reuse.
-	 */
-	vn = is_vn_id_valid(vn_id) ?
-		id_to_node(vn_id):addr_to_node(va->va_start);
+		spin_lock(&lp->lock);
+		list_add_tail(&va->list, &lp->head);
+		WRITE_ONCE(lp->nr_pages, lp->nr_pages + nr);
 
-	spin_lock(&vn->lazy.lock);
-	insert_vmap_area(va, &vn->lazy.root, &vn->lazy.head);
-	spin_unlock(&vn->lazy.lock);
+		if (lp->nr_pages < VMAP_LAZY_PCPU_MAX_PAGES) {
+			spin_unlock(&lp->lock);
+			return;
+		}
+
+		list_replace_init(&lp->head, &local_list);
+		nr = lp->nr_pages;
+		WRITE_ONCE(lp->nr_pages, 0);
+		spin_unlock(&lp->lock);
 
-	trace_free_vmap_area_noflush(va_start, nr_lazy, nr_lazy_max);
+		nr_lazy = spill_lazy_list(&local_list, nr);
+	} else {
+		nr_lazy = atomic_long_add_return(nr, &vmap_lazy_nr);
+		lazy_add_vmap_area(va, nr_lazy);
+	}
 
 	/* After this point, we may free va at any time */
 	if (unlikely(nr_lazy > nr_lazy_max))
@@ -3716,6 +3833,37 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 	return NULL;
 }
 
+/*
+ * Callers which do not ask for huge mappings explicitly may still get them
+ * when "hugevmalloc=auto" is set, but only with no special vm_flags,
+ * PAGE_KERNEL protection and the default range.  On NUMA machines the
+ * caller must also name a node (vmalloc_node() and friends): the pages are
+ * then allocated with that node preferred, but may still fall back to
+ * others like any page allocation.  NUMA_NO_NODE allocations would have
+ * the size split across all online nodes, see __vmalloc_node_range(), so
+ * they keep using small pages there.
+ */
+static bool vmap_use_huge(unsigned long size, unsigned long start,
+		unsigned long end, pgprot_t prot, unsigned long vm_flags, int node)
+{
+	if (!vmap_allow_huge)
+		return false;
+
+	if (vm_flags & VM_ALLOW_HUGE_VMAP)
+		return true;
+
+	if (!vmap_auto_huge || vm_flags)
+		return false;
+
+	if (size < PMD_SIZE || pgprot_val(prot) != pgprot_val(PAGE_KERNEL))
+		return false;
+
+	if (start != VMALLOC_START || end != VMALLOC_END)
+		return false;
+
+	return node != NUMA_NO_NODE || num_online_nodes() == 1;
+}
+
 /**
  * __vmalloc_node_range - allocate virtually contiguous memory
  * @size:		  allocation size
@@ -3766,7 +3914,7 @@ void *__vmalloc_node_range_noprof(unsigned long size, unsigned long align,
 		return NULL;
 	}
 
-	if (vmap_allow_huge && (vm_flags & VM_ALLOW_HUGE_VMAP)) {
+	if (vmap_use_huge(size, start, end, prot, vm_flags, node)) {
 		unsigned long size_per_node;
 
 		/*
@@ -5098,6 +5246,7 @@ void __init vmalloc_init(void)
 
 	for_each_possible_cpu(i) {
 		struct vmap_block_queue *vbq;
+		struct vmap_lazy_pcpu *lp;
 		struct vfree_deferred *p;
 
 		vbq = &per_cpu(vmap_block_queue, i);
@@ -5107,6 +5256,10 @@ void __init vmalloc_init(void)
 		init_llist_head(&p->list);
 		INIT_WORK(&p->wq, delayed_vfree_work);
 		xa_init(&vbq->vmap_blocks);
+
+		lp = &per_cpu(vmap_lazy_pcpu, i);
+		spin_lock_init(&lp->lock);
+		INIT_LIST_HEAD(&lp->head);
 	}
 
 	/*
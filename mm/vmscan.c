@@ -1101,7 +1101,9 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 		 *    not marked for immediate reclaim, or the caller does not
 		 *    have __GFP_FS (or __GFP_IO if it's simply going to swap,
 		 *    not to fs). In this case mark the folio for immediate
-		 *    reclaim and continue scanning.
+		 *    reclaim and continue scanning. The same applies when
+		 *    the folio's writeback is not guaranteed to complete,
+		 *    e.g. when it waits on a userspace FUSE server.
 		 *
 		 *    Require may_enter_fs() because we would wait on fs, which
 		 *    may not have submitted I/O yet. And the loop driver might
@@ -1126,6 +1128,8 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 		 * takes to write them to disk.
 		 */
 		if (folio_test_writeback(folio)) {
+			mapping = folio_mapping(folio);
+
 			/* Case 1 above */
 			if (current_is_kswapd() &&
 			    folio_test_reclaim(folio) &&
@@ -1136,7 +1140,9 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 			/* Case 2 above */
 			} else if (writeback_throttling_sane(sc) ||
 			    !folio_test_reclaim(folio) ||
-			    !may_enter_fs(folio, sc->gfp_mask)) {
+			    !may_enter_fs(folio, sc->gfp_mask) ||
+			    (mapping &&
+			     mapping_writeback_indeterminate(mapping))) {
 				/*
 				 * This is slightly racy -
 				 * folio_end_writeback() might have
@@ -3774,6 +3780,20 @@ static bool try_to_inc_min_seq(struct lruvec *lruvec, bool can_swap)
 	return success;
 }
 
+static void decay_refault_dist(struct lruvec *lruvec)
+{
+	int type, dist;
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+
+	for (type = 0; type < ANON_AND_FILE; type++) {
+		for (dist = 0; dist < NR_REFAULT_DISTS; dist++) {
+			atomic_long_t *n = &lrugen->refault_dist[type][dist];
+
+			atomic_long_set(n, atomic_long_read(n) / 2);
+		}
+	}
+}
+
 static bool inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 			bool can_swap, bool force_scan)
 {
@@ -3833,6 +3853,8 @@ static bool inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 	for (type = 0; type < ANON_AND_FILE; type++)
 		reset_ctrl_pos(lruvec, type, false);
 
+	decay_refault_dist(lruvec);
+
 	WRITE_ONCE(lrugen->timestamps[next], jiffies);
 	/* make sure preceding modifications appear */
 	smp_store_release(&lrugen->max_seq, lrugen->max_seq + 1);
@@ -4193,6 +4215,9 @@ void lru_gen_offline_memcg(struct mem_cgroup *memcg)
 {
 	int nid;
 
+	WRITE_ONCE(memcg->lru_gen_aging_ms, 0);
+	cancel_delayed_work_sync(&memcg->lru_gen_aging_work);
+
 	for_each_node(nid) {
 		struct lruvec *lruvec = get_lruvec(memcg, nid);
 
@@ -4235,6 +4260,167 @@ void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid)
 		lru_gen_rotate_memcg(lruvec, MEMCG_LRU_HEAD);
 }
 
+/*
+ * A refault at distance d would have been avoided by keeping d+1 more
+ * generations. Returns the number of extra generations needed to cover 15/16
+ * of the recent refaults, or 0 if there are too few of them to matter.
+ */
+static int get_hot_dist(struct lruvec *lruvec, int type)
+{
+	int dist;
+	unsigned long sum = 0;
+	unsigned long total = 0;
+	unsigned long n[NR_REFAULT_DISTS];
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+
+	for (dist = 0; dist < NR_REFAULT_DISTS; dist++) {
+		n[dist] = atomic_long_read(&lrugen->refault_dist[type][dist]);
+		total += n[dist];
+	}
+
+	if (total < MIN_LRU_BATCH)
+		return 0;
+
+	for (dist = 0; dist < NR_REFAULT_DISTS - 1; dist++) {
+		sum += n[dist];
+		if (sum * 16 >= total * 15)
+			break;
+	}
+
+	return dist + 1;
+}
+
+/*
+ * The working set of an lruvec is everything resident in its generations plus
+ * the evicted folios which refaults show should have been kept. Without such
+ * refaults, the oldest generation is considered cold.
+ */
+static unsigned long lruvec_wss(struct lruvec *lruvec)
+{
+	int type, zone;
+	unsigned long wss = 0;
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+	DEFINE_MAX_SEQ(lruvec);
+	DEFINE_MIN_SEQ(lruvec);
+
+	for (type = 0; type < ANON_AND_FILE; type++) {
+		int dist;
+		unsigned long seq = min_seq[type];
+		int hot_dist = get_hot_dist(lruvec, type);
+
+		if (!hot_dist)
+			seq++;
+
+		for (; seq <= max_seq; seq++) {
+			int gen = lru_gen_from_seq(seq);
+
+			for (zone = 0; zone < MAX_NR_ZONES; zone++)
+				wss += max(READ_ONCE(lrugen->nr_pages[gen][type][zone]), 0L);
+		}
+
+		for (dist = 0; dist < hot_dist; dist++)
+			wss += atomic_long_read(&lrugen->refault_dist[type][dist]);
+	}
+
+	return wss;
+}
+
+unsigned long lru_gen_memcg_wss(struct mem_cgroup *memcg)
+{
+	int nid;
+	unsigned long wss = 0;
+
+	/* without the multi-gen LRU, everything is considered hot */
+	if (!lru_gen_enabled())
+		return page_counter_read(&memcg->memory);
+
+	for_each_node_state(nid, N_MEMORY)
+		wss += lruvec_wss(get_lruvec(memcg, nid));
+
+	return wss;
+}
+
+static void lru_gen_age_lruvec(struct lruvec *lruvec, struct scan_control *sc,
+			       unsigned long interval)
+{
+	int gen;
+	bool can_swap = get_swappiness(lruvec, sc);
+	DEFINE_MAX_SEQ(lruvec);
+	DEFINE_MIN_SEQ(lruvec);
+
+	/* the youngest generation is not old enough yet */
+	gen = lru_gen_from_seq(max_seq);
+	if (time_is_after_jiffies(READ_ONCE(lruvec->lrugen.timestamps[gen]) + interval))
+		return;
+
+	/* leave it to the eviction if it's out of room for a new generation */
+	if (min_seq[!can_swap] + MAX_NR_GENS - 1 <= max_seq)
+		return;
+
+	try_to_inc_max_seq(lruvec, max_seq, can_swap, false);
+}
+
+/*
+ * Proactive aging creates a new generation every interval for each lruvec of
+ * this memcg, so that cold memory is sorted into the oldest generations before
+ * reclaim has to look for it. Together with lru_gen_memcg_wss(), it allows
+ * userspace to reclaim the difference through memory.reclaim.
+ */
+static void lru_gen_aging_workfn(struct work_struct *work)
+{
+	int nid;
+	unsigned int flags;
+	struct blk_plug plug;
+	struct mem_cgroup *memcg = container_of(to_delayed_work(work),
+						struct mem_cgroup, lru_gen_aging_work);
+	unsigned long interval = msecs_to_jiffies(READ_ONCE(memcg->lru_gen_aging_ms));
+	struct scan_control sc = {
+		.may_writepage = true,
+		.may_unmap = true,
+		.may_swap = true,
+		.reclaim_idx = MAX_NR_ZONES - 1,
+		.gfp_mask = GFP_KERNEL,
+	};
+
+	if (!interval)
+		return;
+
+	if (lru_gen_enabled()) {
+		set_task_reclaim_state(current, &sc.reclaim_state);
+		flags = memalloc_noreclaim_save();
+		blk_start_plug(&plug);
+
+		for_each_node_state(nid, N_MEMORY) {
+			lru_gen_age_lruvec(get_lruvec(memcg, nid), &sc, interval);
+			cond_resched();
+		}
+
+		clear_mm_walk();
+		blk_finish_plug(&plug);
+		memalloc_noreclaim_restore(flags);
+		set_task_reclaim_state(current, NULL);
+	}
+
+	queue_delayed_work(system_unbound_wq, &memcg->lru_gen_aging_work, interval);
+}
+
+int lru_gen_set_aging_interval(struct mem_cgroup *memcg, unsigned int msecs)
+{
+	/* don't let the aging become a busy loop */
+	if (msecs && msecs < MSEC_PER_SEC / 10)
+		return -EINVAL;
+
+	WRITE_ONCE(memcg->lru_gen_aging_ms, msecs);
+
+	if (msecs)
+		mod_delayed_work(system_unbound_wq, &memcg->lru_gen_aging_work,
+				 msecs_to_jiffies(msecs));
+	else
+		cancel_delayed_work_sync(&memcg->lru_gen_aging_work);
+
+	return 0;
+}
+
 #endif /* CONFIG_MEMCG */
 
 /******************************************************************************
@@ -5584,6 +5770,8 @@ void lru_gen_init_memcg(struct mem_cgroup *memcg)
 {
 	struct lru_gen_mm_list *mm_list = get_mm_list(memcg);
 
+	INIT_DELAYED_WORK(&memcg->lru_gen_aging_work, lru_gen_aging_workfn);
+
 	if (!mm_list)
 		return;
 
@@ -1390,6 +1390,8 @@ const char * const vmstat_text[] = {
 	"nr_tlb_local_flush_all",
 	"nr_tlb_local_flush_one",
 #endif /* CONFIG_DEBUG_TLBFLUSH */
+	"unmap_tlb_flush",
+	"unmap_tlb_flush_saved",
 
 #ifdef CONFIG_SWAP
 	"swap_ra",
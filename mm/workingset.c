@@ -283,6 +283,7 @@ static void lru_gen_refault(struct folio *folio, void *shadow)
 	int hist, tier, refs;
 	bool workingset;
 	unsigned long token;
+	unsigned long dist;
 	struct lruvec *lruvec;
 	struct lru_gen_folio *lrugen;
 	int type = folio_is_file_lru(folio);
@@ -296,11 +297,17 @@ static void lru_gen_refault(struct folio *folio, void *shadow)
 
 	mod_lruvec_state(lruvec, WORKINGSET_REFAULT_BASE + type, delta);
 
+	lrugen = &lruvec->lrugen;
+
+	/* the number of generations evicted since this folio was */
+	dist = (READ_ONCE(lrugen->min_seq[type]) - (token >> LRU_REFS_WIDTH)) &
+	       (EVICTION_MASK >> LRU_REFS_WIDTH);
+	dist = min_t(unsigned long, dist, NR_REFAULT_DISTS - 1);
+	atomic_long_add(delta, &lrugen->refault_dist[type][dist]);
+
 	if (!recent)
 		goto unlock;
 
-	lrugen = &lruvec->lrugen;
-
 	hist = lru_hist_from_seq(READ_ONCE(lrugen->min_seq[type]));
 	/* see the comment in folio_lru_refs() */
 	refs = (token & (BIT(LRU_REFS_WIDTH) - 1)) + workingset;
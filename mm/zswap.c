@@ -140,11 +140,22 @@ bool is_zswap_enabled(void)
 * data structures
 **********************************/
 
+/*
+ * Asynchronous compressors, e.g. hardware accelerators, can work on several
+ * requests at the same time. zswap_store() submits the pages of a large folio
+ * to them in batches of up to this many requests.
+ */
+#define ZSWAP_MAX_BATCH_SIZE	8U
+
 struct crypto_acomp_ctx {
 	struct crypto_acomp *acomp;
-	struct acomp_req *req;
-	struct crypto_wait wait;
-	u8 *buffer;
+	/* the first request is also used for decompression */
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE];
+	struct crypto_wait waits[ZSWAP_MAX_BATCH_SIZE];
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist inputs[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist outputs[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int nr_reqs;
 	struct mutex mutex;
 	bool is_sleepable;
 };
@@ -832,54 +843,80 @@ static void zswap_entry_free(struct zswap_entry *entry)
 /*********************************
 * compressed storage functions
 **********************************/
+static void zswap_acomp_ctx_free(struct crypto_acomp_ctx *acomp_ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZSWAP_MAX_BATCH_SIZE; i++) {
+		if (!IS_ERR_OR_NULL(acomp_ctx->reqs[i]))
+			acomp_request_free(acomp_ctx->reqs[i]);
+		acomp_ctx->reqs[i] = NULL;
+		kfree(acomp_ctx->buffers[i]);
+		acomp_ctx->buffers[i] = NULL;
+	}
+
+	if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
+		crypto_free_acomp(acomp_ctx->acomp);
+	acomp_ctx->acomp = NULL;
+}
+
 static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
 	struct crypto_acomp *acomp;
 	struct acomp_req *req;
+	unsigned int i;
 	int ret;
 
 	mutex_init(&acomp_ctx->mutex);
 
-	acomp_ctx->buffer = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL, cpu_to_node(cpu));
-	if (!acomp_ctx->buffer)
-		return -ENOMEM;
-
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
 				pool->tfm_name, PTR_ERR(acomp));
-		ret = PTR_ERR(acomp);
-		goto acomp_fail;
+		return PTR_ERR(acomp);
 	}
 	acomp_ctx->acomp = acomp;
 	acomp_ctx->is_sleepable = acomp_is_async(acomp);
 
-	req = acomp_request_alloc(acomp_ctx->acomp);
-	if (!req) {
-		pr_err("could not alloc crypto acomp_request %s\n",
-		       pool->tfm_name);
-		ret = -ENOMEM;
-		goto req_fail;
-	}
-	acomp_ctx->req = req;
-
-	crypto_init_wait(&acomp_ctx->wait);
 	/*
-	 * if the backend of acomp is async zip, crypto_req_done() will wakeup
-	 * crypto_wait_req(); if the backend of acomp is scomp, the callback
-	 * won't be called, crypto_wait_req() will return without blocking.
+	 * Synchronous compressors complete every request before returning,
+	 * so more than one request would only cost memory.
 	 */
-	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
-				   crypto_req_done, &acomp_ctx->wait);
+	acomp_ctx->nr_reqs = acomp_is_async(acomp) ? ZSWAP_MAX_BATCH_SIZE : 1;
+
+	for (i = 0; i < acomp_ctx->nr_reqs; i++) {
+		acomp_ctx->buffers[i] = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL,
+						     cpu_to_node(cpu));
+		if (!acomp_ctx->buffers[i]) {
+			ret = -ENOMEM;
+			goto fail;
+		}
+
+		req = acomp_request_alloc(acomp_ctx->acomp);
+		if (!req) {
+			pr_err("could not alloc crypto acomp_request %s\n",
+			       pool->tfm_name);
+			ret = -ENOMEM;
+			goto fail;
+		}
+		acomp_ctx->reqs[i] = req;
+
+		crypto_init_wait(&acomp_ctx->waits[i]);
+		/*
+		 * if the backend of acomp is async zip, crypto_req_done() will wakeup
+		 * crypto_wait_req(); if the backend of acomp is scomp, the callback
+		 * won't be called, crypto_wait_req() will return without blocking.
+		 */
+		acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   crypto_req_done, &acomp_ctx->waits[i]);
+	}
 
 	return 0;
 
-req_fail:
-	crypto_free_acomp(acomp_ctx->acomp);
-acomp_fail:
-	kfree(acomp_ctx->buffer);
+fail:
+	zswap_acomp_ctx_free(acomp_ctx);
 	return ret;
 }
 
@@ -888,69 +925,33 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
 
-	if (!IS_ERR_OR_NULL(acomp_ctx)) {
-		if (!IS_ERR_OR_NULL(acomp_ctx->req))
-			acomp_request_free(acomp_ctx->req);
-		if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
-			crypto_free_acomp(acomp_ctx->acomp);
-		kfree(acomp_ctx->buffer);
-	}
+	if (!IS_ERR_OR_NULL(acomp_ctx))
+		zswap_acomp_ctx_free(acomp_ctx);
 
 	return 0;
 }
 
-static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
+static bool zswap_store_compressed(struct zswap_entry *entry, u8 *dst,
+				   unsigned int dlen)
 {
-	struct crypto_acomp_ctx *acomp_ctx;
-	struct scatterlist input, output;
-	int comp_ret = 0, alloc_ret = 0;
-	unsigned int dlen = PAGE_SIZE;
 	unsigned long handle;
 	struct zpool *zpool;
 	char *buf;
 	gfp_t gfp;
-	u8 *dst;
-
-	acomp_ctx = raw_cpu_ptr(entry->pool->acomp_ctx);
-
-	mutex_lock(&acomp_ctx->mutex);
-
-	dst = acomp_ctx->buffer;
-	sg_init_table(&input, 1);
-	sg_set_page(&input, &folio->page, PAGE_SIZE, 0);
-
-	/*
-	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
-	 * and hardware-accelerators may won't check the dst buffer size, so
-	 * giving the dst buffer with enough length to avoid buffer overflow.
-	 */
-	sg_init_one(&output, dst, PAGE_SIZE * 2);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, dlen);
-
-	/*
-	 * it maybe looks a little bit silly that we send an asynchronous request,
-	 * then wait for its completion synchronously. This makes the process look
-	 * synchronous in fact.
-	 * Theoretically, acomp supports users send multiple acomp requests in one
-	 * acomp instance, then get those requests done simultaneously. but in this
-	 * case, zswap actually does store and load page by page, there is no
-	 * existing method to send the second page before the first page is done
-	 * in one thread doing zwap.
-	 * but in different threads running on different cpu, we have different
-	 * acomp instance, so multiple threads can do (de)compression in parallel.
-	 */
-	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
-	if (comp_ret)
-		goto unlock;
+	int ret;
 
 	zpool = zswap_find_zpool(entry);
 	gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
 	if (zpool_malloc_support_movable(zpool))
 		gfp |= __GFP_HIGHMEM | __GFP_MOVABLE;
-	alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
-	if (alloc_ret)
-		goto unlock;
+	ret = zpool_malloc(zpool, dlen, gfp, &handle);
+	if (ret) {
+		if (ret == -ENOSPC)
+			zswap_reject_compress_poor++;
+		else
+			zswap_reject_alloc_fail++;
+		return false;
+	}
 
 	buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
 	memcpy(buf, dst, dlen);
@@ -959,16 +960,86 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	entry->handle = handle;
 	entry->length = dlen;
 
-unlock:
-	if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
-		zswap_reject_compress_poor++;
-	else if (comp_ret)
-		zswap_reject_compress_fail++;
-	else if (alloc_ret)
-		zswap_reject_alloc_fail++;
+	return true;
+}
+
+/*
+ * Compress @nr pages into the given entries, which must have their pool
+ * set. Either all of them are stored, or none is and false is returned.
+ */
+static bool zswap_compress(struct page **pages, struct zswap_entry **entries,
+			   unsigned int nr, struct zswap_pool *pool)
+{
+	struct crypto_acomp_ctx *acomp_ctx;
+	int comp_ret[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int start, batch, i;
+	unsigned int nr_stored = 0;
+	bool ret = true;
+
+	acomp_ctx = raw_cpu_ptr(pool->acomp_ctx);
+
+	mutex_lock(&acomp_ctx->mutex);
+
+	for (start = 0; ret && start < nr; start += batch) {
+		batch = min(nr - start, acomp_ctx->nr_reqs);
+
+		for (i = 0; i < batch; i++) {
+			struct acomp_req *req = acomp_ctx->reqs[i];
+
+			sg_init_table(&acomp_ctx->inputs[i], 1);
+			sg_set_page(&acomp_ctx->inputs[i], pages[start + i], PAGE_SIZE, 0);
+
+			/*
+			 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
+			 * and hardware-accelerators may won't check the dst buffer size, so
+			 * giving the dst buffer with enough length to avoid buffer overflow.
+			 */
+			sg_init_one(&acomp_ctx->outputs[i], acomp_ctx->buffers[i], PAGE_SIZE * 2);
+			acomp_request_set_params(req, &acomp_ctx->inputs[i],
+						 &acomp_ctx->outputs[i], PAGE_SIZE, PAGE_SIZE);
+
+			comp_ret[i] = crypto_acomp_compress(req);
+		}
+
+		/*
+		 * All requests of the batch have been submitted, so an
+		 * asynchronous compressor can work on them in parallel. The
+		 * synchronous ones are done already and won't block here.
+		 */
+		for (i = 0; i < batch; i++)
+			comp_ret[i] = crypto_wait_req(comp_ret[i], &acomp_ctx->waits[i]);
+
+		for (i = 0; i < batch; i++) {
+			if (comp_ret[i]) {
+				if (comp_ret[i] == -ENOSPC)
+					zswap_reject_compress_poor++;
+				else
+					zswap_reject_compress_fail++;
+				ret = false;
+				break;
+			}
+
+			if (!zswap_store_compressed(entries[start + i],
+						    acomp_ctx->buffers[i],
+						    acomp_ctx->reqs[i]->dlen)) {
+				ret = false;
+				break;
+			}
+
+			nr_stored++;
+		}
+	}
 
 	mutex_unlock(&acomp_ctx->mutex);
-	return comp_ret == 0 && alloc_ret == 0;
+
+	if (!ret) {
+		for (i = 0; i < nr_stored; i++) {
+			zpool_free(zswap_find_zpool(entries[i]), entries[i]->handle);
+			entries[i]->length = 0;
+		}
+	}
+
+	return ret;
 }
 
 static void zswap_decompress(struct zswap_entry *entry, struct page *page)
@@ -993,20 +1064,21 @@ static void zswap_decompress(struct zswap_entry *entry, struct page *page)
 	 */
 	if ((acomp_ctx->is_sleepable && !zpool_can_sleep_mapped(zpool)) ||
 	    !virt_addr_valid(src)) {
-		memcpy(acomp_ctx->buffer, src, entry->length);
-		src = acomp_ctx->buffer;
+		memcpy(acomp_ctx->buffers[0], src, entry->length);
+		src = acomp_ctx->buffers[0];
 		zpool_unmap_handle(zpool, entry->handle);
 	}
 
 	sg_init_one(&input, src, entry->length);
 	sg_init_table(&output, 1);
 	sg_set_page(&output, page, PAGE_SIZE, 0);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, PAGE_SIZE);
-	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait));
-	BUG_ON(acomp_ctx->req->dlen != PAGE_SIZE);
+	acomp_request_set_params(acomp_ctx->reqs[0], &input, &output, entry->length, PAGE_SIZE);
+	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->reqs[0]),
+			       &acomp_ctx->waits[0]));
+	BUG_ON(acomp_ctx->reqs[0]->dlen != PAGE_SIZE);
 	mutex_unlock(&acomp_ctx->mutex);
 
-	if (src != acomp_ctx->buffer)
+	if (src != acomp_ctx->buffers[0])
 		zpool_unmap_handle(zpool, entry->handle);
 }
 
@@ -1373,14 +1445,14 @@ static void shrink_worker(struct work_struct *w)
 /*********************************
 * same-filled functions
 **********************************/
-static bool zswap_is_folio_same_filled(struct folio *folio, unsigned long *value)
+static bool zswap_is_page_same_filled(struct page *subpage, unsigned long *value)
 {
 	unsigned long *page;
 	unsigned long val;
 	unsigned int pos, last_pos = PAGE_SIZE / sizeof(*page) - 1;
 	bool ret = false;
 
-	page = kmap_local_folio(folio, 0);
+	page = kmap_local_page(subpage);
 	val = page[0];
 
 	if (val != page[last_pos])
@@ -1409,23 +1481,134 @@ static void zswap_fill_page(void *ptr, unsigned long value)
 /*********************************
 * main API
 **********************************/
+/*
+ * Store @nr pages of @folio, starting at @index. Returns false if any of
+ * them could not be stored; the caller then has to invalidate the whole
+ * range, including the entries which made it into the tree.
+ */
+static bool zswap_store_pages(struct folio *folio, long index, unsigned int nr,
+			      struct obj_cgroup *objcg, struct zswap_pool *pool)
+{
+	struct zswap_entry *entries[ZSWAP_MAX_BATCH_SIZE];
+	struct zswap_entry *to_compress[ZSWAP_MAX_BATCH_SIZE];
+	struct page *pages[ZSWAP_MAX_BATCH_SIZE];
+	swp_entry_t swp = folio->swap;
+	pgoff_t offset = swp_offset(swp) + index;
+	struct xarray *tree = swap_zswap_tree(swp);
+	unsigned int i, nr_compress = 0;
+	struct zswap_entry *entry, *old;
+	unsigned long value;
+
+	for (i = 0; i < nr; i++) {
+		struct page *page = folio_page(folio, index + i);
+
+		entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
+		if (!entry) {
+			zswap_reject_kmemcache_fail++;
+			goto free_entries;
+		}
+		entries[i] = entry;
+
+		if (zswap_is_page_same_filled(page, &value)) {
+			entry->pool = NULL;
+			entry->length = 0;
+			entry->value = value;
+		} else {
+			entry->pool = pool;
+			pages[nr_compress] = page;
+			to_compress[nr_compress++] = entry;
+		}
+	}
+
+	if (nr_compress && !zswap_compress(pages, to_compress, nr_compress, pool))
+		goto free_entries;
+
+	/* From here on the entries are complete and only zswap_entry_free() them */
+	for (i = 0; i < nr; i++) {
+		entry = entries[i];
+		entry->swpentry = swp_entry(swp_type(swp), offset + i);
+		entry->objcg = objcg;
+		INIT_LIST_HEAD(&entry->lru);
+
+		if (entry->length)
+			percpu_ref_get(&pool->ref);
+		else
+			atomic_inc(&zswap_same_filled_pages);
+
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+		}
+		atomic_inc(&zswap_stored_pages);
+	}
+
+	for (i = 0; i < nr; i++) {
+		old = xa_store(tree, offset + i, entries[i], GFP_KERNEL);
+		if (xa_is_err(old)) {
+			int err = xa_err(old);
+
+			WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+			zswap_reject_alloc_fail++;
+			for (; i < nr; i++)
+				zswap_entry_free(entries[i]);
+			return false;
+		}
+
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old)
+			zswap_entry_free(old);
+	}
+
+	/*
+	 * We finish initializing the entries while they're already in xarray.
+	 * This is safe because:
+	 *
+	 * 1. Concurrent stores and invalidations are excluded by folio lock.
+	 *
+	 * 2. Writeback is excluded by the entry not being on the LRU yet.
+	 *    The publishing order matters to prevent writeback from seeing
+	 *    an incoherent entry.
+	 */
+	for (i = 0; i < nr; i++) {
+		entry = entries[i];
+		if (entry->length)
+			zswap_lru_add(&zswap_list_lru, entry);
+		if (objcg)
+			count_objcg_event(objcg, ZSWPOUT);
+	}
+
+	return true;
+
+free_entries:
+	while (i--)
+		zswap_entry_cache_free(entries[i]);
+	return false;
+}
+
+/*
+ * Large folios are stored page by page, each as a regular zswap entry, so
+ * that writeback and loads keep working on single pages. The pages are
+ * handed to the compressor in batches though, see zswap_compress().
+ */
 bool zswap_store(struct folio *folio)
 {
+	long nr_pages = folio_nr_pages(folio);
 	swp_entry_t swp = folio->swap;
 	pgoff_t offset = swp_offset(swp);
 	struct xarray *tree = swap_zswap_tree(swp);
-	struct zswap_entry *entry, *old;
 	struct obj_cgroup *objcg = NULL;
 	struct mem_cgroup *memcg = NULL;
-	unsigned long value;
+	struct zswap_entry *entry;
+	struct zswap_pool *pool;
+	long index;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
 
-	/* Large folios aren't supported */
-	if (folio_test_large(folio))
-		return false;
-
 	if (!zswap_enabled)
 		goto check_old;
 
@@ -1443,24 +1626,10 @@ bool zswap_store(struct folio *folio)
 	if (zswap_check_limits())
 		goto reject;
 
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
-	if (!entry) {
-		zswap_reject_kmemcache_fail++;
+	/* the entries take their own references */
+	pool = zswap_pool_current_get();
+	if (!pool)
 		goto reject;
-	}
-
-	if (zswap_is_folio_same_filled(folio, &value)) {
-		entry->length = 0;
-		entry->value = value;
-		atomic_inc(&zswap_same_filled_pages);
-		goto store_entry;
-	}
-
-	/* if entry is successfully added, it keeps the reference */
-	entry->pool = zswap_pool_current_get();
-	if (!entry->pool)
-		goto freepage;
 
 	if (objcg) {
 		memcg = get_mem_cgroup_from_objcg(objcg);
@@ -1471,66 +1640,23 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	if (!zswap_compress(folio, entry))
-		goto put_pool;
-
-store_entry:
-	entry->swpentry = swp;
-	entry->objcg = objcg;
-
-	old = xa_store(tree, offset, entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
-
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
-		goto store_failed;
-	}
-
-	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
-	 */
-	if (old)
-		zswap_entry_free(old);
+	for (index = 0; index < nr_pages; index += ZSWAP_MAX_BATCH_SIZE) {
+		unsigned int nr = min_t(long, nr_pages - index, ZSWAP_MAX_BATCH_SIZE);
 
-	if (objcg) {
-		obj_cgroup_charge_zswap(objcg, entry->length);
-		count_objcg_event(objcg, ZSWPOUT);
+		if (!zswap_store_pages(folio, index, nr, objcg, pool))
+			goto put_pool;
 	}
 
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
-	}
+	zswap_pool_put(pool);
+	obj_cgroup_put(objcg);
 
 	/* update stats */
-	atomic_inc(&zswap_stored_pages);
-	count_vm_event(ZSWPOUT);
+	count_vm_events(ZSWPOUT, nr_pages);
 
 	return true;
 
-store_failed:
-	if (!entry->length)
-		atomic_dec(&zswap_same_filled_pages);
-	else {
-		zpool_free(zswap_find_zpool(entry), entry->handle);
 put_pool:
-		zswap_pool_put(entry->pool);
-	}
-freepage:
-	zswap_entry_cache_free(entry);
+	zswap_pool_put(pool);
 reject:
 	obj_cgroup_put(objcg);
 	if (zswap_pool_reached_full)
@@ -1538,27 +1664,68 @@ bool zswap_store(struct folio *folio)
 check_old:
 	/*
 	 * If the zswap store fails or zswap is disabled, we must invalidate the
-	 * possibly stale entry which was previously stored at this offset.
+	 * possibly stale entries which were previously stored at these offsets.
 	 * Otherwise, writeback could overwrite the new data in the swapfile.
+	 * This also drops the entries already stored for a part of the folio.
 	 */
-	entry = xa_erase(tree, offset);
-	if (entry)
-		zswap_entry_free(entry);
+	for (index = 0; index < nr_pages; index++) {
+		entry = xa_erase(tree, offset + index);
+		if (entry)
+			zswap_entry_free(entry);
+	}
 	return false;
 }
 
+/*
+ * Return how many of the @nr_pages swap entries starting at @swp are
+ * currently held in zswap.
+ */
+int zswap_present_nr(swp_entry_t swp, int nr_pages)
+{
+	pgoff_t offset = swp_offset(swp);
+	struct xarray *tree = swap_zswap_tree(swp);
+	int i, nr = 0;
+
+	for (i = 0; i < nr_pages; i++)
+		if (xa_load(tree, offset + i))
+			nr++;
+
+	return nr;
+}
+
 bool zswap_load(struct folio *folio)
 {
 	swp_entry_t swp = folio->swap;
 	pgoff_t offset = swp_offset(swp);
-	struct page *page = &folio->page;
+	long i, nr_pages = folio_nr_pages(folio);
 	bool swapcache = folio_test_swapcache(folio);
 	struct xarray *tree = swap_zswap_tree(swp);
 	struct zswap_entry *entry;
+	struct page *page;
 	u8 *dst;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 
+	/*
+	 * The only source of large folios here is the swapcache-bypassing
+	 * fault on SWP_SYNCHRONOUS_IO devices in do_swap_page(); swapcache
+	 * swapin, readahead included, is still order-0.  That fault only
+	 * allocates a large folio when every subpage is in zswap, and its
+	 * SWAP_HAS_CACHE pin on all of the entries keeps them from going
+	 * away under us. Should we ever see a partial hit, fail the read
+	 * rather than mixing in stale data from the backing device.
+	 */
+	if (folio_test_large(folio)) {
+		int nr = zswap_present_nr(swp, nr_pages);
+
+		VM_WARN_ON_ONCE(swapcache);
+
+		if (!nr)
+			return false;
+		if (WARN_ON_ONCE(nr != nr_pages))
+			return true;
+	}
+
 	/*
 	 * When reading into the swapcache, invalidate our entry. The
 	 * swapcache can be the authoritative owner of the page and
@@ -1571,31 +1738,39 @@ bool zswap_load(struct folio *folio)
 	 * files, which reads into a private page and may free it if
 	 * the fault fails. We remain the primary owner of the entry.)
 	 */
-	if (swapcache)
-		entry = xa_erase(tree, offset);
-	else
-		entry = xa_load(tree, offset);
+	for (i = 0; i < nr_pages; i++) {
+		if (swapcache)
+			entry = xa_erase(tree, offset + i);
+		else
+			entry = xa_load(tree, offset + i);
 
-	if (!entry)
-		return false;
+		if (!entry) {
+			/* a miss past the first subpage leaves the folio !uptodate */
+			VM_WARN_ON_ONCE(i);
+			return i > 0;
+		}
 
-	if (entry->length)
-		zswap_decompress(entry, page);
-	else {
-		dst = kmap_local_page(page);
-		zswap_fill_page(dst, entry->value);
-		kunmap_local(dst);
-	}
+		page = folio_page(folio, i);
+		if (entry->length)
+			zswap_decompress(entry, page);
+		else {
+			dst = kmap_local_page(page);
+			zswap_fill_page(dst, entry->value);
+			kunmap_local(dst);
+		}
 
-	count_vm_event(ZSWPIN);
-	if (entry->objcg)
-		count_objcg_event(entry->objcg, ZSWPIN);
+		count_vm_event(ZSWPIN);
+		if (entry->objcg)
+			count_objcg_event(entry->objcg, ZSWPIN);
 
-	if (swapcache) {
-		zswap_entry_free(entry);
-		folio_mark_dirty(folio);
+		if (swapcache)
+			zswap_entry_free(entry);
 	}
 
+	if (swapcache)
+		folio_mark_dirty(folio);
+	folio_mark_uptodate(folio);
+
 	return true;
 }
 
@@ -4678,6 +4678,26 @@ void ceph_osdc_start_request(struct ceph_osd_client *osdc,
 }
 EXPORT_SYMBOL(ceph_osdc_start_request);
 
+/*
+ * Register and send a batch of requests linked through r_private_item,
+ * taking osdc->lock once for all of them.  @reqs is empty on return.
+ */
+void ceph_osdc_start_requests(struct ceph_osd_client *osdc,
+			      struct list_head *reqs)
+{
+	struct ceph_osd_request *req;
+
+	down_read(&osdc->lock);
+	while (!list_empty(reqs)) {
+		req = list_first_entry(reqs, struct ceph_osd_request,
+				       r_private_item);
+		list_del_init(&req->r_private_item);
+		submit_request(req, false);
+	}
+	up_read(&osdc->lock);
+}
+EXPORT_SYMBOL(ceph_osdc_start_requests);
+
 /*
  * Unregister request.  If @req was registered, it isn't completed:
  * r_result isn't set and __complete_request() isn't invoked.
@@ -3781,7 +3781,9 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 				 struct netdev_queue *txq)
 {
 	spinlock_t *root_lock = qdisc_lock(q);
-	struct sk_buff *to_free = NULL;
+	struct sk_buff *next, *to_free = NULL;
+	struct llist_node *ll_list;
+	unsigned long limit;
 	bool contended;
 	int rc;
 
@@ -3826,6 +3828,26 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		kfree_skb_reason(skb, SKB_DROP_REASON_TC_RECLASSIFY_LOOP);
 		return NET_XMIT_DROP;
 	}
+
+	/* Stage the skb on the lockless defer_list. Only the sender finding
+	 * the list empty goes for the root lock, and enqueues everything
+	 * staged by other cpus meanwhile in one batch. The others return
+	 * right away, without touching the qdisc lock cache line.
+	 */
+	if (!llist_empty(&q->defer_list)) {
+		limit = READ_ONCE(q->limit) ?: READ_ONCE(dev->tx_queue_len);
+		if (unlikely(atomic_long_inc_return(&q->defer_count) > limit)) {
+			atomic_long_dec(&q->defer_count);
+			spin_lock(root_lock);
+			qdisc_qstats_drop(q);
+			spin_unlock(root_lock);
+			kfree_skb_reason(skb, SKB_DROP_REASON_QDISC_DROP);
+			return NET_XMIT_DROP;
+		}
+	}
+	if (!llist_add(&skb->ll_node, &q->defer_list))
+		return NET_XMIT_SUCCESS;
+
 	/*
 	 * Heuristic to force contended enqueues to serialize on a
 	 * separate lock before trying to get qdisc main lock.
@@ -3841,16 +3863,24 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		spin_lock(&q->busylock);
 
 	spin_lock(root_lock);
+
+	ll_list = llist_del_all(&q->defer_list);
+	/* Senders adding to the list from now on start a new batch. */
+	atomic_long_set(&q->defer_count, 0);
+	ll_list = llist_reverse_order(ll_list);
+
 	if (unlikely(test_bit(__QDISC_STATE_DEACTIVATED, &q->state))) {
-		__qdisc_drop(skb, &to_free);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node)
+			__qdisc_drop(skb, &to_free);
 		rc = NET_XMIT_DROP;
 	} else if ((q->flags & TCQ_F_CAN_BYPASS) && !qdisc_qlen(q) &&
-		   qdisc_run_begin(q)) {
+		   !ll_list->next && qdisc_run_begin(q)) {
 		/*
 		 * This is a work-conserving queue; there are no old skbs
 		 * waiting to be sent out; and the qdisc is not running -
-		 * xmit the skb directly.
+		 * xmit the skb directly. Being alone on the list, it is ours.
 		 */
+		skb_mark_not_on_list(skb);
 
 		qdisc_bstats_update(q, skb);
 
@@ -3865,8 +3895,18 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		qdisc_run_end(q);
 		rc = NET_XMIT_SUCCESS;
 	} else {
+		/* Our own skb was added first, report its status. */
+		rc = -1;
 		WRITE_ONCE(q->owner, smp_processor_id());
-		rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+			int ret;
+
+			prefetch(next);
+			skb_mark_not_on_list(skb);
+			ret = dev_qdisc_enqueue(skb, q, &to_free, txq);
+			if (rc == -1)
+				rc = ret;
+		}
 		WRITE_ONCE(q->owner, -1);
 		if (qdisc_run_begin(q)) {
 			if (unlikely(contended)) {
@@ -4600,6 +4640,7 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 
 	sock_flow_table = rcu_dereference(net_hotdata.rps_sock_flow_table);
 	if (flow_table && sock_flow_table) {
+		struct softnet_data *sd = this_cpu_ptr(&softnet_data);
 		struct rps_dev_flow *rflow;
 		u32 next_cpu;
 		u32 ident;
@@ -4608,8 +4649,10 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 		 * This READ_ONCE() pairs with WRITE_ONCE() from rps_record_sock_flow().
 		 */
 		ident = READ_ONCE(sock_flow_table->ents[hash & sock_flow_table->mask]);
-		if ((ident ^ hash) & ~net_hotdata.rps_cpu_mask)
+		if ((ident ^ hash) & ~net_hotdata.rps_cpu_mask) {
+			sd->rfs_miss++;
 			goto try_rps;
+		}
 
 		next_cpu = ident & net_hotdata.rps_cpu_mask;
 
@@ -4630,15 +4673,21 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 		 *     This guarantees that all previous packets for the flow
 		 *     have been dequeued, thus preserving in order delivery.
 		 */
-		if (unlikely(tcpu != next_cpu) &&
-		    (tcpu >= nr_cpu_ids || !cpu_online(tcpu) ||
-		     ((int)(READ_ONCE(per_cpu(softnet_data, tcpu).input_queue_head) -
-		      rflow->last_qtail)) >= 0)) {
-			tcpu = next_cpu;
-			rflow = set_rps_cpu(dev, skb, rflow, next_cpu);
+		if (unlikely(tcpu != next_cpu)) {
+			if (tcpu >= nr_cpu_ids || !cpu_online(tcpu) ||
+			    ((int)(READ_ONCE(per_cpu(softnet_data, tcpu).input_queue_head) -
+			     rflow->last_qtail)) >= 0) {
+				tcpu = next_cpu;
+				rflow = set_rps_cpu(dev, skb, rflow, next_cpu);
+				sd->rfs_switch++;
+			} else {
+				sd->rfs_held++;
+			}
 		}
 
 		if (tcpu < nr_cpu_ids && cpu_online(tcpu)) {
+			if (tcpu == next_cpu)
+				sd->rfs_hit++;
 			*rflowp = rflow;
 			cpu = tcpu;
 			goto done;
@@ -6183,12 +6232,12 @@ bool napi_complete_done(struct napi_struct *n, int work_done)
 
 	if (work_done) {
 		if (n->gro_bitmask)
-			timeout = READ_ONCE(n->dev->gro_flush_timeout);
-		n->defer_hard_irqs_count = READ_ONCE(n->dev->napi_defer_hard_irqs);
+			timeout = napi_get_gro_flush_timeout(n);
+		n->defer_hard_irqs_count = napi_get_defer_hard_irqs(n);
 	}
 	if (n->defer_hard_irqs_count > 0) {
 		n->defer_hard_irqs_count--;
-		timeout = READ_ONCE(n->dev->gro_flush_timeout);
+		timeout = napi_get_gro_flush_timeout(n);
 		if (timeout)
 			ret = false;
 	}
@@ -6320,8 +6369,8 @@ static void busy_poll_stop(struct napi_struct *napi, void *have_poll_lock,
 	local_bh_disable();
 
 	if (flags & NAPI_F_PREFER_BUSY_POLL) {
-		napi->defer_hard_irqs_count = READ_ONCE(napi->dev->napi_defer_hard_irqs);
-		timeout = READ_ONCE(napi->dev->gro_flush_timeout);
+		napi->defer_hard_irqs_count = napi_get_defer_hard_irqs(napi);
+		timeout = napi_get_gro_flush_timeout(napi);
 		if (napi->defer_hard_irqs_count && timeout) {
 			hrtimer_start(&napi->timer, ns_to_ktime(timeout), HRTIMER_MODE_REL_PINNED);
 			skip_schedule = true;
@@ -6448,6 +6497,55 @@ void napi_busy_loop(unsigned int napi_id,
 }
 EXPORT_SYMBOL(napi_busy_loop);
 
+/**
+ * napi_suspend_irqs - keep device irqs off while an application polls
+ * @napi_id: id of the napi the application busy polls
+ *
+ * Called when a prefer-busy-poll loop found work. A busy poll that
+ * ended with a full budget leaves the napi with its irqs masked and the
+ * watchdog armed with gro_flush_timeout; push the watchdog out to the
+ * napi's irq_suspend_timeout so the irqs stay off for as long as the
+ * application keeps finding events. The watchdog remains the safety net
+ * should the application stop polling.
+ */
+void napi_suspend_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+	unsigned long timeout;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi) {
+		timeout = napi_get_irq_suspend_timeout(napi);
+		if (timeout)
+			hrtimer_start(&napi->timer, ns_to_ktime(timeout),
+				      HRTIMER_MODE_REL_PINNED);
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * napi_resume_irqs - hand a napi back to its device irq
+ * @napi_id: id of the napi the application stopped busy polling
+ *
+ * Called when a prefer-busy-poll loop came up empty. Schedule the napi
+ * so that its next poll completes it and rearms the device irq, rather
+ * than waiting for the irq_suspend_timeout watchdog.
+ */
+void napi_resume_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi && napi_get_irq_suspend_timeout(napi)) {
+		local_bh_disable();
+		napi_schedule(napi);
+		local_bh_enable();
+	}
+	rcu_read_unlock();
+}
+
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 static void napi_hash_add(struct napi_struct *napi)
@@ -6511,7 +6609,8 @@ static void init_gro_hash(struct napi_struct *napi)
 	napi->gro_bitmask = 0;
 }
 
-int dev_set_threaded(struct net_device *dev, bool threaded)
+int dev_set_threaded(struct net_device *dev,
+		      enum netdev_napi_threaded threaded)
 {
 	struct napi_struct *napi;
 	int err = 0;
@@ -6524,7 +6623,7 @@ int dev_set_threaded(struct net_device *dev, bool threaded)
 			if (!napi->thread) {
 				err = napi_kthread_create(napi);
 				if (err) {
-					threaded = false;
+					threaded = NETDEV_NAPI_THREADED_DISABLED;
 					break;
 				}
 			}
@@ -6544,8 +6643,11 @@ int dev_set_threaded(struct net_device *dev, bool threaded)
 	 * softirq mode will happen in the next round of napi_schedule().
 	 * This should not cause hiccups/stalls to the live traffic.
 	 */
-	list_for_each_entry(napi, &dev->napi_list, dev_list)
+	list_for_each_entry(napi, &dev->napi_list, dev_list) {
+		assign_bit(NAPI_STATE_THREADED_BUSY_POLL, &napi->state,
+			   threaded == NETDEV_NAPI_THREADED_BUSY_POLL);
 		assign_bit(NAPI_STATE_THREADED, &napi->state, threaded);
+	}
 
 	return err;
 }
@@ -6608,6 +6710,12 @@ void netif_napi_add_weight(struct net_device *dev, struct napi_struct *napi,
 				weight);
 	napi->weight = weight;
 	napi->dev = dev;
+	napi->config = NULL;
+	napi_set_defer_hard_irqs(napi, READ_ONCE(dev->napi_defer_hard_irqs));
+	napi_set_gro_flush_timeout(napi, READ_ONCE(dev->gro_flush_timeout));
+	napi_set_irq_suspend_timeout(napi, 0);
+	napi->gro_packets = 0;
+	napi->gro_merged = 0;
 #ifdef CONFIG_NETPOLL
 	napi->poll_owner = -1;
 #endif
@@ -6622,11 +6730,41 @@ void netif_napi_add_weight(struct net_device *dev, struct napi_struct *napi,
 	 * threaded mode will not be enabled in napi_enable().
 	 */
 	if (dev->threaded && napi_kthread_create(napi))
-		dev->threaded = false;
+		dev->threaded = NETDEV_NAPI_THREADED_DISABLED;
 	netif_napi_set_irq(napi, -1);
 }
 EXPORT_SYMBOL(netif_napi_add_weight);
 
+/**
+ * netif_napi_add_config - initialize a NAPI context bound to a queue
+ * @dev: network device
+ * @napi: NAPI context
+ * @poll: polling function
+ * @index: queue index the NAPI context serves
+ *
+ * Like netif_napi_add(), but the per-napi settings (defer_hard_irqs,
+ * gro_flush_timeout, irq_suspend_timeout) are kept in the device's
+ * config slot @index, so that a NAPI context added again for the same
+ * queue, e.g. after a ring reconfiguration, picks them up again.
+ */
+void netif_napi_add_config(struct net_device *dev, struct napi_struct *napi,
+			   int (*poll)(struct napi_struct *, int),
+			   unsigned int index)
+{
+	struct napi_config *config;
+
+	netif_napi_add_weight(dev, napi, poll, NAPI_POLL_WEIGHT);
+	if (WARN_ON_ONCE(index >= netdev_nr_napi_config(dev)))
+		return;
+
+	config = &dev->napi_config[index];
+	napi_set_defer_hard_irqs(napi, config->defer_hard_irqs);
+	napi_set_gro_flush_timeout(napi, config->gro_flush_timeout);
+	napi_set_irq_suspend_timeout(napi, config->irq_suspend_timeout);
+	napi->config = config;
+}
+EXPORT_SYMBOL(netif_napi_add_config);
+
 void napi_disable(struct napi_struct *n)
 {
 	unsigned long val, new;
@@ -6642,7 +6780,8 @@ void napi_disable(struct napi_struct *n)
 		}
 
 		new = val | NAPIF_STATE_SCHED | NAPIF_STATE_NPSVC;
-		new &= ~(NAPIF_STATE_THREADED | NAPIF_STATE_PREFER_BUSY_POLL);
+		new &= ~(NAPIF_STATE_THREADED | NAPIF_STATE_THREADED_BUSY_POLL |
+			 NAPIF_STATE_PREFER_BUSY_POLL);
 	} while (!try_cmpxchg(&n->state, &val, new));
 
 	hrtimer_cancel(&n->timer);
@@ -6668,6 +6807,9 @@ void napi_enable(struct napi_struct *n)
 		new = val & ~(NAPIF_STATE_SCHED | NAPIF_STATE_NPSVC);
 		if (n->dev->threaded && n->thread)
 			new |= NAPIF_STATE_THREADED;
+		if (n->dev->threaded == NETDEV_NAPI_THREADED_BUSY_POLL &&
+		    n->thread)
+			new |= NAPIF_STATE_THREADED_BUSY_POLL;
 	} while (!try_cmpxchg(&n->state, &val, new));
 }
 EXPORT_SYMBOL(napi_enable);
@@ -6822,7 +6964,7 @@ static int napi_thread_wait(struct napi_struct *napi)
 	return -1;
 }
 
-static void napi_threaded_poll_loop(struct napi_struct *napi)
+static void napi_threaded_poll_loop(struct napi_struct *napi, bool busy_poll)
 {
 	struct softnet_data *sd;
 	unsigned long last_qs = jiffies;
@@ -6847,22 +6989,54 @@ static void napi_threaded_poll_loop(struct napi_struct *napi)
 			net_rps_action_and_irq_enable(sd);
 		}
 		skb_defer_free_flush(sd);
+
+		/* napi_complete_done() is a nop while busy polling, so it
+		 * won't push out packets held by GRO: do it here instead.
+		 */
+		if (busy_poll) {
+			if (napi->gro_bitmask)
+				napi_gro_flush(napi, HZ >= 1000);
+			gro_normal_list(napi);
+		}
 		local_bh_enable();
 
-		if (!repoll)
+		/* A busy polling thread never completes the napi, so it must
+		 * not skip the quiescent state and resched checks below.
+		 */
+		if (!repoll && !busy_poll)
 			break;
 
 		rcu_softirq_qs_periodic(last_qs);
 		cond_resched();
+
+		if (!repoll)
+			break;
 	}
 }
 
 static int napi_threaded_poll(void *data)
 {
 	struct napi_struct *napi = data;
+	bool want_busy_poll;
+	unsigned long val;
+
+	while (!napi_thread_wait(napi)) {
+		/* While NAPI_STATE_IN_BUSY_POLL is set, napi_complete_done()
+		 * leaves the napi scheduled and device interrupts disabled,
+		 * so this thread keeps being handed the napi back by
+		 * napi_thread_wait() and polls it continuously. Dropping the
+		 * bit makes the next poll complete and rearm the interrupt.
+		 */
+		val = READ_ONCE(napi->state);
+		want_busy_poll = (val & NAPIF_STATE_THREADED_BUSY_POLL) &&
+				 !(val & NAPIF_STATE_DISABLE) &&
+				 !kthread_should_stop();
+		if (want_busy_poll != !!(val & NAPIF_STATE_IN_BUSY_POLL))
+			assign_bit(NAPI_STATE_IN_BUSY_POLL, &napi->state,
+				   want_busy_poll);
 
-	while (!napi_thread_wait(napi))
-		napi_threaded_poll_loop(napi);
+		napi_threaded_poll_loop(napi, want_busy_poll);
+	}
 
 	return 0;
 }
@@ -10890,8 +11064,8 @@ void netdev_sw_irq_coalesce_default_on(struct net_device *dev)
 	WARN_ON(dev->reg_state == NETREG_REGISTERED);
 
 	if (!IS_ENABLED(CONFIG_PREEMPT_RT)) {
-		dev->gro_flush_timeout = 20000;
-		dev->napi_defer_hard_irqs = 1;
+		netdev_set_gro_flush_timeout(dev, 20000);
+		netdev_set_defer_hard_irqs(dev, 1);
 	}
 }
 EXPORT_SYMBOL_GPL(netdev_sw_irq_coalesce_default_on);
@@ -11016,6 +11190,11 @@ struct net_device *alloc_netdev_mqs(int sizeof_priv, const char *name,
 	if (netif_alloc_rx_queues(dev))
 		goto free_all;
 
+	dev->napi_config = kvcalloc(max(txqs, rxqs), sizeof(*dev->napi_config),
+				    GFP_KERNEL_ACCOUNT);
+	if (!dev->napi_config)
+		goto free_all;
+
 	strcpy(dev->name, name);
 	dev->name_assign_type = name_assign_type;
 	dev->group = INIT_NETDEV_GROUP;
@@ -11075,6 +11254,7 @@ void free_netdev(struct net_device *dev)
 
 	list_for_each_entry_safe(p, n, &dev->napi_list, dev_list)
 		netif_napi_del(p);
+	kvfree(dev->napi_config);
 
 	ref_tracker_dir_exit(&dev->refcnt_tracker);
 #ifdef CONFIG_PCPU_DEV_REFCNT
@@ -11863,7 +12043,7 @@ static void run_backlog_napi(unsigned int cpu)
 {
 	struct softnet_data *sd = per_cpu_ptr(&softnet_data, cpu);
 
-	napi_threaded_poll_loop(&sd->backlog);
+	napi_threaded_poll_loop(&sd->backlog, false);
 }
 
 static void backlog_napi_setup(unsigned int cpu)
@@ -147,6 +147,81 @@ static inline void xdp_do_check_flushed(struct napi_struct *napi) { }
 #endif
 
 struct napi_struct *napi_by_id(unsigned int napi_id);
+
+/* Per-napi copies of the netdev wide knobs, tunable via netdev genl */
+static inline u32 napi_get_defer_hard_irqs(const struct napi_struct *n)
+{
+	return READ_ONCE(n->defer_hard_irqs);
+}
+
+static inline void napi_set_defer_hard_irqs(struct napi_struct *n, u32 defer)
+{
+	WRITE_ONCE(n->defer_hard_irqs, defer);
+	if (n->config)
+		n->config->defer_hard_irqs = defer;
+}
+
+static inline unsigned int netdev_nr_napi_config(const struct net_device *dev)
+{
+	return max(dev->num_rx_queues, dev->num_tx_queues);
+}
+
+/* Setting the netdev wide value overrides all of its napis */
+static inline void netdev_set_defer_hard_irqs(struct net_device *netdev,
+					      u32 defer)
+{
+	struct napi_struct *napi;
+
+	unsigned int i;
+
+	WRITE_ONCE(netdev->napi_defer_hard_irqs, defer);
+	for (i = 0; i < netdev_nr_napi_config(netdev); i++)
+		netdev->napi_config[i].defer_hard_irqs = defer;
+	list_for_each_entry(napi, &netdev->napi_list, dev_list)
+		napi_set_defer_hard_irqs(napi, defer);
+}
+
+static inline unsigned long
+napi_get_gro_flush_timeout(const struct napi_struct *n)
+{
+	return READ_ONCE(n->gro_flush_timeout);
+}
+
+static inline void napi_set_gro_flush_timeout(struct napi_struct *n,
+					      unsigned long timeout)
+{
+	WRITE_ONCE(n->gro_flush_timeout, timeout);
+	if (n->config)
+		n->config->gro_flush_timeout = timeout;
+}
+
+static inline void netdev_set_gro_flush_timeout(struct net_device *netdev,
+						unsigned long timeout)
+{
+	struct napi_struct *napi;
+
+	unsigned int i;
+
+	WRITE_ONCE(netdev->gro_flush_timeout, timeout);
+	for (i = 0; i < netdev_nr_napi_config(netdev); i++)
+		netdev->napi_config[i].gro_flush_timeout = timeout;
+	list_for_each_entry(napi, &netdev->napi_list, dev_list)
+		napi_set_gro_flush_timeout(napi, timeout);
+}
+
+static inline unsigned long
+napi_get_irq_suspend_timeout(const struct napi_struct *n)
+{
+	return READ_ONCE(n->irq_suspend_timeout);
+}
+
+static inline void napi_set_irq_suspend_timeout(struct napi_struct *n,
+						unsigned long timeout)
+{
+	WRITE_ONCE(n->irq_suspend_timeout, timeout);
+	if (n->config)
+		n->config->irq_suspend_timeout = timeout;
+}
 void kick_defer_list_purge(struct softnet_data *sd, unsigned int cpu);
 
 #define XMIT_RECURSION_LIMIT	8
@@ -537,8 +537,10 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 		gro_list->count--;
 	}
 
-	if (same_flow)
+	if (same_flow) {
+		WRITE_ONCE(napi->gro_merged, napi->gro_merged + 1);
 		goto ok;
+	}
 
 	if (NAPI_GRO_CB(skb)->flush)
 		goto normal;
@@ -557,6 +559,7 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 	list_add(&skb->list, &gro_list->list);
 	ret = GRO_HELD;
 ok:
+	WRITE_ONCE(napi->gro_packets, napi->gro_packets + 1);
 	if (gro_list->count) {
 		if (!test_bit(bucket, &napi->gro_bitmask))
 			__set_bit(bucket, &napi->gro_bitmask);
@@ -475,6 +475,27 @@ static void page_pool_clear_pp_info(struct page *page)
 	page->pp = NULL;
 }
 
+#ifdef CONFIG_NUMA
+/* Last time an allocation for a pool bound to the node got remote pages */
+static unsigned long page_pool_node_fallback[MAX_NUMNODES];
+#endif
+
+/* The page allocator only falls back to another node once the pool's own
+ * node is short of memory. Note when that happens, so that the remote
+ * pages it hands out stay recyclable until the node has recovered.
+ */
+static void page_pool_check_fallback(const struct page_pool *pool,
+				     const struct page *page)
+{
+#ifdef CONFIG_NUMA
+	int nid = pool->p.nid;
+
+	if (nid != NUMA_NO_NODE && unlikely(page_to_nid(page) != nid) &&
+	    READ_ONCE(page_pool_node_fallback[nid]) != jiffies)
+		WRITE_ONCE(page_pool_node_fallback[nid], jiffies);
+#endif
+}
+
 static struct page *__page_pool_alloc_page_order(struct page_pool *pool,
 						 gfp_t gfp)
 {
@@ -484,6 +505,7 @@ static struct page *__page_pool_alloc_page_order(struct page_pool *pool,
 	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
 	if (unlikely(!page))
 		return NULL;
+	page_pool_check_fallback(pool, page);
 
 	if (pool->dma_map && unlikely(!page_pool_dma_map(pool, page))) {
 		put_page(page);
@@ -525,6 +547,7 @@ static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 					       pool->alloc.cache);
 	if (unlikely(!nr_pages))
 		return NULL;
+	page_pool_check_fallback(pool, pool->alloc.cache[nr_pages - 1]);
 
 	/* Pages have been filled into alloc.cache array, but count is zero and
 	 * page element have not been (possibly) DMA mapped.
@@ -686,6 +709,28 @@ static bool __page_pool_page_can_be_recycled(const struct page *page)
 	return page_ref_count(page) == 1 && !page_is_pfmemalloc(page);
 }
 
+/* Pages of another node than the one the pool is bound to would only be
+ * waived by the next refill, see page_pool_refill_alloc_cache(). Don't
+ * make them take a cache or ring slot on the way, unless the node ran out
+ * of memory during the last second: releasing them then would only have
+ * the next allocation fall back to a remote node again.
+ */
+static bool page_pool_page_is_remote(const struct page_pool *pool,
+				     const struct page *page)
+{
+#ifdef CONFIG_NUMA
+	int nid = READ_ONCE(pool->p.nid);
+	unsigned long fallback;
+
+	if (nid == NUMA_NO_NODE || page_to_nid(page) == nid)
+		return false;
+	fallback = READ_ONCE(page_pool_node_fallback[nid]);
+	return !fallback || time_after(jiffies, fallback + HZ);
+#else
+	return false;
+#endif
+}
+
 /* If the page refcnt == 1, this will try to recycle the page.
  * If pool->dma_sync is set, we'll try to sync the DMA area for
  * the configured size min(dma_sync_size, pool->max_len).
@@ -710,6 +755,11 @@ __page_pool_put_page(struct page_pool *pool, struct page *page,
 	if (likely(__page_pool_page_can_be_recycled(page))) {
 		/* Read barrier done in page_ref_count / READ_ONCE */
 
+		if (unlikely(page_pool_page_is_remote(pool, page))) {
+			page_pool_return_page(pool, page);
+			return NULL;
+		}
+
 		page_pool_dma_sync_for_device(pool, page, dma_sync_size);
 
 		if (allow_direct && page_pool_recycle_in_cache(page, pool))
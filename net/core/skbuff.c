@@ -337,16 +337,21 @@ void *__netdev_alloc_frag_align(unsigned int fragsz, unsigned int align_mask)
 }
 EXPORT_SYMBOL(__netdev_alloc_frag_align);
 
-static struct sk_buff *napi_skb_cache_get(void)
+/* @alloc: refill an empty cache from slab. Callers outside of NAPI pass
+ * false: they only take heads recycled by TX completions on this cpu, and
+ * fall back to a regular allocation honouring their own gfp mask.
+ */
+static struct sk_buff *napi_skb_cache_get(bool alloc)
 {
 	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
 	struct sk_buff *skb;
 
 	if (unlikely(!nc->skb_count)) {
-		nc->skb_count = kmem_cache_alloc_bulk(net_hotdata.skbuff_cache,
-						      GFP_ATOMIC,
-						      NAPI_SKB_CACHE_BULK,
-						      nc->skb_cache);
+		if (alloc)
+			nc->skb_count = kmem_cache_alloc_bulk(net_hotdata.skbuff_cache,
+							      GFP_ATOMIC,
+							      NAPI_SKB_CACHE_BULK,
+							      nc->skb_cache);
 		if (unlikely(!nc->skb_count))
 			return NULL;
 	}
@@ -522,7 +527,7 @@ static struct sk_buff *__napi_build_skb(void *data, unsigned int frag_size)
 {
 	struct sk_buff *skb;
 
-	skb = napi_skb_cache_get();
+	skb = napi_skb_cache_get(true);
 	if (unlikely(!skb))
 		return NULL;
 
@@ -649,10 +654,24 @@ struct sk_buff *__alloc_skb(unsigned int size, gfp_t gfp_mask,
 		gfp_mask |= __GFP_MEMALLOC;
 
 	/* Get the HEAD */
-	if ((flags & (SKB_ALLOC_FCLONE | SKB_ALLOC_NAPI)) == SKB_ALLOC_NAPI &&
-	    likely(node == NUMA_NO_NODE || node == numa_mem_id()))
-		skb = napi_skb_cache_get();
-	else
+	skb = NULL;
+	if (!(flags & SKB_ALLOC_FCLONE) &&
+	    likely(node == NUMA_NO_NODE || node == numa_mem_id())) {
+		if (flags & SKB_ALLOC_NAPI) {
+			skb = napi_skb_cache_get(true);
+			if (unlikely(!skb))
+				return NULL;
+		} else if (!in_hardirq() && !irqs_disabled()) {
+			/* The NAPI cache is also fed by TX completions
+			 * (napi_consume_skb()), let transmitters reuse those
+			 * heads instead of going back to slab.
+			 */
+			local_bh_disable();
+			skb = napi_skb_cache_get(false);
+			local_bh_enable();
+		}
+	}
+	if (!skb)
 		skb = kmem_cache_alloc_node(cache, gfp_mask & ~GFP_DMA, node);
 	if (unlikely(!skb))
 		return NULL;
@@ -5003,7 +5022,7 @@ void __init skb_init(void)
 					      sizeof(struct sk_buff),
 					      0,
 					      SLAB_HWCACHE_ALIGN|SLAB_PANIC|
-						FLAG_SKB_NO_MERGE,
+						SLAB_SHEAVES|FLAG_SKB_NO_MERGE,
 					      offsetof(struct sk_buff, cb),
 					      sizeof_field(struct sk_buff, cb),
 					      NULL);
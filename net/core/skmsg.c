@@ -511,7 +511,8 @@ static struct sk_msg *alloc_sk_msg(gfp_t gfp)
 }
 
 static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
-						  struct sk_buff *skb)
+						  struct sk_buff *skb,
+						  gfp_t gfp)
 {
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		return NULL;
@@ -519,7 +520,7 @@ static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
 	if (!sk_rmem_schedule(sk, skb, skb->truesize))
 		return NULL;
 
-	return alloc_sk_msg(GFP_KERNEL);
+	return alloc_sk_msg(gfp);
 }
 
 static int sk_psock_skb_ingress_enqueue(struct sk_buff *skb,
@@ -560,7 +561,7 @@ static int sk_psock_skb_ingress_self(struct sk_psock *psock, struct sk_buff *skb
 				     u32 off, u32 len);
 
 static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
-				u32 off, u32 len)
+				u32 off, u32 len, gfp_t gfp)
 {
 	struct sock *sk = psock->sk;
 	struct sk_msg *msg;
@@ -572,7 +573,7 @@ static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
 	 */
 	if (unlikely(skb->sk == sk))
 		return sk_psock_skb_ingress_self(psock, skb, off, len);
-	msg = sk_psock_create_ingress_msg(sk, skb);
+	msg = sk_psock_create_ingress_msg(sk, skb, gfp);
 	if (!msg)
 		return -EAGAIN;
 
@@ -620,7 +621,7 @@ static int sk_psock_handle_skb(struct sk_psock *psock, struct sk_buff *skb,
 		return skb_send_sock(psock->sk, skb, off, len);
 	}
 	skb_get(skb);
-	err = sk_psock_skb_ingress(psock, skb, off, len);
+	err = sk_psock_skb_ingress(psock, skb, off, len, GFP_KERNEL);
 	if (err < 0)
 		kfree_skb(skb);
 	return err;
@@ -900,6 +901,44 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* An ingress redirect only has to go through the backlog work to keep
+ * ordering with what is already queued there, or because the owner of the
+ * other socket holds it. Otherwise the skb is handed to the ingress_msg
+ * queue of the other socket right away, the data pages are not copied
+ * in either case.
+ */
+static bool sk_psock_skb_redirect_fast(struct sk_psock *psock,
+				       struct sk_buff *skb)
+{
+	struct sock *sk = psock->sk;
+	bool done = false;
+
+	if (!skb_bpf_ingress(skb) || skb_bpf_strparser(skb) ||
+	    !skb_queue_empty(&psock->ingress_skb))
+		return false;
+
+	/* The caller may hold the socket lock of the sending side, which
+	 * can be this very socket or redirect to us in turn, so never spin.
+	 */
+	local_bh_disable();
+	if (!spin_trylock(&sk->sk_lock.slock)) {
+		local_bh_enable();
+		return false;
+	}
+	if (!sock_owned_by_user(sk) &&
+	    sk_psock_test_state(psock, SK_PSOCK_TX_ENABLED)) {
+		skb_bpf_redirect_clear(skb);
+		if (sk_psock_skb_ingress(psock, skb, 0, skb->len,
+					 GFP_ATOMIC) < 0)
+			skb_bpf_set_redir(skb, sk, true);
+		else
+			done = true;
+	}
+	spin_unlock(&sk->sk_lock.slock);
+	local_bh_enable();
+	return done;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
@@ -924,6 +963,9 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		sock_drop(from->sk, skb);
 		return -EIO;
 	}
+	if (sk_psock_skb_redirect_fast(psock_other, skb))
+		return 0;
+
 	spin_lock_bh(&psock_other->ingress_lock);
 	if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
 		spin_unlock_bh(&psock_other->ingress_lock);
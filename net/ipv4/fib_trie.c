@@ -164,11 +164,37 @@ struct trie_stat {
 	unsigned int nodesizes[MAX_STAT_DEPTH];
 };
 
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+#define FIB_DIR_SHIFT	16
+#define FIB_DIR_SIZE	(1U << (KEYLENGTH - FIB_DIR_SHIFT))
+/* Small tables are walked quickly enough, don't spend 768 KB on them */
+#define FIB_DIR_MIN_ALIASES	4096
+
+/* Direct table indexed by the top 16 bits of the key. A non NULL entry
+ * is the leaf holding the longest prefix covering the whole /16, which
+ * is only cached when the /16 contains no longer prefix (nlong == 0).
+ * Entries are filled by lookups and cleared under RTNL on any change of
+ * a prefix overlapping them; seq lets lookups detect such a change
+ * racing with their fill. Leaves are only freed after an RCU grace
+ * period, once their last alias was removed and the entries cleared.
+ */
+struct fib_dir {
+	struct key_vector	*leaf[FIB_DIR_SIZE];
+	u32			nlong[FIB_DIR_SIZE];
+	unsigned int		seq;
+};
+#endif
+
 struct trie {
 	struct key_vector kv[1];
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	struct trie_use_stats __percpu *stats;
 #endif
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	struct fib_dir *dir;
+	unsigned int dir_aliases;	/* under RTNL, until dir exists */
+	bool dir_disabled;
+#endif
 };
 
 static struct key_vector *resize(struct trie *t, struct key_vector *tn);
@@ -1107,6 +1133,97 @@ static void trie_rebalance(struct trie *t, struct key_vector *tn)
 		tn = resize(t, tn);
 }
 
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+static struct key_vector *leaf_walk_rcu(struct key_vector **tn, t_key key);
+
+/* Allocate the direct table once the trie has grown large enough, and
+ * count the prefixes longer than /16 it already holds. Caller must hold
+ * RTNL. A failed allocation only costs the shortcut.
+ */
+static void fib_dir_create(struct trie *t)
+{
+	struct key_vector *l, *tp = t->kv;
+	struct fib_dir *dir;
+	struct fib_alias *fa;
+	t_key key = 0;
+
+	dir = kvzalloc(sizeof(*dir), GFP_KERNEL);
+	if (!dir) {
+		t->dir_disabled = true;
+		return;
+	}
+
+	while ((l = leaf_walk_rcu(&tp, key)) != NULL) {
+		hlist_for_each_entry(fa, &l->leaf, fa_list) {
+			if (fa->fa_slen < KEYLENGTH - FIB_DIR_SHIFT)
+				dir->nlong[l->key >> FIB_DIR_SHIFT]++;
+		}
+
+		key = l->key + 1;
+		/* stop in case of wrap around */
+		if (key < l->key)
+			break;
+	}
+
+	/* lookups may use the table as soon as they see it */
+	smp_store_release(&t->dir, dir);
+}
+
+/* Caller must hold RTNL, after the alias was linked or unlinked. */
+static void fib_dir_alias_change(struct trie *t, t_key key, u8 slen,
+				 int delta)
+{
+	struct fib_dir *dir = t->dir;
+	unsigned int i, first, nr;
+
+	if (!dir) {
+		t->dir_aliases += delta;
+		if (!t->dir_disabled &&
+		    t->dir_aliases >= FIB_DIR_MIN_ALIASES)
+			fib_dir_create(t);
+		return;
+	}
+
+	first = key >> FIB_DIR_SHIFT;
+	if (slen < KEYLENGTH - FIB_DIR_SHIFT) {
+		WRITE_ONCE(dir->nlong[first], dir->nlong[first] + delta);
+		nr = 1;
+	} else {
+		nr = 1U << (slen - (KEYLENGTH - FIB_DIR_SHIFT));
+	}
+
+	/* publish the trie update before the new sequence ... */
+	smp_wmb();
+	WRITE_ONCE(dir->seq, dir->seq + 1);
+	/* ... and the new sequence before clearing the entries */
+	smp_mb();
+
+	for (i = 0; i < nr; i++)
+		WRITE_ONCE(dir->leaf[first + i], NULL);
+}
+
+static void fib_dir_fill(struct fib_dir *dir, t_key key,
+			 struct key_vector *l, unsigned int seq)
+{
+	unsigned int idx = key >> FIB_DIR_SHIFT;
+
+	if (READ_ONCE(dir->nlong[idx]) || cmpxchg(&dir->leaf[idx], NULL, l))
+		return;
+
+	/* Undo if the trie changed since this lookup started, the entry
+	 * might have been cleared before we filled it.
+	 */
+	smp_mb();
+	if (READ_ONCE(dir->seq) != seq)
+		cmpxchg(&dir->leaf[idx], l, NULL);
+}
+#else
+static inline void fib_dir_alias_change(struct trie *t, t_key key, u8 slen,
+					int delta)
+{
+}
+#endif
+
 static int fib_insert_node(struct trie *t, struct key_vector *tp,
 			   struct fib_alias *new, t_key key)
 {
@@ -1161,8 +1278,13 @@ static int fib_insert_alias(struct trie *t, struct key_vector *tp,
 			    struct key_vector *l, struct fib_alias *new,
 			    struct fib_alias *fa, t_key key)
 {
-	if (!l)
-		return fib_insert_node(t, tp, new, key);
+	if (!l) {
+		int err = fib_insert_node(t, tp, new, key);
+
+		if (!err)
+			fib_dir_alias_change(t, key, new->fa_slen, 1);
+		return err;
+	}
 
 	if (fa) {
 		hlist_add_before_rcu(&new->fa_list, &fa->fa_list);
@@ -1190,6 +1312,8 @@ static int fib_insert_alias(struct trie *t, struct key_vector *tp,
 		node_push_suffix(tp, new->fa_slen);
 	}
 
+	fib_dir_alias_change(t, key, new->fa_slen, 1);
+
 	return 0;
 }
 
@@ -1450,6 +1574,11 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	struct trie_use_stats __percpu *stats = t->stats;
 #endif
 	const t_key key = ntohl(flp->daddr);
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	struct fib_dir *dir = smp_load_acquire(&t->dir);
+	bool from_dir = false;
+	unsigned int dir_seq;
+#endif
 	struct key_vector *n, *pn;
 	struct fib_alias *fa;
 	unsigned long index;
@@ -1468,6 +1597,22 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	this_cpu_inc(stats->gets);
 #endif
 
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	if (dir) {
+		struct key_vector *l;
+
+		dir_seq = smp_load_acquire(&dir->seq);
+		l = READ_ONCE(dir->leaf[key >> FIB_DIR_SHIFT]);
+		if (l) {
+			/* if the leaf doesn't give a result, start over */
+			from_dir = true;
+			n = l;
+			goto found;
+		}
+	}
+descend:
+#endif
+
 	/* Step 1: Travel to the longest prefix match in the trie */
 	for (;;) {
 		index = get_cindex(key, n);
@@ -1580,6 +1725,16 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 			if (index >= (1ul << fa->fa_slen))
 				continue;
 		}
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+		/* The first covering alias met by a lookup from the root is
+		 * the longest prefix match for the key.
+		 */
+		if (dir && !from_dir) {
+			if (fa->fa_slen >= KEYLENGTH - FIB_DIR_SHIFT)
+				fib_dir_fill(dir, key, n, dir_seq);
+			dir = NULL;
+		}
+#endif
 		if (fa->fa_dscp &&
 		    inet_dscp_to_dsfield(fa->fa_dscp) != flp->flowi4_tos)
 			continue;
@@ -1643,6 +1798,18 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 miss:
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	this_cpu_inc(stats->semantic_match_miss);
+#endif
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	if (from_dir) {
+		from_dir = false;
+		dir = NULL;
+		n = get_child_rcu(pn, cindex);
+		if (!n) {
+			trace_fib_table_lookup(tb->tb_id, flp, NULL, -EAGAIN);
+			return -EAGAIN;
+		}
+		goto descend;
+	}
 #endif
 	goto backtrace;
 }
@@ -1657,6 +1824,7 @@ static void fib_remove_alias(struct trie *t, struct key_vector *tp,
 
 	/* remove the fib_alias from the list */
 	hlist_del_rcu(&old->fa_list);
+	fib_dir_alias_change(t, l->key, old->fa_slen, -1);
 
 	/* if we emptied the list this leaf will be freed and we can sort
 	 * out parent suffix lengths as a part of trie_rebalance
@@ -1893,6 +2061,9 @@ static void fib_trie_free(struct fib_table *tb)
 
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	free_percpu(t->stats);
+#endif
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	kvfree(t->dir);
 #endif
 	kfree(tb);
 }
@@ -2006,6 +2177,7 @@ void fib_table_flush_external(struct fib_table *tb)
 			 */
 			if (tb->tb_id != fa->tb_id) {
 				hlist_del_rcu(&fa->fa_list);
+				fib_dir_alias_change(t, n->key, fa->fa_slen, -1);
 				alias_free_mem_rcu(fa);
 				continue;
 			}
@@ -2095,6 +2267,7 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 				rtmsg_fib(RTM_DELROUTE, htonl(n->key), fa,
 					  KEYLENGTH - fa->fa_slen, tb->tb_id, &info, 0);
 			hlist_del_rcu(&fa->fa_list);
+			fib_dir_alias_change(t, n->key, fa->fa_slen, -1);
 			fib_release_info(fa->fa_info);
 			alias_free_mem_rcu(fa);
 			found++;
@@ -2252,12 +2425,18 @@ int fib_notify(struct net *net, struct notifier_block *nb,
 static void __trie_free_rcu(struct rcu_head *head)
 {
 	struct fib_table *tb = container_of(head, struct fib_table, rcu);
-#ifdef CONFIG_IP_FIB_TRIE_STATS
+#if defined(CONFIG_IP_FIB_TRIE_STATS) || defined(CONFIG_IP_FIB_TRIE_DIR16)
 	struct trie *t = (struct trie *)tb->tb_data;
 
-	if (tb->tb_data == tb->__data)
+	if (tb->tb_data == tb->__data) {
+#ifdef CONFIG_IP_FIB_TRIE_STATS
 		free_percpu(t->stats);
-#endif /* CONFIG_IP_FIB_TRIE_STATS */
+#endif
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+		kvfree(t->dir);
+#endif
+	}
+#endif
 	kfree(tb);
 }
 
@@ -2435,9 +2614,13 @@ struct fib_table *fib_trie_table(u32 id, struct fib_table *alias)
 	t->stats = alloc_percpu(struct trie_use_stats);
 	if (!t->stats) {
 		kfree(tb);
-		tb = NULL;
+		return NULL;
 	}
 #endif
+#ifdef CONFIG_IP_FIB_TRIE_DIR16
+	/* The local table mostly holds host routes, don't bother. */
+	t->dir_disabled = id == RT_TABLE_LOCAL;
+#endif
 
 	return tb;
 }
@@ -2112,8 +2112,14 @@ static int tcp_zerocopy_receive(struct sock *sk,
 
 	sock_rps_record_flow(sk);
 
-	if (inq && inq <= copybuf_len)
-		return receive_fallback_to_copy(sk, zc, inq, tss);
+	/* Nothing can be mapped below a page: copy what the copy buffer
+	 * holds rather than bouncing the caller to recvmsg().
+	 */
+	if (inq && copybuf_len > 0 &&
+	    (inq <= copybuf_len || inq < PAGE_SIZE))
+		return receive_fallback_to_copy(sk, zc,
+						min_t(int, inq, copybuf_len),
+						tss);
 
 	if (inq < PAGE_SIZE) {
 		zc->length = 0;
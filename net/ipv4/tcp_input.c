@@ -3305,7 +3305,8 @@ static int tcp_clean_rtx_queue(struct sock *sk, const struct sk_buff *ack_skb,
 	struct tcp_sock *tp = tcp_sk(sk);
 	u32 prior_sacked = tp->sacked_out;
 	u32 reord = tp->snd_nxt; /* lowest acked un-retx un-sacked seq */
-	struct sk_buff *skb, *next;
+	struct sk_buff *skb, *next, *to_free = NULL;
+	int freed_truesize = 0, freed_charge = 0;
 	bool fully_acked = true;
 	long sack_rtt_us = -1L;
 	long seq_rtt_us = -1L;
@@ -3392,7 +3393,26 @@ static int tcp_clean_rtx_queue(struct sock *sk, const struct sk_buff *ack_skb,
 		if (unlikely(skb == tp->lost_skb_hint))
 			tp->lost_skb_hint = NULL;
 		tcp_highest_sack_replace(sk, skb, next);
-		tcp_rtx_queue_unlink_and_free(skb, sk);
+
+		/* A single ACK can cover thousands of skbs with large
+		 * windows: unlink them here, but batch the memory
+		 * accounting and the freeing after the walk.
+		 */
+		list_del(&skb->tcp_tsorted_anchor);
+		tcp_rtx_queue_unlink(skb, sk);
+		freed_truesize += skb->truesize;
+		if (!skb_zcopy_pure(skb))
+			freed_charge += skb->truesize;
+		else
+			freed_charge += SKB_TRUESIZE(skb_end_offset(skb));
+		skb->next = to_free;
+		to_free = skb;
+	}
+
+	if (to_free) {
+		sk_wmem_queued_add(sk, -freed_truesize);
+		sk_mem_uncharge(sk, freed_charge);
+		kfree_skb_list_reason(to_free, SKB_CONSUMED);
 	}
 
 	if (!skb)
@@ -3277,16 +3277,83 @@ static struct tcp_seq_afinfo tcp4_seq_afinfo = {
 	.family		= AF_INET,
 };
 
+/* Slot 0 counts empty buckets, slot n chains of [2^(n-1), 2^n) sockets,
+ * the last slot everything longer.
+ */
+#define TCP_EHASH_HIST_SLOTS	8
+
+/* A child netns sharing the global established hash would see the
+ * connections of the whole host, only show the table to its owner.
+ */
+static bool tcp_ehash_proc_visible(const struct net *net)
+{
+	return net_eq(net, &init_net) ||
+	       net->ipv4.tcp_death_row.hashinfo != &tcp_hashinfo;
+}
+
+/* Chain length statistics of the established hash used by this netns.
+ * Sockets can move between chains while we walk them locklessly, the
+ * numbers are approximate.
+ */
+static int tcp_ehash_seq_show(struct seq_file *seq, void *v)
+{
+	struct net *net = seq->private;
+	struct inet_hashinfo *hinfo = net->ipv4.tcp_death_row.hashinfo;
+	unsigned long hist[TCP_EHASH_HIST_SLOTS] = {};
+	unsigned int bucket, max_len = 0;
+	unsigned long entries = 0;
+	int i;
+
+	for (bucket = 0; bucket <= hinfo->ehash_mask; bucket++) {
+		struct inet_ehash_bucket *head = &hinfo->ehash[bucket];
+		const struct hlist_nulls_node *node;
+		unsigned int len = 0;
+		struct sock *sk;
+
+		if (!hlist_nulls_empty(&head->chain)) {
+			rcu_read_lock();
+			sk_nulls_for_each_rcu(sk, node, &head->chain)
+				len++;
+			rcu_read_unlock();
+		}
+
+		entries += len;
+		max_len = max(max_len, len);
+		hist[min_t(int, fls(len), TCP_EHASH_HIST_SLOTS - 1)]++;
+
+		if (!(bucket & 1023))
+			cond_resched();
+	}
+
+	seq_printf(seq, "buckets %u entries %lu max_chain %u\n",
+		   hinfo->ehash_mask + 1, entries, max_len);
+	seq_printf(seq, "0: %lu\n", hist[0]);
+	for (i = 1; i < TCP_EHASH_HIST_SLOTS - 1; i++)
+		seq_printf(seq, "%u-%u: %lu\n", 1U << (i - 1), (1U << i) - 1,
+			   hist[i]);
+	seq_printf(seq, "%u+: %lu\n", 1U << (i - 1), hist[i]);
+	return 0;
+}
+
 static int __net_init tcp4_proc_init_net(struct net *net)
 {
 	if (!proc_create_net_data("tcp", 0444, net->proc_net, &tcp4_seq_ops,
 			sizeof(struct tcp_iter_state), &tcp4_seq_afinfo))
 		return -ENOMEM;
+	/* Walking the whole hash is not cheap, keep it for the admin. */
+	if (tcp_ehash_proc_visible(net) &&
+	    !proc_create_net_single("tcp_ehash", 0400, net->proc_net,
+			tcp_ehash_seq_show, NULL)) {
+		remove_proc_entry("tcp", net->proc_net);
+		return -ENOMEM;
+	}
 	return 0;
 }
 
 static void __net_exit tcp4_proc_exit_net(struct net *net)
 {
+	if (tcp_ehash_proc_visible(net))
+		remove_proc_entry("tcp_ehash", net->proc_net);
 	remove_proc_entry("tcp", net->proc_net);
 }
 
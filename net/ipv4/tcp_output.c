@@ -1180,6 +1180,31 @@ void __init tcp_tasklet_init(void)
 	}
 }
 
+/* Called from tcp_wfree() when the socket looks owned by user. The owner
+ * state and tcp_release_cb() are serialized by the socket spinlock, which
+ * we only try to take: on contention the TSQ tasklet does the work.
+ * The spinlock is taken with BH disabled elsewhere, so only try from
+ * softirq (or BH disabled) context.
+ */
+static bool tcp_wfree_defer(struct sock *sk)
+{
+	bool deferred = false;
+
+	if (!in_softirq() || in_hardirq() ||
+	    !spin_trylock(&sk->sk_lock.slock))
+		return false;
+
+	if (sock_owned_by_user(sk)) {
+		if (!test_and_set_bit(TCP_TSQ_DEFERRED, &sk->sk_tsq_flags))
+			sock_hold(sk);
+		clear_bit(TSQ_THROTTLED, &sk->sk_tsq_flags);
+		deferred = true;
+	}
+	spin_unlock(&sk->sk_lock.slock);
+
+	return deferred;
+}
+
 /*
  * Write buffer destructor automatically called from kfree_skb.
  * We can't xmit new skbs from this context, as we might already
@@ -1213,6 +1238,14 @@ void tcp_wfree(struct sk_buff *skb)
 		if (!(oval & TSQF_THROTTLED) || (oval & TSQF_QUEUED))
 			goto out;
 
+		/* The owner thread is in sendmsg(), likely on another cpu:
+		 * let release_sock() push more data from there rather than
+		 * queueing the socket to this cpu tasklet, which would
+		 * only find it owned and defer it anyway.
+		 */
+		if (sock_owned_by_user_nocheck(sk) && tcp_wfree_defer(sk))
+			goto out;
+
 		nval = (oval & ~TSQF_THROTTLED) | TSQF_QUEUED;
 	} while (!try_cmpxchg(&sk->sk_tsq_flags, &oval, nval));
 
@@ -93,6 +93,7 @@
 #include <linux/inet.h>
 #include <linux/netdevice.h>
 #include <linux/slab.h>
+#include <linux/jhash.h>
 #include <net/tcp_states.h>
 #include <linux/skbuff.h>
 #include <linux/proc_fs.h>
@@ -1052,6 +1053,97 @@ int udp_cmsg_send(struct sock *sk, struct msghdr *msg, u16 *gso_size)
 }
 EXPORT_SYMBOL_GPL(udp_cmsg_send);
 
+/* Unconnected senders (e.g. sendmmsg() by a server talking to many
+ * peers) do a full route lookup per message. Keep the route of the last
+ * destination in the socket, once two consecutive lookups used the same
+ * key. The cached dst is validated like sk_dst_cache.
+ */
+struct udp_route_key {
+	__be32	faddr;
+	__be32	saddr;
+	int	oif;
+	u32	mark;
+	__be16	dport;
+	u8	tos;
+	u8	scope;
+	u8	flow_flags;
+};
+
+struct udp_route_cache {
+	struct rcu_head		rcu;
+	struct udp_route_key	key;
+	struct dst_entry	*dst;
+	struct flowi4		fl4;
+};
+
+static struct rtable *udp_route_cache_get(struct sock *sk,
+					  const struct udp_route_key *key,
+					  struct flowi4 *fl4)
+{
+	struct udp_route_cache *rc;
+	struct dst_entry *dst;
+	struct rtable *rt = NULL;
+
+	rcu_read_lock();
+	rc = rcu_dereference(udp_sk(sk)->route_cache);
+	if (rc && !memcmp(&rc->key, key, sizeof(*key))) {
+		dst = dst_check(rc->dst, 0);
+		if (dst && dst_hold_safe(dst)) {
+			*fl4 = rc->fl4;
+			rt = dst_rtable(dst);
+		}
+	}
+	rcu_read_unlock();
+
+	return rt;
+}
+
+static void udp_route_cache_free(struct udp_route_cache *rc)
+{
+	if (rc) {
+		dst_release(rc->dst);
+		kfree_rcu(rc, rcu);
+	}
+}
+
+static void udp_route_cache_set(struct sock *sk,
+				const struct udp_route_key *key,
+				const struct flowi4 *fl4, struct rtable *rt)
+{
+	struct udp_sock *up = udp_sk(sk);
+	struct udp_route_cache *rc;
+	u32 hash;
+
+	/* Only cache runs of messages to the same destination. */
+	hash = jhash(key, sizeof(*key), 0);
+	if (READ_ONCE(up->route_miss_hash) != hash) {
+		WRITE_ONCE(up->route_miss_hash, hash);
+		return;
+	}
+
+	rc = kmalloc(sizeof(*rc), GFP_ATOMIC | __GFP_NOWARN);
+	if (!rc)
+		return;
+	rc->key = *key;
+	rc->fl4 = *fl4;
+	rc->dst = dst_clone(&rt->dst);
+
+	rc = unrcu_pointer(xchg(&up->route_cache, RCU_INITIALIZER(rc)));
+	udp_route_cache_free(rc);
+}
+
+/* The key doesn't cover per-socket policy (IP_XFRM_POLICY, ...), drop the
+ * cached route whenever a socket or IP level option is set.
+ */
+static void udp_route_cache_reset(struct sock *sk)
+{
+	struct udp_sock *up = udp_sk(sk);
+
+	if (!rcu_access_pointer(up->route_cache))
+		return;
+	udp_route_cache_free(unrcu_pointer(xchg(&up->route_cache, NULL)));
+}
+
 int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 {
 	struct inet_sock *inet = inet_sk(sk);
@@ -1072,6 +1164,7 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 	int (*getfrag)(void *, char *, int, int, int, struct sk_buff *);
 	struct sk_buff *skb;
 	struct ip_options_data opt_copy;
+	struct udp_route_key key;
 	int uc_index;
 
 	if (len > 0xFFFF)
@@ -1217,8 +1310,23 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 		}
 	}
 
-	if (connected)
+	if (connected) {
 		rt = dst_rtable(sk_dst_check(sk, 0));
+	} else {
+		memset(&key, 0, sizeof(key));
+		key.faddr = faddr;
+		key.saddr = saddr;
+		key.oif = ipc.oif;
+		key.mark = ipc.sockc.mark;
+		key.dport = dport;
+		key.tos = tos;
+		key.scope = scope;
+		key.flow_flags = inet_sk_flowi_flags(sk);
+
+		rt = udp_route_cache_get(sk, &key, &fl4_stack);
+		if (rt)
+			fl4 = &fl4_stack;
+	}
 
 	if (!rt) {
 		struct net *net = sock_net(sk);
@@ -1246,6 +1354,8 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 			goto out;
 		if (connected)
 			sk_dst_set(sk, dst_clone(&rt->dst));
+		else if (!(rt->rt_flags & RTCF_BROADCAST))
+			udp_route_cache_set(sk, &key, fl4, rt);
 	}
 
 	if (msg->msg_flags&MSG_CONFIRM)
@@ -1471,31 +1581,6 @@ static void udp_skb_dtor_locked(struct sock *sk, struct sk_buff *skb)
 	udp_rmem_release(sk, udp_skb_truesize(skb), 1, true);
 }
 
-/* Idea of busylocks is to let producers grab an extra spinlock
- * to relieve pressure on the receive_queue spinlock shared by consumer.
- * Under flood, this means that only one producer can be in line
- * trying to acquire the receive_queue spinlock.
- * These busylock can be allocated on a per cpu manner, instead of a
- * per socket one (that would consume a cache line per socket)
- */
-static int udp_busylocks_log __read_mostly;
-static spinlock_t *udp_busylocks __read_mostly;
-
-static spinlock_t *busylock_acquire(void *ptr)
-{
-	spinlock_t *busy;
-
-	busy = udp_busylocks + hash_ptr(ptr, udp_busylocks_log);
-	spin_lock(busy);
-	return busy;
-}
-
-static void busylock_release(spinlock_t *busy)
-{
-	if (busy)
-		spin_unlock(busy);
-}
-
 static int udp_rmem_schedule(struct sock *sk, int size)
 {
 	int delta;
@@ -1510,10 +1595,13 @@ static int udp_rmem_schedule(struct sock *sk, int size)
 int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 {
 	struct sk_buff_head *list = &sk->sk_receive_queue;
+	struct udp_prod_queue *udp_prod_queue;
+	struct sk_buff *next, *to_drop = NULL;
+	struct llist_node *ll_list;
+	unsigned int total_size = 0;
 	int rmem, err = -ENOMEM;
-	spinlock_t *busy = NULL;
-	bool becomes_readable;
-	int size, rcvbuf;
+	int size, rcvbuf, nb = 0;
+	bool was_empty;
 
 	/* Immediately drop when the receive queue is full.
 	 * Always allow at least one packet.
@@ -1523,58 +1611,95 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 	if (rmem > rcvbuf)
 		goto drop;
 
+	udp_prod_queue = &udp_sk(sk)->udp_prod_queue[numa_node_id()];
+
+	/* Also account for skbs queued by producers of this node, but not
+	 * yet spliced to the receive queue.
+	 */
+	rmem += atomic_read(&udp_prod_queue->rmem_alloc);
+	if (rmem > rcvbuf)
+		goto drop;
+
 	/* Under mem pressure, it might be helpful to help udp_recvmsg()
 	 * having linear skbs :
 	 * - Reduce memory overhead and thus increase receive queue capacity
 	 * - Less cache line misses at copyout() time
 	 * - Less work at consume_skb() (less alien page frag freeing)
 	 */
-	if (rmem > (rcvbuf >> 1)) {
+	if (rmem > (rcvbuf >> 1))
 		skb_condense(skb);
 
-		busy = busylock_acquire(sk);
-	}
 	size = skb->truesize;
 	udp_set_dev_scratch(skb);
 
-	atomic_add(size, &sk->sk_rmem_alloc);
+	atomic_add(size, &udp_prod_queue->rmem_alloc);
+
+	/* Only the producer finding the per node queue empty takes the
+	 * receive queue lock, and splices everything other producers of
+	 * this node added in the meantime. Packets from one cpu keep
+	 * their order.
+	 */
+	if (!llist_add(&skb->ll_node, &udp_prod_queue->ll_root))
+		return 0;
 
 	spin_lock(&list->lock);
-	err = udp_rmem_schedule(sk, size);
-	if (err) {
-		spin_unlock(&list->lock);
-		goto uncharge_drop;
-	}
 
-	sk_forward_alloc_add(sk, -size);
+	/* Decide about the wakeup now, a reader may dequeue once unlocked */
+	was_empty = skb_queue_empty(list);
+	ll_list = llist_del_all(&udp_prod_queue->ll_root);
+	ll_list = llist_reverse_order(ll_list);
+
+	llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+		size = udp_skb_truesize(skb);
+		total_size += size;
+
+		atomic_add(size, &sk->sk_rmem_alloc);
+		err = udp_rmem_schedule(sk, size);
+		if (unlikely(err)) {
+			atomic_sub(size, &sk->sk_rmem_alloc);
+			/* Free the skbs outside of the locked section. */
+			skb->next = to_drop;
+			to_drop = skb;
+			continue;
+		}
+
+		sk_forward_alloc_add(sk, -size);
 
-	/* no need to setup a destructor, we will explicitly release the
-	 * forward allocated memory on dequeue
-	 */
-	sock_skb_set_dropcount(sk, skb);
+		/* no need to setup a destructor, we will explicitly release
+		 * the forward allocated memory on dequeue
+		 */
+		sock_skb_set_dropcount(sk, skb);
+
+		__skb_queue_tail(list, skb);
+		nb++;
+	}
 
-	becomes_readable = skb_queue_empty(list);
-	__skb_queue_tail(list, skb);
 	spin_unlock(&list->lock);
 
-	if (!sock_flag(sk, SOCK_DEAD)) {
-		if (becomes_readable ||
-		    sk->sk_data_ready != sock_def_readable ||
-		    READ_ONCE(sk->sk_peek_off) >= 0)
+	atomic_sub(total_size, &udp_prod_queue->rmem_alloc);
+
+	while (unlikely(to_drop)) {
+		next = to_drop->next;
+		skb_mark_not_on_list(to_drop);
+		atomic_inc(&sk->sk_drops);
+		__UDPX_INC_STATS(sk, UDP_MIB_MEMERRORS);
+		__UDPX_INC_STATS(sk, UDP_MIB_INERRORS);
+		kfree_skb_reason(to_drop, SKB_DROP_REASON_PROTO_MEM);
+		to_drop = next;
+	}
+
+	if (nb && !sock_flag(sk, SOCK_DEAD)) {
+		if (sk->sk_data_ready != sock_def_readable ||
+		    READ_ONCE(sk->sk_peek_off) >= 0 || was_empty)
 			INDIRECT_CALL_1(sk->sk_data_ready,
 					sock_def_readable, sk);
 		else
 			sk_wake_async_rcu(sk, SOCK_WAKE_WAITD, POLL_IN);
 	}
-	busylock_release(busy);
 	return 0;
 
-uncharge_drop:
-	atomic_sub(skb->truesize, &sk->sk_rmem_alloc);
-
 drop:
 	atomic_inc(&sk->sk_drops);
-	busylock_release(busy);
 	return err;
 }
 EXPORT_SYMBOL_GPL(__udp_enqueue_schedule_skb);
@@ -1592,6 +1717,8 @@ void udp_destruct_common(struct sock *sk)
 		kfree_skb(skb);
 	}
 	udp_rmem_release(sk, total, 0, true);
+	kfree(up->udp_prod_queue);
+	udp_route_cache_free(rcu_dereference_protected(up->route_cache, 1));
 }
 EXPORT_SYMBOL_GPL(udp_destruct_common);
 
@@ -1603,10 +1730,11 @@ static void udp_destruct_sock(struct sock *sk)
 
 int udp_init_sock(struct sock *sk)
 {
-	udp_lib_init_sock(sk);
+	int res = udp_lib_init_sock(sk);
+
 	sk->sk_destruct = udp_destruct_sock;
 	set_bit(SOCK_SUPPORT_ZC, &sk->sk_socket->flags);
-	return 0;
+	return res;
 }
 
 void skb_consume_udp(struct sock *sk, struct sk_buff *skb, int len)
@@ -2798,11 +2926,20 @@ EXPORT_SYMBOL(udp_lib_setsockopt);
 int udp_setsockopt(struct sock *sk, int level, int optname, sockptr_t optval,
 		   unsigned int optlen)
 {
-	if (level == SOL_UDP  ||  level == SOL_UDPLITE || level == SOL_SOCKET)
+	int err;
+
+	if (level == SOL_UDP  ||  level == SOL_UDPLITE)
 		return udp_lib_setsockopt(sk, level, optname,
 					  optval, optlen,
 					  udp_push_pending_frames);
-	return ip_setsockopt(sk, level, optname, optval, optlen);
+	if (level == SOL_SOCKET)
+		err = udp_lib_setsockopt(sk, level, optname,
+					 optval, optlen,
+					 udp_push_pending_frames);
+	else
+		err = ip_setsockopt(sk, level, optname, optval, optlen);
+	udp_route_cache_reset(sk);
+	return err;
 }
 
 int udp_lib_getsockopt(struct sock *sk, int level, int optname,
@@ -3642,7 +3779,6 @@ static void __init bpf_iter_register(void)
 void __init udp_init(void)
 {
 	unsigned long limit;
-	unsigned int i;
 
 	udp_table_init(&udp_table, "UDP");
 	limit = nr_free_buffer_pages() / 8;
@@ -3651,15 +3787,6 @@ void __init udp_init(void)
 	sysctl_udp_mem[1] = limit;
 	sysctl_udp_mem[2] = sysctl_udp_mem[0] * 2;
 
-	/* 16 spinlocks per cpu */
-	udp_busylocks_log = ilog2(nr_cpu_ids) + 4;
-	udp_busylocks = kmalloc(sizeof(spinlock_t) << udp_busylocks_log,
-				GFP_KERNEL);
-	if (!udp_busylocks)
-		panic("UDP: failed to alloc udp_busylocks\n");
-	for (i = 0; i < (1U << udp_busylocks_log); i++)
-		spin_lock_init(udp_busylocks + i);
-
 	if (register_pernet_subsys(&udp_sysctl_ops))
 		panic("UDP: failed to init sysctl parameters.\n");
 
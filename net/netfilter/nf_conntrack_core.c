@@ -1615,7 +1615,19 @@ __nf_conntrack_alloc(struct net *net,
 	ct_count = atomic_inc_return(&cnet->count);
 
 	if (nf_conntrack_max && unlikely(ct_count > nf_conntrack_max)) {
-		if (!early_drop(net, hash)) {
+		/* When a scan found nothing to evict, a flood of new
+		 * connections would rescan for every packet: fail fast
+		 * for the rest of this jiffy and leave it to the gc worker.
+		 */
+		unsigned long now = jiffies;
+		bool fail = READ_ONCE(cnet->early_drop_fail) == now;
+
+		if (!fail && !early_drop(net, hash)) {
+			/* only a real scan restarts the fail-fast window */
+			WRITE_ONCE(cnet->early_drop_fail, now);
+			fail = true;
+		}
+		if (fail) {
 			if (!conntrack_gc_work.early_drop)
 				conntrack_gc_work.early_drop = true;
 			atomic_dec(&cnet->count);
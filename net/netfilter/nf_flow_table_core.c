@@ -337,6 +337,14 @@ static void flow_offload_del(struct nf_flowtable *flow_table,
 	rhashtable_remove_fast(&flow_table->rhashtable,
 			       &flow->tuplehash[FLOW_OFFLOAD_DIR_REPLY].node,
 			       nf_flow_offload_rhash_params);
+
+	/* Invalidate all per cpu last hits, the flow is only freed after an
+	 * RCU grace period. Paired with the acquire in flow_offload_lookup(),
+	 * which sees the removal if it sees the new generation.
+	 */
+	smp_mb__before_atomic();
+	atomic_long_inc(&flow_table->last_hit_gen);
+
 	flow_offload_free(flow);
 }
 
@@ -353,16 +361,38 @@ flow_offload_lookup(struct nf_flowtable *flow_table,
 		    struct flow_offload_tuple *tuple)
 {
 	struct flow_offload_tuple_rhash *tuplehash;
+	struct flow_offload_last_hit *hit;
 	struct flow_offload *flow;
+	unsigned long gen;
 	int dir;
 
-	tuplehash = rhashtable_lookup(&flow_table->rhashtable, tuple,
-				      nf_flow_offload_rhash_params);
-	if (!tuplehash)
-		return NULL;
+	/* Packets of a flow tend to come in bursts (NAPI batches, GRO lists):
+	 * remember the last tuple found by this cpu, a hit saves the hash and
+	 * the bucket walk. Any flow removal since the tuple was found makes
+	 * it stale. Called from BH context.
+	 */
+	hit = this_cpu_ptr(flow_table->last_hit);
+	gen = atomic_long_read_acquire(&flow_table->last_hit_gen);
+	tuplehash = hit->tuplehash;
+	if (tuplehash && hit->gen == gen &&
+	    !memcmp(&tuplehash->tuple, tuple,
+		    offsetof(struct flow_offload_tuple, __hash))) {
+		dir = tuplehash->tuple.dir;
+		flow = container_of(tuplehash, struct flow_offload,
+				    tuplehash[dir]);
+	} else {
+		tuplehash = rhashtable_lookup(&flow_table->rhashtable, tuple,
+					      nf_flow_offload_rhash_params);
+		if (!tuplehash)
+			return NULL;
+
+		dir = tuplehash->tuple.dir;
+		flow = container_of(tuplehash, struct flow_offload,
+				    tuplehash[dir]);
+		hit->tuplehash = tuplehash;
+		hit->gen = gen;
+	}
 
-	dir = tuplehash->tuple.dir;
-	flow = container_of(tuplehash, struct flow_offload, tuplehash[dir]);
 	if (test_bit(NF_FLOW_TEARDOWN, &flow->flags))
 		return NULL;
 
@@ -546,10 +576,16 @@ int nf_flow_table_init(struct nf_flowtable *flowtable)
 	flow_block_init(&flowtable->flow_block);
 	init_rwsem(&flowtable->flow_block_lock);
 
+	flowtable->last_hit = alloc_percpu(struct flow_offload_last_hit);
+	if (!flowtable->last_hit)
+		return -ENOMEM;
+
 	err = rhashtable_init(&flowtable->rhashtable,
 			      &nf_flow_offload_rhash_params);
-	if (err < 0)
+	if (err < 0) {
+		free_percpu(flowtable->last_hit);
 		return err;
+	}
 
 	queue_delayed_work(system_power_efficient_wq,
 			   &flowtable->gc_work, HZ);
@@ -610,6 +646,7 @@ void nf_flow_table_free(struct nf_flowtable *flow_table)
 	nf_flow_table_gc_run(flow_table);
 	nf_flow_table_offload_flush_cleanup(flow_table);
 	rhashtable_destroy(&flow_table->rhashtable);
+	free_percpu(flow_table->last_hit);
 }
 EXPORT_SYMBOL_GPL(nf_flow_table_free);
 
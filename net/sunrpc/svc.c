@@ -721,6 +721,9 @@ void svc_pool_wake_idle_thread(struct svc_pool *pool)
 	}
 	rcu_read_unlock();
 
+	/* Let the service know that it may want more threads here */
+	if (!test_bit(SP_NEED_THREAD, &pool->sp_flags))
+		set_bit(SP_NEED_THREAD, &pool->sp_flags);
 }
 EXPORT_SYMBOL_GPL(svc_pool_wake_idle_thread);
 
@@ -837,19 +840,48 @@ svc_stop_kthreads(struct svc_serv *serv, struct svc_pool *pool, int nrservs)
 int
 svc_set_num_threads(struct svc_serv *serv, struct svc_pool *pool, int nrservs)
 {
+	unsigned int i;
+	int err = 0;
+
 	if (!pool)
 		nrservs -= serv->sv_nrthreads;
 	else
 		nrservs -= atomic_read(&pool->sp_nrthreads);
 
 	if (nrservs > 0)
-		return svc_start_kthreads(serv, pool, nrservs);
-	if (nrservs < 0)
-		return svc_stop_kthreads(serv, pool, nrservs);
-	return 0;
+		err = svc_start_kthreads(serv, pool, nrservs);
+	else if (nrservs < 0)
+		err = svc_stop_kthreads(serv, pool, nrservs);
+
+	/* Threads beyond these counts were added by svc_pool_grow() */
+	for (i = 0; i < serv->sv_nrpools; i++) {
+		struct svc_pool *p = &serv->sv_pools[i];
+
+		if (!pool || p == pool)
+			WRITE_ONCE(p->sp_nrthrmin,
+				   atomic_read(&p->sp_nrthreads));
+	}
+	return err;
 }
 EXPORT_SYMBOL_GPL(svc_set_num_threads);
 
+/**
+ * svc_pool_grow - start one more thread in a busy pool
+ * @serv: RPC service
+ * @pool: pool that ran out of idle threads
+ *
+ * The new thread exits again once @pool has been idle for a while and
+ * has more threads than set by the last svc_set_num_threads().  Caller
+ * must provide the same mutual exclusion as for svc_set_num_threads().
+ *
+ * Returns zero on success or a negative errno.
+ */
+int svc_pool_grow(struct svc_serv *serv, struct svc_pool *pool)
+{
+	return svc_start_kthreads(serv, pool, 1);
+}
+EXPORT_SYMBOL_GPL(svc_pool_grow);
+
 /**
  * svc_rqst_replace_page - Replace one page in rq_pages[]
  * @rqstp: svc_rqst with pages to replace
@@ -728,15 +728,41 @@ svc_thread_should_sleep(struct svc_rqst *rqstp)
 	return true;
 }
 
+/*
+ * A pool that has threads beyond its configured count retires one of
+ * them whenever it has seen no thread go idle for this long.
+ */
+#define SVC_POOL_IDLE_TIMEOUT	(30 * HZ)
+
+static bool svc_pool_has_extra_threads(struct svc_pool *pool)
+{
+	return atomic_read(&pool->sp_nrthreads) > READ_ONCE(pool->sp_nrthrmin);
+}
+
+/*
+ * Use the victim handshake of svc_stop_kthreads() to make the calling
+ * thread exit, unless some other thread is already on its way out.
+ */
+static void svc_pool_retire_thread(struct svc_pool *pool)
+{
+	if (test_and_set_bit(SP_VICTIM_REMAINS, &pool->sp_flags))
+		return;
+	set_bit(SP_NEED_VICTIM, &pool->sp_flags);
+}
+
 static void svc_thread_wait_for_work(struct svc_rqst *rqstp)
 {
 	struct svc_pool *pool = rqstp->rq_pool;
+	long timeout = MAX_SCHEDULE_TIMEOUT;
 
 	if (svc_thread_should_sleep(rqstp)) {
+		if (svc_pool_has_extra_threads(pool))
+			timeout = SVC_POOL_IDLE_TIMEOUT;
+
 		set_current_state(TASK_IDLE | TASK_FREEZABLE);
 		llist_add(&rqstp->rq_idle, &pool->sp_idle_threads);
 		if (likely(svc_thread_should_sleep(rqstp)))
-			schedule();
+			timeout = schedule_timeout(timeout);
 
 		while (!llist_del_first_this(&pool->sp_idle_threads,
 					     &rqstp->rq_idle)) {
@@ -748,10 +774,19 @@ static void svc_thread_wait_for_work(struct svc_rqst *rqstp)
 			 * for this new work.  This thread can safely sleep
 			 * until woken again.
 			 */
+			timeout = MAX_SCHEDULE_TIMEOUT;
 			schedule();
 			set_current_state(TASK_IDLE | TASK_FREEZABLE);
 		}
 		__set_current_state(TASK_RUNNING);
+
+		/*
+		 * Being first on the idle list after the timeout means no
+		 * other thread went idle meanwhile: the pool has spare ones.
+		 */
+		if (!timeout && svc_thread_should_sleep(rqstp) &&
+		    svc_pool_has_extra_threads(pool))
+			svc_pool_retire_thread(pool);
 	} else {
 		cond_resched();
 	}
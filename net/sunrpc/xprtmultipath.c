@@ -427,6 +427,30 @@ struct rpc_xprt *__xprt_switch_find_next_entry_roundrobin(struct list_head *head
 	return xprt_switch_find_first_entry(head);
 }
 
+/*
+ * Pick the active transport that the current CPU maps to, so that RPCs
+ * issued from one CPU keep using the same connection and its socket state
+ * stays warm in that CPU's cache.  The mapping is a plain modulo of the CPU
+ * number and knows nothing about where the transport's memory lives, so it
+ * gives no NUMA locality.
+ */
+static
+struct rpc_xprt *xprt_switch_find_local_entry(struct list_head *head,
+		unsigned int nactive)
+{
+	struct rpc_xprt *pos;
+	unsigned int idx;
+
+	if (nactive < 2)
+		return NULL;
+	idx = raw_smp_processor_id() % nactive;
+	list_for_each_entry_rcu(pos, head, xprt_switch) {
+		if (xprt_is_active(pos) && !idx--)
+			return pos;
+	}
+	return NULL;
+}
+
 static
 struct rpc_xprt *xprt_switch_find_next_entry_roundrobin(struct rpc_xprt_switch *xps,
 		const struct rpc_xprt *cur)
@@ -435,6 +459,13 @@ struct rpc_xprt *xprt_switch_find_next_entry_roundrobin(struct rpc_xprt_switch *
 	struct rpc_xprt *xprt;
 	unsigned int nactive;
 
+	/* Prefer the CPU local transport unless it is above average load */
+	nactive = READ_ONCE(xps->xps_nactive);
+	xprt = xprt_switch_find_local_entry(head, nactive);
+	if (xprt && atomic_long_read(&xprt->queuelen) * nactive <=
+		    atomic_long_read(&xps->xps_queuelen))
+		return xprt;
+
 	for (;;) {
 		unsigned long xprt_queuelen, xps_queuelen;
 
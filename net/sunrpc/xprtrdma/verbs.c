@@ -368,6 +368,22 @@ static noinline int rpcrdma_ep_put(struct rpcrdma_ep *ep)
 	return kref_put(&ep->re_kref, rpcrdma_ep_destroy);
 }
 
+/*
+ * Allocate both CQs of a transport on the same completion vector, and spread
+ * transports over the vectors by their id.  The nconnect transports of a
+ * client are usually all connected from the same CPU, so their ids rather
+ * than the connecting CPU keep them from piling up on one vector.
+ */
+static struct ib_cq *rpcrdma_alloc_cq(struct rpcrdma_xprt *r_xprt,
+				      struct ib_device *device, int nr_cqe)
+{
+	int vector = 0;
+
+	if (device->num_comp_vectors > 1)
+		vector = r_xprt->rx_xprt.id % device->num_comp_vectors;
+	return ib_alloc_cq(device, r_xprt, nr_cqe, vector, IB_POLL_WORKQUEUE);
+}
+
 static int rpcrdma_ep_create(struct rpcrdma_xprt *r_xprt)
 {
 	struct rpcrdma_connect_private *pmsg;
@@ -411,18 +427,16 @@ static int rpcrdma_ep_create(struct rpcrdma_xprt *r_xprt)
 	ep->re_send_count = ep->re_send_batch;
 	init_waitqueue_head(&ep->re_connect_wait);
 
-	ep->re_attr.send_cq = ib_alloc_cq_any(device, r_xprt,
-					      ep->re_attr.cap.max_send_wr,
-					      IB_POLL_WORKQUEUE);
+	ep->re_attr.send_cq = rpcrdma_alloc_cq(r_xprt, device,
+					       ep->re_attr.cap.max_send_wr);
 	if (IS_ERR(ep->re_attr.send_cq)) {
 		rc = PTR_ERR(ep->re_attr.send_cq);
 		ep->re_attr.send_cq = NULL;
 		goto out_destroy;
 	}
 
-	ep->re_attr.recv_cq = ib_alloc_cq_any(device, r_xprt,
-					      ep->re_attr.cap.max_recv_wr,
-					      IB_POLL_WORKQUEUE);
+	ep->re_attr.recv_cq = rpcrdma_alloc_cq(r_xprt, device,
+					       ep->re_attr.cap.max_recv_wr);
 	if (IS_ERR(ep->re_attr.recv_cq)) {
 		rc = PTR_ERR(ep->re_attr.recv_cq);
 		ep->re_attr.recv_cq = NULL;
@@ -237,16 +237,21 @@ static inline
 u32 xskq_cons_read_desc_batch(struct xsk_queue *q, struct xsk_buff_pool *pool,
 			      u32 max)
 {
+	struct xdp_rxtx_ring *ring = (struct xdp_rxtx_ring *)q->ring;
+	u32 max_segs = pool->netdev->xdp_zc_max_segs;
 	u32 cached_cons = q->cached_cons, nb_entries = 0;
+	u32 cached_prod = q->cached_prod, ring_mask = q->ring_mask;
 	struct xdp_desc *descs = pool->tx_descs;
 	u32 total_descs = 0, nr_frags = 0;
 
-	/* track first entry, if stumble upon *any* invalid descriptor, rewind
+	/* The stores to descs[] may alias the queue and pool fields as far
+	 * as the compiler knows, so read the loop invariants once above.
+	 *
+	 * track first entry, if stumble upon *any* invalid descriptor, rewind
 	 * current packet that consists of frags and stop the processing
 	 */
-	while (cached_cons != q->cached_prod && nb_entries < max) {
-		struct xdp_rxtx_ring *ring = (struct xdp_rxtx_ring *)q->ring;
-		u32 idx = cached_cons & q->ring_mask;
+	while (cached_cons != cached_prod && nb_entries < max) {
+		u32 idx = cached_cons & ring_mask;
 		struct parsed_desc parsed;
 
 		descs[nb_entries] = ring->desc[idx];
@@ -260,7 +265,7 @@ u32 xskq_cons_read_desc_batch(struct xsk_queue *q, struct xsk_buff_pool *pool,
 			nr_frags = 0;
 		} else {
 			nr_frags++;
-			if (nr_frags == pool->netdev->xdp_zc_max_segs) {
+			if (nr_frags == max_segs) {
 				nr_frags = 0;
 				break;
 			}
@@ -20,6 +20,8 @@
 #include <linux/skbuff.h>
 #include <linux/percpu.h>
 #include <linux/list.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
 #include <net/sock.h>
 #include <linux/un.h>
 #include <net/af_unix.h>
@@ -34,8 +36,8 @@
 #define CREATE_TRACE_POINTS
 #include <trace/events/avc.h>
 
-#define AVC_CACHE_SLOTS			512
-#define AVC_DEF_CACHE_THRESHOLD		512
+#define AVC_DEF_CACHE_SLOTS		512
+#define AVC_MAX_CACHE_SLOTS		(1 << 16)
 #define AVC_CACHE_RECLAIM		16
 
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
@@ -69,8 +71,8 @@ struct avc_xperms_node {
 };
 
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
+	struct hlist_head	*slots; /* head for avc_node->list */
+	spinlock_t		*slots_lock; /* lock for writes */
 	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
 	atomic_t		active_nodes;
 	u32			latest_notif;	/* latest revocation notification */
@@ -93,12 +95,37 @@ struct selinux_avc {
 
 static struct selinux_avc selinux_avc;
 
+static u32 avc_cache_slots __ro_after_init = AVC_DEF_CACHE_SLOTS;
+
+static int __init avc_cache_slots_setup(char *str)
+{
+	unsigned int slots;
+
+	if (!kstrtouint(str, 0, &slots))
+		avc_cache_slots = clamp_t(u32,
+					  rounddown_pow_of_two(max(slots, 1U)),
+					  AVC_DEF_CACHE_SLOTS,
+					  AVC_MAX_CACHE_SLOTS);
+	return 1;
+}
+__setup("selinux_avc_cache_slots=", avc_cache_slots_setup);
+
 void selinux_avc_init(void)
 {
 	int i;
 
-	selinux_avc.avc_cache_threshold = AVC_DEF_CACHE_THRESHOLD;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	/* Up to AVC_MAX_CACHE_SLOTS entries, too big for kmalloc with lockdep */
+	selinux_avc.avc_cache.slots = kvmalloc_array(avc_cache_slots,
+					sizeof(*selinux_avc.avc_cache.slots),
+					GFP_KERNEL);
+	selinux_avc.avc_cache.slots_lock = kvmalloc_array(avc_cache_slots,
+					sizeof(*selinux_avc.avc_cache.slots_lock),
+					GFP_KERNEL);
+	if (!selinux_avc.avc_cache.slots || !selinux_avc.avc_cache.slots_lock)
+		panic("SELinux: failed to allocate the AVC hash table\n");
+
+	selinux_avc.avc_cache_threshold = avc_cache_slots;
+	for (i = 0; i < avc_cache_slots; i++) {
 		INIT_HLIST_HEAD(&selinux_avc.avc_cache.slots[i]);
 		spin_lock_init(&selinux_avc.avc_cache.slots_lock[i]);
 	}
@@ -124,7 +151,7 @@ static struct kmem_cache *avc_xperms_cachep __ro_after_init;
 
 static inline u32 avc_hash(u32 ssid, u32 tsid, u16 tclass)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return jhash_3words(ssid, tsid, tclass, 0) & (avc_cache_slots - 1);
 }
 
 /**
@@ -158,7 +185,7 @@ int avc_get_hash_stats(char *page)
 
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache_slots; i++) {
 		head = &selinux_avc.avc_cache.slots[i];
 		if (!hlist_empty(head)) {
 			slots_used++;
@@ -175,7 +202,7 @@ int avc_get_hash_stats(char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&selinux_avc.avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, avc_cache_slots, max_chain_len);
 }
 
 /*
@@ -466,9 +493,9 @@ static inline int avc_reclaim_node(void)
 	struct hlist_head *head;
 	spinlock_t *lock;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
+	for (try = 0, ecx = 0; try < avc_cache_slots; try++) {
 		hvalue = atomic_inc_return(&selinux_avc.avc_cache.lru_hint) &
-			(AVC_CACHE_SLOTS - 1);
+			(avc_cache_slots - 1);
 		head = &selinux_avc.avc_cache.slots[hvalue];
 		lock = &selinux_avc.avc_cache.slots_lock[hvalue];
 
@@ -928,7 +955,7 @@ static void avc_flush(void)
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache_slots; i++) {
 		head = &selinux_avc.avc_cache.slots[i];
 		lock = &selinux_avc.avc_cache.slots_lock[i];
 
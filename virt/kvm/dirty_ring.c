@@ -50,7 +50,44 @@ static bool kvm_dirty_ring_full(struct kvm_dirty_ring *ring)
 	return kvm_dirty_ring_used(ring) >= ring->size;
 }
 
-static void kvm_reset_dirty_gfn(struct kvm *kvm, u32 slot, u64 offset, u64 mask)
+/*
+ * Coalesced resets are applied in batches, so that the mmu_lock is taken
+ * once per batch rather than once per mask, without holding it for the
+ * whole ring at a time.
+ */
+#define KVM_DIRTY_RING_RESET_BATCH	16
+
+struct kvm_dirty_reset_batch {
+	unsigned int nr;
+	struct {
+		struct kvm_memory_slot *memslot;
+		u64 offset;
+		u64 mask;
+	} ents[KVM_DIRTY_RING_RESET_BATCH];
+};
+
+static void kvm_reset_dirty_flush(struct kvm *kvm,
+				  struct kvm_dirty_reset_batch *batch)
+{
+	unsigned int i;
+
+	if (!batch->nr)
+		return;
+
+	KVM_MMU_LOCK(kvm);
+	for (i = 0; i < batch->nr; i++)
+		kvm_arch_mmu_enable_log_dirty_pt_masked(kvm,
+							batch->ents[i].memslot,
+							batch->ents[i].offset,
+							batch->ents[i].mask);
+	KVM_MMU_UNLOCK(kvm);
+
+	batch->nr = 0;
+}
+
+static void kvm_reset_dirty_gfn(struct kvm *kvm,
+				struct kvm_dirty_reset_batch *batch,
+				u32 slot, u64 offset, u64 mask)
 {
 	struct kvm_memory_slot *memslot;
 	int as_id, id;
@@ -69,9 +106,11 @@ static void kvm_reset_dirty_gfn(struct kvm *kvm, u32 slot, u64 offset, u64 mask)
 	if (!memslot || (offset + __fls(mask)) >= memslot->npages)
 		return;
 
-	KVM_MMU_LOCK(kvm);
-	kvm_arch_mmu_enable_log_dirty_pt_masked(kvm, memslot, offset, mask);
-	KVM_MMU_UNLOCK(kvm);
+	batch->ents[batch->nr].memslot = memslot;
+	batch->ents[batch->nr].offset = offset;
+	batch->ents[batch->nr].mask = mask;
+	if (++batch->nr == KVM_DIRTY_RING_RESET_BATCH)
+		kvm_reset_dirty_flush(kvm, batch);
 }
 
 int kvm_dirty_ring_alloc(struct kvm_dirty_ring *ring, int index, u32 size)
@@ -106,6 +145,7 @@ static inline bool kvm_dirty_gfn_harvested(struct kvm_dirty_gfn *gfn)
 
 int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 {
+	struct kvm_dirty_reset_batch batch = { .nr = 0 };
 	u32 cur_slot, next_slot;
 	u64 cur_offset, next_offset;
 	unsigned long mask;
@@ -150,14 +190,15 @@ int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 				continue;
 			}
 		}
-		kvm_reset_dirty_gfn(kvm, cur_slot, cur_offset, mask);
+		kvm_reset_dirty_gfn(kvm, &batch, cur_slot, cur_offset, mask);
 		cur_slot = next_slot;
 		cur_offset = next_offset;
 		mask = 1;
 		first_round = false;
 	}
 
-	kvm_reset_dirty_gfn(kvm, cur_slot, cur_offset, mask);
+	kvm_reset_dirty_gfn(kvm, &batch, cur_slot, cur_offset, mask);
+	kvm_reset_dirty_flush(kvm, &batch);
 
 	/*
 	 * The request KVM_REQ_DIRTY_RING_SOFT_FULL will be cleared
@@ -3772,6 +3772,43 @@ static inline void update_halt_poll_stats(struct kvm_vcpu *vcpu, ktime_t start,
 	}
 }
 
+/* Recent halts are weighted more, the histogram is halved this often */
+#define KVM_HALT_HIST_DECAY	64
+
+static void kvm_vcpu_halt_hist_update(struct kvm_vcpu *vcpu, u64 halt_ns)
+{
+	int i;
+
+	if (++vcpu->halt_hist_nr == KVM_HALT_HIST_DECAY) {
+		for (i = 0; i < HALT_POLL_HIST_COUNT; i++)
+			vcpu->halt_hist[i] >>= 1;
+		vcpu->halt_hist_nr = 0;
+	}
+	++vcpu->halt_hist[min_t(int, fls64(halt_ns), HALT_POLL_HIST_COUNT - 1)];
+}
+
+/*
+ * Predict from the recent halt durations whether the wakeup is likely to
+ * arrive within @poll_ns, i.e. whether polling is likely to pay off.
+ * Until enough history has been collected, always poll.
+ */
+static bool kvm_vcpu_halt_poll_predicted(struct kvm_vcpu *vcpu,
+					 unsigned int poll_ns)
+{
+	unsigned int within = 0, total = 0;
+	int i, last;
+
+	/* Bucket i holds durations below 2^i ns */
+	last = min_t(int, ilog2(poll_ns), HALT_POLL_HIST_COUNT - 1);
+	for (i = 0; i < HALT_POLL_HIST_COUNT; i++) {
+		total += vcpu->halt_hist[i];
+		if (i <= last)
+			within += vcpu->halt_hist[i];
+	}
+
+	return total < KVM_HALT_HIST_DECAY / 4 || within * 2 >= total;
+}
+
 static unsigned int kvm_vcpu_max_halt_poll_ns(struct kvm_vcpu *vcpu)
 {
 	struct kvm *kvm = vcpu->kvm;
@@ -3809,6 +3846,11 @@ void kvm_vcpu_halt(struct kvm_vcpu *vcpu)
 		vcpu->halt_poll_ns = max_halt_poll_ns;
 
 	do_halt_poll = halt_poll_allowed && vcpu->halt_poll_ns;
+	if (do_halt_poll &&
+	    !kvm_vcpu_halt_poll_predicted(vcpu, vcpu->halt_poll_ns)) {
+		++vcpu->stat.generic.halt_poll_skipped;
+		do_halt_poll = false;
+	}
 
 	start = cur = poll_end = ktime_get();
 	if (do_halt_poll) {
@@ -3847,6 +3889,13 @@ void kvm_vcpu_halt(struct kvm_vcpu *vcpu)
 		/* Recompute the max halt poll time in case it changed. */
 		max_halt_poll_ns = kvm_vcpu_max_halt_poll_ns(vcpu);
 
+		/*
+		 * How long the vCPU stayed halted doesn't depend on whether it
+		 * polled, so the prediction is fed even when polling was skipped.
+		 */
+		if (vcpu_valid_wakeup(vcpu))
+			kvm_vcpu_halt_hist_update(vcpu, halt_ns);
+
 		if (!vcpu_valid_wakeup(vcpu)) {
 			shrink_halt_poll_ns(vcpu);
 		} else if (max_halt_poll_ns) {